@@ -59,7 +59,12 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
-
+#if TRIGGER_EVENT_DEBOUNCE
+void TriggerDebounceElapsed( void );
+#endif
+#if STOP_MODE_IDLE
+void SystemClock_PllReady( void );
+#endif
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
@@ -93,6 +98,22 @@ void Error_Handler(void);
 #define TRIGGER_SET           1
 #define TRIGGER_CLR           0
 #define TRIG_TIMEOUT_MS       1000U
+#define TRIG_CONFIRM_US       20U     // LOW_LATENCY_TRIGGER: an edge must stay high this long to be taken
+#ifndef TRIG_DEBOUNCE_MS
+#define TRIG_DEBOUNCE_MS      20U     // TRIGGER_EVENT_DEBOUNCE: the input must hold still this long (1-2000 ms)
+#endif
+#define TRIG_DEBOUNCE_TICKS   ( ( LSI_VALUE / 1000U ) * TRIG_DEBOUNCE_MS )  // LPTIM1 counts of the LSI
+#define AMP_SETTLE_MS         10U     // MAX98357A turn-on time after NSD_MODE goes high
+
+// Fast boot (FAST_BOOT): supply-ready condition and the volume used before the ADC is up
+#ifndef FAST_BOOT_PVD_LEVEL
+#define FAST_BOOT_PVD_LEVEL         PWR_PVDLEVEL_5  // VDD must be above this (about 2.8 V)...
+#endif
+#define FAST_BOOT_SUPPLY_STABLE_MS  2U              // ...for this long
+#define FAST_BOOT_SUPPLY_TIMEOUT_MS 150U            // Start anyway after the normal boot's delay
+#ifndef FAST_BOOT_VOLUME
+#define FAST_BOOT_VOLUME            32768U          // Until the first volume ADC pass (1-65535)
+#endif
 
 // Special development/customer switches
 //#define TEST_CYCLING
@@ -117,6 +138,10 @@ void Error_Handler(void);
 // Volume minimum clamp level.
 #define VOLUME_MIN_CLAMP 8U
 
+// Number of oversampled ADC results kept by the circular volume DMA (the averaging window).
+// At the 200 Hz TIM7 trigger rate, 16 results span 80 ms.
+#define VOLUME_ADC_DMA_SAMPLES 16U
+
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
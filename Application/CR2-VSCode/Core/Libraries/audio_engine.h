@@ -59,6 +59,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include "stm32g4xx_hal.h"
+#include "audio_engine_config.h"
 
 /* I2S handle selection (default: hi2s2). Override in application if needed. */
 #ifndef AUDIO_ENGINE_I2S_HANDLE
@@ -70,484 +71,4338 @@ extern "C" {
 #define AUDIO_ENGINE_INLINE_DMA_CALLBACK 0
 #endif
 
-/* Set to 0 to compile out Air Effect support and save flash. */
-#ifndef AUDIO_ENGINE_ENABLE_AIR_EFFECT
-#define AUDIO_ENGINE_ENABLE_AIR_EFFECT 1
+/* Set to 0 to compile out baked assets: AUDIO_ASSET_BAKED assets (Tools/make_asset.py --bake)
+ * carry the LPF, makeup gain, DC blocker and air effect already applied, and play with only
+ * the EQ, speaker FIR, compressor, noise gate and soft clipper running on them. */
+#ifndef AUDIO_ENGINE_ENABLE_BAKED_ASSETS
+#define AUDIO_ENGINE_ENABLE_BAKED_ASSETS 1
+#endif
+
+/* Set to 0 to compile out noise-shaped 8-bit assets: AUDIO_ASSET_SHAPED assets
+ * (Tools/make_asset.py --shape) were quantised with error feedback that moves the noise to the
+ * top of the band, and play with the 8-bit dither and LPF left out. */
+#ifndef AUDIO_ENGINE_ENABLE_SHAPED_8BIT
+#define AUDIO_ENGINE_ENABLE_SHAPED_8BIT 1
+#endif
+
+/* Set to 1 to fold the volume into the 8-bit fetch: a 256-entry table of the centred 8-bit
+ * levels at the block's volume, rebuilt when the volume changes, turns the conversion and a
+ * steady volume into one load per sample, and a ramping volume is stepped per frame in the
+ * fetch, leaving FadeBlock() only the fades.  Used for a sound whose 8-bit filter chain is
+ * linear at its first block (no application stage, noise gate or soft clipper scheduled and the
+ * compressor not compressing) and that is not downmixed, whenever the volume is not steady at
+ * full; 512 bytes of RAM. */
+#ifndef AUDIO_ENGINE_ENABLE_PCM8_VOLUME_TABLE
+#define AUDIO_ENGINE_ENABLE_PCM8_VOLUME_TABLE 0
+#endif
+
+/* Set to 1 to take the LPF level, DC filter and air effect coefficients from per-rate tables
+ * generated at build time (Tools/make_coeff_tables.py, cmake/coeff_tables.cmake), so each
+ * level keeps the cutoff it has at 22050 Hz whatever the output rate.  At 0 the levels are the
+ * single alphas below, whatever the rate. */
+#ifndef AUDIO_ENGINE_ENABLE_RATE_COEFF_TABLES
+#define AUDIO_ENGINE_ENABLE_RATE_COEFF_TABLES 0
+#endif
+
+/* Parametric EQ bands (AudioEngine_SetEqBand()), 0 to compile the EQ out.  Each band is one
+ * biquad of the cascade at the head of the post-LPF filters; bands that are off cost nothing. */
+#ifndef AUDIO_ENGINE_EQ_BANDS
+#define AUDIO_ENGINE_EQ_BANDS 4U
+#endif
+
+/* Set to 1 for loudness compensation (AudioEngine_SetLoudnessCompensation()): a bass and a
+ * treble shelf after the EQ bands whose boost follows the volume after the response curve.
+ * Full volume has no boost; the boost grows by one table step for each
+ * AUDIO_ENGINE_LOUDNESS_STEP_DB the volume is below full, up to the maximum at the last of
+ * AUDIO_ENGINE_LOUDNESS_STEPS steps.  The table is designed for the output rate when it is set,
+ * so a volume change is only a lookup.  Needs AUDIO_ENGINE_EQ_BANDS; about
+ * 84 * AUDIO_ENGINE_LOUDNESS_STEPS bytes of RAM. */
+#ifndef AUDIO_ENGINE_ENABLE_LOUDNESS_COMP
+#define AUDIO_ENGINE_ENABLE_LOUDNESS_COMP 0
+#endif
+#if AUDIO_ENGINE_ENABLE_LOUDNESS_COMP
+#ifndef AUDIO_ENGINE_LOUDNESS_STEPS
+#define AUDIO_ENGINE_LOUDNESS_STEPS       16U       // Table entries, from no boost to the maximum
+#endif
+#ifndef AUDIO_ENGINE_LOUDNESS_STEP_DB
+#define AUDIO_ENGINE_LOUDNESS_STEP_DB     2.0f      // Volume below full per step
+#endif
+#ifndef AUDIO_ENGINE_LOUDNESS_BASS_HZ
+#define AUDIO_ENGINE_LOUDNESS_BASS_HZ     150.0f    // Low shelf corner
+#endif
+#ifndef AUDIO_ENGINE_LOUDNESS_BASS_DB
+#define AUDIO_ENGINE_LOUDNESS_BASS_DB     10.0f     // Low shelf boost at the last step
+#endif
+#ifndef AUDIO_ENGINE_LOUDNESS_TREBLE_HZ
+#define AUDIO_ENGINE_LOUDNESS_TREBLE_HZ   6000.0f   // High shelf corner
+#endif
+#ifndef AUDIO_ENGINE_LOUDNESS_TREBLE_DB
+#define AUDIO_ENGINE_LOUDNESS_TREBLE_DB   4.0f      // High shelf boost at the last step
+#endif
+#endif
+
+/* Most taps of the speaker correction FIR (AudioEngine_SetSpeakerFir()), 0 to compile it out.
+ * The history and two tap sets take about 4 * AUDIO_ENGINE_FIR_MAX_TAPS bytes of RAM each way. */
+#ifndef AUDIO_ENGINE_FIR_MAX_TAPS
+#define AUDIO_ENGINE_FIR_MAX_TAPS 256U
+#endif
+
+/* Share of the core the FIR may take at the output rate, in percent; taps that would need
+ * more are refused, and a rate that makes loaded taps exceed it runs without them */
+#ifndef AUDIO_ENGINE_FIR_MAX_LOAD_PCT
+#define AUDIO_ENGINE_FIR_MAX_LOAD_PCT 40U
+#endif
+
+/* Set to 1 to build the compressor and loudness normalisation stage (AudioEngine_SetCompressor(),
+ * AudioEngine_SetLoudnessTarget()) ahead of the EQ.  It costs nothing until one is set. */
+#ifndef AUDIO_ENGINE_ENABLE_COMPRESSOR
+#define AUDIO_ENGINE_ENABLE_COMPRESSOR 1U
+#endif
+
+/* Set to 0 to compile out PlayPlaylist() and its join buffer (HALFCHUNK_SZ stereo frames of RAM). */
+#ifndef AUDIO_ENGINE_ENABLE_PLAYLIST
+#define AUDIO_ENGINE_ENABLE_PLAYLIST 1
+#endif
+
+/* Set to 0 to compile out PlaySampleLooped() loop regions. */
+#ifndef AUDIO_ENGINE_ENABLE_LOOP_POINTS
+#define AUDIO_ENGINE_ENABLE_LOOP_POINTS 1
+#endif
+
+/* Set to 0 to compile out PlaySampleFrom() and SeekPlayback(). */
+#ifndef AUDIO_ENGINE_ENABLE_SEEK
+#define AUDIO_ENGINE_ENABLE_SEEK 1
+#endif
+
+/* Set to 0 to compile out CrossfadeToSample().  It shares the playlist's join buffer. */
+#ifndef AUDIO_ENGINE_ENABLE_CROSSFADE
+#define AUDIO_ENGINE_ENABLE_CROSSFADE 1
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SEEK
+/* Fade out before and in after a SeekPlayback() jump, in milliseconds */
+#ifndef AUDIO_ENGINE_SEEK_FADE_MS
+#define AUDIO_ENGINE_SEEK_FADE_MS 3U
+#endif
+#endif
+
+/* Set to 0 to compile out silence maps (AudioEngine_SetSilenceMap()): per-block peak tables,
+ * made by Tools/make_silence_map.py, that let periods below the noise gate skip the filter chain. */
+#ifndef AUDIO_ENGINE_ENABLE_SILENCE_MAP
+#define AUDIO_ENGINE_ENABLE_SILENCE_MAP 1
+#endif
+
+/* Source frames per silence map entry: a power of two, matching the converter's --block-frames. */
+#ifndef AUDIO_ENGINE_SILENCE_MAP_BLOCK_FRAMES
+#define AUDIO_ENGINE_SILENCE_MAP_BLOCK_FRAMES 256U
+#endif
+
+/* Set to 0 to compile out the mute (AudioEngine_SetMute(), AudioEngine_SetMuteLevel()).  Once the
+ * volume has ramped to silence, a muted PCM16 or PCM8 playback only moves its position and fade
+ * counters each period, leaving the ring silent, and its filters are settled where the sound is
+ * when it unmutes. */
+#ifndef AUDIO_ENGINE_ENABLE_MUTE
+#define AUDIO_ENGINE_ENABLE_MUTE 1
+#endif
+
+/* Set to 0 to compile out IMA-ADPCM sources: 4-bit samples, made by Tools/make_adpcm_header.py,
+ * played with a sample_depth of AUDIO_ENGINE_ADPCM_DEPTH and decoded a block at a time. */
+#ifndef AUDIO_ENGINE_ENABLE_ADPCM
+#define AUDIO_ENGINE_ENABLE_ADPCM 1
+#endif
+
+/* Bytes per channel in each ADPCM block (the WAV block_align divided by the channels), matching
+ * the converter's --block-bytes: a multiple of 4, at least 8. */
+#ifndef AUDIO_ENGINE_ADPCM_BLOCK_BYTES
+#define AUDIO_ENGINE_ADPCM_BLOCK_BYTES 256U
+#endif
+
+#define AUDIO_ENGINE_ADPCM_DEPTH        4U          // sample_depth that selects an IMA-ADPCM source
+#define AUDIO_ENGINE_ADPCM_BLOCK_FRAMES ( ( AUDIO_ENGINE_ADPCM_BLOCK_BYTES - 4U ) * 2U + 1U )
+
+/* Set to 0 to compile out lossless sources: 16-bit samples compressed with a fixed linear
+ * predictor and Rice-coded residuals by Tools/make_lossless_header.py, played with a
+ * sample_depth of AUDIO_ENGINE_LOSSLESS_DEPTH and decoded bit-exact a block at a time. */
+#ifndef AUDIO_ENGINE_ENABLE_LOSSLESS
+#define AUDIO_ENGINE_ENABLE_LOSSLESS 1
+#endif
+
+/* Frames in each independently decodable lossless block, matching the converter's
+ * --block-frames: 16 to 4096. */
+#ifndef AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES
+#define AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES 512U
+#endif
+
+#define AUDIO_ENGINE_LOSSLESS_DEPTH     2U          // sample_depth that selects a lossless source
+
+/* Set to 0 to compile out companded sources: G.711 mu-law and A-law samples, one byte per
+ * sample as written by Tools/make_companded_header.py, expanded to 16 bits through a table. */
+#ifndef AUDIO_ENGINE_ENABLE_COMPANDED
+#define AUDIO_ENGINE_ENABLE_COMPANDED 1
+#endif
+
+#define AUDIO_ENGINE_MULAW_DEPTH        5U          // sample_depth that selects a mu-law source
+#define AUDIO_ENGINE_ALAW_DEPTH         6U          // sample_depth that selects an A-law source
+
+/* Set to 0 to compile out SBC sources: 16-bit music coded in sub-band frames by
+ * Tools/make_sbc_header.py at about a sixth of its PCM size, played with a sample_depth of
+ * AUDIO_ENGINE_SBC_DEPTH and decoded a block of 4 or 8 frames at a time. */
+#ifndef AUDIO_ENGINE_ENABLE_SBC
+#define AUDIO_ENGINE_ENABLE_SBC 1
+#endif
+
+#define AUDIO_ENGINE_SBC_DEPTH          7U          // sample_depth that selects an SBC source
+
+/* Set to 0 to compile out mid/side sources: stereo samples stored by
+ * Tools/make_midside_header.py as a 16-bit mid and a half-rate or 8-bit side, rebuilt to left
+ * and right in the fetch stage. */
+#ifndef AUDIO_ENGINE_ENABLE_MIDSIDE
+#define AUDIO_ENGINE_ENABLE_MIDSIDE 1
+#endif
+
+#define AUDIO_ENGINE_MIDSIDE_DEPTH      9U          // sample_depth that selects a mid/side source
+
+/* Set to 0 to compile out packed 12-bit sources: PCM stored by Tools/make_asset.py with two
+ * samples in three bytes, a quarter less flash than PCM16, and unpacked eight samples from three
+ * words into the 16-bit path, so they skip the 8-bit low-pass. */
+#ifndef AUDIO_ENGINE_ENABLE_PCM12
+#define AUDIO_ENGINE_ENABLE_PCM12 1
+#endif
+
+#define AUDIO_ENGINE_PCM12_DEPTH        12U         // sample_depth that selects a packed 12-bit source
+
+/* Set to 0 to compile out silence-coded sources: 16-bit samples stored by
+ * Tools/make_rle_header.py as a table of silent runs and the frames between them, which are
+ * the only ones kept in flash.  The runs are written as zeros without reading flash, and with
+ * AUDIO_ENGINE_ENABLE_SILENCE_MAP a period inside one after the noise gate has closed is not
+ * filtered either. */
+#ifndef AUDIO_ENGINE_ENABLE_SILENCE_RLE
+#define AUDIO_ENGINE_ENABLE_SILENCE_RLE 1
+#endif
+
+#define AUDIO_ENGINE_SILENCE_RLE_DEPTH  13U         // sample_depth that selects a silence-coded source
+
+/* Set to 1 to keep the decoded PCM of the short ADPCM, lossless and SBC assets played last in
+ * RAM.  The first PlayAsset() of one decodes it as before and copies each period's frames into
+ * a free or the least recently used slot; once it has played to the end, later PlayAsset()s of
+ * it play 16-bit PCM from the slot and the decoder does not run.  The slots are laid out in the
+ * engine arena (AUDIO_ENGINE_ARENA_BYTES) by AudioEngine_Init(). */
+#ifndef AUDIO_ENGINE_ENABLE_ASSET_CACHE
+#define AUDIO_ENGINE_ENABLE_ASSET_CACHE 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_CACHE
+#ifndef AUDIO_ENGINE_ASSET_CACHE_SLOTS
+#define AUDIO_ENGINE_ASSET_CACHE_SLOTS      2U
+#endif
+/* Bytes per slot, a multiple of 4: an asset is cached only if its decoded PCM fits, and 16384
+ * holds 0.37 s of 22.05 kHz mono */
+#ifndef AUDIO_ENGINE_ASSET_CACHE_SLOT_BYTES
+#define AUDIO_ENGINE_ASSET_CACHE_SLOT_BYTES 16384U
+#endif
+#endif
+
+/* Output bus rate in Hz, or 0 to run the I2S at each sample's own rate.  With a bus rate,
+ * PlaySample() converts 8 and 16-bit PCM at any other rate, up to 4x the bus rate, to the bus
+ * rate through the resampler instead of reconfiguring the I2S, so a running stream is not
+ * restarted.  With AUDIO_ENGINE_ENABLE_I2S_CLOCK_PLAN it does so only on a running stream or
+ * when the I2S dividers miss the rate by more than AUDIO_ENGINE_RATE_TOLERANCE_PPM.  Other
+ * encodings, loops and playlists still set the I2S to their own rate. */
+#ifndef AUDIO_ENGINE_BUS_RATE
+#define AUDIO_ENGINE_BUS_RATE 0U
+#endif
+
+/* Resampler kernel used with AUDIO_ENGINE_BUS_RATE, from cheapest to best */
+#define AUDIO_ENGINE_RESAMPLE_LINEAR    0           // Linear interpolation
+#define AUDIO_ENGINE_RESAMPLE_CUBIC     1           // 4-point Catmull-Rom
+#define AUDIO_ENGINE_RESAMPLE_SINC      2           // 8-tap polyphase windowed sinc, SMLAD with AUDIO_ENGINE_ENABLE_DSP_SIMD
+#ifndef AUDIO_ENGINE_RESAMPLER
+#define AUDIO_ENGINE_RESAMPLER AUDIO_ENGINE_RESAMPLE_SINC
+#endif
+
+/* Oversampling factor, 1 (off), 2 or 4.  Without a bus rate, PlaySample() runs 8 and 16-bit PCM
+ * with the I2S at the largest factor times the sample's rate that is no more than
+ * AUDIO_ENGINE_OVERSAMPLE_MAX_HZ and interpolates the sample up through zero-phase half-band
+ * stages, which push the images of a low-rate sample out of the audio band so the 8-bit and
+ * biquad low-pass filters can be set more gently.  With AUDIO_ENGINE_BUS_RATE, samples at exactly
+ * 1/2 or 1/4 of the bus rate take the half-band stages instead of the resampler kernel.  Loops,
+ * playlists and samples queued on a running stream are not oversampled; the filters, mixer and
+ * effects run at the output rate. */
+#ifndef AUDIO_ENGINE_OVERSAMPLE
+#define AUDIO_ENGINE_OVERSAMPLE 1U
+#endif
+
+/* Highest output rate oversampling may set the I2S to */
+#ifndef AUDIO_ENGINE_OVERSAMPLE_MAX_HZ
+#define AUDIO_ENGINE_OVERSAMPLE_MAX_HZ 48000U
+#endif
+
+/* Set to 1 to stream 8 and 16-bit samples from external memory such as SPI/QSPI NOR flash
+ * (PlayStreamedSample(), PlayStreamedAsset()).  The application's DMA read function fills a
+ * ring of staging blocks ahead of the render context (AudioEngine_SourceStreamInit()). */
+#ifndef AUDIO_ENGINE_ENABLE_SOURCE_STREAM
+#define AUDIO_ENGINE_ENABLE_SOURCE_STREAM 0
+#endif
+
+/* Staging ring: AUDIO_ENGINE_STREAM_BLOCKS reads of AUDIO_ENGINE_STREAM_BLOCK_BYTES (a power of
+ * two; each read is one whole block at a block-aligned address, so a multiple of 512 gives
+ * multi-sector SD reads).  The ring must hold at least two of the largest periods.  What it
+ * buffers beyond one block and one period rides out a stall of the medium: 8 x 1 KB covers
+ * about 60 ms of 22 kHz 16-bit stereo, enough for NOR flash.  An SD card can stall for
+ * 100-250 ms during internal housekeeping; 16 x 2 KB covers about 300 ms. */
+#ifndef AUDIO_ENGINE_STREAM_BLOCK_BYTES
+#define AUDIO_ENGINE_STREAM_BLOCK_BYTES 1024U
+#endif
+
+#ifndef AUDIO_ENGINE_STREAM_BLOCKS
+#define AUDIO_ENGINE_STREAM_BLOCKS 8U
+#endif
+
+/* Milliseconds the application context waits for a read before giving up */
+#ifndef AUDIO_ENGINE_STREAM_TIMEOUT_MS
+#define AUDIO_ENGINE_STREAM_TIMEOUT_MS 100U
+#endif
+
+/* Set to 1 to play samples straight from QUADSPI NOR flash mapped at 0x90000000
+ * (AudioEngine_MapQspiAssets()).  Data placed with AUDIO_ENGINE_QSPI_ASSET is linked there and
+ * read in place like internal flash, with no staging ring; the controller's prefetch keeps a
+ * sequential burst going.  With AUDIO_ENGINE_ENABLE_PREFETCH_DMA and a word-wide channel each
+ * block comes over as one burst while the engine is idle.  Needs HAL_QSPI_MODULE_ENABLED. */
+#ifndef AUDIO_ENGINE_ENABLE_QSPI_XIP
+#define AUDIO_ENGINE_ENABLE_QSPI_XIP 0
+#endif
+
+/* Set to 1 for a RAM asset slot (PlayRamAsset()): one asset image, made by Tools/make_asset.py
+ * --ram, written into a RAM region the linker script reserves (-Wl,--defsym=__ram_asset_size)
+ * by a debugger or over the UART control port, and played like an asset in flash.  A new sound
+ * can be auditioned without rebuilding or reflashing the firmware. */
+#ifndef AUDIO_ENGINE_ENABLE_RAM_ASSET
+#define AUDIO_ENGINE_ENABLE_RAM_ASSET 0
+#endif
+
+/* Set to 1 for a live line input (AudioEngine_LineInInit(), PlayLineIn()).  An ADC channel, with
+ * one of the G474's OPAMPs in front as pre-amplifier, converts on a timer trigger at the I2S
+ * rate into a circular DMA ring.  Each period takes the newest samples as a mono 16-bit source
+ * through the filter chain, volume and fades.  The timer is steered so capture keeps pace
+ * with the I2S clock.  Input to output latency is one period plus
+ * AUDIO_ENGINE_LINE_IN_LATENCY_FRAMES plus the playback ring. */
+#ifndef AUDIO_ENGINE_ENABLE_LINE_IN
+#define AUDIO_ENGINE_ENABLE_LINE_IN 0
+#endif
+
+/* Capture ring in frames: a power of two with room for two of the largest periods and the latency */
+#ifndef AUDIO_ENGINE_LINE_IN_RING_FRAMES
+#define AUDIO_ENGINE_LINE_IN_RING_FRAMES 2048U
+#endif
+
+/* Frames captured beyond the period being rendered, the margin for the render's start to wander */
+#ifndef AUDIO_ENGINE_LINE_IN_LATENCY_FRAMES
+#define AUDIO_ENGINE_LINE_IN_LATENCY_FRAMES 16U
+#endif
+
+/* Bits in an ADC result: 12, or up to 16 with the ADC's oversampler giving a longer one */
+#ifndef AUDIO_ENGINE_LINE_IN_ADC_BITS
+#define AUDIO_ENGINE_LINE_IN_ADC_BITS 12U
+#endif
+
+/* Set to 1 to drive an accent LED from the output's envelope (AudioEngine_EnvelopePwmInit()).
+ * Each rendered period is cut into AUDIO_ENGINE_ENVELOPE_PWM_STEPS steps, whose peak or RMS,
+ * smoothed, sets a PWM duty in a ring laid out like the audio ring.  The timer's update DMA
+ * copies the ring into the channel's compare register, a value per PWM cycle, and the timer
+ * runs a cycle per step, held to the I2S position by its period, so the light follows what is
+ * heard with no interrupt and no foreground work. */
+#ifndef AUDIO_ENGINE_ENABLE_ENVELOPE_PWM
+#define AUDIO_ENGINE_ENABLE_ENVELOPE_PWM 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ENVELOPE_PWM
+#ifndef AUDIO_ENGINE_ENVELOPE_PWM_STEPS
+#define AUDIO_ENGINE_ENVELOPE_PWM_STEPS 8U          // PWM cycles per ring period: 344 Hz with 512-frame periods at 22 kHz
+#endif
+#endif
+
+/* Set to 1 for an output level meter (AudioEngine_GetMeter()).  Each rendered period's peak and
+ * RMS per channel, with a held peak that decays, is published for the application to read
+ * without a lock, for telemetry, level LEDs or gain checks.  One pass over each period. */
+#ifndef AUDIO_ENGINE_ENABLE_METER
+#define AUDIO_ENGINE_ENABLE_METER 0
+#endif
+
+/* Set to 1 for a pushed source (PlayPushedSource(), AudioEngine_PushFrames()).  A producer that
+ * delivers audio on its own clock, such as the USB audio sink in usb_audio.c, writes 16-bit
+ * frames into an elastic ring, from an interrupt if need be, and each period plays what it
+ * holds through the filter chain, volume and fades.  The producer keeps pace with the I2S
+ * clock from AudioEngine_GetPushLevel(); the ring takes up its jitter.  Input to output
+ * latency is about one period plus AUDIO_ENGINE_PUSH_LATENCY_FRAMES plus the playback ring. */
+#ifndef AUDIO_ENGINE_ENABLE_PUSH_SOURCE
+#define AUDIO_ENGINE_ENABLE_PUSH_SOURCE 0
+#endif
+
+/* Elastic ring in frames: a power of two with room for two of the largest periods and the latency */
+#ifndef AUDIO_ENGINE_PUSH_RING_FRAMES
+#define AUDIO_ENGINE_PUSH_RING_FRAMES 2048U
+#endif
+
+/* Frames left in the ring after a period is taken, the margin for the producer's jitter */
+#ifndef AUDIO_ENGINE_PUSH_LATENCY_FRAMES
+#define AUDIO_ENGINE_PUSH_LATENCY_FRAMES 96U
+#endif
+
+/* Set to 1 to look assets up by ID at runtime (AudioEngine_FindAsset(), PlayAssetById()).
+ * Entries registered with AUDIO_ENGINE_INDEX_ASSET() or AUDIO_ENGINE_INDEX_SAMPLE() are
+ * gathered and sorted by ID at link time into the .audio_index section of the linker script. */
+#ifndef AUDIO_ENGINE_ENABLE_ASSET_INDEX
+#define AUDIO_ENGINE_ENABLE_ASSET_INDEX 0
+#endif
+
+/* Set to 1 to check the indexed assets against the CRC-32 make_asset.py stores with them, in the
+ * background (AudioEngine_StartAssetVerify(), AudioEngine_ServiceAssetVerify()).  A DMA channel
+ * feeds the CRC unit a slice at a time from the application's idle loop, so start-up does not
+ * wait on it; an asset found corrupt is refused by PlayAsset() and PlayAssetById().  Needs
+ * AUDIO_ENGINE_ENABLE_ASSET_INDEX. */
+#ifndef AUDIO_ENGINE_ENABLE_ASSET_VERIFY
+#define AUDIO_ENGINE_ENABLE_ASSET_VERIFY 0
+#endif
+
+/* Bytes fed to the CRC unit per service call, and the most index entries the result bitmaps hold */
+#ifndef AUDIO_ENGINE_VERIFY_SLICE_BYTES
+#define AUDIO_ENGINE_VERIFY_SLICE_BYTES 4096U
+#endif
+
+#ifndef AUDIO_ENGINE_VERIFY_MAX_ASSETS
+#define AUDIO_ENGINE_VERIFY_MAX_ASSETS 128U
+#endif
+
+/* Set to 1 to play assets from an asset bank (AudioEngine_MountBank(), PlayBankAsset()): a
+ * flash partition programmed apart from the firmware, holding a header, a CRC-32 and an index
+ * sorted by ID, built by Tools/make_asset_bank.py.  Its samples are played in place.  The
+ * linker script reserves __asset_bank_size bytes at the top of flash for it. */
+#ifndef AUDIO_ENGINE_ENABLE_ASSET_BANK
+#define AUDIO_ENGINE_ENABLE_ASSET_BANK 0
+#endif
+
+/* Set to 1 to reprogram the asset bank while playback continues (AudioEngine_BeginBankUpdate()):
+ * the linker script reserves two bank slots in the second flash bank, and a new bank is written
+ * into the slot not mounted, checked with the CRC unit and swapped in.  Needs the asset bank,
+ * the dual-bank flash option (DBANK) and the firmware within the first bank. */
+#ifndef AUDIO_ENGINE_ENABLE_BANK_UPDATE
+#define AUDIO_ENGINE_ENABLE_BANK_UPDATE 0
+#endif
+
+/* Set to 1 to keep the tuned configuration in flash (AudioEngine_SavePreset()): the linker script
+ * reserves __preset_store_size bytes at the end of the firmware's flash, and start-up applies
+ * the preset saved there (AudioEngine_MountPresetStore()) in place of the compiled-in one.
+ * Saves are wear levelled over the partition's two halves and checked with the CRC unit. */
+#ifndef AUDIO_ENGINE_ENABLE_PRESET_STORE
+#define AUDIO_ENGINE_ENABLE_PRESET_STORE 0
+#endif
+
+/* Worst-case flash page erase time, in microseconds: the G474 datasheet's 2 KB page erase with
+ * margin.  A bank update starts an erase only when the ring holds this much rendered audio. */
+#ifndef AUDIO_ENGINE_FLASH_ERASE_US
+#define AUDIO_ENGINE_FLASH_ERASE_US 25000U
+#endif
+
+/* Worst-case flash double-word program time, in microseconds */
+#ifndef AUDIO_ENGINE_FLASH_PROGRAM_US
+#define AUDIO_ENGINE_FLASH_PROGRAM_US 100U
+#endif
+
+/* Set to 1 for PlayPhrase(): announcements stitched from word clips looked up by ID in the asset
+ * bank or the asset index, each trimmed of its leading and trailing silence and joined with a
+ * short crossfade as one playlist.  Needs the playlist and the asset bank or asset index. */
+#ifndef AUDIO_ENGINE_ENABLE_PHRASE
+#define AUDIO_ENGINE_ENABLE_PHRASE 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PHRASE
+/* Most clips in one phrase; PlayPhrase() keeps a playlist item for each */
+#ifndef AUDIO_ENGINE_PHRASE_MAX_CLIPS
+#define AUDIO_ENGINE_PHRASE_MAX_CLIPS 16U
+#endif
+
+/* Silence trimmed from a clip's ends is anything below its peak shifted down by this: 6 is -36 dB */
+#ifndef AUDIO_ENGINE_PHRASE_TRIM_SHIFT
+#define AUDIO_ENGINE_PHRASE_TRIM_SHIFT 6U
+#endif
+
+/* Frames kept either side of the sound after trimming, so soft onsets and tails survive */
+#ifndef AUDIO_ENGINE_PHRASE_PAD_FRAMES
+#define AUDIO_ENGINE_PHRASE_PAD_FRAMES 64U
+#endif
+#endif
+
+/* Set to 1 to use the Cortex-M4 DSP-extension (packed SIMD) kernels for stereo 16-bit processing.
+ * Defaults to 1 when the compiler targets a core with the DSP extension, otherwise the plain C
+ * path is used.  Forcing 1 on a core without the DSP extension will not compile. */
+#ifndef AUDIO_ENGINE_ENABLE_DSP_SIMD
+  #if defined( __ARM_FEATURE_DSP ) && ( __ARM_FEATURE_DSP == 1 )
+    #define AUDIO_ENGINE_ENABLE_DSP_SIMD 1
+  #else
+    #define AUDIO_ENGINE_ENABLE_DSP_SIMD 0
+  #endif
+#endif
+
+/* Set to 1 to run the 16-bit biquad LPF on the STM32G4 FMAC peripheral instead of the CPU.
+ * AudioEngine_Init() takes over the FMAC, so it must not be used elsewhere in the application.
+ * The FMAC keeps its filter history at 16 bits, so very low cutoffs are noisier than in software. */
+#ifndef AUDIO_ENGINE_ENABLE_FMAC_LPF
+#define AUDIO_ENGINE_ENABLE_FMAC_LPF 0
+#endif
+
+/* Set to 1 to run the 16-bit biquad LPF and the speaker correction FIR on ARM's CMSIS-DSP
+ * kernels (arm_biquad_cas_df1_32x64_q31(), arm_scale_q31(), arm_fir_q15()) instead of the
+ * engine's own, linked from the prebuilt library in Drivers/CMSIS/DSP.  The FMAC, when enabled,
+ * keeps the LPF.  AudioEngine_SetCmsisDsp() swaps the kernels at run time, so the benchmark
+ * firmware times both.  CMake: -DAUDIO_ENGINE_CMSIS_DSP=ON. */
+#ifndef AUDIO_ENGINE_ENABLE_CMSIS_DSP
+#define AUDIO_ENGINE_ENABLE_CMSIS_DSP 0
+#endif
+
+/* Set to 1 to build single-precision float kernels for the 16-bit biquad LPF, the DC blocker
+ * with the air effect, and the fades, with coefficients in float and flush-to-zero set in the
+ * FPU.  Samples are converted from int16 on entry to each float stretch and back on its exit;
+ * the stages between them stay fixed point.  AudioEngine_SetFloatDsp() swaps the kernels at
+ * run time, so the benchmark firmware times both.  CMSIS-DSP and the FMAC, when enabled, keep
+ * the LPF.  Needs the hard-float ABI.  CMake: -DAUDIO_ENGINE_FLOAT_DSP=ON. */
+#ifndef AUDIO_ENGINE_ENABLE_FLOAT_DSP
+#define AUDIO_ENGINE_ENABLE_FLOAT_DSP 0
+#endif
+
+/* Set to 1 to compute the runtime parameter conversions (cutoff to alpha, dB to gain, volume
+ * curve) with the STM32G4 CORDIC unit instead of libm expf/logf/powf.  Results agree with libm
+ * to about 1e-6 relative, and each conversion takes tens of cycles instead of hundreds. */
+#ifndef AUDIO_ENGINE_ENABLE_CORDIC_MATH
+#define AUDIO_ENGINE_ENABLE_CORDIC_MATH 0
+#endif
+
+/* Set to 1 to copy each source block from flash into an SRAM staging buffer with a
+ * memory-to-memory DMA channel while the engine is idle, so the chunk processor reads
+ * zero-wait-state RAM.  The channel is supplied with AudioEngine_SetPrefetchDMA(). */
+#ifndef AUDIO_ENGINE_ENABLE_PREFETCH_DMA
+#define AUDIO_ENGINE_ENABLE_PREFETCH_DMA 0
+#endif
+
+/* Set to 1 to send 32-bit I2S frames (configure the I2S for I2S_DATAFORMAT_32B).  The chain
+ * then renders at unity gain and the volume is applied in the 32-bit output stage, so the
+ * output keeps full source resolution at low volume.  Costs an extra 8 KB DMA buffer. */
+#ifndef AUDIO_ENGINE_OUTPUT_32BIT
+#define AUDIO_ENGINE_OUTPUT_32BIT 0
+#endif
+
+/* Number of I2S outputs (zones) driven from one processing pass, 1-4.  Zone 0 is
+ * AUDIO_ENGINE_I2S_HANDLE; the others are attached with AudioEngine_AttachZone() and each
+ * gets its own DMA buffer and gain.  The I2S init callback must set every zone up at
+ * I2S_PlaybackSpeed.  Each extra zone costs one more DMA buffer (4 KB, 8 KB at 32-bit). */
+#ifndef AUDIO_ENGINE_OUTPUT_ZONES
+#define AUDIO_ENGINE_OUTPUT_ZONES 1
+#endif
+
+/* Set to 1 to send the output on an SAI block (AUDIO_ENGINE_SAI_HANDLE) in place of the I2S.
+ * With more than one zone the block runs TDM, two slots a zone (zone z in slots 2z and 2z + 1),
+ * from one interleaved DMA buffer: one DMA channel and one interrupt pair serve every amplifier
+ * on the bus, and the zones cannot drift apart.  The I2S init callback must set the block up at
+ * I2S_PlaybackSpeed with 2 * AUDIO_ENGINE_OUTPUT_ZONES active slots of the output's width, and
+ * its FIFO threshold at a half or more so the DMA fills it in bursts.  The interleaved buffer
+ * holds every zone (4 KB a zone, 8 KB at 32-bit).  Needs HAL_SAI_MODULE_ENABLED. */
+#ifndef AUDIO_ENGINE_ENABLE_SAI_OUTPUT
+#define AUDIO_ENGINE_ENABLE_SAI_OUTPUT 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SAI_OUTPUT
+/* SAI block handle (default: hsai_BlockA1), with a linked TX DMA channel */
+#ifndef AUDIO_ENGINE_SAI_HANDLE
+#define AUDIO_ENGINE_SAI_HANDLE hsai_BlockA1
+#endif
+#endif
+
+/* Set to 1 for AudioEngine_PlanI2SClock() and AudioEngine_ApplyI2SClock(), which choose the I2S
+ * kernel clock (SYSCLK, PLL "Q", HSI16 or I2S_CKIN) and channel length whose divider lands
+ * nearest a rate, rather than the HAL's divider from SYSCLK alone. */
+#ifndef AUDIO_ENGINE_ENABLE_I2S_CLOCK_PLAN
+#define AUDIO_ENGINE_ENABLE_I2S_CLOCK_PLAN 1
+#endif
+
+/* Largest rate error in parts per million that AudioEngine_PlanI2SClock() counts as exact */
+#ifndef AUDIO_ENGINE_RATE_TOLERANCE_PPM
+#define AUDIO_ENGINE_RATE_TOLERANCE_PPM 1000U
+#endif
+
+/* Frequency in Hz of an audio oscillator on I2S_CKIN (PA12, AF5), or 0 if none is fitted.
+ * 11289600 or 12288000 gives the 11.025 and 8 kHz rate families exactly. */
+#ifndef AUDIO_ENGINE_I2S_CKIN_HZ
+#define AUDIO_ENGINE_I2S_CKIN_HZ 0U
+#endif
+
+/* Set to 1 to change a running stream's rate without stopping it (AudioEngine_RetuneStream()).
+ * PlaySample() at a new rate on an idle stream then waits for the ring to fall silent, holds
+ * the DMA at a frame boundary, reprograms only the I2S divider and kernel clock and lets the
+ * DMA carry on, instead of re-running the I2S init and restarting the ring: the output is
+ * still for a frame or two rather than stopped, and the DAC stays on.  Needs
+ * AUDIO_ENGINE_ENABLE_I2S_CLOCK_PLAN and a single output zone; a rate the planner misses by
+ * more than AUDIO_ENGINE_RATE_TOLERANCE_PPM still restarts the stream. */
+#ifndef AUDIO_ENGINE_ENABLE_HOT_RATE_SWITCH
+#define AUDIO_ENGINE_ENABLE_HOT_RATE_SWITCH 0
+#endif
+
+/* Set to 1 for AudioEngine_SetDriftTrim(), which keeps a running stream's audio in step with
+ * another unit's clock.  The output passes through a short delay line whose length moves one
+ * frame at a time, glided across a period, so the sound gains or loses frames against the
+ * I2S clock at the trimmed rate.  The G474's PLL has no fractional divider to nudge, and the
+ * I2S prescaler is an integer, so the rate itself cannot be trimmed finely.  The line adds
+ * AUDIO_ENGINE_DRIFT_TRIM_FRAMES / 2 frames of latency and recentres whenever it holds only
+ * silence. */
+#ifndef AUDIO_ENGINE_ENABLE_DRIFT_TRIM
+#define AUDIO_ENGINE_ENABLE_DRIFT_TRIM 0
+#endif
+
+/* Delay line length in frames, a power of two: half of it is the most one sound can gain or
+ * lose, 128 frames or about 6 ms at 22 kHz, which 100 ppm takes a minute to use up */
+#ifndef AUDIO_ENGINE_DRIFT_TRIM_FRAMES
+#define AUDIO_ENGINE_DRIFT_TRIM_FRAMES 256U
+#endif
+
+/* Largest trim AudioEngine_SetDriftTrim() accepts, in parts per million */
+#ifndef AUDIO_ENGINE_DRIFT_TRIM_MAX_PPM
+#define AUDIO_ENGINE_DRIFT_TRIM_MAX_PPM 1000U
+#endif
+
+/* Render periods over which a new air effect gain, LPF makeup gain or 16-bit LPF alpha glides
+ * to its value, so a setter driven from a knob does not zipper.  1 applies it at the next
+ * period.  While nothing plays, a new value applies at once. */
+#ifndef AUDIO_ENGINE_PARAM_SMOOTH_PERIODS
+#define AUDIO_ENGINE_PARAM_SMOOTH_PERIODS 8U
+#endif
+
+/* Number of mixer voices, 0-8, that play alongside the main sample on the output stream
+ * (AudioEngine_PlayVoice()).  0 compiles the mixer out; otherwise it costs a 4 KB mix bus. */
+#ifndef AUDIO_ENGINE_MIXER_VOICES
+#define AUDIO_ENGINE_MIXER_VOICES 0
+#endif
+
+/* Bytes of RAM for the delay lines of the mixer's reverb (AudioEngine_SetReverb()), with mixer
+ * voices.  16384 holds the full room up to 48 kHz; less, or a higher rate, shortens the lines
+ * to fit.  0 compiles the reverb out; otherwise it costs this plus a 3 KB send bus. */
+#ifndef AUDIO_ENGINE_REVERB_RAM_BYTES
+#define AUDIO_ENGINE_REVERB_RAM_BYTES 16384U
+#endif
+
+/* Bytes of the engine arena, the one block of RAM the speaker FIR histories, the decoded asset
+ * cache and the reverb's delay lines are laid out in at configuration time
+ * (AudioEngine_GetArenaStats()).  0 sizes it for the features built in at their largest; less
+ * makes the reverb's room smaller to fit. */
+#ifndef AUDIO_ENGINE_ARENA_BYTES
+#define AUDIO_ENGINE_ARENA_BYTES 0U
+#endif
+
+/* Set to 0 to compile out synthesised scores on the mixer voices (AudioEngine_PlayScore()).
+ * Each voice then carries AUDIO_ENGINE_SYNTH_NOTES notes of state, about 40 bytes a note, and
+ * the wavetables take 11 KB of flash. */
+#ifndef AUDIO_ENGINE_ENABLE_SYNTH
+#define AUDIO_ENGINE_ENABLE_SYNTH 1U
+#endif
+
+/* Notes of a score that sound at once on one voice; a note starting with all of them busy
+ * takes over the quietest */
+#ifndef AUDIO_ENGINE_SYNTH_NOTES
+#define AUDIO_ENGINE_SYNTH_NOTES 4U
+#endif
+
+/* Set to 0 to compile out ducking on the mixer (AudioEngine_SetDucker(), AudioEngine_SetVoiceBus()).
+ * It costs a few cycles a period, and nothing per sample. */
+#ifndef AUDIO_ENGINE_ENABLE_DUCKER
+#define AUDIO_ENGINE_ENABLE_DUCKER 1U
+#endif
+
+/* Set to 1 for time-stretched mixer voices (AudioEngine_SetVoiceTempo()), so one recording of
+ * an announcement serves several lengths at its pitch.  The voice is played by WSOLA: every
+ * hop it crossfades into a new segment of the sample, taken where the tempo has got to and
+ * moved by up to AUDIO_ENGINE_STRETCH_SEARCH frames to where it best matches what is fading
+ * out.  The search is a fixed number of correlations per hop, SMLALD with
+ * AUDIO_ENGINE_ENABLE_DSP_SIMD, so the cost per period is bounded whatever the tempo. */
+#ifndef AUDIO_ENGINE_ENABLE_TIME_STRETCH
+#define AUDIO_ENGINE_ENABLE_TIME_STRETCH 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_TIME_STRETCH
+/* Output frames between splices, and the length of each crossfade: 256 is 12 ms at 22 kHz */
+#ifndef AUDIO_ENGINE_STRETCH_HOP_FRAMES
+#define AUDIO_ENGINE_STRETCH_HOP_FRAMES 256U
+#endif
+
+/* Source frames a splice may move either way from where the tempo puts it; about the longest
+ * pitch period it can align, 3 ms at 22 kHz */
+#ifndef AUDIO_ENGINE_STRETCH_SEARCH
+#define AUDIO_ENGINE_STRETCH_SEARCH 64U
+#endif
+
+/* Source frames each candidate is correlated over, even */
+#ifndef AUDIO_ENGINE_STRETCH_CORR_FRAMES
+#define AUDIO_ENGINE_STRETCH_CORR_FRAMES 128U
+#endif
+#endif
+
+/* Set to 1 for modulators on the mixer voices (AudioEngine_SetVoiceMod()): LFOs and ADSR
+ * envelopes that move a voice's gain, pan, pitch or a low-pass cutoff on their own, for
+ * tremolo, vibrato, swells and sweeps.  They are worked out once a period, so they cost a few
+ * cycles a period each, and the low-pass two multiplies a sample on the voices that use it. */
+#ifndef AUDIO_ENGINE_ENABLE_VOICE_MOD
+#define AUDIO_ENGINE_ENABLE_VOICE_MOD 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_VOICE_MOD
+/* Modulators each voice carries, 1-4 */
+#ifndef AUDIO_ENGINE_VOICE_MODS
+#define AUDIO_ENGINE_VOICE_MODS 2U
+#endif
+#endif
+
+/* Set to 1 for sampler instruments on the mixer voices (AudioEngine_SetInstrument(),
+ * AudioEngine_NoteOn(), AudioEngine_NoteOff()).  A few recorded notes are each spread over a
+ * key range and repitched to the key played.  A zone's loop region is held while its key is
+ * down and let go on release, so the recording's tail plays out. */
+#ifndef AUDIO_ENGINE_ENABLE_SAMPLER
+#define AUDIO_ENGINE_ENABLE_SAMPLER 0
+#endif
+
+/* Set to 1 for a streamed mixer voice (AudioEngine_PlayStreamVoice(), AudioEngine_Write()).
+ * Audio the application makes or receives itself, from a decoder, a synthesiser or a UART,
+ * is written into a ring in batches of any size and played on a mixer voice alongside the
+ * other sounds, at any rate up to the stream's.  AudioEngine_OnStreamVoiceLow() asks for
+ * more once the ring falls to a low-water mark, so the producer can fill it a batch at a
+ * time rather than keep pace with every period. */
+#ifndef AUDIO_ENGINE_ENABLE_STREAM_VOICE
+#define AUDIO_ENGINE_ENABLE_STREAM_VOICE 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_STREAM_VOICE
+/* Ring in frames: a power of two of at least two of the largest periods; 4 bytes a frame */
+#ifndef AUDIO_ENGINE_STREAM_VOICE_FRAMES
+#define AUDIO_ENGINE_STREAM_VOICE_FRAMES 2048U
+#endif
+#endif
+
+/* Set to 1 for the chime sequencer (AudioEngine_RunSequence()): a bytecode script of voice
+ * starts, waits, gain changes, loops and branches, run by the render once per period. */
+#ifndef AUDIO_ENGINE_ENABLE_SEQUENCER
+#define AUDIO_ENGINE_ENABLE_SEQUENCER 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SEQUENCER
+/* Mixer voices the sequencer keeps for its scripts, the last of AUDIO_ENGINE_MIXER_VOICES;
+ * AudioEngine_PlayVoice() and AudioEngine_PlayScore() share the rest */
+#ifndef AUDIO_ENGINE_SEQUENCER_VOICES
+#define AUDIO_ENGINE_SEQUENCER_VOICES 2U
+#endif
+
+/* Loops a script may nest */
+#ifndef AUDIO_ENGINE_SEQUENCER_LOOP_DEPTH
+#define AUDIO_ENGINE_SEQUENCER_LOOP_DEPTH 4U
+#endif
+
+/* Instructions run in one period before the script is held to the next, so a loop with no
+ * wait in it costs a bounded time rather than hanging the render */
+#ifndef AUDIO_ENGINE_SEQUENCER_STEPS
+#define AUDIO_ENGINE_SEQUENCER_STEPS 32U
+#endif
+#endif
+
+/* Set to 1 to time the DMA callback and each chunk-processing stage with the DWT cycle
+ * counter.  Read the results with AudioEngine_GetProfile(); costs a few cycles per stage. */
+#ifndef AUDIO_ENGINE_ENABLE_PROFILING
+#define AUDIO_ENGINE_ENABLE_PROFILING 0
+#endif
+
+/* Set to 1 to pick the ring's period size at AudioEngine_Init() by timing the render on this
+ * core (AudioEngine_CalibratePeriod()), with AUDIO_ENGINE_ENABLE_PROFILING.  The chunk
+ * processors are timed with the filter chain as configured at each period size, and the
+ * smallest period whose render, with AUDIO_ENGINE_PERIOD_CAL_JITTER_US held off by other
+ * interrupts, takes no more than AUDIO_ENGINE_PERIOD_CAL_BUDGET_PCT of the deadline at
+ * AUDIO_ENGINE_PERIOD_CAL_RATE is kept, for the lowest latency the build can hold. */
+#ifndef AUDIO_ENGINE_ENABLE_PERIOD_CALIBRATION
+#define AUDIO_ENGINE_ENABLE_PERIOD_CALIBRATION 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PERIOD_CALIBRATION
+#ifndef AUDIO_ENGINE_PERIOD_CAL_RATE
+#define AUDIO_ENGINE_PERIOD_CAL_RATE        44100U  // Output rate the period must hold, the highest the product plays
+#endif
+#ifndef AUDIO_ENGINE_PERIOD_CAL_BUDGET_PCT
+#define AUDIO_ENGINE_PERIOD_CAL_BUDGET_PCT  50U     // Share of the deadline the render may take; the rest is margin
+#endif
+#ifndef AUDIO_ENGINE_PERIOD_CAL_JITTER_US
+#define AUDIO_ENGINE_PERIOD_CAL_JITTER_US   50U     // Longest the render may be held off by other interrupts
+#endif
+#ifndef AUDIO_ENGINE_PERIOD_CAL_OVERHEAD
+#define AUDIO_ENGINE_PERIOD_CAL_OVERHEAD    1500U   // Cycles per period outside the chunk processor: interrupt, volume read, configuration
+#endif
+#endif
+
+/* Set to 1 for constant-cost kernels, so a render costs what its configuration costs whatever
+ * the audio: the noise gate and the fades multiply every sample, with the gain ramp's end and
+ * the held gain picked by selects rather than by loops that stop early or skip a unity gain,
+ * the compressor takes its log on silence too, and the loudness shelves run at no boost.  The
+ * soft clipper is a table lookup either way.  The worst case is then the typical case, which
+ * AudioEngine_Benchmark() reports as the worst run over varied test data.  Costs the cycles the
+ * skips saved; not with AUDIO_ENGINE_ENABLE_PCM8_VOLUME_TABLE or the float kernels. */
+#ifndef AUDIO_ENGINE_ENABLE_CONSTANT_TIME
+#define AUDIO_ENGINE_ENABLE_CONSTANT_TIME 0
+#endif
+
+/* Set to 1 to check each rendered period against the I2S DMA read position, counting the
+ * periods the I2S reached before they were finished and the least slack left before one was
+ * due (AudioEngine_GetDeadlineStats()).  Costs a read of the DMA counter per period. */
+#ifndef AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR
+#define AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR 1
+#endif
+
+/* Set to 1 to conceal a missed render deadline rather than let the I2S replay the stale audio
+ * left in the period, heard as a buzz.  A period the I2S has already started to read when the
+ * render comes to it is not rendered: the stale audio fades out from where the I2S is over
+ * AUDIO_ENGINE_CONCEAL_FADE_FRAMES, 8 and 16-bit PCM skips a period ahead so the sound keeps
+ * its length, and the next period fades back in.  The render also catches up sooner.  Needs
+ * AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR, and is on with it by default. */
+#ifndef AUDIO_ENGINE_ENABLE_UNDERRUN_CONCEAL
+#define AUDIO_ENGINE_ENABLE_UNDERRUN_CONCEAL AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR
+#endif
+
+#if AUDIO_ENGINE_ENABLE_UNDERRUN_CONCEAL
+#ifndef AUDIO_ENGINE_CONCEAL_FADE_FRAMES
+#define AUDIO_ENGINE_CONCEAL_FADE_FRAMES 64U        // Fade out of the stale audio, and back in after (~3 ms at 22 kHz)
+#endif
+#endif
+
+/* Set to 1 to paint the free main stack at AudioEngine_Init() and measure how deep it has been
+ * used since, and to record the most interrupts nested at once when the render and the other
+ * handlers run (AudioEngine_GetStackStats()), so _Min_Stack_Size in the linker script can be
+ * sized from a measurement (AUDIO_ENGINE_STACK_MONITOR).  Painting takes a fraction of a
+ * millisecond at init with interrupts off; a nesting sample costs a few tens of cycles. */
+#ifndef AUDIO_ENGINE_ENABLE_STACK_MONITOR
+#define AUDIO_ENGINE_ENABLE_STACK_MONITOR 0
+#endif
+
+/* Set to 1 to keep the last AUDIO_ENGINE_EVENT_TRACE_LEN engine events in a ring for post-mortem
+ * analysis: playback state changes, commands posted, underruns, filter configuration swaps and
+ * trigger edges, three words each with a CYCCNT timestamp.  The ring (audio_engine_trace) is not
+ * cleared at reset, so a unit that glitched or reset in the field can be read afterwards over
+ * SWD, or sent over a UART from AudioEngine_CopyTrace(), and decoded with Docs/decode_trace.py.
+ * Recording takes no lock and a few tens of cycles; with 0 the trace points compile to nothing. */
+#ifndef AUDIO_ENGINE_ENABLE_EVENT_TRACE
+#define AUDIO_ENGINE_ENABLE_EVENT_TRACE 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_EVENT_TRACE
+#ifndef AUDIO_ENGINE_EVENT_TRACE_LEN
+#define AUDIO_ENGINE_EVENT_TRACE_LEN    64U         // Events kept, a power of two; 12 bytes each
+#endif
+#endif
+
+#if AUDIO_ENGINE_ENABLE_STACK_MONITOR
+#ifndef AUDIO_ENGINE_STACK_PAINT
+#define AUDIO_ENGINE_STACK_PAINT        0xA5A5A5A5U // Word the free stack is painted with
+#endif
+#ifndef AUDIO_ENGINE_STACK_PAINT_MARGIN
+#define AUDIO_ENGINE_STACK_PAINT_MARGIN 64U         // Bytes left unpainted below the SP at the paint
+#endif
+#endif
+
+/* Set to 1 to time a trigger from its input edge to the sound: the application marks the edge
+ * from its EXTI handler (AudioEngine_MarkTrigger()) and the engine records when PlaySample()
+ * ran, when the output DMA started and when its first half-complete interrupt came
+ * (AudioEngine_GetLatencyStats()).  Runs the DWT cycle counter; a few cycles per playback. */
+#ifndef AUDIO_ENGINE_ENABLE_LATENCY_PROBE
+#define AUDIO_ENGINE_ENABLE_LATENCY_PROBE 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_LATENCY_PROBE
+#ifndef AUDIO_ENGINE_LATENCY_LIMIT_MS
+#define AUDIO_ENGINE_LATENCY_LIMIT_MS   2000U       // Longer is a stale edge (a glitch, not a trigger) and is dropped
+#endif
+#endif
+
+/* Set to 1 to account where the time goes on a battery unit: the core running, in sleep and in
+ * STOP, each split by what the engine was doing (AudioEngine_GetEnergyStats()), over all time
+ * and over the last playback.  The DWT cycle counter times it; DBGMCU is set to keep it counting
+ * in sleep and STOP, which also keeps the core clock running there, so the profile is right
+ * about time but the unit draws more than it will in the field: multiply the times by each
+ * state's current (Docs/energy_report.py).  The application marks its own sleeps and clock
+ * changes with AudioEngine_SetPowerState(); a few tens of cycles per render and per sleep.  A
+ * sleep longer than 2^32 cycles, 25 s at 170 MHz or 268 s in STOP, is counted short. */
+#ifndef AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+#define AUDIO_ENGINE_ENABLE_ENERGY_PROFILE 0
+#endif
+
+/* Set to 1 to keep the attack of one sound rendered in RAM, filtered and faded in
+ * (AudioEngine_CacheNextAttack()).  PlaySample() of that sound then starts the DMA on the
+ * cached first ring instead of rendering it, and the render catches up from the first frame
+ * at two periods per period played, so the first ring played costs twice the usual render
+ * load.  16-bit single-zone output only. */
+#ifndef AUDIO_ENGINE_ENABLE_ATTACK_CACHE
+#define AUDIO_ENGINE_ENABLE_ATTACK_CACHE 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ATTACK_CACHE
+#ifndef AUDIO_ENGINE_ATTACK_CACHE_FRAMES
+#define AUDIO_ENGINE_ATTACK_CACHE_FRAMES ( 2U * AUDIO_ENGINE_RING_FRAMES )  // Stereo frames: the catch-up needs two rings less a period
+#endif
+#endif
+
+/* Set to 1 for AudioEngine_SetPassthrough(): 16-bit stereo PCM at its own rate is then played
+ * by the I2S DMA straight from the asset, with no render, filters, fades or software volume.
+ * The DMA runs in chunks of up to 65534 samples, restarted from its transfer complete
+ * interrupt within one sample slot.  16-bit single-zone output only. */
+#ifndef AUDIO_ENGINE_ENABLE_PASSTHROUGH
+#define AUDIO_ENGINE_ENABLE_PASSTHROUGH 0
+#endif
+
+/* Set to 1 for AudioEngine_SetDACReady(): a DAC switch that returns before the amplifier has
+ * settled reports when it has, and a playback whose ring is ready first streams silence over
+ * the I2S, a few frames at a time, until it does.  The ring then starts at once, so the settle
+ * time overlaps the prefill and whatever ran since the switch rather than adding to it.
+ * Single-zone output only. */
+#ifndef AUDIO_ENGINE_ENABLE_DAC_SETTLE
+#define AUDIO_ENGINE_ENABLE_DAC_SETTLE 0
+#endif
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+#ifndef AUDIO_ENGINE_DAC_SETTLE_MAX_MS
+#define AUDIO_ENGINE_DAC_SETTLE_MAX_MS  100U                // Silence streamed at most before the ring starts regardless
+#endif
+#endif
+
+/* Set to 1 for playback events: the end of a playback, position markers and loop wraps are
+ * queued by the render context and handed to a callback in the application's context by
+ * AudioEngine_WaitForEvent(), which sleeps with WFI until the next one.  WaitForSampleEnd()
+ * then sleeps and delivers the events too, instead of spinning. */
+#ifndef AUDIO_ENGINE_ENABLE_EVENTS
+#define AUDIO_ENGINE_ENABLE_EVENTS 0
+#endif
+#if AUDIO_ENGINE_ENABLE_EVENTS
+#ifndef AUDIO_ENGINE_EVENT_MARKERS
+#define AUDIO_ENGINE_EVENT_MARKERS  4U                      // Position markers (AudioEngine_SetMarker())
+#endif
+#endif
+
+/* Set to 1 for a background job queue run in the application's idle time.  WaitForSampleEnd()
+ * and AudioEngine_WaitForEvent() run the queued jobs in slices of at most
+ * AUDIO_ENGINE_IDLE_SLICE_US between their checks, before they sleep, and the EQ design, the
+ * volume and soft clipper tables and the asset check are posted there by their setters instead
+ * of being done in the call.  Call AudioEngine_RunIdleJobs() from other idle loops too. */
+#ifndef AUDIO_ENGINE_ENABLE_IDLE_JOBS
+#define AUDIO_ENGINE_ENABLE_IDLE_JOBS 0
+#endif
+#if AUDIO_ENGINE_ENABLE_IDLE_JOBS
+#ifndef AUDIO_ENGINE_IDLE_JOBS
+#define AUDIO_ENGINE_IDLE_JOBS      8U                      // Queue slots, the engine's own included
+#endif
+#ifndef AUDIO_ENGINE_IDLE_SLICE_US
+#define AUDIO_ENGINE_IDLE_SLICE_US  200U                    // No job step starts once a slice has run this long
+#endif
+#endif
+
+/* Set to 1 to end a sound once its tail has decayed below audibility instead of rendering it,
+ * and powering the amplifier, to the end of the data.  When the output of the main playback
+ * has stayed below AUDIO_ENGINE_AUTO_END_LEVEL for AUDIO_ENGINE_AUTO_END_HOLD_MS it fades out
+ * over AUDIO_ENGINE_AUTO_END_FADE_MS and ends as at the end of its data, DAC-off included; a
+ * mixer voice quiet as long ramps out over one block and is freed.  The hold has to outlast
+ * the longest pause inside any sound played: AudioEngine_SetAutoEnd() changes both at run time. */
+#ifndef AUDIO_ENGINE_ENABLE_AUTO_END
+#define AUDIO_ENGINE_ENABLE_AUTO_END 0
+#endif
+#if AUDIO_ENGINE_ENABLE_AUTO_END
+#ifndef AUDIO_ENGINE_AUTO_END_LEVEL
+#define AUDIO_ENGINE_AUTO_END_LEVEL     8U                  // Peak counted as silent, in 16-bit units (-72 dBFS)
+#endif
+#ifndef AUDIO_ENGINE_AUTO_END_HOLD_MS
+#define AUDIO_ENGINE_AUTO_END_HOLD_MS   150U                // Time below it before the sound ends
+#endif
+#ifndef AUDIO_ENGINE_AUTO_END_FADE_MS
+#define AUDIO_ENGINE_AUTO_END_FADE_MS   2U                  // Micro-fade of the main playback's end
+#endif
+#endif
+
+/* Set to 1 to power the amplifier down over long silences inside a sample under automatic DAC
+ * control.  The silence ahead is read from the sample's silence metadata: the runs of a
+ * silence-coded sample or the peak table of AudioEngine_SetSilenceMap().  Once all the I2S has
+ * still to play is quiet and at least AUDIO_ENGINE_AMP_GATE_MS of silence follows, the DAC is
+ * switched off; it is switched back on AUDIO_ENGINE_AMP_GATE_LEAD_MS, plus a period, before the
+ * sound resumes, so the lead must cover the DAC switch's settle time.  The switching is done by
+ * AudioEngine_ServiceAmpGate() in the application's wait loop, never by the render. */
+#ifndef AUDIO_ENGINE_ENABLE_AMP_GATE
+#define AUDIO_ENGINE_ENABLE_AMP_GATE 0
+#endif
+#if AUDIO_ENGINE_ENABLE_AMP_GATE
+#ifndef AUDIO_ENGINE_AMP_GATE_MS
+#define AUDIO_ENGINE_AMP_GATE_MS        500U                // Shortest silence the amplifier is switched off for
+#endif
+#ifndef AUDIO_ENGINE_AMP_GATE_LEAD_MS
+#define AUDIO_ENGINE_AMP_GATE_LEAD_MS   20U                 // Switched on this far ahead: the 10 ms settle and a margin
+#endif
+#ifndef AUDIO_ENGINE_AMP_GATE_LEVEL
+#define AUDIO_ENGINE_AMP_GATE_LEVEL     8U                  // Output swing, and map peak, counted as silent (16-bit units)
+#endif
+#endif
+
+/* Set to 1 to estimate the render load of a playback and of a filter configuration from a
+ * per-stage cost table before either takes effect, so a combination the core cannot render in
+ * time leaves out stages or is refused instead of glitching (AudioEngine_SetLoadPolicy()).
+ * The defaults are conservative figures for the G474 at any clock; measure the table for a
+ * build with the benchmark firmware (AUDIO_ENGINE_BENCHMARK) and set the AUDIO_ENGINE_COST_*
+ * values, or call AudioEngine_CalibrateLoadModel() at boot in a profiling build. */
+#ifndef AUDIO_ENGINE_ENABLE_LOAD_ADMISSION
+#define AUDIO_ENGINE_ENABLE_LOAD_ADMISSION 1
+#endif
+
+#if AUDIO_ENGINE_ENABLE_LOAD_ADMISSION
+#ifndef AUDIO_ENGINE_LOAD_BUDGET_PCT
+#define AUDIO_ENGINE_LOAD_BUDGET_PCT    75U         // Share of the core one playback may take; the rest is margin
+#endif
+/* Cycles per source sample, times 100 */
+#ifndef AUDIO_ENGINE_COST_BASE_16BIT
+#define AUDIO_ENGINE_COST_BASE_16BIT    1200U       // Fetch, volume, DC filter, fades and output of 16-bit PCM
+#endif
+#ifndef AUDIO_ENGINE_COST_BASE_8BIT
+#define AUDIO_ENGINE_COST_BASE_8BIT     1600U       // The same for 8-bit PCM, with the dithered unpack
+#endif
+#ifndef AUDIO_ENGINE_COST_LPF_16BIT
+#define AUDIO_ENGINE_COST_LPF_16BIT     1400U       // 16-bit biquad low-pass filter
+#endif
+#ifndef AUDIO_ENGINE_COST_LPF_8BIT
+#define AUDIO_ENGINE_COST_LPF_8BIT      1000U       // 8-bit low-pass filter
+#endif
+#ifndef AUDIO_ENGINE_COST_AIR_EFFECT
+#define AUDIO_ENGINE_COST_AIR_EFFECT    1000U       // Air effect shelf
+#endif
+#ifndef AUDIO_ENGINE_COST_NOISE_GATE
+#define AUDIO_ENGINE_COST_NOISE_GATE    600U        // Noise gate
+#endif
+#ifndef AUDIO_ENGINE_COST_SOFT_CLIP
+#define AUDIO_ENGINE_COST_SOFT_CLIP     500U        // Soft clipper
+#endif
+#ifndef AUDIO_ENGINE_COST_PERIOD
+#define AUDIO_ENGINE_COST_PERIOD        1500U       // Cycles per ring period: interrupt, volume read, configuration
+#endif
+#endif
+
+/* Set to 1 to run the core during playback at the lowest clock the render cost model fits in
+ * AUDIO_ENGINE_LOAD_BUDGET_PCT of.  The AHB prescaler divides HCLK down from SYSCLK once the
+ * DMA has started, and SYSCLK, the PLL and so the I2S kernel clock stay as they are.  Needs
+ * AUDIO_ENGINE_ENABLE_LOAD_ADMISSION; a render that comes close to its deadline (with
+ * AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR) puts the full clock back for the rest of the playback. */
+#ifndef AUDIO_ENGINE_ENABLE_CLOCK_SCALING
+#define AUDIO_ENGINE_ENABLE_CLOCK_SCALING 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_CLOCK_SCALING
+#ifndef AUDIO_ENGINE_MIN_CORE_HZ
+#define AUDIO_ENGINE_MIN_CORE_HZ        16000000U   // Lowest HCLK chosen; SYSCLK is divided by at most 16
+#endif
+#endif
+
+/* Set to 1 to give up quality in steps when renders come close to their deadline, rather than
+ * run late and glitch: first the air effect, then the 16-bit biquad low-pass runs as a one-pole,
+ * then the bus-rate resampler falls back to linear interpolation, and last, playing voices are
+ * stopped, lowest priority first.  Each period's slack from AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR
+ * drives it; a step is given back after a run of periods with slack to spare
+ * (AudioEngine_SetQualityGovernor()).  Costs a few comparisons per period. */
+#ifndef AUDIO_ENGINE_ENABLE_QUALITY_GOVERNOR
+#define AUDIO_ENGINE_ENABLE_QUALITY_GOVERNOR 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_QUALITY_GOVERNOR
+#ifndef AUDIO_ENGINE_QUALITY_SETTLE_PERIODS
+#define AUDIO_ENGINE_QUALITY_SETTLE_PERIODS 4U      // Periods after a step before the slack is judged again
+#endif
+#endif
+
+/* Set to 1 to drive GPIO trace pins high while the engine is in the DMA interrupt, renders
+ * ring periods, fetches samples into a PCM period and reads the volume control, so render
+ * duty cycle and jitter can be measured on a scope at full clock without a debugger.  The
+ * application configures the pins as outputs (AUDIO_ENGINE_TRACE_PINS); a pin of 0 is not
+ * traced.  Each edge is one store to the port's BSRR. */
+#ifndef AUDIO_ENGINE_ENABLE_TRACE_PINS
+#define AUDIO_ENGINE_ENABLE_TRACE_PINS 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_TRACE_PINS
+#ifndef AUDIO_ENGINE_TRACE_PORT
+#define AUDIO_ENGINE_TRACE_PORT         GPIOA       // Free on the board, away from the I2S lines
+#endif
+#ifndef AUDIO_ENGINE_TRACE_CALLBACK_PIN
+#define AUDIO_ENGINE_TRACE_CALLBACK_PIN GPIO_PIN_8  // DMA half and full transfer interrupts
+#endif
+#ifndef AUDIO_ENGINE_TRACE_RENDER_PIN
+#define AUDIO_ENGINE_TRACE_RENDER_PIN   GPIO_PIN_9  // Rendering the periods the I2S has finished with
+#endif
+#ifndef AUDIO_ENGINE_TRACE_FETCH_PIN
+#define AUDIO_ENGINE_TRACE_FETCH_PIN    GPIO_PIN_10 // Fetching and scaling a PCM period, before the filters
+#endif
+#ifndef AUDIO_ENGINE_TRACE_VOLUME_PIN
+#define AUDIO_ENGINE_TRACE_VOLUME_PIN   GPIO_PIN_11 // Reading the volume control for a period
+#endif
+#define AUDIO_ENGINE_TRACE_PINS         ( AUDIO_ENGINE_TRACE_CALLBACK_PIN | AUDIO_ENGINE_TRACE_RENDER_PIN | \
+                                          AUDIO_ENGINE_TRACE_FETCH_PIN | AUDIO_ENGINE_TRACE_VOLUME_PIN )
+#endif
+
+/* Set to 1 to stream engine statistics and an optional decimated audio tap over SWO, on ITM
+ * stimulus ports, while the core runs (AudioEngine_SetTelemetryTap()).  Decode and plot the
+ * capture with Docs/itm_telemetry.py.  Nothing is sent until a debugger enables the ports,
+ * and a full ITM FIFO drops the rest of a frame rather than stalling the render. */
+#ifndef AUDIO_ENGINE_ENABLE_ITM_TELEMETRY
+#define AUDIO_ENGINE_ENABLE_ITM_TELEMETRY 0
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ITM_TELEMETRY
+#ifndef AUDIO_ENGINE_ITM_STATS_PORT
+#define AUDIO_ENGINE_ITM_STATS_PORT     1U          // Statistics frames; port 0 is left to printf()
+#endif
+#ifndef AUDIO_ENGINE_ITM_TAP_PORT
+#define AUDIO_ENGINE_ITM_TAP_PORT       2U          // Audio tap blocks
+#endif
+#ifndef AUDIO_ENGINE_ITM_STATS_PERIODS
+#define AUDIO_ENGINE_ITM_STATS_PERIODS  16U         // Ring periods per statistics frame
+#endif
+#endif
+
+/* Set to 1 to place the chunk processors, filter kernels and filter state in the G474's
+ * 32 KB CCM SRAM (zero wait states, off the bus the DMA uses).  The startup code copies the
+ * .ccmram section from flash; pb_buffer stays in main SRAM.  CMake: -DAUDIO_ENGINE_DSP_RAM=CCMSRAM. */
+#ifndef AUDIO_ENGINE_USE_CCMSRAM
+#define AUDIO_ENGINE_USE_CCMSRAM 0
+#endif
+
+/* Set to 1 to run the DSP path (the same functions as AUDIO_ENGINE_USE_CCMSRAM) from main
+ * SRAM through the .RamFunc section, which the startup code copies along with .data.  Normally
+ * set from CMake with -DAUDIO_ENGINE_DSP_RAM=SRAM. */
+#ifndef AUDIO_ENGINE_RAM_EXEC
+#define AUDIO_ENGINE_RAM_EXEC 0
+#endif
+
+/* Set to 1 to keep the I2S stream running between samples.  The first PlaySample() starts a
+ * silent stream (AudioEngine_StartStream()) and ShutDownAudio() leaves it running, so a later
+ * sample at the same rate starts at the next period with no I2S re-init and no DAC power-up.
+ * Latency is then at most one ring (see AudioEngine_SetBufferGeometry()).  The DAC stays on
+ * until AudioEngine_StopStream(). */
+#ifndef AUDIO_ENGINE_ALWAYS_ON
+#define AUDIO_ENGINE_ALWAYS_ON 0
+#endif
+
+/* Frames from the output DMA's read position to the sound leaving the DAC, taken off the
+ * position AudioEngine_GetPosition() reports.  The I2S holds about one frame in its data and
+ * shift registers; add the DAC's group delay, from its datasheet, for light or multi-unit sync
+ * tighter than a millisecond. */
+#ifndef AUDIO_ENGINE_OUTPUT_DELAY_FRAMES
+#define AUDIO_ENGINE_OUTPUT_DELAY_FRAMES 1U
+#endif
+
+/* Set to 1 to render ahead into a deep output FIFO so the core can sleep between bursts.
+ * The ring storage defaults to 4096 frames (16 KB, more with 32-bit output or zones) in
+ * HALFCHUNK_SZ periods, each DMA half and full interrupt renders half of it in one burst, and
+ * WaitForSampleEnd() sleeps with WFI between bursts instead of spinning. */
+#ifndef AUDIO_ENGINE_RENDER_AHEAD
+#define AUDIO_ENGINE_RENDER_AHEAD 0
+#endif
+
+/* Set to 1 to render in PendSV at the lowest interrupt priority instead of in the DMA
+ * interrupt.  The I2S callbacks then only hand the played periods over and pend PendSV;
+ * PendSV_Handler() must call AudioEngine_RenderTask().  AudioEngine_Init() sets the PendSV
+ * priority, so PendSV must not be used elsewhere (for example by an RTOS). */
+#ifndef AUDIO_ENGINE_DEFERRED_RENDER
+#define AUDIO_ENGINE_DEFERRED_RENDER 0
+#endif
+
+/* Set to 1 to take the I2S DMA interrupt without the HAL.  The DMA channel's IRQ handler calls
+ * AudioEngine_DmaIrqHandler() in place of HAL_DMA_IRQHandler(), which reads and clears the half
+ * and full transfer flags itself and goes straight to the ring hand-over, skipping the HAL DMA
+ * and I2S callback layers.  With AUDIO_ENGINE_DEFERRED_RENDER the render then tail-chains into
+ * PendSV as soon as the short DMA interrupt returns.  Transfer errors still go to the HAL. */
+#ifndef AUDIO_ENGINE_ENABLE_LL_DMA_IRQ
+#define AUDIO_ENGINE_ENABLE_LL_DMA_IRQ 0
+#endif
+
+/* Set to 1 to run under FreeRTOS through the port in audio_rtos.c, with AUDIO_ENGINE_DEFERRED_RENDER.
+ * The DMA interrupt then wakes a high-priority render task with a direct-to-task notification
+ * instead of pending PendSV, which the kernel owns, and the engine's blocking waits block the
+ * calling task until the render task has run rather than spinning or sleeping the core. */
+#ifndef AUDIO_ENGINE_ENABLE_RTOS
+#define AUDIO_ENGINE_ENABLE_RTOS 0
+#endif
+
+/* Size of the 8-bit TPDF dither table, as a power of two number of block start positions
+ * (8-12).  The table holds that many entries plus one full stereo block of 1024 entries;
+ * 10 gives 2048 entries (4 KB of RAM).  Each block walks it from a new start position. */
+#ifndef AUDIO_ENGINE_DITHER_TABLE_BITS
+#define AUDIO_ENGINE_DITHER_TABLE_BITS 10
+#endif
+
+/* Set to 1 to keep renewing the dither table from the STM32G4 hardware RNG.  AudioEngine_Init()
+ * enables HSI48 and the RNG, so the RNG must not be used elsewhere in the application.  Each
+ * block takes only the random words that are already waiting, so the callback never stalls. */
+#ifndef AUDIO_ENGINE_ENABLE_RNG_DITHER
+#define AUDIO_ENGINE_ENABLE_RNG_DITHER 0
+#endif
+
+/* Number of segments in the volume response table, as a power of two (6-10).
+ * 8 gives 256 segments (514 bytes of RAM); the curve is linearly interpolated between entries. */
+#ifndef AUDIO_ENGINE_VOLUME_CURVE_BITS
+#define AUDIO_ENGINE_VOLUME_CURVE_BITS 8
 #endif
 
 /* Set to 1 (default) to use interrupt-independent HAL_Delay override in audio_engine.c.
- * Set to 0 to use HAL's default tick-based HAL_Delay implementation. */
+ * Set to 0 to use HAL's default tick-based HAL_Delay implementation.  Under an RTOS it
+ * defaults to 0, as the RTOS port's HAL_Delay() blocks the calling task on the kernel tick. */
 #ifndef AUDIO_ENGINE_CUSTOM_HAL_DELAY
+#if AUDIO_ENGINE_ENABLE_RTOS
+#define AUDIO_ENGINE_CUSTOM_HAL_DELAY 0
+#else
 #define AUDIO_ENGINE_CUSTOM_HAL_DELAY 1
 #endif
+#endif
+
+/* DAC control values */
+#define DAC_OFF               false
+#define DAC_ON                true
+
+/* Playback engine buffer configuration */
+// The DMA buffer is a ring of periods.  AudioEngine_SetBufferGeometry() picks the period size
+// and count at runtime within this storage; the default fills it with HALFCHUNK_SZ periods.
+// Shorter periods react sooner to volume and control changes, more periods buffer deeper.
+#ifndef AUDIO_ENGINE_RING_FRAMES
+  #if AUDIO_ENGINE_RENDER_AHEAD
+    #define AUDIO_ENGINE_RING_FRAMES  4096U                     // Ring storage in stereo frames
+  #else
+    #define AUDIO_ENGINE_RING_FRAMES  1024U                     // Ring storage in stereo frames
+  #endif
+#endif
+#define PB_BUFF_SZ                  ( AUDIO_ENGINE_RING_FRAMES * 2U )
+#define HALFCHUNK_SZ                512U                        // Frames in the largest period
+#define CHUNK_SZ                    ( HALFCHUNK_SZ * 2U )       // Samples in the largest period
+#define PERIOD_FRAMES_MIN           32U                         // Frames in the smallest period
+#define FIRST                       0U
+#define SECOND                      1U
+
+/* Fade configuration */
+#define PAUSE_FADEOUT_SAMPLES       5512U    // About 0.5 second at 11kHz
+#define FADEIN_SAMPLES              2048U    // About 93ms at 22kHz
+
+/* DC blocking filter configuration */
+#define DC_FILTER_ALPHA             64225    // 0.98 in fixed-point (64225/65536)
+#define DC_FILTER_SHIFT             16       // Right shift for fixed-point division
+#define SOFT_DC_FILTER_ALPHA        65216    // 0.995 in fixed-point (65216/65536)
+
+/* 16-bit biquad low-pass filter aggressiveness levels (alpha coefficients) */
+/* Lower alpha is heavier filtering for this biquad, so values are ordered heavy -> light. */
+#define LPF_16BIT_VERY_SOFT         40960    // 0.625 - minimal filtering / highest cutoff
+#define LPF_16BIT_SOFT              52429    // ~0.80 - gentle filtering
+#define LPF_16BIT_MEDIUM            57344    // 0.875 - balanced filtering
+#define LPF_16BIT_FIRM              60416    // ~0.92 - firm filtering
+#define LPF_16BIT_AGGRESSIVE        63488    // ~0.97 - strongest filtering / lowest cutoff
+
+/* Low-pass filter for 8-bit samples */
+#define LPF_MAKEUP_GAIN_Q16         70779   // ~1.08x post-LPF makeup (default)
+/* Low-pass filter for 16-bit samples */
+#define LPF_16BIT_MAKEUP_GAIN_Q16   65536   // 1.00x post-LPF makeup (default)
+
+/* 8-bit low-pass filter aggressiveness levels (alpha coefficients in fixed-point) */
+#define LPF_VERY_SOFT           61440       // 0.9375 - very gentle filtering
+#define LPF_SOFT                57344       // 0.875 - gentle filtering
+#define LPF_MEDIUM              49152       // 0.75 - balanced filtering
+#define LPF_FIRM                45056       // 0.6875 - firm filtering
+#define LPF_AGGRESSIVE          40960       // 0.625 - strong filtering
+
+/* Noise gate configuration.  The gate opens when a block peaks above NOISE_GATE_THRESHOLD and
+ * closes once blocks have stayed below NOISE_GATE_CLOSE_THRESHOLD for the hold time. */
+#define NOISE_GATE_THRESHOLD        512     // ~1.5% of full scale
+#define NOISE_GATE_CLOSE_THRESHOLD  256     // Hysteresis: half the opening level
+#ifndef NOISE_GATE_ATTACK_MS
+#define NOISE_GATE_ATTACK_MS        1U      // Closed to open
+#endif
+#ifndef NOISE_GATE_HOLD_MS
+#define NOISE_GATE_HOLD_MS          50U     // Held open after the level drops
+#endif
+#ifndef NOISE_GATE_RELEASE_MS
+#define NOISE_GATE_RELEASE_MS       100U    // Open to closed
+#endif
+
+/* Audio silence midpoints */
+#define SAMPLE8_MIDPOINT        128U        // Midpoint for unsigned 8-bit unsigned samples
+#define SAMPLE16_MIDPOINT       0           // Midpoint for signed 16-bit samples
+
+/* Fill half buffer macro */
+#if AUDIO_ENGINE_OUTPUT_32BIT || ( AUDIO_ENGINE_OUTPUT_ZONES > 1 )
+#define MIDPOINT_FILL_BUFFER() FillOutputSilence();
+#else
+#define MIDPOINT_FILL_BUFFER() memset( pb_buffer, SAMPLE16_MIDPOINT, sizeof( pb_buffer ) );
+#endif
+
+/* Playback status type */
+typedef enum {
+  PB_Idle,
+  PB_Error,
+  PB_Playing,
+  PB_Pausing,
+  PB_Paused,
+  PB_PlayingFailed,
+  PB_Primed                                   // Rendered and waiting for AudioEngine_StartPrimed()
+} PB_StatusTypeDef;
+
+/* Playback mode type */
+typedef enum {
+  Mode_stereo,
+  Mode_mono
+} PB_ModeTypeDef;
+
+/* Audio channel identifier */
+typedef enum {
+  CHANNEL_LEFT = 0U,
+  CHANNEL_RIGHT = 1U,
+  CHANNEL_COUNT = 2U
+} AudioChannelId;
+
+/* Speakers the I2S frame drives (AudioEngine_SetOutputTopology()) */
+typedef enum {
+  OUTPUT_TOPOLOGY_STEREO,                   // Left and right are separate speakers (default)
+  OUTPUT_TOPOLOGY_MONO_SPEAKER              // One speaker: stereo sources are downmixed and filtered once
+} OutputTopology_TypeDef;
+
+/* Low-pass filter aggressiveness type */
+typedef enum {
+  LPF_Off,
+  LPF_VerySoft,
+  LPF_Soft,
+  LPF_Medium,
+  LPF_Firm,
+  LPF_Aggressive,
+  LPF_Custom
+} LPF_Level;
+
+/* Soft clipper transfer curve (SetSoftClipCurve()).  Samples within +/-28,000 pass unchanged. */
+typedef enum {
+  SoftClip_Cubic,                           // Smoothstep knee, limiting at about +/-32,400 (default)
+  SoftClip_Tanh,                            // Hyperbolic tangent knee, approaching the rails
+  SoftClip_Asymmetric                       // Tanh knees at +28,000 and -21,000, for even harmonics
+} SoftClip_Curve;
+
+/* Air Effect (High-Shelf Brightening) Filter.  The shelf gain is the level of the shelf well
+ * above the corner, the same at every output rate. */
+#define AIR_EFFECT_SHELF_GAIN       98304     // ~1.5 in Q16 (high-frequency shelf ~ +3.5 dB)
+#define AIR_EFFECT_SHELF_GAIN_MAX   131072    // Cap runtime boost at ~2.0x to avoid harsh clipping
+#ifndef AIR_EFFECT_FREQ_HZ
+#define AIR_EFFECT_FREQ_HZ          4900U     // Shelf corner, retuned for each output rate
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PLAYLIST
+/* One item of a gapless playlist (PlayPlaylist()) */
+typedef struct {
+  const void   *sample;                     // Sample data, depth and mode shared by the playlist
+  uint32_t      sample_sz;                  // Total samples, all channels combined
+} AudioEngine_PlaylistItem;
+#endif
+
+/* Sound asset encodings (AudioAsset.encoding) */
+typedef enum {
+  ASSET_PCM16,                              // Signed 16-bit, little-endian
+  ASSET_PCM8,                               // Unsigned 8-bit
+  ASSET_ADPCM,                              // 4-bit IMA-ADPCM (AUDIO_ENGINE_ENABLE_ADPCM)
+  ASSET_LOSSLESS,                           // Predicted, Rice-coded 16-bit (AUDIO_ENGINE_ENABLE_LOSSLESS)
+  ASSET_MULAW,                              // G.711 mu-law 8-bit (AUDIO_ENGINE_ENABLE_COMPANDED)
+  ASSET_ALAW,                               // G.711 A-law 8-bit (AUDIO_ENGINE_ENABLE_COMPANDED)
+  ASSET_SBC,                                // Sub-band coded 16-bit (AUDIO_ENGINE_ENABLE_SBC)
+  ASSET_MIDSIDE,                            // 16-bit mid, reduced side (AUDIO_ENGINE_ENABLE_MIDSIDE)
+  ASSET_PCM12,                              // 12-bit PCM, two samples in three bytes (AUDIO_ENGINE_ENABLE_PCM12)
+  ASSET_SILENCE_RLE                         // 16-bit PCM with silent runs left out (AUDIO_ENGINE_ENABLE_SILENCE_RLE)
+} AudioAsset_Encoding;
+
+struct AudioEngine_Preset;
+
+/* AudioAsset.flags */
+#define AUDIO_ASSET_BAKED           0x01U   // The static filters are in the data (make_asset.py --bake)
+#define AUDIO_ASSET_SHAPED          0x02U   // 8-bit data with shaped quantisation noise (make_asset.py --shape)
+
+/* A sound asset with its metadata, generated from a WAV file by Tools/make_asset.py */
+typedef struct {
+  const void     *data;                     // Sample data, word aligned
+  uint32_t        sample_sz;                // Total samples, all channels combined (decoded, for ADPCM and lossless)
+  uint32_t        sample_rate;              // Hz
+  uint32_t        loop_start_frame;         // Loop region, or both 0 when there is none
+  uint32_t        loop_end_frame;           // Frame after the loop region
+  const uint16_t *block_peaks;              // Silence map (AudioEngine_SetSilenceMap()), or NULL
+  uint32_t        block_peak_count;
+  uint16_t        block_peak_frames;        // Frames per silence map entry
+  uint16_t        adpcm_block_bytes;        // Bytes per channel per ADPCM block, 0 for PCM
+  uint16_t        lossless_block_frames;    // Frames per lossless block, 0 for other encodings
+  uint16_t        peak;                     // Peak magnitude of the whole asset, in 16-bit units
+  int16_t         warmup_sample;            // First sample (left channel), seeds the 16-bit LPF at the start
+  uint8_t         encoding;                 // AudioAsset_Encoding
+  uint8_t         channels;                 // 1 or 2
+  int16_t         loudness_db10;            // Measured loudness, LUFS in tenths of a dB, 0 if not measured
+  int16_t         loudness_target_db10;     // Loudness to play at, tenths of a dB, 0 for AudioEngine_SetLoudnessTarget()
+  const struct AudioEngine_Preset *preset;  // Applied as the asset starts (ApplyPreset()), or NULL
+  uint8_t         flags;                    // AUDIO_ASSET_* flags
+  uint32_t        data_bytes;               // Size of the data, 0 if it carries no CRC
+  uint32_t        data_crc;                 // CRC-32 (as zlib's crc32()) of the data
+} AudioAsset;
+
+#if AUDIO_ENGINE_ENABLE_SOURCE_STREAM
+/* Stream image (Tools/make_stream_image.py): an 8-byte header holding AUDIO_ENGINE_STREAM_MAGIC
+ * and the entry count, then the entries sorted by id, then the sample data */
+#define AUDIO_ENGINE_STREAM_MAGIC   0x53325243U     // "CR2S", little-endian
+#define AUDIO_ENGINE_NO_STREAM_IMAGE 0xFFFFFFFFU    // AudioEngine_SourceStreamInit() without an image
+
+/* One stream image index entry */
+typedef struct {
+  uint32_t        id;                       // Asset ID, ascending through the index
+  uint32_t        offset;                   // Sample data offset from the image start
+  uint32_t        sample_sz;                // Total samples, all channels combined
+  uint32_t        sample_rate;              // Hz
+  uint8_t         encoding;                 // ASSET_PCM16 or ASSET_PCM8
+  uint8_t         channels;                 // 1 or 2
+  uint16_t        reserved;
+} AudioEngine_StreamEntry;
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+/* Asset bank (Tools/make_asset_bank.py): this header, then the index entries sorted by id,
+ * then the sample data and silence maps, word aligned */
+#define AUDIO_ENGINE_BANK_MAGIC     0x42325243U     // "CR2B", little-endian
+#define AUDIO_ENGINE_BANK_VERSION   2U
+
+typedef struct {
+  uint32_t        magic;                    // AUDIO_ENGINE_BANK_MAGIC
+  uint32_t        crc32;                    // CRC-32 (IEEE 802.3) of the bank from version to bank_bytes
+  uint32_t        version;                  // AUDIO_ENGINE_BANK_VERSION
+  uint32_t        bank_bytes;               // Whole bank, header included
+  uint32_t        count;                    // Index entries
+  uint32_t        reserved;
+} AudioEngine_BankHeader;
+
+/* One asset bank index entry: an AudioAsset with offsets from the bank start for pointers */
+typedef struct {
+  uint32_t        id;                       // Asset ID, ascending through the index
+  uint32_t        data_offset;              // Sample data, word aligned
+  uint32_t        data_bytes;
+  uint32_t        sample_sz;
+  uint32_t        sample_rate;
+  uint32_t        loop_start_frame;
+  uint32_t        loop_end_frame;
+  uint32_t        peaks_offset;             // Silence map, 0 for none
+  uint32_t        block_peak_count;
+  uint16_t        block_peak_frames;
+  uint16_t        adpcm_block_bytes;
+  uint16_t        lossless_block_frames;
+  uint16_t        peak;
+  int16_t         warmup_sample;
+  uint8_t         encoding;                 // AudioAsset_Encoding
+  uint8_t         channels;
+  int16_t         loudness_db10;
+  int16_t         loudness_target_db10;
+} AudioEngine_BankEntry;
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+/* One entry of the linker-placed asset index */
+typedef struct {
+  uint32_t            id;                   // Ascending through the index
+  const AudioAsset   *asset;
+} AudioEngine_IndexEntry;
+
+/* Register an asset under an ID.  The ID must be a plain decimal literal (no suffix): the
+ * linker sorts the entries by the number at the end of their section name. */
+#define AUDIO_ENGINE_INDEX_ASSET( id, asset )                                                   \
+  static const AudioEngine_IndexEntry audio_index_##id                                          \
+    __attribute__( ( used, section( ".audio_index." #id ) ) ) = { id##U, &( asset ) }
+
+/* Register a sound header's sample under an ID, with the arguments PlaySample() would take.
+ * The LPF warm-up starts from zero rather than the first sample. */
+#define AUDIO_ENGINE_INDEX_SAMPLE( id, sample, size, rate, depth, mode )                        \
+  static const AudioAsset audio_index_asset_##id =                                              \
+  {                                                                                             \
+    .data         = ( sample ),                                                                 \
+    .sample_sz    = ( size ),                                                                   \
+    .sample_rate  = ( rate ),                                                                   \
+    .encoding     = ( ( depth ) == 16U ) ? ASSET_PCM16 : ASSET_PCM8,                            \
+    .channels     = ( ( mode ) == Mode_stereo ) ? 2U : 1U                                       \
+  };                                                                                            \
+  AUDIO_ENGINE_INDEX_ASSET( id, audio_index_asset_##id )
+#endif
+
+/* Filter chain runtime configuration */
+typedef struct {
+  uint8_t enable_16bit_biquad_lpf;            // Biquad low-pass filter for 16-bit samples
+  uint8_t enable_soft_dc_filter_16bit;        // Soft DC blocking filter for 16-bit samples
+  uint8_t enable_8bit_lpf;                    // Biquad low-pass filter for 8-bit samples
+  uint8_t enable_noise_gate;                  // Noise gate. Attenuates low-level noise between sounds.
+  uint8_t enable_soft_clipping;               // Soft clipping.
+  uint8_t enable_air_effect;                  // High-shelf brightening filter
+  uint32_t lpf_makeup_gain_q16;               // Q16 gain applied after LPF
+  uint32_t lpf_makeup_gain_16bit_q16;         // Q16 gain applied after 16-bit LPF
+  LPF_Level lpf_16bit_level;                  // Filter level for 16-bit biquad LPF
+  uint16_t lpf_16bit_custom_alpha;            // Q16 alpha for custom 16-bit LPF
+  LPF_Level lpf_8bit_level;                   // Filter level for 8-bit LPF
+  uint16_t lpf_8bit_custom_alpha;             // Q16 alpha for custom 8-bit LPF
+  uint8_t enable_filter_chain_16bit;          // Master enable for entire 16-bit filter chain
+  uint8_t enable_filter_chain_8bit;           // Master enable for entire 8-bit filter chain
+} FilterConfig_TypeDef;
+
+/* A complete engine configuration for ApplyPreset(), with every value precomputed so applying
+ * it does no float math.  Keep presets const in flash; Tools/make_preset.py writes one from
+ * cutoff frequencies, decibels and seconds. */
+typedef struct AudioEngine_Preset {
+  FilterConfig_TypeDef filter;                // As for SetFilterConfig(); the LPF alphas follow the levels
+  uint32_t  air_gain_q16;                     // Air effect shelf gain, up to AIR_EFFECT_SHELF_GAIN_MAX
+  uint16_t  fade_in_ms;                       // Fade times, 1-5000 ms
+  uint16_t  fade_out_ms;
+  uint16_t  pause_fade_ms;
+  uint16_t  resume_fade_ms;
+  uint8_t   faders_enabled;
+} AudioEngine_Preset;
+
+#if AUDIO_ENGINE_EQ_BANDS > 0
+/* Response of one EQ band */
+typedef enum {
+  EQ_Off,
+  EQ_Peaking,                                 // Bell around freq_hz
+  EQ_LowShelf,                                // Below freq_hz
+  EQ_HighShelf,                               // Above freq_hz
+  EQ_HighPass,                                // 12 dB/octave below freq_hz
+  EQ_LowPass                                  // 12 dB/octave above freq_hz
+} AudioEngine_EqType;
+
+/* One EQ band, designed for the output rate whenever it changes */
+typedef struct {
+  AudioEngine_EqType type;
+  float freq_hz;                              // Centre or corner frequency, 20 Hz to 0.45 of the output rate
+  float q;                                    // Bandwidth of a peak, slope of a shelf or resonance of a pass, 0.1-10
+  float gain_db;                              // Peaking and shelf gain, -18 to +18 dB
+} AudioEngine_EqBand;
+
+#define AUDIO_ENGINE_EQ_Q_BUTTERWORTH   0.7071f     // Maximally flat pass or shelf
+#endif
+
+#if AUDIO_ENGINE_ENABLE_COMPRESSOR
+/* Compressor settings (AudioEngine_SetCompressor()) */
+typedef struct {
+  float threshold_db;                         // Peak level above which the gain comes down, -40 to 0 dBFS
+  float ratio;                                // Input dB per output dB above the threshold, 1 (no compression) to 20
+  float attack_ms;                            // Time the gain takes to come down, 1 to 500 ms
+  float release_ms;                           // Time the gain takes to recover, 10 to 5000 ms
+  float makeup_db;                            // Gain after compression, 0 to +18 dB
+} AudioEngine_Compressor;
+
+/* Most boost loudness normalisation applies to a quiet asset */
+#ifndef AUDIO_ENGINE_LOUDNESS_MAX_BOOST_DB
+#define AUDIO_ENGINE_LOUDNESS_MAX_BOOST_DB  12.0f
+#endif
+#endif
+
+/* Stages of the render graph (AudioEngine_SetRenderGraph()), after the source's LPF.  A stage
+ * compiled out, switched off in the filter configuration or with nothing to do is left out. */
+typedef enum {
+  AUDIO_NODE_COMPRESSOR,                      // Compressor and loudness gain (AUDIO_ENGINE_ENABLE_COMPRESSOR)
+  AUDIO_NODE_EQ,                              // Parametric EQ (AUDIO_ENGINE_EQ_BANDS)
+  AUDIO_NODE_FIR,                             // Speaker correction FIR (AUDIO_ENGINE_FIR_MAX_TAPS)
+  AUDIO_NODE_APP,                             // The application's stage (AudioEngine_SetAppStage())
+  AUDIO_NODE_DC_AIR,                          // DC blocker, with the air effect when it is on
+  AUDIO_NODE_NOISE_GATE,
+  AUDIO_NODE_SOFT_CLIP,
+  AUDIO_NODE_COUNT
+} AudioEngine_Node;
+
+/* The application's stage: one channel of a block, in place, in the render context.  Stereo
+ * blocks call it once per channel with stride 2; mono sources once with stride 1. */
+typedef void        ( *AudioEngine_StageFunc )  ( int16_t *samples, uint32_t count, uint32_t stride,
+                                                  uint8_t channel, void *context );
+
+#if AUDIO_ENGINE_ENABLE_PROFILING
+/* Profiled stages of a buffer refill */
+typedef enum {
+  PROFILE_STAGE_VOLUME,                       // Volume read and response curve
+  PROFILE_STAGE_FETCH,                        // Source fetch, 8-bit unpack and volume scaling
+  PROFILE_STAGE_FILTER,                       // Filter chain
+  PROFILE_STAGE_FADE,                         // Mono expansion, fades and output stage
+  PROFILE_STAGE_CALLBACK,                     // Whole render, entry to exit (DMA callback or render task)
+  PROFILE_STAGE_RESPONSE,                     // DMA interrupt to end of render, including any deferral
+  PROFILE_STAGE_COUNT
+} AudioEngine_ProfileStage;
+
+/* Cycle statistics for one stage */
+typedef struct {
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint32_t avg_cycles;
+  uint32_t samples;                           // Number of measurements
+} AudioEngine_StageProfile;
+
+/* Profile snapshot returned by AudioEngine_GetProfile() */
+typedef struct {
+  AudioEngine_StageProfile stage[ PROFILE_STAGE_COUNT ];
+  uint32_t period_cycles;                     // Core cycles per DMA ring period at the current rate
+  uint32_t deadline_cycles;                   // Core cycles between DMA interrupts (half the ring)
+  uint8_t  load_avg_pct;                      // Average render time as a percentage of the deadline
+  uint8_t  headroom_pct;                      // 100 minus the worst-case response, 0 if overrun
+} AudioEngine_Profile;
+
+/* Stages timed by AudioEngine_Benchmark() over a fixed test vector, one DMA period each */
+typedef enum {
+  BENCH_LPF_16BIT,                            // 16-bit biquad LPF, both channels
+  BENCH_LPF_8BIT,                             // 8-bit LPF, both channels
+  BENCH_DC_FILTER,                            // DC blocking filter, both channels
+  BENCH_AIR_EFFECT,                           // DC blocker and air effect shelf section, both channels (AUDIO_ENGINE_ENABLE_AIR_EFFECT)
+  BENCH_NOISE_GATE,                           // Noise gate, both channels
+  BENCH_SOFT_CLIP,                            // Soft clipper
+  BENCH_FADE,                                 // Fade ramp across the period
+  BENCH_DITHER_8BIT,                          // 8-bit to 16-bit conversion with TPDF dither
+  BENCH_CHAIN_16BIT,                          // Filter chain for 16-bit samples, as configured
+  BENCH_CHAIN_8BIT,                           // Filter chain for 8-bit samples, as configured
+  BENCH_CHUNK_16BIT_STEREO,                   // ProcessNextWaveChunk(): fetch, volume, chain and fades
+  BENCH_CHUNK_16BIT_MONO,
+  BENCH_CHUNK_8BIT_STEREO,                    // ProcessNextWaveChunk_8_bit()
+  BENCH_CHUNK_8BIT_MONO,
+  BENCH_SPEAKER_FIR,                          // Speaker correction FIR with the taps loaded, both channels (AUDIO_ENGINE_FIR_MAX_TAPS > 0)
+  BENCH_STAGE_COUNT
+} AudioEngine_BenchStage;
+
+/* Result of AudioEngine_Benchmark() */
+typedef struct {
+  uint32_t cycles;                            // Average core cycles per period, on the full-scale test vector
+  uint32_t min_cycles;                        // Fewest cycles of any run, over all the test data
+  uint32_t max_cycles;                        // Most cycles of any run: the measured worst case
+  uint32_t samples;                           // Source samples per period
+  uint32_t cycles_per_sample_x100;            // Cycles per source sample, times 100
+} AudioEngine_BenchResult;
+
+#if AUDIO_ENGINE_ENABLE_PERIOD_CALIBRATION
+/* Result of AudioEngine_CalibratePeriod() */
+typedef struct {
+  uint32_t rate;                              // Output rate calibrated for, Hz; 0 before the first calibration
+  uint16_t period_frames;                     // Period chosen and set
+  uint8_t  period_count;                      // Periods in the ring, as they were
+  uint8_t  fits;                              // 0 if no period met the budget; the largest that fits the ring is set
+  uint32_t render_cycles;                     // Render of half the ring at that period, with the overhead
+  uint32_t deadline_cycles;                   // Half the ring at the rate
+} AudioEngine_PeriodCalibration;
+#endif
+#endif
+
+/* Global audio engine state exposed for hardware initialization */
+extern uint32_t I2S_PlaybackSpeed;
+
+/* Hardware interface function pointer types */
+typedef void        ( *DAC_SwitchFunc )         ( GPIO_PinState setting );
+typedef uint16_t    ( *ReadVolumeFunc )         ( void );
+typedef void        ( *I2S_InitFunc )           ( void );
+typedef void        ( *PlaybackEndCallback )    ( void );
+#if AUDIO_ENGINE_ENABLE_SOURCE_STREAM
+typedef uint8_t     ( *SourceReadFunc )         ( uint32_t addr, void *dst, uint32_t len );
+#endif
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+typedef uint8_t     ( *DAC_ReadyFunc )          ( void );
+#endif
+
+extern DAC_SwitchFunc AudioEngine_DACSwitch;
+extern ReadVolumeFunc AudioEngine_ReadVolume;
+extern I2S_InitFunc   AudioEngine_I2SInit;
+
+/**
+ * @brief Weak callback invoked when playback ends naturally or via stop
+ * @note Define this function in your application to receive playback end notifications
+ * @note Called from ISR context - keep implementation short and non-blocking
+ */
+void AudioEngine_OnPlaybackEnd( void );
+
+/**
+ * @brief Initialize the audio engine with hardware interface callbacks
+ * @param[in] dac_switch   Function to control DAC amplifier power (GPIO)
+ * @param[in] read_volume  Function to read current volume setting (0-255)
+ * @param[in] i2s_init     Function to initialize I2S peripheral
+ * @return PB_Idle on success, PB_Error on failure
+ */
+PB_StatusTypeDef    AudioEngine_Init                  (
+                                                        DAC_SwitchFunc dac_switch,
+                                                        ReadVolumeFunc read_volume,
+                                                        I2S_InitFunc i2s_init
+                                                      );
+
+/* Filter configuration functions */
+/**
+ * @brief Apply a complete filter configuration to the audio engine
+ * @param[in] cfg Pointer to FilterConfig_TypeDef with desired settings
+ * @note All filter settings in cfg are applied atomically, from the next period: the render
+ *       context swaps to the new set between periods and never sees a partial update.
+ * @note With AUDIO_ENGINE_ENABLE_LOAD_ADMISSION the configuration is checked against the
+ *       format of the current or last playback; see AudioEngine_SetLoadPolicy().
+ * @return PB_Idle when applied, PB_Error for a NULL cfg or one refused under LOAD_POLICY_REFUSE
+ */
+PB_StatusTypeDef    SetFilterConfig                   ( const FilterConfig_TypeDef *cfg );
+
+/**
+ * @brief Read current filter configuration from the audio engine
+ * @param[out] cfg Pointer to FilterConfig_TypeDef to receive current settings
+ */
+void                GetFilterConfig                   ( FilterConfig_TypeDef *cfg );
+
+/**
+ * @brief Switch the whole engine configuration to a preset
+ * @param[in] preset Precomputed configuration, normally const in flash
+ * @note The filter configuration is published in one swap, as by SetFilterConfig(), and the air
+ *       gain and 16-bit LPF alpha glide as their setters do.  Fade times are converted to
+ *       sample counts at the current rate with integer math.  PlayAsset() applies an asset's
+ *       own preset as it starts.
+ */
+void                ApplyPreset                       ( const AudioEngine_Preset *preset );
+
+/**
+ * @brief Capture the running engine configuration as a preset
+ * @param[out] preset Receives the configuration; ApplyPreset() with it changes nothing
+ * @note Fade times are rounded to the millisecond. Lets a few settings be changed together:
+ *       capture, edit the copy, and apply it in one swap.
+ */
+void                AudioEngine_CapturePreset         ( AudioEngine_Preset *preset );
+
+/**
+ * @brief Start a configuration transaction: the setters stage their changes until the commit
+ * @note Covers the filter configuration setters, the fade time setters, SetLpf16BitLevel(),
+ *       SetLpf16BitCustomAlpha(), the air effect setters, SetFadersEnabled() and
+ *       AudioEngine_SetOutputTopology(). Staged values read back from their getters may still
+ *       be the applied ones. Transactions nest; commit before starting a playback.
+ */
+void                BeginEngineConfig                 ( void );
+
+/**
+ * @brief End a configuration transaction and apply what was staged in it at once
+ * @note Fade times are converted to sample counts once, the LPF alpha and air gain glide from
+ *       their last staged values, and the filter configuration is published in one swap, so
+ *       the render context takes every change at the same block. Application context only.
+ */
+void                CommitEngineConfig                ( void );
+
+#if AUDIO_ENGINE_ENABLE_PRESET_STORE
+/**
+ * @brief Mount the preset store and apply the preset saved in it
+ * @param[in] region Start of the partition (__preset_store_start from the linker script), 4K aligned
+ * @param[in] region_bytes Size of the partition, a multiple of 8K
+ * @return PB_Idle when a saved preset was applied; PB_Error for a bad region or with nothing
+ *         saved yet, when the caller applies its own default
+ * @note Call once after AudioEngine_Init(), in place of applying the startup preset. Reads
+ *       the records and applies the newest good one, as ApplyPreset() would; no float math.
+ */
+PB_StatusTypeDef    AudioEngine_MountPresetStore      ( const void *region, uint32_t region_bytes );
+
+/**
+ * @brief Save the running engine configuration to the preset store
+ * @return PB_Idle when saved, or when the newest saved preset is the same; PB_Playing while
+ *         playing, with the output running or during a bank update (stop, then try again);
+ *         PB_Error without AudioEngine_MountPresetStore() or if the flash failed
+ * @note Application context only. Appends a record, and erases half the store each time the
+ *       other half fills, stalling the CPU AUDIO_ENGINE_FLASH_ERASE_US for each page.
+ */
+PB_StatusTypeDef    AudioEngine_SavePreset            ( void );
+
+/**
+ * @brief Erase the preset store, so the next start-up applies the firmware's default
+ * @return As AudioEngine_SavePreset()
+ */
+PB_StatusTypeDef    AudioEngine_ErasePresetStore      ( void );
+#endif
+
+/**
+ * @brief Set makeup gain applied after 8-bit low-pass filter
+ * @param[in] gain Linear gain (1.0 = no gain, 2.0 = 2x, etc.)
+ * @note Compensates for attenuation from aggressive filtering. During playback the gain glides
+ *       to its new value over AUDIO_ENGINE_PARAM_SMOOTH_PERIODS periods.
+ */
+void                SetLpfMakeupGain8Bit              ( float gain );
+
+/**
+ * @brief Set makeup gain applied after 16-bit low-pass filter
+ * @param[in] gain Linear gain (1.0 = no gain, 2.0 = 2x, etc.)
+ * @note Compensates for attenuation from aggressive filtering. During playback the gain glides
+ *       to its new value over AUDIO_ENGINE_PARAM_SMOOTH_PERIODS periods.
+ */
+void                SetLpfMakeupGain16Bit             ( float gain );
+
+/**
+ * @brief Get makeup gain applied after 16-bit low-pass filter
+ * @return Linear gain (1.0 = no gain, 2.0 = 2x, etc.)
+ */
+float               GetLpfMakeupGain16Bit             ( void );
+
+/**
+ * @brief Enable/disable the high-shelf air effect brightening filter
+ * @param[in] enabled 1 to enable, 0 to disable
+ * @note Air effect is automatically controlled by SetAirEffectPresetDb()
+ */
+void                SetAirEffectEnable                ( uint8_t enabled );
+
+/**
+ * @brief Read current air effect enable state
+ * @return 1 if enabled, 0 if disabled
+ */
+uint8_t             GetAirEffectEnable                ( void );
+
+/**
+ * @brief Enable/disable soft clipping above ±28,000, on the curve set by SetSoftClipCurve()
+ * @param[in] enabled 1 to enable, 0 to disable
+ * @note While playing, this and the filter chain and air effect switches take effect at the
+ *       next DMA period, so one block never mixes two filter configurations.
+ */
+void                SetSoftClippingEnable             ( uint8_t enabled );
+
+/**
+ * @brief Read current soft clipping enable state
+ * @return 1 if enabled, 0 if disabled
+ */
+uint8_t             GetSoftClippingEnable             ( void );
+
+/**
+ * @brief Select the soft clipper transfer curve
+ * @param[in] curve SoftClip_Cubic (default), SoftClip_Tanh or SoftClip_Asymmetric
+ * @note Rebuilds the clipper's lookup table in the calling context and publishes it whole,
+ *       so a block never mixes two curves. Application context only.
+ */
+void                SetSoftClipCurve                  ( SoftClip_Curve curve );
+
+/**
+ * @brief Read the soft clipper transfer curve
+ * @return The curve set by SetSoftClipCurve()
+ */
+SoftClip_Curve      GetSoftClipCurve                  ( void );
+
+/* 8-bit sample low-pass filter configuration */
+/**
+ * @brief Set the aggressiveness level of the 8-bit low-pass filter
+ * @param[in] level One of: LPF_Off, LPF_VerySoft, LPF_Soft, LPF_Medium, LPF_Firm, LPF_Aggressive, LPF_Custom
+ * @note Custom alpha can be set separately via SetLpf8BitCustomAlpha()
+ */
+void                SetLpf8BitLevel                   ( LPF_Level level );
+
+/**
+ * @brief Get the current aggressiveness level of the 8-bit low-pass filter
+ * @return Current LPF_Level (Off, VerySoft, Soft, Medium, Firm, Aggressive, or Custom)
+ */
+LPF_Level           GetLpf8BitLevel                   ( void );
+
+/**
+ * @brief Set a custom alpha coefficient for the 8-bit low-pass filter
+ * @param[in] alpha Q16 fixed-point alpha value (0-65535), where 65535 = 0.99999, 32768 = 0.5
+ * @note This sets level to LPF_Custom and uses the provided alpha directly
+ */
+void                SetLpf8BitCustomAlpha             ( uint16_t alpha );
+
+/**
+ * @brief Get the current custom alpha coefficient for the 8-bit low-pass filter
+ * @return Q16 fixed-point alpha value
+ */
+uint16_t            GetLpf8BitCustomAlpha             ( void );
+
+/* 16-bit sample low-pass filter configuration */
+/**
+ * @brief Set the aggressiveness level of the 16-bit biquad low-pass filter
+ * @param[in] level One of: LPF_Off, LPF_VerySoft, LPF_Soft, LPF_Medium, LPF_Firm, LPF_Aggressive, LPF_Custom
+ */
+void                SetLpf16BitLevel                  ( LPF_Level level );
+
+/**
+ * @brief Set a custom alpha coefficient for the 16-bit low-pass filter
+ * @param[in] alpha Q16 fixed-point alpha value (0-65535), where 65535 = 0.99999, 32768 = 0.5
+ * @note This sets level to LPF_Custom and uses the provided alpha directly. During playback the
+ *       filter glides to it over AUDIO_ENGINE_PARAM_SMOOTH_PERIODS periods, as it does for
+ *       SetLpf16BitLevel().
+ */
+void                SetLpf16BitCustomAlpha            ( uint16_t alpha );
+
+/**
+ * @brief Calculate Q16 alpha coefficient from desired cutoff frequency
+ * @param[in] cutoff_hz Cutoff frequency in Hz
+ * @param[in] sample_rate_hz Sample rate in Hz
+ * @return Q16 alpha value suitable for SetLpf16BitCustomAlpha()
+ * @note Formula: alpha = 2*pi*fc / sr, clamped to [0, 65535]
+ */
+uint16_t            CalcLpf16BitAlphaFromCutoff       ( float cutoff_hz, float sample_rate_hz );
+
+/**
+ * @brief Calculate Q16 alpha coefficient for 8-bit LPF from desired cutoff frequency
+ * @param[in] cutoff_hz Cutoff frequency in Hz
+ * @param[in] sample_rate_hz Sample rate in Hz
+ * @return Q16 alpha value suitable for SetLpf8BitCustomAlpha()
+ * @note Formula: alpha = 1 - exp(-2*pi*fc / fs), clamped to [0, 65535]
+ */
+uint16_t            CalcLpf8BitAlphaFromCutoff        ( float cutoff_hz, float sample_rate_hz );
+
+/**
+ * @brief Get the cutoff frequency corresponding to the current 16-bit LPF custom alpha
+ * @param[in] cutoff_hz Cutoff frequency in Hz
+ * @return Q16 alpha value, or 0 if not in custom mode
+ */
+uint16_t            GetLpf16BitCustomAlphaFromCutoff  ( float cutoff_hz );
+
+#if AUDIO_ENGINE_EQ_BANDS > 0
+/* Parametric EQ */
+/**
+ * @brief Set one band of the parametric EQ
+ * @param[in] band Band, 0 to AUDIO_ENGINE_EQ_BANDS - 1
+ * @param[in] params Response of the band, or NULL (or type EQ_Off) to switch it off; frequency,
+ *            Q and gain are clamped to their ranges
+ * @note Application context only: the coefficients are designed with float math.  While
+ *       playing, takes effect at the next DMA period.  The cascade runs ahead of the DC blocker
+ *       in both the 8 and 16-bit chains, or on the mix bus while voices play.
+ */
+void                AudioEngine_SetEqBand             ( uint8_t band, const AudioEngine_EqBand *params );
+
+/**
+ * @brief Get one band of the parametric EQ
+ * @param[in] band Band, 0 to AUDIO_ENGINE_EQ_BANDS - 1
+ * @param[out] params Receives the band as clamped, type EQ_Off for a band that is off
+ */
+void                AudioEngine_GetEqBand             ( uint8_t band, AudioEngine_EqBand *params );
+
+/**
+ * @brief Switch every EQ band off
+ */
+void                AudioEngine_ClearEq               ( void );
+
+#if AUDIO_ENGINE_ENABLE_LOUDNESS_COMP
+/**
+ * @brief Switch loudness compensation on or off
+ * @param[in] enabled Non-zero to boost bass and treble as the volume comes down (the default)
+ * @note The boost moves one table step per volume read towards the volume's step, so a pot
+ *       turned quickly glides to its new boost over a few periods.
+ */
+void                AudioEngine_SetLoudnessCompensation( uint8_t enabled );
+
+/**
+ * @brief Read whether loudness compensation is on
+ * @return Non-zero if on
+ */
+uint8_t             AudioEngine_GetLoudnessCompensation( void );
+#endif
+#endif
+
+#if AUDIO_ENGINE_FIR_MAX_TAPS > 0
+/* Speaker correction FIR */
+/**
+ * @brief Load the taps of the speaker correction FIR
+ * @param[in] taps Impulse response, Q15 (32767 = 1.0), first tap first; copied, so it may be
+ *            a const table in flash or a temporary; NULL to switch the FIR off
+ * @param[in] count Taps, 1 to AUDIO_ENGINE_FIR_MAX_TAPS
+ * @return PB_Idle once loaded, PB_Error if count is out of range or the taps cannot keep up
+ *         at the current output rate within AUDIO_ENGINE_FIR_MAX_LOAD_PCT (the taps in use stay)
+ * @note Application context. The same taps filter both channels, after the EQ and ahead of
+ *       the DC blocker. While playing, takes effect at the next DMA period.
+ */
+PB_StatusTypeDef    AudioEngine_SetSpeakerFir         ( const int16_t *taps, uint16_t count );
+
+/**
+ * @brief Report whether the speaker correction FIR is running
+ * @return 1 if taps are loaded and fit the cycle budget at the output rate, otherwise 0
+ */
+uint8_t             AudioEngine_GetSpeakerFirActive   ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_CMSIS_DSP
+/* CMSIS-DSP kernels */
+/**
+ * @brief Choose between the CMSIS-DSP kernels and the engine's own for the 16-bit biquad LPF
+ *        and the speaker correction FIR
+ * @param[in] enable 1 for CMSIS-DSP (the default), 0 for the native kernels
+ * @note Any context. Takes effect at the next block; the filter history carries over.
+ */
+void                AudioEngine_SetCmsisDsp           ( uint8_t enable );
+
+/**
+ * @brief Report which kernels run
+ * @return 1 for CMSIS-DSP, 0 for the native kernels
+ */
+uint8_t             AudioEngine_GetCmsisDsp           ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_FLOAT_DSP
+/* Float kernels */
+/**
+ * @brief Choose between the float kernels and the fixed-point ones for the 16-bit biquad LPF,
+ *        the DC blocker, the air effect and the fades
+ * @param[in] enable 1 for float (the default), 0 for fixed point
+ * @note Any context. Takes effect at the next block; the filter history carries over.
+ */
+void                AudioEngine_SetFloatDsp           ( uint8_t enable );
+
+/**
+ * @brief Report which kernels run
+ * @return 1 for float, 0 for fixed point
+ */
+uint8_t             AudioEngine_GetFloatDsp           ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_COMPRESSOR
+/* Compressor and loudness normalisation */
+/**
+ * @brief Set the compressor
+ * @param[in] params Settings, clamped to their ranges; NULL switches the compressor off
+ * @note Application context. Feed-forward: each block's peak across both channels sets one
+ *       gain, smoothed at the attack or release rate and ramped across the block. The gain
+ *       comes down by (1 - 1/ratio) of the level above the threshold. While playing, takes
+ *       effect at the next DMA period.
+ */
+void                AudioEngine_SetCompressor         ( const AudioEngine_Compressor *params );
+
+/**
+ * @brief Read the compressor settings
+ * @param[out] params Settings as clamped, ratio 1 and makeup 0 when off
+ */
+void                AudioEngine_GetCompressor         ( AudioEngine_Compressor *params );
+
+/**
+ * @brief Set the loudness assets are played at
+ * @param[in] lufs Target loudness, -60 to -1 LUFS (-16 to -20 suits a chime), or 0 to play
+ *            assets at their own level
+ * @note Takes effect at the next PlayAsset(). An asset made by Tools/make_asset.py carries its
+ *       measured loudness and is played at this target, or at the target in its descriptor,
+ *       with at most AUDIO_ENGINE_LOUDNESS_MAX_BOOST_DB of boost. Without the compressor the
+ *       boost also stops at the asset's peak, so normalisation never clips. Samples started
+ *       without a descriptor play at their own level.
+ */
+void                AudioEngine_SetLoudnessTarget     ( float lufs );
+
+/**
+ * @brief Read the loudness assets are played at
+ * @return Target in LUFS, 0 when off
+ */
+float               AudioEngine_GetLoudnessTarget     ( void );
+#endif
+
+/* Render graph */
+
+/**
+ * @brief Set the order of the stages after the source's LPF
+ * @param[in] nodes Stages in the order they run, each at most once; NULL or count 0 for the
+ *            default (compressor, EQ, FIR, application stage, DC blocker and air effect,
+ *            noise gate, soft clipper)
+ * @param[in] count Number of stages, at most AUDIO_NODE_COUNT
+ * @return PB_Idle if taken, PB_Error for an unknown or repeated stage
+ * @note Application context. The order is compiled into a flat list of block kernels the next
+ *       time the render context takes a configuration, and stages left out of the order or
+ *       switched off cost nothing. While voices play, the stages run once on the mix bus.
+ *       Takes effect at the next DMA period.
+ */
+PB_StatusTypeDef    AudioEngine_SetRenderGraph        ( const AudioEngine_Node *nodes, uint8_t count );
+
+/**
+ * @brief Read the order of the stages after the source's LPF
+ * @param[out] nodes Receives up to max stages
+ * @param[in] max Room in nodes
+ * @return Number of stages in the order
+ */
+uint8_t             AudioEngine_GetRenderGraph        ( AudioEngine_Node *nodes, uint8_t max );
+
+/**
+ * @brief Set the application's stage, run where AUDIO_NODE_APP stands in the render graph
+ * @param[in] func Stage, or NULL to leave it out
+ * @param[in] context Passed to func
+ * @note Application context. func runs in the render context on every block and must finish
+ *       well inside a DMA period. Takes effect at the next DMA period.
+ */
+void                AudioEngine_SetAppStage           ( AudioEngine_StageFunc func, void *context );
+
+/* Output topology */
+
+/**
+ * @brief Set the speakers the output drives
+ * @param[in] topology OUTPUT_TOPOLOGY_MONO_SPEAKER downmixes stereo sources to (L + R) / 2
+ *            straight after the fetch, runs the filter chain once and sends the result on
+ *            both I2S channels, which roughly halves the filter cost of stereo assets.
+ *            Mono sources render the same either way.
+ * @note While playing, takes effect at the next DMA period.
+ */
+void                AudioEngine_SetOutputTopology     ( OutputTopology_TypeDef topology );
+
+/**
+ * @brief Read the speakers the output drives
+ * @return OUTPUT_TOPOLOGY_STEREO or OUTPUT_TOPOLOGY_MONO_SPEAKER
+ */
+OutputTopology_TypeDef AudioEngine_GetOutputTopology  ( void );
+
+/* Fade time configuration functions */
+
+/** @brief Set whether the faders are enabled or not
+ *  @param[in] 1 (Enabled) or 0 (Disabled).
+ *  @note While playing, takes effect at the next DMA period.
+ */
+void                SetFadersEnabled                  ( uint8_t fader_setting );
+
+/**
+ * @brief Get the state of whether the faders are enabled or not.
+ * @return Faders enabled (1) or not (0)
+ */
+  uint8_t             GetFadersEnabled                ( void );
+
+/**
+ * @brief Set the duration of fade-in ramp at playback start
+ * @param[in] seconds Fade-in time in seconds (0.0-5.0 typical range)
+ * @note Fade uses quadratic curve for smooth volume ramp
+ */
+void                SetFadeInTime                     ( float seconds );
+
+/**
+ * @brief Get the current fade-in time setting
+ * @return Fade-in time in seconds
+ */
+float               GetFadeInTime                     ( void );
+
+/**
+ * @brief Set the duration of fade-out ramp when stopping playback
+ * @param[in] seconds Fade-out time in seconds (0.0-5.0 typical range)
+ */
+void                SetFadeOutTime                    ( float seconds );
+
+/**
+ * @brief Get the current fade-out time setting
+ * @return Fade-out time in seconds
+ */
+float               GetFadeOutTime                    ( void );
+
+/**
+ * @brief Set the duration of fade-out when pausing playback
+ * @param[in] seconds Pause fade time in seconds (0.0-5.0 typical range)
+ * @note Typically longer than normal fade-out for smooth pause
+ */
+void                SetPauseFadeTime                  ( float seconds );
+
+/**
+ * @brief Get the current pause fade time setting
+ * @return Pause fade time in seconds
+ */
+float               GetPauseFadeTime                  ( void );
+
+/**
+ * @brief Set the duration of fade-in ramp when resuming from pause
+ * @param[in] seconds Resume fade time in seconds (0.0-5.0 typical range)
+ */
+void                SetResumeFadeTime                 ( float seconds );
+
+/**
+ * @brief Get the current resume fade time setting
+ * @return Resume fade time in seconds
+ */
+float               GetResumeFadeTime                 ( void );
+
+/* Playback control functions */
+/**
+ * @brief Calculate a sample offset from time, sample rate, and mode
+ * @param[in] seconds Desired offset in seconds (>= 0)
+ * @param[in] sample_rate_hz Sample rate in Hz
+ * @param[in] mode Playback mode: Mode_mono or Mode_stereo
+ * @return Sample offset in interleaved samples
+ * @note For stereo, the returned value is multiplied by 2 (left+right).
+ */
+uint32_t            CalcSampleOffsetSamples           (
+                                                        float seconds,
+                                                        uint32_t sample_rate_hz,
+                                                        PB_ModeTypeDef mode 
+                                                      );
+/**
+ * @brief Start playback of a sample from memory
+ * @param[in] sample_to_play Pointer to sample data in memory
+ * @param[in] sample_set_sz Total number of samples to play (all channels combined)
+ * @param[in] playback_speed Sample rate in Hz (e.g., 22000, 44100)
+ * @param[in] sample_depth Bits per sample: 8 or 16, or AUDIO_ENGINE_ADPCM_DEPTH for IMA-ADPCM,
+ *            AUDIO_ENGINE_LOSSLESS_DEPTH for a lossless 16-bit sample, AUDIO_ENGINE_MULAW_DEPTH
+ *            or AUDIO_ENGINE_ALAW_DEPTH for a companded 8-bit sample, AUDIO_ENGINE_SBC_DEPTH
+ *            for an SBC-coded sample, AUDIO_ENGINE_MIDSIDE_DEPTH for a mid/side stereo sample,
+ *            AUDIO_ENGINE_PCM12_DEPTH for a packed 12-bit sample, or AUDIO_ENGINE_SILENCE_RLE_DEPTH
+ *            for a silence-coded 16-bit sample
+ * @param[in] mode Playback mode: Mode_mono or Mode_stereo
+ * @return PB_Playing on success, PB_Error on failure
+ * @note For an IMA-ADPCM sample, sample_set_sz still counts decoded samples; the data is
+ *       AUDIO_ENGINE_ADPCM_BLOCK_BYTES-per-channel blocks as written by Tools/make_adpcm_header.py.
+ *       The same holds for a lossless sample, in AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES-frame blocks
+ *       written by Tools/make_lossless_header.py, and for an SBC sample, in the frames written
+ *       by Tools/make_sbc_header.py.  A mid/side sample (Tools/make_midside_header.py) plays
+ *       in Mode_stereo only.  A packed 12-bit sample must be word aligned, as
+ *       Tools/make_asset.py writes it, and so must a silence-coded one
+ *       (Tools/make_rle_header.py), whose sample_set_sz counts the silent runs too.
+ *       PlayPlaylist() and PlaySampleLooped() take 8 or 16-bit PCM samples only.
+ *       With AUDIO_ENGINE_BUS_RATE, 8 and 16-bit PCM at another rate is resampled to it.
+ *       With AUDIO_ENGINE_OVERSAMPLE, 8 and 16-bit PCM may play at a multiple of its rate.
+ */
+PB_StatusTypeDef    PlaySample                        ( 
+                                                        const void *sample_to_play, 
+                                                        uint32_t sample_set_sz, 
+                                                        uint32_t playback_speed, 
+                                                        uint8_t sample_depth, 
+                                                        PB_ModeTypeDef mode 
+                                                      ); 
+
+/**
+ * @brief Start the output stream on silence so samples can start on an exact frame
+ * @param[in] playback_speed Sample rate in Hz for the stream and every sample played on it
+ * @return PB_Idle once streaming, PB_Error if playback is active or the DMA failed to start
+ * @note The I2S and DMA keep running between samples until AudioEngine_StopStream() or
+ *       ShutDownAudio(). PlaySample() at the stream's rate plays on the stream; a new rate
+ *       restarts it, or with AUDIO_ENGINE_ENABLE_HOT_RATE_SWITCH retunes it in place when
+ *       nothing is playing. The DAC stays powered while streaming.
+ */
+PB_StatusTypeDef    AudioEngine_StartStream           ( uint32_t playback_speed );
+
+/**
+ * @brief Stop the output stream
+ * @return PB_Idle when stopped, PB_Error while a sample is still playing
+ */
+PB_StatusTypeDef    AudioEngine_StopStream            ( void );
+
+#if AUDIO_ENGINE_ENABLE_HOT_RATE_SWITCH
+/**
+ * @brief Change the rate of the running output stream without stopping the I2S and DMA
+ * @param[in] playback_speed New rate in Hz
+ * @return PB_Idle once the stream runs at the new rate, PB_Error if no stream is running, a
+ *         sample is playing or cued, the ring did not fall silent within two rings, or the
+ *         I2S clock planner misses the rate
+ * @note Application context. Waits for the ring to play out to silence, so for up to a ring
+ *       after the last sound. PlaySample() at a new rate on an idle stream calls it and
+ *       restarts the stream only when it fails.
+ */
+PB_StatusTypeDef    AudioEngine_RetuneStream          ( uint32_t playback_speed );
+#endif
+
+/**
+ * @brief Make the next PlaySample() prepare its playback without starting it
+ * @return PB_Idle when the next play call will prime, PB_Error on a running stream or with
+ *         AUDIO_ENGINE_ALWAYS_ON, where the stream already starts samples at the next period
+ * @note The play call (PlaySample() or any of its wrappers) then initialises the I2S, renders
+ *       the whole ring and powers the DAC, returning PB_Primed, so AudioEngine_StartPrimed()
+ *       only has to start the DMA. The primed periods keep the volume and filters of the
+ *       prime. ShutDownAudio() or another play call drops a primed playback.
+ */
+PB_StatusTypeDef    AudioEngine_PrimeNextPlayback     ( void );
+
+/**
+ * @brief Start the playback prepared after AudioEngine_PrimeNextPlayback()
+ * @return PB_Playing, PB_PlayingFailed if the DMA failed to start, PB_Error if nothing is primed
+ * @note Only starts the output DMA: the first frame leaves within microseconds of the call.
+ */
+PB_StatusTypeDef    AudioEngine_StartPrimed           ( void );
+
+/**
+ * @brief Drop the playback prepared after AudioEngine_PrimeNextPlayback() without starting it
+ * @return PB_Idle once dropped, PB_Error if nothing was primed
+ * @note The DMA never ran, so this only resets the playback state and, under automatic DAC
+ *       control, powers the DAC down; the I2S is left as the prime set it. A prime requested
+ *       for the next play call is forgotten too. For a speculative prime on an unconfirmed
+ *       trigger edge that turns out to be a bounce.
+ */
+PB_StatusTypeDef    AudioEngine_CancelPrimed          ( void );
+
+#if AUDIO_ENGINE_ENABLE_ATTACK_CACHE
+/**
+ * @brief Make the next PlaySample() render its sound's attack into the cache instead of playing
+ * @return PB_Idle when the next play call will cache, PB_Error while playing, primed or streaming
+ * @note The play call (PlaySample() or any of its wrappers) returns PB_Idle with the attack
+ *       cached, PB_Error if the sound is shorter than the cache or the ring geometry does not
+ *       fit it. Later PlaySample() calls with the same sound, rate, depth and mode start from
+ *       the cache until it is rebuilt or dropped. Rebuild it after changing the volume,
+ *       filters or fades: the cached ring keeps those of the build.
+ */
+PB_StatusTypeDef    AudioEngine_CacheNextAttack       ( void );
+
+/**
+ * @brief Drop the cached attack, so the next PlaySample() renders its first ring as usual
+ */
+void                AudioEngine_DropAttackCache       ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PASSTHROUGH
+/**
+ * @brief Play 16-bit stereo PCM by DMA straight from the asset, without rendering it
+ * @param[in] enable 1 to play eligible samples in passthrough, 0 (the default) to render all
+ * @note PlaySample() of 16-bit stereo PCM at a rate the output takes as is, with no stream,
+ *       playlist, loop, prime or attack cache pending, then costs no render time. The filter
+ *       chain, fades, software volume, pause and seeking do not apply to it: use it when the
+ *       amplifier sets the volume and the assets start and end at silence. ShutDownAudio()
+ *       and StopPlayback() still stop it.
+ */
+void                AudioEngine_SetPassthrough        ( uint8_t enable );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+/**
+ * @brief Register the check that the amplifier has settled since the DAC switch turned it on
+ * @param[in] dac_ready Returns non-zero once the amplifier is ready to play; NULL (the default)
+ *                      treats it as ready as soon as the switch returns
+ * @note Called from PlaySample() and, while the silence runs, from the I2S DMA interrupt.
+ *       Only consulted under automatic DAC control (SetDAC_Control(1)).
+ */
+void                AudioEngine_SetDACReady           ( DAC_ReadyFunc dac_ready );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_EVENTS
+/* Playback events, delivered by AudioEngine_WaitForEvent() or AudioEngine_GetEvent() */
+typedef enum {
+  AUDIO_ENGINE_EVENT_END,                     // The playback has ended (played out, stopped or failed)
+  AUDIO_ENGINE_EVENT_MARKER,                  // The I2S has played a marker's frame; id is the marker
+  AUDIO_ENGINE_EVENT_LOOP                     // A loop wrap was rendered; id is the wraps left (255 for ever or more)
+} AudioEngine_EventType;
+
+typedef struct {
+  uint8_t  type;                              // AudioEngine_EventType
+  uint8_t  id;                                // Marker index or wraps left, 0 for AUDIO_ENGINE_EVENT_END
+  uint32_t frame;                             // Frames from the start of the playback at which it falls
+} AudioEngine_Event;
+
+typedef void        ( *AudioEngine_EventFunc )  ( const AudioEngine_Event *event );
+
+#define AUDIO_ENGINE_MARKER_OFF     0xFFFFFFFFU                 // AudioEngine_SetMarker(): clear the marker
+
+/**
+ * @brief Set the function AudioEngine_WaitForEvent() hands the events to
+ * @param[in] callback Runs in the caller of AudioEngine_WaitForEvent(), so it may call the
+ *                     engine API; NULL leaves the events queued for AudioEngine_GetEvent()
+ */
+void                AudioEngine_SetEventCallback      ( AudioEngine_EventFunc callback );
+
+/**
+ * @brief Set a position marker, reported once per playback when the I2S has played its frame
+ * @param[in] index Marker, 0 to AUDIO_ENGINE_EVENT_MARKERS - 1
+ * @param[in] frame Output frames from the start of the playback, or AUDIO_ENGINE_MARKER_OFF
+ * @return PB_Idle, or PB_Error for a bad index
+ * @note Markers stay set for the following playbacks. A marker is seen at the first DMA
+ *       interrupt after its frame has played, so it is up to half a ring late; frames count
+ *       output time, including pauses. Passthrough playbacks report only their end.
+ */
+PB_StatusTypeDef    AudioEngine_SetMarker             ( uint8_t index, uint32_t frame );
+
+/**
+ * @brief Take the oldest queued event
+ * @param[out] event Receives it
+ * @return 1 if there was one, 0 if the queue is empty
+ */
+uint8_t             AudioEngine_GetEvent              ( AudioEngine_Event *event );
+
+/**
+ * @brief Sleep with WFI until an event is queued or nothing is playing, then deliver the events
+ * @return Playback state after the events, as GetPlaybackState()
+ * @note Call with interrupts enabled, from the application's main loop. Every interrupt wakes
+ *       the core only long enough to check the queue. Without a callback the events stay
+ *       queued and it returns once nothing is playing. The queue holds 8 events; when it is
+ *       full the newest is dropped.
+ */
+PB_StatusTypeDef    AudioEngine_WaitForEvent          ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_IDLE_JOBS
+/* Step of a background job: does a bounded piece of the work and returns an AUDIO_ENGINE_JOB_* */
+typedef uint8_t     ( *AudioEngine_JobFunc )    ( void *arg );
+
+#define AUDIO_ENGINE_JOB_DONE       0U                          // Finished: the job leaves the queue
+#define AUDIO_ENGINE_JOB_MORE       1U                          // More to do now: stepped again in this slice
+#define AUDIO_ENGINE_JOB_WAIT       2U                          // Waiting on hardware: stepped again after the next wake-up
+
+/**
+ * @brief Queue a job to run in the application's idle time
+ * @param[in] job Step function, called until it returns AUDIO_ENGINE_JOB_DONE
+ * @param[in] arg Passed to each step
+ * @return PB_Idle when queued, or already queued with the same arg; PB_Error for a NULL job or
+ *         a full queue
+ * @note May be called from any context, a step included. A job posted again while its step
+ *       runs gets at least one more step. Each step should take well under
+ *       AUDIO_ENGINE_IDLE_SLICE_US: a slice ends only between steps.
+ */
+PB_StatusTypeDef    AudioEngine_PostJob               ( AudioEngine_JobFunc job, void *arg );
+
+/**
+ * @brief Run one slice of the queued jobs, a step of each in turn
+ * @return Jobs with work to do now, 0 once every job is done or waiting on hardware
+ * @note Application context only. Called by WaitForSampleEnd() and AudioEngine_WaitForEvent(),
+ *       which sleep only once it returns 0; call it from the application's own idle loops the
+ *       same way, for example until it returns 0 before STOP. A call from within a step
+ *       returns at once.
+ */
+uint8_t             AudioEngine_RunIdleJobs           ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_AUTO_END
+/**
+ * @brief Set when a decaying sound is ended early
+ * @param[in] level Output peak, in 16-bit units, below which a sound counts as silent; 0 turns
+ *            the auto end off
+ * @param[in] hold_ms Time, up to 10000 ms, a sound has to stay below the level before it ends
+ * @return PB_Idle, or PB_Error for a hold out of range
+ * @note A sound is only ended once it has been above the level, so leading silence plays.
+ *       Line-in and push sources, a playback with loops or playlist items still to play, and
+ *       synth voices are not ended, nor is anything while the volume is 0. Takes effect from
+ *       the next period.
+ */
+PB_StatusTypeDef    AudioEngine_SetAutoEnd            ( uint16_t level, uint16_t hold_ms );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_AMP_GATE
+/**
+ * @brief Set the shortest silence inside a sample the amplifier is powered down for
+ * @param[in] gap_ms Silence ahead, up to 10000 ms, needed to switch the DAC off; 0 turns the
+ *            amplifier gate off
+ * @return PB_Idle, or PB_Error for a gap out of range
+ * @note Only a silence-coded sample, or one with a silence map, is looked ahead into, and only
+ *       while no mixer voice plays. Takes effect from the next period.
+ */
+PB_StatusTypeDef    AudioEngine_SetAmpGate            ( uint16_t gap_ms );
+
+/**
+ * @brief Switch the DAC as the amplifier gate asks
+ * @note Application context only, under SetDAC_Control(1). Called by WaitForSampleEnd() and
+ *       AudioEngine_WaitForEvent() between checks; an application that waits for a playback in
+ *       its own loop calls it there, at least once a period. Without it the DAC stays on. A
+ *       voice started in a silence waits the settle time to be heard.
+ */
+void                AudioEngine_ServiceAmpGate        ( void );
+#endif
+
+/**
+ * @brief Frames played since the output DMA started, exact to the frame
+ * @return Stream frame count, the timeline used by PlaySampleAt(); wraps after 2^32 frames
+ */
+uint32_t            AudioEngine_GetFrameCount         ( void );
+
+/* Output position returned by AudioEngine_GetPosition() */
+typedef struct {
+  uint32_t stream_frame;                      // Frame at the DAC on the AudioEngine_GetFrameCount() timeline
+  uint32_t playback_frame;                    // Frames of the playback at the DAC since its first, 0 unless playing
+  uint32_t rate;                              // Output rate in Hz, to turn frames into time
+  uint32_t cycles;                            // DWT cycle count read with the frames, if the counter runs
+  uint8_t  playing;                           // 1 if a playback's frames have reached the DAC
+} AudioEngine_Position;
+
+/**
+ * @brief Get the frame at the DAC now, on the stream timeline and in the current playback
+ * @param[out] position Frames, output rate and the cycle count they were read at
+ * @note Any context, no lock. Exact to the frame from the DMA's transfer counter between
+ *       interrupts, less AUDIO_ENGINE_OUTPUT_DELAY_FRAMES. playback_frame counts every frame
+ *       output since the playback's first, a pause's silence included, on the same count as
+ *       the event markers; it starts at a queued sample's cue, not at PlaySampleAt().
+ */
+void                AudioEngine_GetPosition           ( AudioEngine_Position *position );
+
+/**
+ * @brief Queue a sample to start on an exact frame of the running stream
+ * @param[in] sample_to_play Pointer to sample data in memory
+ * @param[in] sample_set_sz Total number of samples to play (all channels combined)
+ * @param[in] sample_depth Bits per sample: 8 or 16, or an AUDIO_ENGINE_*_DEPTH as for PlaySample()
+ * @param[in] mode Playback mode: Mode_mono or Mode_stereo
+ * @param[in] start_frame AudioEngine_GetFrameCount() value at which the first sample plays
+ * @return PB_Playing when queued, PB_Error without a stream, while busy or on bad parameters
+ * @note Exact when start_frame is at least one ring (AudioEngine_GetBufferGeometry()) ahead
+ *       of AudioEngine_GetFrameCount(); a start already past plays straight away.
+ *       WaitForSampleEnd() also waits for a queued sample.
+ */
+PB_StatusTypeDef    PlaySampleAt                      (
+                                                        const void *sample_to_play,
+                                                        uint32_t sample_set_sz,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode,
+                                                        uint32_t start_frame
+                                                      );
+
+#if AUDIO_ENGINE_ENABLE_DRIFT_TRIM
+/**
+ * @brief Trim the rate at which a running stream's audio plays against the I2S clock
+ * @param[in] ppb Parts per billion: positive plays the audio faster, dropping frames, for a
+ *                clock that runs slow against the reference; negative repeats frames
+ * @return PB_Idle, or PB_Error beyond AUDIO_ENGINE_DRIFT_TRIM_MAX_PPM
+ * @note Takes effect from the next period.  At most one frame slips per period, glided
+ *       across it, so there is no click.  The trim only acts on a running stream
+ *       (AudioEngine_StartStream()) and while the output holds sound.
+ */
+PB_StatusTypeDef    AudioEngine_SetDriftTrim          ( int32_t ppb );
+
+/**
+ * @brief Get how far the trim has moved the sound from the fixed latency of the delay line
+ * @return Frames: positive when the sound plays later than a start frame alone would give
+ * @note 0 while the output is silent.  A PlaySampleAt() while a sound still plays starts
+ *       this many frames late, so subtract it from the start frame to compensate.
+ */
+int32_t             AudioEngine_GetDriftSlip          ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PLAYLIST
+/**
+ * @brief Play several samples back to back as one gapless timeline
+ * @param[in] items Samples to play in order; must stay valid until playback has finished
+ * @param[in] item_count Number of items (at least 1)
+ * @param[in] playback_speed Sample rate in Hz, shared by every item
+ * @param[in] sample_depth Bits per sample: 8 or 16, shared by every item
+ * @param[in] mode Playback mode: Mode_mono or Mode_stereo, shared by every item
+ * @param[in] crossfade_frames Frames each join overlaps (linear crossfade), 0 for a butt-join
+ * @return As PlaySample()
+ * @note Joins fall mid-period with no silence or filter reset. The crossfade at a join is
+ *       limited to the shorter item. StopPlayback() fades out within the current item.
+ */
+PB_StatusTypeDef    PlayPlaylist                      (
+                                                        const AudioEngine_PlaylistItem *items,
+                                                        uint8_t item_count,
+                                                        uint32_t playback_speed,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode,
+                                                        uint32_t crossfade_frames
+                                                      );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PHRASE
+/**
+ * @brief Play an announcement built from word clips, as one gapless timeline
+ * @param[in] clip_ids IDs of the clips in order, looked up in the mounted asset bank, then in the
+ *            asset index; copied, so the array need not outlive the call
+ * @param[in] clip_count Number of clips, 1 to AUDIO_ENGINE_PHRASE_MAX_CLIPS
+ * @param[in] crossfade_frames Frames each join overlaps, 0 for a butt-join
+ * @return As PlayPlaylist(), PB_Error for an unknown ID or clips that differ in rate, encoding
+ *         or channels (all must be PCM16 or all PCM8)
+ * @note Each clip's leading and trailing silence, below its peak by AUDIO_ENGINE_PHRASE_TRIM_SHIFT,
+ *       is trimmed to within AUDIO_ENGINE_PHRASE_PAD_FRAMES, found through its silence map and
+ *       then sample by sample; a clip that is all silence is kept whole, as a pause. The clips
+ *       play through one PlaySample(), so there is no I2S restart between them.
+ */
+PB_StatusTypeDef    PlayPhrase                        ( const uint32_t *clip_ids, uint8_t clip_count, uint32_t crossfade_frames );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_LOOP_POINTS
+#define AUDIO_ENGINE_LOOP_FOREVER   0xFFFFU   // PlaySampleLooped() loop_count: repeat until stopped
+
+/**
+ * @brief Play a sample with a loop region repeated seamlessly
+ * @param[in] sample_to_play Pointer to sample data in memory
+ * @param[in] sample_set_sz Total number of samples to play (all channels combined)
+ * @param[in] playback_speed Sample rate in Hz
+ * @param[in] sample_depth Bits per sample: 8 or 16
+ * @param[in] mode Playback mode: Mode_mono or Mode_stereo
+ * @param[in] loop_start_frame First frame of the loop region
+ * @param[in] loop_end_frame Frame after the loop region (at most the sample's frame count)
+ * @param[in] loop_count Jumps back to loop_start_frame, or AUDIO_ENGINE_LOOP_FOREVER
+ * @return As PlaySample(), PB_Error for an empty or out-of-range loop region
+ * @note Plays to the loop end, wraps loop_count times, then plays on to the sample end.
+ *       Wraps are sample-exact with no fade. StopPlayback() fades out while still looping.
+ */
+PB_StatusTypeDef    PlaySampleLooped                  (
+                                                        const void *sample_to_play,
+                                                        uint32_t sample_set_sz,
+                                                        uint32_t playback_speed,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode,
+                                                        uint32_t loop_start_frame,
+                                                        uint32_t loop_end_frame,
+                                                        uint16_t loop_count
+                                                      );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SEEK
+/**
+ * @brief Start playback of a sample part way through
+ * @param[in] sample_to_play Pointer to the start of the sample (8, 12 or 16-bit PCM, mu-law or A-law)
+ * @param[in] sample_set_sz Total number of samples (all channels combined)
+ * @param[in] playback_speed Sample rate in Hz
+ * @param[in] sample_depth 8, 16, AUDIO_ENGINE_PCM12_DEPTH, AUDIO_ENGINE_MULAW_DEPTH or
+ *            AUDIO_ENGINE_ALAW_DEPTH
+ * @param[in] mode Mode_mono or Mode_stereo
+ * @param[in] start_sample Sample to start from, all channels counted (see CalcSampleOffsetSamples()),
+ *            rounded down to a frame
+ * @return As PlaySample(), PB_Error for ADPCM or lossless samples
+ * @note The filters start settled on the sample at the start point and the normal fade-in
+ *       applies. SeekPlayback() offsets stay relative to sample_to_play.
+ */
+PB_StatusTypeDef    PlaySampleFrom                    (
+                                                        const void *sample_to_play,
+                                                        uint32_t sample_set_sz,
+                                                        uint32_t playback_speed,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode,
+                                                        uint32_t start_sample
+                                                      );
+
+/**
+ * @brief Jump to another point of the playing sample
+ * @param[in] sample_offset Sample to continue from, all channels counted from the start of the
+ *            sample, rounded down to a frame; the end of the sample or beyond ends playback
+ * @return PB_Playing when queued while playing, the current state when queued while paused,
+ *         PB_Error if the sample cannot seek or the command queue is full
+ * @note The jump is made at a period boundary, between an AUDIO_ENGINE_SEEK_FADE_MS fade-out
+ *       and fade-in, with the filters settled on the new position. While paused, ResumePlayback()
+ *       continues from the new position. Samples started by PlaySample(), PlaySampleAt(),
+ *       PlaySampleFrom() or PlayAsset() from memory can seek, if 8, 12 or 16-bit PCM, mu-law
+ *       or A-law at the output rate; playlists, loop regions, streamed, resampled, ADPCM and
+ *       lossless samples cannot.
+ */
+PB_StatusTypeDef    SeekPlayback                      ( uint32_t sample_offset );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_CROSSFADE
+/**
+ * @brief Replace the playing sample with another, crossfading from one to the other
+ * @param[in] sample_to_play Pointer to the start of the new sample
+ * @param[in] sample_set_sz Total number of samples (all channels combined)
+ * @param[in] playback_speed Sample rate in Hz, that of the playing sample
+ * @param[in] sample_depth 8 or 16, that of the playing sample
+ * @param[in] mode Mode_mono or Mode_stereo, that of the playing sample
+ * @param[in] crossfade_ms Time over which the playing sample falls and the new one rises with
+ *            linear gains, limited to the new sample's length
+ * @return PB_Playing when queued, as PlaySample() when nothing was playing, PB_Error if the
+ *         playing sample cannot crossfade to this one or a crossfade is already queued
+ * @note The new sample takes over from the next rendered period, with no fade-in, no DMA
+ *       restart and no filter reset: both are mixed ahead of the one filter chain, and the
+ *       stop fade and end fade then belong to the new sample. The playing sample must be 8 or
+ *       16-bit PCM from memory at the output rate, with no playlist or loop region, and still
+ *       playing rather than stopping or pausing. A resume during the crossfade ends it.
+ */
+PB_StatusTypeDef    CrossfadeToSample                 (
+                                                        const void *sample_to_play,
+                                                        uint32_t sample_set_sz,
+                                                        uint32_t playback_speed,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode,
+                                                        uint16_t crossfade_ms
+                                                      );
+#endif
+
+/**
+ * @brief Start playback of a sound asset
+ * @param[in] asset Descriptor made by Tools/make_asset.py; must stay valid until playback has finished
+ * @return As PlaySample(), PB_Error for a descriptor this build cannot play (bad metadata, an
+ *         encoding compiled out, or ADPCM or lossless blocks of another block size)
+ * @note Rate, depth and mode come from the descriptor. The LPF warm-up uses its first sample
+ *       and its silence map is attached, so nothing is read from the data before the start.
+ *       Fade sample counts are only recalculated when the rate changes.
+ */
+PB_StatusTypeDef    PlayAsset                         ( const AudioAsset *asset );
+
+#if AUDIO_ENGINE_ENABLE_ASSET_CACHE
+/* Decoded asset cache use returned by AudioEngine_GetAssetCacheStats() */
+typedef struct {
+  uint32_t hits;                              // PlayAsset()s played from a slot
+  uint32_t misses;                            // PlayAsset()s of an asset that fits a slot but was not in one
+  uint8_t  cached;                            // Slots holding a whole decoded asset
+} AudioEngine_AssetCacheStats;
+
+/**
+ * @brief Get the decoded asset cache's hits, misses and filled slots
+ * @param[out] stats Counts since AudioEngine_Init()
+ */
+void                AudioEngine_GetAssetCacheStats    ( AudioEngine_AssetCacheStats *stats );
+
+/**
+ * @brief Forget every decoded asset, so the next play of each decodes it again
+ * @note Application context. Needed only when encoded data is rewritten in place; mounting an
+ *       asset bank does it. A sound playing from a slot plays on.
+ */
+void                AudioEngine_FlushAssetCache       ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_LOOP_POINTS
+/**
+ * @brief Start playback of a sound asset, repeating the loop region from its descriptor
+ * @param[in] asset Descriptor with a loop region (PCM encodings only)
+ * @param[in] loop_count Jumps back to the loop start, or AUDIO_ENGINE_LOOP_FOREVER
+ * @return As PlaySampleLooped(), PB_Error if the asset has no loop region
+ */
+PB_StatusTypeDef    PlayAssetLooped                   ( const AudioAsset *asset, uint16_t loop_count );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+/**
+ * @brief Look an asset up in the linker-placed index by its ID
+ * @param[in] id Asset ID given to AUDIO_ENGINE_INDEX_ASSET() or AUDIO_ENGINE_INDEX_SAMPLE()
+ * @return The asset, or NULL if no entry has that ID
+ * @note Binary search of the sorted index.
+ */
+const AudioAsset   *AudioEngine_FindAsset             ( uint32_t id );
+
+/**
+ * @brief Start playback of an asset from the index by its ID
+ * @param[in] id Asset ID
+ * @return As PlayAsset(), PB_Error for an unknown ID
+ */
+PB_StatusTypeDef    PlayAssetById                     ( uint32_t id );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_VERIFY
+/* Result of the background check of an indexed asset (AudioEngine_GetAssetCheck()) */
+typedef enum {
+  AssetCheck_Pending,                       // Not checked yet
+  AssetCheck_Valid,                         // Data matches its CRC
+  AssetCheck_Corrupt,                       // Data does not match its CRC; PlayAsset() refuses it
+  AssetCheck_None                           // No such ID, or the asset carries no CRC
+} AudioEngine_AssetCheck;
+
+/**
+ * @brief Start checking every indexed asset against its CRC in the background
+ * @param[in] hdma Memory-to-memory DMA channel (DMA_NORMAL, word data width on both sides,
+ *                 source increment enabled, destination increment disabled)
+ * @return PB_Idle on success, PB_Error if the channel is unsuitable or the index holds more
+ *         than AUDIO_ENGINE_VERIFY_MAX_ASSETS entries
+ * @note Forgets earlier results. The channel's interrupt must not be enabled. With
+ *       AUDIO_ENGINE_ENABLE_IDLE_JOBS the check is queued as an idle job and needs no service calls.
+ */
+PB_StatusTypeDef     AudioEngine_StartAssetVerify     ( DMA_HandleTypeDef *hdma );
+
+/**
+ * @brief Do the next slice of the background check
+ * @return 1 while assets remain to be checked, 0 once all have been
+ * @note Call from the application's idle loop. Returns at once while a slice is still being
+ *       transferred; each slice is at most AUDIO_ENGINE_VERIFY_SLICE_BYTES.
+ */
+uint8_t              AudioEngine_ServiceAssetVerify   ( void );
+
+/**
+ * @brief Result of the background check of an indexed asset
+ * @param[in] id Asset ID
+ * @return AudioEngine_AssetCheck
+ */
+AudioEngine_AssetCheck AudioEngine_GetAssetCheck      ( uint32_t id );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+/**
+ * @brief Check an asset bank and make its assets playable
+ * @param[in] bank Start of the bank partition (__asset_bank_start from the linker script)
+ * @param[in] region_bytes Size of the partition
+ * @return PB_Idle when mounted, PB_Error while playing or for an empty or corrupt bank
+ * @note Checks the header, the CRC and every index entry, so the bank can be reprogrammed
+ *       on its own without the firmware trusting a half-written one. A failed mount leaves
+ *       no bank mounted.
+ */
+PB_StatusTypeDef    AudioEngine_MountBank             ( const void *bank, uint32_t region_bytes );
+
+/**
+ * @brief Look an asset up in the mounted bank by its ID
+ * @param[in] id Asset ID given to Tools/make_asset_bank.py
+ * @param[out] asset Descriptor pointing into the bank
+ * @return 1 if found, 0 for an unknown ID or with no bank mounted
+ */
+uint8_t             AudioEngine_FindBankAsset         ( uint32_t id, AudioAsset *asset );
+
+/**
+ * @brief Start playback of an asset from the mounted bank by its ID
+ * @param[in] id Asset ID
+ * @return As PlayAsset(), PB_Error for an unknown ID or with no bank mounted
+ */
+PB_StatusTypeDef    PlayBankAsset                     ( uint32_t id );
+
+#if AUDIO_ENGINE_ENABLE_BANK_UPDATE
+/**
+ * @brief Mount the newer of the two asset bank slots
+ * @param[in] slots Start of the first slot (__asset_bank_start); the second follows it
+ * @param[in] slot_bytes Size of each slot (__asset_bank_size)
+ * @return PB_Idle when a bank is mounted, otherwise as AudioEngine_MountBank()
+ * @note Call at start-up in place of AudioEngine_MountBank(). A slot counts once a bank
+ *       update has committed it, and the second slot only when committed after the first,
+ *       so a bank programmed into the first slot with Tools/make_asset_bank.py --slots 2
+ *       takes over.
+ */
+PB_StatusTypeDef    AudioEngine_MountNewestBank       ( const void *slots, uint32_t slot_bytes );
+
+/**
+ * @brief Start writing a new asset bank into the slot not mounted
+ * @param[in] bank_bytes Size of the new bank, at most the slot size less 8 bytes
+ * @return PB_Idle when under way; PB_Playing while an asset from that slot still plays (try
+ *         again later); PB_Error without AudioEngine_MountNewestBank(), without dual-bank flash
+ *         or for a bank too large
+ * @note Application context only. Erases the slot's old contents as the writes go in, so
+ *       nothing found in the previously replaced bank may still be playing.
+ */
+PB_StatusTypeDef    AudioEngine_BeginBankUpdate       ( uint32_t bank_bytes );
+
+/**
+ * @brief Write the next bytes of the new bank
+ * @param[in] data Bank bytes following those already taken
+ * @param[in] len Byte count
+ * @return Bytes taken, 0 to len: the flash is erased and programmed only while the ring holds
+ *         enough rendered audio to cover a stall of the render, so call again with the rest
+ * @note Application context only, from the main loop. A page erase needs
+ *       AUDIO_ENGINE_FLASH_ERASE_US of rendered audio: while playing, a ring of more than two
+ *       periods (AudioEngine_SetBufferGeometry() or AUDIO_ENGINE_ENABLE_RENDER_AHEAD).
+ */
+uint32_t            AudioEngine_WriteBankUpdate       ( const void *data, uint32_t len );
+
+/**
+ * @brief Check the new bank and mount it in place of the old one
+ * @return PB_Idle once swapped in (or PB_Playing while the last flash write is busy, try
+ *         again), PB_Error if it is incomplete, fails the CRC or does not check out
+ * @note The swap takes effect for the next asset found; those playing carry on from the old
+ *       slot. The slot is committed last, so a power cut at any point keeps the old bank.
+ */
+PB_StatusTypeDef    AudioEngine_FinishBankUpdate      ( void );
+#endif
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SOURCE_STREAM
+/**
+ * @brief Set up streaming from external memory
+ * @param[in] read_func Starts a read of len bytes at addr into dst and returns 0 once it is
+ *            under way; the application calls AudioEngine_SourceReadComplete() when the data
+ *            has landed. Called from the render context and the completion interrupt. Reads
+ *            are whole AUDIO_ENGINE_STREAM_BLOCK_BYTES blocks at aligned addresses.
+ * @param[in] image_addr Address of the stream image for PlayStreamedAsset(), or
+ *            AUDIO_ENGINE_NO_STREAM_IMAGE to stream only with PlayStreamedSample()
+ * @return PB_Idle when ready, PB_Error if read_func is NULL, the read failed or the image
+ *         header is not valid
+ */
+PB_StatusTypeDef    AudioEngine_SourceStreamInit      ( SourceReadFunc read_func, uint32_t image_addr );
+
+/**
+ * @brief Report that the read started by the SourceReadFunc has completed
+ * @note Call from the DMA transfer-complete interrupt, at the I2S DMA interrupt's priority
+ *       or above, or with interrupts masked, so the render context cannot preempt it. Starts
+ *       the next read while a staging block is free.
+ */
+void                AudioEngine_SourceReadComplete    ( void );
+
+/**
+ * @brief Start playback of a sample held in external memory
+ * @param[in] addr External address of the first sample
+ * @param[in] sample_set_sz Total samples, all channels combined
+ * @param[in] playback_speed Sample rate in Hz
+ * @param[in] sample_depth 8 or 16
+ * @param[in] mode Mode_mono or Mode_stereo
+ * @return As PlaySample(), PB_PlayingFailed if the staging ring could not be filled in time
+ * @note Blocks while the staging ring is filled, then plays as PlaySample() does. A read
+ *       that has not landed when its period is rendered gives a silent period and counts an
+ *       underrun (AudioEngine_GetStreamUnderruns()). Pause holds the stream position.
+ */
+PB_StatusTypeDef    PlayStreamedSample                (
+                                                        uint32_t addr,
+                                                        uint32_t sample_set_sz,
+                                                        uint32_t playback_speed,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode
+                                                      );
+
+/**
+ * @brief Start playback of an asset from the stream image by its ID
+ * @param[in] id Asset ID from the image index
+ * @return As PlayStreamedSample(), PB_Error for an unknown ID or no image
+ * @note Looks the ID up with a binary search of the index, one read per step.
+ */
+PB_StatusTypeDef    PlayStreamedAsset                 ( uint32_t id );
+
+/**
+ * @brief Start playback of a PCM WAV file held in external memory
+ * @param[in] addr External address of the file (the RIFF header)
+ * @return As PlayStreamedSample(), PB_Error for a file that is not 8 or 16-bit PCM, mono or stereo
+ * @note Rate, depth and mode come from the "fmt " chunk; the "data" chunk is streamed.
+ */
+PB_StatusTypeDef    PlayStreamedWav                   ( uint32_t addr );
+
+/**
+ * @brief Get the number of periods rendered silent while waiting for a read
+ * @return Underruns since AudioEngine_SourceStreamInit()
+ */
+uint32_t            AudioEngine_GetStreamUnderruns    ( void );
+
+/**
+ * @brief Get the least audio the ring held ahead of a period since the stream started
+ * @return Milliseconds, 0 after an underrun; the margin left against stalls of the medium
+ */
+uint32_t            AudioEngine_GetStreamLowWaterMs   ( void );
+
+/**
+ * @brief Weak hook run while the engine waits in the application context
+ * @note Runs in the stream read waits and in WaitForSampleEnd(). A backend whose reads run in
+ *       the application context (sd_stream.c) services its read here.
+ */
+void                AudioEngine_OnStreamWait          ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_LINE_IN
+/**
+ * @brief Set up the line input
+ * @param[in] hadc ADC converting the input: one regular channel, right aligned, on the rising
+ *            edge of htim's TRGO, with DMAContinuousRequests and a circular half-word DMA
+ * @param[in] htim Basic or general-purpose timer with TRGO on its update event; the engine
+ *            sets its prescaler and period for the I2S rate
+ * @param[in] opamp OPAMP feeding the ADC channel (e.g. OPAMP2 on ADC2's internal channel), set
+ *            up by the application and enabled only while the input plays, or NULL
+ * @return PB_Idle, PB_Error for a NULL hadc or htim or an ADC without a DMA handle
+ */
+PB_StatusTypeDef    AudioEngine_LineInInit            ( ADC_HandleTypeDef *hadc, TIM_HandleTypeDef *htim, OPAMP_TypeDef *opamp );
+
+/**
+ * @brief Play the line input until StopPlayback()
+ * @param[in] playback_speed Output and capture rate in Hz
+ * @return As PlaySample(), PB_Error before AudioEngine_LineInInit(), PB_PlayingFailed if the
+ *         ADC did not start
+ * @note Plays as a mono 16-bit sample with no end, with the fade-in, volume and filter chain
+ *       of any other playback. Pause and resume pick up the live input where it is.
+ */
+PB_StatusTypeDef    PlayLineIn                        ( uint32_t playback_speed );
+
+/**
+ * @brief Set the gain of the OPAMP pre-amplifier in PGA mode
+ * @param[in] gain 2, 4, 8, 16, 32 or 64
+ * @return PB_Idle, PB_Error for another gain or with no OPAMP
+ * @note Only the gain is changed; the application chooses the PGA mode and its inputs.
+ */
+PB_StatusTypeDef    AudioEngine_SetLineInGain         ( uint8_t gain );
+
+/**
+ * @brief Get the number of times capture and playback were put back in step
+ * @return Realignments since AudioEngine_LineInInit(), each a jump of the input; steady
+ *         playback counts none after the first periods
+ */
+uint32_t            AudioEngine_GetLineInSlips        ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ENVELOPE_PWM
+/* Level the envelope follows (AudioEngine_EnvelopeConfig) */
+typedef enum {
+  ENVELOPE_PEAK,                              // Largest sample of either channel in a step
+  ENVELOPE_RMS                                // RMS of both channels over a step
+} AudioEngine_EnvelopeMode;
+
+/* Envelope output settings for AudioEngine_SetEnvelopePwm() */
+typedef struct {
+  AudioEngine_EnvelopeMode mode;
+  uint16_t attack_ms;                         // Time constant of a rising level, 0 to follow at once
+  uint16_t release_ms;                        // Time constant of a falling level
+  uint16_t min_duty;                          // Duty at silence, 0-65535 of the PWM period
+  uint16_t max_duty;                          // Duty at full scale
+} AudioEngine_EnvelopeConfig;
+
+/* Envelope-driven LED output */
+/**
+ * @brief Set up the envelope PWM output
+ * @param[in] htim General-purpose or advanced timer with channel in PWM mode, and a circular
+ *            half-word memory to word peripheral DMA on its update request (hdma[ TIM_DMA_ID_UPDATE ])
+ * @param[in] channel TIM_CHANNEL_1 to TIM_CHANNEL_4
+ * @return PB_Idle, PB_Error for a NULL htim, a timer without an update DMA handle, another
+ *         channel, or with the stream running
+ * @note The engine sets the timer's prescaler and period, and starts and stops the PWM with the
+ *       I2S. No interrupt is used; the DMA's interrupts are left disabled.
+ */
+PB_StatusTypeDef    AudioEngine_EnvelopePwmInit       ( TIM_HandleTypeDef *htim, uint32_t channel );
+
+/**
+ * @brief Set how the output's envelope maps onto the PWM duty
+ * @param[in] config Settings; the duties are swapped if min_duty is above max_duty
+ * @note Application context. Defaults: peak, 5 ms attack, 150 ms release, duty 0 to 65535.
+ */
+void                AudioEngine_SetEnvelopePwm        ( const AudioEngine_EnvelopeConfig *config );
+
+/**
+ * @brief Read the envelope output settings
+ * @param[out] config Settings as clamped
+ */
+void                AudioEngine_GetEnvelopePwm        ( AudioEngine_EnvelopeConfig *config );
+
+/**
+ * @brief Get the envelope level last rendered
+ * @return Smoothed level, 0-32767, before the duty mapping
+ */
+uint16_t            AudioEngine_GetEnvelopeLevel      ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_METER
+/* Output levels of the last period rendered, left then right, 0-32767 */
+typedef struct {
+  uint16_t peak[ 2 ];                         // Largest magnitude in the period
+  uint16_t rms[ 2 ];                          // RMS over the period
+  uint16_t hold[ 2 ];                         // Peak held for the hold time, then falling
+  uint32_t periods;                           // Periods measured since the stream started; a new reading changes it
+} AudioEngine_MeterLevels;
+
+/* Output level meter */
+/**
+ * @brief Read the output levels of the last period rendered
+ * @param[out] levels Levels; all zero until the stream's first period
+ * @note Any context below the render's priority. Lock-free: the copy is retried if a render
+ *       publishes during it. The levels stay at the last period's while the stream is stopped.
+ */
+void                AudioEngine_GetMeter              ( AudioEngine_MeterLevels *levels );
+
+/**
+ * @brief Set the meter's peak hold and decay, and clear the held peaks
+ * @param[in] hold_ms Time a peak is held
+ * @param[in] decay_db_per_s Fall after the hold in dB per second, 0 to hold until a higher peak
+ * @note Application context. Defaults: 1000 ms hold, 20 dB/s.
+ */
+void                AudioEngine_SetMeterHold          ( uint16_t hold_ms, uint16_t decay_db_per_s );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PUSH_SOURCE
+/**
+ * @brief Play the frames pushed with AudioEngine_PushFrames() until StopPlayback()
+ * @param[in] playback_speed Output rate in Hz, the producer's nominal rate
+ * @param[in] channels Mode_mono or Mode_stereo, as the producer's frames
+ * @return As PlaySample()
+ * @note Plays as a 16-bit sample with no end, with the fade-in, volume and filter chain of any
+ *       other playback. Silence plays until a period and AUDIO_ENGINE_PUSH_LATENCY_FRAMES are
+ *       buffered, and again after the ring runs dry. A resume plays on from the newest frames.
+ */
+PB_StatusTypeDef    PlayPushedSource                  ( uint32_t playback_speed, PB_ModeTypeDef channels );
+
+/**
+ * @brief Write frames into the pushed source's ring
+ * @param[in] samples 16-bit samples, interleaved left and right for stereo
+ * @param[in] frames Frames in samples
+ * @return Frames taken; fewer when the ring is full, none while no pushed source plays
+ * @note Safe from an interrupt: one producer, the render context the only consumer.
+ */
+uint32_t            AudioEngine_PushFrames            ( const int16_t *samples, uint32_t frames );
+
+/**
+ * @brief Get the frames the ring held after the last period was taken
+ * @return Frames; the producer holds this at AUDIO_ENGINE_PUSH_LATENCY_FRAMES by speeding up
+ *         or slowing down. Sampled once per period, so free of the period's sawtooth.
+ */
+uint32_t            AudioEngine_GetPushLevel          ( void );
+
+/**
+ * @brief Get the number of times the pushed source ran dry
+ * @return Underruns since PlayPushedSource(), each a gap of silence while the ring refills
+ */
+uint32_t            AudioEngine_GetPushUnderruns      ( void );
+
+/**
+ * @brief Get the number of frames dropped for want of room in the ring
+ * @return Frames since PlayPushedSource(), not counting those pushed while paused
+ */
+uint32_t            AudioEngine_GetPushOverruns       ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SILENCE_MAP
+/**
+ * @brief Attach a per-block peak table to the next sample started
+ * @param[in] block_peaks Peak magnitude of each AUDIO_ENGINE_SILENCE_MAP_BLOCK_FRAMES block of
+ *            source frames, in 16-bit units, as made by Tools/make_silence_map.py; must stay
+ *            valid until playback has finished. NULL detaches.
+ * @param[in] block_count Number of entries
+ * @note Call just before PlaySample(), PlaySampleAt() or PlaySampleLooped(); the next sample
+ *       loaded takes the map (a playlist ignores it). While the noise gate is enabled and
+ *       closed, a period whose blocks all peak below NOISE_GATE_THRESHOLD is written as silence
+ *       without running the filter chain. Fades and the playback position advance as usual.
+ */
+void                AudioEngine_SetSilenceMap         ( const uint16_t *block_peaks, uint32_t block_count );
+#endif
+
+/**
+ * @brief Block until current sample playback completes
+ * @return PB_Idle when playback finished, PB_Error on playback failure
+ * @note This blocks while paused/pausing as well. For non-blocking, poll GetPlaybackState().
+ *       With AUDIO_ENGINE_ENABLE_EVENTS it sleeps in AudioEngine_WaitForEvent() and delivers
+ *       the events on the way.
+ */
+PB_StatusTypeDef    WaitForSampleEnd                  ( void );
+
+/**
+ * @brief Pause playback with fade-out
+ * @return PB_Pausing when queued, PB_Error if the command queue is full or AUDIO_ENGINE_ENABLE_PAUSE
+ *         is 0, else the current state
+ * @note Takes effect at the next DMA period. Applies pause fade time before silencing.
+ *       Use ResumePlayback() to resume.
+ */
+PB_StatusTypeDef    PausePlayback                     ( void );
+
+/**
+ * @brief Resume playback after pause with fade-in
+ * @return PB_Playing when queued, PB_Error if the command queue is full or AUDIO_ENGINE_ENABLE_PAUSE
+ *         is 0, else the current state
+ * @note Takes effect at the next DMA period. Applies resume fade time to smoothly restore volume
+ */
+PB_StatusTypeDef    ResumePlayback                    ( void );
+
+/**
+ * @brief Stop playback asynchronously with normal end-of-play fade-out
+ * @return Current playback state, PB_Idle if already idle, PB_Error if the command queue is full
+ * @note Returns immediately. Use GetPlaybackState() to poll for completion.
+ *       Pause, resume and stop are queued from the application context only (not from ISRs)
+ *       and applied by the render context before the next DMA period.
+ */
+PB_StatusTypeDef    StopPlayback                      ( void );
+
+/**
+ * @brief Shut down all audio hardware (I2S, DAC, amplifier)
+ * @note Call when shutting down application or before changing configurations.
+ *       With AUDIO_ENGINE_ALWAYS_ON only the playback is halted and the stream keeps running.
+ */
+void                ShutDownAudio                     ( void );
+
+/* Instance API
+ *
+ * Handle-based forms of the playback and configuration calls, for code written against an
+ * engine instance rather than the file-scope one.  The engine state lives in one instance per
+ * build, returned by AudioEngine_DefaultInstance(); the functions above are that instance's
+ * API, and these give PB_Error for any other handle. */
+typedef struct AudioEngineContext AudioEngine_Instance;
+
+/**
+ * @brief Get the engine instance the handle-free API drives
+ * @return Default instance, the only one in this build
+ */
+AudioEngine_Instance *AudioEngine_DefaultInstance     ( void );
+
+/**
+ * @brief PlaySample() on an engine instance
+ * @param[in] engine Engine instance
+ * @return As PlaySample(), PB_Error for an unknown instance
+ */
+PB_StatusTypeDef    AudioEngine_Play                  (
+                                                        AudioEngine_Instance *engine,
+                                                        const void *sample_to_play,
+                                                        uint32_t sample_set_sz,
+                                                        uint32_t playback_speed,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode
+                                                      );
+
+/**
+ * @brief PausePlayback(), ResumePlayback(), StopPlayback() and WaitForSampleEnd() on an instance
+ * @param[in] engine Engine instance
+ * @return As the handle-free call, PB_Error for an unknown instance
+ */
+PB_StatusTypeDef    AudioEngine_Pause                 ( AudioEngine_Instance *engine );
+PB_StatusTypeDef    AudioEngine_Resume                ( AudioEngine_Instance *engine );
+PB_StatusTypeDef    AudioEngine_Stop                  ( AudioEngine_Instance *engine );
+PB_StatusTypeDef    AudioEngine_WaitForEnd            ( AudioEngine_Instance *engine );
+
+/**
+ * @brief Get the playback state of an engine instance
+ * @param[in] engine Engine instance
+ * @return As GetPlaybackState(), PB_Error for an unknown instance
+ */
+PB_StatusTypeDef    AudioEngine_GetState              ( const AudioEngine_Instance *engine );
+
+/**
+ * @brief SetFilterConfig() on an engine instance
+ * @param[in] engine Engine instance
+ * @param[in] cfg Filter configuration, as SetFilterConfig()
+ * @return As SetFilterConfig(), PB_Error for an unknown instance
+ */
+PB_StatusTypeDef    AudioEngine_SetFilterConfig       ( AudioEngine_Instance *engine, const FilterConfig_TypeDef *cfg );
+
+/**
+ * @brief SetFadeInTime() and SetFadeOutTime() on an engine instance
+ * @param[in] engine Engine instance
+ * @param[in] seconds Fade time in seconds
+ * @return PB_Idle once set, PB_Error for an unknown instance
+ */
+PB_StatusTypeDef    AudioEngine_SetFadeInTime         ( AudioEngine_Instance *engine, float seconds );
+PB_StatusTypeDef    AudioEngine_SetFadeOutTime        ( AudioEngine_Instance *engine, float seconds );
+
+/* DAC power control */
+/**
+ * @brief Enable or disable DAC power control
+ * @param[in] state 1 to enable DAC, 0 to disable DAC
+ * @note Controls the optional DAC power management feature
+ */
+void                SetDAC_Control                    ( uint8_t state );
+
+/**
+ * @brief Get current DAC power control state
+ * @return 1 if DAC control enabled, 0 if disabled
+ */
+uint8_t             GetDAC_Control                    ( void );
+
+/* Volume response control */
+/**
+ * @brief Enable or disable non-linear volume response curve
+ * @param[in] enable 1 to enable logarithmic response (recommended), 0 for linear
+ * @note Non-linear response matches human loudness perception for intuitive control
+ */
+void                SetVolumeResponseNonlinear        ( uint8_t enable );
+
+/**
+ * @brief Get current volume response mode
+ * @return 1 if non-linear mode enabled, 0 if linear
+ */
+uint8_t             GetVolumeResponseNonlinear        ( void );
+
+/**
+ * @brief Set volume response gamma exponent
+ * @param[in] gamma Gamma value (1.0-4.0), typical: 2.0 for quadratic response
+ * @note Higher gamma = more aggressive curve. 1.0 = linear, 2.0 = recommended
+ * @note Rebuilds the volume response table with powf(); call from thread context, not an ISR
+ */
+void                SetVolumeResponseGamma            ( float gamma );
+
+/**
+ * @brief Get current volume response gamma exponent
+ * @return Current gamma value
+ */
+float               GetVolumeResponseGamma            ( void );
+
+#if AUDIO_ENGINE_ENABLE_MUTE
+/**
+ * @brief Mute or unmute the output without stopping playback
+ * @param[in] mute 1 to mute, 0 to play at the volume control again
+ * @note The volume ramps over one block either way.  While muted the main playback keeps its
+ *       place, fades and end on time at almost no render cost, and mixer voices mix silent.
+ */
+void                AudioEngine_SetMute               ( uint8_t mute );
+
+/**
+ * @brief Set the volume reading at or below which the output is muted
+ * @param[in] level Raw ReadVolume() reading, 0 (the default) to mute only at 0
+ * @note Give the floor the volume input clamps to (VOLUME_MIN_CLAMP) to have the control's
+ *       lowest position mute, as AudioEngine_SetMute() does.
+ */
+void                AudioEngine_SetMuteLevel          ( uint16_t level );
+#endif
+
+/* Chunk processing callbacks (call from DMA callbacks) */
+/**
+ * @brief Process next 16-bit PCM chunk from DMA half-complete callback
+ * @param[in,out] chunk_p Pointer to next chunk of 16-bit samples to process
+ * @return PB_Playing while playback continues, PB_Idle when finished
+ * @note Called from DMA ISR. Applies volume, filters, fade, clipping
+ */
+PB_StatusTypeDef    ProcessNextWaveChunk              ( int16_t *chunk_p );
+
+/**
+ * @brief Process next 8-bit PCM chunk from DMA half-complete callback
+ * @param[in,out] chunk_p Pointer to next chunk of 8-bit samples to process
+ * @return PB_Playing while playback continues, PB_Idle when finished
+ * @note Called from DMA ISR. Applies volume, filters, fade, clipping
+ */
+PB_StatusTypeDef    ProcessNextWaveChunk_8_bit        ( uint8_t *chunk_p );
+
+/**
+ * @brief Advance sample pointer for next DMA transfer
+ * @note Call from DMA complete callback after ProcessNextWaveChunk()
+ */
+void                AdvanceSamplePointer              ( void );
+
+#if AUDIO_ENGINE_ENABLE_PREFETCH_DMA
+/**
+ * @brief Attach the memory-to-memory DMA channel used to prefetch source blocks
+ * @param[in] hdma Initialised channel (DMA_MEMORY_TO_MEMORY, DMA_NORMAL, byte or word data
+ *                 width on both sides, both increments enabled), or NULL to read the source directly.
+ *                 A word channel moves each block in a quarter of the beats, and skips blocks
+ *                 that are not word aligned.
+ * @return PB_Idle on success, PB_Error if playback is active or the channel is unsuitable
+ * @note The channel's interrupt must not be enabled; the engine polls the transfer itself.
+ */
+PB_StatusTypeDef     AudioEngine_SetPrefetchDMA       ( DMA_HandleTypeDef *hdma );
+#endif
 
-/* DAC control values */
-#define DAC_OFF               false
-#define DAC_ON                true
+#if AUDIO_ENGINE_ENABLE_SAI_OUTPUT && !defined( HAL_SAI_MODULE_ENABLED )
+#error "AUDIO_ENGINE_ENABLE_SAI_OUTPUT needs HAL_SAI_MODULE_ENABLED"
+#endif
 
-/* Playback engine buffer configuration */
-// Larger buffer sizes can reduce CPU load but increase latency and RAM usage. Adjust as needed.
-// and must be a multiple of 2 correct DMA buffer size requirements.
-#define PB_BUFF_SZ                  2048U
-#define CHUNK_SZ                    ( PB_BUFF_SZ / 2 )
-#define HALFCHUNK_SZ                ( CHUNK_SZ / 2 )
-#define FIRST                       0U
-#define SECOND                      1U
+#if AUDIO_ENGINE_ENABLE_QSPI_XIP
+#ifndef HAL_QSPI_MODULE_ENABLED
+#error "AUDIO_ENGINE_ENABLE_QSPI_XIP needs HAL_QSPI_MODULE_ENABLED"
+#endif
+/* Places sample data in QUADSPI flash: const int16_t chime[ N ] AUDIO_ENGINE_QSPI_ASSET = { ... }; */
+#define AUDIO_ENGINE_QSPI_ASSET   __attribute__( ( section( ".qspi_assets" ), aligned( 4 ) ) )
 
-/* Fade configuration */
-#define PAUSE_FADEOUT_SAMPLES       5512U    // About 0.5 second at 11kHz
-#define FADEIN_SAMPLES              2048U    // About 93ms at 22kHz
+/* Fast read command of the QUADSPI flash */
+typedef struct {
+  uint8_t           instruction;            // Read opcode: 0x6B (quad output) or 0xEB (quad I/O)
+  uint8_t           dummy_cycles;           // Dummy clocks after the address (and mode byte)
+  uint8_t           quad_address;           // 1: address and a 0xFF mode byte on four lines (0xEB)
+  uint8_t           address_bytes;          // 3, or 4 for flash beyond 16 MB
+} AudioEngine_QspiRead;
 
-/* DC blocking filter configuration */
-#define DC_FILTER_ALPHA             64225    // 0.98 in fixed-point (64225/65536)
-#define DC_FILTER_SHIFT             16       // Right shift for fixed-point division
-#define SOFT_DC_FILTER_ALPHA        65216    // 0.995 in fixed-point (65216/65536)
+/**
+ * @brief Put the QUADSPI flash in memory-mapped mode so assets linked into it play in place
+ * @param[in] hqspi Initialised handle; Init.FlashSize must cover the linked assets
+ * @param[in] read The flash's fast read command
+ * @return PB_Idle on success, PB_Error if playback is active, the assets do not fit or the HAL fails
+ * @note The flash's quad-enable bit must already be set.  Until this succeeds PlaySample() and
+ *       AudioEngine_PlayVoice() refuse data in QUADSPI flash.
+ */
+PB_StatusTypeDef     AudioEngine_MapQspiAssets        ( QSPI_HandleTypeDef *hqspi, const AudioEngine_QspiRead *read );
+#endif
 
-/* 16-bit biquad low-pass filter aggressiveness levels (alpha coefficients) */
-/* Lower alpha is heavier filtering for this biquad, so values are ordered heavy -> light. */
-#define LPF_16BIT_VERY_SOFT         40960    // 0.625 - minimal filtering / highest cutoff
-#define LPF_16BIT_SOFT              52429    // ~0.80 - gentle filtering
-#define LPF_16BIT_MEDIUM            57344    // 0.875 - balanced filtering
-#define LPF_16BIT_FIRM              60416    // ~0.92 - firm filtering
-#define LPF_16BIT_AGGRESSIVE        63488    // ~0.97 - strongest filtering / lowest cutoff
+#if AUDIO_ENGINE_ENABLE_RAM_ASSET
+/* RAM asset image (Tools/make_asset.py --ram): this header, then the data, word aligned */
+#define AUDIO_ENGINE_RAM_ASSET_MAGIC 0x52325243U    // "CR2R", little-endian
 
-/* Number of cycles to warm up biquad filter state */
-#define BIQUAD_WARMUP_CYCLES        16
+typedef struct {
+  uint32_t        magic;                    // AUDIO_ENGINE_RAM_ASSET_MAGIC
+  uint32_t        crc32;                    // CRC-32 (IEEE 802.3) of the image from data_bytes to the end of the data
+  uint32_t        data_bytes;               // Sample data following the header
+  uint32_t        sample_sz;                // The AudioAsset fields of the same names
+  uint32_t        sample_rate;
+  uint32_t        loop_start_frame;
+  uint32_t        loop_end_frame;
+  uint16_t        adpcm_block_bytes;
+  uint16_t        lossless_block_frames;
+  uint16_t        peak;
+  int16_t         warmup_sample;
+  uint8_t         encoding;                 // AudioAsset_Encoding
+  uint8_t         channels;
+  int16_t         loudness_db10;
+  int16_t         loudness_target_db10;
+  uint8_t         flags;                    // AUDIO_ASSET_* flags
+  uint8_t         reserved;
+} AudioEngine_RamAssetHeader;
 
-/* Low-pass filter for 8-bit samples */
-#define LPF_MAKEUP_GAIN_Q16         70779   // ~1.08x post-LPF makeup (default)
-/* Low-pass filter for 16-bit samples */
-#define LPF_16BIT_MAKEUP_GAIN_Q16   65536   // 1.00x post-LPF makeup (default)
+/**
+ * @brief Write part of an image into the RAM asset slot
+ * @param[in] offset Byte offset into the slot
+ * @param[in] data Image bytes
+ * @param[in] len Byte count
+ * @return PB_Idle when written; PB_Playing while the image PlayRamAsset() last started may still
+ *         play (stop it first); PB_Error for a write beyond the slot
+ * @note Application context only. A debugger can write the whole image at __ram_asset_start
+ *       instead; the slot is not cleared at reset, so it survives the reset that follows.
+ */
+PB_StatusTypeDef     AudioEngine_WriteRamAsset        ( uint32_t offset, const void *data, uint32_t len );
 
-/* 8-bit low-pass filter aggressiveness levels (alpha coefficients in fixed-point) */
-#define LPF_VERY_SOFT           61440       // 0.9375 - very gentle filtering
-#define LPF_SOFT                57344       // 0.875 - gentle filtering
-#define LPF_MEDIUM              49152       // 0.75 - balanced filtering
-#define LPF_FIRM                45056       // 0.6875 - firm filtering
-#define LPF_AGGRESSIVE          40960       // 0.625 - strong filtering
+/**
+ * @brief Check the image in the RAM asset slot and describe it
+ * @param[out] asset Descriptor pointing into the slot
+ * @return 1 for a whole image, 0 for an empty, partly written or corrupt slot
+ * @note The descriptor can go to PlayAsset(), or its data to PlaySample(), like an asset in flash.
+ */
+uint8_t              AudioEngine_FindRamAsset         ( AudioAsset *asset );
 
-/* Noise gate configuration */
-#define NOISE_GATE_THRESHOLD    512         // ~1.5% of full scale
+/**
+ * @brief Start playback of the asset in the RAM asset slot
+ * @return As PlayAsset(), PB_Error for an empty, partly written or corrupt slot
+ */
+PB_StatusTypeDef     PlayRamAsset                     ( void );
+#endif
 
-/* Audio silence midpoints */
-#define SAMPLE8_MIDPOINT        128U        // Midpoint for unsigned 8-bit unsigned samples
-#define SAMPLE16_MIDPOINT       0           // Midpoint for signed 16-bit samples
+#if AUDIO_ENGINE_ENABLE_I2S_CLOCK_PLAN
+/* I2S clocking */
+typedef struct {
+  uint32_t          requested_hz;           // Rate asked for
+  uint32_t          achieved_hz;            // Rate the dividers give, to the nearest Hz
+  int32_t           error_ppm;              // Achieved rate's error in parts per million
+  uint32_t          kernel_hz;              // I2S kernel clock
+  uint32_t          clock_source;           // RCC_I2SCLKSOURCE_SYSCLK, _PLL, _HSI or _EXT
+  uint16_t          divider;                // Kernel clocks per bit clock, 2 * I2SDIV + ODD
+  uint8_t           extended;               // 16-bit samples in 32-bit channels (I2S_DATAFORMAT_16B_EXTENDED)
+} AudioEngine_I2SClock;
 
-/* Fill half buffer macro */
-#define MIDPOINT_FILL_BUFFER() memset( pb_buffer, SAMPLE16_MIDPOINT, sizeof( pb_buffer ) );
+/**
+ * @brief Find the I2S kernel clock, channel length and divider nearest a sample rate
+ * @param[in] rate Sample rate in Hz
+ * @param[out] clock Best configuration found, with its achieved rate and error
+ * @return 1 if the error is within AUDIO_ENGINE_RATE_TOLERANCE_PPM, 0 if not
+ * @note Considers SYSCLK, the PLL "Q" output when it is enabled, HSI16 and
+ *       AUDIO_ENGINE_I2S_CKIN_HZ, with the master clock output off.
+ */
+uint8_t              AudioEngine_PlanI2SClock         ( uint32_t rate, AudioEngine_I2SClock *clock );
+
+/**
+ * @brief Program a planned clock into an initialised, idle I2S
+ * @param[in] hi2s Handle after HAL_I2S_Init(), with MCLKOutput disabled
+ * @param[in] clock Configuration from AudioEngine_PlanI2SClock()
+ * @return HAL_OK, or HAL_ERROR if the I2S is enabled or cannot take the configuration
+ * @note Call from the I2S init callback. The kernel clock selection is shared by SPI2 and SPI3;
+ *       an extended channel length needs a DAC that accepts 32-bit channels.
+ */
+HAL_StatusTypeDef    AudioEngine_ApplyI2SClock        ( I2S_HandleTypeDef *hi2s, const AudioEngine_I2SClock *clock );
+
+/**
+ * @brief Get the clock last applied to AUDIO_ENGINE_I2S_HANDLE, to report its rate error
+ * @param[out] clock Receives the configuration, all zero if none has been applied
+ */
+void                 AudioEngine_GetI2SClock          ( AudioEngine_I2SClock *clock );
+#endif
+
+#if AUDIO_ENGINE_OUTPUT_ZONES > 1
+/* Output zones */
+#if !AUDIO_ENGINE_ENABLE_SAI_OUTPUT
+/**
+ * @brief Attach the I2S interface for an extra output zone
+ * @param[in] zone Zone number, 1 to AUDIO_ENGINE_OUTPUT_ZONES - 1
+ * @param[in] hi2s I2S handle with a linked TX DMA channel, or NULL to detach the zone
+ * @return PB_Idle on success, PB_Error if playing or the arguments are invalid
+ * @note The zone's DMA requests are synchronised to zone 0 through DMAMUX when zone 0's
+ *       TX channel is on DMAMUX1 channel 0-3. The zone starts at full gain.
+ */
+PB_StatusTypeDef     AudioEngine_AttachZone           ( uint8_t zone, I2S_HandleTypeDef *hi2s );
+#endif
+
+/**
+ * @brief Set the gain of an extra output zone relative to zone 0
+ * @param[in] zone Zone number, 1 to AUDIO_ENGINE_OUTPUT_ZONES - 1
+ * @param[in] gain 0-65535 where 65535 is the same level as zone 0
+ */
+void                 AudioEngine_SetZoneGain          ( uint8_t zone, uint16_t gain );
+#endif
+
+#if AUDIO_ENGINE_MIXER_VOICES > 0
+/* Mixer voices */
+#define AUDIO_ENGINE_PITCH_UNITY        65536U      // Voice playback rate of the recorded pitch, Q16.16
+#define AUDIO_ENGINE_VOICE_WIDTH_UNITY  256U        // Stereo voice width as recorded; 0 is mono
+#define AUDIO_ENGINE_VOICE_WIDTH_MAX    512U        // Widest stereo image, twice the recorded side signal
+#if AUDIO_ENGINE_ENABLE_TIME_STRETCH
+#define AUDIO_ENGINE_TEMPO_UNITY        65536U      // Voice tempo as recorded, Q16.16
+#define AUDIO_ENGINE_TEMPO_MIN          32768U      // Half speed, twice as long
+#define AUDIO_ENGINE_TEMPO_MAX          131072U     // Double speed, half as long
+#endif
 
-/* Playback status type */
 typedef enum {
-  PB_Idle,
-  PB_Error,
-  PB_Playing,
-  PB_Pausing,
-  PB_Paused,
-  PB_PlayingFailed
-} PB_StatusTypeDef;
+  VOICE_STEAL_NONE,                         // A start fails while every voice is busy
+  VOICE_STEAL_OLDEST,                       // Replace the voice started first
+  VOICE_STEAL_QUIETEST,                     // Replace the voice at the lowest level
+  VOICE_STEAL_LOWEST_PRIORITY               // Replace the least important voice, oldest first (default)
+} VoiceSteal_TypeDef;
 
-/* Playback mode type */
+#if AUDIO_ENGINE_ENABLE_DUCKER
+/* Bus a mixer voice plays on, for the ducker (AudioEngine_SetDucker()) */
 typedef enum {
-  Mode_stereo,
-  Mode_mono
-} PB_ModeTypeDef;
+  VOICE_BUS_DIRECT,                         // Neither ducks nor is ducked (default)
+  VOICE_BUS_KEY,                            // Announcements: dips the ducked bus, as the main sample does
+  VOICE_BUS_DUCKED                          // Background: dips under the key bus
+} VoiceBus_TypeDef;
+#endif
 
-/* Audio channel identifier */
+#if AUDIO_ENGINE_ENABLE_VOICE_MOD
+/* What drives a voice modulator.  The LFOs swing from -1 to 1 and start at 0 (the square at 1);
+ * the envelope rises from 0 to 1 and holds its sustain until AudioEngine_ReleaseVoice(). */
 typedef enum {
-  CHANNEL_LEFT = 0U,
-  CHANNEL_RIGHT = 1U,
-  CHANNEL_COUNT = 2U
-} AudioChannelId;
+  VOICE_MOD_OFF,
+  VOICE_MOD_SINE,
+  VOICE_MOD_TRIANGLE,
+  VOICE_MOD_SQUARE,
+  VOICE_MOD_ENVELOPE
+} VoiceModSource_TypeDef;
 
-/* Low-pass filter aggressiveness type */
+/* What a voice modulator moves.  Modulators on the same target add up, gains multiply. */
 typedef enum {
-  LPF_Off,
-  LPF_VerySoft,
-  LPF_Soft,
-  LPF_Medium,
-  LPF_Firm,
-  LPF_Aggressive,
-  LPF_Custom
-} LPF_Level;
+  VOICE_MOD_GAIN,                           // depth: 0-32767 of the gain taken off at the modulator's low
+  VOICE_MOD_PAN,                            // depth: pan steps at the modulator's high
+  VOICE_MOD_PITCH,                          // depth: cents at the modulator's high
+  VOICE_MOD_CUTOFF                          // depth: cents of a low-pass from cutoff_hz at the modulator's high
+} VoiceModTarget_TypeDef;
 
-/* Air Effect (High-Shelf Brightening) Filter */
-#define AIR_EFFECT_SHELF_GAIN       98304     // ~1.5 in Q16 (high-frequency shelf ~ +1.6 dB)
-#define AIR_EFFECT_SHELF_GAIN_MAX   131072    // Cap runtime boost at ~2.0x to avoid harsh clipping
-#define AIR_EFFECT_CUTOFF           49152     // ~0.75 alpha (cutoff around 5-6 kHz @ 22kHz)
+/* One modulator of a voice */
+typedef struct {
+  uint8_t   source;                         // VoiceModSource_TypeDef
+  uint8_t   target;                         // VoiceModTarget_TypeDef
+  int16_t   depth;                          // As the target has it; negative turns the modulator over
+  uint16_t  rate_chz;                       // LFO rate, hundredths of a hertz
+  uint16_t  attack_ms;                      // Envelope rise to 1
+  uint16_t  decay_ms;                       // Envelope fall from 1 to the sustain level
+  uint16_t  sustain;                        // Envelope level held until the release, 0-65535
+  uint16_t  release_ms;                     // Envelope fall from 1 to 0
+  uint16_t  cutoff_hz;                      // VOICE_MOD_CUTOFF: the low-pass cutoff at the modulator's 0
+} AudioEngine_VoiceMod;
+#endif
 
-/* Filter chain runtime configuration */
+#if AUDIO_ENGINE_ENABLE_SYNTH
+/* Carrier waveforms of a synthesised score.  All but the sine come from band-limited
+ * wavetables, one per octave, so high notes do not alias. */
+typedef enum {
+  SYNTH_WAVE_SINE,
+  SYNTH_WAVE_SAW,
+  SYNTH_WAVE_SQUARE,
+  SYNTH_WAVE_TRIANGLE
+} AudioEngine_SynthWave;
+
+/* Instrument of a synthesised score: a carrier phase-modulated by a sine at a fixed ratio
+ * (2-operator FM), shaped by an ADSR envelope.  The modulation index follows the envelope,
+ * so a struck tone starts bright and mellows as it decays; an index of 0 leaves the plain
+ * waveform, a sine for pure tones.  Decay and release times are to fall 60 dB. */
 typedef struct {
-  uint8_t enable_16bit_biquad_lpf;            // Biquad low-pass filter for 16-bit samples
-  uint8_t enable_soft_dc_filter_16bit;        // Soft DC blocking filter for 16-bit samples
-  uint8_t enable_8bit_lpf;                    // Biquad low-pass filter for 8-bit samples
-  uint8_t enable_noise_gate;                  // Noise gate. Removes low-level noise.
-  uint8_t enable_soft_clipping;               // Soft clipping.
-  uint8_t enable_air_effect;                  // High-shelf brightening filter
-  uint32_t lpf_makeup_gain_q16;               // Q16 gain applied after LPF
-  uint32_t lpf_makeup_gain_16bit_q16;         // Q16 gain applied after 16-bit LPF
-  LPF_Level lpf_16bit_level;                  // Filter level for 16-bit biquad LPF
-  uint16_t lpf_16bit_custom_alpha;            // Q16 alpha for custom 16-bit LPF
-  LPF_Level lpf_8bit_level;                   // Filter level for 8-bit LPF
-  uint16_t lpf_8bit_custom_alpha;             // Q16 alpha for custom 8-bit LPF
-  uint8_t enable_filter_chain_16bit;          // Master enable for entire 16-bit filter chain
-  uint8_t enable_filter_chain_8bit;           // Master enable for entire 8-bit filter chain
-} FilterConfig_TypeDef;
+  uint16_t  ratio;                          // Modulator frequency over the carrier's, Q8.8 (256 = unison)
+  uint16_t  index;                          // Modulation index at the envelope peak, radians, Q8.8
+  uint16_t  attack_ms;                      // Rise to the peak
+  uint16_t  decay_ms;                       // Fall from the peak towards the sustain level
+  uint16_t  sustain;                        // Level held while the note is down, 0-65535 of the peak
+  uint16_t  release_ms;                     // Fall once the note's length has run
+  uint8_t   wave;                           // AudioEngine_SynthWave of the carrier
+} AudioEngine_SynthPatch;
 
-/* Global audio engine state exposed for hardware initialization */
-extern uint32_t I2S_PlaybackSpeed;
+/* One note of a score */
+typedef struct {
+  uint16_t  start_ms;                       // From the start of the score; notes are in start order
+  uint16_t  length_ms;                      // From the start to the release
+  uint16_t  pitch;                          // Cents above MIDI note 0 (8.18 Hz): A4 (440 Hz) is 6900
+  uint16_t  level;                          // 0-65535
+} AudioEngine_SynthNote;
 
-/* Hardware interface function pointer types */
-typedef void        ( *DAC_SwitchFunc )         ( GPIO_PinState setting );
-typedef uint16_t    ( *ReadVolumeFunc )         ( void );
-typedef void        ( *I2S_InitFunc )           ( void );
-typedef void        ( *PlaybackEndCallback )    ( void );
+/* A chime as a few bytes of notes rather than a recording */
+typedef struct {
+  const AudioEngine_SynthPatch *patch;
+  const AudioEngine_SynthNote  *notes;
+  uint16_t                      note_count;
+} AudioEngine_Score;
+#endif
 
-extern DAC_SwitchFunc AudioEngine_DACSwitch;
-extern ReadVolumeFunc AudioEngine_ReadVolume;
-extern I2S_InitFunc   AudioEngine_I2SInit;
+#if AUDIO_ENGINE_ENABLE_SAMPLER
+/* One recorded note of an instrument and the keys it plays */
+typedef struct {
+  const AudioAsset *sample;                 // PCM16 or PCM8; its loop region, if any, sustains the note
+  uint8_t           lo_key;                 // Lowest MIDI note of the zone
+  uint8_t           hi_key;                 // Highest MIDI note of the zone
+  uint8_t           root_key;               // MIDI note the sample was recorded at
+  int8_t            tune_cents;             // Correction to the recording's pitch
+} AudioEngine_SamplerZone;
+
+/* A note library: zones searched in order, the first covering the key plays it */
+typedef struct {
+  const AudioEngine_SamplerZone *zones;
+  uint8_t           zone_count;
+  uint8_t           priority;               // Of its voices, as for AudioEngine_PlayVoice()
+  uint16_t          release_ms;             // Fade after the key is let go, 0 to play the sample out
+} AudioEngine_Instrument;
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SEQUENCER
+/* Sequencer instructions.  A script is an array of bytes, each opcode followed by its operands
+ * as listed, multi-byte ones little-endian.  slot is a sequencer voice, 0 to
+ * AUDIO_ENGINE_SEQUENCER_VOICES - 1, and a jump offset counts from the next instruction. */
+typedef enum {
+  SEQ_OP_END        = 0x00,                 // End of the script; its voices play on
+  SEQ_OP_PLAY       = 0x01,                 // slot, sound, gain (u16), pan (s8): start a sound of the table on the slot, over what it plays
+  SEQ_OP_WAIT       = 0x02,                 // frames (u32) at the stream's rate
+  SEQ_OP_WAIT_MS    = 0x03,                 // ms (u16)
+  SEQ_OP_WAIT_VOICE = 0x04,                 // slot: until the slot's sound has ended
+  SEQ_OP_NOTE       = 0x05,                 // slot, note, velocity: play a note of the instrument on the slot (AUDIO_ENGINE_ENABLE_SAMPLER)
+  SEQ_OP_GAIN       = 0x10,                 // slot, gain (u16), ramped over the next period
+  SEQ_OP_FADE       = 0x11,                 // slot, gain (u16), ms (u16): glide the gain there in a straight line
+  SEQ_OP_PAN        = 0x12,                 // slot, pan (s8)
+  SEQ_OP_PITCH      = 0x13,                 // slot, cents (s16) from the recorded pitch
+  SEQ_OP_STOP       = 0x14,                 // slot: ramp to silence over the next period
+  SEQ_OP_RELEASE    = 0x15,                 // slot: let go of the slot's note (AUDIO_ENGINE_ENABLE_SAMPLER)
+  SEQ_OP_LOOP       = 0x20,                 // count: run up to the matching SEQ_OP_NEXT count times, 0 for ever
+  SEQ_OP_NEXT       = 0x21,
+  SEQ_OP_JUMP       = 0x22,                 // offset (s16)
+  SEQ_OP_BRANCH     = 0x23                  // mask, value, offset (s16): jump when ( input & mask ) == value
+} AudioEngine_SeqOp;
+
+/* Reads the inputs SEQ_OP_BRANCH tests, such as the OPT pads' GPIO input register.  Called
+ * from the render interrupt, so it must be quick and must not block. */
+typedef uint32_t ( *AudioEngine_SeqInputFunc ) ( void );
+
+/* A script with the sounds it plays */
+typedef struct {
+  const uint8_t                *code;
+  uint32_t                      length;     // Bytes
+  const AudioAsset * const     *sounds;     // PCM16 or PCM8 assets, by SEQ_OP_PLAY's sound number
+  uint8_t                       sound_count;
+  AudioEngine_SeqInputFunc      read_input; // For SEQ_OP_BRANCH, or NULL to read 0
+#if AUDIO_ENGINE_ENABLE_SAMPLER
+  const AudioEngine_Instrument *instrument; // For SEQ_OP_NOTE, or NULL
+#endif
+} AudioEngine_Sequence;
+#endif
 
 /**
- * @brief Weak callback invoked when playback ends naturally or via stop
- * @note Define this function in your application to receive playback end notifications
- * @note Called from ISR context - keep implementation short and non-blocking
+ * @brief Start a sample on a free mixer voice, over whatever else is playing
+ * @param[in] sample_to_play Pointer to sample data in memory
+ * @param[in] sample_set_sz Total number of samples to play (all channels combined)
+ * @param[in] playback_speed Sample rate of the data in Hz, up to 8x the stream's rate
+ * @param[in] sample_depth Bits per sample: 8 or 16
+ * @param[in] mode Playback mode: Mode_mono or Mode_stereo
+ * @param[in] gain 0-65535 where 65535 is full level; the volume control applies as well
+ * @param[in] pan -127 (left) to 127 (right), 0 for centre.  Mono sources follow a constant-power
+ *            law (3 dB down on each side at the centre); for stereo sources it is a balance.
+ * @param[in] priority Higher is more important; a busy pool may give up a voice of no higher
+ *            priority, which fades out in about 1.5 ms as the new sound starts
+ * @param[in] pitch Playback rate, Q16.16: AUDIO_ENGINE_PITCH_UNITY for the recorded pitch,
+ *            twice that an octave up (see AudioEngine_PitchFromCents())
+ * @return Voice number, or -1 without a stream, with no voice to use or on bad parameters
+ * @note Voices play on the output stream (AudioEngine_StartStream(), AUDIO_ENGINE_ALWAYS_ON),
+ *       start at the next period and bypass the filter chain. Any depth, mode and rate is
+ *       converted to the stream's on the fly. Stopping or restarting the stream drops them.
+ *       The source is read at up to 8x the stream's rate; a higher pitch is held there.
  */
-void AudioEngine_OnPlaybackEnd( void );
+int8_t               AudioEngine_PlayVoice            (
+                                                        const void *sample_to_play,
+                                                        uint32_t sample_set_sz,
+                                                        uint32_t playback_speed,
+                                                        uint8_t sample_depth,
+                                                        PB_ModeTypeDef mode,
+                                                        uint16_t gain,
+                                                        int8_t pan,
+                                                        uint8_t priority,
+                                                        uint32_t pitch
+                                                      );
 
 /**
- * @brief Initialize the audio engine with hardware interface callbacks
- * @param[in] dac_switch   Function to control DAC amplifier power (GPIO)
- * @param[in] read_volume  Function to read current volume setting (0-255)
- * @param[in] i2s_init     Function to initialize I2S peripheral
- * @return PB_Idle on success, PB_Error on failure
+ * @brief Start a PCM asset on a free mixer voice at the next period, from any context
+ * @param[in] asset PCM16 or PCM8 asset, at up to 8x the stream's rate
+ * @param[in] gain 0-65535 where 65535 is full level; the volume control applies as well
+ * @param[in] pan -127 (left) to 127 (right), 0 for centre
+ * @param[in] priority As for AudioEngine_PlayVoice()
+ * @return PB_Idle when queued; PB_Error without a stream, for another encoding or with eight
+ *         starts already waiting
+ * @note May be called from an interrupt, a trigger input's for one: the start is queued and the
+ *       render takes it as it renders the next period, so the sound leaves the DAC at most a
+ *       ring (AudioEngine_GetBufferGeometry()) later. No voice number comes back; a start
+ *       with no voice to take is dropped as AudioEngine_PlayVoice() would refuse it.
+ */
+PB_StatusTypeDef     AudioEngine_TriggerVoice         ( const AudioAsset *asset, uint16_t gain, int8_t pan, uint8_t priority );
+
+#if AUDIO_ENGINE_ENABLE_SYNTH
+/**
+ * @brief Synthesise a score on a free mixer voice
+ * @param[in] score Patch and notes; must stay valid while the voice plays
+ * @param[in] gain 0-65535 where 65535 is full level; the volume control applies as well
+ * @param[in] pan -127 (left) to 127 (right), 0 for centre
+ * @param[in] priority As for AudioEngine_PlayVoice()
+ * @return Voice number, or -1 without a stream, with no voice to use or on bad parameters
+ * @note The voice takes gain, pan, send and stop calls like any other, and
+ *       AudioEngine_SetVoicePitch() transposes the score. It frees itself once the last note
+ *       has released. Application context: the envelope rates are worked out here.
+ */
+int8_t               AudioEngine_PlayScore            ( const AudioEngine_Score *score, uint16_t gain, int8_t pan, uint8_t priority );
+#endif
+
+/**
+ * @brief Choose which voice a start may take when every voice is busy
+ * @param[in] mode VOICE_STEAL_NONE, VOICE_STEAL_OLDEST, VOICE_STEAL_QUIETEST or
+ *            VOICE_STEAL_LOWEST_PRIORITY (default); a voice of higher priority is never taken
+ * @note A voice number held for the stolen sound then refers to the new one.
+ */
+void                 AudioEngine_SetVoiceStealing     ( VoiceSteal_TypeDef mode );
+
+/**
+ * @brief Get the voice stealing policy
+ * @return Current VoiceSteal_TypeDef policy
+ */
+VoiceSteal_TypeDef   AudioEngine_GetVoiceStealing     ( void );
+
+/**
+ * @brief Set the gain of a mixer voice, ramped over the next period
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @param[in] gain 0-65535 where 65535 is full level
+ */
+void                 AudioEngine_SetVoiceGain         ( uint8_t voice, uint16_t gain );
+
+/**
+ * @brief Set the pan of a mixer voice, ramped over the next period
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @param[in] pan -127 (left) to 127 (right), 0 for centre
+ */
+void                 AudioEngine_SetVoicePan          ( uint8_t voice, int8_t pan );
+
+/**
+ * @brief Set the stereo width of a mixer voice, ramped over the next period
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @param[in] width 0 folds the voice to mono, AUDIO_ENGINE_VOICE_WIDTH_UNITY (the default at
+ *            each start) plays it as recorded and up to AUDIO_ENGINE_VOICE_WIDTH_MAX widens it
+ * @note The mid (L + R) / 2 is kept and the side (L - R) / 2 scaled. Mono voices and scores
+ *       have no side and are unaffected.
+ */
+void                 AudioEngine_SetVoiceWidth        ( uint8_t voice, uint16_t width );
+
+/**
+ * @brief Set the playback rate of a mixer voice from the next period, for glides and vibrato
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @param[in] pitch Playback rate, Q16.16, AUDIO_ENGINE_PITCH_UNITY for the recorded pitch; 0 is ignored
+ */
+void                 AudioEngine_SetVoicePitch        ( uint8_t voice, uint32_t pitch );
+
+/**
+ * @brief Convert an interval to a voice playback rate, so one sample can play a scale
+ * @param[in] cents Interval from the recorded pitch, 100 per equal-tempered semitone
+ * @return Playback rate, Q16.16, for AudioEngine_PlayVoice() or AudioEngine_SetVoicePitch()
+ */
+uint32_t             AudioEngine_PitchFromCents       ( int32_t cents );
+
+#if AUDIO_ENGINE_ENABLE_TIME_STRETCH
+/**
+ * @brief Play a mixer voice faster or slower without changing its pitch, from the next period
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @param[in] tempo Q16.16: AUDIO_ENGINE_TEMPO_UNITY as recorded, twice that in half the time;
+ *            held to AUDIO_ENGINE_TEMPO_MIN-AUDIO_ENGINE_TEMPO_MAX
+ * @note Set it straight after AudioEngine_PlayVoice() to stretch the whole sound. A voice once
+ *       stretched stays on the WSOLA path, which at unity plays the sample unchanged. The pitch
+ *       still applies, and scores ignore the tempo.
+ */
+void                 AudioEngine_SetVoiceTempo        ( uint8_t voice, uint32_t tempo );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_VOICE_MOD
+/**
+ * @brief Set a modulator of a mixer voice, from the next period
+ * @param[in] voice Voice number from AudioEngine_PlayVoice(); the sequencer's voices take none
+ * @param[in] slot Modulator, 0 to AUDIO_ENGINE_VOICE_MODS - 1
+ * @param[in] mod Source, target and times, copied; NULL or VOICE_MOD_OFF removes it
+ * @return PB_Idle on success, PB_Error for a voice, slot, source or target out of range
+ * @note The modulator starts from its beginning: an LFO at phase 0, an envelope at 0. Voices
+ *       start with none, so set them straight after the start. A voice whose gain envelope
+ *       has released to 0 frees itself.
+ */
+PB_StatusTypeDef     AudioEngine_SetVoiceMod          ( uint8_t voice, uint8_t slot, const AudioEngine_VoiceMod *mod );
+
+/**
+ * @brief Move the envelopes of a mixer voice to their release, from the next period
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @note A sampler note's envelopes release with AudioEngine_NoteOff() as well.
+ */
+void                 AudioEngine_ReleaseVoice         ( uint8_t voice );
+#endif
+
+/**
+ * @brief Stop a mixer voice, ramping it to silence over the next period
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ */
+void                 AudioEngine_StopVoice            ( uint8_t voice );
+
+/**
+ * @brief Check whether a mixer voice is still playing
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @return 1 while it plays or is about to start, 0 once the voice is free
+ */
+uint8_t              AudioEngine_VoiceActive          ( uint8_t voice );
+
+#if AUDIO_ENGINE_ENABLE_DUCKER
+/**
+ * @brief Route a mixer voice to a bus of the ducker
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @param[in] bus VOICE_BUS_DIRECT (the default at each start), VOICE_BUS_KEY or VOICE_BUS_DUCKED
+ */
+void                 AudioEngine_SetVoiceBus          ( uint8_t voice, VoiceBus_TypeDef bus );
+
+/**
+ * @brief Set the ducker, which dips the VOICE_BUS_DUCKED voices while the key bus plays
+ * @param[in] depth Ducked bus level under a key at full level, 0-65535; 65535 (default) turns
+ *            the ducker off
+ * @param[in] attack_ms Time for the ducked bus to fall all the way, 0 for the next period
+ * @param[in] release_ms Time for it to rise all the way back once the key ends
+ * @note The key bus is the main sample, at the level of its fades, and the VOICE_BUS_KEY voices
+ *       at their gains, whichever is highest. The ducker follows it once a period, and each
+ *       ducked voice ramps to the new level across the period like any gain change, so the
+ *       application need not poll or set volumes around an announcement.
+ */
+void                 AudioEngine_SetDucker            ( uint16_t depth, uint16_t attack_ms, uint16_t release_ms );
+
+/**
+ * @brief Get the level the ducker holds the ducked bus at
+ * @return 0-65535, 65535 while nothing ducks it
+ */
+uint16_t             AudioEngine_GetDuckLevel         ( void );
+#endif
+
+#if AUDIO_ENGINE_REVERB_RAM_BYTES > 0
+/**
+ * @brief Set how much of a mixer voice feeds the reverb
+ * @param[in] voice Voice number from AudioEngine_PlayVoice()
+ * @param[in] send 0-65535 where 65535 sends the voice at the level it plays; voices start at 0
+ */
+void                 AudioEngine_SetVoiceSend         ( uint8_t voice, uint16_t send );
+
+/**
+ * @brief Set the reverb on the mixer's send bus
+ * @param[in] decay 0-65535, from a small room to a long hall
+ * @param[in] damping 0-65535, how much faster the highs die away than the lows
+ * @param[in] level 0-65535 wet level added to the mix; 0 (default) turns the reverb off
+ * @note The tail rings on after the voices that fed it end, and the mix limiter holds the sum.
+ */
+void                 AudioEngine_SetReverb            ( uint16_t decay, uint16_t damping, uint16_t level );
+
+/**
+ * @brief Get the reverb settings
+ * @param[out] decay Receives the decay, 0-65535 (may be NULL)
+ * @param[out] damping Receives the damping, 0-65535 (may be NULL)
+ * @param[out] level Receives the wet level, 0-65535 (may be NULL)
+ */
+void                 AudioEngine_GetReverb            ( uint16_t *decay, uint16_t *damping, uint16_t *level );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_SAMPLER
+/**
+ * @brief Choose the instrument AudioEngine_NoteOn() plays
+ * @param[in] instrument Zones and release; must stay valid while its notes play
+ * @return PB_Idle on success, PB_Error if a zone's sample is not PCM16 or PCM8, its keys are
+ *         out of order or its loop region lies outside the sample
+ */
+PB_StatusTypeDef     AudioEngine_SetInstrument        ( const AudioEngine_Instrument *instrument );
+
+/**
+ * @brief Play a note of the instrument on a free mixer voice
+ * @param[in] note MIDI note, 60 for middle C
+ * @param[in] velocity 1-127; the gain follows its square
+ * @return Voice number, or -1 without a stream or instrument, with no zone for the note, a
+ *         velocity out of range or no voice to use
+ * @note The zone's sample is repitched from its root key by the voice's playback rate, and
+ *       AudioEngine_SetVoicePitch() bends it from there. Its loop region repeats until the
+ *       note is let go.
+ */
+int8_t               AudioEngine_NoteOn               ( uint8_t note, uint8_t velocity );
+
+/**
+ * @brief Let go of every voice playing a note
+ * @param[in] note MIDI note given to AudioEngine_NoteOn()
+ * @note Each voice leaves its loop at the next period and plays on to the end of its sample,
+ *       fading over the instrument's release_ms if it has one.
+ */
+void                 AudioEngine_NoteOff              ( uint8_t note );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_STREAM_VOICE
+/**
+ * @brief Start a mixer voice that plays the frames written with AudioEngine_Write()
+ * @param[in] playback_speed Rate of the frames in Hz, up to the stream's rate
+ * @param[in] mode Mode_mono or Mode_stereo, as the frames written
+ * @param[in] gain 0-65535 where 65535 is full level; the volume control applies as well
+ * @param[in] pan -127 (left) to 127 (right), 0 for centre
+ * @param[in] priority As for AudioEngine_PlayVoice()
+ * @return Voice number, or -1 without a stream, with a streamed voice already playing, with no
+ *         voice to use or on bad parameters
+ * @note The ring starts empty, and the voice plays silence until a period's worth is written,
+ *       and again after it runs dry. It takes gain, pan, send and stop calls like any other
+ *       voice; its pitch and tempo stay as written. It plays until AudioEngine_StopVoice(), or
+ *       until AudioEngine_EndStreamVoice() and the ring has played out.
+ */
+int8_t               AudioEngine_PlayStreamVoice      ( uint32_t playback_speed, PB_ModeTypeDef mode, uint16_t gain, int8_t pan, uint8_t priority );
+
+/**
+ * @brief Write frames into the streamed voice's ring
+ * @param[in] samples 16-bit samples, interleaved left and right for stereo
+ * @param[in] frames Frames in samples
+ * @return Frames taken; fewer when the ring is full, none while no streamed voice plays
+ * @note One producer: the application, an interrupt or AudioEngine_OnStreamVoiceLow(), not
+ *       more than one of them. The render context is the only consumer.
+ */
+uint32_t             AudioEngine_Write                ( const int16_t *samples, uint32_t frames );
+
+/**
+ * @brief Get the frames AudioEngine_Write() would take now
+ * @return Free frames in the ring, 0 while no streamed voice plays
+ */
+uint32_t             AudioEngine_GetWritableFrames    ( void );
+
+/**
+ * @brief Let the streamed voice play out what has been written, then end
+ * @note Frames written after this still play if the voice has not ended by then.
+ */
+void                 AudioEngine_EndStreamVoice       ( void );
+
+/**
+ * @brief Set the fill at which AudioEngine_OnStreamVoiceLow() is called
+ * @param[in] frames Frames left in the ring; AUDIO_ENGINE_STREAM_VOICE_FRAMES / 2 by default
  */
-PB_StatusTypeDef    AudioEngine_Init                  (
-                                                        DAC_SwitchFunc dac_switch,
-                                                        ReadVolumeFunc read_volume,
-                                                        I2S_InitFunc i2s_init
-                                                      );
+void                 AudioEngine_SetStreamVoiceLowWater ( uint32_t frames );
 
-/* Filter configuration functions */
 /**
- * @brief Apply a complete filter configuration to the audio engine
- * @param[in] cfg Pointer to FilterConfig_TypeDef with desired settings
- * @note All filter settings in cfg are applied atomically
+ * @brief Get the number of times the streamed voice ran dry
+ * @return Underruns since AudioEngine_PlayStreamVoice(), each a gap of silence while the ring refills
  */
-void                SetFilterConfig                   ( const FilterConfig_TypeDef *cfg );
+uint32_t             AudioEngine_GetStreamVoiceUnderruns ( void );
 
 /**
- * @brief Read current filter configuration from the audio engine
- * @param[out] cfg Pointer to FilterConfig_TypeDef to receive current settings
+ * @brief Called when the streamed voice's ring falls to the low-water mark (weak, override in application)
+ * @param[in] frames Frames left in the ring
+ * @note Called from the render context once each time the ring falls to the mark, and not
+ *       again until writes have taken it back above. Keep it short: AudioEngine_Write() from
+ *       here, or signal the producer.
  */
-void                GetFilterConfig                   ( FilterConfig_TypeDef *cfg );
+void                 AudioEngine_OnStreamVoiceLow     ( uint32_t frames );
+#endif
 
+#if AUDIO_ENGINE_ENABLE_SEQUENCER
 /**
- * @brief Set makeup gain applied after 8-bit low-pass filter
- * @param[in] gain Linear gain (1.0 = no gain, 2.0 = 2x, etc.)
- * @note Compensates for attenuation from aggressive filtering
+ * @brief Run a chime script on the sequencer's voices, from the next period
+ * @param[in] sequence Script and sound table; must stay valid while the script runs
+ * @return PB_Idle once handed over, PB_Error without a stream or if the script does not check
+ *         out: an unknown opcode, a slot, sound or jump out of range, unbalanced loops, a
+ *         sound that is not PCM16 or PCM8 or is more than 8x the stream's rate, or a note the
+ *         sequence's instrument has no zone for
+ * @note The render runs the script once per period, so it keeps time while the application
+ *       sleeps. Starts and waits are to the frame: a sound starts on the frame its wait ends,
+ *       within the period. Gain, pan, pitch and stops take effect per period, and
+ *       SEQ_OP_WAIT_VOICE resumes at the period after the sound ends. A script already running
+ *       is replaced, and the voices it started are ramped out.
  */
-void                SetLpfMakeupGain8Bit              ( float gain );
+PB_StatusTypeDef     AudioEngine_RunSequence          ( const AudioEngine_Sequence *sequence );
 
 /**
- * @brief Set makeup gain applied after 16-bit low-pass filter
- * @param[in] gain Linear gain (1.0 = no gain, 2.0 = 2x, etc.)
- * @note Compensates for attenuation from aggressive filtering
+ * @brief Stop the script and ramp out its voices at the next period
  */
-void                SetLpfMakeupGain16Bit             ( float gain );
+void                 AudioEngine_StopSequence         ( void );
 
 /**
- * @brief Get makeup gain applied after 16-bit low-pass filter
- * @return Linear gain (1.0 = no gain, 2.0 = 2x, etc.)
+ * @brief Check whether a script is running
+ * @return 1 until it reaches SEQ_OP_END or is stopped, 0 after
  */
-float               GetLpfMakeupGain16Bit             ( void );
+uint8_t              AudioEngine_SequenceRunning      ( void );
+#endif
+#endif
 
+#if AUDIO_ENGINE_ENABLE_PROFILING
+/* Profiling */
 /**
- * @brief Enable/disable the high-shelf air effect brightening filter
- * @param[in] enabled 1 to enable, 0 to disable
- * @note Air effect is automatically controlled by SetAirEffectPresetDb()
+ * @brief Take a snapshot of the profiling statistics
+ * @param[out] profile Filled with per-stage cycles and the load against the buffer period
  */
-void                SetAirEffectEnable                ( uint8_t enabled );
+void                 AudioEngine_GetProfile           ( AudioEngine_Profile *profile );
 
 /**
- * @brief Read current air effect enable state
- * @return 1 if enabled, 0 if disabled
+ * @brief Clear the profiling statistics
  */
-uint8_t             GetAirEffectEnable                ( void );
+void                 AudioEngine_ResetProfile         ( void );
 
 /**
- * @brief Enable/disable soft clipping cubic curve above ±28,000
- * @param[in] enabled 1 to enable, 0 to disable
+ * @brief Time one DSP stage or chunk processor over fixed test vectors, with nothing playing
+ * @param[in] stage Stage to time
+ * @param[in] periods Number of timed runs over one DMA period; every other run uses quieter
+ *            data, down to silence, with the fades held
+ * @param[out] result Average cycles per period and per source sample on the full-scale runs,
+ *             and the fewest and most cycles of any run
+ * @retval 1 if timed, 0 if playing, periods is 0 or the stage is not built
  */
-void                SetSoftClippingEnable             ( uint8_t enabled );
+uint8_t              AudioEngine_Benchmark            ( AudioEngine_BenchStage stage, uint32_t periods,
+                                                        AudioEngine_BenchResult *result );
 
 /**
- * @brief Read current soft clipping enable state
- * @return 1 if enabled, 0 if disabled
+ * @brief Get the short name of a benchmark stage, for reports
  */
-uint8_t             GetSoftClippingEnable             ( void );
+const char          *AudioEngine_BenchStageName       ( AudioEngine_BenchStage stage );
 
-/* 8-bit sample low-pass filter configuration */
 /**
- * @brief Set the aggressiveness level of the 8-bit low-pass filter
- * @param[in] level One of: LPF_Off, LPF_VerySoft, LPF_Soft, LPF_Medium, LPF_Firm, LPF_Aggressive, LPF_Custom
- * @note Custom alpha can be set separately via SetLpf8BitCustomAlpha()
+ * @brief Time the 16-bit filter chain on a test block, with nothing playing
+ * @param[in] periods Number of timed runs over one stereo period
+ * @retval Average cycles per period, 0 if playing or periods is 0
  */
-void                SetLpf8BitLevel                   ( LPF_Level level );
+uint32_t             AudioEngine_BenchmarkFilterChain ( uint32_t periods );
 
+#if AUDIO_ENGINE_ENABLE_PERIOD_CALIBRATION
 /**
- * @brief Get the current aggressiveness level of the 8-bit low-pass filter
- * @return Current LPF_Level (Off, VerySoft, Soft, Medium, Firm, Aggressive, or Custom)
+ * @brief Set the smallest period the render holds on this core, timed with the current chain
+ * @param[in] rate Output rate the period must hold, in Hz
+ * @param[out] result Chosen geometry and the times it was judged on (may be NULL)
+ * @return PB_Idle once set, PB_Error if playing, a stream is running or rate is 0
+ * @note AudioEngine_Init() runs it for AUDIO_ENGINE_PERIOD_CAL_RATE with the default filter
+ *       configuration; run it again after setting up the product's chain. The period count
+ *       stays as set by AudioEngine_SetBufferGeometry(). Takes a few milliseconds. Mixer
+ *       voices and decoded formats are not timed and come out of the budget's margin.
  */
-LPF_Level           GetLpf8BitLevel                   ( void );
+PB_StatusTypeDef     AudioEngine_CalibratePeriod      ( uint32_t rate, AudioEngine_PeriodCalibration *result );
 
 /**
- * @brief Set a custom alpha coefficient for the 8-bit low-pass filter
- * @param[in] alpha Q16 fixed-point alpha value (0-65535), where 65535 = 0.99999, 32768 = 0.5
- * @note This sets level to LPF_Custom and uses the provided alpha directly
+ * @brief Get the result of the last period calibration
+ * @param[out] result Chosen geometry and the times it was judged on; rate 0 if none has run
  */
-void                SetLpf8BitCustomAlpha             ( uint16_t alpha );
+void                 AudioEngine_GetPeriodCalibration ( AudioEngine_PeriodCalibration *result );
+#endif
+#endif
+
+#if AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR
+/* Render deadline statistics returned by AudioEngine_GetDeadlineStats() */
+typedef struct {
+  uint32_t periods;                           // Periods checked
+  uint32_t underruns;                         // Periods the I2S started reading before they were rendered
+  uint32_t min_slack_frames;                  // Least frames left before a period was due, 0 after an underrun
+  uint32_t min_slack_us;                      // The same in microseconds at the current rate
+  uint32_t last_underrun_frame;               // AudioEngine_GetFrameCount() at the last underrun
+  uint32_t concealed;                         // Periods left unrendered and faded out (AUDIO_ENGINE_ENABLE_UNDERRUN_CONCEAL)
+} AudioEngine_DeadlineStats;
 
+/* Render deadline monitor */
 /**
- * @brief Get the current custom alpha coefficient for the 8-bit low-pass filter
- * @return Q16 fixed-point alpha value
+ * @brief Take a snapshot of the render deadline statistics
+ * @param[out] stats Periods checked, underruns and the least slack since the last reset
+ * @note An underrun is a period the I2S started to read before the render had finished it,
+ *       heard as a glitch. A slack that keeps shrinking warns of a configuration near the limit.
  */
-uint16_t            GetLpf8BitCustomAlpha             ( void );
+void                 AudioEngine_GetDeadlineStats     ( AudioEngine_DeadlineStats *stats );
 
-/* 16-bit sample low-pass filter configuration */
 /**
- * @brief Set the aggressiveness level of the 16-bit biquad low-pass filter
- * @param[in] level One of: LPF_Off, LPF_VerySoft, LPF_Soft, LPF_Medium, LPF_Firm, LPF_Aggressive, LPF_Custom
+ * @brief Clear the render deadline statistics
  */
-void                SetLpf16BitLevel                  ( LPF_Level level );
+void                 AudioEngine_ResetDeadlineStats   ( void );
 
 /**
- * @brief Set a custom alpha coefficient for the 16-bit low-pass filter
- * @param[in] alpha Q16 fixed-point alpha value (0-65535), where 65535 = 0.99999, 32768 = 0.5
- * @note This sets level to LPF_Custom and uses the provided alpha directly
+ * @brief Weak hook run when a period misses its deadline, such as to pulse a GPIO or LED
+ * @param[in] late_frames Frames of the period the I2S had already read
+ * @note Called from the render context - keep it short and non-blocking
  */
-void                SetLpf16BitCustomAlpha            ( uint16_t alpha );
+void                 AudioEngine_OnUnderrun           ( uint32_t late_frames );
+#endif
 
+#if AUDIO_ENGINE_ENABLE_EVENT_TRACE
+/* Kinds of event in the trace ring; the numbers are read by Docs/decode_trace.py */
+typedef enum {
+  AUDIO_TRACE_NONE,                           // Never recorded
+  AUDIO_TRACE_INIT,                           // AudioEngine_Init(); value: events recorded before it
+  AUDIO_TRACE_STATE,                          // Playback state changed; arg: the new PB_StatusTypeDef
+  AUDIO_TRACE_COMMAND,                        // Command posted; arg: command (play, stop, halt, pause, resume, ...), value: its value
+  AUDIO_TRACE_COMMAND_DROPPED,                // Command queue full; arg: the command
+  AUDIO_TRACE_UNDERRUN,                       // Render deadline missed; arg: ring period, value: frames already read
+  AUDIO_TRACE_STREAM_UNDERRUN,                // Source ran dry; arg: 0 stream, 1 push source, 2 stream voice, value: its underruns so far
+  AUDIO_TRACE_CONFIG,                         // Filter configuration taken by the render; arg: the set, value: its generation
+  AUDIO_TRACE_TRIGGER,                        // Trigger input edge; arg: level after it
+  AUDIO_TRACE_USER = 0x80                     // From here up, the application's own
+} AudioEngine_TraceType;
+
+/* One traced event */
+typedef struct {
+  uint32_t cycles;                            // DWT->CYCCNT when recorded
+  uint32_t value;                             // Meaning depends on the type
+  uint16_t seq;                               // Low 16 bits of the event's number, written last
+  uint8_t  type;                              // AudioEngine_TraceType
+  uint8_t  arg;                               // Meaning depends on the type
+} AudioEngine_TraceRecord;
+
+/* Event trace */
 /**
- * @brief Calculate Q16 alpha coefficient from desired cutoff frequency
- * @param[in] cutoff_hz Cutoff frequency in Hz
- * @param[in] sample_rate_hz Sample rate in Hz
- * @return Q16 alpha value suitable for SetLpf16BitCustomAlpha()
- * @note Formula: alpha = 2*pi*fc / sr, clamped to [0, 65535]
+ * @brief Record an event in the trace ring
+ * @param[in] type  AudioEngine_TraceType, AUDIO_TRACE_USER or above for the application's own
+ * @param[in] arg   Small argument
+ * @param[in] value Word argument
+ * @note Safe from any context, interrupts included; it takes no lock
  */
-uint16_t            CalcLpf16BitAlphaFromCutoff       ( float cutoff_hz, float sample_rate_hz );
+void                 AudioEngine_Trace                ( uint8_t type, uint8_t arg, uint32_t value );
 
 /**
- * @brief Calculate Q16 alpha coefficient for 8-bit LPF from desired cutoff frequency
- * @param[in] cutoff_hz Cutoff frequency in Hz
- * @param[in] sample_rate_hz Sample rate in Hz
- * @return Q16 alpha value suitable for SetLpf8BitCustomAlpha()
- * @note Formula: alpha = 1 - exp(-2*pi*fc / fs), clamped to [0, 65535]
+ * @brief Copy the events in the trace ring, oldest first
+ * @param[out] records     Events copied
+ * @param[in]  max_records Room in records; the newest are kept when there are more
+ * @return Events copied; a slot still being written or already overwritten is left out
+ * @note Events from before the last reset are kept unless power was lost (AUDIO_TRACE_INIT marks the reset)
  */
-uint16_t            CalcLpf8BitAlphaFromCutoff        ( float cutoff_hz, float sample_rate_hz );
+uint32_t             AudioEngine_CopyTrace            ( AudioEngine_TraceRecord *records, uint32_t max_records );
 
 /**
- * @brief Get the cutoff frequency corresponding to the current 16-bit LPF custom alpha
- * @param[in] cutoff_hz Cutoff frequency in Hz
- * @return Q16 alpha value, or 0 if not in custom mode
+ * @brief Empty the trace ring
  */
-uint16_t            GetLpf16BitCustomAlphaFromCutoff  ( float cutoff_hz );
+void                 AudioEngine_ClearTrace           ( void );
+#endif
 
-/* Fade time configuration functions */
+#if AUDIO_ENGINE_ENABLE_QUALITY_GOVERNOR
+/* Quality steps, taken in this order and given back in reverse (AudioEngine_QualityConfig) */
+#define QUALITY_STEP_AIR_EFFECT         0x01U       // Leave out the air effect
+#define QUALITY_STEP_ONE_POLE_LPF       0x02U       // Run the 16-bit biquad low-pass as a one-pole at its pole
+#define QUALITY_STEP_LINEAR_RESAMPLER   0x04U       // Linear interpolation in the bus-rate resampler
+#define QUALITY_STEP_SHED_VOICES        0x08U       // Stop a playing voice, lowest priority and oldest first
+#define QUALITY_STEPS_ALL               0x0FU
 
-/** @brief Set whether the faders are enabled or not
- *  @param[in] 1 (Enabled) or 0 (Disabled).
+/* Quality governor settings for AudioEngine_SetQualityGovernor() */
+typedef struct {
+  uint8_t  steps;                             // QUALITY_STEP_* the governor may take
+  uint8_t  degrade_slack_pct;                 // A period with less slack than this share of a period takes a step
+  uint8_t  restore_slack_pct;                 // Slack every period of a hold needs for a step to be given back
+  uint16_t hold_periods;                      // Periods in a row at restore_slack_pct before a step is given back
+} AudioEngine_QualityConfig;
+
+/* Quality governor state returned by AudioEngine_GetQualityStats() */
+typedef struct {
+  uint8_t  steps;                             // QUALITY_STEP_* in effect now
+  uint32_t degrades;                          // Steps taken
+  uint32_t restores;                          // Steps given back
+  uint32_t voices_shed;                       // Voices stopped by QUALITY_STEP_SHED_VOICES
+} AudioEngine_QualityStats;
+
+/* Adaptive quality under render overload */
+/**
+ * @brief Set which quality steps the governor may take, and its thresholds
+ * @param[in] config Settings; NULL switches the governor off. The slack shares are clamped to
+ *            100 %, the restore share to at least the degrade share, and the hold to at least 1
+ * @note Application context. Defaults: every step, a step taken below 20 % of a period to
+ *       spare, one given back after 256 periods in a row with 50 %. After a step the next
+ *       AUDIO_ENGINE_QUALITY_SETTLE_PERIODS periods are not judged, so a step shows its effect
+ *       first. Steps not built in (no air effect, no bus-rate resampler, no mixer voices) are
+ *       skipped. Each new playback starts at full quality.
  */
-void                SetFadersEnabled                  ( uint8_t fader_setting );
+void                 AudioEngine_SetQualityGovernor   ( const AudioEngine_QualityConfig *config );
 
 /**
- * @brief Get the state of whether the faders are enabled or not.
- * @return Faders enabled (1) or not (0)
+ * @brief Read the quality governor settings
+ * @param[out] config Settings as clamped, steps 0 when off
  */
-  uint8_t             GetFadersEnabled                ( void );
+void                 AudioEngine_GetQualityGovernor   ( AudioEngine_QualityConfig *config );
 
 /**
- * @brief Set the duration of fade-in ramp at playback start
- * @param[in] seconds Fade-in time in seconds (0.0-5.0 typical range)
- * @note Fade uses quadratic curve for smooth volume ramp
+ * @brief Take a snapshot of the quality governor's state
+ * @param[out] stats Steps in effect, and steps taken, given back and voices shed since the last reset
+ * @note The steps in effect are also in the ITM statistics frames (AUDIO_ENGINE_ENABLE_ITM_TELEMETRY).
  */
-void                SetFadeInTime                     ( float seconds );
+void                 AudioEngine_GetQualityStats      ( AudioEngine_QualityStats *stats );
 
 /**
- * @brief Get the current fade-in time setting
- * @return Fade-in time in seconds
+ * @brief Clear the quality governor's counters; the steps in effect stay
  */
-float               GetFadeInTime                     ( void );
+void                 AudioEngine_ResetQualityStats    ( void );
+#endif
+
+/* Engine arena use returned by AudioEngine_GetArenaStats() */
+typedef struct {
+  uint32_t size_bytes;                        // Bytes in the arena
+  uint32_t used_bytes;                        // Bytes laid out now
+  uint32_t persistent_bytes;                  // Bytes laid out by AudioEngine_Init(), kept from then on
+  uint32_t high_water_bytes;                  // Most bytes laid out at once since AudioEngine_Init()
+  uint32_t failed;                            // Allocations refused: the arena was full, or asked from an interrupt
+} AudioEngine_ArenaStats;
 
+/* Engine arena */
 /**
- * @brief Set the duration of fade-out ramp when stopping playback
- * @param[in] seconds Fade-out time in seconds (0.0-5.0 typical range)
+ * @brief Get how much of the engine arena is laid out, and the most it has been
+ * @param[out] stats Arena size, use, high-water mark and refused allocations
+ * @note Any context. The persistent part holds the speaker FIR histories and the decoded asset
+ *       cache's slots; the reverb's lines are laid out after it each time the output starts at
+ *       a new rate.
  */
-void                SetFadeOutTime                    ( float seconds );
+void                 AudioEngine_GetArenaStats        ( AudioEngine_ArenaStats *stats );
+
+#if AUDIO_ENGINE_ENABLE_STACK_MONITOR
+/* Main stack use and interrupt nesting returned by AudioEngine_GetStackStats() */
+typedef struct {
+  uint32_t high_water_bytes;                  // Most main stack used since AudioEngine_Init(), down from _estack
+  uint32_t painted_bytes;                     // Stack painted at AudioEngine_Init(), the most that can be measured
+  uint32_t reserved_bytes;                    // _Min_Stack_Size in the linker script
+  uint32_t sampled_bytes;                     // Deepest MSP at a nesting sample, down from _estack
+  uint32_t nesting_samples;                   // Nesting samples taken
+  uint8_t  max_nesting;                       // Most exceptions active at once at a sample
+  uint8_t  max_nesting_exception;             // Exception number (IRQn + 16) of the handler that saw it
+  uint8_t  exhausted;                         // 1 if the paint was used up: high_water_bytes is a lower bound
+} AudioEngine_StackStats;
 
+/* Stack monitor */
 /**
- * @brief Get the current fade-out time setting
- * @return Fade-out time in seconds
+ * @brief Measure the main stack high-water mark and get the interrupt nesting statistics
+ * @param[out] stats Stack used, painted and reserved, and the deepest nesting seen
+ * @note Scans the painted stack from the heap up, a few hundred microseconds; call it from the
+ *       main loop. Size _Min_Stack_Size from high_water_bytes after exercising every feature,
+ *       with a margin: the paint only sees the deepest path that has actually run.
  */
-float               GetFadeOutTime                    ( void );
+void                 AudioEngine_GetStackStats        ( AudioEngine_StackStats *stats );
 
 /**
- * @brief Set the duration of fade-out when pausing playback
- * @param[in] seconds Pause fade time in seconds (0.0-5.0 typical range)
- * @note Typically longer than normal fade-out for smooth pause
+ * @brief Clear the interrupt nesting statistics, such as before a playback
+ * @note The stack high-water mark is kept from AudioEngine_Init() on.
  */
-void                SetPauseFadeTime                  ( float seconds );
+void                 AudioEngine_ResetIsrNesting      ( void );
 
 /**
- * @brief Get the current pause fade time setting
- * @return Pause fade time in seconds
+ * @brief Count the exceptions active now and record the deepest nesting and MSP
+ * @note The render samples itself; call at the top of the other handlers, such as the ADC and
+ *       EXTI, so a nest that only forms inside them is seen too.
  */
-float               GetPauseFadeTime                  ( void );
+void                 AudioEngine_SampleIsrNesting     ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_LATENCY_PROBE
+/* Trigger latency of the last playback returned by AudioEngine_GetLatencyStats(), from the edge */
+typedef struct {
+  uint32_t play_us;                           // To PlaySample(), 0 when it ran before the edge (primed)
+  uint32_t start_us;                          // To the output DMA start: the first frame leaves for the DAC
+  uint32_t first_half_us;                     // To the first DMA half-complete interrupt
+  uint32_t max_start_us;                      // Longest start_us since the last reset
+  uint32_t max_first_half_us;                 // Longest first_half_us since the last reset
+  uint32_t triggers;                          // Triggers measured through to the half-complete
+  uint32_t stale;                             // Edges dropped as older than AUDIO_ENGINE_LATENCY_LIMIT_MS
+} AudioEngine_LatencyStats;
 
+/* Trigger latency probe */
 /**
- * @brief Set the duration of fade-in ramp when resuming from pause
- * @param[in] seconds Resume fade time in seconds (0.0-5.0 typical range)
+ * @brief Timestamp the trigger input edge
+ * @note Call from the trigger's EXTI handler. A later edge replaces the mark until the output
+ *       DMA starts, so mark only while the trigger is not yet taken, not on its bounces.
  */
-void                SetResumeFadeTime                 ( float seconds );
+void                 AudioEngine_MarkTrigger          ( void );
 
 /**
- * @brief Get the current resume fade time setting
- * @return Resume fade time in seconds
+ * @brief Get the latency of the last triggered playback and the longest since the reset
+ * @param[out] stats Edge to PlaySample(), to the DMA start and to the first half-complete
+ * @note start_us is the latency heard. The first half-complete comes half a ring later and
+ *       shows the DMA ran. Cycles are converted at the clock the half-complete ran at, so
+ *       time spent on the low power clock after a wake from sleep reads short.
  */
-float               GetResumeFadeTime                 ( void );
+void                 AudioEngine_GetLatencyStats      ( AudioEngine_LatencyStats *stats );
 
-/* Playback control functions */
 /**
- * @brief Calculate a sample offset from time, sample rate, and mode
- * @param[in] seconds Desired offset in seconds (>= 0)
- * @param[in] sample_rate_hz Sample rate in Hz
- * @param[in] mode Playback mode: Mode_mono or Mode_stereo
- * @return Sample offset in interleaved samples
- * @note For stereo, the returned value is multiplied by 2 (left+right).
+ * @brief Clear the trigger latency statistics
  */
-uint32_t            CalcSampleOffsetSamples           (
-                                                        float seconds,
-                                                        uint32_t sample_rate_hz,
-                                                        PB_ModeTypeDef mode 
-                                                      );
+void                 AudioEngine_ResetLatencyStats    ( void );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+/* Power states of the core, as the application marks them around its sleeps */
+typedef enum {
+  ENERGY_STATE_RUN,                           // Executing
+  ENERGY_STATE_SLEEP,                         // Sleep or low power sleep: the core waits in WFI, peripherals run
+  ENERGY_STATE_STOP,                          // STOP0 or STOP1 mode, timed on HSI16
+  ENERGY_STATE_COUNT
+} AudioEngine_PowerState;
+
+/* What the engine was doing, the other axis of AudioEngine_EnergyStats */
+typedef enum {
+  ENERGY_PHASE_APP,                           // None of the below: boot, the application, the DMA and DAC bring-up
+  ENERGY_PHASE_TRIGGER_WAIT,                  // Waiting for a trigger, marked by the application
+  ENERGY_PHASE_PLAY_WAIT,                     // In WaitForSampleEnd() or AudioEngine_WaitForEvent(), between renders
+  ENERGY_PHASE_RENDER,                        // Rendering ring periods, in the DMA interrupt or the render task
+  ENERGY_PHASE_COUNT
+} AudioEngine_EnergyPhase;
+
+/* Time per phase and power state returned by AudioEngine_GetEnergyStats() */
+typedef struct {
+  uint64_t us[ ENERGY_PHASE_COUNT ][ ENERGY_STATE_COUNT ];   // Microseconds in each phase and state
+  uint32_t sleeps;                            // Entries to ENERGY_STATE_SLEEP
+  uint32_t stops;                             // Entries to ENERGY_STATE_STOP
+  uint32_t renders;                           // Render passes
+  uint32_t playbacks;                         // Playbacks started: 1 for the last playback, 0 before the first
+} AudioEngine_EnergyStats;
+
+/* Energy profile */
 /**
- * @brief Start playback of a sample from memory
- * @param[in] sample_to_play Pointer to sample data in memory
- * @param[in] sample_set_sz Total number of samples to play (all channels combined)
- * @param[in] playback_speed Sample rate in Hz (e.g., 22000, 44100)
- * @param[in] sample_depth Bits per sample: 8 or 16
- * @param[in] mode Playback mode: Mode_mono or Mode_stereo
- * @return PB_Playing on success, PB_Error on failure
+ * @brief Mark the core's power state from here on
+ * @param[in] state ENERGY_STATE_SLEEP or ENERGY_STATE_STOP just before the WFI that enters it,
+ *            ENERGY_STATE_RUN once awake and on the full clock again
+ * @note Any context. Time is converted at the core clock when the state is marked, or at
+ *       HSI16 in STOP, which is also the clock STOP wakes on, so mark RUN after the clock is
+ *       restored. Call it with ENERGY_STATE_RUN after any other clock change outside the
+ *       engine too. Each SLEEP or STOP mark counts as an entry.
  */
-PB_StatusTypeDef    PlaySample                        ( 
-                                                        const void *sample_to_play, 
-                                                        uint32_t sample_set_sz, 
-                                                        uint32_t playback_speed, 
-                                                        uint8_t sample_depth, 
-                                                        PB_ModeTypeDef mode 
-                                                      ); 
+void                 AudioEngine_SetPowerState        ( AudioEngine_PowerState state );
 
 /**
- * @brief Block until current sample playback completes
- * @return PB_Idle when playback finished, PB_Error on playback failure
- * @note This blocks while paused/pausing as well. For non-blocking, poll GetPlaybackState().
+ * @brief Mark what the application is waiting for from here on
+ * @param[in] phase ENERGY_PHASE_TRIGGER_WAIT before waiting for a trigger, ENERGY_PHASE_APP after
+ * @note Any context. The engine marks its own waits and renders and puts the phase back after.
  */
-PB_StatusTypeDef    WaitForSampleEnd                  ( void );
+void                 AudioEngine_SetEnergyPhase       ( AudioEngine_EnergyPhase phase );
 
 /**
- * @brief Pause playback with fade-out
- * @return PB_Paused on success, PB_Error if not playing
- * @note Applies pause fade time before silencing. Use ResumePlayback() to resume.
+ * @brief Get the time spent in each phase and power state
+ * @param[out] stats Microseconds and counts
+ * @param[in]  last_playback 1 for the last playback, from its start to its return to idle;
+ *             0 for all time since AudioEngine_Init() or the last reset
  */
-PB_StatusTypeDef    PausePlayback                     ( void );
+void                 AudioEngine_GetEnergyStats       ( AudioEngine_EnergyStats *stats, uint8_t last_playback );
 
 /**
- * @brief Resume playback after pause with fade-in
- * @return PB_Playing on success, PB_Error if not paused
- * @note Applies resume fade time to smoothly restore volume
+ * @brief Clear the energy profile, the all-time and the last playback's
  */
-PB_StatusTypeDef    ResumePlayback                    ( void );
+void                 AudioEngine_ResetEnergyStats     ( void );
 
 /**
- * @brief Stop playback asynchronously with normal end-of-play fade-out
- * @return Current playback state, PB_Idle if already idle
- * @note Returns immediately. Use GetPlaybackState() to poll for completion.
+ * @brief Print the energy profile as text through AudioEngine_EnergyPutChar()
+ * @param[in] last_playback As for AudioEngine_GetEnergyStats()
+ * @note Application context. Read with Docs/energy_report.py, which applies state currents.
  */
-PB_StatusTypeDef    StopPlayback                      ( void );
+void                 AudioEngine_DumpEnergyStats      ( uint8_t last_playback );
 
 /**
- * @brief Shut down all audio hardware (I2S, DAC, amplifier)
- * @note Call when shutting down application or before changing configurations
+ * @brief Send one character of the energy report, over ITM stimulus port 0 unless overridden
+ * @param[in] ch Character
+ * @note Weak; define it to send the report over a UART instead.
  */
-void                ShutDownAudio                     ( void );
+void                 AudioEngine_EnergyPutChar        ( char ch );
+#endif
 
-/* DAC power control */
+#if AUDIO_ENGINE_ENABLE_LOAD_ADMISSION
+/* Stages of the render cost model (AudioEngine_SetStageCost()) */
+typedef enum {
+  COST_BASE_16BIT,                            // Everything but the optional stages, 16-bit PCM and decoded formats
+  COST_BASE_8BIT,                             // The same for 8-bit PCM
+  COST_LPF_16BIT,
+  COST_LPF_8BIT,
+  COST_AIR_EFFECT,
+  COST_NOISE_GATE,
+  COST_SOFT_CLIP,
+  COST_STAGE_COUNT
+} AudioEngine_CostStage;
+
+/* What happens to a playback or filter configuration estimated over AUDIO_ENGINE_LOAD_BUDGET_PCT */
+typedef enum {
+  LOAD_POLICY_OFF,                            // Nothing is checked
+  LOAD_POLICY_DEGRADE,                        // Stages are left out in LOAD_SHED_* order until it fits
+  LOAD_POLICY_REFUSE                          // SetFilterConfig() and PlaySample() return PB_Error
+} AudioEngine_LoadPolicy;
+
+/* Stages left out to fit the budget, in the order they go */
+#define LOAD_SHED_AIR_EFFECT    0x01U
+#define LOAD_SHED_NOISE_GATE    0x02U
+#define LOAD_SHED_SOFT_CLIP     0x04U
+#define LOAD_SHED_LPF           0x08U
+
+/* Load estimate of the configuration the render context runs (AudioEngine_GetLoadStatus()) */
+typedef struct {
+  uint32_t cycles_per_second;                 // Estimated render cycles per second with the stages left out
+  uint8_t  load_pct;                          // The same as a share of SystemCoreClock
+  uint8_t  shed;                              // LOAD_SHED_* stages left out of the requested configuration
+  uint8_t  channels;                          // Format the estimate is for: source channels,
+  uint8_t  sample_depth;                      // sample depth
+  uint32_t rate;                              // and output rate in Hz
+} AudioEngine_LoadStatus;
+
+/* Render load admission */
 /**
- * @brief Enable or disable DAC power control
- * @param[in] state 1 to enable DAC, 0 to disable DAC
- * @note Controls the optional DAC power management feature
+ * @brief Choose what happens to a playback or filter configuration over the load budget
+ * @param[in] policy LOAD_POLICY_DEGRADE (the default), LOAD_POLICY_REFUSE or LOAD_POLICY_OFF
+ * @note Under LOAD_POLICY_DEGRADE the requested configuration is kept (GetFilterConfig()) and
+ *       the stages come back as soon as a playback leaves room for them. A playback that does
+ *       not fit even with every optional stage left out is refused under either policy.
  */
-void                SetDAC_Control                    ( uint8_t state );
+void                 AudioEngine_SetLoadPolicy        ( AudioEngine_LoadPolicy policy );
 
 /**
- * @brief Get current DAC power control state
- * @return 1 if DAC control enabled, 0 if disabled
+ * @brief Estimate the render load of a filter configuration for a playback format
+ * @param[in] cfg Filter configuration, NULL for the current one
+ * @param[in] rate Output rate in Hz
+ * @param[in] channels Source channels, 1 or 2
+ * @param[in] sample_depth 8, 16 or an AUDIO_ENGINE_*_DEPTH
+ * @return Estimated share of SystemCoreClock in percent, with no stages left out
+ * @note Single-sample playback only: mixer voices, the EQ, FIR, compressor and resampler
+ *       are not in the model and come out of the margin the budget leaves.
  */
-uint8_t             GetDAC_Control                    ( void );
+uint8_t              AudioEngine_EstimateLoad         ( const FilterConfig_TypeDef *cfg, uint32_t rate,
+                                                        uint8_t channels, uint8_t sample_depth );
 
-/* Volume response control */
 /**
- * @brief Enable or disable non-linear volume response curve
- * @param[in] enable 1 to enable logarithmic response (recommended), 0 for linear
- * @note Non-linear response matches human loudness perception for intuitive control
+ * @brief Get the load estimate of the configuration the render context runs
+ * @param[out] status Estimated cycles and load, the stages left out and the format
  */
-void                SetVolumeResponseNonlinear        ( uint8_t enable );
+void                 AudioEngine_GetLoadStatus        ( AudioEngine_LoadStatus *status );
 
 /**
- * @brief Get current volume response mode
- * @return 1 if non-linear mode enabled, 0 if linear
+ * @brief Set the cost of one stage in the model, as measured by the benchmark firmware
+ * @param[in] stage Stage
+ * @param[in] cycles_per_sample_x100 Cycles per source sample, times 100
  */
-uint8_t             GetVolumeResponseNonlinear        ( void );
+void                 AudioEngine_SetStageCost         ( AudioEngine_CostStage stage, uint32_t cycles_per_sample_x100 );
 
 /**
- * @brief Set volume response gamma exponent
- * @param[in] gamma Gamma value (1.0-4.0), typical: 2.0 for quadratic response
- * @note Higher gamma = more aggressive curve. 1.0 = linear, 2.0 = recommended
+ * @brief Get the cost of one stage in the model
+ * @return Cycles per source sample, times 100
  */
-void                SetVolumeResponseGamma            ( float gamma );
+uint32_t             AudioEngine_GetStageCost         ( AudioEngine_CostStage stage );
 
+#if AUDIO_ENGINE_ENABLE_CLOCK_SCALING
 /**
- * @brief Get current volume response gamma exponent
- * @return Current gamma value
+ * @brief Turn core clock scaling during playback on (the default) or off
+ * @param[in] enable 1 to divide HCLK down to what the playback's load estimate needs, 0 for SYSCLK
+ * @note HCLK also clocks SysTick, which the HAL reloads, and the APB timers, which run slower
+ *       while it is divided. Mixer voices, the EQ, FIR, compressor and resampler are not in the
+ *       cost model: turn scaling off, or raise AUDIO_ENGINE_MIN_CORE_HZ, for playbacks using them.
  */
-float               GetVolumeResponseGamma            ( void );
+void                 AudioEngine_SetClockScaling      ( uint8_t enable );
+#endif
 
-/* Chunk processing callbacks (call from DMA callbacks) */
+#if AUDIO_ENGINE_ENABLE_PROFILING
 /**
- * @brief Process next 16-bit PCM chunk from DMA half-complete callback
- * @param[in,out] chunk_p Pointer to next chunk of 16-bit samples to process
- * @return PB_Playing while playback continues, PB_Idle when finished
- * @note Called from DMA ISR. Applies volume, filters, fade, clipping
+ * @brief Measure the cost table on this core with AudioEngine_Benchmark(), with nothing playing
+ * @retval 1 if measured, 0 if playing
+ * @note Takes a few tens of milliseconds. The base costs come from the chunk processors with
+ *       the current filter configuration, less its filter chain.
  */
-PB_StatusTypeDef    ProcessNextWaveChunk              ( int16_t *chunk_p );
+uint8_t              AudioEngine_CalibrateLoadModel   ( void );
+#endif
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ITM_TELEMETRY
+/* Pipeline points the ITM audio tap can stream from (left channel) */
+typedef enum {
+  TELEMETRY_TAP_OFF,
+  TELEMETRY_TAP_SOURCE,                       // PCM period after the fetch and volume, before the filter chain
+  TELEMETRY_TAP_FILTERED,                     // PCM period after the filter chain, before the fades
+  TELEMETRY_TAP_OUTPUT                        // Ring period as it goes to the I2S, voices mixed in
+} AudioEngine_TelemetryTap;
 
+/* ITM telemetry */
 /**
- * @brief Process next 8-bit PCM chunk from DMA half-complete callback
- * @param[in,out] chunk_p Pointer to next chunk of 8-bit samples to process
- * @return PB_Playing while playback continues, PB_Idle when finished
- * @note Called from DMA ISR. Applies volume, filters, fade, clipping
+ * @brief Select the pipeline point streamed on the ITM audio tap port
+ * @param[in] tap Tap point, TELEMETRY_TAP_OFF for statistics only
+ * @param[in] decimation Frames per tap sample, 1 or more; at 2 MHz SWO a full-rate 22 kHz tap fits
+ * @note The source and filtered taps only see 8 and 16-bit PCM samples.
  */
-PB_StatusTypeDef    ProcessNextWaveChunk_8_bit        ( uint8_t *chunk_p );
+void                 AudioEngine_SetTelemetryTap      ( AudioEngine_TelemetryTap tap, uint8_t decimation );
 
 /**
- * @brief Advance sample pointer for next DMA transfer
- * @note Call from DMA complete callback after ProcessNextWaveChunk()
+ * @brief Get the number of telemetry frames cut short by a full ITM FIFO
+ * @return Dropped frames since AudioEngine_Init(); raise the SWO clock or the decimation if it grows
  */
-void                AdvanceSamplePointer              ( void );
+uint32_t             AudioEngine_GetTelemetryDrops    ( void );
+#endif
 
 /* Air Effect runtime control */
 /**
  * @brief Set air effect gain using Q16 fixed-point format
  * @param[in] gain_q16 Gain in Q16 format (65536 = 1.0x, 131072 = 2.0x max)
- * @note Enables air effect automatically if gain > 0
+ * @note Enables air effect automatically if gain > 0. During playback the gain glides to its new
+ *       value over AUDIO_ENGINE_PARAM_SMOOTH_PERIODS periods.
  */
 void                 SetAirEffectGainQ16              ( uint32_t gain_q16 );
 
@@ -559,7 +4414,7 @@ uint32_t             GetAirEffectGainQ16              ( void );
 
 /**
  * @brief Set air effect gain using decibels
- * @param[in] db Gain in dB (0.0 = no gain, 6.0 dB = ~2x, -6.0 dB = ~0.5x)
+ * @param[in] db Shelf gain in dB (0.0 = no gain, 6.0 dB = ~2x, -6.0 dB = ~0.5x)
  * @note Enables air effect automatically if db > 0
  */
 void                 SetAirEffectGainDb               ( float db );
@@ -606,6 +4461,7 @@ float                GetAirEffectPresetDb             ( uint8_t preset_index );
 
 
 /* Hardware callbacks (to be called from I2S DMA callbacks) */
+#if !AUDIO_ENGINE_ENABLE_SAI_OUTPUT
 /**
  * @brief DMA half-complete callback for I2S
  * @param[in] hi2s Pointer to I2S handle
@@ -621,6 +4477,31 @@ void                 HAL_I2S_TxHalfCpltCallback      ( I2S_HandleTypeDef *hi2s )
  * @note Application must call this from HAL_I2S_TxCpltCallback()
  */
 void                 HAL_I2S_TxCpltCallback         ( I2S_HandleTypeDef *hi2s );
+#else
+/**
+ * @brief DMA half-complete callback for the SAI output block
+ * @param[in] hsai Pointer to SAI handle
+ * @note Takes the place of HAL_I2S_TxHalfCpltCallback() with AUDIO_ENGINE_ENABLE_SAI_OUTPUT
+ */
+void                 HAL_SAI_TxHalfCpltCallback      ( SAI_HandleTypeDef *hsai );
+
+/**
+ * @brief DMA complete callback for the SAI output block
+ * @param[in] hsai Pointer to SAI handle
+ * @note Takes the place of HAL_I2S_TxCpltCallback() with AUDIO_ENGINE_ENABLE_SAI_OUTPUT
+ */
+void                 HAL_SAI_TxCpltCallback         ( SAI_HandleTypeDef *hsai );
+#endif
+
+#if AUDIO_ENGINE_ENABLE_LL_DMA_IRQ
+/**
+ * @brief Handle the I2S transmit DMA interrupt without the HAL
+ * @note Call from the DMA channel's IRQ handler (DMA1_Channel1_IRQHandler()) in place of
+ *       HAL_DMA_IRQHandler() when AUDIO_ENGINE_ENABLE_LL_DMA_IRQ is 1
+ * @note Serves zone 0's channel only; the channels of extra zones keep the HAL handler
+ */
+void                 AudioEngine_DmaIrqHandler       ( void );
+#endif
 
 /* Playback state accessors (for internal use or advanced applications) */
 /**
@@ -636,17 +4517,60 @@ PB_StatusTypeDef    GetPlaybackState                ( void );
 void                SetPlaybackState                ( PB_StatusTypeDef state );
 
 /**
- * @brief Get which half of double-buffer is next to fill
- * @return FIRST (0) or SECOND (1)
+ * @brief Get which ring period is rendered next
+ * @return Period index; FIRST (0) or SECOND (1) with the default two-period ring
  */
 uint8_t             GetHalfToFill                   ( void );
 
 /**
- * @brief Set which half of double-buffer to fill next (internal use)
- * @param[in] half FIRST or SECOND
+ * @brief Set which ring period to render next (internal use)
+ * @param[in] half Period index; FIRST or SECOND with the default two-period ring
  */
 void                SetHalfToFill                   ( uint8_t half );
 
+/**
+ * @brief Set the DMA ring geometry used from the next PlaySample() or AudioEngine_StartStream()
+ * @param[in] period_frames Frames per period, PERIOD_FRAMES_MIN to HALFCHUNK_SZ, a multiple of 4
+ * @param[in] period_count  Periods in the ring, at least 2, with
+ *                          period_frames * period_count <= AUDIO_ENGINE_RING_FRAMES
+ * @return PB_Idle on success, PB_Error if playback or a stream is active or the geometry does not fit
+ * @note Volume, fades and control requests are handled once per period. The DMA half and
+ *       full interrupts each render all periods already played, so the render deadline is
+ *       half the ring whatever the period count.
+ */
+PB_StatusTypeDef    AudioEngine_SetBufferGeometry     ( uint16_t period_frames, uint8_t period_count );
+
+/**
+ * @brief Get the DMA ring geometry
+ * @param[out] period_frames Frames per period (may be NULL)
+ * @param[out] period_count  Periods in the ring (may be NULL)
+ */
+void                AudioEngine_GetBufferGeometry     ( uint16_t *period_frames, uint8_t *period_count );
+
+#if AUDIO_ENGINE_DEFERRED_RENDER
+/**
+ * @brief Render the ring periods handed over by the DMA interrupts
+ * @note Call from PendSV_Handler() when AUDIO_ENGINE_DEFERRED_RENDER is 1; under
+ *       AUDIO_ENGINE_ENABLE_RTOS the port's render task calls it
+ */
+void                AudioEngine_RenderTask            ( void );
+
+#if AUDIO_ENGINE_ENABLE_RTOS
+/**
+ * @brief Wake the render task; supplied by the RTOS port (audio_rtos.c)
+ * @note Called from the I2S DMA interrupt in place of pending PendSV.
+ */
+void                AudioEngine_RtosPendRender        ( void );
+
+/**
+ * @brief Block the calling task until the render task has run again; supplied by the RTOS port
+ * @note Called by WaitForSampleEnd() and AudioEngine_WaitForEvent() between checks, in task
+ *       context only. It may return early; the engine checks again.
+ */
+void                AudioEngine_RtosWait              ( void );
+#endif
+#endif
+
 /**
  * @brief Get current playback sample rate
  * @return Sample rate in Hz (e.g., 22000, 44100)
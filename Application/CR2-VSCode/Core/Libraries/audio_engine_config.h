@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file           : audio_engine_config.h
+  * @brief          : Pipeline stages built into the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * One switch per stage of the core playback pipeline, all on by default.
+  * Set one to 0 here, or with -D from the build (the AUDIO_ENGINE_MINIMAL
+  * CMake option clears them all), and the stage is compiled out:
+  *
+  *   - Its setters are accepted but the stage stays off, and its getters
+  *     report it off.
+  *   - Every check the render makes for it becomes a constant, so the
+  *     branches leave the hot loops.
+  *   - Its kernels, tables and state are not built, or, where a reference is
+  *     left in dead code, are dropped by --gc-sections.
+  *
+  * A configuration or preset that asks for a stage compiled out plays
+  * without it, as if its enable were 0.  The feature flags for optional
+  * subsystems (sources, effects, peripherals) stay in audio_engine.h.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _AUDIO_ENGINE_CONFIG_H
+#define _AUDIO_ENGINE_CONFIG_H
+
+/* 8-bit unsigned PCM sources: PlaySample() and AudioEngine_PlayVoice() with a depth of 8, and
+ * ASSET_PCM8 assets.  At 0 they are refused with PB_Error and the 8-bit chunk path is left out. */
+#ifndef AUDIO_ENGINE_ENABLE_PCM8
+#define AUDIO_ENGINE_ENABLE_PCM8 1
+#endif
+
+/* One-pole low-pass filter of 8-bit sources (SetLpf8BitLevel(), SetLpf8BitCustomAlpha()) */
+#ifndef AUDIO_ENGINE_ENABLE_LPF_8BIT
+#define AUDIO_ENGINE_ENABLE_LPF_8BIT AUDIO_ENGINE_ENABLE_PCM8
+#endif
+
+/* Biquad low-pass filter of 16-bit sources (SetLpf16BitLevel(), SetLpf16BitCustomAlpha()) */
+#ifndef AUDIO_ENGINE_ENABLE_LPF_16BIT
+#define AUDIO_ENGINE_ENABLE_LPF_16BIT 1
+#endif
+
+/* Air effect: the high-shelf section folded into the DC blocker (SetAirEffectEnable()) */
+#ifndef AUDIO_ENGINE_ENABLE_AIR_EFFECT
+#define AUDIO_ENGINE_ENABLE_AIR_EFFECT 1
+#endif
+
+/* Noise gate (SetNoiseGateEnable()) */
+#ifndef AUDIO_ENGINE_ENABLE_NOISE_GATE
+#define AUDIO_ENGINE_ENABLE_NOISE_GATE 1
+#endif
+
+/* Soft clipper of the filter chain and of the mix bus limiter (SetSoftClippingEnable(),
+ * SetSoftClipCurve()).  At 0 its two 513-entry curve tables go too. */
+#ifndef AUDIO_ENGINE_ENABLE_SOFT_CLIPPING
+#define AUDIO_ENGINE_ENABLE_SOFT_CLIPPING 1
+#endif
+
+/* Fade-in, fade-out and end-of-file fade ramps (SetFadersEnabled()).  At 0 sounds start and
+ * stop at full level, as with SetFadersEnabled( 0 ); the volume still ramps. */
+#ifndef AUDIO_ENGINE_ENABLE_FADERS
+#define AUDIO_ENGINE_ENABLE_FADERS 1
+#endif
+
+/* PausePlayback() and ResumePlayback().  At 0 both return PB_Error. */
+#ifndef AUDIO_ENGINE_ENABLE_PAUSE
+#define AUDIO_ENGINE_ENABLE_PAUSE 1
+#endif
+
+#endif // End of _AUDIO_ENGINE_CONFIG_H
@@ -0,0 +1,349 @@
+/**
+  ******************************************************************************
+  * @file           : audio_pipeline.hpp
+  * @brief          : Filter chains composed at compile time, for C++17 firmware
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * The engine's per-sample filters as stages a C++ application strings together
+  * itself, for its own buffers (a synthesiser's output, a microphone path):
+  *
+  *   using namespace audio_pipeline;
+  *   static const SoftClipTable clip_curve( SoftClip_Cubic );
+  *   Pipeline<Biquad<Q15>, DcAirShelf, SoftClip> left {
+  *     Biquad<Q15>( LPF_16BIT_SOFT ), DcAirShelf( 22050U ), SoftClip( clip_curve )
+  *   };
+  *   auto right = left;                      // Same settings, its own history
+  *
+  *   left.Process( frames, count, 2U );      // Interleaved stereo, one channel each
+  *   right.Process( frames + 1, count, 2U );
+  *
+  * The stage list is the chain: Process() runs every stage on a sample before
+  * the next sample, in one loop the compiler inlines whole, with no enable
+  * flags, function pointers or per-stage passes over the buffer.  A stage left
+  * out costs nothing.  The filter state is copied into locals for the block and
+  * back after it, as the engine's block kernels do, so it stays in registers.
+  *
+  * Each stage does the same arithmetic as its engine kernel, sample for sample
+  * (ApplyLowPassFilter16Bit(), ApplyDCFilterWithAlpha(), ApplyDCAirFilter() and
+  * ApplySoftClipping(), and the float low-pass of AUDIO_ENGINE_ENABLE_FLOAT_DSP),
+  * so a chain here sounds the same as the engine's.  Settings are fixed when a
+  * stage is built; the engine's smoothed parameter ramps are left to it.  A
+  * stage is any class with int16_t Run( int16_t ) and void Reset(), so an
+  * application can add its own.
+  *
+  * The C API in audio_engine.h is unchanged, and the engine does not use this
+  * header; it needs only the engine's constants.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _AUDIO_PIPELINE_HPP
+#define _AUDIO_PIPELINE_HPP
+
+#include "audio_engine.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+namespace audio_pipeline {
+
+/* Sample formats of a Biquad: Q15 is the engine's fixed point, float its AUDIO_ENGINE_ENABLE_FLOAT_DSP kernel */
+struct Q15 {};
+
+template <typename Format> class Biquad;
+
+namespace detail {
+/* The engine's BIQUAD16_COEFFS(), Q16; b2 equals b0 */
+struct LowPassCoeffs {
+  int32_t b0, b1, a1, a2;
+};
+
+inline LowPassCoeffs MakeLowPass( uint32_t alpha_q16 )
+{
+  const int64_t alpha = ( alpha_q16 > 65534U ) ? 65534 : (int64_t)alpha_q16;
+  const int32_t b0    = (int32_t)( ( ( 65536 - alpha ) * ( 65536 - alpha ) ) >> 17 );
+  return { b0, b0 << 1, -(int32_t)( alpha * 2 ), (int32_t)( ( alpha * alpha ) >> 16 ) };
+}
+} // namespace detail
+
+/* Second order low-pass with the engine's double pole at alpha, and its makeup gain */
+template <> class Biquad<Q15> {
+public:
+  /**
+   * @brief Build the filter for a pole
+   * @param[in] alpha_q16 Pole, Q16: LPF_16BIT_VERY_SOFT to LPF_16BIT_AGGRESSIVE, at most 65534
+   * @param[in] makeup_q16 Gain after the filter, Q16 (LPF_16BIT_MAKEUP_GAIN_Q16 is unity)
+   */
+  explicit Biquad( uint32_t alpha_q16, int32_t makeup_q16 = LPF_16BIT_MAKEUP_GAIN_Q16 )
+    : c_( detail::MakeLowPass( alpha_q16 ) ), makeup_( makeup_q16 ) {}
+
+  int16_t Run( int16_t input )
+  {
+    int64_t acc  = (int64_t)c_.b0 * input;
+    acc         += (int64_t)c_.b1 * x1_;
+    acc         += (int64_t)c_.b0 * x2_;
+    acc         -= (int64_t)c_.a1 * y1_;
+    acc         -= (int64_t)c_.a2 * y2_;
+    const int32_t output = (int32_t)( acc >> 16 );
+    x2_ = x1_;  x1_ = input;
+    y2_ = y1_;  y1_ = output;
+    return (int16_t)__SSAT( (int32_t)( ( (int64_t)output * makeup_ ) >> 16 ), 16 );
+  }
+
+  void Reset() { x1_ = x2_ = y1_ = y2_ = 0; }
+
+private:
+  detail::LowPassCoeffs c_;
+  int32_t makeup_;
+  int32_t x1_ = 0, x2_ = 0, y1_ = 0, y2_ = 0;
+};
+
+/* The same low-pass in single-precision float, for a core with an FPU */
+template <> class Biquad<float> {
+public:
+  /**
+   * @brief Build the filter for a pole, from the fixed-point coefficients as the engine does
+   * @param[in] alpha_q16 Pole, Q16, at most 65534
+   * @param[in] makeup_q16 Gain after the filter, Q16
+   */
+  explicit Biquad( uint32_t alpha_q16, int32_t makeup_q16 = LPF_16BIT_MAKEUP_GAIN_Q16 )
+  {
+    const detail::LowPassCoeffs c   = detail::MakeLowPass( alpha_q16 );
+    const float                 q16 = 1.0f / 65536.0f;
+    b0_     = (float)c.b0 * q16;
+    b1_     = (float)c.b1 * q16;
+    a1_     = (float)c.a1 * q16;
+    a2_     = (float)c.a2 * q16;
+    makeup_ = (float)makeup_q16 * q16;
+  }
+
+  int16_t Run( int16_t input )
+  {
+    const float x = (float)input;
+    const float y = b0_ * x + b1_ * x1_ + b0_ * x2_ - a1_ * y1_ - a2_ * y2_;
+    x2_ = x1_;  x1_ = x;
+    y2_ = y1_;  y1_ = y;
+    float out = y * makeup_;
+    out = ( out > 32767.0f ) ? 32767.0f : ( out < -32768.0f ) ? -32768.0f : out;
+    return (int16_t)( (int32_t)( out + 32768.5f ) - 32768 );   // Round halves up, as the engine
+  }
+
+  void Reset() { x1_ = x2_ = y1_ = y2_ = 0.0f; }
+
+private:
+  float b0_, b1_, a1_, a2_, makeup_;
+  float x1_ = 0.0f, x2_ = 0.0f, y1_ = 0.0f, y2_ = 0.0f;
+};
+
+/* First order DC blocker: y = x - x1 + alpha * y1 */
+class DcBlock {
+public:
+  /**
+   * @brief Build the blocker
+   * @param[in] alpha_q16 Pole, Q16: DC_FILTER_ALPHA (default) or SOFT_DC_FILTER_ALPHA
+   */
+  explicit DcBlock( uint32_t alpha_q16 = DC_FILTER_ALPHA ) : alpha_( (int32_t)alpha_q16 ) {}
+
+  int16_t Run( int16_t input )
+  {
+    const int32_t output = __SSAT( (int32_t)input - x1_ + ( ( y1_ * alpha_ ) >> DC_FILTER_SHIFT ), 16 );
+    x1_ = input;
+    y1_ = output;
+    return (int16_t)output;
+  }
+
+  void Reset() { x1_ = y1_ = 0; }
+
+private:
+  int32_t alpha_;
+  int32_t x1_ = 0, y1_ = 0;
+};
+
+/* DC blocker and one-pole high shelf as one biquad: the DC blocker, then the input plus ( G - 1 )
+ * times what a low-pass at AIR_EFFECT_FREQ_HZ takes out, with one clamp on the output */
+class DcAirShelf {
+public:
+  static constexpr int kShift = 28;                            // Coefficients Q28
+  static constexpr int32_t kOne = (int32_t)1 << kShift;
+
+  /**
+   * @brief Build the section for an output rate
+   * @param[in] rate Output rate, Hz
+   * @param[in] gain_q16 Shelf gain G, Q16, up to AIR_EFFECT_SHELF_GAIN_MAX
+   * @param[in] alpha_q16 DC pole, Q16: DC_FILTER_ALPHA (default) or SOFT_DC_FILTER_ALPHA
+   */
+  explicit DcAirShelf( uint32_t rate, uint32_t gain_q16 = AIR_EFFECT_SHELF_GAIN, uint32_t alpha_q16 = DC_FILTER_ALPHA )
+  {
+    const float   alpha = 1.0f - std::exp( -2.0f * 3.14159265359f * (float)AIR_EFFECT_FREQ_HZ / (float)rate );
+    int32_t       q15   = (int32_t)( alpha * 32768.0f + 0.5f );
+    q15      = ( q15 > 32767 ) ? 32767 : q15;
+    gain_q16 = ( gain_q16 > AIR_EFFECT_SHELF_GAIN_MAX ) ? AIR_EFFECT_SHELF_GAIN_MAX : gain_q16;
+    const int64_t a = (int64_t)alpha_q16 << ( kShift - 16 );         // Poles as DCAirCoeffsFor()
+    const int64_t c = (int64_t)( 32768 - q15 ) << ( kShift - 15 );
+    c_  = (int32_t)c;
+    a1_ = (int32_t)( a + c );
+    a2_ = (int32_t)( ( a * c + ( (int64_t)1 << ( kShift - 1 ) ) ) >> kShift );
+    k_  = ( ( ( (int32_t)gain_q16 - 65536 ) / 2 ) * ( 32768 - q15 ) ) >> ( 30 - kShift );
+  }
+
+  int16_t Run( int16_t input )
+  {
+    const int32_t u   = (int32_t)input - x1_;
+    int64_t       acc = err_;
+    acc += (int64_t)( kOne + k_ ) * u;
+    acc -= (int64_t)( c_ + k_ ) * u1_;
+    acc += (int64_t)a1_ * y1_;
+    acc -= (int64_t)a2_ * y2_;
+    const int32_t output = (int32_t)( acc >> kShift );
+    err_ = (int32_t)( acc - (int64_t)output * kOne );
+    x1_ = input;  u1_ = u;
+    y2_ = y1_;    y1_ = output;
+    return (int16_t)__SSAT( output, 16 );
+  }
+
+  void Reset() { x1_ = u1_ = y1_ = y2_ = err_ = 0; }
+
+private:
+  int32_t c_, a1_, a2_, k_;
+  int32_t x1_ = 0, u1_ = 0, y1_ = 0, y2_ = 0, err_ = 0;
+};
+
+/* The soft clipper's curve, tabulated as the engine's SetSoftClipCurve() does; 1 KB, shared by its stages */
+class SoftClipTable {
+public:
+  static constexpr uint32_t kBits     = 9U;                      // 512 segments over the 16-bit range
+  static constexpr uint32_t kFracBits = 16U - kBits;
+
+  explicit SoftClipTable( SoftClip_Curve curve )
+  {
+    for( uint32_t i = 0U; i <= ( 1UL << kBits ); i++ ) {
+      const float in        = (float)( (int32_t)( i << kFracBits ) - 32768 );
+      const float magnitude = ( in < 0.0f ) ? -in : in;
+      const float knee      = ( curve == SoftClip_Asymmetric && in < 0.0f ) ? 21000.0f : 28000.0f;
+      const float range     = 32767.0f - knee;
+      float       out       = magnitude;
+
+      if( magnitude > knee ) {
+        float x = ( magnitude - knee ) / range;
+        float shaped;
+        if( curve == SoftClip_Cubic ) {
+          x      = ( x > 1.0f ) ? 1.0f : x;
+          shaped = 1.5f * x * x - x * x * x;
+        } else {
+          const float e2x = std::exp( -2.0f * x );
+          shaped = ( 1.0f - e2x ) / ( 1.0f + e2x );
+        }
+        out = knee + range * shaped;
+      }
+      out = ( out > 32767.0f ) ? 32767.0f : out;
+      table_[ i ] = (int16_t)( ( in < 0.0f ) ? -( out + 0.5f ) : ( out + 0.5f ) );
+    }
+  }
+
+  const int16_t *data() const { return table_.data(); }
+
+private:
+  std::array<int16_t, ( 1UL << kBits ) + 1U> table_;
+};
+
+/* Soft clipper: the table's curve, interpolated linearly between entries */
+class SoftClip {
+public:
+  /**
+   * @brief Build the clipper on a curve
+   * @param[in] table Curve; must outlive the stage and its copies
+   */
+  explicit SoftClip( const SoftClipTable &table ) : curve_( table.data() ) {}
+
+  int16_t Run( int16_t input ) const
+  {
+    const uint32_t pos  = (uint32_t)( (int32_t)input + 32768 );
+    const uint32_t idx  = pos >> SoftClipTable::kFracBits;
+    const int32_t  frac = (int32_t)( pos & ( ( 1UL << SoftClipTable::kFracBits ) - 1U ) );
+    const int32_t  a    = curve_[ idx ];
+    const int32_t  b    = curve_[ idx + 1U ];
+    return (int16_t)( a + ( ( ( b - a ) * frac ) >> SoftClipTable::kFracBits ) );
+  }
+
+  void Reset() {}
+
+private:
+  const int16_t *curve_;
+};
+
+/* One channel's chain: Stages run left to right on each sample */
+template <typename... Stages>
+class Pipeline {
+  static_assert( sizeof...( Stages ) > 0U, "A pipeline needs at least one stage" );
+
+public:
+  explicit Pipeline( Stages... stages ) : stages_( std::move( stages )... ) {}
+
+  /**
+   * @brief Run the chain over a block in place
+   * @param[in,out] samples First sample of the channel
+   * @param[in] count Samples to process
+   * @param[in] stride Distance between the channel's samples: 1 for mono, 2 for one side of stereo
+   */
+  void Process( int16_t *samples, uint32_t count, uint32_t stride = 1U )
+  {
+    std::tuple<Stages...> local = stages_;                      // Keeps the state out of memory for the loop
+
+    for( uint32_t i = 0U; i < count; i++, samples += stride ) {
+      *samples = RunAll( local, *samples, std::index_sequence_for<Stages...>{} );
+    }
+    stages_ = local;
+  }
+
+  /* Clear every stage's history, keeping its settings */
+  void Reset()
+  {
+    std::apply( []( auto &... stage ) { ( stage.Reset(), ... ); }, stages_ );
+  }
+
+  /* A stage, to rebuild with new settings: pipeline.Stage<0>() = Biquad<Q15>( LPF_16BIT_FIRM ) */
+  template <std::size_t I>
+  auto &Stage() { return std::get<I>( stages_ ); }
+
+private:
+  template <std::size_t... I>
+  static inline __attribute__( ( always_inline ) ) int16_t RunAll( std::tuple<Stages...> &stages, int16_t sample,
+                                                                  std::index_sequence<I...> )
+  {
+    ( ( sample = std::get<I>( stages ).Run( sample ) ), ... );
+    return sample;
+  }
+
+  std::tuple<Stages...> stages_;
+};
+
+} // namespace audio_pipeline
+
+#endif // End of _AUDIO_PIPELINE_HPP
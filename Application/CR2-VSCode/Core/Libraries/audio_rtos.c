@@ -0,0 +1,293 @@
+/**
+  ******************************************************************************
+  * @file           : audio_rtos.c
+  * @brief          : FreeRTOS port of the audio engine: render task and command queue
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * One task does all the engine's work at task level: each wake-up renders the
+  * periods the DMA interrupt handed over, then runs the queued commands, then
+  * gives render_done so a task blocked in an engine wait checks again.  The
+  * notification count is cleared on each take, so any number of interrupts
+  * and posts between two passes cost one pass.  commands_posted runs ahead of
+  * commands_done while a command is queued or running, which is how
+  * AudioRtos_WaitForEnd() knows a play it posted has not started yet.
+  *
+  ******************************************************************************
+  */
+
+#include "audio_engine.h"
+
+#if AUDIO_ENGINE_ENABLE_RTOS
+
+#include "audio_rtos.h"
+
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+extern void xPortSysTickHandler( void );
+
+static          TaskHandle_t      render_task           = NULL;
+static          QueueHandle_t     command_queue         = NULL;
+static          SemaphoreHandle_t render_done           = NULL;   // Given after each pass of the render task
+static volatile uint32_t          commands_posted       = 0U;     // Counted before they are queued
+static volatile uint32_t          commands_done         = 0U;
+
+
+/** Run a queued command in the render task
+  *
+  * @param: command - Command taken from the queue
+  * @retval: none
+  */
+static void RunCommand( const AudioRtos_Command *command )
+{
+  switch( command->op ) {
+    case AUDIO_RTOS_PLAY:
+      (void)PlaySample( command->play.sample, command->play.size, command->play.rate, command->play.depth, command->play.mode );
+      break;
+    case AUDIO_RTOS_PAUSE:
+      (void)PausePlayback();
+      break;
+    case AUDIO_RTOS_RESUME:
+      (void)ResumePlayback();
+      break;
+    case AUDIO_RTOS_STOP:
+      (void)StopPlayback();
+      break;
+    case AUDIO_RTOS_CALL:
+      if( command->call.func != NULL ) {
+        command->call.func( command->call.arg );
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+
+/** Render the handed-over periods and run the queued commands, once per wake-up
+  *
+  * @param: arg - Unused
+  * @retval: none
+  */
+static void RenderTask( void *arg )
+{
+  AudioRtos_Command command;
+
+  (void)arg;
+  for( ;; ) {
+    (void)ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+    AudioEngine_RenderTask();
+    while( xQueueReceive( command_queue, &command, 0U ) == pdTRUE ) {
+      RunCommand( &command );
+      commands_done++;
+    }
+    (void)xSemaphoreGive( render_done );
+  }
+}
+
+
+/** Create the render task, its command queue and the wake-up semaphore
+  *
+  * @param: none
+  * @retval: AudioRtos_Status - AUDIO_RTOS_OK, or AUDIO_RTOS_NO_MEMORY
+  */
+AudioRtos_Status AudioRtos_Init( void )
+{
+  command_queue = xQueueCreate( AUDIO_RTOS_QUEUE_LENGTH, sizeof( AudioRtos_Command ) );
+  render_done   = xSemaphoreCreateBinary();
+  if( command_queue == NULL || render_done == NULL ) {
+    return AUDIO_RTOS_NO_MEMORY;
+  }
+  if( xTaskCreate( RenderTask, "audio", AUDIO_RTOS_RENDER_STACK_WORDS, NULL, AUDIO_RTOS_RENDER_PRIORITY, &render_task ) != pdPASS ) {
+    render_task = NULL;
+    return AUDIO_RTOS_NO_MEMORY;
+  }
+  return AUDIO_RTOS_OK;
+}
+
+
+/** Queue a command for the render task and wake it
+  *
+  * @param: command - Command, copied
+  * @param: timeout - Ticks to wait for room
+  * @retval: AudioRtos_Status - AUDIO_RTOS_OK once queued
+  */
+AudioRtos_Status AudioRtos_Post( const AudioRtos_Command *command, TickType_t timeout )
+{
+  if( render_task == NULL ) {
+    return AUDIO_RTOS_NOT_STARTED;
+  }
+
+  taskENTER_CRITICAL();
+  commands_posted++;
+  taskEXIT_CRITICAL();
+  if( xQueueSend( command_queue, command, timeout ) != pdTRUE ) {
+    taskENTER_CRITICAL();
+    commands_posted--;
+    taskEXIT_CRITICAL();
+    return AUDIO_RTOS_QUEUE_FULL;
+  }
+  xTaskNotifyGive( render_task );
+  return AUDIO_RTOS_OK;
+}
+
+
+/** Queue a command for the render task from an interrupt and wake it
+  *
+  * @param: command - Command, copied
+  * @param: woken - Set to pdTRUE if a context switch is due, or NULL
+  * @retval: AudioRtos_Status - AUDIO_RTOS_OK once queued
+  */
+AudioRtos_Status AudioRtos_PostFromISR( const AudioRtos_Command *command, BaseType_t *woken )
+{
+  UBaseType_t saved;
+
+  if( render_task == NULL ) {
+    return AUDIO_RTOS_NOT_STARTED;
+  }
+
+  saved = taskENTER_CRITICAL_FROM_ISR();
+  commands_posted++;
+  taskEXIT_CRITICAL_FROM_ISR( saved );
+  if( xQueueSendFromISR( command_queue, command, woken ) != pdTRUE ) {
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    commands_posted--;
+    taskEXIT_CRITICAL_FROM_ISR( saved );
+    return AUDIO_RTOS_QUEUE_FULL;
+  }
+  vTaskNotifyGiveFromISR( render_task, woken );
+  return AUDIO_RTOS_OK;
+}
+
+
+/** Block until the posted commands have run and nothing plays
+  *
+  * @param: timeout - Ticks to wait, portMAX_DELAY for no limit
+  * @retval: AudioRtos_Status - AUDIO_RTOS_OK once idle, AUDIO_RTOS_TIMEOUT if not
+  */
+AudioRtos_Status AudioRtos_WaitForEnd( TickType_t timeout )
+{
+  TimeOut_t started;
+
+  if( render_task == NULL ) {
+    return AUDIO_RTOS_NOT_STARTED;
+  }
+
+  vTaskSetTimeOutState( &started );
+  for( ;; ) {
+    const PB_StatusTypeDef state = GetPlaybackState();
+
+    if( commands_posted == commands_done && state != PB_Playing && state != PB_Pausing && state != PB_Paused ) {
+      return AUDIO_RTOS_OK;
+    }
+    if( xTaskCheckForTimeOut( &started, &timeout ) != pdFALSE ) {
+      return AUDIO_RTOS_TIMEOUT;
+    }
+    (void)xSemaphoreTake( render_done, ( timeout < pdMS_TO_TICKS( AUDIO_RTOS_WAIT_MS ) ) ? timeout : pdMS_TO_TICKS( AUDIO_RTOS_WAIT_MS ) );
+  }
+}
+
+
+/** Count the kernel tick once the scheduler has started
+  *
+  * @param: none
+  * @retval: none
+  */
+void AudioRtos_SysTick( void )
+{
+  if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED ) {
+    xPortSysTickHandler();
+  }
+}
+
+
+/** Wake the render task from the I2S DMA interrupt (the engine's PendSV replacement)
+  *
+  * @param: none
+  * @retval: none
+  */
+void AudioEngine_RtosPendRender( void )
+{
+  BaseType_t woken = pdFALSE;
+
+  if( render_task == NULL ) {
+    return;
+  }
+  if( __get_IPSR() == 0U ) {
+    xTaskNotifyGive( render_task );                       // A render kicked off from a task
+    return;
+  }
+  vTaskNotifyGiveFromISR( render_task, &woken );
+  portYIELD_FROM_ISR( woken );
+}
+
+
+/** Block the calling task until the render task has run again, or AUDIO_RTOS_WAIT_MS
+  *
+  * Before the scheduler starts there is nothing to block on, and the engine's wait loop
+  * simply checks again.
+  *
+  * @param: none
+  * @retval: none
+  */
+void AudioEngine_RtosWait( void )
+{
+  if( render_done != NULL && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING ) {
+    (void)xSemaphoreTake( render_done, pdMS_TO_TICKS( AUDIO_RTOS_WAIT_MS ) );
+  }
+}
+
+
+#if !AUDIO_ENGINE_CUSTOM_HAL_DELAY
+/** HAL_Delay() on the kernel tick
+  *
+  * Blocks the calling task once the scheduler runs, so the core goes to other tasks.  Before
+  * that, or in an interrupt, it waits on the HAL tick as HAL's own version does.
+  *
+  * @param: Delay - Delay duration in milliseconds
+  * @retval: none
+  */
+void HAL_Delay( uint32_t Delay )
+{
+  if( xTaskGetSchedulerState() == taskSCHEDULER_RUNNING && __get_IPSR() == 0U ) {
+    vTaskDelay( pdMS_TO_TICKS( Delay ) + 1U );            // At least Delay whole milliseconds, as HAL's
+    return;
+  }
+
+  const uint32_t start = HAL_GetTick();
+  uint32_t       wait  = Delay;
+
+  if( wait < HAL_MAX_DELAY ) {
+    wait += (uint32_t)uwTickFreq;
+  }
+  while( ( HAL_GetTick() - start ) < wait ) {
+  }
+}
+#endif
+
+#endif
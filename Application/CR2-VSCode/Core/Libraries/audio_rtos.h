@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file           : audio_rtos.h
+  * @brief          : FreeRTOS port of the audio engine: render task and command queue
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Runs the engine under FreeRTOS.  Build with AUDIO_ENGINE_ENABLE_RTOS and
+  * AUDIO_ENGINE_DEFERRED_RENDER (CMake AUDIO_ENGINE_RTOS):
+  *
+  *   AudioEngine_Init( DAC_MasterSwitch, ReadVolume, MX_I2S2_Init );
+  *   AudioRtos_Init();                         // Before or after vTaskStartScheduler()
+  *
+  *   void ChimeTask( void *arg )               // Any task below AUDIO_RTOS_RENDER_PRIORITY
+  *   {
+  *     const AudioRtos_Command ding = { .op = AUDIO_RTOS_PLAY,
+  *                                      .play = { ding_data, ding_size, 22050, 16, Mode_mono } };
+  *     for( ;; ) {
+  *       xSemaphoreTake( doorbell, portMAX_DELAY );
+  *       AudioRtos_Post( &ding, portMAX_DELAY );
+  *       AudioRtos_WaitForEnd( portMAX_DELAY );              // Blocks; other tasks run
+  *     }
+  *   }
+  *
+  * The I2S DMA interrupt hands the played periods over and wakes the render
+  * task with a direct-to-task notification, so the filter chain runs at task
+  * level and the kernel's own interrupts keep their timing.  The render task
+  * also takes commands from a queue, so tasks that play, pause or stop sounds
+  * are serialised with the render rather than racing it; engine setters may
+  * still be called directly, as before.  The render task's priority must be
+  * above that of every task that calls the engine, which is what the PendSV
+  * render relied on.
+  *
+  * The engine's blocking calls (WaitForSampleEnd(), AudioEngine_WaitForEvent())
+  * block on a semaphore the render task gives after each pass, and HAL_Delay()
+  * becomes vTaskDelay() once the scheduler runs, so no call spins the core.
+  * With a binary semaphore one waiting task wakes at each render; any other
+  * checks again within AUDIO_RTOS_WAIT_MS.  Queued commands run in the render
+  * task and must not block: DAC_MasterSwitch()'s 10 ms turn-on delay would
+  * hold up the render, so build with AUDIO_ENGINE_ENABLE_DAC_SETTLE.
+  *
+  * The kernel owns SVC and PendSV: map vPortSVCHandler and xPortPendSVHandler
+  * to SVC_Handler and PendSV_Handler in FreeRTOSConfig.h, which
+  * stm32g4xx_it.c leaves out in this build, and keep SysTick on HAL_IncTick()
+  * with AudioRtos_SysTick() for the kernel tick.  configPRIO_BITS is 4 on the
+  * G474, and the I2S DMA interrupt must be at or below
+  * configMAX_SYSCALL_INTERRUPT_PRIORITY to use the FromISR calls.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _AUDIO_RTOS_H
+#define _AUDIO_RTOS_H
+
+#include "main.h"
+#include "audio_engine.h"
+
+#include "FreeRTOS.h"
+
+#include <stdint.h>
+
+/* Priority of the render task, above every task that calls the engine */
+#ifndef AUDIO_RTOS_RENDER_PRIORITY
+#define AUDIO_RTOS_RENDER_PRIORITY ( configMAX_PRIORITIES - 1U )
+#endif
+
+/* Stack of the render task in words; the filter chain and the commands run on it */
+#ifndef AUDIO_RTOS_RENDER_STACK_WORDS
+#define AUDIO_RTOS_RENDER_STACK_WORDS 512U
+#endif
+
+/* Commands the queue holds */
+#ifndef AUDIO_RTOS_QUEUE_LENGTH
+#define AUDIO_RTOS_QUEUE_LENGTH 8U
+#endif
+
+/* Longest a blocking wait sleeps before it checks the engine again */
+#ifndef AUDIO_RTOS_WAIT_MS
+#define AUDIO_RTOS_WAIT_MS 10U
+#endif
+
+typedef enum {
+  AUDIO_RTOS_PLAY,                          // PlaySample() with .play
+  AUDIO_RTOS_PAUSE,                         // PausePlayback()
+  AUDIO_RTOS_RESUME,                        // ResumePlayback()
+  AUDIO_RTOS_STOP,                          // StopPlayback()
+  AUDIO_RTOS_CALL                           // .call.func( .call.arg ), for any other engine call
+} AudioRtos_Op;
+
+/* An engine command, run by the render task between renders */
+typedef struct {
+  AudioRtos_Op      op;
+  union {
+    struct {
+      const void     *sample;
+      uint32_t        size;                 // Total samples, all channels combined
+      uint32_t        rate;                 // Hz
+      uint8_t         depth;                // 8 or 16
+      PB_ModeTypeDef  mode;
+    } play;
+    struct {
+      void          ( *func )( void *arg ); // Must not block: no WaitForSampleEnd() or HAL_Delay()
+      void           *arg;
+    } call;
+  };
+} AudioRtos_Command;
+
+typedef enum {
+  AUDIO_RTOS_OK,
+  AUDIO_RTOS_NO_MEMORY,                     // The task, queue or semaphore could not be created
+  AUDIO_RTOS_QUEUE_FULL,                    // The command was not queued in time
+  AUDIO_RTOS_TIMEOUT,                       // Still playing when the wait ran out
+  AUDIO_RTOS_NOT_STARTED                    // AudioRtos_Init() has not run
+} AudioRtos_Status;
+
+/**
+ * @brief Create the render task, its command queue and the wake-up semaphore
+ * @return AUDIO_RTOS_OK, or AUDIO_RTOS_NO_MEMORY if the kernel heap is too small
+ * @note Call once, after AudioEngine_Init() and before any playback.
+ */
+AudioRtos_Status    AudioRtos_Init                    ( void );
+
+/**
+ * @brief Queue a command for the render task
+ * @param[in] command Command, copied into the queue
+ * @param[in] timeout Ticks to wait for room in the queue
+ * @return AUDIO_RTOS_OK once queued, AUDIO_RTOS_QUEUE_FULL otherwise
+ * @note Task context. The command runs at the render task's next pass, which it triggers.
+ */
+AudioRtos_Status    AudioRtos_Post                    ( const AudioRtos_Command *command, TickType_t timeout );
+
+/**
+ * @brief Queue a command from an interrupt, such as a trigger input's EXTI
+ * @param[in] command Command, copied into the queue
+ * @param[out] woken Set to pdTRUE if a context switch is due (portYIELD_FROM_ISR()); may be NULL
+ * @return AUDIO_RTOS_OK once queued, AUDIO_RTOS_QUEUE_FULL otherwise
+ */
+AudioRtos_Status    AudioRtos_PostFromISR             ( const AudioRtos_Command *command, BaseType_t *woken );
+
+/**
+ * @brief Block the calling task until nothing plays, commands queued before included
+ * @param[in] timeout Ticks to wait, portMAX_DELAY for no limit
+ * @return AUDIO_RTOS_OK once idle, AUDIO_RTOS_TIMEOUT if still playing
+ * @note Task context. Runs the event callback as WaitForSampleEnd() does, with
+ *       AUDIO_ENGINE_ENABLE_EVENTS, but does not stop the DMA afterwards.
+ */
+AudioRtos_Status    AudioRtos_WaitForEnd              ( TickType_t timeout );
+
+/**
+ * @brief Count the kernel tick; call from SysTick_Handler() after HAL_IncTick()
+ */
+void                AudioRtos_SysTick                 ( void );
+
+#endif // End of _AUDIO_RTOS_H
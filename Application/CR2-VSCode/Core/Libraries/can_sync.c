@@ -0,0 +1,434 @@
+/**
+  ******************************************************************************
+  * @file           : can_sync.c
+  * @brief          : Frame-synchronised playback across units over FDCAN
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Messages are classic CAN data frames with standard identifiers, little-endian:
+  *
+  *   CAN_SYNC_BASE_ID      sync       1 byte   sequence number
+  *   CAN_SYNC_BASE_ID + 1  follow-up  8 bytes  sequence number, 3 reserved, master frame
+  *   CAN_SYNC_BASE_ID + 2  cue        8 bytes  cue number, master start frame
+  *
+  * The sync has the lowest identifier, so it wins arbitration over the others.
+  * The master stores a Tx event for it, whose timestamp and the frame count read
+  * in the Tx event interrupt give the frame on which it went out.
+  *
+  * The interrupts only capture: clock updates and cues are handed to
+  * CanSync_Service() one at a time, and one arriving before the last was taken
+  * is dropped.
+  *
+  ******************************************************************************
+  */
+
+#include "audio_engine.h"
+
+#if AUDIO_ENGINE_ENABLE_DRIFT_TRIM && defined( HAL_FDCAN_MODULE_ENABLED )
+
+#include "can_sync.h"
+
+#define SYNC_ID                     ( CAN_SYNC_BASE_ID + 0U )
+#define FOLLOW_UP_ID                ( CAN_SYNC_BASE_ID + 1U )
+#define CUE_ID                      ( CAN_SYNC_BASE_ID + 2U )
+#define SYNC_TIMEOUT_MS             ( CAN_SYNC_INTERVAL_MS * 10U )
+#define TRIM_LIMIT_PPB              ( (int32_t)AUDIO_ENGINE_DRIFT_TRIM_MAX_PPM * 1000 )
+
+static          FDCAN_HandleTypeDef   *can                      = NULL;
+static const    CanSync_Config        *sync_cfg                 = NULL;
+static          uint32_t    frames_per_tick             = 0U;     // Stream frames per timestamp counter tick (a bit time), 16.16
+static          uint32_t    window_frames               = 0U;     // CAN_SYNC_DRIFT_WINDOW_MS in stream frames
+
+/* Master */
+static          uint8_t     tx_seq                      = 0U;
+static          uint32_t    next_sync_ms                = 0U;
+static volatile uint8_t     follow_ready                = 0U;     // A sync went out: send its follow-up
+static volatile uint8_t     follow_seq                  = 0U;
+static volatile uint32_t    follow_frame                = 0U;
+
+/* Slave, captured by the Rx interrupt */
+static          uint8_t     rx_seq                      = 0U;
+static          uint8_t     rx_valid                    = 0U;     // rx_frame waits for its follow-up
+static          uint32_t    rx_frame                    = 0U;     // Local frame the sync rx_seq went out on
+static volatile uint8_t     pair_ready                  = 0U;
+static volatile uint32_t    pair_master                 = 0U;
+static volatile uint32_t    pair_local                  = 0U;
+static volatile uint8_t     cue_ready                   = 0U;
+static volatile uint32_t    cue_number                  = 0U;
+static volatile uint32_t    cue_master                  = 0U;     // Master start frame
+
+/* Slave clock estimate */
+static          uint8_t     offset_valid                = 0U;
+static          uint8_t     drift_valid                 = 0U;
+static          uint32_t    offset                      = 0U;     // Master frame minus local frame
+static          int32_t     drift_ppb                   = 0;      // Master's gain on this unit's clock
+static          uint32_t    last_master                 = 0U;     // Master frame of the last sync
+static          uint32_t    last_sync_ms                = 0U;
+static          uint32_t    window_master               = 0U;     // Frames at the start of the drift window
+static          uint32_t    window_local                = 0U;
+
+/* Slave phase of a cued sound */
+static          uint8_t     cue_playing                 = 0U;
+static          uint32_t    cue_offset                  = 0U;     // Offset the sound was mapped with
+static          int32_t     cue_slip                    = 0;      // AudioEngine_GetDriftSlip() it started with
+
+
+static inline void     Put32( uint8_t *p, uint32_t v ) { p[ 0 ] = (uint8_t)v; p[ 1 ] = (uint8_t)( v >> 8 ); p[ 2 ] = (uint8_t)( v >> 16 ); p[ 3 ] = (uint8_t)( v >> 24 ); }
+static inline uint32_t Get32( const uint8_t *p ) { return (uint32_t)p[ 0 ] | ( (uint32_t)p[ 1 ] << 8 ) | ( (uint32_t)p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 ); }
+
+
+/* ===== Bus ===== */
+
+/** Queue a classic CAN data frame
+  *
+  * @param: id - Standard identifier
+  * @param: data - Payload
+  * @param: length - Payload bytes, 1-8
+  * @param: marker - Tx event marker, or -1 for no Tx event
+  * @retval: HAL_StatusTypeDef - HAL_OK once queued
+  */
+static HAL_StatusTypeDef SendMessage( uint32_t id, const uint8_t *data, uint32_t length, int32_t marker )
+{
+  const FDCAN_TxHeaderTypeDef header = {
+    .Identifier          = id,
+    .IdType              = FDCAN_STANDARD_ID,
+    .TxFrameType         = FDCAN_DATA_FRAME,
+    .DataLength          = length,                        // FDCAN_DLC_BYTES_n is n up to 8
+    .ErrorStateIndicator = FDCAN_ESI_ACTIVE,
+    .BitRateSwitch       = FDCAN_BRS_OFF,
+    .FDFormat            = FDCAN_CLASSIC_CAN,
+    .TxEventFifoControl  = ( marker >= 0 ) ? FDCAN_STORE_TX_EVENTS : FDCAN_NO_TX_EVENTS,
+    .MessageMarker       = ( marker >= 0 ) ? (uint32_t)marker : 0U
+  };
+  return HAL_FDCAN_AddMessageToTxFifoQ( can, &header, data );
+}
+
+
+/** Get the stream frame on which a message started on the bus
+  *
+  * @param: now_frames - AudioEngine_GetFrameCount() read with now_ticks
+  * @param: now_ticks - Timestamp counter read in the interrupt
+  * @param: stamp - Timestamp the FDCAN captured at the message's start of frame
+  * @retval: uint32_t - Stream frame
+  */
+static uint32_t FrameAtTimestamp( uint32_t now_frames, uint16_t now_ticks, uint32_t stamp )
+{
+  const uint16_t ticks = (uint16_t)( now_ticks - (uint16_t)stamp );
+  return now_frames - (uint32_t)( ( (uint64_t)ticks * frames_per_tick + 0x8000U ) >> 16 );
+}
+
+
+/* ===== Clock ===== */
+
+/** Take a master and local frame pair from a sync into the offset and drift
+  *
+  * @param: master - Master's frame the sync went out on
+  * @param: local - This unit's frame the sync went out on
+  * @retval: none
+  */
+static void UpdateClock( uint32_t master, uint32_t local )
+{
+  offset       = master - local;
+  last_master  = master;
+  last_sync_ms = HAL_GetTick();
+  if( !offset_valid ) {
+    offset_valid  = 1U;
+    window_master = master;
+    window_local  = local;
+    return;
+  }
+
+  const uint32_t span = local - window_local;
+  if( span < window_frames ) {
+    return;
+  }
+  const int32_t gained   = (int32_t)( ( master - window_master ) - span );
+  const int64_t measured = (int64_t)gained * 1000000000LL / (int64_t)span;
+  window_master = master;
+  window_local  = local;
+  if( measured > TRIM_LIMIT_PPB || measured < -TRIM_LIMIT_PPB ) {
+    drift_valid = 0U;                                     // The master restarted its stream: measure afresh
+    return;
+  }
+  drift_ppb   = drift_valid ? drift_ppb + ( (int32_t)measured - drift_ppb ) / 4 : (int32_t)measured;
+  drift_valid = 1U;
+}
+
+
+/** Map a master frame onto this unit's stream
+  *
+  * @param: master - Master's stream frame
+  * @retval: uint32_t - Local stream frame
+  */
+static uint32_t LocalFrame( uint32_t master )
+{
+  const int32_t ahead = (int32_t)( master - last_master );          // Master frames since the last sync
+  return master - offset - (uint32_t)(int32_t)( (int64_t)ahead * drift_ppb / 1000000000LL );
+}
+
+
+/** Run the output at the master's rate, pulling a cued sound back onto its timeline
+  *
+  * @param: none
+  * @retval: none
+  */
+static void UpdateTrim( void )
+{
+  int32_t trim = drift_valid ? drift_ppb : 0;
+
+  if( cue_playing ) {
+    const PB_StatusTypeDef state = GetPlaybackState();
+    if( state != PB_Playing && state != PB_Pausing ) {
+      cue_playing = 0U;
+    } else {                                              // Frames late against the master; the offset grows as it gains
+      const int32_t strayed = ( AudioEngine_GetDriftSlip() - cue_slip ) + (int32_t)( offset - cue_offset );
+      trim += strayed * CAN_SYNC_PHASE_GAIN_PPB;
+    }
+  }
+  trim = ( trim > TRIM_LIMIT_PPB ) ? TRIM_LIMIT_PPB : ( trim < -TRIM_LIMIT_PPB ) ? -TRIM_LIMIT_PPB : trim;
+  (void)AudioEngine_SetDriftTrim( trim );
+}
+
+
+/* ===== FDCAN Callbacks ===== */
+
+/** Capture syncs, follow-ups and cues
+  *
+  * @param: hfdcan - FDCAN handle
+  * @param: RxFifo0ITs - Rx FIFO 0 interrupts that fired
+  * @retval: none
+  */
+void HAL_FDCAN_RxFifo0Callback( FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo0ITs )
+{
+  if( hfdcan != can || ( RxFifo0ITs & FDCAN_IT_RX_FIFO0_NEW_MESSAGE ) == 0U ) {
+    return;
+  }
+  const uint16_t now_ticks  = HAL_FDCAN_GetTimestampCounter( hfdcan );
+  const uint32_t now_frames = AudioEngine_GetFrameCount();
+  FDCAN_RxHeaderTypeDef header;
+  uint8_t               data[ 8 ];
+
+  while( HAL_FDCAN_GetRxFifoFillLevel( hfdcan, FDCAN_RX_FIFO0 ) != 0U &&
+         HAL_FDCAN_GetRxMessage( hfdcan, FDCAN_RX_FIFO0, &header, data ) == HAL_OK ) {
+    if( sync_cfg->role == CAN_SYNC_MASTER || header.IdType != FDCAN_STANDARD_ID ) {
+      continue;
+    }
+    if( header.Identifier == SYNC_ID && header.DataLength >= FDCAN_DLC_BYTES_1 ) {
+      rx_seq   = data[ 0 ];
+      rx_frame = FrameAtTimestamp( now_frames, now_ticks, header.RxTimestamp );
+      rx_valid = 1U;
+    } else if( header.Identifier == FOLLOW_UP_ID && header.DataLength == FDCAN_DLC_BYTES_8 ) {
+      if( rx_valid && data[ 0 ] == rx_seq && !pair_ready ) {
+        pair_master = Get32( &data[ 4 ] );
+        pair_local  = rx_frame;
+        pair_ready  = 1U;
+      }
+      rx_valid = 0U;
+    } else if( header.Identifier == CUE_ID && header.DataLength == FDCAN_DLC_BYTES_8 && !cue_ready ) {
+      cue_number = Get32( &data[ 0 ] );
+      cue_master = Get32( &data[ 4 ] );
+      cue_ready  = 1U;
+    }
+  }
+}
+
+
+/** Capture the frame a master's sync went out on, for its follow-up
+  *
+  * @param: hfdcan - FDCAN handle
+  * @param: TxEventFifoITs - Tx event FIFO interrupts that fired
+  * @retval: none
+  */
+void HAL_FDCAN_TxEventFifoCallback( FDCAN_HandleTypeDef *hfdcan, uint32_t TxEventFifoITs )
+{
+  if( hfdcan != can || ( TxEventFifoITs & FDCAN_IT_TX_EVT_FIFO_NEW_DATA ) == 0U ) {
+    return;
+  }
+  const uint16_t now_ticks  = HAL_FDCAN_GetTimestampCounter( hfdcan );
+  const uint32_t now_frames = AudioEngine_GetFrameCount();
+  FDCAN_TxEventFifoTypeDef event;
+
+  while( ( hfdcan->Instance->TXEFS & FDCAN_TXEFS_EFFL ) != 0U && HAL_FDCAN_GetTxEvent( hfdcan, &event ) == HAL_OK ) {
+    follow_seq   = (uint8_t)event.MessageMarker;          // Only syncs store Tx events
+    follow_frame = FrameAtTimestamp( now_frames, now_ticks, event.TxTimestamp );
+    follow_ready = 1U;
+  }
+}
+
+
+/* ===== Public Interface ===== */
+
+/** Set up the filter, timestamp counter and notifications, and start the FDCAN
+  *
+  * @param: hfdcan - FDCAN handle initialised by the application, not started
+  * @param: config - Role, stream rate and cue function; must stay valid while the module is used
+  * @retval: CanSync_Status - CAN_SYNC_OK once started
+  */
+CanSync_Status CanSync_Init( FDCAN_HandleTypeDef *hfdcan, const CanSync_Config *config )
+{
+  if( hfdcan == NULL || config == NULL || config->cue == NULL || config->rate == 0U ||
+      hfdcan->Init.StdFiltersNbr <= CAN_SYNC_FILTER_INDEX ) {
+    return CAN_SYNC_BAD_CONFIG;
+  }
+
+  /* The timestamp counter ticks once a nominal bit time */
+  const uint32_t divider = ( hfdcan->Init.ClockDivider == FDCAN_CLOCK_DIV1 ) ? 1U : hfdcan->Init.ClockDivider * 2U;
+  const uint32_t bit_hz  = HAL_RCCEx_GetPeriphCLKFreq( RCC_PERIPHCLK_FDCAN ) /
+                           ( divider * hfdcan->Init.NominalPrescaler * ( 1U + hfdcan->Init.NominalTimeSeg1 + hfdcan->Init.NominalTimeSeg2 ) );
+  if( bit_hz == 0U ) {
+    return CAN_SYNC_BAD_CONFIG;
+  }
+
+  can             = hfdcan;
+  sync_cfg        = config;
+  frames_per_tick = (uint32_t)( ( (uint64_t)config->rate << 16 ) / bit_hz );
+  window_frames   = (uint32_t)( (uint64_t)config->rate * CAN_SYNC_DRIFT_WINDOW_MS / 1000U );
+  next_sync_ms    = HAL_GetTick();
+  follow_ready    = 0U;
+  rx_valid        = 0U;
+  pair_ready      = 0U;
+  cue_ready       = 0U;
+  offset_valid    = 0U;
+  drift_valid     = 0U;
+  cue_playing     = 0U;
+
+  const FDCAN_FilterTypeDef filter = {
+    .IdType       = FDCAN_STANDARD_ID,
+    .FilterIndex  = CAN_SYNC_FILTER_INDEX,
+    .FilterType   = FDCAN_FILTER_RANGE,
+    .FilterConfig = FDCAN_FILTER_TO_RXFIFO0,
+    .FilterID1    = SYNC_ID,
+    .FilterID2    = CUE_ID
+  };
+  if( HAL_FDCAN_ConfigFilter( hfdcan, &filter ) != HAL_OK ||
+      HAL_FDCAN_ConfigGlobalFilter( hfdcan, FDCAN_REJECT, FDCAN_REJECT, FDCAN_REJECT_REMOTE, FDCAN_REJECT_REMOTE ) != HAL_OK ||
+      HAL_FDCAN_ConfigTimestampCounter( hfdcan, FDCAN_TIMESTAMP_PRESC_1 ) != HAL_OK ||
+      HAL_FDCAN_EnableTimestampCounter( hfdcan, FDCAN_TIMESTAMP_INTERNAL ) != HAL_OK ||
+      HAL_FDCAN_ActivateNotification( hfdcan, FDCAN_IT_RX_FIFO0_NEW_MESSAGE | FDCAN_IT_TX_EVT_FIFO_NEW_DATA, 0U ) != HAL_OK ||
+      HAL_FDCAN_Start( hfdcan ) != HAL_OK ) {
+    return CAN_SYNC_CAN_ERROR;
+  }
+  return CAN_SYNC_OK;
+}
+
+
+/** Send the master's sync messages, update a slave's clock estimate and start cues
+  *
+  * @param: none
+  * @retval: none
+  */
+void CanSync_Service( void )
+{
+  uint8_t data[ 8 ] = { 0 };
+
+  if( can == NULL ) {
+    return;
+  }
+
+  if( sync_cfg->role == CAN_SYNC_MASTER ) {
+    if( follow_ready ) {
+      data[ 0 ] = follow_seq;
+      Put32( &data[ 4 ], follow_frame );
+      follow_ready = 0U;
+      (void)SendMessage( FOLLOW_UP_ID, data, FDCAN_DLC_BYTES_8, -1 );
+    }
+    const uint32_t now = HAL_GetTick();
+    if( (int32_t)( now - next_sync_ms ) >= 0 ) {
+      next_sync_ms = ( now - next_sync_ms < CAN_SYNC_INTERVAL_MS ) ? next_sync_ms + CAN_SYNC_INTERVAL_MS : now + CAN_SYNC_INTERVAL_MS;
+      data[ 0 ] = ++tx_seq;
+      (void)SendMessage( SYNC_ID, data, FDCAN_DLC_BYTES_1, tx_seq );
+    }
+    return;
+  }
+
+  if( pair_ready ) {
+    UpdateClock( pair_master, pair_local );
+    pair_ready = 0U;
+    UpdateTrim();
+  } else if( drift_valid && HAL_GetTick() - last_sync_ms > SYNC_TIMEOUT_MS ) {
+    drift_valid = 0U;                                     // Master gone: hold the last trim until it returns
+  }
+
+  if( cue_ready ) {
+    const uint32_t cue    = cue_number;
+    const uint32_t master = cue_master;
+    cue_ready = 0U;
+    if( offset_valid ) {
+      const uint32_t local = LocalFrame( master );
+      cue_offset  = master - local;
+      cue_slip    = AudioEngine_GetDriftSlip();
+      cue_playing = 1U;
+      sync_cfg->cue( cue, local - (uint32_t)cue_slip );   // A sound still in the line delays it by the slip
+    }
+  }
+}
+
+
+/** Cue a sound on every unit, this one included, a number of frames from now
+  *
+  * @param: cue - Application's sound number
+  * @param: lead_frames - Frames from now to the start
+  * @retval: CanSync_Status - CAN_SYNC_OK once sent and started here
+  */
+CanSync_Status CanSync_Cue( uint32_t cue, uint32_t lead_frames )
+{
+  uint8_t data[ 8 ];
+
+  if( can == NULL || sync_cfg->role != CAN_SYNC_MASTER ) {
+    return CAN_SYNC_NOT_MASTER;
+  }
+  const uint32_t start = AudioEngine_GetFrameCount() + lead_frames;
+  Put32( &data[ 0 ], cue );
+  Put32( &data[ 4 ], start );
+  if( SendMessage( CUE_ID, data, FDCAN_DLC_BYTES_8, -1 ) != HAL_OK ) {
+    return CAN_SYNC_CAN_ERROR;
+  }
+  sync_cfg->cue( cue, start );
+  return CAN_SYNC_OK;
+}
+
+
+uint8_t CanSync_IsLocked( void )
+{
+  if( can == NULL ) {
+    return 0U;
+  }
+  return ( sync_cfg->role == CAN_SYNC_MASTER || drift_valid ) ? 1U : 0U;
+}
+
+
+int32_t CanSync_GetDrift( void )
+{
+  return drift_ppb;
+}
+
+
+uint32_t CanSync_GetOffset( void )
+{
+  return offset;
+}
+
+#endif // AUDIO_ENGINE_ENABLE_DRIFT_TRIM && HAL_FDCAN_MODULE_ENABLED
@@ -0,0 +1,174 @@
+/**
+  ******************************************************************************
+  * @file           : can_sync.h
+  * @brief          : Frame-synchronised playback across units over FDCAN
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Lets several chimes on one CAN bus play a sound on the same frame, and keep
+  * it in step while it plays.  One unit is the master; it cues sounds for all of
+  * them, itself included:
+  *
+  *   MX_FDCAN1_Init();                         // hfdcan1, classic CAN
+  *   AudioEngine_Init( DAC_MasterSwitch, ReadVolume, MX_I2S2_Init );
+  *   AudioEngine_StartStream( 22050 );         // Every unit, at the same rate
+  *   CanSync_Init( &hfdcan1, &sync_config );
+  *   while( 1 ) {
+  *     CanSync_Service();
+  *     if( triggered ) { CanSync_Cue( sound_id, 11025 );  }    // Master: half a second ahead
+  *   }
+  *
+  *   void PlayCue( uint32_t cue, uint32_t start_frame )        // sync_config.cue, every unit
+  *   {
+  *     PlaySampleAt( sounds[ cue ].data, sounds[ cue ].size, 16, Mode_mono, start_frame );
+  *   }
+  *
+  * Every CAN_SYNC_INTERVAL_MS the master broadcasts a sync message, then a
+  * follow-up carrying the AudioEngine_GetFrameCount() at which the sync went out.
+  * Each unit notes its own frame count when the sync arrives, so it knows the
+  * offset between the master's stream and its own, and over
+  * CAN_SYNC_DRIFT_WINDOW_MS how fast the two crystals drift apart.  Both ends read
+  * the frame count in the FDCAN interrupt and correct it by the FDCAN timestamp
+  * counter, which the controller captures at the start of the frame on the bus,
+  * so the time the interrupt waits behind the audio render does not count.
+  *
+  * A cue carries the master's start frame; each unit maps it onto its own
+  * stream and calls the application's cue function, which starts the sound with
+  * PlaySampleAt().  While a cued sound plays, AudioEngine_SetDriftTrim() runs it
+  * at the master's rate and pulls back what it has strayed, so a long
+  * announcement stays in step to within a frame or two.  The I2S clock itself
+  * cannot be nudged on the G474, as its PLL has no fractional divider, so the
+  * trim slips frames in the engine's output (AUDIO_ENGINE_ENABLE_DRIFT_TRIM).
+  *
+  * The module implements HAL_FDCAN_RxFifo0Callback() and
+  * HAL_FDCAN_TxEventFifoCallback().  It takes standard filter element
+  * CAN_SYNC_FILTER_INDEX and Rx FIFO 0, and rejects frames no filter accepts;
+  * other traffic can use the remaining filters with Rx FIFO 1.  Cue lead times
+  * must be at least one ring (AudioEngine_GetBufferGeometry()) plus the bus
+  * latency for the start to be exact on every unit.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _CAN_SYNC_H
+#define _CAN_SYNC_H
+
+#include "main.h"
+#include "audio_engine.h"
+
+#include <stdint.h>
+
+/* Standard identifiers: sync, follow-up and cue are CAN_SYNC_BASE_ID to CAN_SYNC_BASE_ID + 2 */
+#ifndef CAN_SYNC_BASE_ID
+#define CAN_SYNC_BASE_ID 0x640U
+#endif
+
+/* Standard filter element the module configures */
+#ifndef CAN_SYNC_FILTER_INDEX
+#define CAN_SYNC_FILTER_INDEX 0U
+#endif
+
+/* Time between the master's sync messages */
+#ifndef CAN_SYNC_INTERVAL_MS
+#define CAN_SYNC_INTERVAL_MS 100U
+#endif
+
+/* Span over which the drift is measured: each reading is good to a frame, which over 5 s at
+ * 22 kHz is 9 ppm, and successive windows are averaged */
+#ifndef CAN_SYNC_DRIFT_WINDOW_MS
+#define CAN_SYNC_DRIFT_WINDOW_MS 5000U
+#endif
+
+/* Extra trim per frame a playing sound has strayed from the master's timeline, in parts
+ * per billion: 20000 pulls back one frame in about two seconds at 22 kHz */
+#ifndef CAN_SYNC_PHASE_GAIN_PPB
+#define CAN_SYNC_PHASE_GAIN_PPB 20000
+#endif
+
+/* Called from CanSync_Service() on every unit to start cue cue on stream frame start_frame */
+typedef void ( *CanSync_CueFunc )( uint32_t cue, uint32_t start_frame );
+
+typedef enum {
+  CAN_SYNC_SLAVE,
+  CAN_SYNC_MASTER
+} CanSync_Role;
+
+typedef struct {
+  CanSync_Role      role;                   // One master per bus
+  uint32_t          rate;                   // Hz, the rate every unit's stream runs at
+  CanSync_CueFunc   cue;
+} CanSync_Config;
+
+typedef enum {
+  CAN_SYNC_OK,
+  CAN_SYNC_BAD_CONFIG,                      // A NULL handle or function, or no rate
+  CAN_SYNC_CAN_ERROR,                       // The FDCAN did not start, or the message was not queued
+  CAN_SYNC_NOT_MASTER                       // CanSync_Cue() on a slave
+} CanSync_Status;
+
+/**
+ * @brief Set up the filter, timestamp counter and notifications, and start the FDCAN
+ * @param[in] hfdcan FDCAN handle initialised by the application (classic or FD frames), not started
+ * @param[in] config Role, stream rate and cue function; must stay valid while the module is used
+ * @return CAN_SYNC_OK once started
+ */
+CanSync_Status      CanSync_Init                      ( FDCAN_HandleTypeDef *hfdcan, const CanSync_Config *config );
+
+/**
+ * @brief Send the master's sync messages, update a slave's clock estimate and start cues
+ * @note Application context only, from the main loop, at least every CAN_SYNC_INTERVAL_MS / 2.
+ *       Needs the stream running (AudioEngine_StartStream()).
+ */
+void                CanSync_Service                   ( void );
+
+/**
+ * @brief Cue a sound on every unit, this one included, a number of frames from now
+ * @param[in] cue Application's sound number, passed to every unit's cue function
+ * @param[in] lead_frames Frames from now to the start; at least a ring plus a few milliseconds
+ * @return CAN_SYNC_OK once sent and started here, CAN_SYNC_NOT_MASTER on a slave
+ */
+CanSync_Status      CanSync_Cue                       ( uint32_t cue, uint32_t lead_frames );
+
+/**
+ * @brief Check whether this unit follows the master's clock
+ * @return 1 once a slave has measured its drift (the master always), 0 until then or when
+ *         the syncs have stopped for ten intervals
+ */
+uint8_t             CanSync_IsLocked                  ( void );
+
+/**
+ * @brief Get the drift measured against the master
+ * @return Parts per billion the master's clock runs fast against this unit's
+ */
+int32_t             CanSync_GetDrift                  ( void );
+
+/**
+ * @brief Get the offset between the master's stream and this unit's
+ * @return Master frame count minus this unit's at the last sync (wrapping)
+ */
+uint32_t            CanSync_GetOffset                 ( void );
+
+#endif // End of _CAN_SYNC_H
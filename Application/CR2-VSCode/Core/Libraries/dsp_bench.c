@@ -0,0 +1,215 @@
+/**
+  ******************************************************************************
+  * @file           : dsp_bench.c
+  * @brief          : On-target cycle benchmark of the audio engine DSP stages
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * The board has no UART wired, so the report goes out over SWO.  Cycles per sample are
+  * printed with two decimals from integers, as newlib-nano's printf() has no floating point.
+  *
+  ******************************************************************************
+  */
+
+#include "dsp_bench.h"
+#include <stdio.h>
+
+#if !AUDIO_ENGINE_ENABLE_PROFILING
+#error "The DSP benchmark needs AUDIO_ENGINE_ENABLE_PROFILING=1"
+#endif
+
+
+/** Send printf() output to ITM stimulus port 0 (syscalls.c _write())
+  *
+  * ITM_SendChar() drops the character when no debugger has enabled the port.
+  *
+  * @param: ch - Character
+  * @retval: The character
+  */
+int __io_putchar( int ch )
+{
+  (void)ITM_SendChar( (uint32_t)ch );
+  return ch;
+}
+
+
+#if AUDIO_ENGINE_ENABLE_CMSIS_DSP || AUDIO_ENGINE_ENABLE_FLOAT_DSP
+/** Time stages on the native kernels and on an alternative kernel set, side by side
+  *
+  * @param: label - Column heading for the alternative kernels
+  * @param: select - Switches the alternative kernels on (1) or off (0)
+  * @param: stages - Stages to time
+  * @param: count - Number of stages
+  * @retval: none
+  */
+static void BenchmarkKernelSets( const char *label, void ( *select )( uint8_t ),
+                                 const AudioEngine_BenchStage *stages, uint32_t count )
+{
+  AudioEngine_BenchResult native;
+  AudioEngine_BenchResult other;
+
+  printf( "\r\n%-20s %10s %10s %8s\r\n", "stage", "native", label, "ratio" );
+  for( uint32_t i = 0; i < count; i++ ) {
+    const char *name = AudioEngine_BenchStageName( stages[ i ] );
+    select( 0U );
+    const uint8_t timed = AudioEngine_Benchmark( stages[ i ], DSP_BENCH_PERIODS, &native );
+    select( 1U );
+    if( !timed || !AudioEngine_Benchmark( stages[ i ], DSP_BENCH_PERIODS, &other ) || native.cycles == 0U ) {
+      printf( "%-20s %10s\r\n", name, "skipped" );
+      continue;
+    }
+    const uint32_t ratio_x100 = (uint32_t)( ( (uint64_t)other.cycles * 100U ) / native.cycles );
+    printf( "%-20s %10lu %10lu %5lu.%02lu\r\n", name, (unsigned long)native.cycles, (unsigned long)other.cycles,
+            (unsigned long)( ratio_x100 / 100U ), (unsigned long)( ratio_x100 % 100U ) );
+  }
+}
+#endif
+
+
+#if AUDIO_ENGINE_ENABLE_CMSIS_DSP
+/** Time the stages with a CMSIS-DSP form on the native kernels and on CMSIS-DSP, side by side
+  *
+  * With no speaker FIR loaded, a DSP_BENCH_FIR_TAPS test set stands in for the comparison; the
+  * cost depends only on the number of taps.  The float kernels, if built, are off meanwhile.
+  *
+  * @param: none
+  * @retval: none
+  */
+static void BenchmarkCmsisDsp( void )
+{
+  static const AudioEngine_BenchStage stages[] = {
+    BENCH_LPF_16BIT, BENCH_SPEAKER_FIR, BENCH_CHAIN_16BIT, BENCH_CHUNK_16BIT_STEREO
+  };
+  const uint8_t  was_on  = AudioEngine_GetCmsisDsp();
+#if AUDIO_ENGINE_ENABLE_FLOAT_DSP
+  const uint8_t  was_flt = AudioEngine_GetFloatDsp();
+#endif
+#if AUDIO_ENGINE_FIR_MAX_TAPS > 0
+  const uint8_t  own_fir = AudioEngine_GetSpeakerFirActive();
+  static int16_t taps[ DSP_BENCH_FIR_TAPS ];
+
+  if( !own_fir ) {
+    for( uint32_t k = 0; k < DSP_BENCH_FIR_TAPS; k++ ) {
+      taps[ k ] = (int16_t)( 16384 >> ( k / 4U ) );        // A decaying impulse
+    }
+    (void)AudioEngine_SetSpeakerFir( taps, DSP_BENCH_FIR_TAPS );
+  }
+#endif
+#if AUDIO_ENGINE_ENABLE_FLOAT_DSP
+  AudioEngine_SetFloatDsp( 0U );
+#endif
+
+  BenchmarkKernelSets( "cmsis-dsp", AudioEngine_SetCmsisDsp, stages, sizeof( stages ) / sizeof( stages[ 0 ] ) );
+
+  AudioEngine_SetCmsisDsp( was_on );
+#if AUDIO_ENGINE_ENABLE_FLOAT_DSP
+  AudioEngine_SetFloatDsp( was_flt );
+#endif
+#if AUDIO_ENGINE_FIR_MAX_TAPS > 0
+  if( !own_fir ) {
+    (void)AudioEngine_SetSpeakerFir( NULL, 0U );
+  }
+#endif
+}
+#endif
+
+
+#if AUDIO_ENGINE_ENABLE_FLOAT_DSP
+/** Time the stages with a float form on the fixed-point kernels and in float, side by side
+  *
+  * CMSIS-DSP, if built, is off meanwhile, so the LPF's native column is the Q16 biquad.
+  *
+  * @param: none
+  * @retval: none
+  */
+static void BenchmarkFloatDsp( void )
+{
+  static const AudioEngine_BenchStage stages[] = {
+    BENCH_LPF_16BIT, BENCH_DC_FILTER, BENCH_AIR_EFFECT, BENCH_FADE, BENCH_CHAIN_16BIT, BENCH_CHUNK_16BIT_STEREO
+  };
+  const uint8_t was_on    = AudioEngine_GetFloatDsp();
+#if AUDIO_ENGINE_ENABLE_CMSIS_DSP
+  const uint8_t was_cmsis = AudioEngine_GetCmsisDsp();
+
+  AudioEngine_SetCmsisDsp( 0U );
+#endif
+
+  BenchmarkKernelSets( "float", AudioEngine_SetFloatDsp, stages, sizeof( stages ) / sizeof( stages[ 0 ] ) );
+
+  AudioEngine_SetFloatDsp( was_on );
+#if AUDIO_ENGINE_ENABLE_CMSIS_DSP
+  AudioEngine_SetCmsisDsp( was_cmsis );
+#endif
+}
+#endif
+
+
+/** Time every DSP stage with nothing playing and print the results over SWO
+  *
+  * @param: none
+  * @retval: none
+  */
+void Benchmark_Run( void )
+{
+  AudioEngine_BenchResult result;
+
+  setvbuf( stdout, NULL, _IONBF, 0 );                     // Each character straight to the ITM
+  printf( "\r\nDSP benchmark: %lu Hz core, %lu periods per stage%s\r\n",
+          (unsigned long)SystemCoreClock, (unsigned long)DSP_BENCH_PERIODS,
+          AUDIO_ENGINE_ENABLE_CONSTANT_TIME ? ", constant-time kernels" : "" );
+  printf( "%-20s %10s %10s %10s %8s %12s\r\n", "stage", "cycles", "min", "max", "samples", "cyc/sample" );
+
+  for( uint32_t stage = 0; stage < BENCH_STAGE_COUNT; stage++ ) {
+    const char *name = AudioEngine_BenchStageName( (AudioEngine_BenchStage)stage );
+    if( !AudioEngine_Benchmark( (AudioEngine_BenchStage)stage, DSP_BENCH_PERIODS, &result ) ) {
+      printf( "%-20s %10s\r\n", name, "skipped" );
+      continue;
+    }
+    printf( "%-20s %10lu %10lu %10lu %8lu %9lu.%02lu\r\n", name, (unsigned long)result.cycles,
+            (unsigned long)result.min_cycles, (unsigned long)result.max_cycles, (unsigned long)result.samples,
+            (unsigned long)( result.cycles_per_sample_x100 / 100U ),
+            (unsigned long)( result.cycles_per_sample_x100 % 100U ) );
+  }
+#if AUDIO_ENGINE_ENABLE_CMSIS_DSP
+  BenchmarkCmsisDsp();
+#endif
+#if AUDIO_ENGINE_ENABLE_FLOAT_DSP
+  BenchmarkFloatDsp();
+#endif
+#if AUDIO_ENGINE_ENABLE_LOAD_ADMISSION
+  /* The cost table for the load admission model, ready to paste into the build's definitions */
+  if( AudioEngine_CalibrateLoadModel() ) {
+    static const char *const names[ COST_STAGE_COUNT ] = {
+      "BASE_16BIT", "BASE_8BIT", "LPF_16BIT", "LPF_8BIT", "AIR_EFFECT", "NOISE_GATE", "SOFT_CLIP"
+    };
+    for( uint32_t stage = 0; stage < COST_STAGE_COUNT; stage++ ) {
+      printf( "-DAUDIO_ENGINE_COST_%s=%luU\r\n", names[ stage ],
+              (unsigned long)AudioEngine_GetStageCost( (AudioEngine_CostStage)stage ) );
+    }
+  }
+#endif
+  printf( "Done\r\n" );
+}
@@ -0,0 +1,73 @@
+/**
+  ******************************************************************************
+  * @file           : dsp_bench.h
+  * @brief          : On-target cycle benchmark of the audio engine DSP stages
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Times every DSP stage and chunk processor of the audio engine over fixed test vectors with
+  * the DWT cycle counter (AudioEngine_Benchmark()), and prints cycles per period and per
+  * sample over SWO, through printf() and the ITM stimulus port 0.  The min and max columns are
+  * the cheapest and dearest runs over quieter data as well; built with
+  * AUDIO_ENGINE_ENABLE_CONSTANT_TIME, max is the configuration's measured worst case:
+  *
+  *   Benchmark_Run();                      // After AudioEngine_Init() and the filter setup
+  *
+  * The CR2-VSCode-bench firmware (AUDIO_ENGINE_BENCHMARK in CMakeLists.txt) runs it
+  * in place of the main loop.  The engine must be built with AUDIO_ENGINE_ENABLE_PROFILING=1;
+  * built with AUDIO_ENGINE_ENABLE_CMSIS_DSP or AUDIO_ENGINE_ENABLE_FLOAT_DSP as well, it also
+  * times the stages with a CMSIS-DSP or float form on both kernel sets, side by side.
+  * Read the output with the debugger's SWO viewer at the core clock.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _DSP_BENCH_H
+#define _DSP_BENCH_H
+
+#include "main.h"
+#include "audio_engine.h"
+
+#include <stdint.h>
+
+/* Timed runs per stage, each over one DMA period */
+#ifndef DSP_BENCH_PERIODS
+#define DSP_BENCH_PERIODS       64U
+#endif
+
+/* Taps of the test speaker FIR timed against CMSIS-DSP when the application has none loaded */
+#ifndef DSP_BENCH_FIR_TAPS
+#define DSP_BENCH_FIR_TAPS      32U
+#endif
+
+/**
+ * @brief Time every DSP stage with nothing playing and print the results over SWO
+ * @note Application context only. Takes DSP_BENCH_PERIODS periods' worth of rendering per
+ *       stage, well under a second, and leaves the engine idle.
+ */
+void                Benchmark_Run                     ( void );
+
+#endif // End of _DSP_BENCH_H
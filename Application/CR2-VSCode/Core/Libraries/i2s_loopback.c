@@ -0,0 +1,482 @@
+/**
+  ******************************************************************************
+  * @file           : i2s_loopback.c
+  * @brief          : On-target I2S loopback capture of the audio engine output
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * The capture runs below the engine's DMA interrupt, so it cannot delay a render; a half
+  * of the ring it reaches only after the DMA has come round to it again is counted as late,
+  * and that case's report is not to be trusted.  The report goes out over SWO as for the
+  * DSP benchmark, in the line format Host/loopback_check.py reads:
+  *
+  *   LBK <cases> <segment frames>
+  *   LBC <name> <rate> <channels> <bits> <frames> <host_render options>
+  *   LBF <frames captured> <first non-silent frame> <late halves> <underruns>
+  *   LBS <segment> <CRC-32>
+  *   LBK END
+  *
+  ******************************************************************************
+  */
+
+#include "i2s_loopback.h"
+#include <stdio.h>
+#include <string.h>
+
+#if AUDIO_ENGINE_OUTPUT_ZONES > 1
+#error "The loopback capture takes SPI3, which an extra output zone may be using"
+#endif
+
+#define LOOPBACK_MAX_SEGMENTS   16U                         // Segments kept per case: 64 K frames at the default size
+#define LOOPBACK_MAX_MS         300U                        // Longest test input
+#define LOOPBACK_CAPTURE_IRQ    7U                          // Below the engine's DMA1_Channel1 (6)
+
+/* Half-words the DMA moves per stereo frame: the high half of a 32-bit sample comes first */
+#if AUDIO_ENGINE_OUTPUT_32BIT
+#define LOOPBACK_FRAME_HALFWORDS 4U
+#else
+#define LOOPBACK_FRAME_HALFWORDS 2U
+#endif
+
+/* One test case: an input format and the host_render options it is rendered with */
+typedef struct {
+  const char *name;
+  uint32_t    rate;
+  uint8_t     channels;
+  uint8_t     bits;
+  LPF_Level   lpf;
+  uint8_t     air_db;                                       // 0 for the air effect off
+  uint8_t     noise_gate;
+  uint8_t     soft_clip;
+  uint8_t     hard_dc;
+  uint8_t     faders;
+  int16_t     fade_in_ms;                                   // -1 for the engine's default
+  int16_t     fade_out_ms;
+} LoopbackCase;
+
+static const LoopbackCase loopback_cases[] = {
+  { "m16_22k_off",  22050U, 1U, 16U, LPF_Off,        0U, 0U, 1U, 0U, 1U,  -1,  -1 },
+  { "s16_44k_soft", 44100U, 2U, 16U, LPF_Soft,       0U, 0U, 1U, 0U, 1U,  10,  20 },
+  { "s8_16k_air",   16000U, 2U,  8U, LPF_Medium,     3U, 0U, 1U, 0U, 1U,  -1,  -1 },
+  { "m8_11k_gate",  11025U, 1U,  8U, LPF_Firm,       0U, 1U, 0U, 1U, 0U,  -1,  -1 },   // The 8-bit prefill with no fade-in
+  { "m16_48k_aggr", 48000U, 1U, 16U, LPF_Aggressive, 0U, 0U, 1U, 0U, 1U, 300, 300 },
+};
+#define LOOPBACK_CASES ( sizeof( loopback_cases ) / sizeof( loopback_cases[ 0 ] ) )
+
+static const char *const lpf_names[] = { "off", "very-soft", "soft", "medium", "firm", "aggressive" };
+
+/* Capture: SPI3 as an I2S slave receiver, its DMA ring folded into CRCs as it fills */
+static I2S_HandleTypeDef  hi2s3;
+static DMA_HandleTypeDef  hdma_spi3_rx;
+static uint16_t           capture_ring[ LOOPBACK_RING_FRAMES * LOOPBACK_FRAME_HALFWORDS ];
+static uint32_t           capture_next      = 0U;           // Ring frame the capture has reached
+static uint32_t           capture_frames    = 0U;           // Frames folded in
+static uint32_t           capture_first     = UINT32_MAX;   // First frame with a sample other than 0
+static uint32_t           capture_late      = 0U;           // Halves the DMA had overwritten before they were read
+static uint32_t           capture_crc       = 0U;           // Running CRC of the current segment
+static uint32_t           capture_crcs[ LOOPBACK_MAX_SEGMENTS ];
+
+static uint8_t            loopback_input[ LOOPBACK_INPUT_BYTES ] __attribute__( ( aligned( 4 ) ) );
+
+
+/** Send printf() output to ITM stimulus port 0 (syscalls.c _write())
+  *
+  * @param: ch - Character
+  * @retval: The character
+  */
+int __io_putchar( int ch )
+{
+  (void)ITM_SendChar( (uint32_t)ch );
+  return ch;
+}
+
+
+/* Full volume, as host_render plays */
+static uint16_t LoopbackVolume( void )
+{
+  return 65535U;
+}
+
+
+/** Add a byte to a CRC-32 (IEEE 802.3, as zlib's crc32()), a nibble at a time
+  *
+  * @param: crc - CRC so far, before the final inversion
+  * @param: byte - Next byte
+  * @retval: uint32_t - Updated CRC
+  */
+static inline uint32_t Crc32Byte( uint32_t crc, uint8_t byte )
+{
+  static const uint32_t nibble[ 16 ] = {
+    0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU, 0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+    0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU, 0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU
+  };
+
+  crc = ( crc >> 4 ) ^ nibble[ ( crc ^ byte ) & 0x0FU ];
+  return ( crc >> 4 ) ^ nibble[ ( crc ^ ( byte >> 4 ) ) & 0x0FU ];
+}
+
+
+/** Fold captured frames into the segment CRCs, as host_render writes them to its file
+  *
+  * @param: end - Ring frame to capture up to, exclusive; below capture_next when the ring wrapped
+  * @retval: none
+  */
+static void CaptureUpTo( uint32_t end )
+{
+  while( capture_next != end ) {
+    const uint16_t *hw = &capture_ring[ capture_next * LOOPBACK_FRAME_HALFWORDS ];
+    uint8_t         audible = 0U;
+
+    for( uint32_t c = 0; c < 2U; c++ ) {
+#if AUDIO_ENGINE_OUTPUT_32BIT
+      const uint32_t sample = ( (uint32_t)hw[ 2U * c ] << 16 ) | hw[ 2U * c + 1U ];
+      for( uint32_t b = 0; b < 4U; b++ ) {
+        capture_crc = Crc32Byte( capture_crc, (uint8_t)( sample >> ( 8U * b ) ) );
+      }
+#else
+      const uint32_t sample = hw[ c ];
+      capture_crc = Crc32Byte( capture_crc, (uint8_t)sample );
+      capture_crc = Crc32Byte( capture_crc, (uint8_t)( sample >> 8 ) );
+#endif
+      audible |= ( sample != 0U ) ? 1U : 0U;
+    }
+    if( audible && capture_first == UINT32_MAX ) {
+      capture_first = capture_frames;
+    }
+    capture_frames++;
+    if( capture_frames % LOOPBACK_SEGMENT_FRAMES == 0U ) {
+      const uint32_t segment = capture_frames / LOOPBACK_SEGMENT_FRAMES - 1U;
+      if( segment < LOOPBACK_MAX_SEGMENTS ) {
+        capture_crcs[ segment ] = ~capture_crc;
+      }
+      capture_crc = 0xFFFFFFFFU;
+    }
+    capture_next = ( capture_next + 1U < LOOPBACK_RING_FRAMES ) ? capture_next + 1U : 0U;
+  }
+}
+
+
+/* Ring frame the DMA writes next */
+static uint32_t CaptureDmaFrame( void )
+{
+  const uint32_t written = (uint32_t)( LOOPBACK_RING_FRAMES * LOOPBACK_FRAME_HALFWORDS ) -
+                           __HAL_DMA_GET_COUNTER( &hdma_spi3_rx );
+  return ( written / LOOPBACK_FRAME_HALFWORDS ) % LOOPBACK_RING_FRAMES;
+}
+
+
+/** Capture a finished half of the ring
+  *
+  * @param: end - Frame the half ends at
+  * @retval: none
+  */
+static void CaptureHalf( uint32_t end )
+{
+  const uint32_t half = LOOPBACK_RING_FRAMES / 2U;
+
+  CaptureUpTo( end % LOOPBACK_RING_FRAMES );
+  /* The DMA should still be in the other half; back in this one, it wrote over frames unread */
+  if( ( CaptureDmaFrame() < half ) == ( end == half ) ) {
+    capture_late++;
+  }
+}
+
+
+void HAL_I2S_RxHalfCpltCallback( I2S_HandleTypeDef *hi2s )
+{
+  if( hi2s == &hi2s3 ) {
+    CaptureHalf( LOOPBACK_RING_FRAMES / 2U );
+  }
+}
+
+
+void HAL_I2S_RxCpltCallback( I2S_HandleTypeDef *hi2s )
+{
+  if( hi2s == &hi2s3 ) {
+    CaptureHalf( LOOPBACK_RING_FRAMES );
+  }
+}
+
+
+/**
+  * @brief This function handles DMA1 channel3 global interrupt (the capture DMA).
+  */
+void DMA1_Channel3_IRQHandler( void )
+{
+  HAL_DMA_IRQHandler( &hdma_spi3_rx );
+}
+
+
+/** Set SPI3 up as an I2S slave receiver with its DMA, in the format the engine sends
+  *
+  * @param: none
+  * @retval: none
+  */
+static void CaptureInit( void )
+{
+  GPIO_InitTypeDef gpio = { 0 };
+
+  __HAL_RCC_SPI3_CLK_ENABLE();
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+  __HAL_RCC_GPIOC_CLK_ENABLE();
+
+  /* PA15 I2S3_WS, PC10 I2S3_CK, PC12 I2S3_SD */
+  gpio.Mode      = GPIO_MODE_AF_PP;
+  gpio.Pull      = GPIO_NOPULL;
+  gpio.Speed     = GPIO_SPEED_FREQ_MEDIUM;
+  gpio.Alternate = GPIO_AF6_SPI3;
+  gpio.Pin       = GPIO_PIN_15;
+  HAL_GPIO_Init( GPIOA, &gpio );
+  gpio.Pin       = GPIO_PIN_10 | GPIO_PIN_12;
+  HAL_GPIO_Init( GPIOC, &gpio );
+
+  hdma_spi3_rx.Instance                 = DMA1_Channel3;
+  hdma_spi3_rx.Init.Request             = DMA_REQUEST_SPI3_RX;
+  hdma_spi3_rx.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+  hdma_spi3_rx.Init.PeriphInc           = DMA_PINC_DISABLE;
+  hdma_spi3_rx.Init.MemInc              = DMA_MINC_ENABLE;
+  hdma_spi3_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  hdma_spi3_rx.Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+  hdma_spi3_rx.Init.Mode                = DMA_CIRCULAR;
+  hdma_spi3_rx.Init.Priority            = DMA_PRIORITY_HIGH;  // A dropped frame here would look like the engine's
+  if( HAL_DMA_Init( &hdma_spi3_rx ) != HAL_OK ) {
+    Error_Handler();
+  }
+  __HAL_LINKDMA( &hi2s3, hdmarx, hdma_spi3_rx );
+  HAL_NVIC_SetPriority( DMA1_Channel3_IRQn, LOOPBACK_CAPTURE_IRQ, 0 );
+  HAL_NVIC_EnableIRQ( DMA1_Channel3_IRQn );
+
+  hi2s3.Instance        = SPI3;
+  hi2s3.Init.Mode       = I2S_MODE_SLAVE_RX;
+  hi2s3.Init.Standard   = I2S_STANDARD_PHILIPS;
+#if AUDIO_ENGINE_OUTPUT_32BIT
+  hi2s3.Init.DataFormat = I2S_DATAFORMAT_32B;
+#else
+  hi2s3.Init.DataFormat = I2S_DATAFORMAT_16B;
+#endif
+  hi2s3.Init.MCLKOutput = I2S_MCLKOUTPUT_DISABLE;
+  hi2s3.Init.AudioFreq  = I2S_AUDIOFREQ_DEFAULT;           // The master's clock sets the rate
+  hi2s3.Init.CPOL       = I2S_CPOL_LOW;
+  if( HAL_I2S_Init( &hi2s3 ) != HAL_OK ) {
+    Error_Handler();
+  }
+}
+
+
+/** Arm the slave for a capture, before the playback starts the master's clocks
+  *
+  * @param: none
+  * @retval: none
+  */
+static void CaptureStart( void )
+{
+  capture_next  = 0U;
+  capture_frames = 0U;
+  capture_first = UINT32_MAX;
+  capture_late  = 0U;
+  capture_crc   = 0xFFFFFFFFU;
+  if( HAL_I2S_Receive_DMA( &hi2s3, capture_ring, (uint16_t)( LOOPBACK_RING_FRAMES * LOOPBACK_FRAME_HALFWORDS ) ) != HAL_OK ) {
+    Error_Handler();
+  }
+}
+
+
+/** Take the rest of a capture once the master has stopped
+  *
+  * @param: none
+  * @retval: none
+  */
+static void CaptureStop( void )
+{
+  HAL_Delay( 2U );                                          // The last frame out of the shift register
+  HAL_NVIC_DisableIRQ( DMA1_Channel3_IRQn );
+  const uint32_t end = CaptureDmaFrame();
+  (void)HAL_I2S_DMAStop( &hi2s3 );
+  CaptureUpTo( end );
+  const uint32_t segment = capture_frames / LOOPBACK_SEGMENT_FRAMES;
+  if( capture_frames % LOOPBACK_SEGMENT_FRAMES != 0U && segment < LOOPBACK_MAX_SEGMENTS ) {
+    capture_crcs[ segment ] = ~capture_crc;
+  }
+  HAL_NVIC_ClearPendingIRQ( DMA1_Channel3_IRQn );
+  HAL_NVIC_EnableIRQ( DMA1_Channel3_IRQn );
+}
+
+
+/** Write a case's test input: a rising triangle chirp, a full-scale square burst that drives
+  * the soft clipper, then low-level noise for the noise gate
+  *
+  * Integer only, so Host/loopback_check.py builds the same samples bit for bit.
+  *
+  * @param: test - Test case
+  * @param: frames - Frames to write
+  * @retval: none
+  */
+static void MakeTestInput( const LoopbackCase *test, uint32_t frames )
+{
+  uint32_t phase = 0U;
+  uint32_t step  = 0x01000000U;
+  uint32_t noise = 1U;
+
+  for( uint32_t n = 0; n < frames; n++ ) {
+    for( uint32_t c = 0; c < test->channels; c++ ) {
+      int32_t v;
+
+      if( n < frames / 2U ) {
+        const int32_t t = (int32_t)( ( phase + c * 0x40000000U ) >> 16 );
+        v = ( ( ( t < 32768 ) ? t : 65535 - t ) * 2 - 32767 ) * 23 >> 5;
+      } else if( n < frames * 3U / 4U ) {
+        v = ( ( n / ( 7U + 5U * c ) ) & 1U ) ? 32767 : -32767;
+      } else {
+        noise = noise * 1664525U + 1013904223U;
+        v = (int32_t)( ( noise >> 16 ) & 127U ) - 64;
+      }
+      const uint32_t i = n * test->channels + c;
+      if( test->bits == 16U ) {
+        ( (int16_t *)loopback_input )[ i ] = (int16_t)v;
+      } else {
+        loopback_input[ i ] = (uint8_t)( ( v >> 8 ) + 128 );
+      }
+    }
+    phase += step;
+    step  += 0x8000U;
+  }
+}
+
+
+/** Print a case's host_render options
+  *
+  * @param: test - Test case
+  * @retval: none
+  */
+static void PrintHostOptions( const LoopbackCase *test )
+{
+  printf( " --lpf %s", lpf_names[ test->lpf ] );
+  if( test->air_db != 0U ) {
+    printf( " --air %u", (unsigned)test->air_db );
+  }
+  if( test->noise_gate ) {
+    printf( " --noise-gate" );
+  }
+  if( !test->soft_clip ) {
+    printf( " --no-soft-clip" );
+  }
+  if( test->hard_dc ) {
+    printf( " --hard-dc" );
+  }
+  if( test->fade_in_ms >= 0 ) {
+    printf( " --fade-in %d.%03d", test->fade_in_ms / 1000, test->fade_in_ms % 1000 );
+  }
+  if( test->fade_out_ms >= 0 ) {
+    printf( " --fade-out %d.%03d", test->fade_out_ms / 1000, test->fade_out_ms % 1000 );
+  }
+  if( !test->faders ) {
+    printf( " --no-faders" );
+  }
+}
+
+
+/** Play every loopback test case, capture the I2S output and print the report over SWO
+  *
+  * Each case is set up from the engine's defaults in the order host_render applies its
+  * options, so the two differ only in what the hardware does to the stream.
+  *
+  * @param: dac_switch - DAC power switch
+  * @param: i2s_init - I2S2 init function
+  * @retval: none
+  */
+void Loopback_Run( DAC_SwitchFunc dac_switch, I2S_InitFunc i2s_init )
+{
+  FilterConfig_TypeDef defaults;
+
+  setvbuf( stdout, NULL, _IONBF, 0 );                     // Each character straight to the ITM
+  if( AudioEngine_Init( dac_switch, LoopbackVolume, i2s_init ) != PB_Idle ) {
+    Error_Handler();
+  }
+  SetDAC_Control( 1 );
+  CaptureInit();
+
+  GetFilterConfig( &defaults );
+  const float fade_in  = GetFadeInTime();
+  const float fade_out = GetFadeOutTime();
+  const float air_db   = GetAirEffectGainDb();
+
+  printf( "\r\nLBK %lu %lu\r\n", (unsigned long)LOOPBACK_CASES, (unsigned long)LOOPBACK_SEGMENT_FRAMES );
+  for( uint32_t k = 0; k < LOOPBACK_CASES; k++ ) {
+    const LoopbackCase  *test   = &loopback_cases[ k ];
+    const uint32_t       fit    = LOOPBACK_INPUT_BYTES / ( test->channels * ( test->bits / 8U ) );
+    const uint32_t       frames = ( test->rate * LOOPBACK_MAX_MS / 1000U < fit ) ? test->rate * LOOPBACK_MAX_MS / 1000U : fit;
+    FilterConfig_TypeDef cfg    = defaults;
+
+    cfg.enable_noise_gate           = test->noise_gate;
+    cfg.enable_soft_clipping        = test->soft_clip;
+    cfg.enable_soft_dc_filter_16bit = (uint8_t)!test->hard_dc;
+    (void)SetFilterConfig( &cfg );
+    SetFadersEnabled( test->faders );
+    SetFadeInTime( ( test->fade_in_ms >= 0 ) ? (float)test->fade_in_ms * 0.001f : fade_in );
+    SetFadeOutTime( ( test->fade_out_ms >= 0 ) ? (float)test->fade_out_ms * 0.001f : fade_out );
+    if( test->bits == 16U ) {
+      SetLpf16BitLevel( test->lpf );
+    } else {
+      SetLpf8BitLevel( test->lpf );
+    }
+    SetAirEffectGainDb( ( test->air_db != 0U ) ? (float)test->air_db : air_db );
+    SetAirEffectEnable( ( test->air_db != 0U ) ? 1U : 0U );
+    MakeTestInput( test, frames );
+
+    printf( "LBC %s %lu %u %u %lu", test->name, (unsigned long)test->rate, (unsigned)test->channels,
+            (unsigned)test->bits, (unsigned long)frames );
+    PrintHostOptions( test );
+    printf( "\r\n" );
+
+#if AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR
+    AudioEngine_ResetDeadlineStats();
+#endif
+    CaptureStart();
+    if( PlaySample( loopback_input, frames * test->channels, test->rate, test->bits,
+                    ( test->channels == 2U ) ? Mode_stereo : Mode_mono ) != PB_Playing ) {
+      printf( "LBF failed\r\n" );
+      CaptureStop();
+      continue;
+    }
+    (void)WaitForSampleEnd();
+    CaptureStop();
+
+    uint32_t underruns = 0U;
+#if AUDIO_ENGINE_ENABLE_DEADLINE_MONITOR
+    AudioEngine_DeadlineStats stats;
+    AudioEngine_GetDeadlineStats( &stats );
+    underruns = stats.underruns;
+#endif
+    printf( "LBF %lu %ld %lu %lu\r\n", (unsigned long)capture_frames,
+            ( capture_first == UINT32_MAX ) ? -1L : (long)capture_first,
+            (unsigned long)capture_late, (unsigned long)underruns );
+    const uint32_t segments = ( capture_frames + LOOPBACK_SEGMENT_FRAMES - 1U ) / LOOPBACK_SEGMENT_FRAMES;
+    for( uint32_t s = 0; s < segments && s < LOOPBACK_MAX_SEGMENTS; s++ ) {
+      printf( "LBS %lu %08lX\r\n", (unsigned long)s, (unsigned long)capture_crcs[ s ] );
+    }
+  }
+  printf( "LBK END\r\n" );
+}
@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file           : i2s_loopback.h
+  * @brief          : On-target I2S loopback capture of the audio engine output
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Plays a fixed set of test cases through the engine and captures what the I2S2 master
+  * actually sends, with SPI3 as an I2S slave receiver wired back to it on a test jig:
+  *
+  *   PB13 I2S2_CK -> PC10 I2S3_CK
+  *   PB12 I2S2_WS -> PA15 I2S3_WS
+  *   PB15 I2S2_SD -> PC12 I2S3_SD
+  *
+  * The slave is armed before each playback starts the master's clocks, so frame 0 of the
+  * capture is the first frame the DMA sent.  Each capture is folded into CRC-32s of
+  * LOOPBACK_SEGMENT_FRAMES frames as it arrives, with its length and first non-silent frame,
+  * and reported over SWO with the test case's host_render options:
+  *
+  *   Loopback_Run( DAC_MasterSwitch, MX_I2S2_Init );   // In place of the engine setup
+  *
+  * The CR2-VSCode-loopback firmware (AUDIO_ENGINE_LOOPBACK_TEST in CMakeLists.txt) runs it
+  * in place of the main loop.  Host/loopback_check.py renders the same cases with host_render
+  * and compares: a late render, a DMA race or a prefill fault shows as a segment whose CRC
+  * differs, or as a start or length off by some frames, where the host render matches.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _I2S_LOOPBACK_H
+#define _I2S_LOOPBACK_H
+
+#include "main.h"
+#include "audio_engine.h"
+
+#include <stdint.h>
+
+/* Frames per CRC segment, the resolution a mismatch is located to */
+#ifndef LOOPBACK_SEGMENT_FRAMES
+#define LOOPBACK_SEGMENT_FRAMES 4096U
+#endif
+
+/* Frames of the capture DMA ring, processed half at a time */
+#ifndef LOOPBACK_RING_FRAMES
+#define LOOPBACK_RING_FRAMES    1024U
+#endif
+
+/* RAM for the test input; each case is as long as fits, up to 0.3 s */
+#ifndef LOOPBACK_INPUT_BYTES
+#define LOOPBACK_INPUT_BYTES    32768U
+#endif
+
+/**
+ * @brief Play every loopback test case, capture the I2S output and print the report over SWO
+ * @param[in] dac_switch DAC power switch, as for AudioEngine_Init()
+ * @param[in] i2s_init I2S2 init function, as for AudioEngine_Init()
+ * @note Application context only, after the clock, GPIO and DMA setup and in place of
+ *       AudioEngine_Init(): the engine is initialised here at full volume with its defaults,
+ *       as host_render has it. Takes a few seconds and leaves the engine idle.
+ */
+void                Loopback_Run                      ( DAC_SwitchFunc dac_switch, I2S_InitFunc i2s_init );
+
+#endif // End of _I2S_LOOPBACK_H
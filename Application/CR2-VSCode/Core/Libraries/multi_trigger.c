@@ -0,0 +1,286 @@
+/**
+  ******************************************************************************
+  * @file           : multi_trigger.c
+  * @brief          : Independent trigger inputs, each starting its own sound on a mixer voice
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  *
+  * @attention
+  *
+  * Each input is a small state machine on its own compare channel of a free-running 16-bit
+  * counter at 1 MHz:
+  *
+  *   idle        a rising edge arms the compare MULTI_TRIGGER_CONFIRM_US ahead
+  *   confirming  an edge re-arms it; the compare fires the input if it is high, else idles it
+  *   held        an edge re-arms the compare MULTI_TRIGGER_RELEASE_US ahead; the compare
+  *               idles the input if it is low, and leaves it held if it is high
+  *
+  * A channel with nothing to time has its interrupt off, so an idle input costs nothing.
+  *
+  ******************************************************************************
+  */
+
+#include "audio_engine.h"
+
+#if AUDIO_ENGINE_MIXER_VOICES > 0
+
+#include "multi_trigger.h"
+
+#include <string.h>
+
+#if MULTI_TRIGGER_CONFIRM_US < 1 || MULTI_TRIGGER_CONFIRM_US > 65535
+#error "MULTI_TRIGGER_CONFIRM_US must be 1-65535: the debounce timer counts 16 bits of microseconds"
+#endif
+#if MULTI_TRIGGER_RELEASE_US < 1 || MULTI_TRIGGER_RELEASE_US > 65535
+#error "MULTI_TRIGGER_RELEASE_US must be 1-65535: the debounce timer counts 16 bits of microseconds"
+#endif
+
+#define TIMER_TICK_HZ               1000000U
+
+typedef enum {
+  INPUT_IDLE,
+  INPUT_CONFIRMING,
+  INPUT_HELD
+} InputState;
+
+static          TIM_TypeDef               *timer                    = NULL;
+static const    MultiTrigger_Input        *trigger_inputs           = NULL;
+static          uint8_t                    input_count              = 0U;
+static          uint8_t                    input_state[ MULTI_TRIGGER_MAX_INPUTS ];
+static volatile MultiTrigger_Stats         input_stats[ MULTI_TRIGGER_MAX_INPUTS ];
+
+
+/** Timer kernel clock of a timer, from the APB it sits on
+  *
+  * @param: tim - Timer instance
+  * @retval: Hz before the timer's prescaler
+  */
+static uint32_t TimerKernelClock( const TIM_TypeDef *tim )
+{
+  uint8_t apb2 = ( tim == TIM1 || tim == TIM8 || tim == TIM15 || tim == TIM16 || tim == TIM17 ) ? 1U : 0U;
+#if defined( TIM20 )
+  apb2 |= ( tim == TIM20 ) ? 1U : 0U;
+#endif
+  if( apb2 ) {
+    return HAL_RCC_GetPCLK2Freq() * ( ( ( RCC->CFGR & RCC_CFGR_PPRE2_2 ) != 0U ) ? 2U : 1U );   // Doubled behind a divided APB
+  }
+  return HAL_RCC_GetPCLK1Freq() * ( ( ( RCC->CFGR & RCC_CFGR_PPRE1_2 ) != 0U ) ? 2U : 1U );
+}
+
+
+/** Time an input: its compare a number of microseconds from now, its interrupt on
+  *
+  * The compare is moved before the flag is cleared, so a match of the old compare cannot
+  * follow the clear.  A new compare so close that it matched before the clear, or while a
+  * higher-priority interrupt held the arming up, has its flag raised again by software rather
+  * than waiting for the counter to come round.
+  *
+  * @param: input - Input, which is its channel
+  * @param: us - Microseconds, 1-65535
+  * @retval: none
+  */
+static void ArmInput( uint8_t input, uint32_t us )
+{
+  const uint32_t start = timer->CNT;
+
+  ( &timer->CCR1 )[ input ] = ( start + us ) & 0xFFFFU;
+  timer->SR    = ~( TIM_SR_CC1IF << input );              // rc_w0: clears this flag only
+  timer->DIER |= TIM_DIER_CC1IE << input;
+  if( ( ( timer->CNT - start ) & 0xFFFFU ) >= us ) {
+    timer->EGR = TIM_EGR_CC1G << input;                   // Already passed: the match's flag, now
+  }
+}
+
+
+/** Stop timing an input
+  *
+  * @param: input - Input, which is its channel
+  * @retval: none
+  */
+static void DisarmInput( uint8_t input )
+{
+  timer->DIER &= ~( TIM_DIER_CC1IE << input );
+  timer->SR    = ~( TIM_SR_CC1IF << input );
+}
+
+
+/** Read an input's level
+  *
+  * @param: input - Input
+  * @retval: 1 if high
+  */
+static inline uint8_t InputHigh( uint8_t input )
+{
+  return ( trigger_inputs[ input ].port->IDR & trigger_inputs[ input ].pin ) ? 1U : 0U;
+}
+
+
+/** Start the debounce timer and arm the inputs
+  *
+  * @param: tim - Four-channel timer, clocked by the application
+  * @param: inputs - Input table, kept
+  * @param: count - Inputs in the table, 1-MULTI_TRIGGER_MAX_INPUTS
+  * @retval: MULTI_TRIGGER_OK once armed, MULTI_TRIGGER_BAD_CONFIG for an unusable table
+  */
+MultiTrigger_Status MultiTrigger_Init( TIM_TypeDef *tim, const MultiTrigger_Input *inputs, uint8_t count )
+{
+  uint16_t pins = 0U;
+
+  if( tim == NULL || inputs == NULL || count == 0U || count > MULTI_TRIGGER_MAX_INPUTS ) {
+    return MULTI_TRIGGER_BAD_CONFIG;
+  }
+  for( uint8_t i = 0U; i < count; i++ ) {
+    const AudioAsset *asset = inputs[ i ].asset;
+
+    if( inputs[ i ].port == NULL || inputs[ i ].pin == 0U || ( pins & inputs[ i ].pin ) != 0U || asset == NULL ||
+        ( asset->encoding != ASSET_PCM16 && asset->encoding != ASSET_PCM8 ) ) {
+      return MULTI_TRIGGER_BAD_CONFIG;                    // A pin number twice would share its EXTI line
+    }
+    pins |= inputs[ i ].pin;
+  }
+
+  tim->CR1   = 0U;
+  tim->DIER  = 0U;
+  tim->CCMR1 = 0U;                                        // Frozen output compare: the channels only time
+  tim->CCMR2 = 0U;
+  tim->CCER  = 0U;
+  tim->PSC   = TimerKernelClock( tim ) / TIMER_TICK_HZ - 1U;
+  tim->ARR   = 0xFFFFU;
+  tim->EGR   = TIM_EGR_UG;                                // Load the prescaler
+  tim->SR    = 0U;
+
+  timer          = tim;
+  trigger_inputs = inputs;
+  input_count    = count;
+  memset( (void *)input_stats, 0, sizeof( input_stats ) );
+  tim->CR1       = TIM_CR1_CEN;
+
+  for( uint8_t i = 0U; i < count; i++ ) {
+    input_state[ i ] = INPUT_IDLE;
+    if( InputHigh( i ) ) {
+      input_state[ i ] = INPUT_HELD;                      // Not a press: wait for it to be let go
+      ArmInput( i, MULTI_TRIGGER_RELEASE_US );
+    }
+  }
+  return MULTI_TRIGGER_OK;
+}
+
+
+/** Take an edge of an input
+  *
+  * @param: pin - GPIO_PIN_x whose EXTI line fired
+  * @retval: none
+  */
+void MultiTrigger_Edge( uint16_t pin )
+{
+  for( uint8_t i = 0U; i < input_count; i++ ) {
+    if( trigger_inputs[ i ].pin != pin ) {
+      continue;
+    }
+    switch( input_state[ i ] ) {
+      case INPUT_IDLE:
+        if( InputHigh( i ) ) {
+          input_state[ i ] = INPUT_CONFIRMING;
+          ArmInput( i, MULTI_TRIGGER_CONFIRM_US );
+        }
+        break;
+
+      case INPUT_CONFIRMING:
+        ArmInput( i, MULTI_TRIGGER_CONFIRM_US );          // The input must hold still for the whole time
+        break;
+
+      default:
+        ArmInput( i, MULTI_TRIGGER_RELEASE_US );
+        break;
+    }
+    return;
+  }
+}
+
+
+/** Confirm or release the inputs whose debounce time has run out
+  *
+  * @param: none
+  * @retval: none
+  */
+void MultiTrigger_TimerIrq( void )
+{
+  if( timer == NULL ) {
+    return;
+  }
+
+  const uint32_t due = timer->SR & timer->DIER;
+
+  for( uint8_t i = 0U; i < input_count; i++ ) {
+    if( ( due & ( TIM_SR_CC1IF << i ) ) == 0U ) {
+      continue;
+    }
+    DisarmInput( i );
+
+    const MultiTrigger_Input *input = &trigger_inputs[ i ];
+    const uint8_t             high  = InputHigh( i );
+
+    if( input_state[ i ] == INPUT_CONFIRMING ) {
+      if( !high ) {
+        input_state[ i ] = INPUT_IDLE;
+        input_stats[ i ].rejected++;
+        continue;
+      }
+      if( AudioEngine_TriggerVoice( input->asset, input->gain, input->pan, input->priority ) == PB_Idle ) {
+        input_stats[ i ].fired++;
+      } else {
+        input_stats[ i ].dropped++;
+      }
+      input_state[ i ] = INPUT_HELD;
+      ArmInput( i, MULTI_TRIGGER_RELEASE_US );            // Let go within the time, and a bounce there, is still this press
+    } else if( !high ) {
+      input_state[ i ] = INPUT_IDLE;                      // Low and still: the next rising edge is a new press
+    }                                                     // Still held: its falling edge times the release
+  }
+}
+
+
+/** Get an input's counts
+  *
+  * @param: input - Index into the input table
+  * @param: stats - Filled with the counts since MultiTrigger_Init()
+  * @retval: none
+  */
+void MultiTrigger_GetStats( uint8_t input, MultiTrigger_Stats *stats )
+{
+  if( stats == NULL ) {
+    return;
+  }
+  if( input >= input_count ) {
+    memset( stats, 0, sizeof( *stats ) );
+    return;
+  }
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *stats = input_stats[ input ];
+  __set_PRIMASK( primask );
+}
+
+#endif // AUDIO_ENGINE_MIXER_VOICES > 0
@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * @file           : multi_trigger.h
+  * @brief          : Independent trigger inputs, each starting its own sound on a mixer voice
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Up to four active-high inputs, such as a front door, a back door and an intercom, each
+  * play their own sound, and sounds of different inputs overlap through the mixer:
+  *
+  *   AudioEngine_Init( DAC_MasterSwitch, ReadVolume, MX_I2S2_Init );
+  *   AudioEngine_StartStream( 22050 );
+  *   __HAL_RCC_TIM3_CLK_ENABLE();
+  *   MultiTrigger_Init( TIM3, trigger_inputs, 3 );
+  *
+  *   void HAL_GPIO_EXTI_Callback( uint16_t pin )   { MultiTrigger_Edge( pin ); }
+  *   void TIM3_IRQHandler( void )                  { MultiTrigger_TimerIrq(); }
+  *
+  * Each input is debounced on its own channel of one timer counting microseconds: an edge
+  * arms the input's compare MULTI_TRIGGER_CONFIRM_US ahead, any further edge re-arms it, and
+  * the input fires when the compare finds it still high.  It then re-arms only once it has
+  * been low and still for MULTI_TRIGGER_RELEASE_US, so a held or bouncing button plays once.
+  *
+  * A firing input queues its asset from the timer interrupt (AudioEngine_TriggerVoice()),
+  * with no main loop or polling in between.  From the edge to the sound leaving the DAC is
+  * then at most MULTI_TRIGGER_CONFIRM_US, plus the interrupt latency, plus one ring
+  * (AudioEngine_GetBufferGeometry()).  The stream must run while the inputs are armed.
+  *
+  * The inputs are GPIO EXTI lines on both edges, set up by the application, each on a
+  * different pin number.  Give the EXTI interrupts and the timer's the same priority: the
+  * handlers share the timer's registers and each input's state.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _MULTI_TRIGGER_H
+#define _MULTI_TRIGGER_H
+
+#include "main.h"
+#include "audio_engine.h"
+
+#include <stdint.h>
+
+/* Inputs, one per capture/compare channel of the debounce timer */
+#define MULTI_TRIGGER_MAX_INPUTS  4U
+
+/* An input must stay high this long from its last edge to fire (1-65535 us) */
+#ifndef MULTI_TRIGGER_CONFIRM_US
+#define MULTI_TRIGGER_CONFIRM_US  1000U
+#endif
+
+/* A fired input must be low and still this long before it can fire again (1-65535 us) */
+#ifndef MULTI_TRIGGER_RELEASE_US
+#define MULTI_TRIGGER_RELEASE_US  20000U
+#endif
+
+typedef struct {
+  GPIO_TypeDef       *port;
+  uint16_t            pin;                  // GPIO_PIN_x, its EXTI line on both edges
+  const AudioAsset   *asset;                // PCM16 or PCM8, played on a mixer voice
+  uint16_t            gain;                 // 0-65535, as for AudioEngine_PlayVoice()
+  int8_t              pan;
+  uint8_t             priority;
+} MultiTrigger_Input;
+
+/* Counts since MultiTrigger_Init() (MultiTrigger_GetStats()) */
+typedef struct {
+  uint32_t            fired;                // Confirmed presses queued for a voice
+  uint32_t            rejected;             // Rises that were low again when their confirm time ran out (glitches)
+  uint32_t            dropped;              // Confirmed presses AudioEngine_TriggerVoice() refused
+} MultiTrigger_Stats;
+
+typedef enum {
+  MULTI_TRIGGER_OK,
+  MULTI_TRIGGER_BAD_CONFIG                  // No or too many inputs, a NULL port, a non-PCM asset or a pin number twice
+} MultiTrigger_Status;
+
+/**
+ * @brief Start the debounce timer and arm the inputs
+ * @param[in] tim General-purpose or advanced timer with four channels, its clock and its
+ *            capture/compare interrupt in the NVIC enabled by the application
+ * @param[in] inputs Input table; must stay valid while the module is used
+ * @param[in] count Inputs in the table, 1-MULTI_TRIGGER_MAX_INPUTS; input n uses channel n + 1
+ * @return MULTI_TRIGGER_OK once armed
+ * @note An input already high is taken as held: it fires on its next press, not at start-up.
+ */
+MultiTrigger_Status MultiTrigger_Init                 ( TIM_TypeDef *tim, const MultiTrigger_Input *inputs, uint8_t count );
+
+/**
+ * @brief Take an edge of an input
+ * @param[in] pin GPIO_PIN_x whose EXTI line fired, as HAL_GPIO_EXTI_Callback() gets it
+ * @note From the EXTI interrupts; a pin that is no input is ignored.
+ */
+void                MultiTrigger_Edge                 ( uint16_t pin );
+
+/**
+ * @brief Confirm or release the inputs whose debounce time has run out
+ * @note From the timer's interrupt handler.
+ */
+void                MultiTrigger_TimerIrq             ( void );
+
+/**
+ * @brief Get an input's counts
+ * @param[in] input Index into the input table
+ * @param[out] stats Counts since MultiTrigger_Init(), all 0 for an input out of range
+ */
+void                MultiTrigger_GetStats             ( uint8_t input, MultiTrigger_Stats *stats );
+
+#endif // End of _MULTI_TRIGGER_H
@@ -0,0 +1,314 @@
+/**
+  ******************************************************************************
+  * @file           : pc_sampler.c
+  * @brief          : Statistical profiler sampling the interrupted PC on every SysTick
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Three histograms cover the code: flash up to _etext, and the two RAM regions the engine's
+  * DSP path can run from (.RamFunc inside .data, and .ccmram).  Each is divided into a fixed
+  * number of bins of a power-of-two size chosen at PcSampler_Start() from the region's
+  * length, so the resolution follows the image size; 2048 bins over 64 KB of code are 32 bytes
+  * each, a few instructions.  Counts saturate at 65535, a little over a minute in one bin.
+  *
+  * The report is plain text, one bin per line, so any SWO viewer or terminal log will do:
+  *
+  *   PCS <samples> <outside> <tick Hz>
+  *   PCR <region start> <bin shift>
+  *   <bin address> <count>
+  *   ...
+  *   PCS END
+  *
+  ******************************************************************************
+  */
+
+#include "pc_sampler.h"
+
+/* Vector table: 16 system exceptions and 102 interrupts (startup_stm32g474xx.s); VTOR needs
+   it aligned to its size rounded up to a power of two */
+#define PC_SAMPLER_VECTORS      118U
+#define PC_SAMPLER_REGIONS      3U
+
+typedef struct {
+  uint32_t  start;                                          // First code address
+  uint32_t  end;                                            // One past the last code address
+  uint32_t  shift;                                          // log2 of the bin size in bytes
+  uint32_t  bins;                                           // Bins in use
+  uint16_t  *counts;
+} PcSampler_Region;
+
+/* Linker script symbols */
+extern uint32_t _etext;
+extern uint32_t _sdata;
+extern uint32_t _edata;
+extern uint32_t _sccmram;
+extern uint32_t _eccmram;
+
+static uint32_t pc_sampler_vectors[ PC_SAMPLER_VECTORS ] __attribute__( ( aligned( 512 ) ) );
+static uint16_t pc_sampler_flash_counts[ PC_SAMPLER_FLASH_BINS ];
+static uint16_t pc_sampler_ram_counts[ PC_SAMPLER_REGIONS - 1U ][ PC_SAMPLER_RAM_BINS ];
+static PcSampler_Region pc_sampler_regions[ PC_SAMPLER_REGIONS ];
+
+static uint32_t          pc_sampler_saved_vtor;
+static volatile uint32_t pc_sampler_samples;
+static volatile uint32_t pc_sampler_outside;
+static volatile uint8_t  pc_sampler_running;
+
+
+/** Count one sampled PC in the histogram of the region it falls in
+  *
+  * Called from PcSampler_SysTickEntry() ahead of SysTick_Handler().
+  *
+  * @param: pc - Interrupted PC from the exception stack frame
+  * @retval: none
+  */
+__attribute__( ( used ) ) static void PcSampler_Record( uint32_t pc )
+{
+  if( !pc_sampler_running ) {
+    return;
+  }
+  pc_sampler_samples++;
+
+  for( uint32_t r = 0; r < PC_SAMPLER_REGIONS; r++ ) {
+    PcSampler_Region *region = &pc_sampler_regions[ r ];
+    if( pc >= region->start && pc < region->end ) {
+      uint16_t *count = &region->counts[ ( pc - region->start ) >> region->shift ];
+      if( *count < UINT16_MAX ) {
+        ( *count )++;
+      }
+      return;
+    }
+  }
+  pc_sampler_outside++;
+}
+
+
+/** SysTick entry in the RAM vector table: sample the interrupted PC, then run SysTick_Handler()
+  *
+  * The PC is word 6 of the exception stack frame, on the stack EXC_RETURN in LR names. r4 is
+  * pushed with LR only to keep the stack 8-byte aligned for the call.
+  *
+  * @param: none
+  * @retval: none
+  */
+__attribute__( ( naked ) ) static void PcSampler_SysTickEntry( void )
+{
+  __asm volatile(
+    "tst    lr, #4              \n"
+    "ite    eq                  \n"
+    "mrseq  r0, msp             \n"
+    "mrsne  r0, psp             \n"
+    "ldr    r0, [r0, #24]       \n"
+    "push   {r4, lr}            \n"
+    "bl     PcSampler_Record    \n"
+    "pop    {r4, lr}            \n"
+    "b      SysTick_Handler     \n"
+  );
+}
+
+
+/** Set up a region's histogram over [start, end) with the smallest bin size that fits
+  *
+  * @param: region - Region to set up
+  * @param: start  - First code address
+  * @param: end    - One past the last code address
+  * @param: counts - Bin counters
+  * @param: bins   - Number of bin counters
+  * @retval: none
+  */
+static void PcSampler_SetRegion( PcSampler_Region *region, uint32_t start, uint32_t end,
+                                 uint16_t *counts, uint32_t bins )
+{
+  uint32_t shift = 1U;                                      // Thumb instructions are halfword aligned
+
+  if( end < start ) {
+    end = start;
+  }
+  while( ( ( end - start ) >> shift ) >= bins ) {
+    shift++;
+  }
+  region->start  = start;
+  region->end    = end;
+  region->shift  = shift;
+  region->bins   = ( ( end - start ) >> shift ) + 1U;
+  region->counts = counts;
+  for( uint32_t i = 0; i < bins; i++ ) {
+    counts[ i ] = 0U;
+  }
+}
+
+
+/** Clear the histogram and start sampling the PC on every SysTick
+  *
+  * @param: none
+  * @retval: none
+  */
+void PcSampler_Start( void )
+{
+  const uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if( !pc_sampler_running ) {
+    const uint32_t *vectors = (const uint32_t *)SCB->VTOR;
+
+    pc_sampler_saved_vtor = SCB->VTOR;
+    for( uint32_t i = 0; i < PC_SAMPLER_VECTORS; i++ ) {
+      pc_sampler_vectors[ i ] = vectors[ i ];
+    }
+    pc_sampler_vectors[ (uint32_t)( SysTick_IRQn + 16 ) ] = (uint32_t)PcSampler_SysTickEntry;
+    __DSB();
+    SCB->VTOR = (uint32_t)pc_sampler_vectors;
+    __DSB();
+    __ISB();
+  }
+
+  PcSampler_SetRegion( &pc_sampler_regions[ 0 ], FLASH_BASE, (uint32_t)&_etext,
+                       pc_sampler_flash_counts, PC_SAMPLER_FLASH_BINS );
+  PcSampler_SetRegion( &pc_sampler_regions[ 1 ], (uint32_t)&_sdata, (uint32_t)&_edata,
+                       pc_sampler_ram_counts[ 0 ], PC_SAMPLER_RAM_BINS );
+  PcSampler_SetRegion( &pc_sampler_regions[ 2 ], (uint32_t)&_sccmram, (uint32_t)&_eccmram,
+                       pc_sampler_ram_counts[ 1 ], PC_SAMPLER_RAM_BINS );
+  pc_sampler_samples = 0U;
+  pc_sampler_outside = 0U;
+  pc_sampler_running = 1U;
+  __set_PRIMASK( primask );
+}
+
+
+/** Stop sampling and give the original vector table back
+  *
+  * @param: none
+  * @retval: none
+  */
+void PcSampler_Stop( void )
+{
+  const uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if( pc_sampler_running ) {
+    pc_sampler_running = 0U;
+    SCB->VTOR = pc_sampler_saved_vtor;
+    __DSB();
+    __ISB();
+  }
+  __set_PRIMASK( primask );
+}
+
+
+/** Total samples taken since PcSampler_Start()
+  *
+  * @param: none
+  * @retval: Samples, including those outside the code regions
+  */
+uint32_t PcSampler_GetSamples( void )
+{
+  return pc_sampler_samples;
+}
+
+
+/** Send one character of the report over ITM stimulus port 0
+  *
+  * ITM_SendChar() drops the character when no debugger has enabled the port.
+  *
+  * @param: ch - Character
+  * @retval: none
+  */
+__attribute__( ( weak ) ) void PcSampler_PutChar( char ch )
+{
+  (void)ITM_SendChar( (uint32_t)(uint8_t)ch );
+}
+
+
+/** Send a string, a hexadecimal or a decimal number through PcSampler_PutChar()
+  *
+  * @param: s / value - What to send
+  * @retval: none
+  */
+static void PcSampler_PutString( const char *s )
+{
+  while( *s != '\0' ) {
+    PcSampler_PutChar( *s++ );
+  }
+}
+
+static void PcSampler_PutHex( uint32_t value )
+{
+  for( int32_t nibble = 7; nibble >= 0; nibble-- ) {
+    PcSampler_PutChar( "0123456789abcdef"[ ( value >> ( (uint32_t)nibble * 4U ) ) & 0xFU ] );
+  }
+}
+
+static void PcSampler_PutDec( uint32_t value )
+{
+  char digits[ 10 ];
+  uint32_t n = 0;
+
+  do {
+    digits[ n++ ] = (char)( '0' + ( value % 10U ) );
+    value /= 10U;
+  } while( value != 0U );
+  while( n > 0U ) {
+    PcSampler_PutChar( digits[ --n ] );
+  }
+}
+
+
+/** Print the histogram as text through PcSampler_PutChar()
+  *
+  * @param: none
+  * @retval: none
+  */
+void PcSampler_Dump( void )
+{
+  PcSampler_PutString( "\r\nPCS " );
+  PcSampler_PutDec( pc_sampler_samples );
+  PcSampler_PutChar( ' ' );
+  PcSampler_PutDec( pc_sampler_outside );
+  PcSampler_PutChar( ' ' );
+  PcSampler_PutDec( 1000U / (uint32_t)HAL_GetTickFreq() );
+  PcSampler_PutString( "\r\n" );
+
+  for( uint32_t r = 0; r < PC_SAMPLER_REGIONS; r++ ) {
+    const PcSampler_Region *region = &pc_sampler_regions[ r ];
+    if( region->end == region->start ) {
+      continue;
+    }
+    PcSampler_PutString( "PCR " );
+    PcSampler_PutHex( region->start );
+    PcSampler_PutChar( ' ' );
+    PcSampler_PutDec( region->shift );
+    PcSampler_PutString( "\r\n" );
+    for( uint32_t i = 0; i < region->bins; i++ ) {
+      if( region->counts[ i ] != 0U ) {
+        PcSampler_PutHex( region->start + ( i << region->shift ) );
+        PcSampler_PutChar( ' ' );
+        PcSampler_PutDec( region->counts[ i ] );
+        PcSampler_PutString( "\r\n" );
+      }
+    }
+  }
+  PcSampler_PutString( "PCS END\r\n" );
+}
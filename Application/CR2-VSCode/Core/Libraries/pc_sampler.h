@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file           : pc_sampler.h
+  * @brief          : Statistical profiler sampling the interrupted PC on every SysTick
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  * Records where the core was at every SysTick (1 ms) into a histogram of code addresses,
+  * across a whole playback, without instrumenting any function.  The interrupted PC is read
+  * from the exception stack frame by a short entry routine placed in front of SysTick_Handler
+  * in a RAM copy of the vector table, so the handler in stm32g4xx_it.c is left alone:
+  *
+  *   PcSampler_Start();                    // Clears the histogram and starts sampling
+  *   PlaySample( ... );
+  *   WaitForSampleEnd();
+  *   PcSampler_Stop();
+  *   PcSampler_Dump();                     // Text report over SWO, see Docs/pc_profile.py
+  *
+  * The tick runs above the I2S DMA interrupt (TICK_INT_PRIORITY), so the DMA handler and the
+  * render are sampled too; only the EXTI trigger interrupt and the tick itself are not.
+  * Docs/pc_profile.py maps the report onto the firmware's symbols.  Built in with
+  * AUDIO_ENGINE_PC_SAMPLER in CMakeLists.txt.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _PC_SAMPLER_H
+#define _PC_SAMPLER_H
+
+#include "main.h"
+
+#include <stdint.h>
+
+/* Histogram bins over the code in flash, sized to the image at PcSampler_Start() */
+#ifndef PC_SAMPLER_FLASH_BINS
+#define PC_SAMPLER_FLASH_BINS   2048U
+#endif
+
+/* Histogram bins over each of the code regions in RAM (.RamFunc in SRAM and .ccmram) */
+#ifndef PC_SAMPLER_RAM_BINS
+#define PC_SAMPLER_RAM_BINS     128U
+#endif
+
+/**
+ * @brief Clear the histogram and start sampling the PC on every SysTick
+ * @note Application context only. Points SCB->VTOR at a RAM copy of the vector table.
+ */
+void                PcSampler_Start                   ( void );
+
+/**
+ * @brief Stop sampling and give the original vector table back
+ */
+void                PcSampler_Stop                    ( void );
+
+/**
+ * @brief Total samples taken since PcSampler_Start()
+ * @return Samples, including those outside the code regions
+ */
+uint32_t            PcSampler_GetSamples              ( void );
+
+/**
+ * @brief Print the histogram as text through PcSampler_PutChar()
+ * @note Application context only, after PcSampler_Stop(). Only non-empty bins are sent.
+ */
+void                PcSampler_Dump                    ( void );
+
+/**
+ * @brief Send one character of the report; weak, sends over ITM stimulus port 0 (SWO)
+ * @note Override to send the report over a UART instead.
+ * @param ch Character
+ */
+void                PcSampler_PutChar                 ( char ch );
+
+#endif // End of _PC_SAMPLER_H
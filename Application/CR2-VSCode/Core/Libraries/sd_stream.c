@@ -0,0 +1,671 @@
+/**
+  ******************************************************************************
+  * @file           : sd_stream.c
+  * @brief          : SD card (SPI mode) streaming source for the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Card access follows the SD Physical Layer Simplified Specification in SPI mode:
+  * SDv1 and SDv2 cards, standard and high capacity.  The file system side is only
+  * what streaming needs: the first FAT16 or FAT32 volume, 8.3 names in the root
+  * directory, and the cluster chain of the open file reduced to a few extents, so
+  * that a block read maps straight to a multi-block card read.
+  *
+  ******************************************************************************
+  */
+
+#include "sd_stream.h"
+#include <string.h>
+
+#if AUDIO_ENGINE_ENABLE_SOURCE_STREAM
+
+#if AUDIO_ENGINE_STREAM_BLOCK_BYTES < 512U
+#error "SD streaming needs AUDIO_ENGINE_STREAM_BLOCK_BYTES of at least one 512-byte sector"
+#endif
+
+#define SD_SECTOR_BYTES         512U
+#define SD_INIT_TIMEOUT_MS      1000U       // ACMD41 until the card leaves the idle state
+#define SD_READY_TIMEOUT_MS     500U        // Card busy between commands
+
+/* Commands (ACMDs are flagged with 0x80 and preceded by CMD55) */
+#define SD_CMD0                 0U          // GO_IDLE_STATE
+#define SD_CMD8                 8U          // SEND_IF_COND
+#define SD_CMD12                12U         // STOP_TRANSMISSION
+#define SD_CMD16                16U         // SET_BLOCKLEN
+#define SD_CMD17                17U         // READ_SINGLE_BLOCK
+#define SD_CMD18                18U         // READ_MULTIPLE_BLOCK
+#define SD_CMD55                55U         // APP_CMD
+#define SD_CMD58                58U         // READ_OCR
+#define SD_ACMD41               ( 0x80U | 41U )   // SD_SEND_OP_COND
+
+#define SD_R1_IDLE              0x01U
+#define SD_TOKEN_START_BLOCK    0xFEU
+
+typedef struct {
+  uint32_t        lba;                      // First sector of the run
+  uint32_t        sectors;
+} SdExtent;
+
+static const SdStream_Config *sd_cfg                    = NULL;
+static          uint8_t     sd_block_addressing         = 0U;         // SDHC/SDXC: commands take sectors, not bytes
+
+/* Mounted volume */
+static          uint8_t     fat32                       = 0U;
+static          uint8_t     sectors_per_cluster         = 0U;
+static          uint32_t    fat_lba                     = 0U;         // First sector of the first FAT
+static          uint32_t    data_lba                    = 0U;         // Sector of cluster 2
+static          uint32_t    root_lba                    = 0U;         // FAT16 root directory region
+static          uint32_t    root_sectors                = 0U;
+static          uint32_t    root_cluster                = 0U;         // FAT32 root directory chain
+
+/* Open file */
+static          SdExtent    extents[ SD_STREAM_MAX_EXTENTS ];
+static          uint8_t     extent_count                = 0U;
+static          uint32_t    file_size                   = 0U;
+
+/* Queued read */
+static volatile uint8_t     read_queued                 = 0U;
+static          uint32_t    read_addr                   = 0U;
+static          uint8_t    *read_dst                    = NULL;
+static          uint32_t    read_len                    = 0U;
+static volatile uint32_t    read_errors                 = 0U;
+
+static          uint8_t     sector_buf[ SD_SECTOR_BYTES ] __attribute__( ( aligned( 4 ) ) );
+static          uint32_t    sector_buf_lba              = 0xFFFFFFFFU;  // Sector held in sector_buf
+
+
+static inline uint16_t Le16( const uint8_t *p ) { return (uint16_t)( p[ 0 ] | ( p[ 1 ] << 8 ) ); }
+static inline uint32_t Le32( const uint8_t *p ) { return (uint32_t)Le16( p ) | ( (uint32_t)Le16( p + 2 ) << 16 ); }
+
+
+/* ===== SPI Card Access ===== */
+
+/** Exchange one byte with the card
+  *
+  * @param: out - Byte to send, 0xFF while receiving
+  * @retval: uint8_t - Byte received
+  */
+static uint8_t SpiExchange( uint8_t out )
+{
+  SPI_TypeDef *spi = sd_cfg->spi;
+
+  while( !LL_SPI_IsActiveFlag_TXE( spi ) ) {
+  }
+  LL_SPI_TransmitData8( spi, out );
+  while( !LL_SPI_IsActiveFlag_RXNE( spi ) ) {
+  }
+  return LL_SPI_ReceiveData8( spi );
+}
+
+
+/** Change the SPI clock prescaler
+  *
+  * @param: prescaler - LL_SPI_BAUDRATEPRESCALER_DIVx
+  * @retval: none
+  */
+static void SpiSetPrescaler( uint32_t prescaler )
+{
+  LL_SPI_Disable( sd_cfg->spi );
+  LL_SPI_SetBaudRatePrescaler( sd_cfg->spi, prescaler );
+  LL_SPI_SetRxFIFOThreshold( sd_cfg->spi, LL_SPI_RX_FIFO_TH_QUARTER );   // RXNE per byte
+  LL_SPI_Enable( sd_cfg->spi );
+}
+
+
+static void CardDeselect( void )
+{
+  LL_GPIO_SetOutputPin( sd_cfg->cs_port, sd_cfg->cs_pin );
+  (void)SpiExchange( 0xFFU );                             // The card releases its output on the next clock
+}
+
+
+/** Wait until the card stops signalling busy
+  *
+  * @param: timeout_ms - Longest wait
+  * @retval: 1 when ready, 0 on timeout
+  */
+static uint8_t CardWaitReady( uint32_t timeout_ms )
+{
+  const uint32_t start = HAL_GetTick();
+
+  while( SpiExchange( 0xFFU ) != 0xFFU ) {
+    if( HAL_GetTick() - start >= timeout_ms ) {
+      return 0U;
+    }
+  }
+  return 1U;
+}
+
+
+/** Select the card and send a command
+  *
+  * The card stays selected for the data or response bytes that follow; CardDeselect() ends
+  * the transaction.
+  *
+  * @param: cmd - Command index, with 0x80 set for an application command
+  * @param: arg - Argument
+  * @retval: uint8_t - R1 response, 0xFF if the card did not answer
+  */
+static uint8_t CardCommand( uint8_t cmd, uint32_t arg )
+{
+  uint8_t r1;
+
+  if( cmd & 0x80U ) {                                     // ACMD: CMD55 first
+    cmd &= 0x7FU;
+    r1 = CardCommand( SD_CMD55, 0U );
+    if( r1 > SD_R1_IDLE ) {
+      return r1;
+    }
+  }
+
+  CardDeselect();
+  LL_GPIO_ResetOutputPin( sd_cfg->cs_port, sd_cfg->cs_pin );
+  if( cmd != SD_CMD0 && !CardWaitReady( SD_READY_TIMEOUT_MS ) ) {
+    return 0xFFU;
+  }
+
+  (void)SpiExchange( (uint8_t)( 0x40U | cmd ) );
+  (void)SpiExchange( (uint8_t)( arg >> 24 ) );
+  (void)SpiExchange( (uint8_t)( arg >> 16 ) );
+  (void)SpiExchange( (uint8_t)( arg >> 8 ) );
+  (void)SpiExchange( (uint8_t)arg );
+  (void)SpiExchange( ( cmd == SD_CMD0 ) ? 0x95U : ( cmd == SD_CMD8 ) ? 0x87U : 0x01U );   // CRC only checked for these
+  if( cmd == SD_CMD12 ) {
+    (void)SpiExchange( 0xFFU );                           // Stuff byte
+  }
+
+  for( uint8_t n = 0U; n < 10U; n++ ) {                   // Response within 8 bytes
+    r1 = SpiExchange( 0xFFU );
+    if( !( r1 & 0x80U ) ) {
+      break;
+    }
+  }
+  return r1;
+}
+
+
+/** Read sectors from the card with one single or multiple block read
+  *
+  * @param: lba - First sector
+  * @param: dst - Destination
+  * @param: count - Sectors, at least 1
+  * @retval: 1 if all arrived, 0 on error
+  */
+static uint8_t CardReadSectors( uint32_t lba, uint8_t *dst, uint32_t count )
+{
+  const uint8_t multi = ( count > 1U );
+  uint8_t       ok    = 1U;
+
+  if( CardCommand( multi ? SD_CMD18 : SD_CMD17, sd_block_addressing ? lba : lba * SD_SECTOR_BYTES ) != 0U ) {
+    CardDeselect();
+    return 0U;
+  }
+
+  while( count > 0U ) {
+    const uint32_t start = HAL_GetTick();
+    uint8_t        token;
+
+    /* The card may hold off the data token while it is busy internally */
+    do {
+      token = SpiExchange( 0xFFU );
+    } while( token == 0xFFU && HAL_GetTick() - start < SD_STREAM_READ_TIMEOUT_MS );
+    if( token != SD_TOKEN_START_BLOCK ) {
+      ok = 0U;
+      break;
+    }
+    for( uint32_t i = 0U; i < SD_SECTOR_BYTES; i++ ) {
+      dst[ i ] = SpiExchange( 0xFFU );
+    }
+    (void)SpiExchange( 0xFFU );                           // CRC, not checked in SPI mode
+    (void)SpiExchange( 0xFFU );
+    dst += SD_SECTOR_BYTES;
+    count--;
+  }
+
+  if( multi ) {
+    (void)CardCommand( SD_CMD12, 0U );
+  }
+  CardDeselect();
+  return ok;
+}
+
+
+/** Load a sector into sector_buf unless it is already there
+  *
+  * @param: lba - Sector
+  * @retval: 1 with the sector loaded, 0 on a read error
+  */
+static uint8_t LoadSector( uint32_t lba )
+{
+  if( lba == sector_buf_lba ) {
+    return 1U;
+  }
+  sector_buf_lba = 0xFFFFFFFFU;
+  if( !CardReadSectors( lba, sector_buf, 1U ) ) {
+    return 0U;
+  }
+  sector_buf_lba = lba;
+  return 1U;
+}
+
+
+/** Bring the card out of reset into SPI mode, ready for reads
+  *
+  * @param: none
+  * @retval: SdStream_Status
+  */
+static SdStream_Status CardInit( void )
+{
+  uint8_t  ocr[ 4 ];
+  uint32_t start;
+  uint8_t  r1;
+
+  SpiSetPrescaler( sd_cfg->init_prescaler );
+  LL_GPIO_SetOutputPin( sd_cfg->cs_port, sd_cfg->cs_pin );
+  for( uint8_t n = 0U; n < 10U; n++ ) {                   // At least 74 clocks with the card deselected
+    (void)SpiExchange( 0xFFU );
+  }
+
+  if( CardCommand( SD_CMD0, 0U ) != SD_R1_IDLE ) {
+    CardDeselect();
+    return SD_STREAM_NO_CARD;
+  }
+
+  sd_block_addressing = 0U;
+  if( CardCommand( SD_CMD8, 0x1AAU ) == SD_R1_IDLE ) {    // SDv2: check the voltage range echo
+    for( uint8_t n = 0U; n < 4U; n++ ) {
+      ocr[ n ] = SpiExchange( 0xFFU );
+    }
+    if( ( ocr[ 2 ] & 0x0FU ) != 0x01U || ocr[ 3 ] != 0xAAU ) {
+      CardDeselect();
+      return SD_STREAM_NO_CARD;
+    }
+    start = HAL_GetTick();
+    while( ( r1 = CardCommand( SD_ACMD41, 1UL << 30 ) ) == SD_R1_IDLE ) {   // HCS: host supports SDHC
+      if( HAL_GetTick() - start >= SD_INIT_TIMEOUT_MS ) {
+        break;
+      }
+    }
+    if( r1 != 0U || CardCommand( SD_CMD58, 0U ) != 0U ) {
+      CardDeselect();
+      return SD_STREAM_NO_CARD;
+    }
+    for( uint8_t n = 0U; n < 4U; n++ ) {
+      ocr[ n ] = SpiExchange( 0xFFU );
+    }
+    sd_block_addressing = ( ocr[ 0 ] & 0x40U ) ? 1U : 0U;   // CCS
+  } else {                                                // SDv1
+    start = HAL_GetTick();
+    while( ( r1 = CardCommand( SD_ACMD41, 0U ) ) == SD_R1_IDLE ) {
+      if( HAL_GetTick() - start >= SD_INIT_TIMEOUT_MS ) {
+        break;
+      }
+    }
+    if( r1 != 0U ) {                                      // MMC cards are not supported
+      CardDeselect();
+      return SD_STREAM_NO_CARD;
+    }
+  }
+  if( !sd_block_addressing && CardCommand( SD_CMD16, SD_SECTOR_BYTES ) != 0U ) {
+    CardDeselect();
+    return SD_STREAM_IO_ERROR;
+  }
+  CardDeselect();
+
+  SpiSetPrescaler( sd_cfg->fast_prescaler );
+  return SD_STREAM_OK;
+}
+
+
+/* ===== FAT Volume ===== */
+
+/** Mount the first FAT16 or FAT32 volume, on a partitioned or an unpartitioned card
+  *
+  * @param: none
+  * @retval: SdStream_Status
+  */
+static SdStream_Status MountVolume( void )
+{
+  uint32_t volume_lba = 0U;
+
+  if( !LoadSector( 0U ) ) {
+    return SD_STREAM_IO_ERROR;
+  }
+  if( sector_buf[ 510 ] != 0x55U || sector_buf[ 511 ] != 0xAAU ) {
+    return SD_STREAM_NO_FILESYSTEM;
+  }
+  if( ( sector_buf[ 0 ] != 0xEBU && sector_buf[ 0 ] != 0xE9U ) || Le16( &sector_buf[ 11 ] ) != SD_SECTOR_BYTES ) {
+    volume_lba = Le32( &sector_buf[ 0x1C6 ] );            // Master boot record: first partition
+    if( !LoadSector( volume_lba ) ) {
+      return SD_STREAM_IO_ERROR;
+    }
+  }
+
+  /* BIOS parameter block */
+  const uint16_t bytes_per_sector = Le16( &sector_buf[ 11 ] );
+  const uint8_t  spc              = sector_buf[ 13 ];
+  const uint16_t reserved         = Le16( &sector_buf[ 14 ] );
+  const uint8_t  fat_count        = sector_buf[ 16 ];
+  const uint16_t root_entries     = Le16( &sector_buf[ 17 ] );
+  const uint32_t total_sectors    = Le16( &sector_buf[ 19 ] ) ? Le16( &sector_buf[ 19 ] ) : Le32( &sector_buf[ 32 ] );
+  const uint32_t fat_sectors      = Le16( &sector_buf[ 22 ] ) ? Le16( &sector_buf[ 22 ] ) : Le32( &sector_buf[ 36 ] );
+
+  if( bytes_per_sector != SD_SECTOR_BYTES || spc == 0U || fat_count == 0U || fat_sectors == 0U ) {
+    return SD_STREAM_NO_FILESYSTEM;
+  }
+  root_sectors  = ( root_entries * 32U + SD_SECTOR_BYTES - 1U ) / SD_SECTOR_BYTES;
+  fat_lba       = volume_lba + reserved;
+  root_lba      = fat_lba + fat_count * fat_sectors;
+  data_lba      = root_lba + root_sectors;
+
+  const uint32_t meta     = reserved + fat_count * fat_sectors + root_sectors;
+  const uint32_t clusters = ( total_sectors > meta ) ? ( total_sectors - meta ) / spc : 0U;
+  if( clusters < 4085U ) {
+    return SD_STREAM_NO_FILESYSTEM;                       // FAT12
+  }
+  fat32               = ( clusters >= 65525U );
+  root_cluster        = fat32 ? Le32( &sector_buf[ 44 ] ) : 0U;
+  sectors_per_cluster = spc;
+  return SD_STREAM_OK;
+}
+
+
+/** Look up the next cluster of a chain
+  *
+  * @param: cluster - Cluster in the chain
+  * @param: next - Receives the next cluster
+  * @retval: 1 if there is one, 0 at the end of the chain or on a read error
+  */
+static uint8_t NextCluster( uint32_t cluster, uint32_t *next )
+{
+  const uint32_t offset = cluster * ( fat32 ? 4U : 2U );
+
+  if( !LoadSector( fat_lba + offset / SD_SECTOR_BYTES ) ) {
+    return 0U;
+  }
+  if( fat32 ) {
+    *next = Le32( &sector_buf[ offset % SD_SECTOR_BYTES ] ) & 0x0FFFFFFFU;
+    return ( *next >= 2U && *next < 0x0FFFFFF7U );
+  }
+  *next = Le16( &sector_buf[ offset % SD_SECTOR_BYTES ] );
+  return ( *next >= 2U && *next < 0xFFF7U );
+}
+
+
+/** Search one directory sector for an entry
+  *
+  * @param: name - Name in directory form, 11 characters padded with spaces
+  * @param: entry - Receives the entry when found
+  * @retval: 1 found, 0 not in this sector, -1 at the end of the directory
+  */
+static int8_t SearchDirSector( const char *name, uint8_t *entry )
+{
+  for( uint32_t pos = 0U; pos < SD_SECTOR_BYTES; pos += 32U ) {
+    const uint8_t *e = &sector_buf[ pos ];
+
+    if( e[ 0 ] == 0x00U ) {
+      return -1;
+    }
+    if( e[ 0 ] != 0xE5U && !( e[ 11 ] & 0x18U ) && memcmp( e, name, 11U ) == 0 ) {   // Not a directory, label or long name
+      memcpy( entry, e, 32U );
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+/** Map a file's cluster chain to runs of consecutive sectors
+  *
+  * @param: cluster - First cluster
+  * @retval: SdStream_Status
+  */
+static SdStream_Status MapClusters( uint32_t cluster )
+{
+  uint32_t mapped = 0U;
+
+  extent_count = 0U;
+  while( mapped < file_size ) {
+    uint32_t run = 1U;
+    uint32_t next;
+    uint8_t  more;
+
+    while( ( more = NextCluster( cluster + run - 1U, &next ) ) && next == cluster + run ) {
+      run++;
+    }
+    if( extent_count == SD_STREAM_MAX_EXTENTS ) {
+      return SD_STREAM_FRAGMENTED;
+    }
+    extents[ extent_count ].lba     = data_lba + ( cluster - 2U ) * sectors_per_cluster;
+    extents[ extent_count ].sectors = run * sectors_per_cluster;
+    extent_count++;
+    mapped += run * sectors_per_cluster * SD_SECTOR_BYTES;
+    if( !more ) {
+      break;
+    }
+    cluster = next;
+  }
+  return ( mapped >= file_size ) ? SD_STREAM_OK : SD_STREAM_IO_ERROR;
+}
+
+
+/* ===== Public Interface ===== */
+
+/** Bring the card up in SPI mode and mount its first FAT volume
+  *
+  * @param: config - SPI wiring; must stay valid while the card is used
+  * @retval: SdStream_Status - SD_STREAM_OK when the volume is mounted
+  */
+SdStream_Status SdStream_Init( const SdStream_Config *config )
+{
+  SdStream_Status status;
+
+  if( config == NULL || config->spi == NULL || config->cs_port == NULL ) {
+    return SD_STREAM_NO_CARD;
+  }
+  sd_cfg          = config;
+  sector_buf_lba  = 0xFFFFFFFFU;
+  extent_count    = 0U;
+  file_size       = 0U;
+  read_queued     = 0U;
+  read_errors     = 0U;
+
+  status = CardInit();
+  if( status != SD_STREAM_OK ) {
+    return status;
+  }
+  return MountVolume();
+}
+
+
+/** Open a file in the root directory for streaming
+  *
+  * @param: name - 8.3 file name, case-insensitive
+  * @retval: SdStream_Status - SD_STREAM_OK when the file's clusters are mapped
+  */
+SdStream_Status SdStream_Open( const char *name )
+{
+  char     dir_name[ 11 ];
+  uint8_t  entry[ 32 ];
+  int8_t   found = 0;
+  uint8_t  i     = 0U;
+  uint8_t  limit = 8U;                                    // End of the current name part
+
+  if( sd_cfg == NULL || name == NULL || read_queued ) {
+    return SD_STREAM_NOT_FOUND;
+  }
+  extent_count = 0U;
+  file_size    = 0U;
+
+  /* Directory form: "CHIME.WAV" -> "CHIME   WAV" */
+  memset( dir_name, ' ', sizeof( dir_name ) );
+  for( ; *name != '\0'; name++ ) {
+    if( *name == '.' && limit == 8U ) {
+      i     = 8U;
+      limit = 11U;
+    } else if( i < limit && *name != '.' ) {
+      dir_name[ i++ ] = ( *name >= 'a' && *name <= 'z' ) ? (char)( *name - 'a' + 'A' ) : *name;
+    } else {
+      return SD_STREAM_NOT_FOUND;                         // Not an 8.3 name
+    }
+  }
+
+  if( fat32 ) {
+    uint32_t cluster = root_cluster;
+    do {
+      for( uint8_t s = 0U; s < sectors_per_cluster && found == 0; s++ ) {
+        if( !LoadSector( data_lba + ( cluster - 2U ) * sectors_per_cluster + s ) ) {
+          return SD_STREAM_IO_ERROR;
+        }
+        found = SearchDirSector( dir_name, entry );
+      }
+    } while( found == 0 && NextCluster( cluster, &cluster ) );
+  } else {
+    for( uint32_t s = 0U; s < root_sectors && found == 0; s++ ) {
+      if( !LoadSector( root_lba + s ) ) {
+        return SD_STREAM_IO_ERROR;
+      }
+      found = SearchDirSector( dir_name, entry );
+    }
+  }
+  if( found != 1 ) {
+    return SD_STREAM_NOT_FOUND;
+  }
+
+  file_size = Le32( &entry[ 28 ] );
+  if( file_size == 0U ) {
+    return SD_STREAM_OK;
+  }
+  return MapClusters( ( fat32 ? (uint32_t)Le16( &entry[ 20 ] ) << 16 : 0U ) | Le16( &entry[ 26 ] ) );
+}
+
+
+/** Get the size of the open file
+  *
+  * @param: none
+  * @retval: uint32_t - Bytes, 0 if no file is open
+  */
+uint32_t SdStream_GetFileSize( void )
+{
+  return file_size;
+}
+
+
+/** Queue a read for SdStream_Service()
+  *
+  * Called by the engine from the render context or its completion path, so it only records
+  * the request.
+  *
+  * @param: addr - Offset into the open file, a multiple of 512
+  * @param: dst - Destination
+  * @param: len - Bytes, a multiple of 512
+  * @retval: uint8_t - 0 once queued, 1 if a read is already queued
+  */
+uint8_t SdStream_Read( uint32_t addr, void *dst, uint32_t len )
+{
+  if( read_queued ) {
+    return 1U;
+  }
+  read_addr   = addr;
+  read_dst    = (uint8_t *)dst;
+  read_len    = len;
+  read_queued = 1U;
+  return 0U;
+}
+
+
+/** Perform the queued read and report it to the engine
+  *
+  * Each run of the read that lies in one extent is a single multi-block card read.
+  *
+  * @param: none
+  * @retval: none
+  */
+void SdStream_Service( void )
+{
+  uint32_t sector = read_addr / SD_SECTOR_BYTES;
+  uint32_t count  = read_len / SD_SECTOR_BYTES;
+  uint8_t *dst    = read_dst;
+  uint32_t primask;
+
+  if( !read_queued ) {
+    return;
+  }
+
+  while( count > 0U ) {
+    uint32_t first = 0U;                                  // File sector at the start of the extent
+    uint8_t  e     = 0U;
+
+    while( e < extent_count && sector >= first + extents[ e ].sectors ) {
+      first += extents[ e ].sectors;
+      e++;
+    }
+    if( e == extent_count ) {
+      break;                                              // Past the end of the file
+    }
+    const uint32_t run = ( count < first + extents[ e ].sectors - sector ) ? count : first + extents[ e ].sectors - sector;
+    if( !CardReadSectors( extents[ e ].lba + sector - first, dst, run ) ) {
+      read_errors++;
+      break;
+    }
+    sector += run;
+    count  -= run;
+    dst    += run * SD_SECTOR_BYTES;
+  }
+  memset( dst, 0, count * SD_SECTOR_BYTES );              // Silence rather than stale data
+  sector_buf_lba = 0xFFFFFFFFU;
+
+  /* The engine's completion must not be preempted by its render context */
+  read_queued = 0U;
+  primask     = __get_PRIMASK();
+  __disable_irq();
+  AudioEngine_SourceReadComplete();                       // May queue the next read
+  __set_PRIMASK( primask );
+}
+
+
+/** Get the number of reads that failed since SdStream_Init()
+  *
+  * @param: none
+  * @retval: uint32_t - Failed reads
+  */
+uint32_t SdStream_GetReadErrors( void )
+{
+  return read_errors;
+}
+
+
+/** Service the card while the engine waits (overrides the engine's weak hook)
+  *
+  * @param: none
+  * @retval: none
+  */
+void AudioEngine_OnStreamWait( void )
+{
+  SdStream_Service();
+}
+
+#endif // AUDIO_ENGINE_ENABLE_SOURCE_STREAM
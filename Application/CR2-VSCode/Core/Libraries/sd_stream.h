@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * @file           : sd_stream.h
+  * @brief          : SD card (SPI mode) streaming source for the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Plays WAV files from the root directory of a FAT16 or FAT32 SD card through the
+  * audio engine's streamed source (AUDIO_ENGINE_ENABLE_SOURCE_STREAM):
+  *
+  *   SdStream_Init( &sd_config );
+  *   SdStream_Open( "CHIME.WAV" );
+  *   AudioEngine_SourceStreamInit( SdStream_Read, AUDIO_ENGINE_NO_STREAM_IMAGE );
+  *   PlayStreamedWav( 0 );
+  *   WaitForSampleEnd();
+  *
+  * Stream addresses are byte offsets into the open file.  The card is read with
+  * multi-block reads in the application context, from the engine's wait hook, so
+  * a card that stalls holds up only the application while the DMA keeps playing
+  * from the staging ring.  An application that does not wait in WaitForSampleEnd()
+  * calls SdStream_Service() from its main loop instead.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _SD_STREAM_H
+#define _SD_STREAM_H
+
+#include "main.h"
+#include "audio_engine.h"
+#include "stm32g4xx_ll_spi.h"
+#include "stm32g4xx_ll_gpio.h"
+
+#include <stdint.h>
+
+/* Most cluster runs a file may be split into */
+#ifndef SD_STREAM_MAX_EXTENTS
+#define SD_STREAM_MAX_EXTENTS   16U
+#endif
+
+/* Milliseconds to wait for the card to start sending a block; cards can stall for 250 ms */
+#ifndef SD_STREAM_READ_TIMEOUT_MS
+#define SD_STREAM_READ_TIMEOUT_MS 500U
+#endif
+
+/* SPI wiring.  The SPI is set up by CubeMX as a full-duplex 8-bit master, mode 0, MSB first,
+ * with a software-driven chip select on an output pin. */
+typedef struct {
+  SPI_TypeDef    *spi;
+  GPIO_TypeDef   *cs_port;
+  uint32_t        cs_pin;                   // LL_GPIO_PIN_x
+  uint32_t        init_prescaler;           // LL_SPI_BAUDRATEPRESCALER_DIVx giving 100-400 kHz
+  uint32_t        fast_prescaler;           // Up to 25 MHz, used once the card is ready
+} SdStream_Config;
+
+typedef enum {
+  SD_STREAM_OK,
+  SD_STREAM_NO_CARD,                        // No response, or a card type that is not supported
+  SD_STREAM_IO_ERROR,                       // A command or read failed
+  SD_STREAM_NO_FILESYSTEM,                  // No FAT16 or FAT32 volume with 512-byte sectors
+  SD_STREAM_NOT_FOUND,                      // No such file in the root directory
+  SD_STREAM_FRAGMENTED                      // More than SD_STREAM_MAX_EXTENTS cluster runs
+} SdStream_Status;
+
+/**
+ * @brief Bring the card up in SPI mode and mount its first FAT volume
+ * @param[in] config SPI wiring; must stay valid while the card is used
+ * @return SD_STREAM_OK when the volume is mounted
+ */
+SdStream_Status     SdStream_Init                     ( const SdStream_Config *config );
+
+/**
+ * @brief Open a file in the root directory for streaming
+ * @param[in] name 8.3 file name, such as "CHIME.WAV" (case-insensitive)
+ * @return SD_STREAM_OK when the file's clusters are mapped
+ * @note Only while no stream is playing. Stream addresses then run from 0 to the file size.
+ */
+SdStream_Status     SdStream_Open                     ( const char *name );
+
+/**
+ * @brief Get the size of the open file
+ * @return Bytes, 0 if no file is open
+ */
+uint32_t            SdStream_GetFileSize              ( void );
+
+/**
+ * @brief Read function for AudioEngine_SourceStreamInit()
+ * @param[in] addr Offset into the open file, a multiple of 512
+ * @param[out] dst Destination
+ * @param[in] len Bytes, a multiple of 512
+ * @return 0 once the read is queued for SdStream_Service(), 1 if one is already queued
+ */
+uint8_t             SdStream_Read                     ( uint32_t addr, void *dst, uint32_t len );
+
+/**
+ * @brief Perform the queued read and report it to the engine
+ * @note Application context only. Blocks for as long as the card takes; bytes past the end of
+ *       the file, or of a failed read, are returned as zeros. Runs from the engine's
+ *       AudioEngine_OnStreamWait() hook.
+ */
+void                SdStream_Service                  ( void );
+
+/**
+ * @brief Get the number of reads that failed since SdStream_Init()
+ * @return Failed reads, each streamed as silence
+ */
+uint32_t            SdStream_GetReadErrors            ( void );
+
+#endif // End of _SD_STREAM_H
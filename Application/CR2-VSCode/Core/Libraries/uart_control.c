@@ -0,0 +1,437 @@
+/**
+  ******************************************************************************
+  * @file           : uart_control.c
+  * @brief          : Binary control protocol over a UART for field tuning
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * The Rx event interrupt (line idle, or the DMA at the end of the ring; the
+  * half-transfer interrupt is turned off) only flags that bytes have landed.
+  * The parser then works through the ring up to the DMA position a byte at a
+  * time, so a frame may arrive in pieces, and hunts for the next sync byte
+  * after a bad frame.  It must be called at least once per lap of the ring.
+  *
+  ******************************************************************************
+  */
+
+#include "audio_engine.h"
+
+#if defined( HAL_UART_MODULE_ENABLED )
+
+#include "uart_control.h"
+
+#include <string.h>
+
+#define FRAME_OVERHEAD              4U                      // Sync, length and CRC
+#define REPLY_BYTES                 ( FRAME_OVERHEAD + 3U )
+
+typedef enum {
+  PARSE_SYNC,
+  PARSE_LENGTH,
+  PARSE_BODY
+} ParseState;
+
+static          UART_HandleTypeDef       *uart                  = NULL;
+static const    UartControl_Config       *control_cfg           = NULL;
+static          uint8_t     rx_ring[ UART_CONTROL_RX_BYTES ];
+static volatile uint8_t     rx_event                    = 0U;     // Bytes have landed since the last parse
+static          uint32_t    rx_tail                     = 0U;     // Next byte to parse
+
+static          ParseState  parse_state                 = PARSE_SYNC;
+static          uint8_t     frame[ 1U + 255U + 2U ];              // Length, payload and CRC
+static          uint32_t    frame_len                   = 0U;     // Bytes of frame[] received
+static          uint32_t    frame_start_ms              = 0U;
+static          uint32_t    dropped                     = 0U;
+static          uint8_t     reply[ REPLY_BYTES ];
+
+
+static inline uint32_t Get32( const uint8_t *p ) { return (uint32_t)p[ 0 ] | ( (uint32_t)p[ 1 ] << 8 ) | ( (uint32_t)p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 ); }
+
+
+/** CRC-16/CCITT-FALSE of a block, a bit at a time (frames are short)
+  *
+  * @param: data - Bytes to check
+  * @param: len - Byte count
+  * @retval: uint16_t - The CRC
+  */
+static uint16_t Crc16( const uint8_t *data, uint32_t len )
+{
+  uint16_t crc = 0xFFFFU;
+
+  while( len-- > 0U ) {
+    crc ^= (uint16_t)( (uint16_t)*data++ << 8 );
+    for( uint32_t bit = 0U; bit < 8U; bit++ ) {
+      crc = ( crc & 0x8000U ) ? (uint16_t)( ( crc << 1 ) ^ 0x1021U ) : (uint16_t)( crc << 1 );
+    }
+  }
+  return crc;
+}
+
+
+/* ===== Reception ===== */
+
+/** Start the circular DMA reception from the top of the ring
+  *
+  * @param: none
+  * @retval: HAL_StatusTypeDef - HAL_OK once receiving
+  */
+static HAL_StatusTypeDef StartReception( void )
+{
+  HAL_StatusTypeDef status;
+
+  rx_event    = 0U;
+  rx_tail     = 0U;
+  parse_state = PARSE_SYNC;
+
+  status = HAL_UARTEx_ReceiveToIdle_DMA( uart, rx_ring, UART_CONTROL_RX_BYTES );
+  if( status == HAL_OK ) {
+    __HAL_DMA_DISABLE_IT( uart->hdmarx, DMA_IT_HT );      // Idle and end of ring only
+  }
+  return status;
+}
+
+
+/** Flag the bytes received: at an idle line, and as the DMA wraps the ring
+  *
+  * @param: huart - UART handle
+  * @param: Size - Ring position of the DMA
+  * @retval: none
+  */
+void HAL_UARTEx_RxEventCallback( UART_HandleTypeDef *huart, uint16_t Size )
+{
+  (void)Size;                                             // UartControl_Service() reads the DMA position itself
+  if( huart == uart ) {
+    rx_event = 1U;
+  }
+}
+
+
+/* ===== Frames ===== */
+
+/** Check a frame's records, and gather its SETs into a preset
+  *
+  * @param: payload - Records, after the sequence number
+  * @param: len - Bytes of records
+  * @param: preset - Receives the preset the frame's SETs and PRESETs make
+  * @param: settings - Set to 1 if the frame changes any setting
+  * @retval: uint8_t - 1 if every record is good
+  */
+static uint8_t GatherSettings( const uint8_t *payload, uint32_t len, AudioEngine_Preset *preset, uint8_t *settings )
+{
+  uint32_t pos = 0U;
+
+  AudioEngine_CapturePreset( preset );
+  *settings = 0U;
+
+  while( pos < len ) {
+    const uint8_t op = payload[ pos++ ];
+
+    switch( op ) {
+      case UART_CONTROL_SET: {
+        if( len - pos < 5U ) {
+          return 0U;
+        }
+        const uint8_t  param = payload[ pos ];
+        const uint32_t value = Get32( &payload[ pos + 1U ] );
+        FilterConfig_TypeDef *f = &preset->filter;
+        pos += 5U;
+
+        switch( param ) {
+          case UART_CONTROL_LPF_16BIT_LEVEL:      if( value > LPF_Custom ) return 0U;  f->lpf_16bit_level = (LPF_Level)value; break;
+          case UART_CONTROL_LPF_16BIT_ALPHA:      if( value > 0xFFFFU ) return 0U;     f->lpf_16bit_custom_alpha = (uint16_t)value; break;
+          case UART_CONTROL_LPF_8BIT_LEVEL:       if( value > LPF_Custom ) return 0U;  f->lpf_8bit_level = (LPF_Level)value; break;
+          case UART_CONTROL_LPF_8BIT_ALPHA:       if( value > 0xFFFFU ) return 0U;     f->lpf_8bit_custom_alpha = (uint16_t)value; break;
+          case UART_CONTROL_LPF_MAKEUP_Q16:       if( value > AIR_EFFECT_SHELF_GAIN_MAX ) return 0U;  f->lpf_makeup_gain_q16 = value; break;
+          case UART_CONTROL_LPF_16BIT_MAKEUP_Q16: if( value > AIR_EFFECT_SHELF_GAIN_MAX ) return 0U;  f->lpf_makeup_gain_16bit_q16 = value; break;
+          case UART_CONTROL_BIQUAD_LPF_16BIT:     if( value > 1U ) return 0U;          f->enable_16bit_biquad_lpf = (uint8_t)value; break;
+          case UART_CONTROL_DC_FILTER_16BIT:      if( value > 1U ) return 0U;          f->enable_soft_dc_filter_16bit = (uint8_t)value; break;
+          case UART_CONTROL_LPF_8BIT:             if( value > 1U ) return 0U;          f->enable_8bit_lpf = (uint8_t)value; break;
+          case UART_CONTROL_NOISE_GATE:           if( value > 1U ) return 0U;          f->enable_noise_gate = (uint8_t)value; break;
+          case UART_CONTROL_SOFT_CLIPPING:        if( value > 1U ) return 0U;          f->enable_soft_clipping = (uint8_t)value; break;
+          case UART_CONTROL_AIR_EFFECT:           if( value > 1U ) return 0U;          f->enable_air_effect = (uint8_t)value; break;
+          case UART_CONTROL_FILTER_CHAIN_16BIT:   if( value > 1U ) return 0U;          f->enable_filter_chain_16bit = (uint8_t)value; break;
+          case UART_CONTROL_FILTER_CHAIN_8BIT:    if( value > 1U ) return 0U;          f->enable_filter_chain_8bit = (uint8_t)value; break;
+          case UART_CONTROL_AIR_GAIN_Q16:         if( value > AIR_EFFECT_SHELF_GAIN_MAX ) return 0U;  preset->air_gain_q16 = value; break;
+          case UART_CONTROL_FADE_IN_MS:           if( value < 1U || value > 5000U ) return 0U;  preset->fade_in_ms = (uint16_t)value; break;
+          case UART_CONTROL_FADE_OUT_MS:          if( value < 1U || value > 5000U ) return 0U;  preset->fade_out_ms = (uint16_t)value; break;
+          case UART_CONTROL_PAUSE_FADE_MS:        if( value < 1U || value > 5000U ) return 0U;  preset->pause_fade_ms = (uint16_t)value; break;
+          case UART_CONTROL_RESUME_FADE_MS:       if( value < 1U || value > 5000U ) return 0U;  preset->resume_fade_ms = (uint16_t)value; break;
+          case UART_CONTROL_FADERS:               if( value > 1U ) return 0U;          preset->faders_enabled = (uint8_t)value; break;
+          default:
+            return 0U;
+        }
+        *settings = 1U;
+        break;
+      }
+
+      case UART_CONTROL_PRESET:
+        if( pos >= len || control_cfg->presets == NULL || payload[ pos ] >= control_cfg->preset_count ||
+            control_cfg->presets[ payload[ pos ] ] == NULL ) {
+          return 0U;
+        }
+        *preset   = *control_cfg->presets[ payload[ pos ] ];  // Later SETs adjust it
+        *settings = 1U;
+        pos++;
+        break;
+
+      case UART_CONTROL_PLAY_ID:
+      case UART_CONTROL_PLAY_BANK:
+#if !AUDIO_ENGINE_ENABLE_ASSET_INDEX
+        if( op == UART_CONTROL_PLAY_ID ) return 0U;
+#endif
+#if !AUDIO_ENGINE_ENABLE_ASSET_BANK
+        if( op == UART_CONTROL_PLAY_BANK ) return 0U;
+#endif
+        if( len - pos < 4U ) {
+          return 0U;
+        }
+        pos += 4U;
+        break;
+
+      case UART_CONTROL_PAUSE:
+      case UART_CONTROL_RESUME:
+      case UART_CONTROL_STOP:
+        break;
+
+#if AUDIO_ENGINE_ENABLE_PRESET_STORE
+      case UART_CONTROL_SAVE:
+        break;
+#endif
+
+#if AUDIO_ENGINE_ENABLE_RAM_ASSET
+      case UART_CONTROL_RAM_WRITE:
+        if( len - pos < 5U || len - pos - 5U < payload[ pos + 4U ] ) {
+          return 0U;
+        }
+        pos += 5U + payload[ pos + 4U ];
+        break;
+
+      case UART_CONTROL_PLAY_RAM:
+        break;
+#endif
+
+      default:
+        return 0U;
+    }
+  }
+  return 1U;
+}
+
+
+/** Run a frame's commands in order, skipping the settings already applied
+  *
+  * @param: payload - Records, after the sequence number
+  * @param: len - Bytes of records
+  * @param: applied - Receives the number of records applied
+  * @retval: UartControl_Result - UART_CONTROL_APPLIED, or UART_CONTROL_COMMAND_FAILED at the first refusal
+  */
+static UartControl_Result RunCommands( const uint8_t *payload, uint32_t len, uint8_t *applied )
+{
+  uint32_t         pos = 0U;
+  PB_StatusTypeDef status;
+
+  while( pos < len ) {
+    const uint8_t op = payload[ pos++ ];
+
+    switch( op ) {
+      case UART_CONTROL_SET:     pos += 5U;  status = PB_Idle;  break;
+      case UART_CONTROL_PRESET:  pos += 1U;  status = PB_Idle;  break;
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+      case UART_CONTROL_PLAY_ID:    status = PlayAssetById( Get32( &payload[ pos ] ) );  pos += 4U;  break;
+#endif
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+      case UART_CONTROL_PLAY_BANK:  status = PlayBankAsset( Get32( &payload[ pos ] ) );  pos += 4U;  break;
+#endif
+      case UART_CONTROL_PAUSE:   status = PausePlayback();   break;
+      case UART_CONTROL_RESUME:  status = ResumePlayback();  break;
+      case UART_CONTROL_STOP:    status = StopPlayback();    break;
+#if AUDIO_ENGINE_ENABLE_PRESET_STORE
+      case UART_CONTROL_SAVE:    status = ( AudioEngine_SavePreset() == PB_Idle ) ? PB_Idle : PB_Error;  break;
+#endif
+#if AUDIO_ENGINE_ENABLE_RAM_ASSET
+      case UART_CONTROL_RAM_WRITE:
+        status = ( AudioEngine_WriteRamAsset( Get32( &payload[ pos ] ), &payload[ pos + 5U ], payload[ pos + 4U ] ) == PB_Idle ) ? PB_Idle : PB_Error;
+        pos   += 5U + payload[ pos + 4U ];
+        break;
+      case UART_CONTROL_PLAY_RAM:  status = PlayRamAsset();  break;
+#endif
+      default:                   status = PB_Error;          break;   // Not reached: GatherSettings() checked
+    }
+    if( status == PB_Error || status == PB_PlayingFailed ) {
+      return UART_CONTROL_COMMAND_FAILED;
+    }
+    ( *applied )++;
+  }
+  return UART_CONTROL_APPLIED;
+}
+
+
+/** Apply a frame whose CRC has checked out, and answer it
+  *
+  * @param: payload - Sequence number, then records
+  * @param: len - Payload bytes
+  * @retval: none
+  */
+static void ApplyFrame( const uint8_t *payload, uint32_t len )
+{
+  AudioEngine_Preset  preset;
+  uint8_t             settings;
+  uint8_t             applied = 0U;
+  UartControl_Result  result;
+
+  if( !GatherSettings( &payload[ 1 ], len - 1U, &preset, &settings ) ) {
+    result = UART_CONTROL_BAD_RECORD;
+  } else {
+    if( settings ) {
+      ApplyPreset( &preset );                             // The whole batch in one publish
+    }
+    result = RunCommands( &payload[ 1 ], len - 1U, &applied );
+  }
+
+  if( uart->hdmatx != NULL && uart->gState == HAL_UART_STATE_READY ) {
+    uint16_t crc;
+
+    reply[ 0 ] = UART_CONTROL_SYNC;
+    reply[ 1 ] = 3U;
+    reply[ 2 ] = payload[ 0 ];
+    reply[ 3 ] = (uint8_t)result;
+    reply[ 4 ] = applied;
+    crc        = Crc16( &reply[ 1 ], 4U );
+    reply[ 5 ] = (uint8_t)crc;
+    reply[ 6 ] = (uint8_t)( crc >> 8 );
+    (void)HAL_UART_Transmit_DMA( uart, reply, REPLY_BYTES );
+  }
+}
+
+
+/** Feed one received byte to the frame parser
+  *
+  * @param: byte - Next byte from the ring
+  * @retval: none
+  */
+static void ParseByte( uint8_t byte )
+{
+  switch( parse_state ) {
+    case PARSE_SYNC:
+      if( byte == UART_CONTROL_SYNC ) {
+        parse_state    = PARSE_LENGTH;
+        frame_start_ms = HAL_GetTick();
+      }
+      break;
+
+    case PARSE_LENGTH:
+      if( byte == 0U ) {                                  // A frame carries at least its sequence number
+        parse_state = PARSE_SYNC;
+        dropped++;
+        break;
+      }
+      frame[ 0 ]  = byte;
+      frame_len   = 1U;
+      parse_state = PARSE_BODY;
+      break;
+
+    case PARSE_BODY:
+      frame[ frame_len++ ] = byte;
+      if( frame_len == frame[ 0 ] + 3U ) {                // Length, payload and CRC
+        const uint32_t crc = (uint32_t)frame[ frame_len - 2U ] | ( (uint32_t)frame[ frame_len - 1U ] << 8 );
+
+        parse_state = PARSE_SYNC;
+        if( Crc16( frame, frame_len - 2U ) == crc ) {
+          ApplyFrame( &frame[ 1 ], frame[ 0 ] );
+        } else {
+          dropped++;
+        }
+      }
+      break;
+  }
+}
+
+
+/* ===== Public ===== */
+
+/** Start the circular DMA reception
+  *
+  * @param: huart - UART handle with a circular Rx DMA channel linked
+  * @param: config - Preset table
+  * @retval: UartControl_Status - UART_CONTROL_OK once receiving
+  */
+UartControl_Status UartControl_Init( UART_HandleTypeDef *huart, const UartControl_Config *config )
+{
+  if( huart == NULL || config == NULL || huart->hdmarx == NULL || huart->hdmarx->Init.Mode != DMA_CIRCULAR ) {
+    return UART_CONTROL_BAD_CONFIG;
+  }
+  uart        = huart;
+  control_cfg = config;
+  dropped     = 0U;
+  return ( StartReception() == HAL_OK ) ? UART_CONTROL_OK : UART_CONTROL_UART_ERROR;
+}
+
+
+/** Parse the frames received since the last call and apply them
+  *
+  * @param: none
+  * @retval: none
+  */
+void UartControl_Service( void )
+{
+  uint32_t head;
+
+  if( uart == NULL ) {
+    return;
+  }
+  if( uart->RxState != HAL_UART_STATE_BUSY_RX ) {        // A UART error ended the reception
+    dropped += ( parse_state != PARSE_SYNC ) ? 1U : 0U;
+    (void)StartReception();
+    return;
+  }
+
+  if( rx_event ) {
+    rx_event = 0U;                                        // Cleared first: an event from here on is parsed next time
+    head     = ( UART_CONTROL_RX_BYTES - __HAL_DMA_GET_COUNTER( uart->hdmarx ) ) % UART_CONTROL_RX_BYTES;
+    while( rx_tail != head ) {
+      ParseByte( rx_ring[ rx_tail ] );
+      rx_tail = ( rx_tail + 1U ) % UART_CONTROL_RX_BYTES;
+    }
+  }
+
+  if( parse_state != PARSE_SYNC && HAL_GetTick() - frame_start_ms > UART_CONTROL_FRAME_TIMEOUT_MS ) {
+    parse_state = PARSE_SYNC;                             // The rest is not coming
+    dropped++;
+  }
+}
+
+
+/** Get the number of frames dropped
+  *
+  * @param: none
+  * @retval: uint32_t - Bad CRC or timed-out frames since UartControl_Init()
+  */
+uint32_t UartControl_GetDropped( void )
+{
+  return dropped;
+}
+
+#endif // HAL_UART_MODULE_ENABLED
@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * @file           : uart_control.h
+  * @brief          : Binary control protocol over a UART for field tuning
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Lets a PC or a site controller tune the engine and start sounds over a
+  * UART, so a site can be set up without reflashing:
+  *
+  *   MX_DMA_Init();
+  *   MX_USART1_UART_Init();                    // huart1, Rx DMA circular, Tx DMA normal (optional)
+  *   AudioEngine_Init( DAC_MasterSwitch, ReadVolume, MX_I2S2_Init );
+  *   UartControl_Init( &huart1, &control_config );
+  *   while( 1 ) { UartControl_Service(); }
+  *
+  * Reception is one circular DMA transfer that never stops; the UART interrupts
+  * only when the line goes idle after a frame and once per lap of the ring,
+  * never per byte, and the interrupt just notes how far the DMA has got.
+  * UartControl_Service() parses what has arrived in the application context.
+  *
+  * A frame, little-endian:
+  *
+  *   UART_CONTROL_SYNC, length (1 byte), payload (length bytes),
+  *   CRC-16/CCITT-FALSE of the length and payload (2 bytes)
+  *
+  * The payload is a sequence number, then records.  A frame is all or nothing:
+  * if any record is unknown or out of range, none is applied.  Otherwise every
+  * SET in the frame is gathered into one preset, taken from the running
+  * configuration (AudioEngine_CapturePreset()) or from a PRESET record, and
+  * applied with a single ApplyPreset(), so the render sees the whole batch
+  * change in one period.  Commands follow in order, through the engine's
+  * command queue.  With a Tx DMA channel linked, each good frame is answered
+  * with UART_CONTROL_SYNC, 3, sequence number, UartControl_Result, records
+  * applied, CRC.  Tools/uart_control.py builds the frames.
+ *
+ * With AUDIO_ENGINE_ENABLE_RAM_ASSET, RAM_WRITE records carry an asset image
+ * into the RAM asset slot a frame at a time, and PLAY_RAM plays it, so a new
+ * sound is auditioned in seconds (Tools/uart_control.py --upload).
+  *
+  ******************************************************************************
+  */
+
+#ifndef _UART_CONTROL_H
+#define _UART_CONTROL_H
+
+#include "main.h"
+#include "audio_engine.h"
+
+#include <stdint.h>
+
+/* First byte of every frame */
+#define UART_CONTROL_SYNC           0xC2U
+
+/* Receive ring, bytes: at 115200 baud it laps every 44 ms, so call UartControl_Service() more often */
+#ifndef UART_CONTROL_RX_BYTES
+#define UART_CONTROL_RX_BYTES 512U
+#endif
+
+/* A frame started but not finished within this time is dropped */
+#ifndef UART_CONTROL_FRAME_TIMEOUT_MS
+#define UART_CONTROL_FRAME_TIMEOUT_MS 50U
+#endif
+
+/* Record opcodes and their arguments */
+typedef enum {
+  UART_CONTROL_SET        = 0x01,           // Parameter (1 byte), value (int32): see UartControl_Param
+  UART_CONTROL_PRESET     = 0x02,           // Preset index (1 byte) into the config's table, the base for the SETs
+  UART_CONTROL_PLAY_ID    = 0x10,           // Asset ID (4 bytes): PlayAssetById()
+  UART_CONTROL_PLAY_BANK  = 0x11,           // Asset ID (4 bytes): PlayBankAsset()
+  UART_CONTROL_PAUSE      = 0x12,
+  UART_CONTROL_RESUME     = 0x13,
+  UART_CONTROL_STOP       = 0x14,
+  UART_CONTROL_SAVE       = 0x20,           // AudioEngine_SavePreset(), with AUDIO_ENGINE_ENABLE_PRESET_STORE; refused while playing
+  UART_CONTROL_RAM_WRITE  = 0x30,           // Slot offset (4 bytes), count (1 byte), count image bytes:
+                                            // AudioEngine_WriteRamAsset(), with AUDIO_ENGINE_ENABLE_RAM_ASSET
+  UART_CONTROL_PLAY_RAM   = 0x31            // PlayRamAsset(), with AUDIO_ENGINE_ENABLE_RAM_ASSET
+} UartControl_Op;
+
+/* Parameters a SET record changes, with the AudioEngine_Preset fields they map onto */
+typedef enum {
+  UART_CONTROL_LPF_16BIT_LEVEL      = 0x01,   // LPF_Level
+  UART_CONTROL_LPF_16BIT_ALPHA      = 0x02,   // Q16, with LPF_Custom
+  UART_CONTROL_LPF_8BIT_LEVEL       = 0x03,
+  UART_CONTROL_LPF_8BIT_ALPHA       = 0x04,
+  UART_CONTROL_LPF_MAKEUP_Q16       = 0x05,   // Up to AIR_EFFECT_SHELF_GAIN_MAX
+  UART_CONTROL_LPF_16BIT_MAKEUP_Q16 = 0x06,
+  UART_CONTROL_BIQUAD_LPF_16BIT     = 0x10,   // Enables, 0 or 1
+  UART_CONTROL_DC_FILTER_16BIT      = 0x11,
+  UART_CONTROL_LPF_8BIT             = 0x12,
+  UART_CONTROL_NOISE_GATE           = 0x13,
+  UART_CONTROL_SOFT_CLIPPING        = 0x14,
+  UART_CONTROL_AIR_EFFECT           = 0x15,
+  UART_CONTROL_FILTER_CHAIN_16BIT   = 0x16,
+  UART_CONTROL_FILTER_CHAIN_8BIT    = 0x17,
+  UART_CONTROL_AIR_GAIN_Q16         = 0x20,   // Up to AIR_EFFECT_SHELF_GAIN_MAX
+  UART_CONTROL_FADE_IN_MS           = 0x21,   // Fade times, 1-5000 ms
+  UART_CONTROL_FADE_OUT_MS          = 0x22,
+  UART_CONTROL_PAUSE_FADE_MS        = 0x23,
+  UART_CONTROL_RESUME_FADE_MS       = 0x24,
+  UART_CONTROL_FADERS               = 0x25    // 0 or 1
+} UartControl_Param;
+
+/* Result in a reply */
+typedef enum {
+  UART_CONTROL_APPLIED,                     // Every record applied
+  UART_CONTROL_BAD_RECORD,                  // Unknown, truncated or out of range: nothing applied
+  UART_CONTROL_COMMAND_FAILED               // The settings applied, but a command was refused; later ones were skipped
+} UartControl_Result;
+
+typedef struct {
+  const AudioEngine_Preset * const *presets;  // Table for PRESET records, or NULL
+  uint8_t                           preset_count;
+} UartControl_Config;
+
+typedef enum {
+  UART_CONTROL_OK,
+  UART_CONTROL_BAD_CONFIG,                  // A NULL handle or config, or no circular Rx DMA
+  UART_CONTROL_UART_ERROR                   // The reception did not start
+} UartControl_Status;
+
+/**
+ * @brief Start the circular DMA reception
+ * @param[in] huart UART handle initialised by the application, with a circular Rx DMA channel
+ *            linked and, for replies, a Tx DMA channel
+ * @param[in] config Preset table; must stay valid while the module is used
+ * @return UART_CONTROL_OK once receiving
+ */
+UartControl_Status  UartControl_Init                  ( UART_HandleTypeDef *huart, const UartControl_Config *config );
+
+/**
+ * @brief Parse the frames received and apply them
+ * @note Application context only, from the main loop. Restarts the reception after a UART error.
+ */
+void                UartControl_Service               ( void );
+
+/**
+ * @brief Get the number of frames dropped for a bad CRC or a timeout
+ * @return Count since UartControl_Init()
+ */
+uint32_t            UartControl_GetDropped            ( void );
+
+#endif // End of _UART_CONTROL_H
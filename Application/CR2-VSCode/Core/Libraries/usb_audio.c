@@ -0,0 +1,706 @@
+/**
+  ******************************************************************************
+  * @file           : usb_audio.c
+  * @brief          : USB Audio Class 1 speaker feeding the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * The device follows the USB Device Class Definition for Audio Devices 1.0: one
+  * audio control interface (USB streaming input terminal, a feature unit with
+  * master mute and volume, speaker output terminal) and one audio streaming
+  * interface, whose alternate setting 1 carries 16-bit PCM on an asynchronous
+  * isochronous OUT endpoint with its explicit feedback endpoint.  Every class
+  * driver in current use (Windows, macOS, Linux) binds to it without a driver.
+  * Only the one rate and format configured are offered, so the host converts to
+  * them and the engine plays the frames as they come.
+  *
+  * Everything runs from the USB interrupt except starting and stopping playback,
+  * which UsbAudio_Service() does from the application context.
+  *
+  ******************************************************************************
+  */
+
+#include "audio_engine.h"
+
+#if AUDIO_ENGINE_ENABLE_PUSH_SOURCE && defined( HAL_PCD_MODULE_ENABLED )
+
+#include "usb_audio.h"
+#include <math.h>
+#include <string.h>
+
+#define USB_EP0_SIZE            64U
+#define USB_EP_AUDIO_OUT        0x01U       // Isochronous, asynchronous
+#define USB_EP_FEEDBACK_IN      0x82U       // Isochronous, explicit feedback for USB_EP_AUDIO_OUT
+#define USB_FEEDBACK_BYTES      3U          // 10.14 frames per millisecond at full speed
+
+/* Packet memory: the buffer table for endpoints 0 to 2, then each endpoint's buffer */
+#define USB_PMA_EP0_OUT         0x18U
+#define USB_PMA_EP0_IN          0x58U
+#define USB_PMA_AUDIO_OUT       0x98U       // Up to 196 bytes: 49 stereo frames of 48 kHz
+#define USB_PMA_FEEDBACK_IN     0x160U
+
+/* Standard requests */
+#define USB_REQ_GET_STATUS          0x00U
+#define USB_REQ_CLEAR_FEATURE       0x01U
+#define USB_REQ_SET_FEATURE         0x03U
+#define USB_REQ_SET_ADDRESS         0x05U
+#define USB_REQ_GET_DESCRIPTOR      0x06U
+#define USB_REQ_GET_CONFIGURATION   0x08U
+#define USB_REQ_SET_CONFIGURATION   0x09U
+#define USB_REQ_GET_INTERFACE       0x0AU
+#define USB_REQ_SET_INTERFACE       0x0BU
+
+#define USB_REQ_TYPE_MASK           0x60U
+#define USB_REQ_TYPE_STANDARD       0x00U
+#define USB_REQ_TYPE_CLASS          0x20U
+#define USB_REQ_RECIPIENT_MASK      0x1FU
+#define USB_REQ_RECIPIENT_INTERFACE 0x01U
+#define USB_REQ_RECIPIENT_ENDPOINT  0x02U
+
+#define USB_DESC_DEVICE             0x01U
+#define USB_DESC_CONFIGURATION      0x02U
+#define USB_DESC_STRING             0x03U
+#define USB_DESC_INTERFACE          0x04U
+#define USB_DESC_ENDPOINT           0x05U
+#define USB_DESC_CS_INTERFACE       0x24U
+#define USB_DESC_CS_ENDPOINT        0x25U
+
+/* Audio class requests, control selectors and entities */
+#define UAC_SET_CUR                 0x01U
+#define UAC_GET_CUR                 0x81U
+#define UAC_GET_MIN                 0x82U
+#define UAC_GET_MAX                 0x83U
+#define UAC_GET_RES                 0x84U
+#define UAC_FU_MUTE                 0x01U
+#define UAC_FU_VOLUME               0x02U
+#define UAC_EP_SAMPLING_FREQ        0x01U
+
+#define UAC_INPUT_TERMINAL_ID       1U
+#define UAC_FEATURE_UNIT_ID         2U
+#define UAC_OUTPUT_TERMINAL_ID      3U
+#define UAC_STREAMING_INTERFACE     1U
+
+#define USB_AUDIO_VOLUME_MIN        ( -(int16_t)( USB_AUDIO_VOLUME_MIN_DB * 256U ) )   // 1/256 dB
+#define USB_AUDIO_VOLUME_RES        256                   // 1 dB steps
+
+typedef enum {
+  CTRL_IDLE,
+  CTRL_DATA_IN,                             // Sending the data stage
+  CTRL_DATA_OUT                             // Waiting for a SET_CUR's data
+} UsbCtrlState;
+
+typedef struct {
+  uint8_t         type;                     // bmRequestType
+  uint8_t         request;
+  uint16_t        value;
+  uint16_t        index;
+  uint16_t        length;
+} UsbSetup;
+
+static          PCD_HandleTypeDef     *usb_pcd                  = NULL;
+static const    UsbAudio_Config       *usb_cfg                  = NULL;
+
+/* Descriptors, built for the configured identity and format */
+static          uint8_t     device_desc[ 18 ];
+static          uint8_t     config_desc[ 128 ];
+static          uint16_t    config_desc_len             = 0U;
+
+/* Control endpoint */
+static          UsbCtrlState ctrl_state                 = CTRL_IDLE;
+static          UsbSetup    ctrl_setup;                           // The request a data stage belongs to
+static          uint8_t     ctrl_zlp                    = 0U;     // Short of wLength on a packet boundary: end with an empty packet
+static          uint8_t     ctrl_buf[ USB_EP0_SIZE ] __attribute__( ( aligned( 4 ) ) );
+
+/* Device and stream state */
+static          uint8_t     configuration               = 0U;
+static volatile uint8_t     streaming                   = 0U;     // Alternate setting 1 selected
+static          uint8_t     playing                     = 0U;     // UsbAudio_Service() started playback
+static          uint8_t     frame_bytes                 = 4U;
+static          uint16_t    packet_max                  = 0U;
+static          uint8_t     audio_buf[ 256 ] __attribute__( ( aligned( 4 ) ) );
+
+/* Feature unit */
+static volatile uint8_t     mute                        = 0U;
+static volatile int16_t     volume_db                   = 0;      // 1/256 dB
+static volatile uint16_t    volume_linear               = 65535U;
+
+/* Feedback */
+static          uint32_t    fb_nominal                  = 0U;     // 10.14 frames per millisecond
+static volatile uint32_t    fb_value                    = 0U;
+static          uint32_t    fb_frames                   = 0U;     // AudioEngine_GetFrameCount() at the window's start
+static          uint16_t    fb_ticks                    = 0U;     // SOFs into the window
+static          uint8_t     fb_valid                    = 0U;     // fb_frames was taken
+static volatile uint8_t     fb_busy                     = 0U;     // A feedback packet waits for the host
+static          uint8_t     fb_buf[ 4 ] __attribute__( ( aligned( 4 ) ) );
+
+
+static inline uint8_t *Put16( uint8_t *p, uint16_t v ) { p[ 0 ] = (uint8_t)v; p[ 1 ] = (uint8_t)( v >> 8 ); return p + 2; }
+static inline uint8_t *Put24( uint8_t *p, uint32_t v ) { p[ 2 ] = (uint8_t)( v >> 16 ); return Put16( p, (uint16_t)v ) + 1; }
+
+
+/* ===== Descriptors ===== */
+
+/** Build the device and configuration descriptors for the configured identity and format
+  *
+  * @param: none
+  * @retval: none
+  */
+static void BuildDescriptors( void )
+{
+  const uint8_t  channels   = ( usb_cfg->channels == Mode_stereo ) ? 2U : 1U;
+  const uint8_t  fu_len     = (uint8_t)( 7U + channels + 1U );   // One control byte for master and each channel
+  const uint16_t ac_len     = (uint16_t)( 9U + 12U + fu_len + 9U );
+  uint8_t       *p          = device_desc;
+
+  *p++ = 18U;  *p++ = USB_DESC_DEVICE;
+  p = Put16( p, 0x0200U );                                // USB 2.0, full speed
+  *p++ = 0x00U;  *p++ = 0x00U;  *p++ = 0x00U;             // Class per interface
+  *p++ = USB_EP0_SIZE;
+  p = Put16( p, usb_cfg->vendor_id );
+  p = Put16( p, usb_cfg->product_id );
+  p = Put16( p, 0x0100U );                                // bcdDevice
+  *p++ = 1U;  *p++ = 2U;  *p++ = 0U;                      // Manufacturer, product, no serial number
+  *p++ = 1U;                                              // One configuration
+
+  p = config_desc;
+  *p++ = 9U;  *p++ = USB_DESC_CONFIGURATION;
+  p += 2;                                                 // wTotalLength, filled in below
+  *p++ = 2U;  *p++ = 1U;  *p++ = 0U;                      // Two interfaces, configuration 1
+  *p++ = 0xC0U;                                           // Self-powered: the amplifier has its own supply
+  *p++ = 50U;                                             // 100 mA
+
+  /* Audio control interface */
+  *p++ = 9U;  *p++ = USB_DESC_INTERFACE;
+  *p++ = 0U;  *p++ = 0U;  *p++ = 0U;                      // Interface 0, no endpoints
+  *p++ = 0x01U;  *p++ = 0x01U;  *p++ = 0x00U;  *p++ = 0U; // Audio, audio control
+  *p++ = 9U;  *p++ = USB_DESC_CS_INTERFACE;  *p++ = 0x01U;   // Header
+  p = Put16( p, 0x0100U );
+  p = Put16( p, ac_len );
+  *p++ = 1U;  *p++ = UAC_STREAMING_INTERFACE;
+  *p++ = 12U;  *p++ = USB_DESC_CS_INTERFACE;  *p++ = 0x02U;  // Input terminal: USB streaming
+  *p++ = UAC_INPUT_TERMINAL_ID;
+  p = Put16( p, 0x0101U );
+  *p++ = 0U;  *p++ = channels;
+  p = Put16( p, ( channels == 2U ) ? 0x0003U : 0x0004U );   // Left and right front, or centre
+  *p++ = 0U;  *p++ = 0U;
+  *p++ = fu_len;  *p++ = USB_DESC_CS_INTERFACE;  *p++ = 0x06U;   // Feature unit
+  *p++ = UAC_FEATURE_UNIT_ID;  *p++ = UAC_INPUT_TERMINAL_ID;  *p++ = 1U;
+  *p++ = 0x03U;                                           // Master mute and volume
+  for( uint8_t ch = 0U; ch < channels; ch++ ) {
+    *p++ = 0x00U;
+  }
+  *p++ = 0U;
+  *p++ = 9U;  *p++ = USB_DESC_CS_INTERFACE;  *p++ = 0x03U;   // Output terminal: speaker
+  *p++ = UAC_OUTPUT_TERMINAL_ID;
+  p = Put16( p, 0x0301U );
+  *p++ = 0U;  *p++ = UAC_FEATURE_UNIT_ID;  *p++ = 0U;
+
+  /* Audio streaming interface: alternate 0 without endpoints, 1 streaming */
+  *p++ = 9U;  *p++ = USB_DESC_INTERFACE;
+  *p++ = UAC_STREAMING_INTERFACE;  *p++ = 0U;  *p++ = 0U;
+  *p++ = 0x01U;  *p++ = 0x02U;  *p++ = 0x00U;  *p++ = 0U;
+  *p++ = 9U;  *p++ = USB_DESC_INTERFACE;
+  *p++ = UAC_STREAMING_INTERFACE;  *p++ = 1U;  *p++ = 2U;
+  *p++ = 0x01U;  *p++ = 0x02U;  *p++ = 0x00U;  *p++ = 0U;
+  *p++ = 7U;  *p++ = USB_DESC_CS_INTERFACE;  *p++ = 0x01U;   // General
+  *p++ = UAC_INPUT_TERMINAL_ID;  *p++ = 1U;               // One frame of delay
+  p = Put16( p, 0x0001U );                                // PCM
+  *p++ = 11U;  *p++ = USB_DESC_CS_INTERFACE;  *p++ = 0x02U;  // Type I format
+  *p++ = 0x01U;  *p++ = channels;  *p++ = 2U;  *p++ = 16U;
+  *p++ = 1U;                                              // One discrete rate
+  p = Put24( p, usb_cfg->rate );
+  *p++ = 9U;  *p++ = USB_DESC_ENDPOINT;                   // Audio data
+  *p++ = USB_EP_AUDIO_OUT;  *p++ = 0x05U;                 // Isochronous, asynchronous
+  p = Put16( p, packet_max );
+  *p++ = 1U;  *p++ = 0U;  *p++ = USB_EP_FEEDBACK_IN;
+  *p++ = 7U;  *p++ = USB_DESC_CS_ENDPOINT;  *p++ = 0x01U;
+  *p++ = 0x00U;                                           // No controls: the one rate
+  *p++ = 0U;  p = Put16( p, 0U );
+  *p++ = 9U;  *p++ = USB_DESC_ENDPOINT;                   // Feedback
+  *p++ = USB_EP_FEEDBACK_IN;  *p++ = 0x01U;               // Isochronous
+  p = Put16( p, USB_FEEDBACK_BYTES );
+  *p++ = 1U;  *p++ = USB_AUDIO_FEEDBACK_REFRESH;  *p++ = 0U;
+
+  config_desc_len = (uint16_t)( p - config_desc );
+  (void)Put16( &config_desc[ 2 ], config_desc_len );
+}
+
+
+/** Build a string descriptor in ctrl_buf
+  *
+  * @param: index - 0 for the language, 1 manufacturer, 2 product
+  * @retval: uint16_t - Descriptor length, 0 for no such string
+  */
+static uint16_t BuildStringDescriptor( uint8_t index )
+{
+  const char *text = ( index == 1U ) ? usb_cfg->manufacturer : ( index == 2U ) ? usb_cfg->product : NULL;
+  uint16_t    len  = 2U;
+
+  if( index == 0U ) {
+    (void)Put16( &ctrl_buf[ 2 ], 0x0409U );               // English (United States)
+    len = 4U;
+  } else if( text != NULL ) {
+    while( *text != '\0' && len + 2U <= sizeof( ctrl_buf ) ) {
+      len = (uint16_t)( Put16( &ctrl_buf[ len ], (uint8_t)*text++ ) - ctrl_buf );
+    }
+  } else {
+    return 0U;
+  }
+  ctrl_buf[ 0 ] = (uint8_t)len;
+  ctrl_buf[ 1 ] = USB_DESC_STRING;
+  return len;
+}
+
+
+/* ===== Control Endpoint ===== */
+
+/** Send the data stage of a control read
+  *
+  * @param: data - Response, copied unless already in ctrl_buf
+  * @param: len - Bytes, cut to the request's wLength
+  * @retval: none
+  */
+static void ControlSend( const uint8_t *data, uint16_t len )
+{
+  if( len > ctrl_setup.length ) {
+    len = ctrl_setup.length;
+  }
+  ctrl_zlp   = ( len < ctrl_setup.length && ( len % USB_EP0_SIZE ) == 0U ) ? 1U : 0U;
+  ctrl_state = CTRL_DATA_IN;
+  (void)HAL_PCD_EP_Transmit( usb_pcd, 0x80U, (uint8_t *)data, len );   // The PCD sends it a packet at a time
+}
+
+
+static void ControlStatus( void )
+{
+  ctrl_state = CTRL_IDLE;
+  (void)HAL_PCD_EP_Transmit( usb_pcd, 0x80U, NULL, 0U );
+}
+
+
+static void ControlStall( void )
+{
+  ctrl_state = CTRL_IDLE;
+  (void)HAL_PCD_EP_SetStall( usb_pcd, 0x80U );
+  (void)HAL_PCD_EP_SetStall( usb_pcd, 0x00U );           // Until the next SETUP
+}
+
+
+/** Open or close the streaming endpoints for an alternate setting of the streaming interface
+  *
+  * @param: alt - 0 or 1
+  * @retval: none
+  */
+static void SelectStreaming( uint8_t alt )
+{
+  if( alt != 0U && !streaming ) {
+    (void)HAL_PCD_EP_Open( usb_pcd, USB_EP_AUDIO_OUT, packet_max, EP_TYPE_ISOC );
+    (void)HAL_PCD_EP_Open( usb_pcd, USB_EP_FEEDBACK_IN, USB_FEEDBACK_BYTES, EP_TYPE_ISOC );
+    (void)HAL_PCD_EP_Receive( usb_pcd, USB_EP_AUDIO_OUT, audio_buf, packet_max );
+    fb_value  = fb_nominal;
+    fb_valid  = 0U;
+    fb_ticks  = 0U;
+    fb_busy   = 0U;
+    streaming = 1U;
+  } else if( alt == 0U && streaming ) {
+    streaming = 0U;
+    (void)HAL_PCD_EP_Close( usb_pcd, USB_EP_AUDIO_OUT );
+    (void)HAL_PCD_EP_Close( usb_pcd, USB_EP_FEEDBACK_IN );
+  }
+}
+
+
+/** Handle a standard request
+  *
+  * @param: req - The request
+  * @retval: none
+  */
+static void StandardRequest( const UsbSetup *req )
+{
+  switch( req->request ) {
+    case USB_REQ_GET_DESCRIPTOR:
+      switch( req->value >> 8 ) {
+        case USB_DESC_DEVICE:
+          ControlSend( device_desc, sizeof( device_desc ) );
+          return;
+        case USB_DESC_CONFIGURATION:
+          ControlSend( config_desc, config_desc_len );
+          return;
+        case USB_DESC_STRING: {
+          const uint16_t len = BuildStringDescriptor( (uint8_t)req->value );
+          if( len != 0U ) {
+            ControlSend( ctrl_buf, len );
+            return;
+          }
+          break;
+        }
+        default:                                          // Full speed only: no device qualifier
+          break;
+      }
+      break;
+
+    case USB_REQ_SET_ADDRESS:
+      (void)HAL_PCD_SetAddress( usb_pcd, (uint8_t)( req->value & 0x7FU ) );   // Takes effect after the status stage
+      ControlStatus();
+      return;
+
+    case USB_REQ_SET_CONFIGURATION:
+      if( req->value <= 1U ) {
+        configuration = (uint8_t)req->value;
+        if( configuration == 0U ) {
+          SelectStreaming( 0U );
+        }
+        ControlStatus();
+        return;
+      }
+      break;
+
+    case USB_REQ_GET_CONFIGURATION:
+      ctrl_buf[ 0 ] = configuration;
+      ControlSend( ctrl_buf, 1U );
+      return;
+
+    case USB_REQ_GET_STATUS:
+      ctrl_buf[ 0 ] = ( ( req->type & USB_REQ_RECIPIENT_MASK ) == 0U ) ? 0x01U : 0x00U;   // Self-powered
+      ctrl_buf[ 1 ] = 0U;
+      ControlSend( ctrl_buf, 2U );
+      return;
+
+    case USB_REQ_SET_INTERFACE:
+      if( configuration != 0U && req->index == UAC_STREAMING_INTERFACE && req->value <= 1U ) {
+        SelectStreaming( (uint8_t)req->value );
+        ControlStatus();
+        return;
+      }
+      if( configuration != 0U && req->index == 0U && req->value == 0U ) {
+        ControlStatus();
+        return;
+      }
+      break;
+
+    case USB_REQ_GET_INTERFACE:
+      if( configuration != 0U && req->index <= UAC_STREAMING_INTERFACE ) {
+        ctrl_buf[ 0 ] = ( req->index == UAC_STREAMING_INTERFACE ) ? streaming : 0U;
+        ControlSend( ctrl_buf, 1U );
+        return;
+      }
+      break;
+
+    case USB_REQ_CLEAR_FEATURE:
+    case USB_REQ_SET_FEATURE:                             // No halt or remote wakeup to act on
+      ControlStatus();
+      return;
+
+    default:
+      break;
+  }
+  ControlStall();
+}
+
+
+/** Handle an audio class request to the feature unit or the streaming endpoint
+  *
+  * @param: req - The request
+  * @retval: none
+  */
+static void ClassRequest( const UsbSetup *req )
+{
+  const uint8_t recipient = req->type & USB_REQ_RECIPIENT_MASK;
+  const uint8_t selector  = (uint8_t)( req->value >> 8 );
+
+  if( recipient == USB_REQ_RECIPIENT_INTERFACE && ( req->index >> 8 ) == UAC_FEATURE_UNIT_ID &&
+      ( req->value & 0xFFU ) == 0U ) {                    // Master channel
+    if( selector == UAC_FU_MUTE && req->request == UAC_GET_CUR ) {
+      ctrl_buf[ 0 ] = mute;
+      ControlSend( ctrl_buf, 1U );
+      return;
+    }
+    if( selector == UAC_FU_VOLUME && req->request != UAC_SET_CUR ) {
+      const int16_t value = ( req->request == UAC_GET_CUR ) ? volume_db :
+                            ( req->request == UAC_GET_MIN ) ? USB_AUDIO_VOLUME_MIN :
+                            ( req->request == UAC_GET_MAX ) ? 0 : USB_AUDIO_VOLUME_RES;
+      (void)Put16( ctrl_buf, (uint16_t)value );
+      ControlSend( ctrl_buf, 2U );
+      return;
+    }
+    if( ( selector == UAC_FU_MUTE || selector == UAC_FU_VOLUME ) && req->request == UAC_SET_CUR &&
+        req->length != 0U && req->length <= sizeof( ctrl_buf ) ) {
+      ctrl_state = CTRL_DATA_OUT;
+      (void)HAL_PCD_EP_Receive( usb_pcd, 0x00U, ctrl_buf, req->length );
+      return;
+    }
+  }
+
+  if( recipient == USB_REQ_RECIPIENT_ENDPOINT && ( req->index & 0xFFU ) == USB_EP_AUDIO_OUT &&
+      selector == UAC_EP_SAMPLING_FREQ ) {
+    if( req->request == UAC_GET_CUR ) {
+      (void)Put24( ctrl_buf, usb_cfg->rate );
+      ControlSend( ctrl_buf, 3U );
+      return;
+    }
+    if( req->request == UAC_SET_CUR && req->length != 0U && req->length <= sizeof( ctrl_buf ) ) {
+      ctrl_state = CTRL_DATA_OUT;                         // Only the one rate is offered; accepted and ignored
+      (void)HAL_PCD_EP_Receive( usb_pcd, 0x00U, ctrl_buf, req->length );
+      return;
+    }
+  }
+  ControlStall();
+}
+
+
+/** Apply the data of a SET_CUR
+  *
+  * @param: none
+  * @retval: none
+  */
+static void ClassRequestData( void )
+{
+  if( ( ctrl_setup.type & USB_REQ_RECIPIENT_MASK ) != USB_REQ_RECIPIENT_INTERFACE ) {
+    return;
+  }
+  if( ( ctrl_setup.value >> 8 ) == UAC_FU_MUTE ) {
+    mute = ctrl_buf[ 0 ] ? 1U : 0U;
+  } else if( ctrl_setup.length >= 2U ) {
+    int16_t value = (int16_t)( ctrl_buf[ 0 ] | ( ctrl_buf[ 1 ] << 8 ) );
+    value = ( value < USB_AUDIO_VOLUME_MIN ) ? USB_AUDIO_VOLUME_MIN : ( value > 0 ) ? 0 : value;
+    volume_db     = value;
+    volume_linear = (uint16_t)( 65535.0f * powf( 10.0f, (float)value / ( 20.0f * 256.0f ) ) + 0.5f );
+  }
+}
+
+
+/* ===== Feedback ===== */
+
+/** Work out the feedback value at a start of frame
+  *
+  * The frames the I2S played over the window, from AudioEngine_GetFrameCount(), which reads
+  * the DMA position within the period, give its rate in host milliseconds to a fraction of a
+  * frame.  The ring's distance from AUDIO_ENGINE_PUSH_LATENCY_FRAMES is added on top, made up
+  * over about 256 ms and at most a quarter frame per millisecond, so the host settles the ring
+  * there.  Until a window has been measured, or while the I2S is stopped, the nominal rate is
+  * reported.
+  *
+  * @param: none
+  * @retval: none
+  */
+static void UpdateFeedback( void )
+{
+  const int32_t limit = 1L << 12;
+  uint32_t      frames, rate;
+  int32_t       trim;
+
+  if( ++fb_ticks < USB_AUDIO_FEEDBACK_WINDOW_MS ) {
+    return;
+  }
+  fb_ticks = 0U;
+  frames   = AudioEngine_GetFrameCount();
+  rate     = (uint32_t)( ( (uint64_t)( frames - fb_frames ) << 14 ) / USB_AUDIO_FEEDBACK_WINDOW_MS );
+  if( !fb_valid || rate < fb_nominal - fb_nominal / 64U || rate > fb_nominal + fb_nominal / 64U ) {
+    rate = fb_nominal;                                    // Not a measurement of a running I2S
+  }
+  fb_frames = frames;
+  fb_valid  = 1U;
+
+  trim = ( (int32_t)AUDIO_ENGINE_PUSH_LATENCY_FRAMES - (int32_t)AudioEngine_GetPushLevel() ) * 64;   // 1/256 of the error per ms, in 10.14
+  trim = ( trim > limit ) ? limit : ( trim < -limit ) ? -limit : trim;
+  fb_value = (uint32_t)( (int32_t)rate + trim );
+}
+
+
+/* ===== PCD Callbacks ===== */
+
+void HAL_PCD_ResetCallback( PCD_HandleTypeDef *hpcd )
+{
+  SelectStreaming( 0U );
+  configuration = 0U;
+  ctrl_state    = CTRL_IDLE;
+  (void)HAL_PCD_EP_Open( hpcd, 0x00U, USB_EP0_SIZE, EP_TYPE_CTRL );
+  (void)HAL_PCD_EP_Open( hpcd, 0x80U, USB_EP0_SIZE, EP_TYPE_CTRL );
+}
+
+
+void HAL_PCD_SetupStageCallback( PCD_HandleTypeDef *hpcd )
+{
+  const uint8_t *setup = (const uint8_t *)hpcd->Setup;
+
+  ctrl_setup.type    = setup[ 0 ];
+  ctrl_setup.request = setup[ 1 ];
+  ctrl_setup.value   = (uint16_t)( setup[ 2 ] | ( setup[ 3 ] << 8 ) );
+  ctrl_setup.index   = (uint16_t)( setup[ 4 ] | ( setup[ 5 ] << 8 ) );
+  ctrl_setup.length  = (uint16_t)( setup[ 6 ] | ( setup[ 7 ] << 8 ) );
+
+  switch( ctrl_setup.type & USB_REQ_TYPE_MASK ) {
+    case USB_REQ_TYPE_STANDARD:
+      StandardRequest( &ctrl_setup );
+      break;
+    case USB_REQ_TYPE_CLASS:
+      ClassRequest( &ctrl_setup );
+      break;
+    default:
+      ControlStall();
+      break;
+  }
+}
+
+
+void HAL_PCD_DataOutStageCallback( PCD_HandleTypeDef *hpcd, uint8_t epnum )
+{
+  if( epnum == 0U ) {
+    if( ctrl_state == CTRL_DATA_OUT ) {
+      ClassRequestData();
+      ControlStatus();
+    }
+    return;                                               // Or the status stage of a read
+  }
+  if( epnum == ( USB_EP_AUDIO_OUT & 0x0FU ) && streaming ) {
+    const uint32_t bytes = HAL_PCD_EP_GetRxCount( hpcd, USB_EP_AUDIO_OUT );
+    (void)AudioEngine_PushFrames( (const int16_t *)audio_buf, bytes / frame_bytes );
+    (void)HAL_PCD_EP_Receive( hpcd, USB_EP_AUDIO_OUT, audio_buf, packet_max );
+  }
+}
+
+
+void HAL_PCD_DataInStageCallback( PCD_HandleTypeDef *hpcd, uint8_t epnum )
+{
+  if( epnum == 0U ) {
+    if( ctrl_state == CTRL_DATA_IN ) {
+      if( ctrl_zlp ) {
+        ctrl_zlp = 0U;
+        (void)HAL_PCD_EP_Transmit( hpcd, 0x80U, NULL, 0U );
+      } else {
+        ctrl_state = CTRL_IDLE;
+        (void)HAL_PCD_EP_Receive( hpcd, 0x00U, NULL, 0U );   // Status stage
+      }
+    }
+    return;
+  }
+  if( epnum == ( USB_EP_FEEDBACK_IN & 0x0FU ) ) {
+    fb_busy = 0U;
+  }
+}
+
+
+/** Measure the rate and keep a feedback packet waiting for the host's next poll
+  *
+  * @param: hpcd - PCD handle
+  * @retval: none
+  */
+void HAL_PCD_SOFCallback( PCD_HandleTypeDef *hpcd )
+{
+  if( !streaming ) {
+    return;
+  }
+  UpdateFeedback();
+  if( !fb_busy ) {
+    (void)Put24( fb_buf, fb_value );
+    fb_busy = 1U;
+    (void)HAL_PCD_EP_Transmit( hpcd, USB_EP_FEEDBACK_IN, fb_buf, USB_FEEDBACK_BYTES );
+  }
+}
+
+
+void HAL_PCD_ISOINIncompleteCallback( PCD_HandleTypeDef *hpcd, uint8_t epnum )
+{
+  (void)hpcd;
+  if( epnum == ( USB_EP_FEEDBACK_IN & 0x0FU ) ) {
+    fb_busy = 0U;                                         // Not polled this frame: sent afresh on the next SOF
+  }
+}
+
+
+/* ===== Public Interface ===== */
+
+/** Configure the endpoint buffers and connect to the host
+  *
+  * @param: hpcd - PCD handle set up by CubeMX
+  * @param: config - Identity and format; must stay valid while the device is used
+  * @retval: UsbAudio_Status - USB_AUDIO_OK once connected
+  */
+UsbAudio_Status UsbAudio_Init( PCD_HandleTypeDef *hpcd, const UsbAudio_Config *config )
+{
+  if( hpcd == NULL || config == NULL || config->manufacturer == NULL || config->product == NULL ||
+      config->rate < 8000U || config->rate > 48000U ||
+      ( config->channels != Mode_mono && config->channels != Mode_stereo ) ) {
+    return USB_AUDIO_BAD_CONFIG;
+  }
+  usb_pcd     = hpcd;
+  usb_cfg     = config;
+  frame_bytes = ( config->channels == Mode_stereo ) ? 4U : 2U;
+  packet_max  = (uint16_t)( ( config->rate + 999U ) / 1000U + 1U ) * frame_bytes;   // A frame over the nominal, for the feedback's corrections
+  fb_nominal  = (uint32_t)( ( (uint64_t)config->rate << 14 ) / 1000U );
+  fb_value    = fb_nominal;
+  streaming   = 0U;
+  playing     = 0U;
+  BuildDescriptors();
+
+  (void)HAL_PCDEx_PMAConfig( hpcd, 0x00U, PCD_SNG_BUF, USB_PMA_EP0_OUT );
+  (void)HAL_PCDEx_PMAConfig( hpcd, 0x80U, PCD_SNG_BUF, USB_PMA_EP0_IN );
+  (void)HAL_PCDEx_PMAConfig( hpcd, USB_EP_AUDIO_OUT, PCD_SNG_BUF, USB_PMA_AUDIO_OUT );
+  (void)HAL_PCDEx_PMAConfig( hpcd, USB_EP_FEEDBACK_IN, PCD_SNG_BUF, USB_PMA_FEEDBACK_IN );
+  return ( HAL_PCD_Start( hpcd ) == HAL_OK ) ? USB_AUDIO_OK : USB_AUDIO_USB_ERROR;
+}
+
+
+/** Start or stop playback as the host opens or closes the stream
+  *
+  * @param: none
+  * @retval: none
+  */
+void UsbAudio_Service( void )
+{
+  if( streaming && !playing ) {
+    const PB_StatusTypeDef status = PlayPushedSource( usb_cfg->rate, usb_cfg->channels );
+    playing = ( status == PB_Playing || status == PB_Primed ) ? 1U : 0U;
+  } else if( !streaming && playing ) {
+    StopPlayback();
+    playing = 0U;
+  }
+}
+
+
+/** Volume function following the host's volume and mute
+  *
+  * @param: none
+  * @retval: uint16_t - 0-65535, linear in amplitude
+  */
+uint16_t UsbAudio_ReadVolume( void )
+{
+  return mute ? 0U : volume_linear;
+}
+
+
+uint8_t UsbAudio_IsStreaming( void )
+{
+  return streaming;
+}
+
+
+uint32_t UsbAudio_GetFeedback( void )
+{
+  return fb_value;
+}
+
+#endif // AUDIO_ENGINE_ENABLE_PUSH_SOURCE && HAL_PCD_MODULE_ENABLED
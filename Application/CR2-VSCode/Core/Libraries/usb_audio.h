@@ -0,0 +1,126 @@
+/**
+  ******************************************************************************
+  * @file           : usb_audio.h
+  * @brief          : USB Audio Class 1 speaker feeding the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Presents the chime to a host PC or Raspberry Pi as a USB Audio Class 1 speaker
+  * on the G474's full-speed USB device, and plays what the host sends through the
+  * audio engine's pushed source (AUDIO_ENGINE_ENABLE_PUSH_SOURCE):
+  *
+  *   MX_USB_PCD_Init();                        // hpcd_USB_FS
+  *   UsbAudio_Init( &hpcd_USB_FS, &usb_config );
+  *   AudioEngine_Init( DAC_MasterSwitch, UsbAudio_ReadVolume, MX_I2S2_Init );   // Optional
+  *   while( 1 ) { UsbAudio_Service(); }
+  *
+  * The streaming endpoint is asynchronous: the chime's I2S clock sets the rate,
+  * and an explicit feedback endpoint tells the host how many frames to send per
+  * millisecond.  The value is measured from the I2S DMA position over
+  * USB_AUDIO_FEEDBACK_WINDOW_MS start-of-frame ticks, and trimmed by how far the
+  * engine's elastic ring sits from AUDIO_ENGINE_PUSH_LATENCY_FRAMES, so the ring
+  * neither fills nor runs dry however far the two clocks differ.
+  *
+  * The module is the whole device stack: it implements the HAL_PCD callbacks, so
+  * it cannot share the USB peripheral with another class.  The USB kernel clock
+  * is the application's, HSI48 with the CRS synchronised to the host's SOF.
+  *
+  ******************************************************************************
+  */
+
+#ifndef _USB_AUDIO_H
+#define _USB_AUDIO_H
+
+#include "main.h"
+#include "audio_engine.h"
+
+#include <stdint.h>
+
+/* Start-of-frame ticks (milliseconds) over which the host's frame rate is measured */
+#ifndef USB_AUDIO_FEEDBACK_WINDOW_MS
+#define USB_AUDIO_FEEDBACK_WINDOW_MS 64U
+#endif
+
+/* Feedback endpoint poll period as bRefresh: the host reads it every 2^n milliseconds */
+#ifndef USB_AUDIO_FEEDBACK_REFRESH
+#define USB_AUDIO_FEEDBACK_REFRESH 3U
+#endif
+
+/* Attenuation at the bottom of the host's volume control, in dB */
+#ifndef USB_AUDIO_VOLUME_MIN_DB
+#define USB_AUDIO_VOLUME_MIN_DB 60U
+#endif
+
+/* Device identity and stream format.  The strings are ASCII and must stay valid. */
+typedef struct {
+  uint16_t        vendor_id;
+  uint16_t        product_id;
+  const char     *manufacturer;
+  const char     *product;
+  uint32_t        rate;                     // Hz, 8000 to 48000: the only rate offered, played as it is
+  PB_ModeTypeDef  channels;                 // Mode_mono or Mode_stereo
+} UsbAudio_Config;
+
+typedef enum {
+  USB_AUDIO_OK,
+  USB_AUDIO_BAD_CONFIG,                     // A NULL handle or string, or a rate or mode not offered
+  USB_AUDIO_USB_ERROR                       // The PCD did not start
+} UsbAudio_Status;
+
+/**
+ * @brief Configure the endpoint buffers and connect to the host
+ * @param[in] hpcd PCD handle set up by CubeMX for the USB peripheral
+ * @param[in] config Identity and format; must stay valid while the device is used
+ * @return USB_AUDIO_OK once connected
+ */
+UsbAudio_Status     UsbAudio_Init                     ( PCD_HandleTypeDef *hpcd, const UsbAudio_Config *config );
+
+/**
+ * @brief Start or stop playback as the host opens or closes the stream
+ * @note Application context only, from the main loop. Starts PlayPushedSource() when the host
+ *       selects the streaming alternate setting and stops playback when it leaves it.
+ */
+void                UsbAudio_Service                  ( void );
+
+/**
+ * @brief Volume function for AudioEngine_Init() following the host's volume and mute
+ * @return 0-65535, linear in amplitude; use the linear response, as the host's control is in dB
+ */
+uint16_t            UsbAudio_ReadVolume               ( void );
+
+/**
+ * @brief Check whether the host has the stream open
+ * @return 1 while the streaming alternate setting is selected
+ */
+uint8_t             UsbAudio_IsStreaming              ( void );
+
+/**
+ * @brief Get the rate last reported on the feedback endpoint
+ * @return Frames per millisecond in 10.14 fixed point, as sent to the host
+ */
+uint32_t            UsbAudio_GetFeedback              ( void );
+
+#endif // End of _USB_AUDIO_H
@@ -32,6 +32,39 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "audio_engine.h"
+#if AUDIO_ENGINE_BENCHMARK_MAIN
+#include "dsp_bench.h"
+#endif
+#if AUDIO_ENGINE_LOOPBACK_MAIN
+#include "i2s_loopback.h"
+#endif
+#if PC_SAMPLER_ENABLE
+#include "pc_sampler.h"
+#endif
+#if TRIGGER_EVENT_DEBOUNCE
+#include "stm32g4xx_ll_bus.h"
+#include "stm32g4xx_ll_exti.h"
+#include "stm32g4xx_ll_lptim.h"
+#include "stm32g4xx_ll_rcc.h"
+#endif
+#if LOW_LATENCY_TRIGGER && TRIGGER_EVENT_DEBOUNCE
+#error "LOW_LATENCY_TRIGGER and TRIGGER_EVENT_DEBOUNCE are alternative trigger front ends"
+#endif
+#if SPECULATIVE_TRIGGER && ( LOW_LATENCY_TRIGGER || TRIGGER_EVENT_DEBOUNCE )
+#error "SPECULATIVE_TRIGGER primes on the edges the SysTick trigger filter confirms; LOW_LATENCY_TRIGGER primes before them"
+#endif
+#if MULTI_TRIGGER
+#if LOW_LATENCY_TRIGGER || TRIGGER_EVENT_DEBOUNCE || SPECULATIVE_TRIGGER
+#error "MULTI_TRIGGER debounces TRIGGER itself, on TIM3; the other trigger front ends cannot share it"
+#endif
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX || defined( VOLUME_INPUT_DIGITAL )
+#error "MULTI_TRIGGER takes OPT1 and OPT2 as trigger inputs; they cannot also select the sound or set the volume"
+#endif
+#if !( AUDIO_ENGINE_MIXER_VOICES > 0 )
+#error "MULTI_TRIGGER plays its sounds on mixer voices: set AUDIO_ENGINE_MIXER_VOICES"
+#endif
+#include "multi_trigger.h"
+#endif
 
 // Sample data includes, use as needed.
 
@@ -109,6 +142,9 @@ ADC_HandleTypeDef hadc1;
 TIM_HandleTypeDef htim7;
 I2S_HandleTypeDef hi2s2;
 DMA_HandleTypeDef hdma_spi2_tx;
+#ifndef VOLUME_INPUT_DIGITAL
+DMA_HandleTypeDef hdma_adc1;
+#endif
 
 /* USER CODE BEGIN PV */
 
@@ -117,11 +153,120 @@ volatile  uint16_t        trig_counter                  = 0;              // Cou
 volatile  uint8_t         trig_timeout_flag             = 0;              // Flag indicating trigger timeout has occurred
 volatile  uint16_t        trig_timeout_counter          = 0;              // Counter for trigger timeout duration
 volatile  uint8_t         trig_status                   = TRIGGER_CLR;    // Current trigger status  (SET or CLR)
+#if SPECULATIVE_TRIGGER
+static volatile uint8_t   trig_edge_pending             = 0;              // A rising edge the filter has yet to confirm
+static          uint8_t   trig_primed                   = 0;              // The selected sound was primed on that edge
+#endif
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+static volatile uint8_t   amp_on                        = 0;              // NSD_MODE is high
+static volatile uint32_t  amp_on_tick                   = 0;              // HAL tick at which it went high
+static volatile uint8_t   amp_early                     = 0;              // Turned on by a trigger edge not yet confirmed
+#endif
+
+#ifndef VOLUME_INPUT_DIGITAL
+volatile  uint16_t        adc_dma_buffer[ VOLUME_ADC_DMA_SAMPLES ];      // Oversampled volume readings, refilled by circular DMA
+#endif
+
+// Engine configuration at startup, precomputed so applying it converts nothing at run time
+static const AudioEngine_Preset startup_preset =
+{
+  .filter =
+  {
+    .enable_16bit_biquad_lpf      = 0,                          // 16-bit biquad LPF off; enable as needed
+    .enable_soft_dc_filter_16bit  = 1,                          // Soft DC blocking filter for 16-bit samples
+    .enable_8bit_lpf              = 0,                          // 8-bit LPF off; enable as needed
+    .enable_noise_gate            = 0,                          // Noise gate off; enable as needed
+    .enable_soft_clipping         = 1,
+    .enable_air_effect            = 0,                          // Air effect (high-shelf brightening) off
+    .lpf_makeup_gain_q16          = LPF_MAKEUP_GAIN_Q16,
+    .lpf_makeup_gain_16bit_q16    = LPF_16BIT_MAKEUP_GAIN_Q16,  // 1.0 for testing purposes
+    .lpf_16bit_level              = LPF_Off,
+    .lpf_16bit_custom_alpha       = LPF_16BIT_SOFT,
+    .lpf_8bit_level               = LPF_Medium,
+    .lpf_8bit_custom_alpha        = LPF_MEDIUM,
+    .enable_filter_chain_16bit    = 1,                          // Master enable for entire 16-bit filter chain
+    .enable_filter_chain_8bit     = 0                           // Master enable for entire 8-bit filter chain
+  },
+  .air_gain_q16   = 73533,                                      // +1 dB, for when the air effect is enabled
+  .fade_in_ms     = 500,
+  .fade_out_ms    = 500,
+  .pause_fade_ms  = 1150,
+  .resume_fade_ms = 1250,
+  .faders_enabled = 1
+};
+
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+#ifdef VOLUME_INPUT_DIGITAL
+#error "The OPT1-OPT3 pads select the sound with AUDIO_ENGINE_ENABLE_ASSET_INDEX; they cannot also set the volume"
+#endif
+
+// Sounds selectable with the OPT1-OPT3 pads (ReadSoundSelect()). ID 0 plays with no pads bridged
+// and for an ID with no sound.  Mind the flash: one 16-bit sound is typically 100-250 KB.
+AUDIO_ENGINE_INDEX_SAMPLE( 0, secret_door16b16k1c, SECRET_DOOR16B16K1C_SZ, I2S_AUDIOFREQ_16K, 16, SECRET_DOOR16B16K1C_PB_FMT );
+AUDIO_ENGINE_INDEX_SAMPLE( 1, custom_tritone16k, CUSTOM_TRITONE16K_SZ, I2S_AUDIOFREQ_16K, 16, CUSTOM_TRITONE16K_PB_FMT );
+AUDIO_ENGINE_INDEX_SAMPLE( 2, big_gong8b1c11k, BIG_GONG8B1C11K_SZ, I2S_AUDIOFREQ_11K, 8, Mode_mono );
+#endif
+
+#if MULTI_TRIGGER
+// One sound per trigger input, each on its own mixer voice so they overlap (MultiTrigger_Init())
+static const AudioAsset front_door_sound =
+{
+  .data        = secret_door16b16k1c,
+  .sample_sz   = SECRET_DOOR16B16K1C_SZ,
+  .sample_rate = I2S_AUDIOFREQ_16K,
+  .encoding    = ASSET_PCM16,
+  .channels    = ( SECRET_DOOR16B16K1C_PB_FMT == Mode_stereo ) ? 2U : 1U
+};
+static const AudioAsset back_door_sound =
+{
+  .data        = custom_tritone16k,
+  .sample_sz   = CUSTOM_TRITONE16K_SZ,
+  .sample_rate = I2S_AUDIOFREQ_16K,
+  .encoding    = ASSET_PCM16,
+  .channels    = ( CUSTOM_TRITONE16K_PB_FMT == Mode_stereo ) ? 2U : 1U
+};
+static const AudioAsset intercom_sound =
+{
+  .data        = big_gong8b1c11k,
+  .sample_sz   = BIG_GONG8B1C11K_SZ,
+  .sample_rate = I2S_AUDIOFREQ_11K,
+  .encoding    = ASSET_PCM8,
+  .channels    = 1U
+};
+
+// TRIGGER, OPT1 and OPT2, all active high with the pull-downs of MX_GPIO_Init()
+static const MultiTrigger_Input trigger_inputs[] =
+{
+  { TRIGGER_GPIO_Port, TRIGGER_Pin, &front_door_sound, 65535U, 0, 1U },   // Front door
+  { OPT1_GPIO_Port,    OPT1_Pin,    &back_door_sound,  65535U, 0, 1U },   // Back door
+  { OPT2_GPIO_Port,    OPT2_Pin,    &intercom_sound,   49152U, 0, 2U }    // Intercom, above the doors when voices run out
+};
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+// Asset bank partition from the linker script.  A valid bank's sounds take the place of the
+// compiled-in ones, so chimes can be changed without reflashing the firmware.
+extern const uint8_t __asset_bank_start[];
+extern const uint8_t __asset_bank_end[];
+        uint8_t             bank_mounted = 0;
+#endif
+
+#if AUDIO_ENGINE_ENABLE_PRESET_STORE
+// Preset store partition from the linker script, holding the configuration last saved
+extern const uint8_t __preset_store_start[];
+extern const uint8_t __preset_store_end[];
+#endif
 
-volatile  uint16_t        adc_out                       = 0;              // 
+#if STOP_MODE_IDLE
+static  volatile uint8_t    clock_restoring = 0;          // Woken from STOP, SYSCLK on HSI16 until the PLL locks
+#endif
 
-// External variables from audio_engine
-extern FilterConfig_TypeDef filter_cfg;
+#if FAST_BOOT
+static  uint8_t             deferred_init_done = 0;       // FastBoot_DeferredInit() has run
+#ifndef VOLUME_INPUT_DIGITAL
+static  uint8_t             volume_adc_ready = 0;         // The volume DMA has filled its buffer once
+#endif
+#endif
 
 /* USER CODE END PV */
 
@@ -139,9 +284,37 @@ static  void                MX_TIM7_Init                ( void );
 // Hardware-specific function prototypes
         void                DAC_MasterSwitch            ( GPIO_PinState setting );    // Used in audio_engine
         uint16_t            ReadVolume                  ( void );                     // Used in audio_engine
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+static  uint8_t             DAC_Settled                 ( void );                     // Used in audio_engine
+#endif
         void                WaitForTrigger              ( uint8_t trig_to_wait_for );
         uint8_t             GetTriggerOption            ( void );
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+        uint8_t             ReadSoundSelect             ( void );
+#endif
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+        PB_StatusTypeDef    PlayBankSound               ( void );
+#endif
+static  void                PlayTriggeredSound          ( void );
+#if SPECULATIVE_TRIGGER
+static  void                SpeculateTrigger            ( void );
+#endif
+#if TRIGGER_EVENT_DEBOUNCE
+static  void                TriggerDebounce_Init        ( void );
+static  void                TriggerDebounceRestart      ( void );
+#endif
         void                LPSystemClock_Config        ( void );
+#if STOP_MODE_IDLE
+        void                SystemClock_StartRestore    ( void );
+        void                SystemClock_FinishRestore   ( void );
+#endif
+#if FAST_BOOT
+static  void                WaitForSupplyReady          ( void );
+static  void                FastBoot_DeferredInit       ( void );
+#endif
+#ifndef VOLUME_INPUT_DIGITAL
+static  void                StartVolumeAdc              ( void );
+#endif
       // ...existing code...
 
 /* USER CODE END PFP */
@@ -186,60 +359,112 @@ int main(void)
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_DMA_Init();
-  #ifndef VOLUME_INPUT_DIGITAL
+  #if !defined( VOLUME_INPUT_DIGITAL ) && !FAST_BOOT
   MX_ADC1_Init();
   MX_TIM7_Init();
   #endif
   /* USER CODE BEGIN 2 */
 
-  #ifndef VOLUME_INPUT_DIGITAL
-  HAL_ADC_Start_IT( &hadc1 );         // Start ADC in interrupt mode
-  HAL_TIM_Base_Start( &htim7 );       // Start TIM7 for ADC triggering
+  #if !defined( VOLUME_INPUT_DIGITAL ) && !FAST_BOOT
+  StartVolumeAdc();
   #endif
   
+#if AUDIO_ENGINE_LOOPBACK_MAIN
+  // Loopback test firmware: play the test cases into the SPI3 capture, report over SWO and stop
+  Loopback_Run( DAC_MasterSwitch, MX_I2S2_Init );
+  while( true ) {
+    __WFI();
+  }
+#endif
+
   /* Initialize audio engine with hardware interface functions */
   if( AudioEngine_Init( DAC_MasterSwitch, ReadVolume, MX_I2S2_Init ) != PB_Idle ) {
     Error_Handler();
   }
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+  AudioEngine_SetDACReady( DAC_Settled );   // The engine streams silence until the amplifier is up
+#endif
+  AudioEngine_SetOutputTopology( OUTPUT_TOPOLOGY_MONO_SPEAKER );  // One speaker on the MAX98357A: filter stereo assets once
+#if AUDIO_ENGINE_ENABLE_MUTE
+  AudioEngine_SetMuteLevel( VOLUME_MIN_CLAMP );  // The control's lowest position mutes, at almost no render cost
+#endif
+
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+  // An erased or half-written bank fails its checks and the compiled-in sounds play instead
+#if AUDIO_ENGINE_ENABLE_BANK_UPDATE
+  bank_mounted = ( AudioEngine_MountNewestBank( __asset_bank_start,
+                                                (uint32_t)( __asset_bank_end - __asset_bank_start ) / 2U ) == PB_Idle );
+#else
+  bank_mounted = ( AudioEngine_MountBank( __asset_bank_start,
+                                          (uint32_t)( __asset_bank_end - __asset_bank_start ) ) == PB_Idle );
+#endif
+#endif
 
+#if FAST_BOOT
+  // The engine's default curve is already the one below; wait for the supply, not a fixed time
+  WaitForSupplyReady();
+#else
   // Configure volume response curve (human perception matched)
   SetVolumeResponseNonlinear( 1 );    // Enable non-linear (logarithmic) response
   SetVolumeResponseGamma( 2.0f );     // Gamma = 2.0 (quadratic, typical for human perception)
 
   // Small delay to allow hardware to stabilize
   HAL_Delay( 150 );
+#endif
 
   // Set DAC control to manual and start with it on.
   //DAC_MasterSwitch( DAC_ON );         // Start with DAC off until ready to play
   SetDAC_Control( 1 );                // 0 = manual control, 1 = auto control by audio engine
 
-  // FilterConfig_TypeDef filter_cfg;
-  filter_cfg.enable_noise_gate            = 0;  // Noise gate disabled by default; enable as needed
-  filter_cfg.enable_16bit_biquad_lpf      = 1;  // 16-bit biquad LPF disabled by default; enable as needed
-  filter_cfg.enable_8bit_lpf              = 0;  // 8-bit LPF disabled by default; enable as needed
-  filter_cfg.enable_soft_dc_filter_16bit  = 1;  // Soft DC blocking filter for 16-bit samples enabled by default
-  filter_cfg.enable_soft_clipping         = 1;  // Soft clipping enabled by default
-  filter_cfg.enable_air_effect            = 0;  // Air effect (high-shelf brightening) disabled by default; enable as needed
-  filter_cfg.enable_filter_chain_16bit    = 1;  // Master enable for entire 16-bit filter chain
-  filter_cfg.enable_filter_chain_8bit     = 0;  // Master enable for entire 8-bit filter chain
-
-  // Apply initial filter configuration
-  SetFilterConfig( &filter_cfg );
-
-  // Set initial Air Effect boost in dB (runtime adjustable)
-  SetAirEffectPresetDb( 0 );       // default +3 dB preset
-  
-  // Set fade times
-  SetFadeInTime( 0.5f );                 // 0.5 s fade-in
-  SetFadeOutTime( 0.5f );                // 0.5 s fade-out
-  SetPauseFadeTime( 1.15f );              // 1150 ms pause fade-out
-  SetResumeFadeTime( 1.25f );             // 1250 ms resume fade-in
-
-  // Set LPF filter levels and makeup gain
-  SetLpf16BitLevel( LPF_Off );  // Start with LPF off
-  SetSoftClippingEnable( 1 );
+  // Filters, air effect gain and fade times in one step (see startup_preset)
+#if AUDIO_ENGINE_ENABLE_PRESET_STORE
+  // The configuration saved in the field takes the place of startup_preset once there is one
+  if( AudioEngine_MountPresetStore( __preset_store_start,
+                                    (uint32_t)( __preset_store_end - __preset_store_start ) ) != PB_Idle ) {
+    ApplyPreset( &startup_preset );
+  }
+#else
+  ApplyPreset( &startup_preset );
+#endif
+
+#if LOW_LATENCY_TRIGGER
+  // The trigger EXTI times its edge confirmation with the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#elif TRIGGER_EVENT_DEBOUNCE
+  // The trigger is debounced by the EXTI and LPTIM1 instead of SysTick
+  TriggerDebounce_Init();
+#endif
+
+#if AUDIO_ENGINE_BENCHMARK_MAIN
+  // Benchmark firmware: time the DSP stages with this configuration, report over SWO and stop
+  Benchmark_Run();
+  while( true ) {
+    __WFI();
+  }
+#endif
+
+#if MULTI_TRIGGER
+  // The inputs start their sounds from their interrupts on the running stream, so the main
+  // loop only sleeps between the engine's idle jobs
+  if( AudioEngine_StartStream( I2S_AUDIOFREQ_16K ) != PB_Idle ) {
+    Error_Handler();
+  }
+  __HAL_RCC_TIM3_CLK_ENABLE();
+  HAL_NVIC_SetPriority( TIM3_IRQn, 0, 0 );          // As the EXTI lines: they share the inputs' state
+  HAL_NVIC_EnableIRQ( TIM3_IRQn );
+  if( MultiTrigger_Init( TIM3, trigger_inputs, (uint8_t)( sizeof( trigger_inputs ) / sizeof( trigger_inputs[ 0 ] ) ) ) != MULTI_TRIGGER_OK ) {
+    Error_Handler();
+  }
+  while( true ) {
+#if AUDIO_ENGINE_ENABLE_IDLE_JOBS
+    while( AudioEngine_RunIdleJobs() != 0U ) {
+    }
+#endif
+    __WFI();
+  }
+#endif
   //SetLpf16BitCustomAlpha( CalcLpf16BitAlphaFromCutoff( 3000, I2S_AUDIOFREQ_22K ) );  // Set 16-bit biquad LPF cutoff to 20 kHz for 22 kHz sample rate
-  SetLpfMakeupGain16Bit( 1.0f );  // Set at 1 for testing purposes.
   
   /* USER CODE END 2 */
 
@@ -252,17 +477,50 @@ int main(void)
     //
 #ifndef TEST_CYCLING
     if( GetTriggerOption() == AUTO_TRIG_ENABLED ) {
+#if AUDIO_ENGINE_ENABLE_ATTACK_CACHE
+      // Render the selected sound's attack while idle, so the trigger starts it from the cache
+      if( AudioEngine_CacheNextAttack() == PB_Idle ) {
+        PlayTriggeredSound();
+      }
+#endif
+#if LOW_LATENCY_TRIGGER
+      // Render the first periods and power the DAC now, so the edge only starts the DMA
+      if( AudioEngine_PrimeNextPlayback() == PB_Idle ) {
+        PlayTriggeredSound();
+      }
+#endif
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+      AudioEngine_SetEnergyPhase( ENERGY_PHASE_TRIGGER_WAIT );
+      WaitForTrigger( TRIGGER_SET );
+      AudioEngine_SetEnergyPhase( ENERGY_PHASE_APP );
+#else
       WaitForTrigger( TRIGGER_SET );
+#endif
     }
 #endif
  
     // Start playback of sound sample
     //
-    // PlaySample( didgeridoo16b16k1c , DIDGERIDOO16B16K1C_SZ,
-    //   I2S_AUDIOFREQ_22K, 16, DIDGERIDOO16B16K1C_PB_FMT );
-    PlaySample( secret_door16b16k1c, SECRET_DOOR16B16K1C_SZ,
-      I2S_AUDIOFREQ_16K, 16, SECRET_DOOR16B16K1C_PB_FMT );
+#if PC_SAMPLER_ENABLE
+    PcSampler_Start();                // Profile this playback, reported once it has ended
+#endif
+#if LOW_LATENCY_TRIGGER || SPECULATIVE_TRIGGER
+    if( AudioEngine_StartPrimed() != PB_Playing )   // Not primed, or the primed start failed
+#endif
+    {
+      PlayTriggeredSound();
+    }
+#if FAST_BOOT
+    FastBoot_DeferredInit();          // The first sound is under way: bring up the rest
+#endif
     WaitForSampleEnd();
+#if PC_SAMPLER_ENABLE
+    PcSampler_Stop();
+    PcSampler_Dump();
+#endif
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+    AudioEngine_DumpEnergyStats( 1 ); // Where the time of this playback went, over SWO
+#endif
 
     ShutDownAudio();
 
@@ -271,6 +529,7 @@ int main(void)
     // Wake from interrupt on TRIGGER pin.
     //
     if( GetTriggerOption() == AUTO_TRIG_DISABLED ) {
+      AudioEngine_StopStream();       // No-op unless AUDIO_ENGINE_ALWAYS_ON kept the I2S running
       LPSystemClock_Config();
       HAL_SuspendTick();
       __disable_irq();
@@ -373,6 +632,91 @@ void LPSystemClock_Config( void )
 }
 
 
+#if STOP_MODE_IDLE
+/** Starts restoring the system clock after a wake from STOP mode
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: STOP wakes on HSI16 with the PLL off; its configuration, the voltage range and the
+  *       flash wait states are retained.  The HAL clock state is brought in line with HSI16
+  *       so SysTick keeps counting ms, then the PLL is started without waiting for it:
+  *       SystemClock_PllReady() switches SYSCLK over from the RCC interrupt once it locks.
+  */
+void SystemClock_StartRestore( void )
+{
+  RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+
+  RCC_ClkInitStruct.ClockType       = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
+                                    | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+  RCC_ClkInitStruct.SYSCLKSource    = RCC_SYSCLKSOURCE_HSI;
+  RCC_ClkInitStruct.AHBCLKDivider   = RCC_SYSCLK_DIV1;
+  RCC_ClkInitStruct.APB1CLKDivider  = RCC_HCLK_DIV1;
+  RCC_ClkInitStruct.APB2CLKDivider  = RCC_HCLK_DIV1;
+
+  if( HAL_RCC_ClockConfig( &RCC_ClkInitStruct, FLASH_LATENCY_4 ) != HAL_OK )   // Wait states for the PLL already
+  {
+    Error_Handler();
+  }
+
+  clock_restoring = 1;
+  __HAL_RCC_CLEAR_IT( RCC_IT_PLLRDY );
+  __HAL_RCC_ENABLE_IT( RCC_IT_PLLRDY );         // The flag is only raised while enabled
+  HAL_NVIC_SetPriority( RCC_IRQn, 0, 0 );
+  HAL_NVIC_EnableIRQ( RCC_IRQn );
+  __HAL_RCC_PLL_ENABLE();
+}
+
+
+/** Switches SYSCLK to the relocked PLL
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: Called from RCC_IRQHandler().  HAL_RCC_ClockConfig() takes the AHB through the /2
+  *       step the switch above 80 MHz needs and reloads SysTick for the full clock.
+  */
+void SystemClock_PllReady( void )
+{
+  RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+
+  __HAL_RCC_DISABLE_IT( RCC_IT_PLLRDY );
+
+  RCC_ClkInitStruct.ClockType       = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
+                                    | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+  RCC_ClkInitStruct.SYSCLKSource    = RCC_SYSCLKSOURCE_PLLCLK;
+  RCC_ClkInitStruct.AHBCLKDivider   = RCC_SYSCLK_DIV1;
+  RCC_ClkInitStruct.APB1CLKDivider  = RCC_HCLK_DIV1;
+  RCC_ClkInitStruct.APB2CLKDivider  = RCC_HCLK_DIV1;
+
+  if( HAL_RCC_ClockConfig( &RCC_ClkInitStruct, FLASH_LATENCY_4 ) != HAL_OK )
+  {
+    Error_Handler();
+  }
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+  AudioEngine_SetPowerState( ENERGY_STATE_RUN );  // Time from here at the full clock
+#endif
+  clock_restoring = 0;
+}
+
+
+/** Waits until a clock restore started by SystemClock_StartRestore() has finished
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: The I2S is clocked from SYSCLK, so playback must not be set up on HSI16.  The PLL
+  *       locks well within the trigger filter's TC_HIGH_THRESHOLD ms, so this rarely waits.
+  */
+void SystemClock_FinishRestore( void )
+{
+  while( clock_restoring ) {
+    __WFI();                                    // The RCC interrupt ends it
+  }
+}
+#endif
+
+
 /**
   * @brief I2S2 Initialization Function
   * @param None
@@ -391,7 +735,11 @@ static void MX_I2S2_Init( void )
   hi2s2.Instance        = SPI2;
   hi2s2.Init.Mode       = I2S_MODE_MASTER_TX;
   hi2s2.Init.Standard   = I2S_STANDARD_PHILIPS;
+#if AUDIO_ENGINE_OUTPUT_32BIT
+  hi2s2.Init.DataFormat = I2S_DATAFORMAT_32B;   // 32-bit frames from the engine's output stage
+#else
   hi2s2.Init.DataFormat = I2S_DATAFORMAT_16B;
+#endif
   hi2s2.Init.MCLKOutput = I2S_MCLKOUTPUT_DISABLE;
 
   /* Use the requested playback speed so PlaySample() can change sample rate */
@@ -402,7 +750,15 @@ static void MX_I2S2_Init( void )
     Error_Handler();
   }
   /* USER CODE BEGIN I2S2_Init 2 */
-
+#if AUDIO_ENGINE_ENABLE_I2S_CLOCK_PLAN
+  /* Replace the HAL's SYSCLK divider with the clock and divider nearest the requested rate */
+  AudioEngine_I2SClock i2s_clock;
+  AudioEngine_PlanI2SClock( I2S_PlaybackSpeed, &i2s_clock );
+  if( AudioEngine_ApplyI2SClock( &hi2s2, &i2s_clock ) != HAL_OK )
+  {
+    Error_Handler();
+  }
+#endif
   /* USER CODE END I2S2_Init 2 */
 
 }
@@ -423,6 +779,8 @@ static void MX_DMA_Init( void )
   HAL_NVIC_SetPriority( DMA1_Channel1_IRQn, 6, 0 );
   HAL_NVIC_EnableIRQ( DMA1_Channel1_IRQn );
 
+  /* DMA1_Channel2 (ADC1 volume) runs circular without interrupts */
+
 }
 
 
@@ -464,14 +822,37 @@ static void MX_GPIO_Init( void )
   HAL_NVIC_SetPriority( EXTI4_IRQn, 0, 0 );
   HAL_NVIC_EnableIRQ( EXTI4_IRQn );
 
+#if MULTI_TRIGGER
+  /*Configure GPIO pins : OPT2_Pin OPT1_Pin as trigger inputs with interrupt */
+  GPIO_InitStruct.Pin   = OPT2_Pin | OPT1_Pin;
+  GPIO_InitStruct.Mode  = GPIO_MODE_IT_RISING_FALLING;
+  GPIO_InitStruct.Pull  = GPIO_PULLDOWN;
+  HAL_GPIO_Init( GPIOB, &GPIO_InitStruct );
+  HAL_NVIC_SetPriority( EXTI9_5_IRQn, 0, 0 );
+  HAL_NVIC_EnableIRQ( EXTI9_5_IRQn );
+
+  /*Configure GPIO pins : OPT4_Pin OPT3_Pin */
+  GPIO_InitStruct.Pin   = OPT4_Pin | OPT3_Pin;
+#else
   /*Configure GPIO pins : OPT4_Pin OPT3_Pin OPT2_Pin OPT1_Pin */
   GPIO_InitStruct.Pin   = OPT4_Pin | OPT3_Pin | OPT2_Pin | OPT1_Pin;
+#endif
   GPIO_InitStruct.Mode  = GPIO_MODE_INPUT;
   GPIO_InitStruct.Pull  = GPIO_PULLDOWN;
   HAL_GPIO_Init( GPIOB, &GPIO_InitStruct );
 
   /* USER CODE BEGIN MX_GPIO_Init_2 */
-
+#if AUDIO_ENGINE_ENABLE_TRACE_PINS
+  /*Configure GPIO pins : audio engine scope trace points, low until the engine drives them */
+  if( AUDIO_ENGINE_TRACE_PINS != 0U ) {
+    HAL_GPIO_WritePin( AUDIO_ENGINE_TRACE_PORT, AUDIO_ENGINE_TRACE_PINS, GPIO_PIN_RESET );
+    GPIO_InitStruct.Pin   = AUDIO_ENGINE_TRACE_PINS;
+    GPIO_InitStruct.Mode  = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull  = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    HAL_GPIO_Init( AUDIO_ENGINE_TRACE_PORT, &GPIO_InitStruct );
+  }
+#endif
   /* USER CODE END MX_GPIO_Init_2 */
 }
 
@@ -552,9 +933,13 @@ static void MX_ADC1_Init( void )
   hadc1.Init.DiscontinuousConvMode    = DISABLE;
   hadc1.Init.ExternalTrigConv         = ADC_EXTERNALTRIG_T7_TRGO;
   hadc1.Init.ExternalTrigConvEdge     = ADC_EXTERNALTRIGCONVEDGE_RISING;
-  hadc1.Init.DMAContinuousRequests    = DISABLE;
-  hadc1.Init.Overrun                  = ADC_OVR_DATA_PRESERVED;
-  hadc1.Init.OversamplingMode         = DISABLE;
+  hadc1.Init.DMAContinuousRequests    = ENABLE;
+  hadc1.Init.Overrun                  = ADC_OVR_DATA_OVERWRITTEN;
+  hadc1.Init.OversamplingMode         = ENABLE;
+  hadc1.Init.Oversampling.Ratio                 = ADC_OVERSAMPLING_RATIO_16;          // 16 conversions per trigger...
+  hadc1.Init.Oversampling.RightBitShift         = ADC_RIGHTBITSHIFT_4;                // ...averaged back to 12 bits
+  hadc1.Init.Oversampling.TriggeredMode         = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+  hadc1.Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
   if( HAL_ADC_Init( &hadc1 ) != HAL_OK )
   {
     Error_Handler();
@@ -598,6 +983,8 @@ static void MX_ADC1_Init( void )
   *
   * NOTE: HAL_GPIO_WritePin() is not reentrant; protect with interrupt disable
   * to prevent race conditions on GPIO register access.
+  * With AUDIO_ENGINE_ENABLE_DAC_SETTLE it returns at once and DAC_Settled() reports
+  * when the amplifier is ready; switching on an amplifier already on keeps its start time.
   */
 void DAC_MasterSwitch( GPIO_PinState setting )
 {
@@ -606,13 +993,114 @@ void DAC_MasterSwitch( GPIO_PinState setting )
   
   /* Change the setting */
   HAL_GPIO_WritePin( NSD_MODE_GPIO_Port, NSD_MODE_Pin, setting );
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+  if( setting == DAC_OFF ) {
+    amp_on    = 0;
+    amp_early = 0;
+  }
+  else if( !amp_on ) {
+    amp_on_tick = HAL_GetTick();
+    amp_on      = 1;
+  }
+#endif
   
   /* Restore interrupt state before delay to avoid blocking IRQs unnecessarily */
   ATOMIC_EXIT();
   
+#if !AUDIO_ENGINE_ENABLE_DAC_SETTLE
   /* Wait 10mS to allow the MAX98357A to settle */
   HAL_Delay( 10 );
+#endif
+}
+
+
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+/** Reports whether the MAX98357A has settled since DAC_MasterSwitch() turned it on
+  *
+  * params: none
+  * retval: 1 once it has been on for AMP_SETTLE_MS, 0 otherwise
+  *
+  * NOTE: Called by the audio engine, also from the I2S DMA interrupt.  Whole ticks are
+  *       counted after the one it came on in, so the wait is never short.
+  */
+static uint8_t DAC_Settled( void )
+{
+  return ( amp_on && ( HAL_GetTick() - amp_on_tick ) > AMP_SETTLE_MS ) ? 1U : 0U;
 }
+#endif
+
+
+#ifndef VOLUME_INPUT_DIGITAL
+/** Starts the volume ADC into its circular DMA buffer, triggered by TIM7
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: No interrupts are taken; ReadVolume() averages the buffer.
+  */
+static void StartVolumeAdc( void )
+{
+  if( HAL_ADC_Start_DMA( &hadc1, (uint32_t *) adc_dma_buffer, VOLUME_ADC_DMA_SAMPLES ) != HAL_OK ) {
+    Error_Handler();
+  }
+  __HAL_DMA_DISABLE_IT( &hdma_adc1, DMA_IT_HT | DMA_IT_TC );
+  __HAL_ADC_DISABLE_IT( &hadc1, ADC_IT_OVR );
+  HAL_TIM_Base_Start( &htim7 );       // Start TIM7 for ADC triggering
+}
+#endif
+
+
+#if FAST_BOOT
+/** Waits for the supply the amplifier shares to come up, in place of the fixed boot delay.
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: The PVD compares VDD with FAST_BOOT_PVD_LEVEL; the supply counts as up once VDD has
+  *       stayed above it for FAST_BOOT_SUPPLY_STABLE_MS.  After FAST_BOOT_SUPPLY_TIMEOUT_MS
+  *       (the normal boot's delay) it goes on regardless.  On a supply that is already up
+  *       this takes FAST_BOOT_SUPPLY_STABLE_MS; DAC_MasterSwitch() still waits out the
+  *       amplifier's own turn-on time.
+  */
+static void WaitForSupplyReady( void )
+{
+  PWR_PVDTypeDef pvd    = { .PVDLevel = FAST_BOOT_PVD_LEVEL, .Mode = PWR_PVD_MODE_NORMAL };
+  const uint32_t start  = HAL_GetTick();
+  uint32_t       above  = start;
+
+  HAL_PWR_ConfigPVD( &pvd );
+  HAL_PWR_EnablePVD();
+  while( ( HAL_GetTick() - start ) < FAST_BOOT_SUPPLY_TIMEOUT_MS ) {
+    if( __HAL_PWR_GET_FLAG( PWR_FLAG_PVDO ) ) {
+      above = HAL_GetTick();                    // VDD below the level: start the count again
+    }
+    else if( ( HAL_GetTick() - above ) >= FAST_BOOT_SUPPLY_STABLE_MS ) {
+      break;
+    }
+  }
+  HAL_PWR_DisablePVD();
+}
+
+
+/** Runs the initialisation the first sound does not need, once.
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: Called when the first playback's DMA is running and before any wait for the trigger.
+  *       ReadVolume() returns FAST_BOOT_VOLUME until the volume DMA has filled its buffer.
+  */
+static void FastBoot_DeferredInit( void )
+{
+  if( deferred_init_done ) return;
+  deferred_init_done = 1;
+#ifndef VOLUME_INPUT_DIGITAL
+  MX_ADC1_Init();
+  MX_TIM7_Init();
+  StartVolumeAdc();
+#endif
+}
+#endif
 
 
 /** Read the master volume level for playback.
@@ -638,6 +1126,22 @@ uint16_t ReadVolume( void )
     uint32_t scaled = ( (uint32_t)v * 65535U ) / 7U;  // Map 0-7 to 0-65535
     volume = (uint16_t)scaled;
   #else
+    #if FAST_BOOT
+    // Until the deferred ADC has filled its buffer once there is no reading to average
+    if( !volume_adc_ready ) {
+      if( !deferred_init_done || !__HAL_DMA_GET_FLAG( &hdma_adc1, __HAL_DMA_GET_TC_FLAG_INDEX( &hdma_adc1 ) ) ) {
+        return FAST_BOOT_VOLUME;
+      }
+      volume_adc_ready = 1;
+    }
+    #endif
+    // Average the oversampled readings in the DMA buffer (12-bit, 0-4095)
+    uint32_t adc_sum = 0;
+    for( uint32_t i = 0; i < VOLUME_ADC_DMA_SAMPLES; i++ ) {
+      adc_sum += adc_dma_buffer[ i ];
+    }
+    const uint32_t adc_out = adc_sum / VOLUME_ADC_DMA_SAMPLES;
+
     // Use 12-bit ADC value (0-4095) for linear volume
     // Scale 12-bit ADC directly to match 16-bit volume range with 16x scaling factor
     // (4095 * 16 = 65520, close to full 65535 range)
@@ -657,24 +1161,72 @@ uint16_t ReadVolume( void )
   return volume;
 } 
 
-/* ADC Conversion Complete Callback */
-void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc )
+/** Plays the sound selected for the trigger: from the asset bank, by ID or the default.
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: After AudioEngine_PrimeNextPlayback() this primes the sound instead of starting it,
+  *       and after AudioEngine_CacheNextAttack() it caches the sound's attack.
+  *
+  */
+static void PlayTriggeredSound( void )
 {
-  /* Prevent unused argument(s) compilation warning */
-  UNUSED(hadc);
-  #define FILTER_SHIFT 4      // Smoothing factor (higher = smoother)
-
-  static uint16_t adc_filtered = 0;
-         uint16_t adc_raw;
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+  if( !bank_mounted || PlayBankSound() == PB_Error )
+#endif
+  {
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+    if( PlayAssetById( ReadSoundSelect() ) == PB_Error ) {
+      PlayAssetById( 0 );
+    }
+#else
+    // PlaySample( didgeridoo16b16k1c , DIDGERIDOO16B16K1C_SZ,
+    //   I2S_AUDIOFREQ_22K, 16, DIDGERIDOO16B16K1C_PB_FMT );
+    PlaySample( secret_door16b16k1c, SECRET_DOOR16B16K1C_SZ,
+      I2S_AUDIOFREQ_16K, 16, SECRET_DOOR16B16K1C_PB_FMT );
+#endif
+  }
+}
 
-  // Get the raw value
-  adc_raw = (uint16_t) HAL_ADC_GetValue( &hadc1 );
-  // Note: We perform the subtraction first to find the 'error'
-  adc_filtered = adc_filtered + ( adc_raw - ( adc_filtered >> FILTER_SHIFT ) );
 
-  // Your actual 12-bit volume result (0-4095)
-  adc_out = adc_filtered >> FILTER_SHIFT;
+#if SPECULATIVE_TRIGGER
+/** Primes the selected sound on an unconfirmed trigger edge, and drops it if the edge bounced
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: Runs in the SysTick filter's wait for the trigger.  The I2S initialisation, the
+  *       render of the first ring and the DAC's turn-on then overlap the TC_HIGH_THRESHOLD ms
+  *       the filter takes to confirm the edge, and the confirmed trigger only starts the DMA
+  *       (AudioEngine_StartPrimed()).  An edge whose input falls back until the filter is
+  *       empty was a bounce; dropping its prime is a state reset and the DAC switched off.
+  */
+static void SpeculateTrigger( void )
+{
+  if( trig_primed ) {
+    if( trig_counter == 0U ) {
+      (void)AudioEngine_CancelPrimed();           // The edge was not a trigger
+      trig_primed = 0;
+    }
+    return;
+  }
+  if( !trig_edge_pending ) {
+    return;
+  }
+  trig_edge_pending = 0;
+  if( trig_counter == 0U && !( TRIGGER_GPIO_Port->IDR & TRIGGER_Pin ) ) {
+    return;                                       // Gone before it could be primed
+  }
+#if STOP_MODE_IDLE
+  SystemClock_FinishRestore();                  // The I2S kernel clock must be the one it plays at
+#endif
+  if( AudioEngine_PrimeNextPlayback() == PB_Idle ) {
+    PlayTriggeredSound();
+    trig_primed = 1;
+  }
 }
+#endif
 
 
 /** Wait for the trigger signal
@@ -684,12 +1236,87 @@ void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc )
  * params: none
  * retval: none
  *
+ * NOTE: With LOW_LATENCY_TRIGGER the core sleeps on the full clock until the trigger EXTI
+ *       or SysTick changes the status, so a primed playback and the DAC stay ready; there
+ *       is no low power sleep and no clock restore on the way to the sound.  With
+ *       TRIGGER_EVENT_DEBOUNCE it waits in STOP1 mode with SysTick off, woken only by the
+ *       trigger edges and the debounce timer, and restores the clock once the status is in.
+ *       With STOP_MODE_IDLE the SysTick trigger filter sleeps in STOP1 instead of low power
+ *       sleep, and the PLL relocks in the background while the filter confirms the edge.
+ *       With FAST_BOOT it first runs the initialisation deferred at boot, if still pending,
+ *       and with AUDIO_ENGINE_ENABLE_IDLE_JOBS the engine's queued jobs.  With
+ *       SPECULATIVE_TRIGGER the SysTick filter's wait primes the sound on the first edge and
+ *       drops it again on a bounce, so the confirmed trigger only releases the output.
+ *
  */
 void WaitForTrigger( uint8_t trig_to_wait_for )
 {
+#if FAST_BOOT
+  FastBoot_DeferredInit();                      // The waits below stop and restart the volume ADC
+#endif
+#if AUDIO_ENGINE_ENABLE_IDLE_JOBS
+  while( AudioEngine_RunIdleJobs() != 0U ) {    // Finish the engine's deferred work before sleeping
+  }
+#endif
+#if LOW_LATENCY_TRIGGER
+  while( trig_status != trig_to_wait_for ) {
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+    AudioEngine_SetPowerState( ENERGY_STATE_SLEEP );
+    __WFI();
+    AudioEngine_SetPowerState( ENERGY_STATE_RUN );
+#else
+    __WFI();
+#endif
+  }
+#elif TRIGGER_EVENT_DEBOUNCE
+  if( trig_status == trig_to_wait_for ) return;
+#ifndef NO_SLEEP_MODE
+  /* Nothing needs a clock until an edge: stop in STOP1, the LSI keeps the debounce timer running */
+  AudioEngine_StopStream();                     // No-op unless AUDIO_ENGINE_ALWAYS_ON kept the I2S running
+#ifndef VOLUME_INPUT_DIGITAL
+  HAL_TIM_Base_Stop( &htim7 );                  // Stop TIM7 to prevent ADC triggers during STOP
+  HAL_ADC_Stop_IT( &hadc1 );
+#endif
+  HAL_SuspendTick();
+  while( trig_status != trig_to_wait_for ) {
+    __disable_irq();                            // A status change between the test and the WFI still wakes it
+    if( trig_status != trig_to_wait_for ) {
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+      AudioEngine_SetPowerState( ENERGY_STATE_STOP );  // The debounce handlers between run on HSI16, as counted
+#endif
+      HAL_PWREx_EnterSTOP1Mode( PWR_STOPENTRY_WFI );   // Woken by the trigger EXTI or LPTIM1
+    }
+    __enable_irq();
+  }
+  SystemClock_Config();                         // STOP wakes on HSI16
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+  AudioEngine_SetPowerState( ENERGY_STATE_RUN );
+#endif
+  HAL_ResumeTick();
+#ifndef VOLUME_INPUT_DIGITAL
+  HAL_ADC_Start_IT( &hadc1 );
+  HAL_TIM_Base_Start( &htim7 );
+#endif
+#else
+  while( trig_status != trig_to_wait_for ) {
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+    AudioEngine_SetPowerState( ENERGY_STATE_SLEEP );
+    __WFI();
+    AudioEngine_SetPowerState( ENERGY_STATE_RUN );
+#else
+    __WFI();
+#endif
+  }
+#endif
+#else
   while( 1 ) {
     trig_timeout_flag = 0;
     while( trig_status != trig_to_wait_for ) {
+#if SPECULATIVE_TRIGGER
+      if( trig_to_wait_for == TRIGGER_SET ) {
+        SpeculateTrigger();
+      }
+#endif
       HAL_Delay( 1 );
       trig_timeout_counter++;
       if( trig_timeout_counter >= TRIG_TIMEOUT_MS ) {
@@ -698,7 +1325,21 @@ void WaitForTrigger( uint8_t trig_to_wait_for )
         break;
       }
     }
-    if( trig_status == trig_to_wait_for ) return;
+    if( trig_status == trig_to_wait_for ) {
+#if STOP_MODE_IDLE
+      SystemClock_FinishRestore();
+#endif
+#if SPECULATIVE_TRIGGER
+      trig_primed = 0;                            // The main loop starts the primed sound
+#endif
+      return;
+    }
+#if SPECULATIVE_TRIGGER
+    if( trig_primed ) {
+      (void)AudioEngine_CancelPrimed();           // Neither confirmed nor cleared in TRIG_TIMEOUT_MS
+      trig_primed = 0;
+    }
+#endif
 
 #ifndef NO_SLEEP_MODE
   /* Prep for sleep mode */
@@ -706,7 +1347,11 @@ void WaitForTrigger( uint8_t trig_to_wait_for )
     HAL_TIM_Base_Stop( &htim7 );                // Stop TIM7 to prevent ADC triggers during sleep
     HAL_ADC_Stop_IT( &hadc1 );                  // Stop ADC in interrupt mode
 #endif
+#if STOP_MODE_IDLE
+    AudioEngine_StopStream();                   // No-op unless AUDIO_ENGINE_ALWAYS_ON kept the I2S running
+#else
     LPSystemClock_Config();                     // Reduce clock speed for low power sleep
+#endif
     HAL_SuspendTick();                          // Stop SysTick interrupts to prevent wakeups
     __HAL_GPIO_EXTI_CLEAR_IT( TRIGGER_Pin );    // Clear EXTI pending bit
 #ifndef VOLUME_INPUT_DIGITAL
@@ -717,16 +1362,34 @@ void WaitForTrigger( uint8_t trig_to_wait_for )
     __DSB();
     __ISB();
 
+#if STOP_MODE_IDLE
+    /* Enter STOP1 mode, with RAM and peripheral registers retained, and wait for the trigger */
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+    AudioEngine_SetPowerState( ENERGY_STATE_STOP );
+#endif
+    HAL_PWREx_EnterSTOP1Mode( PWR_STOPENTRY_WFI );
+#else
     /* Enter low power sleep mode and wait for the trigger */
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+    AudioEngine_SetPowerState( ENERGY_STATE_SLEEP );  // On the low power clock set above
+#endif
     HAL_PWR_EnterSLEEPMode( PWR_LOWPOWERREGULATOR_ON, PWR_SLEEPENTRY_WFI );
+#endif
 
     /* Rise from your slumber mighty microcontroller! */
     __HAL_GPIO_EXTI_CLEAR_IT( TRIGGER_Pin );    // Clear EXTI pending bit
 #ifndef VOLUME_INPUT_DIGITAL
     __HAL_TIM_CLEAR_IT( &htim7, TIM_IT_UPDATE );
 #endif
+#if STOP_MODE_IDLE
+    SystemClock_StartRestore();                 // The PLL relocks while the trigger filter runs on HSI16
+#else
     HAL_PWREx_DisableLowPowerRunMode();
     SystemClock_Config();
+#endif
+#if AUDIO_ENGINE_ENABLE_ENERGY_PROFILE
+    AudioEngine_SetPowerState( ENERGY_STATE_RUN );
+#endif
     HAL_ResumeTick();
 #ifndef VOLUME_INPUT_DIGITAL
     HAL_ADC_Start_IT( &hadc1 );                 // Restart ADC in interrupt mode
@@ -734,6 +1397,7 @@ void WaitForTrigger( uint8_t trig_to_wait_for )
 #endif  
 #endif
   }
+#endif
 }
 
 
@@ -753,6 +1417,44 @@ uint8_t GetTriggerOption( void )
 }
 
 
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+/** Returns the sound selected on the OPT1-OPT3 pads.
+  *
+  * params: none
+  * retval: asset ID 0-7, OPT1 being bit 0.  Open pads read 0.
+  *
+  */
+uint8_t ReadSoundSelect( void )
+{
+  return
+    ( ( (OPT3_GPIO_Port->IDR & OPT3_Pin) != 0 ) << 2 ) |
+    ( ( (OPT2_GPIO_Port->IDR & OPT2_Pin) != 0 ) << 1 ) |
+    ( ( (OPT1_GPIO_Port->IDR & OPT1_Pin) != 0 ) << 0 );
+}
+#endif
+
+
+#if AUDIO_ENGINE_ENABLE_ASSET_BANK
+/** Plays the selected sound from the asset bank.
+  *
+  * params: none
+  * retval: PB_Playing (PB_Primed when priming) if the bank has the sound on the OPT1-OPT3
+  *         pads (with the asset index) or ID 0, otherwise PB_Error.
+  *
+  */
+PB_StatusTypeDef PlayBankSound( void )
+{
+#if AUDIO_ENGINE_ENABLE_ASSET_INDEX
+  const PB_StatusTypeDef status = PlayBankAsset( ReadSoundSelect() );
+  if( status == PB_Playing || status == PB_Primed ) {
+    return status;
+  }
+#endif
+  return PlayBankAsset( 0 );
+}
+#endif
+
+
 /* Shuts down audio playback and DAC 
  * 
  * @params: none
@@ -770,6 +1472,10 @@ void HAL_IncTick( void )
 {
   uwTick += uwTickFreq;
 
+#if !TRIGGER_EVENT_DEBOUNCE
+#if LOW_LATENCY_TRIGGER
+  ATOMIC_ENTER();                                 // The trigger EXTI also loads the counter
+#endif
   if( TRIGGER_GPIO_Port->IDR & TRIGGER_Pin ) {    // Trigger is high, so increase counter.
     if( trig_counter < TC_MAX ) trig_counter++;
   }
@@ -780,8 +1486,155 @@ void HAL_IncTick( void )
   /* Handle trigger status with hysteresis */
   if( trig_counter < TC_LOW_THRESHOLD )   trig_status = TRIGGER_CLR;
   if( trig_counter > TC_HIGH_THRESHOLD )  trig_status = TRIGGER_SET;
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+  if( amp_early ) {
+    if( trig_status == TRIGGER_SET ) {
+      amp_early = 0;                              // The playback takes the amplifier over
+    }
+    else if( trig_counter == 0U ) {
+      DAC_MasterSwitch( DAC_OFF );                // The edge was not a trigger
+    }
+  }
+#endif
+#if LOW_LATENCY_TRIGGER
+  ATOMIC_EXIT();
+#endif
+#endif
+}
+
+
+#if LOW_LATENCY_TRIGGER || TRIGGER_EVENT_DEBOUNCE || AUDIO_ENGINE_ENABLE_LATENCY_PROBE || SPECULATIVE_TRIGGER || MULTI_TRIGGER
+/** Trigger pin edge interrupt
+  *
+  * params: GPIO_Pin - Pin whose EXTI line fired
+  * retval: none
+  *
+  * NOTE: A rising edge while the trigger is clear marks the latency probe.  With
+  *       LOW_LATENCY_TRIGGER an edge that stays high for TRIG_CONFIRM_US sets the trigger at
+  *       once instead of after the SysTick filter's TC_HIGH_THRESHOLD ms.  The counter is
+  *       loaded to TC_MAX, so the filter keeps the trigger set through bounces and clears it
+  *       once the input has been low for TC_MAX - TC_LOW_THRESHOLD ms.  With
+  *       TRIGGER_EVENT_DEBOUNCE every edge restarts the debounce timer, and with
+  *       SPECULATIVE_TRIGGER the edge has WaitForTrigger() prime the sound.  With
+  *       MULTI_TRIGGER every input's edges go to its TIM3 debounce instead.
+  */
+void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin )
+{
+#if MULTI_TRIGGER
+  MultiTrigger_Edge( GPIO_Pin );
+  return;
+#endif
+  if( GPIO_Pin != TRIGGER_Pin ) {
+    return;
+  }
+#if AUDIO_ENGINE_ENABLE_EVENT_TRACE
+  AudioEngine_Trace( AUDIO_TRACE_TRIGGER, ( TRIGGER_GPIO_Port->IDR & TRIGGER_Pin ) ? 1U : 0U, 0U );   // Every edge, bounces too
+#endif
+#if TRIGGER_EVENT_DEBOUNCE
+  TriggerDebounceRestart();                       // Taken once the input holds still
+#endif
+  if( trig_status == TRIGGER_SET || !( TRIGGER_GPIO_Port->IDR & TRIGGER_Pin ) ) {
+    return;                                       // Falling edge, or a bounce of a trigger already taken
+  }
+#if AUDIO_ENGINE_ENABLE_LATENCY_PROBE
+  AudioEngine_MarkTrigger();
+#endif
+#if SPECULATIVE_TRIGGER
+  trig_edge_pending = 1;                          // Primed by the wait while the filter confirms it
+#endif
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE && !LOW_LATENCY_TRIGGER
+  if( GetDAC_Control() && !amp_on ) {
+    DAC_MasterSwitch( DAC_ON );                   // Settles while the filter confirms the edge
+    amp_early = 1;
+  }
+#endif
+#if LOW_LATENCY_TRIGGER
+  const uint32_t start   = DWT->CYCCNT;
+  const uint32_t confirm = ( SystemCoreClock / 1000000U ) * TRIG_CONFIRM_US;
+  while( ( DWT->CYCCNT - start ) < confirm ) {
+    if( !( TRIGGER_GPIO_Port->IDR & TRIGGER_Pin ) ) {
+      return;                                     // A glitch; the SysTick filter still sees a real trigger
+    }
+  }
+  trig_counter = TC_MAX;
+  trig_status  = TRIGGER_SET;
+#endif
+}
+#endif
+
+
+#if TRIGGER_EVENT_DEBOUNCE
+/** Sets up LPTIM1 as the one-shot trigger debounce timer
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: Clocked from the LSI, so it counts in STOP mode, and wakes the core through EXTI
+  *       line 29.  The interrupt enable is written with the timer disabled and the reload
+  *       with it enabled, as LPTIM requires.  The input level at boot is debounced too.
+  */
+static void TriggerDebounce_Init( void )
+{
+  LL_RCC_LSI_Enable();
+  while( !LL_RCC_LSI_IsReady() ) {
+  }
+  LL_RCC_SetLPTIMClockSource( LL_RCC_LPTIM1_CLKSOURCE_LSI );
+  LL_APB1_GRP1_EnableClock( LL_APB1_GRP1_PERIPH_LPTIM1 );
+
+  LL_LPTIM_SetPrescaler( LPTIM1, LL_LPTIM_PRESCALER_DIV1 );
+  LL_LPTIM_EnableIT_ARRM( LPTIM1 );
+  LL_LPTIM_Enable( LPTIM1 );
+  LL_LPTIM_SetAutoReload( LPTIM1, TRIG_DEBOUNCE_TICKS );
+  while( !LL_LPTIM_IsActiveFlag_ARROK( LPTIM1 ) ) {
+  }
+  LL_LPTIM_ClearFlag_ARROK( LPTIM1 );
+
+  LL_EXTI_EnableIT_0_31( LL_EXTI_LINE_29 );
+  HAL_NVIC_SetPriority( LPTIM1_IRQn, 0, 0 );
+  HAL_NVIC_EnableIRQ( LPTIM1_IRQn );
+
+  TriggerDebounceRestart();
 }
 
+
+/** Restarts the debounce timer from zero, from an edge of the trigger input
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: Resets a count in progress and starts a new one-shot count, so the timer only
+  *       expires once TRIG_DEBOUNCE_MS has passed without an edge.
+  */
+static void TriggerDebounceRestart( void )
+{
+  LL_LPTIM_ResetCounter( LPTIM1 );
+  LL_LPTIM_StartCounter( LPTIM1, LL_LPTIM_OPERATING_MODE_ONESHOT );
+}
+
+
+/** Takes the trigger level once the input has held still for TRIG_DEBOUNCE_MS
+  *
+  * params: none
+  * retval: none
+  *
+  * NOTE: Called from LPTIM1_IRQHandler().
+  */
+void TriggerDebounceElapsed( void )
+{
+  trig_status = ( TRIGGER_GPIO_Port->IDR & TRIGGER_Pin ) ? TRIGGER_SET : TRIGGER_CLR;
+#if AUDIO_ENGINE_ENABLE_DAC_SETTLE
+  if( amp_early ) {
+    if( trig_status == TRIGGER_SET ) {
+      amp_early = 0;                              // The playback takes the amplifier over
+    }
+    else {
+      DAC_MasterSwitch( DAC_OFF );                // The edge was not a trigger
+    }
+  }
+#endif
+}
+#endif
+
 /* USER CODE END 4 */
 
 /**
@@ -24,6 +24,15 @@
 #include "stm32g4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#if TRIGGER_EVENT_DEBOUNCE
+#include "stm32g4xx_ll_lptim.h"
+#endif
+#if AUDIO_ENGINE_ENABLE_RTOS
+#include "audio_rtos.h"
+#endif
+#if MULTI_TRIGGER
+#include "multi_trigger.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -141,6 +150,7 @@ void UsageFault_Handler(void)
   }
 }
 
+#if !AUDIO_ENGINE_ENABLE_RTOS                 // The kernel's port supplies SVC and PendSV
 /**
   * @brief This function handles System service call via SWI instruction.
   */
@@ -153,6 +163,7 @@ void SVC_Handler(void)
 
   /* USER CODE END SVCall_IRQn 1 */
 }
+#endif
 
 /**
   * @brief This function handles Debug monitor.
@@ -167,18 +178,22 @@ void DebugMon_Handler(void)
   /* USER CODE END DebugMonitor_IRQn 1 */
 }
 
+#if !AUDIO_ENGINE_ENABLE_RTOS
 /**
   * @brief This function handles Pendable request for system service.
   */
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+#if AUDIO_ENGINE_DEFERRED_RENDER
+  AudioEngine_RenderTask();
+#endif
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
 
   /* USER CODE END PendSV_IRQn 1 */
 }
+#endif
 
 /**
   * @brief This function handles System tick timer.
@@ -190,6 +205,9 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+#if AUDIO_ENGINE_ENABLE_RTOS
+  AudioRtos_SysTick();
+#endif
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -207,6 +225,10 @@ void SysTick_Handler(void)
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
+#if AUDIO_ENGINE_ENABLE_LL_DMA_IRQ
+  AudioEngine_DmaIrqHandler();                              // Flags handled at register level
+  return;
+#endif
 
   /* USER CODE END DMA1_Channel1_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi2_tx);
@@ -222,6 +244,9 @@ void DMA1_Channel1_IRQHandler(void)
 void ADC1_2_IRQHandler(void)
 {
   /* USER CODE BEGIN ADC1_2_IRQn 0 */
+#if AUDIO_ENGINE_ENABLE_STACK_MONITOR
+  AudioEngine_SampleIsrNesting();
+#endif
 
   /* USER CODE END ADC1_2_IRQn 0 */
   HAL_ADC_IRQHandler(&hadc1);
@@ -235,7 +260,58 @@ void ADC1_2_IRQHandler(void)
 
 void EXTI4_IRQHandler(void)
 {
+#if AUDIO_ENGINE_ENABLE_STACK_MONITOR
+  AudioEngine_SampleIsrNesting();
+#endif
   HAL_GPIO_EXTI_IRQHandler( TRIGGER_Pin );
 }
 
+#if MULTI_TRIGGER
+/**
+  * @brief This function handles the EXTI lines 9 to 5 interrupt: edges of the OPT1 and OPT2
+  *        trigger inputs.
+  */
+void EXTI9_5_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler( OPT1_Pin );
+  HAL_GPIO_EXTI_IRQHandler( OPT2_Pin );
+}
+
+/**
+  * @brief This function handles the TIM3 interrupt: a trigger input's debounce time has run out.
+  */
+void TIM3_IRQHandler(void)
+{
+  MultiTrigger_TimerIrq();
+}
+#endif
+
+#if TRIGGER_EVENT_DEBOUNCE
+/**
+  * @brief This function handles the LPTIM1 interrupt: the trigger input has held still for
+  *        TRIG_DEBOUNCE_MS.
+  */
+void LPTIM1_IRQHandler(void)
+{
+  if( LL_LPTIM_IsActiveFlag_ARRM( LPTIM1 ) ) {
+    LL_LPTIM_ClearFlag_ARRM( LPTIM1 );
+    TriggerDebounceElapsed();
+  }
+}
+#endif
+
+#if STOP_MODE_IDLE
+/**
+  * @brief This function handles the RCC interrupt: the PLL has relocked after a wake from
+  *        STOP mode.
+  */
+void RCC_IRQHandler(void)
+{
+  if( __HAL_RCC_GET_IT( RCC_IT_PLLRDY ) ) {
+    __HAL_RCC_CLEAR_IT( RCC_IT_PLLRDY );
+    SystemClock_PllReady();
+  }
+}
+#endif
+
 /* USER CODE END 1 */
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""
+Event Trace Decoder for Audio Engine
+Prints the engine's post-mortem event trace (AUDIO_ENGINE_ENABLE_EVENT_TRACE) oldest first,
+with the time of each event from the one before.
+
+Read the ring from a halted or reset unit over SWD, for example with GDB:
+    dump binary value trace.bin audio_engine_trace
+
+or send the records AudioEngine_CopyTrace() returns over a UART as they are in memory, then:
+    python3 decode_trace.py trace.bin
+    python3 decode_trace.py uart.bin --records --core-clock 170000000
+
+The ring is a magic word, the number of events recorded and AUDIO_ENGINE_EVENT_TRACE_LEN slots
+of three words: the CYCCNT timestamp, a value word, and the low 16 bits of the event's number,
+its type and a small argument.  A slot whose number is not the one expected there was being
+written when the ring was read, or is left from before power-up, and is skipped.
+"""
+
+import argparse
+import struct
+from pathlib import Path
+
+MAGIC = 0x54524345
+RECORD = struct.Struct("<IIHBB")
+PB_STATES = {0: "idle", 1: "error", 2: "playing", 3: "pausing", 4: "paused", 5: "playing-failed", 6: "primed"}
+COMMANDS = {0: "play", 1: "stop", 2: "halt", 3: "pause", 4: "resume", 5: "set-param", 6: "seek", 7: "crossfade"}
+SOURCES = {0: "stream", 1: "push"}
+
+
+def describe(kind, arg, value):
+    """Event name and text for its arguments."""
+    if kind == 1:
+        return "init", f"{value} events before"
+    if kind == 2:
+        return "state", PB_STATES.get(arg, str(arg))
+    if kind in (3, 4):
+        return ("command" if kind == 3 else "command-dropped"), f"{COMMANDS.get(arg, arg)} value {value}"
+    if kind == 5:
+        return "underrun", f"period {arg}, {value} frames late"
+    if kind == 6:
+        return "source-underrun", f"{SOURCES.get(arg, arg)}, {value} so far"
+    if kind == 7:
+        return "config", f"set {arg}, generation {value}"
+    if kind == 8:
+        return "trigger", "rising" if arg else "falling"
+    if kind >= 0x80:
+        return f"user-{kind - 0x80}", f"arg {arg} value {value} (0x{value:08X})"
+    return f"type-{kind}", f"arg {arg} value {value}"
+
+
+def ring_records(data):
+    """Records of a dumped ring in the order they were recorded, skipping unfinished slots."""
+    magic, head = struct.unpack_from("<II", data)
+    if magic != MAGIC:
+        raise SystemExit(f"no trace ring: magic 0x{magic:08X}")
+    slots = (len(data) - 8) // RECORD.size
+    records = [RECORD.unpack_from(data, 8 + i * RECORD.size) for i in range(slots)]
+    out = []
+    for index in range(max(0, head - slots), head):
+        record = records[index % slots]
+        if record[2] == index & 0xFFFF:
+            out.append(record)
+    return out, head
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", type=Path, help="binary dump of audio_engine_trace, or of records with --records")
+    parser.add_argument("--records", action="store_true", help="the dump holds AudioEngine_CopyTrace() records")
+    parser.add_argument("--core-clock", type=int, default=170000000, help="core clock in Hz (default: 170000000)")
+    args = parser.parse_args()
+
+    data = args.dump.read_bytes()
+    if args.records:
+        records = [RECORD.unpack_from(data, i) for i in range(0, len(data) - RECORD.size + 1, RECORD.size)]
+        print(f"{len(records)} events")
+    else:
+        records, head = ring_records(data)
+        print(f"{len(records)} events of {head} recorded")
+
+    previous = None
+    for cycles, value, seq, kind, arg in records:
+        delta = "" if previous is None else f"+{((cycles - previous) & 0xFFFFFFFF) * 1e6 / args.core_clock:.1f} us"
+        name, text = describe(kind, arg, value)
+        print(f"{seq:5d} {delta:>14} {name:<16} {text}")
+        previous = cycles
+
+
+if __name__ == "__main__":
+    main()
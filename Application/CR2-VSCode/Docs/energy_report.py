@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Energy Profile Report for Audio Engine
+Tabulates the run, sleep and STOP time printed by AudioEngine_DumpEnergyStats()
+(AUDIO_ENGINE_ENABLE_ENERGY_PROFILE) per engine phase, and with the current of each power state
+the charge and energy a playback takes.
+
+Build with AUDIO_ENGINE_ENERGY_PROFILE=ON, play sounds with the SWO viewer logging to a file,
+then:
+    python3 energy_report.py swo.log
+    python3 energy_report.py swo.log --run-ma 28 --sleep-ma 9 --stop-ua 110 --volts 3.0
+
+The log may hold several reports; the last complete one is used unless --all averages the
+playback reports.  The profile keeps the core clock running in sleep and STOP, so the times are
+the field's but the current measured with it built in is not: take each state's current from a
+measurement of a build without it, or from the datasheet for the clock and peripherals in use.
+No currents are assumed; without them only the times are printed.
+"""
+
+import argparse
+import sys
+from pathlib import Path
+
+STATES = ("run", "sleep", "stop")
+
+
+def parse_reports(text):
+    """Complete reports in the log, each as (kind, {counts}, {phase: [run, sleep, stop] us})."""
+    reports = []
+    current = None
+    for line in text.splitlines():
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "NRG" and len(fields) == 2 and fields[1] == "END":
+            if current:
+                reports.append(current)
+            current = None
+        elif fields[0] == "NRG" and len(fields) == 6:
+            try:
+                counts = dict(zip(("playbacks", "renders", "sleeps", "stops"), map(int, fields[2:])))
+            except ValueError:
+                current = None
+                continue
+            current = (fields[1], counts, {})
+        elif fields[0] == "NRP" and current and len(fields) == 5:
+            try:
+                current[2][fields[1]] = [int(f) for f in fields[2:]]
+            except ValueError:
+                current = None                          # Garbled line: drop the report
+    return reports
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", type=Path, help="SWO viewer or terminal log with AudioEngine_DumpEnergyStats() reports")
+    parser.add_argument("--all", action="store_true", help="average every playback report in the log")
+    parser.add_argument("--run-ma", type=float, help="supply current running, in mA")
+    parser.add_argument("--sleep-ma", type=float, help="supply current in sleep, in mA")
+    parser.add_argument("--stop-ua", type=float, help="supply current in STOP, in uA")
+    parser.add_argument("--volts", type=float, help="supply voltage, for the energy")
+    args = parser.parse_args()
+
+    reports = parse_reports(args.log.read_text(errors="replace"))
+    if not reports:
+        sys.exit("No complete NRG report in the log")
+    if args.all:
+        reports = [r for r in reports if r[0] == "playback"]
+        if not reports:
+            sys.exit("No playback report in the log")
+    else:
+        reports = reports[-1:]
+
+    n = len(reports)
+    phases = {}
+    counts = {}
+    for _, report_counts, report_phases in reports:
+        for name, times in report_phases.items():
+            total = phases.setdefault(name, [0.0] * len(STATES))
+            for i, t in enumerate(times):
+                total[i] += t / n
+        for name, value in report_counts.items():
+            counts[name] = counts.get(name, 0) + value / n
+
+    total_us = sum(sum(times) for times in phases.values())
+    kind = f"mean of {n} playbacks" if args.all else reports[-1][0]
+    print(f"{kind}: {total_us / 1000:.3f} ms, {counts['renders']:.0f} renders, "
+          f"{counts['sleeps']:.0f} sleeps, {counts['stops']:.0f} stops")
+    print(f"{'phase':<14}" + "".join(f"{s + ' ms':>12}" for s in STATES) + f"{'%':>8}")
+    for name, times in phases.items():
+        share = 100.0 * sum(times) / max(1.0, total_us)
+        print(f"{name:<14}" + "".join(f"{t / 1000:12.3f}" for t in times) + f"{share:8.2f}")
+    state_us = [sum(times[i] for times in phases.values()) for i in range(len(STATES))]
+    print(f"{'all':<14}" + "".join(f"{t / 1000:12.3f}" for t in state_us) + f"{100.0:8.2f}")
+
+    if None in (args.run_ma, args.sleep_ma, args.stop_ua):
+        return
+    amps = (args.run_ma / 1000, args.sleep_ma / 1000, args.stop_ua / 1e6)
+    charge = [t / 1e6 * a for t, a in zip(state_us, amps)]
+    print(f"\ncharge: {sum(charge) * 1000:.4f} mAs ({sum(charge) * 1e6 / 3600:.4f} uAh), "
+          + ", ".join(f"{s} {100 * c / max(1e-12, sum(charge)):.1f}%" for s, c in zip(STATES, charge)))
+    if args.volts:
+        print(f"energy: {sum(charge) * args.volts * 1000:.4f} mJ at {args.volts} V")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+ITM Telemetry Decoder for Audio Engine
+Decodes a raw SWO capture of the engine's ITM telemetry (AUDIO_ENGINE_ENABLE_ITM_TELEMETRY)
+and plots the render statistics and the audio tap.
+
+Capture the SWO stream to a file with the debugger, for example with OpenOCD:
+    tpiu config internal swo.bin uart off 170000000 2000000
+    itm ports on
+
+Then:
+    python3 itm_telemetry.py swo.bin --rate 22050 --decimation 1
+    python3 itm_telemetry.py swo.bin --csv stats.csv --wav tap.wav
+
+Statistics frames (port 1, six words): "ST" tag and sequence number, longest render pass
+and average render cycles per period, periods covered with the player state and active voice
+count, underruns so far, and the output peak with the quality governor's steps in effect
+(QUALITY_STEP_* bits) above it.  Tap blocks (port 2): "AT" tag and sample count,
+then the samples two to a word.  Ports match AUDIO_ENGINE_ITM_STATS_PORT and _TAP_PORT.
+"""
+
+import argparse
+import csv
+import struct
+import wave
+from pathlib import Path
+
+STATS_TAG = 0x5354
+TAP_TAG = 0x4154
+STATS_WORDS = 6
+PB_STATES = {0: "idle", 1: "error", 2: "playing", 3: "pausing", 4: "paused", 5: "playing-failed"}
+
+
+def itm_words(data):
+    """Yield (port, word) for every 32-bit software source packet in a raw ITM stream."""
+    i = 0
+    while i < len(data):
+        header = data[i]
+        if header == 0x00 or header == 0x80:              # Synchronisation
+            i += 1
+        elif header & 0x03 and not header & 0x04:         # Software source packet
+            size = {1: 1, 2: 2, 3: 4}[header & 0x03]
+            if i + 1 + size > len(data):
+                break
+            if size == 4:
+                yield header >> 3, struct.unpack_from("<I", data, i + 1)[0]
+            i += 1 + size
+        elif header & 0x03:                               # Hardware source packet: skip
+            i += 1 + {1: 1, 2: 2, 3: 4}[header & 0x03]
+        elif header & 0x0F == 0x00:                       # Local timestamp: continuation bytes follow
+            i += 1
+            if header & 0x80:
+                while i < len(data) and data[i] & 0x80:
+                    i += 1
+                i += 1
+        else:                                             # Overflow and anything else
+            i += 1
+
+
+def decode(words, stats_port, tap_port):
+    """Split the stream into statistics frames and tap samples, resynchronising on tags."""
+    stats, tap = [], []
+    frame = []
+    pending = 0
+    for port, word in words:
+        if port == stats_port:
+            if word >> 16 == STATS_TAG:
+                frame = [word]
+            elif frame:
+                frame.append(word)
+            if len(frame) == STATS_WORDS:
+                seq = frame[0] & 0xFFFF
+                stats.append({
+                    "seq": seq,
+                    "max_cycles": frame[1],
+                    "avg_cycles": frame[2],
+                    "periods": frame[3] >> 16,
+                    "state": PB_STATES.get((frame[3] >> 8) & 0xFF, "?"),
+                    "voices": frame[3] & 0xFF,
+                    "underruns": frame[4],
+                    "peak": frame[5] & 0xFFFF,
+                    "quality": (frame[5] >> 16) & 0xFF,
+                })
+                frame = []
+        elif port == tap_port:
+            if word >> 16 == TAP_TAG and pending == 0:
+                pending = word & 0xFFFF
+            elif pending:
+                for sample in (word & 0xFFFF, word >> 16)[:min(2, pending)]:
+                    tap.append(sample - 0x10000 if sample & 0x8000 else sample)
+                pending = max(0, pending - 2)
+    return stats, tap
+
+
+def write_csv(path, stats):
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(stats[0].keys()))
+        writer.writeheader()
+        writer.writerows(stats)
+
+
+def write_wav(path, tap, rate):
+    with wave.open(str(path), "wb") as wav:
+        wav.setnchannels(1)
+        wav.setsampwidth(2)
+        wav.setframerate(rate)
+        wav.writeframes(struct.pack(f"<{len(tap)}h", *tap))
+
+
+def plot(stats, tap, tap_rate, core_clock, period_frames, rate):
+    import numpy as np
+    import matplotlib.pyplot as plt
+
+    fig, axes = plt.subplots(3, 1, figsize=(12, 10))
+    fig.suptitle("Audio Engine ITM Telemetry", fontsize=14, fontweight="bold")
+
+    if stats:
+        seq = np.arange(len(stats))
+        max_cycles = np.array([s["max_cycles"] for s in stats])
+        avg_cycles = np.array([s["avg_cycles"] for s in stats])
+        ax = axes[0]
+        ax.plot(seq, max_cycles, label="Longest render pass")
+        ax.plot(seq, avg_cycles, label="Average per period")
+        if core_clock and rate:
+            ax.axhline(core_clock * period_frames / rate, color="r", linestyle="--", label="One period")
+        ax.set_ylabel("Cycles")
+        ax.set_title("Render load")
+        ax.legend()
+        ax.grid(True, alpha=0.3)
+
+        ax = axes[1]
+        ax.plot(seq, [s["peak"] for s in stats], label="Output peak")
+        ax.set_ylabel("Peak (16-bit)")
+        ax2 = ax.twinx()
+        ax2.step(seq, [s["underruns"] for s in stats], color="r", where="post", label="Underruns")
+        ax2.step(seq, [s["voices"] for s in stats], color="g", where="post", label="Voices")
+        ax2.step(seq, [bin(s["quality"]).count("1") for s in stats], color="m", where="post",
+                 label="Quality steps")
+        ax2.set_ylabel("Count")
+        ax.set_xlabel("Statistics frame")
+        ax.set_title("Level, underruns, voices and quality steps")
+        ax.grid(True, alpha=0.3)
+
+    ax = axes[2]
+    if tap:
+        samples = np.array(tap, dtype=float) / 32768.0
+        n = min(len(samples), 1 << 16)
+        window = np.hanning(n)
+        spectrum = np.abs(np.fft.rfft(samples[-n:] * window)) / (window.sum() / 2)
+        freqs = np.fft.rfftfreq(n, 1.0 / tap_rate)
+        ax.semilogx(freqs[1:], 20 * np.log10(spectrum[1:] + 1e-9))
+        ax.set_xlabel("Frequency (Hz)")
+        ax.set_ylabel("Magnitude (dBFS)")
+        ax.set_title(f"Audio tap spectrum ({len(tap)} samples at {tap_rate:.0f} Hz)")
+        ax.grid(True, alpha=0.3, which="both")
+    else:
+        ax.set_title("No audio tap in the capture")
+
+    plt.tight_layout()
+    plt.show()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", type=Path, help="raw SWO capture (ITM packets)")
+    parser.add_argument("--stats-port", type=int, default=1, help="AUDIO_ENGINE_ITM_STATS_PORT (default: 1)")
+    parser.add_argument("--tap-port", type=int, default=2, help="AUDIO_ENGINE_ITM_TAP_PORT (default: 2)")
+    parser.add_argument("--rate", type=int, default=22050, help="playback rate in Hz (default: 22050)")
+    parser.add_argument("--decimation", type=int, default=1, help="decimation passed to AudioEngine_SetTelemetryTap()")
+    parser.add_argument("--core-clock", type=int, default=170000000, help="core clock in Hz, for the period line")
+    parser.add_argument("--period-frames", type=int, default=512, help="frames per ring period, for the period line")
+    parser.add_argument("--csv", type=Path, help="write the statistics frames to a CSV file")
+    parser.add_argument("--wav", type=Path, help="write the audio tap to a WAV file")
+    parser.add_argument("--no-plot", action="store_true", help="decode only")
+    args = parser.parse_args()
+
+    stats, tap = decode(itm_words(args.capture.read_bytes()), args.stats_port, args.tap_port)
+    tap_rate = args.rate / max(1, args.decimation)
+    print(f"{len(stats)} statistics frames, {len(tap)} tap samples")
+    if stats:
+        gaps = sum(1 for a, b in zip(stats, stats[1:]) if (b["seq"] - a["seq"]) & 0xFFFF != 1)
+        print(f"longest render pass {max(s['max_cycles'] for s in stats)} cycles, "
+              f"{stats[-1]['underruns']} underruns, {gaps} frames missing")
+
+    if args.csv and stats:
+        write_csv(args.csv, stats)
+    if args.wav and tap:
+        write_wav(args.wav, tap, int(tap_rate))
+    if not args.no_plot:
+        plot(stats, tap, tap_rate, args.core_clock, args.period_frames, args.rate)
+
+
+if __name__ == "__main__":
+    main()
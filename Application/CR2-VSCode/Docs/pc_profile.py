@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+PC Sampling Profile Report for Audio Engine
+Maps the histogram printed by PcSampler_Dump() (Core/Libraries/pc_sampler.c) onto the
+firmware's functions, to show where the cycles of a playback went.
+
+Build with AUDIO_ENGINE_PC_SAMPLER=ON, play a sound with the SWO viewer logging to a file,
+then:
+    python3 pc_profile.py swo.log build/Debug/CR2-VSCode.elf
+    python3 pc_profile.py swo.log build/Debug/CR2-VSCode.elf --top 20 --lines
+
+The log may hold several reports; the last complete one is used unless --all sums them.
+Each bin is charged to the function containing its start address, so a bin that straddles
+two small functions is charged to the first; --lines lists the hottest bins by source line.
+"""
+
+import argparse
+import bisect
+import subprocess
+import sys
+from pathlib import Path
+
+
+def parse_reports(text):
+    """Complete reports in the log, each as (samples, outside, tick_hz, {address: count})."""
+    reports = []
+    current = None
+    for line in text.splitlines():
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "PCS" and len(fields) == 2 and fields[1] == "END":
+            if current:
+                reports.append(current)
+            current = None
+        elif fields[0] == "PCS" and len(fields) == 4:
+            current = (int(fields[1]), int(fields[2]), int(fields[3]), {})
+        elif fields[0] == "PCR":
+            continue
+        elif current and len(fields) == 2:
+            try:
+                current[3][int(fields[0], 16)] = current[3].get(int(fields[0], 16), 0) + int(fields[1])
+            except ValueError:
+                current = None                          # Garbled line: drop the report
+    return reports
+
+
+def load_functions(elf, nm):
+    """Sorted (address, size, name) of the function symbols in the ELF."""
+    out = subprocess.run([nm, "-n", "-S", "--defined-only", str(elf)],
+                         capture_output=True, text=True, check=True).stdout
+    functions = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[2] in "tTwW":
+            functions.append((int(fields[0], 16) & ~1, int(fields[1], 16), fields[3]))
+    return functions
+
+
+def function_at(functions, starts, address):
+    i = bisect.bisect_right(starts, address) - 1
+    if i >= 0:
+        start, size, name = functions[i]
+        if address < start + max(size, 2):
+            return name
+    return f"?{address:08x}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", type=Path, help="SWO viewer or terminal log with the PcSampler_Dump() report")
+    parser.add_argument("elf", type=Path, help="firmware ELF the report was taken from")
+    parser.add_argument("--all", action="store_true", help="sum every report in the log")
+    parser.add_argument("--top", type=int, default=30, help="functions to list (default: 30)")
+    parser.add_argument("--lines", action="store_true", help="also list the hottest bins by source line")
+    parser.add_argument("--nm", default="arm-none-eabi-nm", help="nm of the toolchain")
+    parser.add_argument("--addr2line", default="arm-none-eabi-addr2line", help="addr2line of the toolchain")
+    args = parser.parse_args()
+
+    reports = parse_reports(args.log.read_text(errors="replace"))
+    if not reports:
+        sys.exit("No complete PCS report in the log")
+    if not args.all:
+        reports = reports[-1:]
+
+    samples = sum(r[0] for r in reports)
+    outside = sum(r[1] for r in reports)
+    tick_hz = reports[-1][2]
+    bins = {}
+    for report in reports:
+        for address, count in report[3].items():
+            bins[address] = bins.get(address, 0) + count
+
+    functions = load_functions(args.elf, args.nm)
+    starts = [f[0] for f in functions]
+    per_function = {}
+    for address, count in bins.items():
+        name = function_at(functions, starts, address)
+        per_function[name] = per_function.get(name, 0) + count
+
+    binned = sum(bins.values())
+    print(f"{samples} samples ({samples / tick_hz:.1f} s at {tick_hz} Hz), "
+          f"{outside} outside the code regions, {samples - outside - binned} lost to saturated bins")
+    print(f"{'samples':>8} {'%':>6}  function")
+    for name, count in sorted(per_function.items(), key=lambda kv: -kv[1])[:args.top]:
+        print(f"{count:8d} {100.0 * count / max(1, samples):6.2f}  {name}")
+
+    if args.lines:
+        hottest = sorted(bins.items(), key=lambda kv: -kv[1])[:args.top]
+        out = subprocess.run([args.addr2line, "-f", "-s", "-e", str(args.elf)] + [f"{a:x}" for a, _ in hottest],
+                             capture_output=True, text=True, check=True).stdout.splitlines()
+        print(f"\n{'samples':>8} {'address':>10}  line")
+        for (address, count), name, line in zip(hottest, out[0::2], out[1::2]):
+            print(f"{count:8d} {address:10x}  {line} ({name})")
+
+
+if __name__ == "__main__":
+    main()
@@ -2,8 +2,17 @@
 """
 Filter Characteristics Visualization for Audio Engine
 Generates frequency response and transfer function plots for the DSP filters.
+
+The curves are floating-point models of the filters.  With AUDIO_ENGINE_HOST_LIB set to a
+libaudio_engine_host built from Host/CMakeLists.txt, the 16-bit LPF and the combined chain are
+also measured on the engine's own fixed-point code (Host/audio_engine_host.py) and drawn over
+the models as dotted lines:
+
+    AUDIO_ENGINE_HOST_LIB=build/host/libaudio_engine_host.so Docs/visualize_filters.py
 """
 
+import os
+import sys
 from pathlib import Path
 
 import numpy as np
@@ -35,6 +44,18 @@ LPF_AGGRESSIVE = 40960 / 65536  # 0.625
 # Sampling frequency
 FS = 22000  # Hz (default playback speed)
 
+# The host-built engine, when available, for measured responses
+ENGINE = None
+if os.environ.get("AUDIO_ENGINE_HOST_LIB"):
+    sys.path.insert(0, str(BASE_DIR.parent / "Host"))
+    from audio_engine_host import Engine
+    ENGINE = Engine(os.environ["AUDIO_ENGINE_HOST_LIB"])
+
+
+def measured_response(lpf):
+    """Frequency response of the 16-bit chain measured on the host-built engine at FS."""
+    return ENGINE.frequency_response(FS, lpf=lpf)
+
 def dc_blocking_filter_response(alpha, fs=FS):
     """
     Calculate frequency response of DC blocking filter (high-pass).
@@ -161,6 +182,11 @@ ax2.semilogx(freq_s, mag_s, 'b-', linewidth=2, label=f'Soft (α={LPF_16BIT_SOFT:
 ax2.semilogx(freq_m, mag_m, 'orange', linewidth=2, label=f'Medium (α={LPF_16BIT_MEDIUM:.4f})')
 ax2.semilogx(freq_f, mag_f, 'y-', linewidth=2, label=f'Firm (α={LPF_16BIT_FIRM:.4f})')
 ax2.semilogx(freq_a, mag_a, 'r-', linewidth=2, label=f'Aggressive (α={LPF_16BIT_AGGRESSIVE:.4f})')
+if ENGINE is not None:
+    for level, color in (('very-soft', 'c'), ('soft', 'b'), ('medium', 'orange'), ('firm', 'y'), ('aggressive', 'r')):
+        freq_e, mag_e = measured_response(level)
+        ax2.semilogx(freq_e, mag_e, color=color, linestyle=':', linewidth=1.5)
+    ax2.plot([], [], 'k:', label='Measured on the engine')
 ax2.grid(True, alpha=0.3, which='both')
 ax2.set_xlabel('Frequency (Hz)')
 ax2.set_ylabel('Magnitude (dB)')
@@ -215,6 +241,9 @@ combined_mag = mag_dc + mag_16bit
 ax5.semilogx(freq_dc, mag_dc, 'b-', linewidth=1.5, alpha=0.7, label='Soft DC Block')
 ax5.semilogx(freq_16bit, mag_16bit, 'g-', linewidth=1.5, alpha=0.7, label='16-bit Biquad LPF')
 ax5.semilogx(freq_dc, combined_mag, 'r-', linewidth=2.5, label='Combined Response (DC Block + LPF)')
+if ENGINE is not None:
+    freq_e, mag_e = measured_response('soft')
+    ax5.semilogx(freq_e, mag_e, 'k:', linewidth=2, label='Measured on the engine (soft)')
 ax5.grid(True, alpha=0.3, which='both')
 ax5.set_xlabel('Frequency (Hz)')
 ax5.set_ylabel('Magnitude (dB)')
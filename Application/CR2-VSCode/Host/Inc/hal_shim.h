@@ -0,0 +1,57 @@
+/**
+  ******************************************************************************
+  * @file           : hal_shim.h
+  * @brief          : Host I2S driver for offline rendering of the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * The host has no I2S to drain the DMA ring, so the renderer plays it: HostI2S_Service()
+  * hands the half of the ring the DMA would have sent to a sink, then raises the interrupt
+  * the DMA would have raised, and runs the deferred render task if it was pended.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __HAL_SHIM_H
+#define __HAL_SHIM_H
+
+#include "stm32g4xx_hal.h"
+
+/* Receives one half of the ring: 16-bit samples, or 32-bit words with AUDIO_ENGINE_OUTPUT_32BIT.
+ * On the SAI each frame holds the slots of every zone (AUDIO_ENGINE_OUTPUT_ZONES pairs). */
+typedef void ( *HostI2S_SinkFunc ) ( const void *samples, uint32_t count );
+
+/**
+ * @brief Play the next half of the DMA ring and raise its transfer interrupt
+ * @param[in] sink Receives the samples played
+ * @return 1 while the DMA runs, 0 once the engine has stopped it
+ */
+uint8_t             HostI2S_Service                  ( HostI2S_SinkFunc sink );
+
+extern I2S_HandleTypeDef hi2s2;
+extern SAI_HandleTypeDef hsai_BlockA1;
+
+#endif /* __HAL_SHIM_H */
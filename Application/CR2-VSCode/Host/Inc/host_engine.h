@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file           : host_engine.h
+  * @brief          : Shared-library entry points of the host-built audio engine
+  ******************************************************************************
+  *
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  *
+  * @attention
+  *
+  * libaudio_engine_host exposes the engine, built natively with the same fixed-point code as
+  * the target, to other languages: HostEngine_Render() plays a whole buffer through it and
+  * returns the whole output in one call.  Host/audio_engine_host.py wraps it for Python.
+  * The engine is a single instance, so calls must not overlap.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __HOST_ENGINE_H
+#define __HOST_ENGINE_H
+
+#include <stdint.h>
+
+/* The filter chain and faders for one render.  HostEngine_DefaultSettings() fills in the
+ * engine's defaults. */
+typedef struct {
+  int32_t   lpf_level;                // LPF_Level, for the 16-bit biquad or the 8-bit filter by depth
+  float     air_db;                   // Air effect gain; used when air is set
+  float     fade_in;                  // Seconds, negative for the engine's default
+  float     fade_out;                 // Seconds, negative for the engine's default
+  uint16_t  volume;                   // What the volume callback returns, 1-65535
+  uint8_t   air;                      // Air effect on
+  uint8_t   noise_gate;
+  uint8_t   soft_clip;
+  uint8_t   hard_dc;                  // The hard DC filter in place of the soft one (16-bit)
+  uint8_t   faders;                   // Fade-in and fade-out ramps on
+} HostEngine_Settings;
+
+/**
+ * @brief Fill in the settings host_render uses without options
+ * @param[out] settings Settings to fill in
+ */
+void      HostEngine_DefaultSettings  ( HostEngine_Settings *settings );
+
+/**
+ * @brief Bits per output sample: 16, or 32 with AUDIO_ENGINE_OUTPUT_32BIT
+ * @return 16 or 32
+ */
+uint32_t  HostEngine_OutputBits       ( void );
+
+/**
+ * @brief Play a buffer through the engine and collect what the I2S would have sent
+ * @param[in] samples Interleaved input: int16_t for 16-bit, offset uint8_t for 8-bit
+ * @param[in] sample_count Input samples, all channels counted
+ * @param[in] rate Input rate in Hz
+ * @param[in] channels 1 or 2
+ * @param[in] bits 8 or 16
+ * @param[in] settings Filter chain and faders, NULL for the defaults
+ * @param[out] out Interleaved stereo output at the output rate, int16_t or, with 32-bit output,
+ *                 int32_t; may be NULL to measure the length
+ * @param[in] out_capacity Output samples out has room for; the rest are counted, not stored
+ * @return Output samples produced, more than out_capacity if it was too small, or -1 if the
+ *         engine refused the input
+ */
+int64_t   HostEngine_Render           ( const void *samples, uint32_t sample_count, uint32_t rate,
+                                        uint32_t channels, uint32_t bits, const HostEngine_Settings *settings,
+                                        void *out, uint64_t out_capacity );
+
+/**
+ * @brief The engine's output rate for the last render
+ * @return Output rate in Hz
+ */
+uint32_t  HostEngine_OutputRate       ( void );
+
+#endif /* __HOST_ENGINE_H */
@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * @file           : stm32g4xx_hal.h
+  * @brief          : Host stand-in for the STM32G4 HAL used by the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Lets Core/Libraries/audio_engine.c compile natively for offline rendering
+  * (see Host/CMakeLists.txt).  Only what the engine touches in the host configuration is
+  * here: the HAL status and handle types, the I2S DMA calls, the core registers the engine
+  * reads or writes (SCB, DWT, CoreDebug) as plain structs, and the Cortex-M4 intrinsics as
+  * portable C with the instructions' results, so the DSP-extension kernels render the same
+  * samples as on the target.  The FMAC, CORDIC, RNG, prefetch DMA, I2S clock plan, line
+  * input and extra I2S output zones have no stand-ins and must stay disabled; extra zones
+  * build on the SAI, whose TDM frames carry them all.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __STM32G4xx_HAL_H
+#define __STM32G4xx_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* HAL basics */
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY      0xFFFFFFFFU
+#define UNUSED( X )        (void)X
+
+#define __IO               volatile
+#define SET_BIT( REG, BIT )     ( ( REG ) |= ( BIT ) )
+#define CLEAR_BIT( REG, BIT )   ( ( REG ) &= ~( BIT ) )
+#define READ_BIT( REG, BIT )    ( ( REG ) & ( BIT ) )
+#define WRITE_REG( REG, VAL )   ( ( REG ) = ( VAL ) )
+#define READ_REG( REG )         ( ( REG ) )
+
+typedef enum
+{
+  GPIO_PIN_RESET = 0U,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+/* DMA: the channel counter is all the engine reads (AudioEngine_GetStreamPosition()) */
+typedef struct
+{
+  __IO uint32_t CCR;
+  __IO uint32_t CNDTR;
+  __IO uint32_t CPAR;
+  __IO uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+  DMA_Channel_TypeDef *Instance;
+} DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER( __HANDLE__ )   ( ( __HANDLE__ )->Instance->CNDTR )
+
+/* I2S: transmit by DMA into a ring that the host driver plays (Host/Src/hal_shim.c) */
+typedef enum
+{
+  HAL_I2S_STATE_RESET   = 0x00U,
+  HAL_I2S_STATE_READY   = 0x01U,
+  HAL_I2S_STATE_BUSY_TX = 0x03U
+} HAL_I2S_StateTypeDef;
+
+typedef struct __I2S_HandleTypeDef
+{
+  uint16_t                    *pTxBuffPtr;    // Ring passed to HAL_I2S_Transmit_DMA()
+  __IO uint16_t               TxXferSize;     // Samples in the ring
+  DMA_HandleTypeDef           *hdmatx;
+  __IO HAL_I2S_StateTypeDef   State;
+} I2S_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_I2S_Transmit_DMA( I2S_HandleTypeDef *hi2s, uint16_t *pData, uint16_t Size );
+HAL_StatusTypeDef HAL_I2S_DMAStop( I2S_HandleTypeDef *hi2s );
+void              HAL_I2S_TxHalfCpltCallback( I2S_HandleTypeDef *hi2s );
+void              HAL_I2S_TxCpltCallback( I2S_HandleTypeDef *hi2s );
+
+/* SAI: the same ring, counted in slots, for builds with AUDIO_ENGINE_ENABLE_SAI_OUTPUT */
+#define HAL_SAI_MODULE_ENABLED
+
+typedef enum
+{
+  HAL_SAI_STATE_RESET   = 0x00U,
+  HAL_SAI_STATE_READY   = 0x01U,
+  HAL_SAI_STATE_BUSY_TX = 0x12U
+} HAL_SAI_StateTypeDef;
+
+typedef struct __SAI_HandleTypeDef
+{
+  uint8_t                     *pBuffPtr;      // Ring passed to HAL_SAI_Transmit_DMA()
+  __IO uint16_t               XferSize;       // Slots in the ring
+  DMA_HandleTypeDef           *hdmatx;
+  __IO HAL_SAI_StateTypeDef   State;
+} SAI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SAI_Transmit_DMA( SAI_HandleTypeDef *hsai, uint8_t *pData, uint16_t Size );
+HAL_StatusTypeDef HAL_SAI_DMAStop( SAI_HandleTypeDef *hsai );
+void              HAL_SAI_TxHalfCpltCallback( SAI_HandleTypeDef *hsai );
+void              HAL_SAI_TxCpltCallback( SAI_HandleTypeDef *hsai );
+void              HAL_Delay( uint32_t Delay );
+uint32_t          HAL_GetTick( void );
+
+extern uint32_t   SystemCoreClock;
+
+/* Core registers, kept in memory */
+typedef struct
+{
+  __IO uint32_t ICSR;
+} SCB_Type;
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern SCB_Type       host_scb;
+extern DWT_Type       host_dwt;
+extern CoreDebug_Type host_core_debug;
+
+#define SCB                           ( &host_scb )
+#define DWT                           ( &host_dwt )
+#define CoreDebug                     ( &host_core_debug )
+#define SCB_ICSR_PENDSVSET_Msk        ( 1UL << 28U )
+#define SCB_ICSR_PENDSVCLR_Msk        ( 1UL << 27U )
+#define DWT_CTRL_CYCCNTENA_Msk        ( 1UL << 0U )
+#define CoreDebug_DEMCR_TRCENA_Msk    ( 1UL << 24U )
+
+/* NVIC */
+typedef enum
+{
+  PendSV_IRQn = -2
+} IRQn_Type;
+
+#define __NVIC_PRIO_BITS              4U
+
+static inline void NVIC_SetPriority( IRQn_Type IRQn, uint32_t priority ) { (void)IRQn; (void)priority; }
+
+/* Cortex-M4 intrinsics: barriers and interrupt masking have nothing to order or mask on the host.
+ * Barriers, idle loops and unmasking are where the target could take an interrupt, so they call
+ * host_preempt_hook when it is set (the stress harness, Host/Src/host_stress.c) and unmasked. */
+#define __STATIC_INLINE               static inline
+#define __STATIC_FORCEINLINE          __attribute__( ( always_inline ) ) static inline
+#define __COMPILER_BARRIER()          __asm volatile( "" ::: "memory" )
+
+extern uint32_t host_primask;
+extern void     ( *host_preempt_hook )( void );
+
+#define HOST_PREEMPT_POINT()          do { if( host_preempt_hook != NULL && host_primask == 0U ) { \
+                                             host_preempt_hook(); } } while( 0 )
+#define __DMB()                       do { __COMPILER_BARRIER(); HOST_PREEMPT_POINT(); } while( 0 )
+#define __NOP()                       HOST_PREEMPT_POINT()
+#define __WFI()                       HOST_PREEMPT_POINT()
+
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK( void )             { return host_primask; }
+__STATIC_FORCEINLINE void     __set_PRIMASK( uint32_t priMask ) { host_primask = priMask; HOST_PREEMPT_POINT(); }
+__STATIC_FORCEINLINE void     __disable_irq( void )             { host_primask = 1U; }
+__STATIC_FORCEINLINE void     __enable_irq( void )              { host_primask = 0U; HOST_PREEMPT_POINT(); }
+__STATIC_FORCEINLINE uint32_t __get_IPSR( void )                { return 0U; }                  // Always thread mode
+
+/* Exclusive access: nothing comes between the load and the store on the host */
+__STATIC_FORCEINLINE uint32_t __LDREXW( volatile uint32_t *addr )                 { return *addr; }
+__STATIC_FORCEINLINE uint32_t __STREXW( uint32_t value, volatile uint32_t *addr ) { *addr = value; return 0U; }
+
+__STATIC_FORCEINLINE int32_t __SSAT( int32_t val, uint32_t sat )
+{
+  const int32_t max = (int32_t)( ( 1U << ( sat - 1U ) ) - 1U );
+  const int32_t min = -1 - max;
+
+  return ( val > max ) ? max : ( val < min ) ? min : val;
+}
+
+__STATIC_FORCEINLINE uint32_t __ROR( uint32_t op1, uint32_t op2 )
+{
+  op2 %= 32U;
+  return ( op2 == 0U ) ? op1 : ( op1 >> op2 ) | ( op1 << ( 32U - op2 ) );
+}
+
+__STATIC_FORCEINLINE uint8_t __CLZ( uint32_t value )
+{
+  return ( value == 0U ) ? 32U : (uint8_t)__builtin_clz( value );
+}
+
+/* Packed halfword helpers for the DSP-extension kernels */
+#define HOST_LO16( x )                ( (int32_t)(int16_t)( (uint32_t)( x ) & 0xFFFFU ) )
+#define HOST_HI16( x )                ( (int32_t)(int16_t)( (uint32_t)( x ) >> 16 ) )
+#define HOST_PACK16( hi, lo )         ( ( (uint32_t)(uint16_t)( hi ) << 16 ) | (uint16_t)( lo ) )
+
+#define __PKHBT( ARG1, ARG2, ARG3 )   ( ( ( (uint32_t)( ARG1 ) ) & 0x0000FFFFUL ) | \
+                                        ( ( ( (uint32_t)( ARG2 ) ) << ( ARG3 ) ) & 0xFFFF0000UL ) )
+#define __PKHTB( ARG1, ARG2, ARG3 )   ( ( ( (uint32_t)( ARG1 ) ) & 0xFFFF0000UL ) | \
+                                        ( ( ( (uint32_t)( ARG2 ) ) >> ( ARG3 ) ) & 0x0000FFFFUL ) )
+
+__STATIC_FORCEINLINE uint32_t __QADD16( uint32_t op1, uint32_t op2 )
+{
+  return HOST_PACK16( __SSAT( HOST_HI16( op1 ) + HOST_HI16( op2 ), 16U ),
+                      __SSAT( HOST_LO16( op1 ) + HOST_LO16( op2 ), 16U ) );
+}
+
+__STATIC_FORCEINLINE uint32_t __SHADD16( uint32_t op1, uint32_t op2 )
+{
+  return HOST_PACK16( ( HOST_HI16( op1 ) + HOST_HI16( op2 ) ) >> 1, ( HOST_LO16( op1 ) + HOST_LO16( op2 ) ) >> 1 );
+}
+
+__STATIC_FORCEINLINE uint32_t __UXTB16( uint32_t op1 )
+{
+  return op1 & 0x00FF00FFU;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUAD( uint32_t op1, uint32_t op2 )
+{
+  return (uint32_t)( HOST_LO16( op1 ) * HOST_LO16( op2 ) ) + (uint32_t)( HOST_HI16( op1 ) * HOST_HI16( op2 ) );
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUADX( uint32_t op1, uint32_t op2 )
+{
+  return (uint32_t)( HOST_LO16( op1 ) * HOST_HI16( op2 ) ) + (uint32_t)( HOST_HI16( op1 ) * HOST_LO16( op2 ) );
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLAD( uint32_t op1, uint32_t op2, uint32_t op3 )
+{
+  return __SMUAD( op1, op2 ) + op3;                               // Wraps, as the instruction does
+}
+
+__STATIC_FORCEINLINE int32_t __SMMLA( int32_t op1, int32_t op2, int32_t op3 )
+{
+  return (int32_t)( ( (int64_t)op1 * op2 ) >> 32 ) + op3;
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLALD( uint32_t op1, uint32_t op2, uint64_t acc )
+{
+  return acc + (uint64_t)( (int64_t)HOST_LO16( op1 ) * HOST_LO16( op2 ) +
+                           (int64_t)HOST_HI16( op1 ) * HOST_HI16( op2 ) );
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32G4xx_HAL_H */
@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * @file           : hal_shim.c
+  * @brief          : Host I2S driver for offline rendering of the audio engine
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Stands in for the HAL calls the engine makes and for the I2S DMA itself.  The ring is
+  * "played" half at a time by HostI2S_Service(), with the DMA counter and the callbacks the
+  * real transfer would produce, so the engine runs its own interrupt path unchanged.
+  *
+  ******************************************************************************
+  */
+
+#include "hal_shim.h"
+#include "audio_engine.h"
+
+uint32_t            SystemCoreClock     = 170000000U;
+SCB_Type            host_scb;
+DWT_Type            host_dwt;
+CoreDebug_Type      host_core_debug;
+uint32_t            host_primask        = 0U;
+void                ( *host_preempt_hook )( void ) = NULL;
+
+static DMA_Channel_TypeDef  i2s_dma_channel;
+static DMA_HandleTypeDef    i2s_dma             = { &i2s_dma_channel };
+I2S_HandleTypeDef           hi2s2               = { NULL, 0U, &i2s_dma, HAL_I2S_STATE_READY };
+SAI_HandleTypeDef           hsai_BlockA1        = { NULL, 0U, &i2s_dma, HAL_SAI_STATE_READY };
+
+/* The output the engine drives, and the frames in a lap of its ring per transfer */
+#if AUDIO_ENGINE_ENABLE_SAI_OUTPUT
+#define HOST_OUT_BUSY()             ( hsai_BlockA1.State == HAL_SAI_STATE_BUSY_TX )
+#define HOST_OUT_RING               ( (const void *)hsai_BlockA1.pBuffPtr )
+#define HOST_OUT_SIZE               ( hsai_BlockA1.XferSize )
+#define HOST_OUT_SLOTS              ( 2U * AUDIO_ENGINE_OUTPUT_ZONES )
+#define HOST_OUT_HALF_PLAYED()      HAL_SAI_TxHalfCpltCallback( &hsai_BlockA1 )
+#define HOST_OUT_WRAPPED()          HAL_SAI_TxCpltCallback( &hsai_BlockA1 )
+#else
+#define HOST_OUT_BUSY()             ( hi2s2.State == HAL_I2S_STATE_BUSY_TX )
+#define HOST_OUT_RING               ( (const void *)hi2s2.pTxBuffPtr )
+#define HOST_OUT_SIZE               ( hi2s2.TxXferSize )
+#define HOST_OUT_SLOTS              2U
+#define HOST_OUT_HALF_PLAYED()      HAL_I2S_TxHalfCpltCallback( &hi2s2 )
+#define HOST_OUT_WRAPPED()          HAL_I2S_TxCpltCallback( &hi2s2 )
+#endif
+
+static uint8_t              second_half         = 0U;     // Half of the ring the DMA sends next
+static uint32_t             tick                = 0U;
+
+
+HAL_StatusTypeDef HAL_I2S_Transmit_DMA( I2S_HandleTypeDef *hi2s, uint16_t *pData, uint16_t Size )
+{
+  if( pData == NULL || Size == 0U || hi2s->State != HAL_I2S_STATE_READY ) {
+    return HAL_ERROR;
+  }
+  hi2s->pTxBuffPtr            = pData;
+  hi2s->TxXferSize            = Size;
+  hi2s->hdmatx->Instance->CNDTR = Size;
+  hi2s->State                 = HAL_I2S_STATE_BUSY_TX;
+  second_half                 = 0U;
+  return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_I2S_DMAStop( I2S_HandleTypeDef *hi2s )
+{
+  hi2s->State = HAL_I2S_STATE_READY;
+  return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_SAI_Transmit_DMA( SAI_HandleTypeDef *hsai, uint8_t *pData, uint16_t Size )
+{
+  if( pData == NULL || Size == 0U || hsai->State != HAL_SAI_STATE_READY ) {
+    return HAL_ERROR;
+  }
+  hsai->pBuffPtr              = pData;
+  hsai->XferSize              = Size;
+  hsai->hdmatx->Instance->CNDTR = Size;
+  hsai->State                 = HAL_SAI_STATE_BUSY_TX;
+  second_half                 = 0U;
+  return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_SAI_DMAStop( SAI_HandleTypeDef *hsai )
+{
+  hsai->State = HAL_SAI_STATE_READY;
+  return HAL_OK;
+}
+
+
+void HAL_Delay( uint32_t Delay )
+{
+  tick += Delay;                                          // Nothing to wait for; time still passes
+}
+
+
+uint32_t HAL_GetTick( void )
+{
+  return tick;
+}
+
+
+/** Play the next half of the DMA ring and raise its transfer interrupt
+  *
+  * @param: sink - Receives the samples played
+  * @retval: 1 while the DMA runs, 0 once the engine has stopped it
+  */
+uint8_t HostI2S_Service( HostI2S_SinkFunc sink )
+{
+  if( !HOST_OUT_BUSY() ) {
+    return 0U;
+  }
+
+  const uint32_t size   = HOST_OUT_SIZE;
+  const uint32_t half   = size / 2U;
+  const uint32_t offset = second_half ? half : 0U;
+  const uint32_t count  = second_half ? size - half : half;
+
+#if AUDIO_ENGINE_OUTPUT_32BIT
+  sink( (const uint32_t *)HOST_OUT_RING + offset, count );
+#else
+  sink( (const uint16_t *)HOST_OUT_RING + offset, count );
+#endif
+  tick += (uint32_t)( ( (uint64_t)count * 1000U / HOST_OUT_SLOTS ) / ( I2S_PlaybackSpeed ? I2S_PlaybackSpeed : 1U ) );
+
+  if( second_half ) {
+    i2s_dma_channel.CNDTR = size;
+    second_half           = 0U;
+    HOST_OUT_WRAPPED();
+  } else {
+    i2s_dma_channel.CNDTR = size - half;
+    second_half           = 1U;
+    HOST_OUT_HALF_PLAYED();
+  }
+
+#if AUDIO_ENGINE_DEFERRED_RENDER
+  if( host_scb.ICSR & SCB_ICSR_PENDSVSET_Msk ) {
+    host_scb.ICSR = 0U;
+    AudioEngine_RenderTask();
+  }
+#endif
+  return HOST_OUT_BUSY() ? 1U : 0U;
+}
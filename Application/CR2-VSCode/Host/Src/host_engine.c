@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * @file           : host_engine.c
+  * @brief          : Shared-library entry points of the host-built audio engine
+  ******************************************************************************
+  *
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  *
+  * @attention
+  *
+  * The same path as host_render: PlaySample() starts the DMA, and HostI2S_Service() plays the
+  * ring until the engine stops it, here into the caller's buffer instead of a file.  The
+  * input is copied to a word-aligned buffer first, as the engine reads it in words.
+  *
+  ******************************************************************************
+  */
+
+#include "host_engine.h"
+#include "hal_shim.h"
+#include "audio_engine.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if AUDIO_ENGINE_OUTPUT_32BIT
+typedef int32_t OutputSample;
+#else
+typedef int16_t OutputSample;
+#endif
+
+static uint8_t        engine_ready    = 0U;
+static uint16_t       host_volume     = 65535U;
+static OutputSample  *out_samples     = NULL;
+static uint64_t       out_room        = 0U;
+static uint64_t       out_count       = 0U;
+
+
+/* Hardware callbacks: nothing to switch, a fixed volume, and an I2S with no registers */
+static void     HostDACSwitch   ( GPIO_PinState setting ) { (void)setting; }
+static uint16_t HostReadVolume  ( void )                  { return host_volume; }
+static void     HostI2SInit     ( void )                  { }
+
+
+/* Output sink: stores what fits, counts the rest */
+static void CollectSamples( const void *samples, uint32_t count )
+{
+#if AUDIO_ENGINE_OUTPUT_32BIT
+  const uint32_t *words = samples;
+#else
+  const int16_t  *values = samples;
+#endif
+  for( uint32_t i = 0; i < count; i++, out_count++ ) {
+    if( out_count < out_room ) {
+#if AUDIO_ENGINE_OUTPUT_32BIT
+      out_samples[ out_count ] = (int32_t)__ROR( words[ i ], 16U );   // Undo the half-word swap for the DMA
+#else
+      out_samples[ out_count ] = values[ i ];
+#endif
+    }
+  }
+}
+
+
+/** Fill in the settings host_render uses without options
+  *
+  * @param: settings - Settings to fill in
+  * @retval: none
+  */
+void HostEngine_DefaultSettings( HostEngine_Settings *settings )
+{
+  memset( settings, 0, sizeof( *settings ) );
+  settings->lpf_level   = LPF_Soft;
+  settings->fade_in     = -1.0f;
+  settings->fade_out    = -1.0f;
+  settings->volume      = 65535U;
+  settings->soft_clip   = 1U;
+  settings->faders      = 1U;
+}
+
+
+/** Bits per output sample of this build
+  *
+  * @param: none
+  * @retval: 16, or 32 with AUDIO_ENGINE_OUTPUT_32BIT
+  */
+uint32_t HostEngine_OutputBits( void )
+{
+  return AUDIO_ENGINE_OUTPUT_32BIT ? 32U : 16U;
+}
+
+
+/** Output rate of the last render
+  *
+  * @param: none
+  * @retval: Rate in Hz
+  */
+uint32_t HostEngine_OutputRate( void )
+{
+  return GetPlaybackSpeed();
+}
+
+
+/** Play a buffer through the engine and collect what the I2S would have sent
+  *
+  * @param: samples - Interleaved input, int16_t for 16-bit or offset uint8_t for 8-bit
+  * @param: sample_count - Input samples, all channels counted
+  * @param: rate - Input rate in Hz
+  * @param: channels - 1 or 2
+  * @param: bits - 8 or 16
+  * @param: settings - Filter chain and faders, NULL for the defaults
+  * @param: out - Interleaved stereo output, NULL to measure the length
+  * @param: out_capacity - Output samples out has room for
+  * @retval: Output samples produced, more than out_capacity if it was too small; -1 if the
+  *          engine refused the input
+  */
+int64_t HostEngine_Render( const void *samples, uint32_t sample_count, uint32_t rate, uint32_t channels, uint32_t bits,
+                           const HostEngine_Settings *settings, void *out, uint64_t out_capacity )
+{
+  HostEngine_Settings defaults;
+  FilterConfig_TypeDef cfg;
+
+  if( samples == NULL || sample_count == 0U || ( channels != 1U && channels != 2U ) || ( bits != 8U && bits != 16U ) ) {
+    return -1;
+  }
+  if( settings == NULL ) {
+    HostEngine_DefaultSettings( &defaults );
+    settings = &defaults;
+  }
+  if( !engine_ready ) {
+    if( AudioEngine_Init( HostDACSwitch, HostReadVolume, HostI2SInit ) != PB_Idle ) {
+      return -1;
+    }
+    engine_ready = 1U;
+  }
+
+  host_volume = settings->volume ? settings->volume : 1U;
+  GetFilterConfig( &cfg );
+  cfg.enable_noise_gate            = settings->noise_gate;
+  cfg.enable_soft_clipping         = settings->soft_clip;
+  cfg.enable_soft_dc_filter_16bit  = (uint8_t)!settings->hard_dc;
+  SetFilterConfig( &cfg );
+  SetFadersEnabled( settings->faders );
+  if( settings->fade_in >= 0.0f ) {
+    SetFadeInTime( settings->fade_in );
+  }
+  if( settings->fade_out >= 0.0f ) {
+    SetFadeOutTime( settings->fade_out );
+  }
+  if( bits == 16U ) {
+    SetLpf16BitLevel( (LPF_Level)settings->lpf_level );
+  } else {
+    SetLpf8BitLevel( (LPF_Level)settings->lpf_level );
+  }
+  SetAirEffectEnable( settings->air );
+  if( settings->air ) {
+    SetAirEffectGainDb( settings->air_db );
+  }
+
+  const size_t bytes = (size_t)sample_count * ( bits / 8U );
+  void *data = malloc( bytes + 4U );                      // Word aligned, as the engine expects
+  if( data == NULL ) {
+    return -1;
+  }
+  memcpy( data, samples, bytes );
+
+  out_samples = out;
+  out_room    = ( out != NULL ) ? out_capacity : 0U;
+  out_count   = 0U;
+  if( PlaySample( data, sample_count, rate, (uint8_t)bits, ( channels == 2U ) ? Mode_stereo : Mode_mono ) != PB_Playing ) {
+    free( data );
+    return -1;
+  }
+  while( HostI2S_Service( CollectSamples ) ) {
+  }
+  free( data );
+  out_samples = NULL;
+  return (int64_t)out_count;
+}
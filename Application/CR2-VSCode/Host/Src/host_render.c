@@ -0,0 +1,353 @@
+/**
+  ******************************************************************************
+  * @file           : host_render.c
+  * @brief          : Offline renderer: plays a WAV file through the audio engine into a WAV file
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Runs the engine natively against the HAL stand-in (Host/Src/hal_shim.c): PlaySample()
+  * starts the DMA as on the target, and HostI2S_Service() plays the ring half at a time,
+  * writing what the I2S would have sent to the output file until the engine stops it.
+  * --sweep renders every LPF level with the air effect off and on, one file each, so two
+  * builds can be diffed over the whole filter space in seconds.
+  *
+  * Usage:
+  *   host_render in.wav out.wav [--lpf LEVEL] [--air DB] [--noise-gate] [--no-soft-clip]
+  *                              [--hard-dc] [--volume N] [--fade-in S] [--fade-out S] [--no-faders]
+  *   host_render in.wav out_prefix --sweep
+  *
+  ******************************************************************************
+  */
+
+#include "hal_shim.h"
+#include "audio_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Input and output files */
+typedef struct {
+  void      *data;
+  uint32_t  sample_count;                                   // All channels combined
+  uint32_t  rate;
+  uint16_t  channels;
+  uint16_t  bits;
+} WavInput;
+
+static FILE     *out_file       = NULL;
+static uint32_t out_bytes       = 0U;
+static uint16_t host_volume     = 65535U;
+
+static const char *const level_names[] = { "off", "very-soft", "soft", "medium", "firm", "aggressive" };
+#define LEVEL_COUNT ( sizeof( level_names ) / sizeof( level_names[ 0 ] ) )
+
+
+/* Hardware callbacks: nothing to switch, a fixed volume, and an I2S with no registers */
+static void     HostDACSwitch   ( GPIO_PinState setting ) { (void)setting; }
+static uint16_t HostReadVolume  ( void )                  { return host_volume; }
+static void     HostI2SInit     ( void )                  { }
+
+
+static uint32_t ReadLe( const uint8_t *p, uint32_t bytes )
+{
+  uint32_t v = 0U;
+  for( uint32_t i = 0; i < bytes; i++ ) {
+    v |= (uint32_t)p[ i ] << ( 8U * i );
+  }
+  return v;
+}
+
+
+static void WriteLe( FILE *f, uint32_t v, uint32_t bytes )
+{
+  for( uint32_t i = 0; i < bytes; i++ ) {
+    fputc( (int)( ( v >> ( 8U * i ) ) & 0xFFU ), f );
+  }
+}
+
+
+/** Load an 8 or 16-bit PCM WAV file, mono or stereo
+  *
+  * @param: path - File to read
+  * @param: wav - Filled with the sample data, which stays allocated
+  * @retval: 1 on success, 0 with a message on stderr otherwise
+  */
+static int LoadWav( const char *path, WavInput *wav )
+{
+  FILE *f = fopen( path, "rb" );
+  if( f == NULL ) {
+    fprintf( stderr, "%s: cannot open\n", path );
+    return 0;
+  }
+  fseek( f, 0, SEEK_END );
+  const long size = ftell( f );
+  fseek( f, 0, SEEK_SET );
+  uint8_t *file = malloc( (size_t)size );
+  if( file == NULL || fread( file, 1, (size_t)size, f ) != (size_t)size ) {
+    fclose( f );
+    free( file );
+    fprintf( stderr, "%s: cannot read\n", path );
+    return 0;
+  }
+  fclose( f );
+
+  memset( wav, 0, sizeof( *wav ) );
+  if( size < 12 || memcmp( file, "RIFF", 4 ) != 0 || memcmp( file + 8, "WAVE", 4 ) != 0 ) {
+    fprintf( stderr, "%s: not a WAV file\n", path );
+    free( file );
+    return 0;
+  }
+  for( long pos = 12; pos + 8 <= size; ) {
+    const uint32_t chunk = ReadLe( file + pos + 4, 4U );
+    if( memcmp( file + pos, "fmt ", 4 ) == 0 && chunk >= 16U ) {
+      if( ReadLe( file + pos + 8, 2U ) != 1U ) {
+        fprintf( stderr, "%s: only PCM is supported\n", path );
+        break;
+      }
+      wav->channels = (uint16_t)ReadLe( file + pos + 10, 2U );
+      wav->rate     = ReadLe( file + pos + 12, 4U );
+      wav->bits     = (uint16_t)ReadLe( file + pos + 22, 2U );
+    } else if( memcmp( file + pos, "data", 4 ) == 0 && wav->bits != 0U ) {
+      const uint32_t bytes = ( (long)chunk <= size - pos - 8 ) ? chunk : (uint32_t)( size - pos - 8 );
+      wav->sample_count = bytes / ( wav->bits / 8U );
+      wav->sample_count -= wav->sample_count % wav->channels;
+      wav->data = malloc( bytes + 4U );                     // Word aligned, as the engine expects
+      memcpy( wav->data, file + pos + 8, bytes );
+      break;
+    }
+    pos += 8 + (long)chunk + (long)( chunk & 1U );
+  }
+  free( file );
+
+  if( wav->data == NULL || ( wav->bits != 8U && wav->bits != 16U ) || ( wav->channels != 1U && wav->channels != 2U ) ) {
+    fprintf( stderr, "%s: needs 8 or 16-bit PCM, mono or stereo\n", path );
+    free( wav->data );
+    return 0;
+  }
+  return 1;
+}
+
+
+/* Output sink: the samples the I2S would have sent */
+static void WriteSamples( const void *samples, uint32_t count )
+{
+#if AUDIO_ENGINE_OUTPUT_32BIT
+  const uint32_t *words = samples;
+  for( uint32_t i = 0; i < count; i++ ) {
+    WriteLe( out_file, __ROR( words[ i ], 16U ), 4U );     // Undo the half-word swap for the DMA
+  }
+  out_bytes += count * 4U;
+#else
+  const int16_t *values = samples;
+  for( uint32_t i = 0; i < count; i++ ) {
+    WriteLe( out_file, (uint16_t)values[ i ], 2U );
+  }
+  out_bytes += count * 2U;
+#endif
+}
+
+
+static void WriteWavHeader( FILE *f, uint32_t rate, uint32_t data_bytes )
+{
+  const uint32_t bits = AUDIO_ENGINE_OUTPUT_32BIT ? 32U : 16U;
+
+  fwrite( "RIFF", 1, 4, f );  WriteLe( f, 36U + data_bytes, 4U );
+  fwrite( "WAVEfmt ", 1, 8, f );
+  WriteLe( f, 16U, 4U );  WriteLe( f, 1U, 2U );  WriteLe( f, 2U, 2U );
+  WriteLe( f, rate, 4U );  WriteLe( f, rate * 2U * bits / 8U, 4U );
+  WriteLe( f, 2U * bits / 8U, 2U );  WriteLe( f, bits, 2U );
+  fwrite( "data", 1, 4, f );  WriteLe( f, data_bytes, 4U );
+}
+
+
+/** Play the input through the engine into a stereo WAV file at the output rate
+  *
+  * @param: wav - Input samples
+  * @param: path - Output file
+  * @retval: 1 on success, 0 with a message on stderr otherwise
+  */
+static int Render( const WavInput *wav, const char *path )
+{
+  out_file = fopen( path, "wb" );
+  if( out_file == NULL ) {
+    fprintf( stderr, "%s: cannot create\n", path );
+    return 0;
+  }
+  out_bytes = 0U;
+  WriteWavHeader( out_file, 0U, 0U );
+
+  const PB_StatusTypeDef status = PlaySample( wav->data, wav->sample_count, wav->rate, (uint8_t)wav->bits,
+                                              ( wav->channels == 2U ) ? Mode_stereo : Mode_mono );
+  if( status != PB_Playing ) {
+    fprintf( stderr, "%s: PlaySample() failed (%d)\n", path, (int)status );
+    fclose( out_file );
+    return 0;
+  }
+  while( HostI2S_Service( WriteSamples ) ) {
+  }
+
+  fseek( out_file, 0, SEEK_SET );
+  WriteWavHeader( out_file, GetPlaybackSpeed(), out_bytes );
+  fclose( out_file );
+  return 1;
+}
+
+
+static int LevelFromName( const char *name, LPF_Level *level )
+{
+  for( uint32_t i = 0; i < LEVEL_COUNT; i++ ) {
+    if( strcmp( name, level_names[ i ] ) == 0 ) {
+      *level = (LPF_Level)i;
+      return 1;
+    }
+  }
+  fprintf( stderr, "unknown LPF level %s\n", name );
+  return 0;
+}
+
+
+/* The LPF for the input's depth: the biquad for 16-bit samples, the 8-bit filter otherwise */
+static void SetLpfLevel( const WavInput *wav, LPF_Level level )
+{
+  if( wav->bits == 16U ) {
+    SetLpf16BitLevel( level );
+  } else {
+    SetLpf8BitLevel( level );
+  }
+}
+
+
+int main( int argc, char **argv )
+{
+  WavInput  wav;
+  LPF_Level level       = LPF_Soft;
+  float     air_db      = 0.0f;
+  int       air         = 0;
+  int       sweep       = 0;
+  int       noise_gate  = 0;
+  int       soft_clip   = 1;
+  int       hard_dc     = 0;
+  int       faders      = 1;
+  float     fade_in     = -1.0f;                          // Negative: the engine's default
+  float     fade_out    = -1.0f;
+  int       compress    = 0;
+  float     compress_db = 0.0f;
+
+  if( argc < 3 ) {
+    fprintf( stderr, "usage: %s in.wav out.wav [--lpf LEVEL] [--air DB] [--noise-gate] [--no-soft-clip]\n"
+                     "       %*s [--hard-dc] [--volume N] [--fade-in S] [--fade-out S] [--no-faders] [--compress DB]\n"
+                     "       %s in.wav out_prefix --sweep\n", argv[ 0 ], (int)strlen( argv[ 0 ] ), "", argv[ 0 ] );
+    return 2;
+  }
+  for( int i = 3; i < argc; i++ ) {
+    if( strcmp( argv[ i ], "--lpf" ) == 0 && i + 1 < argc ) {
+      if( !LevelFromName( argv[ ++i ], &level ) ) {
+        return 2;
+      }
+    } else if( strcmp( argv[ i ], "--air" ) == 0 && i + 1 < argc ) {
+      air    = 1;
+      air_db = strtof( argv[ ++i ], NULL );
+    } else if( strcmp( argv[ i ], "--volume" ) == 0 && i + 1 < argc ) {
+      host_volume = (uint16_t)strtoul( argv[ ++i ], NULL, 0 );
+    } else if( strcmp( argv[ i ], "--noise-gate" ) == 0 ) {
+      noise_gate = 1;
+    } else if( strcmp( argv[ i ], "--no-soft-clip" ) == 0 ) {
+      soft_clip = 0;
+    } else if( strcmp( argv[ i ], "--hard-dc" ) == 0 ) {
+      hard_dc = 1;
+    } else if( strcmp( argv[ i ], "--fade-in" ) == 0 && i + 1 < argc ) {
+      fade_in = strtof( argv[ ++i ], NULL );
+    } else if( strcmp( argv[ i ], "--fade-out" ) == 0 && i + 1 < argc ) {
+      fade_out = strtof( argv[ ++i ], NULL );
+    } else if( strcmp( argv[ i ], "--no-faders" ) == 0 ) {
+      faders = 0;
+    } else if( strcmp( argv[ i ], "--compress" ) == 0 && i + 1 < argc ) {
+      compress    = 1;
+      compress_db = strtof( argv[ ++i ], NULL );
+    } else if( strcmp( argv[ i ], "--sweep" ) == 0 ) {
+      sweep = 1;
+    } else {
+      fprintf( stderr, "unknown option %s\n", argv[ i ] );
+      return 2;
+    }
+  }
+
+  if( !LoadWav( argv[ 1 ], &wav ) ) {
+    return 1;
+  }
+  if( AudioEngine_Init( HostDACSwitch, HostReadVolume, HostI2SInit ) != PB_Idle ) {
+    fprintf( stderr, "AudioEngine_Init() failed\n" );
+    return 1;
+  }
+
+  FilterConfig_TypeDef cfg;
+  GetFilterConfig( &cfg );
+  cfg.enable_noise_gate            = (uint8_t)noise_gate;
+  cfg.enable_soft_clipping         = (uint8_t)soft_clip;
+  cfg.enable_soft_dc_filter_16bit  = (uint8_t)!hard_dc;
+  SetFilterConfig( &cfg );
+  SetFadersEnabled( (uint8_t)faders );
+  if( fade_in >= 0.0f ) {
+    SetFadeInTime( fade_in );
+  }
+  if( fade_out >= 0.0f ) {
+    SetFadeOutTime( fade_out );
+  }
+  if( compress ) {
+#if AUDIO_ENGINE_ENABLE_COMPRESSOR
+    const AudioEngine_Compressor comp = { compress_db, 4.0f, 5.0f, 100.0f, 3.0f };   // Threshold from the option, 4:1
+
+    AudioEngine_SetCompressor( &comp );
+#else
+    fprintf( stderr, "--compress needs AUDIO_ENGINE_ENABLE_COMPRESSOR\n" );
+    return 2;
+#endif
+  }
+
+  if( !sweep ) {
+    SetLpfLevel( &wav, level );
+    SetAirEffectEnable( (uint8_t)air );
+    if( air ) {
+      SetAirEffectGainDb( air_db );
+    }
+    return Render( &wav, argv[ 2 ] ) ? 0 : 1;
+  }
+
+  for( uint32_t l = 0; l < LEVEL_COUNT; l++ ) {
+    for( uint32_t a = 0; a < 2U; a++ ) {
+      char path[ 1024 ];
+
+      SetLpfLevel( &wav, (LPF_Level)l );
+      SetAirEffectEnable( (uint8_t)a );
+      snprintf( path, sizeof( path ), "%s_%s%s.wav", argv[ 2 ], level_names[ l ], a ? "_air" : "" );
+      if( !Render( &wav, path ) ) {
+        return 1;
+      }
+      printf( "%s\n", path );
+    }
+  }
+  return 0;
+}
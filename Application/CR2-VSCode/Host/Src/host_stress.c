@@ -0,0 +1,563 @@
+/**
+  ******************************************************************************
+  * @file           : host_stress.c
+  * @brief          : Control-path stress harness: random transport calls raced against the DMA interrupt
+  ******************************************************************************
+  *
+  * MIT License
+  *
+  * Copyright (c) 2024-2026 Jennifer A. Gunn (with technological assistance).
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  *
+  * @attention
+  *
+  * Drives the engine with a random mix of PlaySample(), PlaySampleLooped(), StopPlayback(),
+  * PausePlayback(), ResumePlayback(), ShutDownAudio(), WaitForSampleEnd() and fader changes,
+  * interleaved with DMA interrupts (HostI2S_Service()).  Interrupts are also taken inside the
+  * control calls, at the points the target could take one: barriers, idle loops and the end of
+  * a masked section (host_preempt_hook in Host/Inc/stm32g4xx_hal.h).
+  *
+  * After every call and every interrupt the playback state is checked:
+  *   - it is a PB_StatusTypeDef value, and a transition the context could make: the queued
+  *     calls (stop, pause, resume) never change it themselves, an interrupt never starts a
+  *     playback, and a paused playback never goes back to the pause fade;
+  *   - no playback is left Playing, Pausing or Paused with the DMA stopped;
+  *   - an accepted stop ends the playback, and an accepted pause or resume reaches its state,
+  *     within two seconds of audio;
+  *   - WaitForSampleEnd() returns; it is only called with no pause or endless loop pending,
+  *     as it waits through those by design.
+  * Violations are printed with the step and the preceding calls, and make the exit status 1.
+  *
+  * The report gives the host time of each control call, less the interrupts taken inside it,
+  * and of the interrupts by the state change they made: the worst case of each points at the
+  * longest control path.  Host times only rank the paths; time them on the target with
+  * AUDIO_ENGINE_ENABLE_PROFILING.
+  *
+  * Usage:
+  *   host_stress [--seed N] [--steps N] [--preempt PCT] [--verbose]
+  *
+  ******************************************************************************
+  */
+
+#include "hal_shim.h"
+#include "audio_engine.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TONE_RATE               22050U
+#define TONE_FRAMES             ( TONE_RATE / 4U )          // 250 ms, so playbacks also end on their own
+#define STATE_COUNT             ( PB_PlayingFailed + 1 )
+#define HISTORY_LEN             8U                          // Calls listed with a violation
+#define WAIT_INTERRUPT_LIMIT    100000U                     // Interrupts WaitForSampleEnd() may take
+#define MAX_VIOLATIONS          20U
+
+/* Control calls the harness makes */
+typedef enum {
+  ACT_INTERRUPT,
+  ACT_PLAY_16BIT,
+  ACT_PLAY_8BIT,
+  ACT_PLAY_LOOPED,
+  ACT_STOP,
+  ACT_PAUSE,
+  ACT_RESUME,
+  ACT_SHUTDOWN,
+  ACT_WAIT_END,
+  ACT_FADERS,
+  ACT_COUNT
+} Action;
+
+/* Relative frequency of each call; interrupts dominate so playbacks get somewhere */
+static const uint32_t action_weight[ ACT_COUNT ] = { 40U, 4U, 3U, 2U, 6U, 6U, 6U, 1U, 1U, 2U };
+
+static const char *const action_names[ ACT_COUNT ] = {
+  "interrupt", "PlaySample 16-bit", "PlaySample 8-bit", "PlaySampleLooped", "StopPlayback",
+  "PausePlayback", "ResumePlayback", "ShutDownAudio", "WaitForSampleEnd", "SetFadersEnabled"
+};
+
+static const char *const state_names[ STATE_COUNT ] = {
+  "Idle", "Error", "Playing", "Pausing", "Paused", "PlayingFailed"
+};
+
+/* Host time of one kind of call or interrupt */
+typedef struct {
+  uint64_t  calls;
+  uint64_t  total_ns;
+  uint64_t  max_ns;
+  uint8_t   max_state;                                    // State the slowest one was made in
+  uint64_t  max_step;
+} Cost;
+
+/* A state the harness waits for after an accepted call */
+typedef struct {
+  uint8_t   active;
+  uint32_t  interrupts;                                   // Interrupts since the call
+  uint64_t  step;
+  const char *what;
+} Expectation;
+
+static int16_t      tone16[ TONE_FRAMES ];
+static uint8_t      tone8[ TONE_FRAMES ];
+
+static uint64_t     rng_state;
+static uint32_t     preempt_percent     = 10U;
+static int          verbose             = 0;
+
+static Cost         action_cost[ ACT_COUNT ];
+static Cost         interrupt_cost[ STATE_COUNT ][ STATE_COUNT ];     // By state before and after
+static uint32_t     queue_full          = 0U;
+static uint32_t     nested_interrupts   = 0U;              // Interrupts taken inside control calls
+
+static uint8_t      in_interrupt        = 0U;
+static uint8_t      waiting             = 0U;              // In WaitForSampleEnd(): every idle loop takes one
+static uint32_t     wait_interrupts     = 0U;
+static uint64_t     interrupt_ns        = 0U;              // Spent in interrupts during the current call
+
+static uint8_t      last_state          = PB_Idle;
+static uint64_t     step                = 0U;
+static uint32_t     violations          = 0U;
+static Action       history[ HISTORY_LEN ];
+static uint64_t     history_count       = 0U;
+
+static Expectation  expect_stop;
+static Expectation  expect_pause;
+static Expectation  expect_resume;
+static uint8_t      looping             = 0U;              // The playback loops until stopped
+
+
+/* Hardware callbacks: nothing to switch, a fixed volume, and an I2S with no registers */
+static void     HostDACSwitch   ( GPIO_PinState setting ) { (void)setting; }
+static uint16_t HostReadVolume  ( void )                  { return 40000U; }
+static void     HostI2SInit     ( void )                  { }
+static void     DiscardSamples  ( const void *samples, uint32_t count ) { (void)samples; (void)count; }
+
+
+static uint32_t Random( void )
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return (uint32_t)( ( rng_state * 0x2545F4914F6CDD1DULL ) >> 32 );
+}
+
+
+static uint64_t NowNs( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts );           // CPU time: the scheduler adds no spikes
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+static void RecordCost( Cost *cost, uint64_t ns, uint8_t state )
+{
+  cost->calls++;
+  cost->total_ns += ns;
+  if( ns > cost->max_ns ) {
+    cost->max_ns    = ns;
+    cost->max_state = state;
+    cost->max_step  = step;
+  }
+}
+
+
+static uint8_t PlaybackActive( uint8_t state )
+{
+  return state == PB_Playing || state == PB_Pausing || state == PB_Paused;
+}
+
+
+/** Report a violation with the calls that led to it
+  *
+  * @param: what - What went wrong
+  * @retval: none
+  */
+static void Violation( const char *what )
+{
+  violations++;
+  if( violations > MAX_VIOLATIONS ) {
+    return;
+  }
+  printf( "VIOLATION at step %llu: %s (state %s)\n  after:", (unsigned long long)step, what,
+          state_names[ last_state < STATE_COUNT ? last_state : 0 ] );
+  const uint64_t first = ( history_count > HISTORY_LEN ) ? history_count - HISTORY_LEN : 0U;
+  for( uint64_t i = first; i < history_count; i++ ) {
+    printf( " %s%s", action_names[ history[ i % HISTORY_LEN ] ], ( i + 1U < history_count ) ? "," : "\n" );
+  }
+}
+
+
+/** Check a state change made by an interrupt
+  *
+  * The render context moves a playback on but never starts one (no cued playbacks here), and
+  * a finished pause fade only leaves Paused for a resume or a stop.
+  *
+  * @param: from - State before the interrupt
+  * @param: to - State after it
+  * @retval: none
+  */
+static void CheckInterruptTransition( uint8_t from, uint8_t to )
+{
+  if( to >= STATE_COUNT ) {
+    Violation( "state out of range after an interrupt" );
+  } else if( from != to && !PlaybackActive( from ) ) {
+    Violation( "an interrupt changed the state of an idle or failed engine" );
+  } else if( from == PB_Paused && to == PB_Pausing ) {
+    Violation( "Paused went back to Pausing" );
+  }
+}
+
+
+/** Check the state against the DMA and the pending expectations
+  *
+  * @param: none
+  * @retval: none
+  */
+static void CheckInvariants( void )
+{
+  const uint8_t state = (uint8_t)GetPlaybackState();
+
+  if( PlaybackActive( state ) && hi2s2.State != HAL_I2S_STATE_BUSY_TX ) {
+    Violation( "a playback is active with the DMA stopped" );
+  }
+  if( !PlaybackActive( state ) ) {
+    expect_stop.active   = 0U;
+    expect_pause.active  = 0U;
+    expect_resume.active = 0U;
+  }
+  if( state == PB_Paused ) {
+    expect_pause.active  = 0U;
+  }
+  if( state == PB_Playing ) {
+    expect_resume.active = 0U;
+  }
+}
+
+
+static void Expect( Expectation *e, const char *what )
+{
+  e->active     = 1U;
+  e->interrupts = 0U;
+  e->step       = step;
+  e->what       = what;
+}
+
+
+static void AgeExpectation( Expectation *e )
+{
+  const uint32_t expect_limit = ( 2U * TONE_RATE * 2U ) / ( hi2s2.TxXferSize / 2U + 1U ) + 4U;  // Two seconds of halves
+
+  if( e->active && ++e->interrupts > expect_limit ) {
+    char text[ 128 ];
+    snprintf( text, sizeof( text ), "%s accepted at step %llu has not taken effect after %u interrupts",
+              e->what, (unsigned long long)e->step, (unsigned)expect_limit );
+    Violation( text );
+    e->active = 0U;
+  }
+}
+
+
+/** Take one DMA interrupt, as the I2S finishing half of the ring
+  *
+  * @param: none
+  * @retval: Host time of the interrupt in nanoseconds, 0 with the DMA stopped
+  */
+static uint64_t TakeInterrupt( void )
+{
+  if( hi2s2.State != HAL_I2S_STATE_BUSY_TX ) {
+    return 0U;
+  }
+
+  const uint8_t  from  = (uint8_t)GetPlaybackState();
+  in_interrupt = 1U;
+  const uint64_t start = NowNs();
+  (void)HostI2S_Service( DiscardSamples );
+  const uint64_t ns    = NowNs() - start;
+  in_interrupt = 0U;
+  const uint8_t  to    = (uint8_t)GetPlaybackState();
+
+  if( from < STATE_COUNT && to < STATE_COUNT ) {
+    RecordCost( &interrupt_cost[ from ][ to ], ns, from );
+  }
+  CheckInterruptTransition( from, to );
+  last_state = to;
+  AgeExpectation( &expect_stop );
+  AgeExpectation( &expect_pause );
+  AgeExpectation( &expect_resume );
+  CheckInvariants();
+  return ns;
+}
+
+
+/** Interrupt point inside a control call (host_preempt_hook)
+  *
+  * Takes the DMA interrupt at random, or always while WaitForSampleEnd() idles, as the I2S
+  * would keep interrupting it.  Nothing preempts the interrupt itself.
+  *
+  * @param: none
+  * @retval: none
+  */
+static void PreemptPoint( void )
+{
+  if( in_interrupt ) {
+    return;
+  }
+  if( waiting ) {
+    if( ++wait_interrupts > WAIT_INTERRUPT_LIMIT ) {
+      Violation( "WaitForSampleEnd() does not return" );
+      exit( 1 );
+    }
+    if( hi2s2.State != HAL_I2S_STATE_BUSY_TX && PlaybackActive( (uint8_t)GetPlaybackState() ) ) {
+      Violation( "WaitForSampleEnd() waits on a playback with the DMA stopped" );
+      exit( 1 );
+    }
+  } else if( Random() % 100U >= preempt_percent ) {
+    return;
+  }
+  interrupt_ns += TakeInterrupt();
+  nested_interrupts++;
+}
+
+
+static Action PickAction( void )
+{
+  uint32_t total = 0U;
+  for( uint32_t a = 0; a < ACT_COUNT; a++ ) {
+    total += action_weight[ a ];
+  }
+  uint32_t pick = Random() % total;
+  for( uint32_t a = 0; a < ACT_COUNT; a++ ) {
+    if( pick < action_weight[ a ] ) {
+      return (Action)a;
+    }
+    pick -= action_weight[ a ];
+  }
+  return ACT_INTERRUPT;
+}
+
+
+/** Make one control call and check what it did to the state
+  *
+  * @param: action - Call to make
+  * @retval: none
+  */
+static void RunAction( Action action )
+{
+  const uint8_t     before = (uint8_t)GetPlaybackState();
+  PB_StatusTypeDef  status = PB_Idle;
+
+  if( action == ACT_WAIT_END && ( expect_pause.active || ( looping && !expect_stop.active ) ||
+      ( ( before == PB_Pausing || before == PB_Paused ) && !expect_stop.active && !expect_resume.active ) ) ) {
+    action = ACT_INTERRUPT;                               // Waiting out a pause or an endless loop blocks, by design
+  }
+
+  history[ history_count++ % HISTORY_LEN ] = action;
+  if( action == ACT_INTERRUPT ) {
+    RecordCost( &action_cost[ ACT_INTERRUPT ], TakeInterrupt(), before );
+    return;
+  }
+
+  interrupt_ns = 0U;
+  last_state   = before;
+  const uint64_t start = NowNs();
+  switch( action ) {
+    case ACT_PLAY_16BIT:
+      status = PlaySample( tone16, TONE_FRAMES, TONE_RATE, 16U, Mode_mono );
+      break;
+    case ACT_PLAY_8BIT:
+      status = PlaySample( tone8, TONE_FRAMES, TONE_RATE, 8U, Mode_mono );
+      break;
+    case ACT_PLAY_LOOPED:
+      status = PlaySampleLooped( tone16, TONE_FRAMES, TONE_RATE, 16U, Mode_mono,
+                                 TONE_FRAMES / 4U, TONE_FRAMES / 2U, AUDIO_ENGINE_LOOP_FOREVER );
+      break;
+    case ACT_STOP:
+      status = StopPlayback();
+      break;
+    case ACT_PAUSE:
+      status = PausePlayback();
+      break;
+    case ACT_RESUME:
+      status = ResumePlayback();
+      break;
+    case ACT_SHUTDOWN:
+      ShutDownAudio();
+      break;
+    case ACT_WAIT_END:
+      waiting         = 1U;
+      wait_interrupts = 0U;
+      status          = WaitForSampleEnd();
+      waiting         = 0U;
+      break;
+    case ACT_FADERS:
+      SetFadersEnabled( (uint8_t)( Random() & 1U ) );
+      break;
+    default:
+      break;
+  }
+  const uint64_t ns    = NowNs() - start - interrupt_ns;
+  const uint8_t  after = (uint8_t)GetPlaybackState();
+
+  RecordCost( &action_cost[ action ], ns, before );
+  if( status == PB_Error && ( action == ACT_STOP || action == ACT_PAUSE || action == ACT_RESUME ) ) {
+    queue_full++;
+  }
+
+  /* The state the interrupts inside the call left, against what the call itself may do */
+  if( after >= STATE_COUNT ) {
+    Violation( "state out of range after a control call" );
+  }
+  switch( action ) {
+    case ACT_PLAY_16BIT:
+    case ACT_PLAY_8BIT:
+    case ACT_PLAY_LOOPED:
+      if( status == PB_Playing && !PlaybackActive( after ) && after != PB_Idle ) {
+        Violation( "PlaySample() accepted but the playback is not running" );
+      }
+      if( status == PB_Playing ) {
+        expect_stop.active = expect_pause.active = expect_resume.active = 0U;
+        looping            = ( action == ACT_PLAY_LOOPED ) ? 1U : 0U;
+      }
+      break;
+    case ACT_SHUTDOWN:
+      if( after != PB_Idle || hi2s2.State == HAL_I2S_STATE_BUSY_TX ) {
+        Violation( "ShutDownAudio() left the engine running" );
+      }
+      break;
+    case ACT_WAIT_END:
+      if( PlaybackActive( after ) ) {
+        Violation( "WaitForSampleEnd() returned with the playback active" );
+      }
+      break;
+    default:
+      if( after != last_state ) {
+        Violation( "a queued control call changed the state itself" );
+      }
+      break;
+  }
+  last_state = after;
+
+  if( action == ACT_STOP && status != PB_Error && PlaybackActive( after ) ) {
+    Expect( &expect_stop, "StopPlayback()" );
+  } else if( action == ACT_PAUSE && status == PB_Pausing && !expect_stop.active ) {
+    Expect( &expect_pause, "PausePlayback()" );
+    expect_resume.active = 0U;
+  } else if( action == ACT_RESUME && status == PB_Playing && PlaybackActive( after ) && !expect_stop.active ) {
+    Expect( &expect_resume, "ResumePlayback()" );
+    expect_pause.active = 0U;
+  }
+  CheckInvariants();
+
+  if( verbose ) {
+    printf( "%8llu %-18s %-13s -> %-13s status %d\n", (unsigned long long)step, action_names[ action ],
+            state_names[ before < STATE_COUNT ? before : 0 ], state_names[ after < STATE_COUNT ? after : 0 ], (int)status );
+  }
+}
+
+
+static void PrintCost( const char *name, const Cost *cost )
+{
+  printf( "  %-34s %9llu %9.2f %9.2f  %-13s %llu\n", name, (unsigned long long)cost->calls,
+          cost->calls ? (double)cost->total_ns / (double)cost->calls / 1000.0 : 0.0, (double)cost->max_ns / 1000.0,
+          state_names[ cost->max_state ], (unsigned long long)cost->max_step );
+}
+
+
+static void PrintReport( uint64_t steps, uint64_t seed )
+{
+  printf( "%llu steps, seed %llu, %u%% preemption: %u interrupts inside control calls, %u queue-full refusals\n",
+          (unsigned long long)steps, (unsigned long long)seed, (unsigned)preempt_percent,
+          (unsigned)nested_interrupts, (unsigned)queue_full );
+
+  printf( "\n  %-34s %9s %9s %9s  %-13s %s\n", "control call (host us)", "calls", "mean", "max", "in state", "step" );
+  const Cost *worst = NULL;
+  Action     worst_action = ACT_INTERRUPT;
+  for( uint32_t a = 1; a < ACT_COUNT; a++ ) {
+    if( action_cost[ a ].calls != 0U ) {
+      PrintCost( action_names[ a ], &action_cost[ a ] );
+      if( a != ACT_WAIT_END && ( worst == NULL || action_cost[ a ].max_ns > worst->max_ns ) ) {
+        worst        = &action_cost[ a ];
+        worst_action = (Action)a;
+      }
+    }
+  }
+
+  printf( "\n  %-34s %9s %9s %9s  %-13s %s\n", "interrupt by state change", "calls", "mean", "max", "from", "step" );
+  for( uint32_t from = 0; from < STATE_COUNT; from++ ) {
+    for( uint32_t to = 0; to < STATE_COUNT; to++ ) {
+      if( interrupt_cost[ from ][ to ].calls != 0U ) {
+        char name[ 40 ];
+        snprintf( name, sizeof( name ), "%s -> %s", state_names[ from ], state_names[ to ] );
+        PrintCost( name, &interrupt_cost[ from ][ to ] );
+      }
+    }
+  }
+
+  if( worst != NULL ) {
+    printf( "\nWorst control path: %s in %s, %.2f us on the host (step %llu)\n", action_names[ worst_action ],
+            state_names[ worst->max_state ], (double)worst->max_ns / 1000.0, (unsigned long long)worst->max_step );
+  }
+  printf( "%u violation%s\n", (unsigned)violations, violations == 1U ? "" : "s" );
+}
+
+
+int main( int argc, char **argv )
+{
+  uint64_t seed  = 1U;
+  uint64_t steps = 100000U;
+
+  for( int i = 1; i < argc; i++ ) {
+    if( strcmp( argv[ i ], "--seed" ) == 0 && i + 1 < argc ) {
+      seed = strtoull( argv[ ++i ], NULL, 0 );
+    } else if( strcmp( argv[ i ], "--steps" ) == 0 && i + 1 < argc ) {
+      steps = strtoull( argv[ ++i ], NULL, 0 );
+    } else if( strcmp( argv[ i ], "--preempt" ) == 0 && i + 1 < argc ) {
+      preempt_percent = (uint32_t)strtoul( argv[ ++i ], NULL, 0 );
+    } else if( strcmp( argv[ i ], "--verbose" ) == 0 ) {
+      verbose = 1;
+    } else {
+      fprintf( stderr, "usage: %s [--seed N] [--steps N] [--preempt PCT] [--verbose]\n", argv[ 0 ] );
+      return 2;
+    }
+  }
+  rng_state = seed * 0x9E3779B97F4A7C15ULL + 1U;
+
+  for( uint32_t i = 0; i < TONE_FRAMES; i++ ) {
+    const float s = sinf( 2.0f * 3.14159265f * 440.0f * (float)i / (float)TONE_RATE );
+    tone16[ i ] = (int16_t)( s * 16000.0f );
+    tone8[ i ]  = (uint8_t)( 128.0f + s * 100.0f );
+  }
+
+  if( AudioEngine_Init( HostDACSwitch, HostReadVolume, HostI2SInit ) != PB_Idle ) {
+    fprintf( stderr, "AudioEngine_Init() failed\n" );
+    return 1;
+  }
+  host_preempt_hook = PreemptPoint;
+
+  for( step = 0; step < steps && violations <= MAX_VIOLATIONS; step++ ) {
+    RunAction( PickAction() );
+  }
+
+  host_preempt_hook = NULL;
+  PrintReport( step, seed );
+  return violations ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+Python bindings over the host-built audio engine (libaudio_engine_host, Host/Src/host_engine.c).
+
+render() plays a whole buffer through the engine's own fixed-point code in one call and returns
+the whole output, so a sweep over filter settings runs at native speed on the arithmetic the
+target runs.  frequency_response() measures the chain's magnitude response from an impulse.
+Buffers are numpy arrays when numpy is installed, and array('h') / array('i') otherwise; any
+int16 (or, for 8-bit input, uint8) buffer or sequence is accepted as input.
+
+The engine is a single instance, so an Engine must not be used from two threads at once.
+
+Usage:
+    cmake -S Host -B build/host && cmake --build build/host
+    Host/audio_engine_host.py build/host/libaudio_engine_host.so in.wav out.wav --lpf medium
+
+    from audio_engine_host import Engine
+    engine = Engine("build/host/libaudio_engine_host.so")
+    out = engine.render(samples, rate=22050, lpf="firm", faders=False)
+    freqs, db = engine.frequency_response(22050, lpf="medium")
+"""
+
+import argparse
+import array
+import ctypes
+import math
+import wave
+from pathlib import Path
+
+try:
+    import numpy as np
+except ImportError:                                        # Plain arrays without numpy
+    np = None
+
+LPF_LEVELS = ("off", "very-soft", "soft", "medium", "firm", "aggressive")
+
+
+class Settings(ctypes.Structure):
+    """HostEngine_Settings in Host/Inc/host_engine.h."""
+    _fields_ = [
+        ("lpf_level", ctypes.c_int32),
+        ("air_db", ctypes.c_float),
+        ("fade_in", ctypes.c_float),
+        ("fade_out", ctypes.c_float),
+        ("volume", ctypes.c_uint16),
+        ("air", ctypes.c_uint8),
+        ("noise_gate", ctypes.c_uint8),
+        ("soft_clip", ctypes.c_uint8),
+        ("hard_dc", ctypes.c_uint8),
+        ("faders", ctypes.c_uint8),
+    ]
+
+
+class Engine:
+    """The host-built engine loaded from libaudio_engine_host."""
+
+    def __init__(self, library):
+        self.lib = ctypes.CDLL(str(library))
+        self.lib.HostEngine_DefaultSettings.argtypes = [ctypes.POINTER(Settings)]
+        self.lib.HostEngine_OutputBits.restype = ctypes.c_uint32
+        self.lib.HostEngine_OutputRate.restype = ctypes.c_uint32
+        self.lib.HostEngine_Render.restype = ctypes.c_int64
+        self.lib.HostEngine_Render.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32,
+                                               ctypes.c_uint32, ctypes.POINTER(Settings), ctypes.c_void_p,
+                                               ctypes.c_uint64]
+        self.output_bits = self.lib.HostEngine_OutputBits()
+
+    def settings(self, lpf="soft", air_db=None, noise_gate=False, soft_clip=True, hard_dc=False, faders=True,
+                 fade_in=None, fade_out=None, volume=65535):
+        """HostEngine_Settings from keyword arguments; air_db None leaves the air effect off."""
+        s = Settings()
+        self.lib.HostEngine_DefaultSettings(ctypes.byref(s))
+        s.lpf_level = LPF_LEVELS.index(lpf)
+        s.air = air_db is not None
+        s.air_db = air_db or 0.0
+        s.noise_gate, s.soft_clip, s.hard_dc, s.faders = noise_gate, soft_clip, hard_dc, faders
+        s.fade_in = -1.0 if fade_in is None else fade_in
+        s.fade_out = -1.0 if fade_out is None else fade_out
+        s.volume = volume
+        return s
+
+    def render(self, samples, rate, channels=1, bits=16, **settings):
+        """Play interleaved samples through the engine; the interleaved stereo output at output_rate.
+
+        settings are those of settings().  The output is int16, or int32 with 32-bit output.
+        """
+        if np is not None:
+            data = np.ascontiguousarray(samples, dtype=np.int16 if bits == 16 else np.uint8)
+            count, pointer = data.size, data.ctypes.data
+        else:
+            data = array.array("h" if bits == 16 else "B", samples)
+            count, pointer = len(data), data.buffer_info()[0]
+        config = self.settings(**settings)
+
+        # Room for the output at up to 4x the input rate plus the fades, retried if short
+        capacity = 8 * count + 2 * 48000
+        while True:
+            out = self._buffer(capacity)
+            produced = self.lib.HostEngine_Render(pointer, count, rate, channels, bits, ctypes.byref(config),
+                                                  self._address(out), capacity)
+            if produced < 0:
+                raise ValueError("the engine refused the input")
+            if produced <= capacity:
+                return out[:produced]
+            capacity = produced
+
+    @property
+    def output_rate(self):
+        """Output rate of the last render."""
+        return self.lib.HostEngine_OutputRate()
+
+    def frequency_response(self, rate, lpf="soft", length=8192, amplitude=8192, bits=16, **settings):
+        """Magnitude response in dB of the chain at a rate, from an impulse; needs numpy.
+
+        The chain runs as set, with the faders and soft clipper off so the impulse passes
+        unchanged through them.  Returns the frequencies and the response, one per FFT bin.
+        """
+        if np is None:
+            raise RuntimeError("frequency_response() needs numpy")
+        lead = 64                                          # Silence first: the filters settle on zero
+        impulse = np.zeros(lead + length, dtype=np.int16 if bits == 16 else np.uint8)
+        if bits == 16:
+            impulse[lead] = amplitude
+        else:
+            impulse[:] = 128
+            impulse[lead] = 128 + min(127, amplitude >> 8)
+            amplitude = (impulse[lead] - 128) << 8
+        settings.setdefault("faders", False)
+        settings.setdefault("soft_clip", False)
+        out = self.render(impulse, rate, lpf=lpf, bits=bits, **settings)
+        left = np.asarray(out[0::2], dtype=np.float64)
+        if self.output_bits == 32:
+            left /= 65536.0
+        start = max(0, int(np.argmax(np.abs(left))) - lead)
+        response = np.fft.rfft(left[start:start + length], n=length) / amplitude
+        freqs = np.fft.rfftfreq(length, 1.0 / self.output_rate)
+        return freqs[1:], 20 * np.log10(np.maximum(np.abs(response[1:]), 1e-9))
+
+    def _buffer(self, count):
+        if np is not None:
+            return np.zeros(count, dtype=np.int32 if self.output_bits == 32 else np.int16)
+        return array.array("i" if self.output_bits == 32 else "h", bytes(count * self.output_bits // 8))
+
+    @staticmethod
+    def _address(buffer):
+        return buffer.ctypes.data if np is not None else buffer.buffer_info()[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("library", type=Path, help="libaudio_engine_host built from Host/CMakeLists.txt")
+    parser.add_argument("input", type=Path, help="8 or 16-bit PCM WAV file, mono or stereo")
+    parser.add_argument("output", type=Path, help="stereo WAV file at the output rate")
+    parser.add_argument("--lpf", choices=LPF_LEVELS, default="soft")
+    parser.add_argument("--air", type=float, metavar="DB", help="air effect gain (default: off)")
+    args = parser.parse_args()
+
+    with wave.open(str(args.input), "rb") as wav:
+        rate, channels, width = wav.getframerate(), wav.getnchannels(), wav.getsampwidth()
+        data = wav.readframes(wav.getnframes())
+    samples = array.array("h", data) if width == 2 else array.array("B", data)
+    engine = Engine(args.library)
+    out = engine.render(samples, rate, channels, 8 * width, lpf=args.lpf, air_db=args.air)
+    with wave.open(str(args.output), "wb") as wav:
+        wav.setnchannels(2)
+        wav.setsampwidth(engine.output_bits // 8)
+        wav.setframerate(engine.output_rate)
+        wav.writeframes(bytes(out) if np is None else out.tobytes())
+    print(f"{args.output}: {len(out) // 2} frames at {engine.output_rate} Hz")
+
+
+if __name__ == "__main__":
+    main()
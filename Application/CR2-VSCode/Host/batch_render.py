@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+Batch offline render of sound headers or WAV files through a set of presets, on all host cores.
+
+Every source is rendered through every preset by host_render, one job per pair spread over a
+pool of worker processes, one per core by default.  Each job runs its own host_render, so each
+has an engine instance of its own (the engine keeps its state in statics, so one process per
+engine is what keeps the jobs apart), and measures its render in the worker, where the
+loudness analysis does not wait on the other jobs.  The renders go to
+<out>/<source>/<preset>.wav, and report.csv next to them gives the loudness
+(Tools/measure_loudness.py), the peak, the samples at full scale and the length of each, so a
+content QA pass over the whole library takes as long as the jobs divided by the cores.
+
+A sound header carries no rate or channel count: they are read from the name where it has
+them (22k, 44k, 1c, 2c ...), else --rate and --channels apply, and --format NAME=RATE[:CHANNELS]
+overrides a source.  The bit depth comes from the array type.  The presets are host_render
+option sets; --preset NAME="OPTIONS" adds or replaces one.
+
+Usage:
+    cmake -S Host -B build/host && cmake --build build/host
+    Host/batch_render.py build/host/host_render -o build/qa
+    Host/batch_render.py build/host/host_render Core/Inc/sound_headers/guitar.h chime.wav \\
+        --presets off,medium --preset loud="--lpf firm --air 4" -o build/qa
+"""
+
+import argparse
+import csv
+import math
+import os
+import re
+import shlex
+import struct
+import subprocess
+import sys
+import tempfile
+import wave
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent / "Tools"))
+from make_silence_map import ARRAY_RE, read_samples  # noqa: E402
+from measure_loudness import loudness  # noqa: E402
+
+SOUND_HEADERS = Path(__file__).resolve().parent.parent / "Core" / "Inc" / "sound_headers"
+
+# (name, host_render options)
+PRESETS = {
+    "off": ["--lpf", "off"],
+    "soft": ["--lpf", "soft"],
+    "medium": ["--lpf", "medium"],
+    "firm_air": ["--lpf", "firm", "--air", "3"],
+    "gate": ["--lpf", "soft", "--noise-gate"],
+}
+
+RATES = {"8k": 8000, "11k": 11025, "16k": 16000, "22k": 22050, "32k": 32000, "44k": 44100, "48k": 48000}
+NAME_RATE_RE = re.compile(r"(8|11|16|22|32|44|48)k(?![a-z])")
+NAME_CHANNELS_RE = re.compile(r"([12])c(?![a-z])")
+
+
+def header_format(path, rate, channels, overrides):
+    """Rate and channels of a sound header, from the overrides, its name or the defaults."""
+    stem = path.stem
+    if stem in overrides:
+        return overrides[stem]
+    match = NAME_RATE_RE.search(stem.lower())
+    if match:
+        rate = RATES[match.group(1) + "k"]
+    match = NAME_CHANNELS_RE.search(stem.lower())
+    if match:
+        channels = int(match.group(1))
+    return rate, channels
+
+
+def header_to_wav(path, out, rate, channels):
+    """Write a sound header's array as a WAV file host_render can play."""
+    text = path.read_text(errors="replace")
+    match = ARRAY_RE.search(text)
+    if match is None:
+        raise ValueError("no sample array found")
+    depth = 16 if match.group(1) != "uint8_t" or re.search(r"_LITTLE_ENDIAN\b", text) else 8
+    _, samples = read_samples(text, depth)
+    samples = samples[:len(samples) - len(samples) % channels]
+    with wave.open(str(out), "wb") as wav:
+        wav.setnchannels(channels)
+        wav.setframerate(rate)
+        if depth == 16:
+            wav.setsampwidth(2)
+            wav.writeframes(struct.pack(f"<{len(samples)}h", *samples))
+        else:
+            wav.setsampwidth(1)
+            wav.writeframes(bytes((v >> 8) + 128 for v in samples))
+
+
+def analyse(path):
+    """Loudness, peak dBFS, samples at full scale and seconds of a host_render output file."""
+    with wave.open(str(path), "rb") as wav:
+        width, rate, channels = wav.getsampwidth(), wav.getframerate(), wav.getnchannels()
+        data = wav.readframes(wav.getnframes())
+    shift = 16 if width == 4 else 0                       # 32-bit output: the top 16 bits
+    samples = [v[0] >> shift for v in struct.iter_unpack("<h" if width == 2 else "<i", data)]
+    peak = max((abs(v) for v in samples), default=0)
+    value = loudness(samples, channels, rate)
+    return {
+        "loudness_lufs": f"{value:.1f}" if value is not None else "",
+        "peak_dbfs": f"{20 * math.log10(peak / 32768):.1f}" if peak else "",
+        "full_scale": sum(1 for v in samples if v >= 32767 or v <= -32768),
+        "seconds": f"{len(samples) / channels / rate:.2f}",
+    }
+
+
+def convert(source, wav, rate, channels):
+    """One job: a sound header to a WAV file, None or the error."""
+    try:
+        header_to_wav(source, wav, rate, channels)
+    except (ValueError, OSError) as error:
+        return str(error)
+    return None
+
+
+def render(host_render, source, options, out):
+    """One job: render source through a preset's options and analyse the result."""
+    out.parent.mkdir(parents=True, exist_ok=True)
+    result = subprocess.run([str(host_render), str(source), str(out), *options], capture_output=True, text=True)
+    if result.returncode != 0:
+        return {"error": result.stderr.strip() or f"host_render exited with {result.returncode}"}
+    return analyse(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host_render", type=Path, help="host_render built from Host/CMakeLists.txt")
+    parser.add_argument("sources", type=Path, nargs="*",
+                        help="sound headers or WAV files (default: every header in Core/Inc/sound_headers)")
+    parser.add_argument("-o", "--output", type=Path, required=True, help="directory for the renders and report.csv")
+    parser.add_argument("--presets", default=",".join(PRESETS),
+                        help=f"comma-separated presets to render (default: {','.join(PRESETS)})")
+    parser.add_argument("--preset", action="append", default=[], metavar='NAME="OPTIONS"',
+                        help="define a preset from host_render options")
+    parser.add_argument("--rate", type=int, default=22050, help="rate of a header whose name has none (default: 22050)")
+    parser.add_argument("--channels", type=int, choices=(1, 2), default=1,
+                        help="channels of a header whose name has none (default: 1)")
+    parser.add_argument("--format", action="append", default=[], metavar="NAME=RATE[:CHANNELS]",
+                        help="rate and channels of the header NAME.h")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1,
+                        help="jobs run at once (default: the host's cores)")
+    args = parser.parse_args()
+
+    presets = dict(PRESETS)
+    for spec in args.preset:
+        name, _, options = spec.partition("=")
+        presets[name] = shlex.split(options)
+    wanted = [name for name in args.presets.split(",") if name] + [spec.partition("=")[0] for spec in args.preset]
+    wanted = list(dict.fromkeys(wanted))
+    unknown = [name for name in wanted if name not in presets]
+    if unknown:
+        raise SystemExit(f"unknown preset {', '.join(unknown)}")
+    overrides = {}
+    for spec in args.format:
+        name, _, fmt = spec.partition("=")
+        rate, _, channels = fmt.partition(":")
+        overrides[name] = (int(rate), int(channels or args.channels))
+
+    sources = args.sources or sorted(SOUND_HEADERS.glob("*.h"))
+    failures = []
+    rows = []
+    with tempfile.TemporaryDirectory() as tmp, ProcessPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        conversions = []
+        for source in sources:
+            if source.suffix.lower() == ".wav":
+                conversions.append((source, source, None))
+                continue
+            rate, channels = header_format(source, args.rate, args.channels, overrides)
+            wav = Path(tmp) / f"{source.stem}.wav"
+            conversions.append((source, wav, pool.submit(convert, source, wav, rate, channels)))
+
+        jobs = []
+        for source, wav, job in conversions:
+            error = job.result() if job else None
+            if error:
+                failures.append(f"{source}: {error}")
+                continue
+            for preset in wanted:
+                out = args.output / source.stem / f"{preset}.wav"
+                jobs.append((source.stem, preset, pool.submit(render, args.host_render, wav, presets[preset], out)))
+
+        for name, preset, job in jobs:
+            result = job.result()
+            if "error" in result:
+                failures.append(f"{name} / {preset}: {result['error']}")
+                continue
+            rows.append({"source": name, "preset": preset, **result})
+
+    args.output.mkdir(parents=True, exist_ok=True)
+    report = args.output / "report.csv"
+    with report.open("w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=["source", "preset", "loudness_lufs", "peak_dbfs", "full_scale", "seconds"])
+        writer.writeheader()
+        writer.writerows(rows)
+
+    for failure in failures:
+        print(failure, file=sys.stderr)
+    print(f"{report}: {len(rows)} renders of {len(sources)} sources x {len(wanted)} presets")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Check an I2S loopback capture of the target against host renders.
+
+The CR2-VSCode-loopback firmware (AUDIO_ENGINE_LOOPBACK_TEST, Core/Libraries/i2s_loopback.c)
+plays a set of test cases on a jig that wires I2S2 back into SPI3, and prints over SWO each
+case's host_render options with the length, first non-silent frame and segment CRC-32s of what
+the I2S actually sent.  This renders the same cases with host_render, from the same integer
+test inputs, and compares:
+
+  - the first non-silent frame: the start latency, to the frame;
+  - the frame count: a render that ran late or an early stop shows as a length difference;
+  - each segment's CRC: a difference locates a wrong sample to its segment.
+
+The host build must have the firmware's flags (bus rate, output width, stages compiled in);
+a case the capture flagged with late halves or with deadline underruns is reported, since its
+difference is the capture's or the render's timing, not the DSP.  Host and target compute the
+filter coefficients with their own float functions, so a rounding difference there can show
+as a mismatch too: a difference in every segment of one filter setting, with the start and
+length right, points there before it points at the stream.
+
+Usage:
+    Host/loopback_check.py build/host/host_render swo.log
+    Host/loopback_check.py build/host/host_render swo.log --save renders/
+"""
+
+import argparse
+import subprocess
+import sys
+import tempfile
+import wave
+import zlib
+from pathlib import Path
+
+
+def parse_log(text):
+    """Segment size and the cases of the last complete report in the log."""
+    segment = None
+    current = []
+    done = None
+    for line in text.splitlines():
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "LBK":
+            if fields[1:] == ["END"]:
+                done = (segment, current)
+            elif len(fields) == 3:
+                segment = int(fields[2])
+                current = []
+        elif fields[0] == "LBC" and len(fields) >= 6:
+            current.append({"name": fields[1], "rate": int(fields[2]), "channels": int(fields[3]),
+                            "bits": int(fields[4]), "frames": int(fields[5]), "options": fields[6:],
+                            "result": None, "crcs": {}})
+        elif fields[0] == "LBF" and current:
+            if len(fields) == 5:
+                current[-1]["result"] = [int(f) for f in fields[1:]]
+        elif fields[0] == "LBS" and current and len(fields) == 3:
+            current[-1]["crcs"][int(fields[1])] = int(fields[2], 16)
+    return done
+
+
+def test_input(rate, channels, bits, frames):
+    """Input bytes of a case, built as MakeTestInput() builds them on the target."""
+    out = bytearray()
+    phase, step, noise = 0, 0x01000000, 1
+    for n in range(frames):
+        for c in range(channels):
+            if n < frames // 2:
+                t = ((phase + c * 0x40000000) & 0xFFFFFFFF) >> 16
+                v = (((t if t < 32768 else 65535 - t) * 2 - 32767) * 23) >> 5
+            elif n < frames * 3 // 4:
+                v = 32767 if (n // (7 + 5 * c)) & 1 else -32767
+            else:
+                noise = (noise * 1664525 + 1013904223) & 0xFFFFFFFF
+                v = ((noise >> 16) & 127) - 64
+            out += v.to_bytes(2, "little", signed=True) if bits == 16 else bytes([(v >> 8) + 128])
+        phase = (phase + step) & 0xFFFFFFFF
+        step = (step + 0x8000) & 0xFFFFFFFF
+    return bytes(out)
+
+
+def first_audible(data, frame_bytes):
+    for i in range(0, len(data), frame_bytes):
+        if any(data[i:i + frame_bytes]):
+            return i // frame_bytes
+    return -1
+
+
+def check_case(case, segment, host_render, work):
+    """Differences between a captured case and its host render, as lines of text."""
+    if case["result"] is None:
+        return ["no capture result in the log"]
+    captured, first, late, underruns = case["result"]
+    src = work / f"{case['name']}_in.wav"
+    out = work / f"{case['name']}.wav"
+    with wave.open(str(src), "wb") as wav:
+        wav.setnchannels(case["channels"])
+        wav.setsampwidth(case["bits"] // 8)
+        wav.setframerate(case["rate"])
+        wav.writeframes(test_input(case["rate"], case["channels"], case["bits"], case["frames"]))
+    result = subprocess.run([str(host_render), str(src), str(out), *case["options"]], capture_output=True, text=True)
+    if result.returncode != 0:
+        return [f"host_render failed: {result.stderr.strip()}"]
+    with wave.open(str(out), "rb") as wav:
+        frame_bytes = wav.getsampwidth() * wav.getnchannels()
+        data = wav.readframes(wav.getnframes())
+
+    problems = []
+    if late or underruns:
+        problems.append(f"capture not trusted: {late} late halves, {underruns} underruns")
+    rendered = len(data) // frame_bytes
+    host_first = first_audible(data, frame_bytes)
+    if first != host_first:
+        problems.append(f"first audio at frame {first}, host {host_first}")
+    if captured != rendered:
+        problems.append(f"{captured} frames captured, host {rendered}")
+    data += bytes(max(0, captured - rendered) * frame_bytes)  # The capture runs on in silence
+    for index in sorted(case["crcs"]):
+        start = index * segment
+        chunk = data[start * frame_bytes:min(captured, start + segment) * frame_bytes]
+        if zlib.crc32(chunk) != case["crcs"][index]:
+            problems.append(f"segment {index} (frames {start}-{min(captured, start + segment) - 1}) differs")
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host_render", type=Path, help="host_render built with the firmware's flags")
+    parser.add_argument("log", type=Path, help="SWO viewer log of the loopback firmware")
+    parser.add_argument("--save", type=Path, metavar="DIR", help="keep the inputs and host renders in DIR")
+    args = parser.parse_args()
+
+    report = parse_log(args.log.read_text(errors="replace"))
+    if report is None or report[0] is None:
+        sys.exit("No complete LBK report in the log")
+    segment, cases = report
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        work = args.save or Path(tmp)
+        work.mkdir(parents=True, exist_ok=True)
+        for case in cases:
+            problems = check_case(case, segment, args.host_render, work)
+            failed += bool(problems)
+            print(f"{case['name']}: " + ("; ".join(problems) if problems else "bit-exact"))
+    print(f"{len(cases) - failed}/{len(cases)} cases match")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+Golden-output regression check of the audio engine on the host build.
+
+Renders a fixed matrix of test inputs x filter configurations x fade settings through
+host_render and compares the output with the SHA-256 hashes in Host/golden.sha256, so a
+refactor that should be bit-exact (block processing, DSP-extension kernels, RAM placement)
+is checked over the whole matrix in seconds.  The inputs are synthesised here: a chirp, a
+full-scale square burst that drives the soft clipper, and a low-level tail for the noise gate,
+at 8 and 16 bits, mono and stereo, at several rates.
+
+A build with different flags that should render the same, such as the constant-time kernels,
+is checked with --match: every case is rendered by both host_render binaries and compared
+byte for byte.
+
+A change that is meant to alter the output is checked against a reference render instead:
+render the matrix from the old tree with --save, then check the new tree with --reference and
+a minimum SNR.  After such a change, --update rewrites the golden hashes.
+
+The hashes are for the default host build (Release, DSP-extension kernels on) on x86-64 with
+glibc; the coefficient setup uses the C library's float functions, so other hosts may need
+their own hashes or the SNR check.
+
+Usage:
+    cmake -S Host -B build/host && cmake --build build/host
+    Host/regress.py build/host/host_render
+    Host/regress.py build/host/host_render --save ref/          # Before an intended change
+    Host/regress.py build/host/host_render --reference ref/ --snr 90
+    Host/regress.py build/host/host_render --update
+    Host/regress.py build/host/host_render --match build/host/host_render_ct
+"""
+
+import argparse
+import hashlib
+import math
+import struct
+import subprocess
+import sys
+import tempfile
+import wave
+from pathlib import Path
+
+GOLDEN = Path(__file__).with_name("golden.sha256")
+
+# (name, rate, channels, bits)
+INPUTS = [
+    ("m16_22k", 22050, 1, 16),
+    ("s16_44k", 44100, 2, 16),
+    ("s8_16k", 16000, 2, 8),
+    ("m8_11k", 11025, 1, 8),
+]
+
+# (name, host_render options)
+FILTERS = [
+    ("lpf_off", ["--lpf", "off"]),
+    ("lpf_soft", ["--lpf", "soft"]),
+    ("lpf_aggr", ["--lpf", "aggressive"]),
+    ("air", ["--lpf", "medium", "--air", "3"]),
+    ("gate_hard", ["--lpf", "firm", "--noise-gate", "--hard-dc", "--no-soft-clip"]),
+    ("comp", ["--lpf", "soft", "--compress", "-18"]),
+]
+
+FADES = [
+    ("fade_def", []),
+    ("fade_short", ["--fade-in", "0.01", "--fade-out", "0.02"]),
+    ("fade_long", ["--fade-in", "0.3", "--fade-out", "0.3"]),
+    ("no_fade", ["--no-faders"]),
+]
+
+
+def test_signal(rate, channels, seconds=0.6):
+    """Interleaved samples in -1..1: chirp, full-scale square burst, then a low-level tail."""
+    frames = int(rate * seconds)
+    out = []
+    for n in range(frames):
+        t = n / rate
+        if t < 0.3:
+            f = 100.0 + (rate * 0.45 - 100.0) * t / 0.3
+            v = [0.7 * math.sin(2 * math.pi * f * t * 0.5 + c * 0.5) for c in range(channels)]
+        elif t < 0.45:
+            v = [1.0 if (n // (7 + 5 * c)) % 2 else -1.0 for c in range(channels)]
+        else:
+            v = [0.002 * math.sin(2 * math.pi * 440.0 * t + c) for c in range(channels)]
+        out.extend(v)
+    return out
+
+
+def write_input(path, rate, channels, bits):
+    samples = test_signal(rate, channels)
+    if bits == 16:
+        data = struct.pack(f"<{len(samples)}h", *(max(-32768, min(32767, round(v * 32767))) for v in samples))
+    else:
+        data = bytes(max(0, min(255, 128 + round(v * 127))) for v in samples)
+    with wave.open(str(path), "wb") as wav:
+        wav.setnchannels(channels)
+        wav.setsampwidth(bits // 8)
+        wav.setframerate(rate)
+        wav.writeframes(data)
+
+
+def cases():
+    for name, rate, channels, bits in INPUTS:
+        for filter_name, filter_opts in FILTERS:
+            for fade_name, fade_opts in FADES:
+                yield f"{name}-{filter_name}-{fade_name}", name, filter_opts + fade_opts
+
+
+def read_output(path):
+    """Samples of a host_render output file, 16 or 32-bit, as integers."""
+    with wave.open(str(path), "rb") as wav:
+        width = wav.getsampwidth()
+        data = wav.readframes(wav.getnframes())
+    return [v[0] for v in struct.iter_unpack("<h" if width == 2 else "<i", data)]
+
+
+def snr_db(reference, test):
+    """SNR of test against reference in dB, the shorter padded with silence."""
+    n = max(len(reference), len(test))
+    reference = reference + [0] * (n - len(reference))
+    test = test + [0] * (n - len(test))
+    signal = sum(v * v for v in reference)
+    noise = sum((a - b) ** 2 for a, b in zip(reference, test))
+    if noise == 0:
+        return math.inf
+    return 10.0 * math.log10(signal / noise) if signal else -math.inf
+
+
+def read_golden():
+    golden = {}
+    if GOLDEN.exists():
+        for line in GOLDEN.read_text().splitlines():
+            if line.strip():
+                digest, case = line.split()
+                golden[case] = digest
+    return golden
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host_render", type=Path, help="host_render built from Host/CMakeLists.txt")
+    parser.add_argument("--update", action="store_true", help="rewrite Host/golden.sha256 from this build")
+    parser.add_argument("--save", type=Path, metavar="DIR", help="also keep the rendered files in DIR")
+    parser.add_argument("--reference", type=Path, metavar="DIR",
+                        help="compare with the renders in DIR (from --save) by SNR instead of the golden hashes")
+    parser.add_argument("--snr", type=float, default=90.0, metavar="DB",
+                        help="minimum SNR against --reference (default: 90 dB)")
+    parser.add_argument("--filter", metavar="TEXT", help="only the cases whose name contains TEXT")
+    parser.add_argument("--match", type=Path, metavar="HOST_RENDER",
+                        help="compare with the renders of another host_render build instead of the golden hashes")
+    args = parser.parse_args()
+
+    golden = read_golden()
+    digests = {}
+    failures = []
+    run = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        tmp = Path(tmp)
+        out_dir = args.save or tmp
+        out_dir.mkdir(parents=True, exist_ok=True)
+        for name, rate, channels, bits in INPUTS:
+            write_input(tmp / f"{name}.wav", rate, channels, bits)
+
+        for case, input_name, opts in cases():
+            if args.filter and args.filter not in case:
+                continue
+            run += 1
+            out = out_dir / f"{case}.wav"
+            result = subprocess.run([str(args.host_render), str(tmp / f"{input_name}.wav"), str(out), *opts],
+                                    capture_output=True, text=True)
+            if result.returncode != 0:
+                failures.append(f"{case}: host_render failed: {result.stderr.strip()}")
+                continue
+            digests[case] = hashlib.sha256(out.read_bytes()).hexdigest()
+
+            if args.match:
+                other = tmp / f"{case}.match.wav"
+                result = subprocess.run([str(args.match), str(tmp / f"{input_name}.wav"), str(other), *opts],
+                                        capture_output=True, text=True)
+                if result.returncode != 0:
+                    failures.append(f"{case}: {args.match.name} failed: {result.stderr.strip()}")
+                elif other.read_bytes() != out.read_bytes():
+                    failures.append(f"{case}: output differs from {args.match.name}")
+            elif args.reference:
+                ref = args.reference / f"{case}.wav"
+                if not ref.exists():
+                    failures.append(f"{case}: no reference render")
+                    continue
+                snr = snr_db(read_output(ref), read_output(out))
+                if snr < args.snr:
+                    failures.append(f"{case}: SNR {snr:.1f} dB")
+            elif not args.update:
+                if case not in golden:
+                    failures.append(f"{case}: no golden hash")
+                elif golden[case] != digests[case]:
+                    failures.append(f"{case}: output differs from golden")
+
+    for failure in failures:
+        print(failure, file=sys.stderr)
+    if args.update:
+        if failures:
+            return 1
+        golden.update(digests)
+        GOLDEN.write_text("".join(f"{golden[c]}  {c}\n" for c in sorted(golden)))
+        print(f"{GOLDEN}: {len(digests)} of {len(golden)} cases updated")
+        return 0
+    print(f"{run - len(failures)}/{run} cases passed")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Apply the static part of an engine preset to samples offline, as the engine would at run time.
+
+The 16-bit biquad LPF (or, for an 8-bit asset, the one-pole LPF) with its makeup gain, the DC
+blocker and the air effect are worked out here in the engine's own fixed-point arithmetic,
+starting from the steady state of the first sample as SettleFilterState() does.  make_asset.py
+--bake stores the result and marks the asset AUDIO_ASSET_BAKED, and the engine then skips those
+stages for it; the compressor, EQ, speaker FIR, noise gate, soft clipper, volume and fades still
+run.  The options are make_preset.py's, so the same option string makes the preset and bakes
+the asset; the output rate is the asset's own rate.
+
+Usage:
+    bake_filters.py chime.wav chime_baked.wav --lpf16 medium --air-db 2     # To audition
+    make_asset.py chime.wav --bake "--lpf16 medium --air-db 2" -o chime_asset.h
+"""
+
+import argparse
+import math
+import shlex
+import struct
+import wave
+from pathlib import Path
+
+from make_coeff_tables import defines
+from make_preset import AIR_EFFECT_SHELF_GAIN_MAX, add_options, alpha_16bit, alpha_8bit, gain_q16, q16
+
+ENGINE_HEADER = Path(__file__).resolve().parent.parent / "Core" / "Libraries" / "audio_engine.h"
+LEVEL_MACROS = {"very-soft": "VERY_SOFT", "soft": "SOFT", "medium": "MEDIUM", "firm": "FIRM", "aggressive": "AGGRESSIVE"}
+LPF_16BIT_ALPHA_MAX = 65534
+AIR_EFFECT_FREQ_HZ = 4900
+
+
+def ssat16(value):
+    return max(-32768, min(32767, value))
+
+
+def cdiv(a, b):
+    """C integer division, truncating towards zero."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def parse_options(text):
+    """make_preset.py options from a string, as for make_asset.py --bake."""
+    parser = argparse.ArgumentParser(prog="--bake", add_help=False)
+    add_options(parser)
+    return parser.parse_args(shlex.split(text))
+
+
+def settings(options, rate, depth, header=ENGINE_HEADER):
+    """The fixed-point coefficients of the static stages for an asset; None for a stage left out."""
+    values = defines(Path(header).read_text())
+    if depth == 8:
+        level, cutoff, makeup = options.lpf8, options.lpf8_cutoff, options.lpf8_makeup
+        alpha = alpha_8bit(cutoff, rate) if cutoff is not None else \
+            None if level == "off" else values[f"LPF_{LEVEL_MACROS[level]}"]
+    else:
+        level, cutoff, makeup = options.lpf16, options.lpf16_cutoff, options.lpf16_makeup
+        alpha = min(LPF_16BIT_ALPHA_MAX, alpha_16bit(cutoff, rate)) if cutoff is not None else \
+            None if level == "off" else values[f"LPF_16BIT_{LEVEL_MACROS[level]}"]
+    air = None
+    if options.air_db is not None:
+        air_hz = values.get("AIR_EFFECT_FREQ_HZ", AIR_EFFECT_FREQ_HZ)
+        air_alpha = min(32767, int((1.0 - math.exp(-2.0 * math.pi * air_hz / rate)) * 32768.0 + 0.5))
+        gain = min(AIR_EFFECT_SHELF_GAIN_MAX, q16(10.0 ** (options.air_db / 20.0)))
+        air = (air_alpha, cdiv(gain - 65536, 2))
+    return {
+        "depth": depth,
+        "lpf_alpha": alpha,
+        "makeup_q16": gain_q16(makeup),
+        "dc_alpha": values["DC_FILTER_ALPHA"] if options.hard_dc else values["SOFT_DC_FILTER_ALPHA"],
+        "air": air,
+    }
+
+
+def bake_channel(samples, config, first):
+    """One channel through the LPF, DC blocker and air effect, as the engine's kernels."""
+    makeup, alpha = config["makeup_q16"], config["lpf_alpha"]
+    out = []
+
+    # SettleFilterState(): the LPF holds the first sample's DC output, the DC blocker outputs nothing
+    lpf_out = first
+    if alpha is not None and config["depth"] == 16:
+        b0 = ((65536 - alpha) * (65536 - alpha)) >> 17
+        b1, b2, a1, a2 = b0 << 1, b0, -(alpha * 2), (alpha * alpha) >> 16
+        den = 65536 + a1 + a2
+        x1 = x2 = first
+        y1 = y2 = cdiv((b0 + b1 + b2) * first, den) if den > 0 else 0
+        lpf_out = ssat16((y1 * makeup) >> 16)
+    elif alpha is not None:
+        den = (65536 << 16) - (65536 - alpha) * makeup
+        y1 = ssat16(cdiv(alpha * makeup * first, den)) if den > 0 else 0
+        lpf_out = y1
+    dc_in, dc_out = lpf_out, 0
+    dc_alpha = config["dc_alpha"]
+    air_alpha, boost = config["air"] or (0, 0)
+    air_lp = 0
+
+    for x in samples:
+        if alpha is not None and config["depth"] == 16:
+            y = (b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2) >> 16
+            x2, x1, y2, y1 = x1, x, y1, y
+            x = ssat16((y * makeup) >> 16)
+        elif alpha is not None:
+            y = ((alpha * x) >> 16) + (((65536 - alpha) * y1) >> 16)
+            y1 = ssat16((y * makeup) >> 16)
+            x = y1
+        y = ssat16(x - dc_in + ((dc_out * dc_alpha) >> 16))
+        dc_in, dc_out, x = x, y, y
+        if config["air"] is not None:
+            air_lp += (air_alpha * (x - air_lp) + (1 << 14)) >> 15
+            x = ssat16(x + ((boost * (x - air_lp)) >> 15))
+        out.append(x)
+    return out
+
+
+def bake(samples, channels, config):
+    """Interleaved samples through the static stages, each channel with its own state.
+
+    Both channels start settled on the first (left) sample, the asset's warmup_sample, as in the engine.
+    """
+    out = list(samples)
+    for ch in range(channels):
+        out[ch::channels] = bake_channel(samples[ch::channels], config, samples[0] if samples else 0)
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", type=Path, help="8 or 16-bit PCM WAV file, mono or stereo")
+    parser.add_argument("output", type=Path, help="16-bit WAV file with the static stages applied")
+    add_options(parser)
+    args = parser.parse_args()
+
+    from make_asset import read_wav                      # make_asset imports this module
+    rate, channels, samples = read_wav(args.input)
+    with wave.open(str(args.input), "rb") as wav:
+        depth = 8 * wav.getsampwidth()
+    baked = bake(samples[:len(samples) - len(samples) % channels], channels, settings(args, rate, depth))
+    with wave.open(str(args.output), "wb") as wav:
+        wav.setnchannels(channels)
+        wav.setsampwidth(2)
+        wav.setframerate(rate)
+        wav.writeframes(struct.pack(f"<{len(baked)}h", *baked))
+    print(f"{args.output}: {len(baked) // channels} frames baked at {rate} Hz")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""
+Find sound assets that are rate, depth or channel variants of another.
+
+A library grows lower variants of its sounds for smaller builds: doors_closing and
+doors_closing11k, big_gong, big_gong8b16k and big_gong8b1c11k.  Each is the master resampled,
+requantised or mixed down, and the engine derives it at play time from the master anyway: 8-bit
+data plays on the 16-bit path, and with AUDIO_ENGINE_BUS_RATE the resampler converts any source
+rate, so the variant's data is flash spent twice on one sound.  This compares every pair of
+inputs and reports each variant with the master it derives from and the bytes it would reclaim;
+add_audio_asset(... VARIANT_OF <master>) then builds the variant as a descriptor of the master's
+data (Tools/make_asset.py --variant-of, which runs the same check).
+
+A pair is compared when the variant has no higher rate, depth or channel count than the master.
+Their 10 ms loudness envelopes find where the variant lies in the master (a variant may be
+trimmed); the master is then low-passed and resampled to the variant's rate, mixed to mono like
+it, and correlated with it sample by sample around that offset.  A correlation of
+MATCH_THRESHOLD or more, about 13 dB of difference left, counts as derived: resampling and 8-bit
+quantisation leave far less, a different take of a sound far more.
+
+Inputs are WAV files, or the sound headers of Core/Inc/sound_headers, whose format is read from
+the array and file names (16b, 1c, 11k, ...); a header with no rate in its names is tried at each
+standard rate.  --rate gives one instead.
+
+Usage:
+    find_asset_variants.py Core/Inc/sound_headers/*.h
+    find_asset_variants.py sounds/*.wav --threshold 0.98
+    find_asset_variants.py Core/Inc/sound_headers/*.h --rate newchallenger.h=44100
+"""
+
+import argparse
+import math
+import re
+from pathlib import Path
+
+from make_asset import read_wav
+from make_silence_map import read_samples
+
+MATCH_THRESHOLD = 0.975
+STANDARD_RATES = (8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000)
+RATE_TOKENS = {"8": 8000, "11": 11025, "16": 16000, "22": 22050, "24": 24000, "32": 32000, "44": 44100, "48": 48000}
+ENVELOPE_SECONDS = 0.01
+LOWPASS_TAPS = 31
+EXCERPT = 4096                      # Variant samples the fine offset search runs over
+MIN_LENGTH = 0.5                    # Shortest a trimmed variant may be, as a part of its master
+
+
+class Sound:
+    """One input as mono samples, full scale 32768, with the format it is stored in."""
+
+    def __init__(self, path, rates, depth, channels, mono, stored_bytes):
+        self.path = path
+        self.rates = rates          # The rate, or the standard rates when it is not known
+        self.depth = depth
+        self.channels = channels
+        self.mono = mono
+        self.bytes = stored_bytes
+        self.envelopes = {}
+
+    def envelope(self, rate):
+        """RMS of each ENVELOPE_SECONDS of the samples, taken at rate."""
+        if rate not in self.envelopes:
+            window = max(1, round(rate * ENVELOPE_SECONDS))
+            self.envelopes[rate] = [math.sqrt(sum(v * v for v in self.mono[i:i + window]) / window)
+                                    for i in range(0, len(self.mono) - window + 1, window)]
+        return self.envelopes[rate]
+
+    def describe(self, rate=None):
+        rate = rate or (self.rates[0] if len(self.rates) == 1 else None)
+        return (f"{self.depth}-bit {rate or '?'} Hz {'stereo' if self.channels == 2 else 'mono'}, "
+                f"{self.bytes} bytes")
+
+
+def mix_to_mono(samples, channels):
+    if channels == 1:
+        return list(samples)
+    return [(samples[i] + samples[i + 1]) / 2.0 for i in range(0, len(samples) - 1, 2)]
+
+
+def read_sound(path, rate=None):
+    """A WAV file or a sound header as a Sound."""
+    if path.suffix.lower() == ".wav":
+        wav_rate, channels, samples = read_wav(path)
+        depth = 8 if all(v & 0xFF == 0 for v in samples[:4096]) and max(samples, default=0) <= 32512 else 16
+        return Sound(path, (rate or wav_rate,), depth, channels, mix_to_mono(samples, channels),
+                     len(samples) * depth // 8)
+
+    text = path.read_text()
+    array = re.search(r"const\s+(uint8_t|uint16_t|int16_t)\s+(\w+)", text)
+    if array is None:
+        raise SystemExit(f"{path}: no sample array found")
+    names = f"{array.group(2)} {path.stem}".lower()
+    depth = 8 if array.group(1) == "uint8_t" else 16
+    channels = 2 if re.search(r"(?<!\d)2c", names) else 1
+    found = re.search(r"(?<!\d)(8|11|16|22|24|32|44|48)k", names)
+    rates = (rate,) if rate else (RATE_TOKENS[found.group(1)],) if found else STANDARD_RATES
+    _, samples = read_samples(text, depth)
+    samples = samples[:len(samples) - len(samples) % channels]
+    return Sound(path, rates, depth, channels, mix_to_mono(samples, channels), len(samples) * depth // 8)
+
+
+def correlation(a, b):
+    """Normalised correlation of two equally long sequences, about their means."""
+    n = len(a)
+    if n == 0:
+        return 0.0
+    ma, mb = sum(a) / n, sum(b) / n
+    num = sum((x - ma) * (y - mb) for x, y in zip(a, b))
+    den = math.sqrt(sum((x - ma) ** 2 for x in a) * sum((y - mb) ** 2 for y in b))
+    return num / den if den > 0.0 else 0.0
+
+
+def envelope_offset(master_env, variant_env):
+    """Envelope windows into the master where the variant lies best, and the correlation there."""
+    best = (0, -1.0)
+    need = max(1, int(0.8 * len(variant_env)))
+    for offset in range(-len(variant_env) // 10, len(master_env) - need + 1):
+        lo, hi = max(0, -offset), min(len(variant_env), len(master_env) - offset)
+        if hi - lo < need:
+            continue
+        c = correlation(master_env[offset + lo:offset + hi], variant_env[lo:hi])
+        best = max(best, (offset, c), key=lambda item: item[1])
+    return best
+
+
+def resample(mono, ratio):
+    """The samples at ratio times their rate: a windowed-sinc low-pass when going down, then
+    linear interpolation."""
+    if ratio < 1.0:
+        cutoff, half = 0.45 * ratio, LOWPASS_TAPS // 2
+        taps = [2 * cutoff * (1.0 if k == 0 else math.sin(2 * math.pi * cutoff * k) / (2 * math.pi * cutoff * k))
+                * (0.54 + 0.46 * math.cos(math.pi * k / (half + 1))) for k in range(-half, half + 1)]
+        gain = sum(taps)
+        padded = [0.0] * half + list(mono) + [0.0] * half
+        mono = [sum(t * padded[i + j] for j, t in enumerate(taps)) / gain for i in range(len(mono))]
+    out = []
+    for n in range(int(len(mono) * ratio)):
+        pos = n / ratio
+        i = int(pos)
+        frac = pos - i
+        nxt = mono[i + 1] if i + 1 < len(mono) else mono[i]
+        out.append(mono[i] + (nxt - mono[i]) * frac)
+    return out
+
+
+def compare(master, variant, master_rate, variant_rate):
+    """Correlation of the variant with the master brought to its rate, best offset found."""
+    if variant_rate > master_rate or variant.depth > master.depth or variant.channels > master.channels:
+        return 0.0
+    master_env = master.envelope(master_rate)
+    variant_env = variant.envelope(variant_rate)
+    if len(variant_env) < max(10, MIN_LENGTH * len(master_env)) or len(variant_env) > 1.1 * len(master_env) + 2:
+        return 0.0                                      # Too long or too short to be the same sound
+    offset, coarse = envelope_offset(master_env, variant_env)
+    if coarse < 0.9:
+        return coarse                                   # Not the same sound: no need to look closer
+
+    derived = resample(master.mono, variant_rate / master_rate)
+    window = round(variant_rate * ENVELOPE_SECONDS)
+    start = offset * window
+    loudest = max(range(len(variant_env)), key=variant_env.__getitem__)
+    first = max(0, min(loudest * window - EXCERPT // 2, len(variant.mono) - EXCERPT))
+    excerpt = variant.mono[first:first + EXCERPT]
+    best = (start, -1.0)
+    for lag in range(start - window, start + window + 1):
+        if first + lag < 0 or first + lag + len(excerpt) > len(derived):
+            continue
+        c = correlation(derived[first + lag:first + lag + len(excerpt)], excerpt)
+        best = max(best, (lag, c), key=lambda item: item[1])
+
+    lag = best[0]
+    lo, hi = max(0, -lag), min(len(variant.mono), len(derived) - lag)
+    return correlation(derived[lo + lag:hi + lag], variant.mono[lo:hi]) if hi - lo > 0 else 0.0
+
+
+def best_match(master, variant):
+    """The highest correlation over the rates the two may have, with those rates."""
+    best = (0.0, None, None)
+    for master_rate in master.rates:
+        for variant_rate in variant.rates:
+            if variant_rate > master_rate or (variant_rate, variant.depth, variant.channels) == \
+                    (master_rate, master.depth, master.channels) and len(master.rates) > 1:
+                continue
+            c = compare(master, variant, master_rate, variant_rate)
+            best = max(best, (c, master_rate, variant_rate), key=lambda item: item[0])
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("inputs", type=Path, nargs="+", help="WAV files or sound headers")
+    parser.add_argument("--threshold", type=float, default=MATCH_THRESHOLD,
+                        help=f"correlation a variant needs with its master (default {MATCH_THRESHOLD})")
+    parser.add_argument("--rate", action="append", default=[], metavar="FILE=HZ",
+                        help="rate of an input whose names do not give it")
+    args = parser.parse_args()
+
+    rates = {}
+    for item in args.rate:
+        name, _, hz = item.partition("=")
+        rates[name] = int(hz)
+    sounds = [read_sound(path, rates.get(path.name)) for path in args.inputs]
+
+    # Each variant goes to the largest master it derives from; a master is never itself a variant
+    sounds.sort(key=lambda s: s.bytes, reverse=True)
+    masters = {}
+    variant_of = {}
+    for i, variant in enumerate(sounds):
+        for master in sounds[:i]:
+            if master.path in variant_of:
+                continue
+            c, master_rate, variant_rate = best_match(master, variant)
+            if c >= args.threshold:
+                variant_of[variant.path] = master.path
+                masters.setdefault(master.path, (master, master_rate, []))[2].append((variant, variant_rate, c))
+                break
+
+    total = sum(s.bytes for s in sounds)
+    reclaimed = 0
+    for master, master_rate, variants in masters.values():
+        print(f"{master.path.name}: master, {master.describe(master_rate)}")
+        for variant, variant_rate, c in variants:
+            print(f"  {variant.path.name}: {variant.describe(variant_rate)}, correlation {c:.4f}")
+            reclaimed += variant.bytes
+    print(f"{len(variant_of)} variants of {len(masters)} masters: {reclaimed} of {total} bytes "
+          f"({100.0 * reclaimed / max(1, total):.1f}%) reclaimed by storing the masters only")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Convert a sound header in Core/Inc/sound_headers, or a 16-bit PCM WAV file, to IMA-ADPCM.
+
+The output header holds 4-bit IMA-ADPCM blocks in the WAV IMA layout, with
+--block-bytes bytes per channel per block (AUDIO_ENGINE_ADPCM_BLOCK_BYTES).  Play it with
+PlaySample( name_adpcm, NAME_ADPCM_SZ, rate, AUDIO_ENGINE_ADPCM_DEPTH, mode ).
+
+Usage:
+    make_adpcm_header.py Core/Inc/sound_headers/bong.h --channels 1
+    make_adpcm_header.py chime.wav -o Core/Inc/sound_headers/chime_adpcm.h
+"""
+
+import argparse
+import re
+import wave
+from pathlib import Path
+
+from make_silence_map import read_samples
+
+DEFAULT_BLOCK_BYTES = 256  # AUDIO_ENGINE_ADPCM_BLOCK_BYTES
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def encode_sample(sample, predictor, index):
+    """Return the 4-bit code for one sample and the decoder's new predictor and index."""
+    step = STEP_TABLE[index]
+    delta = sample - predictor
+    code = 8 if delta < 0 else 0
+    delta = abs(delta)
+    if delta >= step:
+        code |= 4
+        delta -= step
+    if delta >= step >> 1:
+        code |= 2
+        delta -= step >> 1
+    if delta >= step >> 2:
+        code |= 1
+
+    # Track exactly what the engine's decoder will reconstruct
+    diff = step >> 3
+    if code & 4:
+        diff += step
+    if code & 2:
+        diff += step >> 1
+    if code & 1:
+        diff += step >> 2
+    predictor = predictor - diff if code & 8 else predictor + diff
+    predictor = max(-32768, min(32767, predictor))
+    index = max(0, min(88, index + INDEX_TABLE[code & 7]))
+    return code, predictor, index
+
+
+def encode(samples, channels, block_bytes):
+    """Encode interleaved 16-bit samples into IMA-ADPCM blocks."""
+    block_frames = (block_bytes - 4) * 2 + 1
+    frames = len(samples) // channels
+    index = [0] * channels
+    out = bytearray()
+
+    for start in range(0, frames, block_frames):
+        count = min(block_frames, frames - start)
+        block = bytearray(block_bytes * channels)
+        predictor = [0] * channels
+        for c in range(channels):
+            first = samples[start * channels + c]
+            predictor[c] = first
+            block[c * 4:c * 4 + 4] = bytes([first & 0xFF, (first >> 8) & 0xFF, index[c], 0])
+        for c in range(channels):
+            for k in range(count - 1):
+                sample = samples[(start + 1 + k) * channels + c]
+                code, predictor[c], index[c] = encode_sample(sample, predictor[c], index[c])
+                pos = channels * 4 + (k >> 3) * channels * 4 + c * 4 + ((k & 7) >> 1)
+                block[pos] |= code << 4 if k & 1 else code
+        out += block
+    return out, frames * channels
+
+
+def read_wav(path):
+    with wave.open(str(path), "rb") as wav:
+        if wav.getsampwidth() != 2:
+            raise SystemExit("only 16-bit PCM WAV files are supported")
+        data = wav.readframes(wav.getnframes())
+        channels = wav.getnchannels()
+    samples = [int.from_bytes(data[i:i + 2], "little", signed=True) for i in range(0, len(data), 2)]
+    return path.stem, samples, channels
+
+
+def write_header(path, name, data, sample_count, block_bytes):
+    guard = f"_{name.upper()}_ADPCM_H"
+    size = f"{name.upper()}_ADPCM_SZ"
+    nbytes = f"{name.upper()}_ADPCM_BYTES"
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* {name} as IMA-ADPCM, {block_bytes} bytes per channel per block (AUDIO_ENGINE_ADPCM_BLOCK_BYTES) */",
+        f"#define {size} {sample_count}",
+        f"#define {nbytes} {len(data)}",
+        "",
+        f"const uint8_t {name}_adpcm[ {nbytes} ] __attribute__( ( aligned( 4 ) ) ) =",
+        "{",
+    ]
+    for i in range(0, len(data), 16):
+        row = ", ".join(f"0x{b:02X}" for b in data[i:i + 16])
+        lines.append(f"  {row}{',' if i + 16 < len(data) else ''}")
+    lines += ["};", "", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", type=Path, help="sound header or 16-bit WAV file")
+    parser.add_argument("--depth", type=int, choices=(8, 16), help="bits per sample of a header (default: from the array type)")
+    parser.add_argument("--channels", type=int, choices=(1, 2), default=1, help="1 for mono, 2 for stereo (headers only)")
+    parser.add_argument("--block-bytes", type=int, default=DEFAULT_BLOCK_BYTES,
+                        help="bytes per channel per block, matching AUDIO_ENGINE_ADPCM_BLOCK_BYTES")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <source>_adpcm.h)")
+    args = parser.parse_args()
+
+    if args.block_bytes < 8 or args.block_bytes % 4:
+        raise SystemExit("--block-bytes must be a multiple of 4, at least 8")
+
+    if args.source.suffix.lower() == ".wav":
+        name, samples, channels = read_wav(args.source)
+    else:
+        text = args.source.read_text()
+        depth = args.depth
+        if depth is None:
+            depth = 8 if re.search(r"const\s+uint8_t\s+\w+\s*\[", text) else 16
+        name, samples = read_samples(text, depth)
+        channels = args.channels
+
+    data, sample_count = encode(samples, channels, args.block_bytes)
+    output = args.output or args.source.with_name(args.source.stem + "_adpcm.h")
+    write_header(output, name, data, sample_count, args.block_bytes)
+    print(f"{output}: {sample_count} samples in {len(data)} bytes")
+
+
+if __name__ == "__main__":
+    main()
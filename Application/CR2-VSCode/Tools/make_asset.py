@@ -0,0 +1,450 @@
+#!/usr/bin/env python3
+"""
+Compile a WAV file into a sound asset header for the audio engine.
+
+The header holds the sample data, word aligned, and a const AudioAsset descriptor
+(<name>_asset) carrying the encoding, rate, channels, loop points, peak level and a silence
+map, so the format can no longer disagree with the data.  Loop points come from the WAV
+'smpl' chunk unless --loop is given.  The measured loudness (Tools/measure_loudness.py) lets the
+engine play every asset at AudioEngine_SetLoudnessTarget(); --loudness-target overrides that
+target for this asset.  The CMake step in cmake/sound_assets.cmake runs this
+for every file in SOUND_ASSET_WAVS.
+
+--id also registers the descriptor in the engine's linker-placed asset index.  --preset attaches an
+engine preset (Tools/make_preset.py) that PlayAsset() applies as the asset starts.
+
+--bake takes make_preset.py options and applies the static part of that preset, the LPF with its
+makeup gain, the DC blocker and the air effect, to the samples before they are encoded
+(Tools/bake_filters.py).  The asset is marked AUDIO_ASSET_BAKED and the engine skips those
+stages when it plays it, leaving the volume, fades, compressor, EQ, noise gate and soft clipper.
+
+--shape quantises a PCM8 asset with error feedback that moves the noise above the band a small
+speaker reproduces (Tools/shape_noise.py), optionally giving the order.  The asset is marked
+AUDIO_ASSET_SHAPED and the engine plays it without its 8-bit dither and LPF.
+
+--object writes the asset as a linkable object instead: the sample data as <output>.bin, pulled
+in by <output>.S with .incbin, the descriptor and silence map in <output>.c, and a header of
+declarations only.  Nothing large goes through the C compiler, the header can be included
+anywhere, and with --gc-sections an asset that nothing references is left out of the image.
+add_audio_asset() in cmake/sound_assets.cmake builds assets this way.
+
+Every descriptor carries the size and CRC-32 of its data, which AUDIO_ENGINE_ENABLE_ASSET_VERIFY
+checks in the background (AudioEngine_ServiceAssetVerify()).
+
+--ram writes an image for the RAM asset slot instead (AUDIO_ENGINE_ENABLE_RAM_ASSET): a 44-byte
+AudioEngine_RamAssetHeader ("CR2R", a CRC-32 of the rest, and the descriptor's fields), then the
+data.  Write it into the slot with the debugger at __ram_asset_start, or send it with
+Tools/uart_control.py --upload, and play it with PlayRamAsset(); no rebuild or reflash.
+
+--variant-of names the master a WAV file is a lower rate, depth or channel variant of
+(Tools/find_asset_variants.py finds them).  The two are compared as that tool compares them, and
+the variant's descriptor is written over the master's data: the master's samples, encoding and
+rate under the variant's name, with no data of its own, so code that plays the variant plays the
+master and the engine's resampler (AUDIO_ENGINE_BUS_RATE) brings it to the bus rate.  The master
+is built as usual, with the same --encoding, --bake and --shape.
+
+--qspi places the sample data in the .qspi_assets section, linked into QUADSPI flash and read in
+place once AudioEngine_MapQspiAssets() has mapped it (AUDIO_ENGINE_ENABLE_QSPI_XIP).  The
+descriptor, peaks and silence map stay in internal flash.
+
+Usage:
+    make_asset.py chime.wav --encoding adpcm -o build/sound_assets/chime_asset.h
+    make_asset.py chime.wav --object -o build/sound_assets/chime_asset.h
+    make_asset.py chime.wav --bake "--lpf16 medium --air-db 2" --preset night_preset
+    make_asset.py chime.wav --encoding pcm8 --shape -o build/sound_assets/chime_asset.h
+    make_asset.py announcement.wav --object --qspi -o build/sound_assets/announcement_asset.h
+    make_asset.py chime.wav --encoding adpcm --ram -o chime_ram.bin
+    make_asset.py doors_closing11k.wav --variant-of doors_closing.wav --object -o build/sound_assets/doors_closing11k_asset.h
+"""
+
+import argparse
+import random
+import re
+import struct
+import wave
+import zlib
+from pathlib import Path
+
+from bake_filters import bake, parse_options, settings
+from make_adpcm_header import DEFAULT_BLOCK_BYTES, encode as encode_adpcm
+from make_companded_header import encode as encode_companded
+from make_lossless_header import DEFAULT_BLOCK_FRAMES as DEFAULT_LOSSLESS_FRAMES, encode as encode_lossless
+from make_midside_header import encode as encode_midside
+from make_rle_header import encode as encode_rle
+from make_sbc_header import encode_default as encode_sbc
+from make_silence_map import DEFAULT_BLOCK_FRAMES, block_peaks
+from measure_loudness import loudness
+from shape_noise import DEFAULT_ORDER as DEFAULT_SHAPE_ORDER, shape
+
+ENCODINGS = {"pcm16": "ASSET_PCM16", "pcm8": "ASSET_PCM8", "adpcm": "ASSET_ADPCM", "lossless": "ASSET_LOSSLESS",
+             "mulaw": "ASSET_MULAW", "alaw": "ASSET_ALAW", "sbc": "ASSET_SBC",
+             "midside": "ASSET_MIDSIDE", "pcm12": "ASSET_PCM12", "rle": "ASSET_SILENCE_RLE"}
+FLAG_BITS = {"AUDIO_ASSET_BAKED": 0x01, "AUDIO_ASSET_SHAPED": 0x02}
+RAM_MAGIC = 0x52325243                      # AUDIO_ENGINE_RAM_ASSET_MAGIC
+RAM_HEADER = struct.Struct("<IIIIIIIHHHhBBhhBB")
+
+
+def read_wav(path):
+    """Return the rate, channels and interleaved samples as signed 16-bit values."""
+    with wave.open(str(path), "rb") as wav:
+        width = wav.getsampwidth()
+        rate = wav.getframerate()
+        channels = wav.getnchannels()
+        data = wav.readframes(wav.getnframes())
+    if channels not in (1, 2):
+        raise SystemExit(f"{path}: {channels} channels, only mono and stereo are supported")
+    if width == 2:
+        samples = [v[0] for v in struct.iter_unpack("<h", data)]
+    elif width == 1:
+        samples = [(v - 128) << 8 for v in data]
+    else:
+        raise SystemExit(f"{path}: {8 * width}-bit samples, only 8 and 16-bit PCM are supported")
+    return rate, channels, samples
+
+
+def read_loop(path):
+    """First loop of the WAV 'smpl' chunk as (start, end) frames, end exclusive, or None."""
+    data = path.read_bytes()
+    pos = 12
+    while pos + 8 <= len(data):
+        tag, size = data[pos:pos + 4], struct.unpack_from("<I", data, pos + 4)[0]
+        if tag == b"smpl" and size >= 60 and struct.unpack_from("<I", data, pos + 8 + 28)[0] > 0:
+            start, end = struct.unpack_from("<II", data, pos + 8 + 36 + 8)
+            return start, end + 1                          # 'smpl' loop ends are inclusive
+        pos += 8 + size + (size & 1)
+    return None
+
+
+def pack_pcm12(samples):
+    """Round to 12 bits with TPDF dither and pack two samples into three bytes, low bits first."""
+    dither = random.Random(12)                              # Fixed seed: the same WAV gives the same asset
+    codes = []
+    for v in samples:
+        d = dither.random() - dither.random()
+        codes.append(max(-2048, min(2047, int((v / 16.0 + d + 2048.5) // 1) - 2048)) & 0xFFF)
+    if len(codes) & 1:
+        codes.append(0)
+    data = bytearray()
+    for a, b in zip(codes[0::2], codes[1::2]):
+        data += (a | b << 12).to_bytes(3, "little")
+    return data
+
+
+def encode(samples, channels, encoding, block_bytes, lossless_frames=DEFAULT_LOSSLESS_FRAMES, rate=44100):
+    """Return the C element type and the values of the data array."""
+    if encoding == "pcm16":
+        return "uint16_t", [v & 0xFFFF for v in samples], 4
+    if encoding == "pcm8":
+        return "uint8_t", [min(255, (v + 32768 + 128) >> 8) for v in samples], 2
+    if encoding in ("mulaw", "alaw"):
+        return "uint8_t", list(encode_companded(samples, encoding)), 2
+    if encoding == "lossless":
+        data, _ = encode_lossless(samples, channels, lossless_frames)
+        return "uint8_t", list(data), 2
+    if encoding == "sbc":
+        data, _ = encode_sbc(samples, channels, rate)
+        return "uint8_t", list(data), 2
+    if encoding == "midside":
+        if channels != 2:
+            raise SystemExit("only stereo samples can be coded as mid/side")
+        data, _ = encode_midside(samples)
+        return "uint8_t", list(data), 2
+    if encoding == "pcm12":
+        return "uint8_t", list(pack_pcm12(samples)), 2
+    if encoding == "rle":
+        data, _ = encode_rle(samples, channels)
+        return "uint8_t", list(data), 2
+    data, _ = encode_adpcm(samples, channels, block_bytes)
+    return "uint8_t", list(data), 2
+
+
+def c_rows(values, digits, per_row=12):
+    rows = []
+    for i in range(0, len(values), per_row):
+        row = ", ".join(f"0x{v:0{digits}X}" for v in values[i:i + per_row])
+        rows.append(f"  {row}{',' if i + per_row < len(values) else ''}")
+    return rows
+
+
+def loudness_db10(samples, channels, rate):
+    """Loudness in tenths of a dB for the descriptor, 0 for silence (not measured)."""
+    value = loudness(samples, channels, rate)
+    return min(-1, round(10 * value)) if value is not None else 0
+
+
+def descriptor(name, rate, channels, samples, encoding, loop, block_frames, block_bytes, lossless_frames, peaks,
+               asset_id, loudness_target, preset, flags=(), data=b"", data_name=None):
+    """Lines of the AudioAsset definition, its silence map and its index entry."""
+    peak = max(peaks, default=0)
+    loop_start, loop_end = loop or (0, 0)
+    lines = [
+        f"const uint16_t {name}_peaks[ {len(peaks)} ] =",
+        "{",
+        *c_rows(peaks, 4),
+        "};",
+        "",
+        *([f"extern const AudioEngine_Preset {preset};", ""] if preset else []),
+        f"const AudioAsset {name}_asset =",
+        "{",
+        f"  .data               = {data_name or name}_data,",
+        f"  .sample_sz          = {len(samples)}U,",
+        f"  .sample_rate        = {rate}U,",
+        f"  .loop_start_frame   = {loop_start}U,",
+        f"  .loop_end_frame     = {loop_end}U,",
+        f"  .block_peaks        = {name}_peaks,",
+        f"  .block_peak_count   = {len(peaks)}U,",
+        f"  .block_peak_frames  = {block_frames}U,",
+        f"  .adpcm_block_bytes  = {block_bytes if encoding == 'adpcm' else 0}U,",
+        f"  .lossless_block_frames = {lossless_frames if encoding == 'lossless' else 0}U,",
+        f"  .peak               = {peak}U,",
+        f"  .warmup_sample      = {samples[0] if samples else 0},",
+        f"  .encoding           = {ENCODINGS[encoding]},",
+        f"  .channels           = {channels}U,",
+        f"  .loudness_db10      = {loudness_db10(samples, channels, rate)},",
+        f"  .loudness_target_db10 = {round(10 * loudness_target) if loudness_target is not None else 0},",
+        f"  .preset             = {'&' + preset if preset else 'NULL'},",
+        f"  .flags              = {' | '.join(flags) or '0U'},",
+        f"  .data_bytes         = {len(data)}U,",
+        f"  .data_crc           = 0x{zlib.crc32(data):08X}U",
+        "};",
+        "",
+    ]
+    if asset_id is not None:
+        lines += [
+            "#if AUDIO_ENGINE_ENABLE_ASSET_INDEX",
+            f"AUDIO_ENGINE_INDEX_ASSET( {asset_id}, {name}_asset );",
+            "#endif",
+            "",
+        ]
+    return lines
+
+
+def as_bytes(ctype, values):
+    """The sample data as it lies in flash."""
+    return struct.pack(f"<{len(values)}H", *values) if ctype == "uint16_t" else bytes(values)
+
+
+def write_header(path, name, source, rate, channels, samples, encoding, loop, block_frames, block_bytes,
+                 lossless_frames, asset_id=None, loudness_target=None, preset=None, flags=(), qspi=False):
+    ctype, values, digits = encode(samples, channels, encoding, block_bytes, lossless_frames, rate)
+    data = as_bytes(ctype, values)
+    peaks = block_peaks(samples, channels, block_frames)
+    guard = f"_{name.upper()}_ASSET_H"
+
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        f"/* Generated by Tools/make_asset.py from {source.name}: do not edit */",
+        "",
+        "#include <stdint.h>",
+        '#include "audio_engine.h"',
+        "",
+        f"const {ctype} {name}_data[ {len(values)} ] "
+        + ("AUDIO_ENGINE_QSPI_ASSET =" if qspi else "__attribute__( ( aligned( 4 ) ) ) ="),
+        "{",
+        *c_rows(values, digits),
+        "};",
+        "",
+        *descriptor(name, rate, channels, samples, encoding, loop, block_frames, block_bytes, lossless_frames, peaks,
+                    asset_id, loudness_target, preset, flags, data),
+        f"#endif // End of {guard}",
+        "",
+    ]
+    path.write_text("\n".join(lines))
+    return len(values) * (2 if ctype == "uint16_t" else 1)
+
+
+def write_ram_image(path, name, source, rate, channels, samples, encoding, loop, block_frames, block_bytes,
+                    lossless_frames, asset_id=None, loudness_target=None, preset=None, flags=(), qspi=False):
+    """Write a RAM asset slot image: an AudioEngine_RamAssetHeader, then the data."""
+    ctype, values, _ = encode(samples, channels, encoding, block_bytes, lossless_frames, rate)
+    data = as_bytes(ctype, values)
+    data += bytes(-len(data) % 4)
+    loop_start, loop_end = loop or (0, 0)
+    fields = RAM_HEADER.pack(0, 0, len(data), len(samples), rate, loop_start, loop_end,
+                             block_bytes if encoding == "adpcm" else 0,
+                             lossless_frames if encoding == "lossless" else 0,
+                             max(block_peaks(samples, channels, block_frames), default=0),
+                             samples[0] if samples else 0, list(ENCODINGS).index(encoding), channels,
+                             loudness_db10(samples, channels, rate),
+                             round(10 * loudness_target) if loudness_target is not None else 0,
+                             sum(FLAG_BITS[f] for f in flags), 0)[8:] + data
+    path.write_bytes(struct.pack("<II", RAM_MAGIC, zlib.crc32(fields)) + fields)
+    return RAM_HEADER.size + len(data)
+
+
+def write_object(path, name, source, rate, channels, samples, encoding, loop, block_frames, block_bytes,
+                 lossless_frames, asset_id=None, loudness_target=None, preset=None, flags=(), qspi=False):
+    """Write <path> declaring the asset, <path>.c defining it, <path>.S and the <path>.bin it includes."""
+    ctype, values, _ = encode(samples, channels, encoding, block_bytes, lossless_frames, rate)
+    data = as_bytes(ctype, values)
+    peaks = block_peaks(samples, channels, block_frames)
+    guard = f"_{name.upper()}_ASSET_H"
+    note = f"/* Generated by Tools/make_asset.py from {source.name}: do not edit */"
+    binary, assembly, definition = (path.with_suffix(suffix) for suffix in (".bin", ".S", ".c"))
+
+    binary.write_bytes(data)
+    assembly.write_text("\n".join([
+        note,
+        "",
+        f'  .section {".qspi_assets" if qspi else ".rodata"}.{name}_data, "a", %progbits',
+        "  .balign 4",
+        f"  .global {name}_data",
+        f"  .type   {name}_data, %object",
+        f"{name}_data:",
+        f'  .incbin "{binary.resolve().as_posix()}"',
+        f"  .size   {name}_data, . - {name}_data",
+        "",
+    ]))
+    path.write_text("\n".join([
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        note,
+        "",
+        "#include <stdint.h>",
+        '#include "audio_engine.h"',
+        "",
+        f"#define {name.upper()}_DATA_BYTES {len(data)}U",
+        "",
+        f"extern const {ctype} {name}_data[];",
+        f"extern const AudioAsset {name}_asset;",
+        "",
+        f"#endif // End of {guard}",
+        "",
+    ]))
+    definition.write_text("\n".join([
+        note,
+        "",
+        f'#include "{path.name}"',
+        "",
+        *descriptor(name, rate, channels, samples, encoding, loop, block_frames, block_bytes, lossless_frames, peaks,
+                    asset_id, loudness_target, preset, flags, data),
+    ]))
+    return len(data)
+
+
+def write_variant(path, name, source, master, rate, channels, samples, encoding, loop, block_frames, block_bytes,
+                  lossless_frames, asset_id=None, loudness_target=None, preset=None, flags=(), master_name=None,
+                  split=False):
+    """Write the variant's descriptor over the master's data: a header alone, or with split a header
+    of declarations and <path>.c defining it."""
+    ctype, values, _ = encode(samples, channels, encoding, block_bytes, lossless_frames, rate)
+    data = as_bytes(ctype, values)
+    peaks = block_peaks(samples, channels, block_frames)
+    guard = f"_{name.upper()}_ASSET_H"
+    note = f"/* Generated by Tools/make_asset.py from {source.name}, a variant of {master.name}: do not edit */"
+    lines = descriptor(name, rate, channels, samples, encoding, loop, block_frames, block_bytes, lossless_frames,
+                       peaks, asset_id, loudness_target, preset, flags, data, master_name)
+    declarations = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        note,
+        "",
+        "#include <stdint.h>",
+        '#include "audio_engine.h"',
+        "",
+        f"extern const {ctype} {master_name}_data[];",
+        *([f"extern const AudioAsset {name}_asset;", ""] if split else ["", *lines]),
+        f"#endif // End of {guard}",
+        "",
+    ]
+    path.write_text("\n".join(declarations))
+    if split:
+        path.with_suffix(".c").write_text("\n".join([note, "", f'#include "{path.name}"', "", *lines]))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("wav", type=Path, help="8 or 16-bit PCM WAV file, mono or stereo")
+    parser.add_argument("--encoding", choices=sorted(ENCODINGS), default="pcm16", help="data encoding (default: pcm16)")
+    parser.add_argument("--name", help="C name prefix (default: from the file name)")
+    parser.add_argument("--loop", type=int, nargs=2, metavar=("START", "END"),
+                        help="loop region in frames, END exclusive (default: from the 'smpl' chunk)")
+    parser.add_argument("--block-frames", type=int, default=DEFAULT_BLOCK_FRAMES,
+                        help="frames per silence map entry, matching AUDIO_ENGINE_SILENCE_MAP_BLOCK_FRAMES")
+    parser.add_argument("--block-bytes", type=int, default=DEFAULT_BLOCK_BYTES,
+                        help="ADPCM bytes per channel per block, matching AUDIO_ENGINE_ADPCM_BLOCK_BYTES")
+    parser.add_argument("--lossless-frames", type=int, default=DEFAULT_LOSSLESS_FRAMES,
+                        help="frames per lossless block, matching AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES")
+    parser.add_argument("--id", type=int, help="also register the asset under this ID in the asset index (PlayAssetById())")
+    parser.add_argument("--loudness-target", type=float, metavar="LUFS",
+                        help="play this asset at this loudness instead of AudioEngine_SetLoudnessTarget()")
+    parser.add_argument("--preset", metavar="NAME", help="engine preset to apply as the asset starts, such as night_preset")
+    parser.add_argument("--bake", metavar='"OPTIONS"',
+                        help="apply the LPF, DC blocker and air effect of these make_preset.py options to the data")
+    parser.add_argument("--shape", type=int, nargs="?", const=DEFAULT_SHAPE_ORDER, choices=(1, 2, 3), metavar="ORDER",
+                        help=f"noise-shape a pcm8 asset so it plays without the 8-bit dither and LPF "
+                             f"(order 1 to 3, default {DEFAULT_SHAPE_ORDER})")
+    parser.add_argument("--object", action="store_true",
+                        help="write a linkable object (.bin, .S and .c) with a header of declarations only")
+    parser.add_argument("--ram", action="store_true",
+                        help="write a RAM asset slot image to play without reflashing (AUDIO_ENGINE_ENABLE_RAM_ASSET)")
+    parser.add_argument("--qspi", action="store_true",
+                        help="link the sample data into QUADSPI flash, read in place (AUDIO_ENGINE_ENABLE_QSPI_XIP)")
+    parser.add_argument("--variant-of", type=Path, metavar="MASTER.wav",
+                        help="describe this WAV as a variant of MASTER.wav, over the master's data")
+    parser.add_argument("--master-name", help="C name prefix of the master (default: from its file name)")
+    parser.add_argument("--threshold", type=float,
+                        help="correlation --variant-of needs with the master (default: as find_asset_variants.py)")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <wav>_asset.h)")
+    args = parser.parse_args()
+
+    name = args.name or re.sub(r"\W", "_", args.wav.stem).lower()
+    source = args.wav
+    if args.variant_of is not None:
+        # Imported here: the tool reads WAV files with this module's read_wav()
+        from find_asset_variants import MATCH_THRESHOLD, best_match, read_sound
+
+        if args.ram or args.qspi:
+            raise SystemExit("--variant-of takes no --ram or --qspi: the master's data decides where it lies")
+        threshold = MATCH_THRESHOLD if args.threshold is None else args.threshold
+        match, master_rate, variant_rate = best_match(read_sound(args.variant_of), read_sound(args.wav))
+        if match < threshold:
+            raise SystemExit(f"{args.wav}: not a variant of {args.variant_of} "
+                             f"(correlation {match:.4f}, needs {threshold})")
+        print(f"{args.wav}: {variant_rate} Hz variant of {args.variant_of} at {master_rate} Hz, "
+              f"correlation {match:.4f}")
+        source = args.variant_of
+    rate, channels, samples = read_wav(source)
+    samples = samples[:len(samples) - len(samples) % channels]
+    loop = tuple(args.loop) if args.loop else read_loop(source)
+    if args.id is not None and args.id < 0:
+        raise SystemExit("--id must not be negative")
+    if args.loudness_target is not None and not -60.0 <= args.loudness_target < 0.0:
+        raise SystemExit("--loudness-target must be from -60 to below 0 LUFS")
+    if loop and not 0 <= loop[0] < loop[1] <= len(samples) // channels:
+        raise SystemExit(f"{source}: loop {loop[0]}-{loop[1]} is outside the {len(samples) // channels} frames")
+
+    if args.ram and (args.object or args.qspi or args.id is not None or args.preset):
+        raise SystemExit("--ram takes no --object, --qspi, --id or --preset")
+    if args.shape is not None and args.encoding != "pcm8":
+        raise SystemExit("--shape needs --encoding pcm8")
+
+    flags = []
+    if args.bake is not None:
+        samples = bake(samples, channels, settings(parse_options(args.bake), rate, 8 if args.encoding == "pcm8" else 16))
+        flags.append("AUDIO_ASSET_BAKED")
+    if args.shape is not None:
+        samples = shape(samples, channels, args.shape)
+        flags.append("AUDIO_ASSET_SHAPED")
+
+    output = args.output or args.wav.with_name(args.wav.stem + ("_ram.bin" if args.ram else "_asset.h"))
+    if args.variant_of is not None:
+        master_name = args.master_name or re.sub(r"\W", "_", args.variant_of.stem).lower()
+        size = write_variant(output, name, args.wav, args.variant_of, rate, channels, samples, args.encoding, loop,
+                             args.block_frames, args.block_bytes, args.lossless_frames, args.id, args.loudness_target,
+                             args.preset, flags, master_name, args.object)
+    else:
+        write = write_ram_image if args.ram else write_object if args.object else write_header
+        size = write(output, name, args.wav, rate, channels, samples, args.encoding, loop,
+                     args.block_frames, args.block_bytes, args.lossless_frames, args.id, args.loudness_target,
+                     args.preset, flags, args.qspi)
+    print(f"{output}: {name}_asset, {args.encoding}, {rate} Hz, {channels} ch, {size} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Build an asset bank of WAV files for the flash partition reserved by the linker script.
+
+The bank is a 24-byte AudioEngine_BankHeader (AUDIO_ENGINE_BANK_MAGIC "CR2B", a CRC-32 of
+everything after it, the version, the bank size and the entry count), an index of 52-byte
+AudioEngine_BankEntry records sorted by ID, then each asset's data and silence map, word
+aligned.  The engine plays the samples in place once AudioEngine_MountBank() has checked it.
+IDs are given as ID=file.wav; a file without one takes the ID after the previous file's.
+
+The bank is programmed on its own, leaving the firmware alone: --program runs
+STM32_Programmer_CLI with the given port, "swd" for an ST-LINK or a serial port such as
+/dev/ttyUSB0 for the STM32 UART bootloader (BOOT0 held high).
+
+With --slots 2 (AUDIO_ENGINE_BANK_UPDATE) the partition is two slots of --bank-size, and the
+bank goes into the first, leaving the slot's last 8 bytes for the commit record written by a
+bank update.  --program then also blanks the second slot's last page, so its commit record is
+gone and AudioEngine_MountNewestBank() takes the bank just programmed.
+
+Usage:
+    make_asset_bank.py 0=chime.wav bong.wav --encoding adpcm --bank-size 0x20000 -o bank.bin
+    make_asset_bank.py 0=chime.wav --bank-size 0x20000 -o bank.bin --program swd
+    make_asset_bank.py 0=chime.wav --bank-size 0x20000 --slots 2 -o bank.bin --program swd
+"""
+
+import argparse
+import struct
+import subprocess
+import zlib
+from pathlib import Path
+
+from make_adpcm_header import DEFAULT_BLOCK_BYTES
+from make_asset import ENCODINGS, encode, loudness_db10, read_loop, read_wav
+from make_lossless_header import DEFAULT_BLOCK_FRAMES as DEFAULT_LOSSLESS_FRAMES
+from make_silence_map import DEFAULT_BLOCK_FRAMES, block_peaks
+from make_stream_image import parse_entries
+
+MAGIC = 0x42325243                 # AUDIO_ENGINE_BANK_MAGIC
+VERSION = 2                        # AUDIO_ENGINE_BANK_VERSION
+HEADER = struct.Struct("<IIIIII")
+ENTRY = struct.Struct("<IIIIIIIIIHHHHhBBhh")
+FLASH_END = 0x08080000             # STM32G474xE, 512 KB
+PAGE_BYTES = 4096
+SLOT_PAGE_BYTES = 2048             # Flash page with the dual-bank option set
+COMMIT_BYTES = 8                   # Bank update commit record at the end of a slot
+ENCODING_VALUES = {name: i for i, name in enumerate(("pcm16", "pcm8", "adpcm", "lossless", "mulaw", "alaw", "sbc", "midside", "pcm12", "rle"))}
+
+
+def build_bank(entries, encoding, block_bytes, lossless_frames, block_frames):
+    index, data = [], bytearray()
+    data_start = HEADER.size + ENTRY.size * len(entries)
+    for ident, path in sorted(entries.items()):
+        rate, channels, samples = read_wav(path)
+        samples = samples[:len(samples) - len(samples) % channels]
+        frames = len(samples) // channels
+        loop = read_loop(path)
+        if loop and not 0 <= loop[0] < loop[1] <= frames:
+            raise SystemExit(f"{path}: loop {loop[0]}-{loop[1]} is outside the {frames} frames")
+        loop_start, loop_end = loop or (0, 0)
+
+        ctype, values, _ = encode(samples, channels, encoding, block_bytes, lossless_frames, rate)
+        blob = struct.pack(f"<{len(values)}H", *values) if ctype == "uint16_t" else bytes(values)
+        data_offset = data_start + len(data)
+        data += blob + bytes(-len(blob) % 4)
+
+        peaks = block_peaks(samples, channels, block_frames)
+        peaks_offset = data_start + len(data) if peaks else 0
+        data += struct.pack(f"<{len(peaks)}H", *peaks)
+        data += bytes(-len(data) % 4)
+
+        index.append(ENTRY.pack(ident, data_offset, len(blob), len(samples), rate, loop_start, loop_end,
+                                peaks_offset, len(peaks), block_frames,
+                                block_bytes if encoding == "adpcm" else 0,
+                                lossless_frames if encoding == "lossless" else 0,
+                                max(peaks, default=0), samples[0] if samples else 0,
+                                ENCODING_VALUES[encoding], channels, loudness_db10(samples, channels, rate), 0))
+
+    body = struct.pack("<III", VERSION, data_start + len(data), len(entries)) + bytes(4) + b"".join(index) + data
+    return struct.pack("<II", MAGIC, zlib.crc32(body)) + body
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("wavs", nargs="+", metavar="[ID=]WAV", help="8 or 16-bit PCM WAV files, mono or stereo")
+    parser.add_argument("--encoding", choices=sorted(ENCODINGS), default="pcm16", help="data encoding (default: pcm16)")
+    parser.add_argument("--bank-size", type=lambda v: int(v, 0), required=True,
+                        help="partition size, matching AUDIO_ENGINE_ASSET_BANK_SIZE")
+    parser.add_argument("--block-frames", type=int, default=DEFAULT_BLOCK_FRAMES,
+                        help="frames per silence map entry, matching AUDIO_ENGINE_SILENCE_MAP_BLOCK_FRAMES")
+    parser.add_argument("--block-bytes", type=int, default=DEFAULT_BLOCK_BYTES,
+                        help="ADPCM bytes per channel per block, matching AUDIO_ENGINE_ADPCM_BLOCK_BYTES")
+    parser.add_argument("--lossless-frames", type=int, default=DEFAULT_LOSSLESS_FRAMES,
+                        help="frames per lossless block, matching AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES")
+    parser.add_argument("--slots", type=int, choices=(1, 2), default=1,
+                        help="bank slots, 2 with AUDIO_ENGINE_BANK_UPDATE (default: 1)")
+    parser.add_argument("--program", metavar="PORT", help="program the bank with STM32_Programmer_CLI on this port")
+    parser.add_argument("-o", "--output", type=Path, required=True, help="output bank image")
+    args = parser.parse_args()
+
+    if args.bank_size <= 0 or args.bank_size % PAGE_BYTES:
+        raise SystemExit(f"--bank-size must be a multiple of the {PAGE_BYTES}-byte flash page")
+    entries = parse_entries(args.wavs)
+    bank = build_bank(entries, args.encoding, args.block_bytes, args.lossless_frames, args.block_frames)
+    room = args.bank_size - (COMMIT_BYTES if args.slots > 1 else 0)
+    if len(bank) > room:
+        raise SystemExit(f"{len(bank)} bytes do not fit the {room} bytes of the bank")
+    args.output.write_bytes(bank)
+    address = FLASH_END - args.bank_size * args.slots
+    print(f"{args.output}: {len(entries)} assets, {args.encoding}, {len(bank)} of {args.bank_size} bytes at 0x{address:08X}")
+
+    if args.program:
+        port = f"port={args.program}"
+        subprocess.run(["STM32_Programmer_CLI", "-c", port, "-w", str(args.output), f"0x{address:08X}", "-v"], check=True)
+        if args.slots > 1:
+            blank = args.output.with_suffix(".blank.bin")
+            blank.write_bytes(b"\xff" * SLOT_PAGE_BYTES)
+            subprocess.run(["STM32_Programmer_CLI", "-c", port, "-w", str(blank),
+                            f"0x{FLASH_END - SLOT_PAGE_BYTES:08X}", "-v"], check=True)
+        subprocess.run(["STM32_Programmer_CLI", "-c", port, "-hardRst"], check=True)
+
+
+if __name__ == "__main__":
+    main()
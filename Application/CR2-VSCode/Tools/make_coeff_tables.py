@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Generate the audio engine's per-rate filter coefficient tables (AUDIO_ENGINE_ENABLE_RATE_COEFF_TABLES).
+
+The LPF_16BIT_*, LPF_* and DC_FILTER_ALPHA levels in audio_engine.h are single alphas tuned at
+--reference-rate.  For every I2S rate in --rates this works out the cutoff each level has at the
+reference rate and the alpha that gives the same cutoff at that rate, so a level sounds the same
+whatever the rate:
+
+    16-bit biquad, DC filter   alpha = exp(-2*pi*fc/fs)        (pole)
+    8-bit one-pole             alpha = 1 - exp(-2*pi*fc/fs)
+
+The air effect corner (AIR_EFFECT_FREQ_HZ) and the preset gains (air_effect_presets_db in
+audio_engine.c) are tabulated with them.  The engine then picks a row by the output rate, with no
+floating-point math on the device.  Run by the build (see cmake/coeff_tables.cmake); the levels
+are read from the engine sources, so the tables follow any change to them.
+
+Usage:
+    make_coeff_tables.py Core/Libraries -o build/generated/audio_engine_coeff_tables.h
+"""
+
+import argparse
+import math
+import re
+from pathlib import Path
+
+RATES = (8000, 11025, 16000, 22050, 32000, 44100, 48000)
+LEVELS = ("VERY_SOFT", "SOFT", "MEDIUM", "FIRM", "AGGRESSIVE")    # LPF_VerySoft ... LPF_Aggressive
+LPF_16BIT_ALPHA_MAX = 65534                                        # As audio_engine.c
+
+
+def defines(text):
+    """Numeric #defines of a source file."""
+    return {m.group(1): int(m.group(2)) for m in re.finditer(r"^#define\s+(\w+)\s+(\d+)U?\b", text, re.M)}
+
+
+def air_presets(text):
+    match = re.search(r"air_effect_presets_db\[\]\s*=\s*\{([^}]*)\}", text)
+    if match is None:
+        raise SystemExit("air_effect_presets_db not found in audio_engine.c")
+    return [float(v.strip().rstrip("fF")) for v in match.group(1).split(",") if v.strip()]
+
+
+def pole_cutoff(alpha, rate):
+    """Cutoff of a pole alpha (Q16) at a rate."""
+    return -math.log(alpha / 65536) * rate / (2 * math.pi)
+
+
+def pole_alpha(cutoff, rate, limit):
+    return min(limit, round(math.exp(-2 * math.pi * cutoff / rate) * 65536))
+
+
+def one_pole_cutoff(alpha, rate):
+    """Cutoff of a one-pole smoothing alpha (Q16) at a rate."""
+    return -math.log(1 - alpha / 65536) * rate / (2 * math.pi)
+
+
+def one_pole_alpha(cutoff, rate):
+    return min(65535, round((1 - math.exp(-2 * math.pi * cutoff / rate)) * 65536))
+
+
+def generate(header, source, rates, reference):
+    values = defines(header)
+    presets = air_presets(source)
+    lpf16 = [pole_cutoff(values[f"LPF_16BIT_{level}"], reference) for level in LEVELS]
+    lpf8 = [one_pole_cutoff(values[f"LPF_{level}"], reference) for level in LEVELS]
+    dc = pole_cutoff(values["DC_FILTER_ALPHA"], reference)
+    soft_dc = pole_cutoff(values["SOFT_DC_FILTER_ALPHA"], reference)
+    air_hz = values["AIR_EFFECT_FREQ_HZ"]
+    gain_max = values["AIR_EFFECT_SHELF_GAIN_MAX"]
+    reference_row = min(range(len(rates)), key=lambda i: abs(rates[i] - reference))
+
+    lines = [
+        "/* Generated by Tools/make_coeff_tables.py from audio_engine.h and audio_engine.c; do not edit. */",
+        "#ifndef AUDIO_ENGINE_COEFF_TABLES_H",
+        "#define AUDIO_ENGINE_COEFF_TABLES_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define COEFF_TABLE_REFERENCE_HZ    {reference}U    // Rate the LPF and DC levels keep their cutoffs from",
+        f"#define COEFF_TABLE_RATES           {len(rates)}U",
+        f"#define COEFF_TABLE_REFERENCE_ROW   {reference_row}U        // Row nearest COEFF_TABLE_REFERENCE_HZ",
+        f"#define COEFF_TABLE_LPF_LEVELS      {len(LEVELS)}U        // LPF_VerySoft ... LPF_Aggressive",
+        f"#define COEFF_TABLE_AIR_PRESETS     {len(presets)}U",
+        "",
+        "/* Cutoffs (Hz): 16-bit " + ", ".join(f"{c:.0f}" for c in lpf16)
+        + "; 8-bit " + ", ".join(f"{c:.0f}" for c in lpf8)
+        + f"; DC {dc:.1f}, soft DC {soft_dc:.1f}; air {air_hz} */",
+        "typedef struct {",
+        "  uint32_t rate_hz;",
+        "  uint16_t lpf16_alpha[ COEFF_TABLE_LPF_LEVELS ];            // Q16 biquad pole, as LPF_16BIT_*",
+        "  uint16_t lpf8_alpha[ COEFF_TABLE_LPF_LEVELS ];             // Q16 one-pole alpha, as LPF_*",
+        "  uint16_t dc_alpha;                                         // Q16, as DC_FILTER_ALPHA",
+        "  uint16_t soft_dc_alpha;                                    // Q16, as SOFT_DC_FILTER_ALPHA",
+        "  int32_t  air_alpha_q15;                                    // Air effect low-pass at AIR_EFFECT_FREQ_HZ",
+        "} RateCoeffs;",
+        "",
+        "static const RateCoeffs rate_coeff_table[ COEFF_TABLE_RATES ] = {",
+    ]
+    for i, rate in enumerate(rates):
+        row16 = ", ".join(f"{pole_alpha(c, rate, LPF_16BIT_ALPHA_MAX):5d}" for c in lpf16)
+        row8 = ", ".join(f"{one_pole_alpha(c, rate):5d}" for c in lpf8)
+        air = min(32767, round((1 - math.exp(-2 * math.pi * air_hz / rate)) * 32768))
+        lines.append(f"  {{ {rate:5d}U, {{ {row16} }}, {{ {row8} }}, {pole_alpha(dc, rate, 65535):5d}, "
+                     f"{pole_alpha(soft_dc, rate, 65535):5d}, {air:5d} }}{',' if i + 1 < len(rates) else ''}")
+    gains = [min(gain_max, round(10 ** (db / 20) * 65536)) for db in presets]
+    lines += [
+        "};",
+        "",
+        "/* Air effect preset gains in Q16, 10^(dB/20) for air_effect_presets_db ("
+        + ", ".join(f"{db:g}" for db in presets) + " dB) */",
+        "static const uint32_t air_preset_gain_q16[ COEFF_TABLE_AIR_PRESETS ] = { "
+        + ", ".join(f"{g}U" for g in gains) + " };",
+        "",
+        "#endif // End of AUDIO_ENGINE_COEFF_TABLES_H",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("engine", type=Path, help="directory holding audio_engine.h and audio_engine.c")
+    parser.add_argument("-o", "--output", type=Path, required=True, help="generated header")
+    parser.add_argument("--rates", default=",".join(str(r) for r in RATES),
+                        help="comma-separated I2S rates to tabulate (default: %(default)s)")
+    parser.add_argument("--reference-rate", type=int, default=22050,
+                        help="rate the levels in audio_engine.h are tuned at (default: %(default)s)")
+    args = parser.parse_args()
+
+    rates = sorted({int(r) for r in args.rates.split(",") if r})
+    text = generate((args.engine / "audio_engine.h").read_text(), (args.engine / "audio_engine.c").read_text(),
+                    rates, args.reference_rate)
+    args.output.parent.mkdir(parents=True, exist_ok=True)
+    args.output.write_text(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+Convert a sound header in Core/Inc/sound_headers, or a 16-bit PCM WAV file, to G.711 mu-law or A-law.
+
+Each sample becomes one byte: the code whose expansion in the engine's table is nearest the
+16-bit value, so quantisation noise follows the signal level.  Play it with
+PlaySample( name_mulaw, NAME_MULAW_SZ, rate, AUDIO_ENGINE_MULAW_DEPTH, mode ), or the _alaw
+header with AUDIO_ENGINE_ALAW_DEPTH.
+
+Usage:
+    make_companded_header.py Core/Inc/sound_headers/steves_doorbell.h --law mulaw
+    make_companded_header.py chime.wav --law alaw -o Core/Inc/sound_headers/chime_alaw.h
+"""
+
+import argparse
+import bisect
+import re
+from pathlib import Path
+
+from make_adpcm_header import read_wav
+from make_silence_map import read_samples
+
+
+def mulaw_expand(code):
+    code = ~code & 0xFF
+    magnitude = (((code & 0x0F) << 3) + 0x84) << ((code & 0x70) >> 4)
+    return 0x84 - magnitude if code & 0x80 else magnitude - 0x84
+
+
+def alaw_expand(code):
+    code ^= 0x55
+    segment = (code & 0x70) >> 4
+    magnitude = (code & 0x0F) << 4
+    if segment == 0:
+        magnitude += 8
+    else:
+        magnitude = (magnitude + 0x108) << (segment - 1)
+    return magnitude if code & 0x80 else -magnitude
+
+
+EXPAND = {"mulaw": mulaw_expand, "alaw": alaw_expand}
+
+
+def encoder(law):
+    """Return a function mapping a 16-bit sample to the code that expands nearest to it."""
+    pairs = sorted((EXPAND[law](code), code) for code in range(256))
+    values = [v for v, _ in pairs]
+
+    def encode_sample(sample):
+        i = bisect.bisect_left(values, sample)
+        if i == len(values) or (i > 0 and sample - values[i - 1] <= values[i] - sample):
+            i -= 1
+        return pairs[i][1]
+    return encode_sample
+
+
+def encode(samples, law):
+    """Return one companded byte per sample."""
+    encode_sample = encoder(law)
+    return bytes(encode_sample(s) for s in samples)
+
+
+def write_header(path, name, data, law):
+    guard = f"_{name.upper()}_{law.upper()}_H"
+    size = f"{name.upper()}_{law.upper()}_SZ"
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* {name} in G.711 {'mu-law' if law == 'mulaw' else 'A-law'}, one byte per sample */",
+        f"#define {size} {len(data)}",
+        "",
+        f"const uint8_t {name}_{law}[ {size} ] __attribute__( ( aligned( 4 ) ) ) =",
+        "{",
+    ]
+    for i in range(0, len(data), 16):
+        row = ", ".join(f"0x{b:02X}" for b in data[i:i + 16])
+        lines.append(f"  {row}{',' if i + 16 < len(data) else ''}")
+    lines += ["};", "", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", type=Path, help="sound header or 16-bit WAV file")
+    parser.add_argument("--law", choices=sorted(EXPAND), default="mulaw", help="companding law (default: mulaw)")
+    parser.add_argument("--depth", type=int, choices=(8, 16), help="bits per sample of a header (default: from the array type)")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <source>_<law>.h)")
+    args = parser.parse_args()
+
+    if args.source.suffix.lower() == ".wav":
+        name, samples, _ = read_wav(args.source)
+    else:
+        text = args.source.read_text()
+        depth = args.depth
+        if depth is None:
+            depth = 8 if re.search(r"const\s+uint8_t\s+\w+\s*\[", text) else 16
+        name, samples = read_samples(text, depth)
+
+    data = encode(samples, args.law)
+    output = args.output or args.source.with_name(f"{args.source.stem}_{args.law}.h")
+    write_header(output, name, data, args.law)
+    print(f"{output}: {len(data)} samples in {len(data)} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Compress a 16-bit sound header in Core/Inc/sound_headers, or a 16-bit PCM WAV file, losslessly.
+
+Each block of --block-frames frames (AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES) is coded on its own:
+per channel, the fixed predictor of order 0-4 and the Rice parameter that give the fewest bits,
+then the Rice-coded prediction errors.  The engine decodes it bit-exact.  Play it with
+PlaySample( name_lossless, NAME_LOSSLESS_SZ, rate, AUDIO_ENGINE_LOSSLESS_DEPTH, mode ).
+
+Usage:
+    make_lossless_header.py Core/Inc/sound_headers/steves_doorbell.h
+    make_lossless_header.py chime.wav -o Core/Inc/sound_headers/chime_lossless.h
+"""
+
+import argparse
+import re
+import struct
+from pathlib import Path
+
+from make_adpcm_header import read_wav
+from make_silence_map import read_samples
+
+DEFAULT_BLOCK_FRAMES = 512  # AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES
+MAX_ORDER = 4
+MAX_QUOTIENT = 16           # LOSSLESS_MAX_QUOTIENT: bounds the decoder's work per sample
+MAX_RICE_K = 24
+
+
+def predict(history, order):
+    """Fixed polynomial prediction from the previous samples, newest first."""
+    h = history
+    if order == 0:
+        return 0
+    if order == 1:
+        return h[0]
+    if order == 2:
+        return 2 * h[0] - h[1]
+    if order == 3:
+        return 3 * (h[0] - h[1]) + h[2]
+    return 4 * (h[0] + h[2]) - 6 * h[1] - h[3]
+
+
+def zigzag(samples, order):
+    """Prediction errors from the first non-warm-up sample, mapped to unsigned values."""
+    values = []
+    for i in range(order, len(samples)):
+        r = samples[i] - predict(samples[max(0, i - MAX_ORDER):i][::-1], order)
+        values.append(2 * r if r >= 0 else -2 * r - 1)
+    return values
+
+
+def best_rice(values):
+    """Return (bits, k) for the cheapest Rice parameter that keeps every quotient in bounds."""
+    if not values:
+        return 0, 0
+    largest = max(values)
+    k = 0
+    while (largest >> k) > MAX_QUOTIENT:
+        k += 1
+    best = None
+    for kk in range(k, MAX_RICE_K + 1):
+        bits = sum(v >> kk for v in values) + (kk + 1) * len(values)
+        if best is not None and bits >= best[0]:
+            break                                   # The cost is convex in k
+        best = (bits, kk)
+    return best
+
+
+def encode_channel(samples):
+    """Return the header and padded residual stream of one channel of a block."""
+    best = None
+    for order in range(min(MAX_ORDER, len(samples)) + 1):
+        values = zigzag(samples, order)
+        bits, k = best_rice(values)
+        if best is None or bits < best[0]:
+            best = (bits, order, k, values)
+    _, order, k, values = best
+
+    out, acc, nbits = bytearray(), 0, 0
+    for v in values:
+        q = v >> k
+        acc = (acc << (q + 1)) | 1
+        nbits += q + 1
+        if k:
+            acc = (acc << k) | (v & ((1 << k) - 1))
+            nbits += k
+        while nbits >= 8:
+            nbits -= 8
+            out.append((acc >> nbits) & 0xFF)
+        acc &= (1 << nbits) - 1
+    if nbits:
+        out.append((acc << (8 - nbits)) & 0xFF)
+    out += bytes(-len(out) % 4)
+
+    warmup = (samples + [0] * MAX_ORDER)[:MAX_ORDER]
+    header = struct.pack("<BBH4h", order, k, len(out), *warmup)
+    return header, bytes(out)
+
+
+def encode(samples, channels, block_frames):
+    """Encode interleaved 16-bit samples into lossless blocks, with 4 bytes of tail padding."""
+    frames = len(samples) // channels
+    out = bytearray()
+    for start in range(0, frames, block_frames):
+        count = min(block_frames, frames - start)
+        parts = [encode_channel(samples[start * channels + c:(start + count) * channels:channels])
+                 for c in range(channels)]
+        out += b"".join(h for h, _ in parts) + b"".join(s for _, s in parts)
+    out += bytes(4)                                 # The decoder's bit cache reads ahead
+    return out, frames * channels
+
+
+def write_header(path, name, data, sample_count, block_frames):
+    guard = f"_{name.upper()}_LOSSLESS_H"
+    size = f"{name.upper()}_LOSSLESS_SZ"
+    nbytes = f"{name.upper()}_LOSSLESS_BYTES"
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* {name} compressed losslessly, {block_frames} frames per block (AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES) */",
+        f"#define {size} {sample_count}",
+        f"#define {nbytes} {len(data)}",
+        "",
+        f"const uint8_t {name}_lossless[ {nbytes} ] __attribute__( ( aligned( 4 ) ) ) =",
+        "{",
+    ]
+    for i in range(0, len(data), 16):
+        row = ", ".join(f"0x{b:02X}" for b in data[i:i + 16])
+        lines.append(f"  {row}{',' if i + 16 < len(data) else ''}")
+    lines += ["};", "", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", type=Path, help="16-bit sound header or 16-bit WAV file")
+    parser.add_argument("--channels", type=int, choices=(1, 2), default=1, help="1 for mono, 2 for stereo (headers only)")
+    parser.add_argument("--block-frames", type=int, default=DEFAULT_BLOCK_FRAMES,
+                        help="frames per block, matching AUDIO_ENGINE_LOSSLESS_BLOCK_FRAMES")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <source>_lossless.h)")
+    args = parser.parse_args()
+
+    if not 16 <= args.block_frames <= 4096:
+        raise SystemExit("--block-frames must be 16 to 4096")
+
+    if args.source.suffix.lower() == ".wav":
+        name, samples, channels = read_wav(args.source)
+    else:
+        text = args.source.read_text()
+        if re.search(r"const\s+uint8_t\s+\w+\s*\[", text):
+            raise SystemExit("only 16-bit sound headers can be compressed losslessly")
+        name, samples = read_samples(text, 16)
+        channels = args.channels
+
+    data, sample_count = encode(samples, channels, args.block_frames)
+    output = args.output or args.source.with_name(args.source.stem + "_lossless.h")
+    write_header(output, name, data, sample_count, args.block_frames)
+    print(f"{output}: {sample_count} samples in {len(data)} bytes, "
+          f"{100 * len(data) / max(1, 2 * sample_count):.0f}% of PCM16")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Convert a stereo 16-bit sound header in Core/Inc/sound_headers, or a stereo 16-bit PCM WAV file,
+to mid/side with a reduced side channel.
+
+The mid (L + R) / 2 is kept at full rate and 16 bits.  The side (L - R) / 2 is stored at half
+rate (after a half-band low-pass), in 8 bits with a shift, or both, whichever the content
+allows: half rate when the side has next to nothing above a quarter of the sample rate, and
+8 bits when the shifted side keeps its quantisation noise below MAX_NOISE_DB of the signal.
+Nearly mono content takes the half-rate 8-bit side, 5/8 of the PCM16 flash.  The engine
+rebuilds L = M + S and R = M - S in the fetch stage, interpolating a half-rate side linearly.
+Play it with PlaySample( name_midside, NAME_MIDSIDE_SZ, rate, AUDIO_ENGINE_MIDSIDE_DEPTH,
+Mode_stereo ).
+
+Usage:
+    make_midside_header.py Core/Inc/sound_headers/rooster16b2c.h
+    make_midside_header.py music.wav --side half8 -o Core/Inc/sound_headers/music_midside.h
+"""
+
+import argparse
+import math
+import re
+import struct
+from pathlib import Path
+
+from make_adpcm_header import read_wav
+from make_silence_map import read_samples
+
+HEADER_BYTES = 4
+SIDE_HALF_RATE = 0x01
+SIDE_8BIT = 0x02
+SIDE_FORMATS = {"full16": 0, "half16": SIDE_HALF_RATE, "full8": SIDE_8BIT, "half8": SIDE_HALF_RATE | SIDE_8BIT}
+HALF_BAND = (-1, 0, 9, 16, 9, 0, -1)    # /32: the decimation low-pass
+MAX_LOSS_DB = -50                        # Side energy above rate / 4, relative to the signal, that half rate may drop
+MAX_NOISE_DB = -66                       # 8-bit side quantisation noise, relative to the signal
+
+
+def split(samples):
+    """Mid and side of interleaved stereo samples."""
+    left, right = samples[0::2], samples[1::2]
+    mid = [(l + r) >> 1 for l, r in zip(left, right)]
+    side = [(l - r) / 2 for l, r in zip(left, right)]
+    return mid, side
+
+
+def low_pass(side):
+    taps = len(HALF_BAND) // 2
+    return [sum(c * side[min(len(side) - 1, max(0, i + k - taps))] for k, c in enumerate(HALF_BAND)) / 32
+            for i in range(len(side))]
+
+
+def db(ratio):
+    return 10 * math.log10(ratio) if ratio > 0 else -200
+
+
+def choose(mid, side):
+    """The smallest side format within MAX_LOSS_DB and MAX_NOISE_DB."""
+    power = sum(m * m + s * s for m, s in zip(mid, side)) / max(1, len(mid)) or 1
+    smooth = low_pass(side)
+    lost = sum((a - b) ** 2 for a, b in zip(side, smooth)) / max(1, len(side))
+    half = db(lost / power) <= MAX_LOSS_DB
+    shift = side_shift(smooth if half else side)
+    noise = (1 << shift) ** 2 / 12
+    return (SIDE_HALF_RATE if half else 0) | (SIDE_8BIT if db(noise / power) <= MAX_NOISE_DB else 0)
+
+
+def side_shift(side):
+    peak = max((abs(s) for s in side), default=0)
+    shift = 0
+    while shift < 8 and peak > 127.5 * (1 << shift):
+        shift += 1
+    return shift
+
+
+def encode(samples, fmt=None):
+    """Encode interleaved stereo 16-bit samples; fmt picks the side format (None: automatic)."""
+    mid, side = split(samples)
+    if fmt is None:
+        fmt = choose(mid, side)
+    if fmt & SIDE_HALF_RATE:
+        smooth = low_pass(side)
+        side = smooth[0::2] + [smooth[-1] if smooth else 0] * 2     # Guard samples for the interpolation
+        side = side[:(len(mid) + 1) // 2 + 1]
+    shift = side_shift(side) if fmt & SIDE_8BIT else 0
+    out = bytearray(struct.pack("<BBH", fmt, shift, 0))
+    out += struct.pack(f"<{len(mid)}h", *mid)
+    out += bytes(-len(out) % 4)
+    if fmt & SIDE_8BIT:
+        out += struct.pack(f"<{len(side)}b", *[max(-128, min(127, round(s / (1 << shift)))) for s in side])
+    else:
+        out += struct.pack(f"<{len(side)}h", *[max(-32768, min(32767, round(s))) for s in side])
+    out += bytes(-len(out) % 4)
+    return out, fmt
+
+
+def format_name(fmt):
+    return next(name for name, value in SIDE_FORMATS.items() if value == fmt)
+
+
+def write_header(path, name, data, sample_count, fmt):
+    guard = f"_{name.upper()}_MIDSIDE_H"
+    size = f"{name.upper()}_MIDSIDE_SZ"
+    nbytes = f"{name.upper()}_MIDSIDE_BYTES"
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* {name} as 16-bit mid and {format_name(fmt)} side (AUDIO_ENGINE_MIDSIDE_DEPTH) */",
+        f"#define {size} {sample_count}",
+        f"#define {nbytes} {len(data)}",
+        "",
+        f"const uint8_t {name}_midside[ {nbytes} ] __attribute__( ( aligned( 4 ) ) ) =",
+        "{",
+    ]
+    for i in range(0, len(data), 16):
+        row = ", ".join(f"0x{b:02X}" for b in data[i:i + 16])
+        lines.append(f"  {row}{',' if i + 16 < len(data) else ''}")
+    lines += ["};", "", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", type=Path, help="stereo 16-bit sound header or stereo 16-bit WAV file")
+    parser.add_argument("--side", choices=sorted(SIDE_FORMATS), help="side format (default: chosen from the content)")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <source>_midside.h)")
+    args = parser.parse_args()
+
+    if args.source.suffix.lower() == ".wav":
+        name, samples, channels = read_wav(args.source)
+        if channels != 2:
+            raise SystemExit("only stereo WAV files can be coded as mid/side")
+    else:
+        text = args.source.read_text()
+        if re.search(r"const\s+uint8_t\s+\w+\s*\[", text):
+            raise SystemExit("only 16-bit sound headers can be coded as mid/side")
+        name, samples = read_samples(text, 16)
+    samples = samples[:len(samples) & ~1]
+
+    data, fmt = encode(samples, SIDE_FORMATS[args.side] if args.side else None)
+    output = args.output or args.source.with_name(args.source.stem + "_midside.h")
+    write_header(output, name, data, len(samples), fmt)
+    print(f"{output}: {len(samples)} samples in {len(data)} bytes, {format_name(fmt)} side, "
+          f"{100 * len(data) / max(1, 2 * len(samples)):.0f}% of PCM16")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+Write an engine preset header for ApplyPreset().
+
+The preset holds the whole filter configuration, the air effect gain and the fade times, with
+the float conversions the setters would do at run time (CalcLpf16BitAlphaFromCutoff(),
+SetAirEffectGainDb(), SetLpfMakeupGain16Bit()) done here.  A cutoff frequency sets a custom LPF
+alpha for one output rate, --rate.  Fade times are stored in milliseconds and turned into
+sample counts at the playback rate with integer math.  Attach the preset to an asset with
+make_asset.py --preset.  make_asset.py --bake takes the same options to bake the LPF, DC blocker and
+air effect into the asset itself (Tools/bake_filters.py).
+
+Usage:
+    make_preset.py --name night --lpf16-cutoff 3000 --rate 22050 --air-db 2 -o night_preset.h
+"""
+
+import argparse
+import math
+from pathlib import Path
+
+LEVELS = {"off": "LPF_Off", "very-soft": "LPF_VerySoft", "soft": "LPF_Soft", "medium": "LPF_Medium",
+          "firm": "LPF_Firm", "aggressive": "LPF_Aggressive"}
+AIR_EFFECT_SHELF_GAIN_MAX = 131072
+ALPHA_MAX = 0.99998                                 # As the engine clamps its own conversions
+
+
+def q16(value):
+    return int(value * 65536.0 + 0.5)
+
+
+def alpha_16bit(cutoff_hz, rate):
+    """Q16 biquad alpha for a cutoff, as CalcLpf16BitAlphaFromCutoff()."""
+    return q16(min(ALPHA_MAX, math.exp(-2.0 * math.pi * cutoff_hz / rate)))
+
+
+def alpha_8bit(cutoff_hz, rate):
+    """Q16 one-pole alpha for a cutoff, as CalcLpf8BitAlphaFromCutoff()."""
+    return q16(min(ALPHA_MAX, 1.0 - math.exp(-2.0 * math.pi * cutoff_hz / rate)))
+
+
+def gain_q16(gain):
+    if not 0.1 <= gain <= 2.0:
+        raise SystemExit("makeup gains must be from 0.1 to 2.0")
+    return q16(gain)
+
+
+def fade_ms(seconds):
+    return min(5000, max(1, round(seconds * 1000.0)))
+
+
+def lpf_fields(level, cutoff, rate, alpha, default_alpha):
+    """Return (level, custom alpha, enable) for one LPF."""
+    if cutoff is not None:
+        if rate is None:
+            raise SystemExit("a cutoff frequency needs --rate")
+        return "LPF_Custom", alpha(cutoff, rate), 1
+    return LEVELS[level], default_alpha, 0 if level == "off" else 1
+
+
+def write_header(path, name, args):
+    lpf16 = lpf_fields(args.lpf16, args.lpf16_cutoff, args.rate, alpha_16bit, "LPF_16BIT_SOFT")
+    lpf8 = lpf_fields(args.lpf8, args.lpf8_cutoff, args.rate, alpha_8bit, "LPF_MEDIUM")
+    air_gain = min(AIR_EFFECT_SHELF_GAIN_MAX, q16(10.0 ** (args.air_db / 20.0))) if args.air_db is not None else 73533
+    guard = f"_{name.upper()}_PRESET_H"
+
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "/* Generated by Tools/make_preset.py: do not edit */",
+        "",
+        '#include "audio_engine.h"',
+        "",
+        f"const AudioEngine_Preset {name}_preset =",
+        "{",
+        "  .filter =",
+        "  {",
+        f"    .enable_16bit_biquad_lpf      = {lpf16[2]},",
+        f"    .enable_soft_dc_filter_16bit  = {0 if args.hard_dc else 1},",
+        f"    .enable_8bit_lpf              = {lpf8[2]},",
+        f"    .enable_noise_gate            = {1 if args.noise_gate else 0},",
+        f"    .enable_soft_clipping         = {0 if args.no_soft_clip else 1},",
+        f"    .enable_air_effect            = {1 if args.air_db is not None else 0},",
+        f"    .lpf_makeup_gain_q16          = {gain_q16(args.lpf8_makeup)}U,",
+        f"    .lpf_makeup_gain_16bit_q16    = {gain_q16(args.lpf16_makeup)}U,",
+        f"    .lpf_16bit_level              = {lpf16[0]},",
+        f"    .lpf_16bit_custom_alpha       = {lpf16[1]},",
+        f"    .lpf_8bit_level               = {lpf8[0]},",
+        f"    .lpf_8bit_custom_alpha        = {lpf8[1]},",
+        "    .enable_filter_chain_16bit    = 1,",
+        "    .enable_filter_chain_8bit     = 1",
+        "  },",
+        f"  .air_gain_q16   = {air_gain}U,",
+        f"  .fade_in_ms     = {fade_ms(args.fade_in)}U,",
+        f"  .fade_out_ms    = {fade_ms(args.fade_out)}U,",
+        f"  .pause_fade_ms  = {fade_ms(args.pause_fade)}U,",
+        f"  .resume_fade_ms = {fade_ms(args.resume_fade)}U,",
+        f"  .faders_enabled = {0 if args.no_faders else 1}U",
+        "};",
+        "",
+        f"#endif // End of {guard}",
+        "",
+    ]
+    path.write_text("\n".join(lines))
+
+
+def add_options(parser):
+    """The filter and fader options, shared with make_asset.py --bake."""
+    parser.add_argument("--rate", type=float, help="output rate in Hz the cutoff frequencies are for")
+    parser.add_argument("--lpf16", choices=LEVELS, default="off", help="16-bit LPF level (default: off)")
+    parser.add_argument("--lpf16-cutoff", type=float, metavar="HZ", help="16-bit LPF cutoff instead of a level")
+    parser.add_argument("--lpf16-makeup", type=float, default=1.0, help="gain after the 16-bit LPF (default: 1.0)")
+    parser.add_argument("--lpf8", choices=LEVELS, default="medium", help="8-bit LPF level (default: medium)")
+    parser.add_argument("--lpf8-cutoff", type=float, metavar="HZ", help="8-bit LPF cutoff instead of a level")
+    parser.add_argument("--lpf8-makeup", type=float, default=70779 / 65536, help="gain after the 8-bit LPF (default: 1.08)")
+    parser.add_argument("--air-db", type=float, help="enable the air effect with this shelf boost in dB")
+    parser.add_argument("--noise-gate", action="store_true", help="enable the noise gate")
+    parser.add_argument("--no-soft-clip", action="store_true", help="disable the soft clipper")
+    parser.add_argument("--hard-dc", action="store_true", help="standard rather than soft DC filter for 16-bit samples")
+    parser.add_argument("--fade-in", type=float, default=0.15, metavar="S", help="fade-in time (default: 0.15 s)")
+    parser.add_argument("--fade-out", type=float, default=0.15, metavar="S", help="fade-out time (default: 0.15 s)")
+    parser.add_argument("--pause-fade", type=float, default=0.1, metavar="S", help="pause fade-out time (default: 0.1 s)")
+    parser.add_argument("--resume-fade", type=float, default=0.1, metavar="S", help="resume fade-in time (default: 0.1 s)")
+    parser.add_argument("--no-faders", action="store_true", help="disable the faders")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--name", required=True, help="C name prefix; the preset is <name>_preset")
+    add_options(parser)
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <name>_preset.h)")
+    args = parser.parse_args()
+
+    output = args.output or Path(f"{args.name}_preset.h")
+    write_header(output, args.name, args)
+    print(f"{output}: {args.name}_preset")
+
+
+if __name__ == "__main__":
+    main()
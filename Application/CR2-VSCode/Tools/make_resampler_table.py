@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""
+Print the audio engine's polyphase resampler coefficients (resample_sinc_table in audio_engine.c).
+
+Each of the --phases rows holds the --taps coefficients of a Kaiser-windowed sinc, in Q15,
+for one fractional position between two source frames: tap k weighs source frame
+pos - (taps / 2 - 1) + k.  The cutoff is a fraction of the source Nyquist frequency, so the
+table suits conversion up to the bus rate.  Each row is scaled to a DC gain of exactly 32768.
+
+Usage:
+    make_resampler_table.py --phases 128 --taps 8 > table.txt
+"""
+
+import argparse
+import math
+
+
+def bessel_i0(x):
+    term, total, k = 1.0, 1.0, 1
+    while term > 1e-12 * total:
+        term *= (x / (2 * k)) ** 2
+        total += term
+        k += 1
+    return total
+
+
+def row(frac, taps, cutoff, beta):
+    half = taps // 2
+    values = []
+    for k in range(taps):
+        t = k - (half - 1) - frac                  # Distance from the output position, in source frames
+        x = math.pi * cutoff * t
+        sinc = 1.0 if t == 0 else math.sin(x) / x
+        w = t / half
+        window = bessel_i0(beta * math.sqrt(1 - w * w)) / bessel_i0(beta) if abs(w) < 1 else 0.0
+        values.append(sinc * window)
+    scale = 32768 / sum(values)
+    coeffs = [round(v * scale) for v in values]
+    coeffs[max(range(taps), key=lambda i: coeffs[i])] += 32768 - sum(coeffs)   # Exact DC gain
+    return coeffs
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--phases", type=int, default=128, help="rows (RESAMPLE_PHASES)")
+    parser.add_argument("--taps", type=int, default=8, help="coefficients per row (RESAMPLE_TAPS)")
+    parser.add_argument("--cutoff", type=float, default=0.9, help="cutoff as a fraction of the source Nyquist frequency")
+    parser.add_argument("--beta", type=float, default=6.0, help="Kaiser window beta")
+    args = parser.parse_args()
+
+    print(f"static const int16_t resample_sinc_table[ RESAMPLE_PHASES ][ RESAMPLE_TAPS ] __attribute__( ( aligned( 4 ) ) ) = {{")
+    for p in range(args.phases):
+        coeffs = row(p / args.phases, args.taps, args.cutoff, args.beta)
+        sep = "," if p + 1 < args.phases else ""
+        print("  { " + ", ".join(f"{c:6d}" for c in coeffs) + " }" + sep)
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
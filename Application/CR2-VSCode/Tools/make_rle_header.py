@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Convert a 16-bit sound header in Core/Inc/sound_headers, or a 16-bit PCM WAV file, to 16-bit PCM
+with its silent stretches run-length coded (AUDIO_ENGINE_SILENCE_RLE_DEPTH).
+
+A frame is silent when every channel is within THRESHOLD of zero.  Silent stretches of at least
+MIN_FRAMES frames, and any at the start or end, are stored as a count and played as zeros; the
+rest is stored as it is.  Chimes with pauses between their strikes, and sounds padded for
+timing, shrink by their silence, and the engine fills the gaps without reading flash.
+
+The data is word aligned: the segment count, then a silent and a stored frame count per segment,
+then the stored frames of every segment, interleaved for stereo.  Play it with
+PlaySample( name_rle, NAME_RLE_SZ, rate, AUDIO_ENGINE_SILENCE_RLE_DEPTH, mode ); NAME_RLE_SZ
+counts the silent frames, so the sound keeps its length.
+
+Usage:
+    make_rle_header.py Core/Inc/sound_headers/doors_opening.h
+    make_rle_header.py chime.wav --threshold 8 -o Core/Inc/sound_headers/chime_rle.h
+"""
+
+import argparse
+import re
+import struct
+from pathlib import Path
+
+from make_adpcm_header import read_wav
+from make_silence_map import read_samples
+
+THRESHOLD = 16                           # Largest sample, in 16-bit units, of a silent frame
+MIN_FRAMES = 128                         # Shortest silent stretch inside the sound worth a segment
+
+
+def silent_runs(samples, channels, threshold):
+    """(start, end) frames of each stretch of silent frames, end exclusive."""
+    frames = len(samples) // channels
+    runs, start = [], None
+    for f in range(frames):
+        quiet = all(abs(s) <= threshold for s in samples[f * channels:(f + 1) * channels])
+        if quiet and start is None:
+            start = f
+        elif not quiet and start is not None:
+            runs.append((start, f))
+            start = None
+    if start is not None:
+        runs.append((start, frames))
+    return runs
+
+
+def encode(samples, channels, threshold=THRESHOLD, min_frames=MIN_FRAMES):
+    """Return the data and the number of frames stored rather than run-length coded."""
+    frames = len(samples) // channels
+    gaps = [(a, b) for a, b in silent_runs(samples, channels, threshold)
+            if b - a >= min_frames or a == 0 or b == frames]
+    table, pcm, pos = [], [], 0                           # [silent, stored] frames per segment
+    for a, b in gaps + [(frames, frames)]:
+        if a > pos:
+            if not table:
+                table.append([0, 0])                      # Starts with sound
+            table[-1][1] = a - pos
+            pcm += samples[pos * channels:a * channels]
+        if b > a:
+            table.append([b - a, 0])
+        pos = b
+    out = bytearray(struct.pack("<I", len(table)))
+    for silent, stored in table:
+        out += struct.pack("<II", silent, stored)
+    out += struct.pack(f"<{len(pcm)}h", *pcm)
+    out += bytes(-len(out) % 4)
+    return out, len(pcm) // channels
+
+
+def write_header(path, name, data, sample_count):
+    guard = f"_{name.upper()}_RLE_H"
+    size = f"{name.upper()}_RLE_SZ"
+    nbytes = f"{name.upper()}_RLE_BYTES"
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* {name} as 16-bit PCM with run-length coded silence (AUDIO_ENGINE_SILENCE_RLE_DEPTH) */",
+        f"#define {size} {sample_count}",
+        f"#define {nbytes} {len(data)}",
+        "",
+        f"const uint8_t {name}_rle[ {nbytes} ] __attribute__( ( aligned( 4 ) ) ) =",
+        "{",
+    ]
+    for i in range(0, len(data), 16):
+        row = ", ".join(f"0x{b:02X}" for b in data[i:i + 16])
+        lines.append(f"  {row}{',' if i + 16 < len(data) else ''}")
+    lines += ["};", "", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", type=Path, help="16-bit sound header or 16-bit WAV file, mono or stereo")
+    parser.add_argument("--channels", type=int, choices=(1, 2), default=1, help="channels of a sound header (default: 1)")
+    parser.add_argument("--threshold", type=int, default=THRESHOLD,
+                        help=f"largest sample of a silent frame (default: {THRESHOLD})")
+    parser.add_argument("--min-frames", type=int, default=MIN_FRAMES,
+                        help=f"shortest silent stretch coded inside the sound (default: {MIN_FRAMES})")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <source>_rle.h)")
+    args = parser.parse_args()
+
+    if args.source.suffix.lower() == ".wav":
+        name, samples, channels = read_wav(args.source)
+    else:
+        text = args.source.read_text()
+        if re.search(r"const\s+uint8_t\s+\w+\s*\[", text):
+            raise SystemExit("only 16-bit sound headers can be run-length coded")
+        name, samples = read_samples(text, 16)
+        channels = args.channels
+    samples = samples[:len(samples) - len(samples) % channels]
+
+    data, stored = encode(samples, channels, args.threshold, args.min_frames)
+    output = args.output or args.source.with_name(args.source.stem + "_rle.h")
+    write_header(output, name, data, len(samples))
+    frames = len(samples) // channels
+    print(f"{output}: {frames} frames, {frames - stored} of them silent, in {len(data)} bytes, "
+          f"{100 * len(data) / max(1, 2 * len(samples)):.0f}% of PCM16")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,347 @@
+#!/usr/bin/env python3
+"""
+Compress a 16-bit sound header in Core/Inc/sound_headers, or a 16-bit PCM WAV file, with SBC.
+
+The frames follow the A2DP SBC layout (sync byte 0x9C, sampling frequency, blocks, channel
+mode, allocation method, subbands, bitpool and CRC-8, then the join bits, 4-bit scale factors
+and the quantised subband samples), and the bits of each subband come from the scale factors
+by the SBC loudness or SNR allocation, so the decoder needs only the frame.  The filterbank is
+this tool's own: a cosine-modulated bank of --subbands bands from a 10 x subbands-tap Kaiser
+prototype (PROTOTYPE_BETA), which the engine's synthesis tables match, so frames from other SBC
+encoders do not decode through it.  The tail is padded with the filterbank delay, which the
+decoder skips at the start, so decoded sample n is source sample n.
+
+Middle-quality settings (the default bitpool, 8 subbands, 16 blocks) store mono at about 5.5x
+and joint stereo at about 6x less than PCM16.  Play it with
+PlaySample( name_sbc, NAME_SBC_SZ, rate, AUDIO_ENGINE_SBC_DEPTH, mode ).
+
+--tables prints the synthesis tables (sbc_synth_* in audio_engine.c) instead.
+
+Usage:
+    make_sbc_header.py Core/Inc/sound_headers/steves_doorbell.h --rate 22050
+    make_sbc_header.py music.wav --bitpool 45 -o Core/Inc/sound_headers/music_sbc.h
+    make_sbc_header.py --tables > tables.txt
+"""
+
+import argparse
+import math
+import re
+import wave
+from pathlib import Path
+
+from make_adpcm_header import read_wav
+from make_silence_map import read_samples
+
+PROTOTYPE_TAPS_PER_BAND = 10
+PROTOTYPE_BETA = 8.5
+DELAY_BLOCKS = 9                # Filterbank delay in blocks (the decoder's SBC_PRIME_BLOCKS)
+SYNC = 0x9C
+MODE_MONO, MODE_DUAL, MODE_STEREO, MODE_JOINT = range(4)
+DEFAULT_BITPOOL = {1: 19, 2: 35}
+
+OFFSET4 = ((-1, 0, 0, 0), (-2, 0, 0, 1), (-2, 0, 0, 1), (-2, 0, 0, 1))
+OFFSET8 = ((-2, 0, 0, 0, 0, 0, 0, 1), (-3, 0, 0, 0, 0, 0, 1, 2),
+           (-4, 0, 0, 0, 0, 0, 1, 2), (-4, 0, 0, 0, 0, 0, 1, 2))
+
+
+def bessel_i0(x):
+    term, total, k = 1.0, 1.0, 1
+    while term > 1e-12 * total:
+        term *= (x / (2 * k)) ** 2
+        total += term
+        k += 1
+    return total
+
+
+def magnitude(p, w):
+    return math.hypot(sum(v * math.cos(w * n) for n, v in enumerate(p)),
+                      sum(v * math.sin(w * n) for n, v in enumerate(p)))
+
+
+def prototype(subbands):
+    """Kaiser-windowed sinc of unity DC gain, its cutoff set for half power at pi / (2 x subbands)."""
+    taps = PROTOTYPE_TAPS_PER_BAND * subbands
+    centre = (taps - 1) / 2
+    lo, hi = 0.1 / subbands, 0.5 / subbands
+    for _ in range(50):
+        cutoff = (lo + hi) / 2
+        p = []
+        for n in range(taps):
+            t = n - centre
+            sinc = 2 * cutoff if t == 0 else math.sin(2 * math.pi * cutoff * t) / (math.pi * t)
+            p.append(sinc * bessel_i0(PROTOTYPE_BETA * math.sqrt(1 - (t / centre) ** 2)) / bessel_i0(PROTOTYPE_BETA))
+        total = sum(p)
+        p = [v / total for v in p]
+        if magnitude(p, math.pi / (2 * subbands)) ** 2 > 0.5:
+            hi = cutoff
+        else:
+            lo = cutoff
+    return p
+
+
+def modulation(subbands, synthesis):
+    """cos((k + 1/2)(i - centre) pi / M -+ phase_k) for i in 0..2M-1, rows i, columns k."""
+    centre = (PROTOTYPE_TAPS_PER_BAND * subbands - 1) / 2
+    sign = -1 if synthesis else 1
+    return [[math.cos((k + 0.5) * (i - centre) * math.pi / subbands + sign * (-1) ** k * math.pi / 4)
+             for k in range(subbands)] for i in range(2 * subbands)]
+
+
+class Analysis:
+    """Polyphase analysis: per block of M new samples, the M subband samples."""
+
+    def __init__(self, subbands):
+        self.m = subbands
+        self.window = [2 * v * (-1) ** (n // (2 * subbands)) for n, v in enumerate(prototype(subbands))]
+        self.matrix = modulation(subbands, False)
+        self.x = [0.0] * len(self.window)               # Newest first
+
+    def block(self, samples):
+        self.x = list(reversed(samples)) + self.x[:-self.m]
+        m2 = 2 * self.m
+        y = [sum(self.window[i + j] * self.x[i + j] for j in range(0, len(self.window), m2)) for i in range(m2)]
+        return [sum(self.matrix[i][k] * y[i] for i in range(m2)) for k in range(self.m)]
+
+
+def allocate_channel(scale, subbands, fs, snr):
+    if snr:
+        return list(scale)
+    offsets = (OFFSET4 if subbands == 4 else OFFSET8)[fs]
+    need = []
+    for sb in range(subbands):
+        if scale[sb] == 0:
+            need.append(-5)
+        else:
+            loudness = scale[sb] - offsets[sb]
+            need.append(loudness // 2 if loudness > 0 else loudness)
+    return need
+
+
+def allocate(scale, channels, subbands, fs, snr, bitpool, mode):
+    """SBC bit allocation: bits[ch][sb] from the scale factors, as the decoder computes it."""
+    groups = [[0], [1]] if mode == MODE_DUAL else [list(range(channels))]
+    bits = [[0] * subbands for _ in range(channels)]
+    for group in groups:
+        need = {(ch, sb): v for ch in group for sb, v in enumerate(allocate_channel(scale[ch], subbands, fs, snr))}
+        order = [(ch, sb) for sb in range(subbands) for ch in group] if len(group) > 1 else [(group[0], sb) for sb in range(subbands)]
+        bitslice = max(need.values()) + 1
+        bitcount = slicecount = 0
+        while True:
+            bitslice -= 1
+            bitcount += slicecount
+            slicecount = 0
+            for v in need.values():
+                if bitslice + 1 < v < bitslice + 16:
+                    slicecount += 1
+                elif v == bitslice + 1:
+                    slicecount += 2
+            if bitcount + slicecount >= bitpool:
+                break
+        if bitcount + slicecount == bitpool:
+            bitcount += slicecount
+            bitslice -= 1
+        for ch, sb in order:
+            bits[ch][sb] = 0 if need[ch, sb] < bitslice + 2 else min(need[ch, sb] - bitslice, 16)
+        for ch, sb in order:
+            if bitcount >= bitpool:
+                break
+            if 2 <= bits[ch][sb] < 16:
+                bits[ch][sb] += 1
+                bitcount += 1
+            elif need[ch, sb] == bitslice + 1 and bitpool > bitcount + 1:
+                bits[ch][sb] = 2
+                bitcount += 2
+        for ch, sb in order:
+            if bitcount >= bitpool:
+                break
+            if bits[ch][sb] < 16:
+                bits[ch][sb] += 1
+                bitcount += 1
+    return bits
+
+
+def scale_factor(values):
+    peak = max(abs(v) for v in values)
+    sf = 0
+    while sf < 15 and peak >= 2 << sf:
+        sf += 1
+    return sf
+
+
+def crc8(data_bits):
+    crc = 0x0F
+    for bit in data_bits:
+        top = (crc >> 7) ^ bit
+        crc = (crc << 1) & 0xFF
+        if top:
+            crc ^= 0x1D
+    return crc
+
+
+class BitWriter:
+    def __init__(self):
+        self.bits = []
+
+    def put(self, value, count):
+        self.bits += [(value >> (count - 1 - i)) & 1 for i in range(count)]
+
+    def to_bytes(self):
+        self.bits += [0] * (-len(self.bits) % 8)
+        return bytes(int("".join(map(str, self.bits[i:i + 8])), 2) for i in range(0, len(self.bits), 8))
+
+
+def encode(samples, channels, subbands, blocks, bitpool, fs, snr, joint):
+    """Encode interleaved 16-bit samples into SBC frames, with 4 bytes of tail padding."""
+    frames = len(samples) // channels
+    mode = MODE_MONO if channels == 1 else MODE_JOINT if joint else MODE_STEREO
+    per_frame = subbands * blocks
+    padded = frames + DELAY_BLOCKS * subbands
+    padded += -padded % per_frame
+    pcm = [[samples[f * channels + c] if f < frames else 0 for f in range(padded)] for c in range(channels)]
+    banks = [Analysis(subbands) for _ in range(channels)]
+    out = bytearray()
+
+    for start in range(0, padded, per_frame):
+        sb = [[banks[c].block(pcm[c][start + b * subbands:start + (b + 1) * subbands]) for b in range(blocks)]
+              for c in range(channels)]
+        join = [0] * subbands
+        if mode == MODE_JOINT:
+            for k in range(subbands - 1):
+                left = [sb[0][b][k] for b in range(blocks)]
+                right = [sb[1][b][k] for b in range(blocks)]
+                mid = [(l + r) / 2 for l, r in zip(left, right)]
+                side = [(l - r) / 2 for l, r in zip(left, right)]
+                if scale_factor(mid) + scale_factor(side) < scale_factor(left) + scale_factor(right):
+                    join[k] = 1
+                    for b in range(blocks):
+                        sb[0][b][k], sb[1][b][k] = mid[b], side[b]
+        scale = [[scale_factor([sb[c][b][k] for b in range(blocks)]) for k in range(subbands)] for c in range(channels)]
+        bits = allocate(scale, channels, subbands, fs, snr, bitpool, mode)
+
+        w = BitWriter()
+        header = [(fs << 6) | ((blocks // 4 - 1) << 4) | (mode << 2) | (int(snr) << 1) | (subbands == 8), bitpool]
+        checked = BitWriter()
+        for byte in header:
+            checked.put(byte, 8)
+        if mode == MODE_JOINT:
+            for k in range(subbands):
+                checked.put(join[k], 1)
+        for c in range(channels):
+            for k in range(subbands):
+                checked.put(scale[c][k], 4)
+        w.put(SYNC, 8)
+        w.put(header[0], 8)
+        w.put(bitpool, 8)
+        w.put(crc8(checked.bits), 8)
+        w.bits += checked.bits[16:]
+        for b in range(blocks):
+            for c in range(channels):
+                for k in range(subbands):
+                    n = bits[c][k]
+                    if n:
+                        levels = (1 << n) - 1
+                        u = sb[c][b][k] / (2 << scale[c][k])
+                        w.put(min(levels - 1, max(0, int(math.floor((u + 1) * levels / 2)))), n)
+        out += w.to_bytes()
+    out += bytes(4)                                     # The decoder's bit cache reads ahead
+    return out, frames * channels
+
+
+def encode_default(samples, channels, rate):
+    """Encode with the middle-quality defaults: 8 subbands, 16 blocks, loudness allocation, joint stereo."""
+    return encode(samples, channels, 8, 16, DEFAULT_BITPOOL[channels], frequency_code(rate), False, True)
+
+
+def q30(v):
+    return max(-(1 << 31), min((1 << 31) - 1, round(v * (1 << 30))))
+
+
+def print_tables():
+    for m in (4, 8):
+        n = modulation(m, True)
+        d = [2 * m * v * (-1) ** (i // (2 * m)) for i, v in enumerate(prototype(m))]
+        print(f"static const int32_t sbc_synth_matrix{m}[ {2 * m} ][ {m} ] = {{")
+        for i, row in enumerate(n):
+            print("  { " + ", ".join(f"{q30(v):11d}" for v in row) + " }" + ("," if i + 1 < len(n) else ""))
+        print("};")
+        print(f"static const int32_t sbc_synth_window{m}[ {len(d)} ] = {{")
+        for i in range(0, len(d), 8):
+            print("  " + ", ".join(f"{q30(v):11d}" for v in d[i:i + 8]) + ("," if i + 8 < len(d) else ""))
+        print("};")
+
+
+def write_header(path, name, data, sample_count, subbands, blocks, bitpool):
+    guard = f"_{name.upper()}_SBC_H"
+    size = f"{name.upper()}_SBC_SZ"
+    nbytes = f"{name.upper()}_SBC_BYTES"
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* {name} in SBC frames of {blocks} blocks of {subbands} subbands, bitpool {bitpool} (AUDIO_ENGINE_SBC_DEPTH) */",
+        f"#define {size} {sample_count}",
+        f"#define {nbytes} {len(data)}",
+        "",
+        f"const uint8_t {name}_sbc[ {nbytes} ] __attribute__( ( aligned( 4 ) ) ) =",
+        "{",
+    ]
+    for i in range(0, len(data), 16):
+        row = ", ".join(f"0x{b:02X}" for b in data[i:i + 16])
+        lines.append(f"  {row}{',' if i + 16 < len(data) else ''}")
+    lines += ["};", "", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def frequency_code(rate):
+    return 0 if rate <= 16000 else 1 if rate <= 32000 else 2 if rate <= 44100 else 3
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", type=Path, nargs="?", help="16-bit sound header or 16-bit WAV file")
+    parser.add_argument("--channels", type=int, choices=(1, 2), default=1, help="1 for mono, 2 for stereo (headers only)")
+    parser.add_argument("--rate", type=int, default=44100, help="sample rate, which picks the loudness offsets (WAV files carry their own)")
+    parser.add_argument("--subbands", type=int, choices=(4, 8), default=8, help="subbands per block")
+    parser.add_argument("--blocks", type=int, choices=(4, 8, 12, 16), default=16, help="blocks per frame")
+    parser.add_argument("--bitpool", type=int, help="bits per block per channel group (default: 19 mono, 35 stereo)")
+    parser.add_argument("--snr", action="store_true", help="SNR bit allocation rather than loudness")
+    parser.add_argument("--no-joint", action="store_true", help="code stereo as left and right, never mid and side")
+    parser.add_argument("--tables", action="store_true", help="print the decoder's synthesis tables and exit")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <source>_sbc.h)")
+    args = parser.parse_args()
+
+    if args.tables:
+        print_tables()
+        return
+    if args.source is None:
+        parser.error("a source is needed unless --tables is given")
+
+    rate = args.rate
+    if args.source.suffix.lower() == ".wav":
+        name, samples, channels = read_wav(args.source)
+        with wave.open(str(args.source), "rb") as wav:
+            rate = wav.getframerate()
+    else:
+        text = args.source.read_text()
+        if re.search(r"const\s+uint8_t\s+\w+\s*\[", text):
+            raise SystemExit("only 16-bit sound headers can be coded with SBC")
+        name, samples = read_samples(text, 16)
+        channels = args.channels
+
+    bitpool = args.bitpool or DEFAULT_BITPOOL[channels]
+    limit = 16 * args.subbands * channels
+    if not 2 <= bitpool <= min(250, limit):
+        raise SystemExit(f"--bitpool must be 2 to {min(250, limit)}")
+
+    data, sample_count = encode(samples, channels, args.subbands, args.blocks, bitpool,
+                                frequency_code(rate), args.snr, not args.no_joint)
+    output = args.output or args.source.with_name(args.source.stem + "_sbc.h")
+    write_header(output, name, data, sample_count, args.subbands, args.blocks, bitpool)
+    print(f"{output}: {sample_count} samples in {len(data)} bytes, "
+          f"{2 * sample_count / max(1, len(data)):.1f}x smaller than PCM16")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Assemble a chime script for AudioEngine_RunSequence() into a C header.
+
+One instruction per line, '#' at the start of a word starts a comment, and 'name:' on its own
+line labels the next instruction for jump and branch.  Slots are sequencer voices from 0, sounds
+are entries of the AudioEngine_Sequence's table, gains 0-65535, pans -127 to 127 and pitches in
+cents:
+
+    play SLOT SOUND [GAIN [PAN]]        wait FRAMES           gain SLOT GAIN
+    fade SLOT GAIN MS                   wait_ms MS            pan SLOT PAN
+    pitch SLOT CENTS                    wait_voice SLOT       stop SLOT
+    loop COUNT (0 for ever) ... next    jump LABEL            branch MASK VALUE LABEL
+    note SLOT NOTE [VELOCITY]           release SLOT          end
+
+A branch jumps when the sequence's read_input() masked with MASK equals VALUE.  A note plays
+on the sequence's instrument (AUDIO_ENGINE_ENABLE_SAMPLER); NOTE is a MIDI number or a name
+such as C4, F#3 or Bb5 (C4 is 60), the velocity 1-127, 127 if left out.
+
+Usage:
+    make_sequence.py doorbell.seq --name doorbell -o doorbell_sequence.h
+
+with doorbell.seq:
+    play 0 0                # ding
+    wait_ms 200
+    loop 2
+      play 1 1              # dong, twice
+      wait_voice 1
+    next
+    fade 2 0 1500           # the music on slot 2 fades out
+"""
+
+import argparse
+import re
+import struct
+from pathlib import Path
+
+OPS = {                                     # AudioEngine_SeqOp: opcode and operand formats
+    "end": (0x00, ""), "play": (0x01, "BBHb"), "wait": (0x02, "I"), "wait_ms": (0x03, "H"),
+    "wait_voice": (0x04, "B"), "gain": (0x10, "BH"), "fade": (0x11, "BHH"), "pan": (0x12, "Bb"),
+    "pitch": (0x13, "Bh"), "stop": (0x14, "B"), "loop": (0x20, "B"), "next": (0x21, ""),
+    "jump": (0x22, "h"), "branch": (0x23, "BBh"), "note": (0x05, "BBB"), "release": (0x15, "B"),
+}
+DEFAULTS = {"play": [65535, 0], "note": [127]}   # Operands an instruction may leave out
+NOTE_NAMES = {"C": 0, "D": 2, "E": 4, "F": 5, "G": 7, "A": 9, "B": 11}
+
+
+def note_number(arg):
+    """MIDI number of a note given as a number or a name with its octave, C4 being 60."""
+    if arg[0].upper() not in NOTE_NAMES:
+        return int(arg, 0)
+    pitch, rest = NOTE_NAMES[arg[0].upper()], arg[1:]
+    while rest[:1] in ("#", "b"):
+        pitch += 1 if rest[0] == "#" else -1
+        rest = rest[1:]
+    return pitch + 12 * (int(rest) + 1)
+
+
+def parse(text):
+    """List of (line number, mnemonic, operand strings) and label offsets."""
+    program, labels, offset = [], {}, 0
+    for number, line in enumerate(text.splitlines(), 1):
+        words = re.split(r"(?:^|\s)#", line, 1)[0].split()
+        if not words:
+            continue
+        if len(words) == 1 and words[0].endswith(":"):
+            labels[words[0][:-1]] = offset
+            continue
+        if words[0] not in OPS:
+            raise SystemExit(f"line {number}: unknown instruction {words[0]}")
+        program.append((number, words[0], words[1:]))
+        offset += 1 + struct.calcsize("<" + OPS[words[0]][1])
+    return program, labels
+
+
+def assemble(text):
+    program, labels = parse(text)
+    code = bytearray()
+    for number, op, args in program:
+        opcode, fmt = OPS[op]
+        fill, missing = DEFAULTS.get(op, []), len(fmt) - len(args)
+        if 0 < missing <= len(fill):
+            args = args + [str(v) for v in fill[len(fill) - missing:]]
+        if len(args) != len(fmt):
+            raise SystemExit(f"line {number}: {op} takes {len(fmt)} operands")
+        end = len(code) + 1 + struct.calcsize("<" + fmt)
+        values = []
+        for arg, kind in zip(args, fmt):
+            if op in ("jump", "branch") and kind == "h":
+                if arg not in labels:
+                    raise SystemExit(f"line {number}: no label {arg}")
+                values.append(labels[arg] - end)
+            elif op == "note" and len(values) == 1:
+                values.append(note_number(arg))
+            else:
+                values.append(int(arg, 0))
+        try:
+            code += bytes([opcode]) + struct.pack("<" + fmt, *values)
+        except struct.error as err:
+            raise SystemExit(f"line {number}: {err}")
+    return bytes(code)
+
+
+def write_header(path, name, code):
+    guard = f"_{name.upper()}_SEQUENCE_H"
+    rows = [", ".join(f"0x{b:02X}" for b in code[i:i + 12]) for i in range(0, len(code), 12)]
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "/* Generated by Tools/make_sequence.py: do not edit */",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"static const uint8_t {name}_sequence[ {len(code)} ] = {{",
+        ",\n".join(f"  {row}" for row in rows),
+        "};",
+        "",
+        f"#endif // End of {guard}",
+        "",
+    ]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("script", type=Path, help="chime script")
+    parser.add_argument("--name", required=True, help="C name prefix; the code is <name>_sequence")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <name>_sequence.h)")
+    args = parser.parse_args()
+
+    code = assemble(args.script.read_text())
+    output = args.output or Path(f"{args.name}_sequence.h")
+    write_header(output, args.name, code)
+    print(f"{output}: {args.name}_sequence, {len(code)} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""
+Generate a silence map header for a sound header in Core/Inc/sound_headers.
+
+A silence map holds the peak magnitude of each block of source frames, in 16-bit units.
+Pass it to AudioEngine_SetSilenceMap() before playing the sample, and periods that lie
+wholly below the noise gate threshold skip the filter chain.
+
+Usage:
+    make_silence_map.py Core/Inc/sound_headers/bong.h --depth 16 --channels 1
+"""
+
+import argparse
+import re
+from pathlib import Path
+
+DEFAULT_BLOCK_FRAMES = 256  # AUDIO_ENGINE_SILENCE_MAP_BLOCK_FRAMES
+
+ARRAY_RE = re.compile(r"const\s+(uint8_t|uint16_t|int16_t)\s+(\w+)\s*\[[^\]]*\]\s*=\s*\{(.*?)\};", re.S)
+
+
+def read_samples(text, depth):
+    """Return the array name and its samples as signed 16-bit values."""
+    match = ARRAY_RE.search(text)
+    if match is None:
+        raise SystemExit("no sample array found")
+    ctype, name, body = match.groups()
+    values = [int(v, 0) for v in re.findall(r"0x[0-9A-Fa-f]+|\d+", body)]
+
+    if ctype == "uint8_t" and depth == 16:  # 16-bit data stored as little-endian bytes
+        values = [values[i] | (values[i + 1] << 8) for i in range(0, len(values) - 1, 2)]
+    if depth == 8:
+        return name, [(v - 128) << 8 for v in values]
+    return name, [v - 0x10000 if v >= 0x8000 else v for v in values]
+
+
+def block_peaks(samples, channels, block_frames):
+    """Peak magnitude of each block of frames, all channels together."""
+    step = block_frames * channels
+    peaks = []
+    for start in range(0, len(samples), step):
+        block = samples[start:start + step]
+        peaks.append(min(max(abs(v) for v in block), 0xFFFF))
+    return peaks
+
+
+def write_header(path, name, peaks, block_frames):
+    guard = f"_{name.upper()}_PEAKS_H"
+    count = f"{name.upper()}_PEAK_BLOCKS"
+    lines = [
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* Silence map for {name}: peak of each {block_frames} frames (AudioEngine_SetSilenceMap()) */",
+        f"#define {count} {len(peaks)}",
+        "",
+        f"const uint16_t {name}_peaks[ {count} ] =",
+        "{",
+    ]
+    for i in range(0, len(peaks), 8):
+        row = ", ".join(f"0x{p:04X}" for p in peaks[i:i + 8])
+        lines.append(f"  {row}{',' if i + 8 < len(peaks) else ''}")
+    lines += ["};", "", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("header", type=Path, help="sound header to scan")
+    parser.add_argument("--depth", type=int, choices=(8, 16), help="bits per sample (default: from the array type)")
+    parser.add_argument("--channels", type=int, choices=(1, 2), default=1, help="1 for mono, 2 for stereo")
+    parser.add_argument("--block-frames", type=int, default=DEFAULT_BLOCK_FRAMES,
+                        help="frames per entry, matching AUDIO_ENGINE_SILENCE_MAP_BLOCK_FRAMES")
+    parser.add_argument("-o", "--output", type=Path, help="output header (default: <header>_peaks.h)")
+    args = parser.parse_args()
+
+    text = args.header.read_text()
+    depth = args.depth
+    if depth is None:
+        depth = 8 if re.search(r"const\s+uint8_t\s+\w+\s*\[", text) else 16
+    name, samples = read_samples(text, depth)
+    peaks = block_peaks(samples, args.channels, args.block_frames)
+
+    output = args.output or args.header.with_name(args.header.stem + "_peaks.h")
+    write_header(output, name, peaks, args.block_frames)
+    print(f"{output}: {len(peaks)} blocks, {sum(p < 512 for p in peaks)} below the noise gate")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Build a stream image of WAV files for external flash, played with PlayStreamedAsset().
+
+The image is an 8-byte header (AUDIO_ENGINE_STREAM_MAGIC "CR2S" and the entry count), an
+index of 20-byte AudioEngine_StreamEntry records sorted by ID, then each sample's data,
+word aligned.  Program it at the address given to AudioEngine_SourceStreamInit().  IDs are
+given as ID=file.wav; a file without one takes the ID after the previous file's.
+--header writes a C header naming the IDs.
+
+Usage:
+    make_stream_image.py 1=chime.wav bong.wav 10=westminster.wav -o chimes.bin --header chime_ids.h
+"""
+
+import argparse
+import re
+import struct
+from pathlib import Path
+
+from make_asset import encode, read_wav
+
+MAGIC = b"CR2S"
+ENTRY = struct.Struct("<IIIIBBH")
+ENCODINGS = {"pcm16": 0, "pcm8": 1}  # AudioAsset_Encoding
+
+
+def parse_entries(args):
+    entries, next_id = {}, 0
+    for arg in args:
+        ident, sep, path = arg.partition("=")
+        if sep:
+            next_id = int(ident, 0)
+        else:
+            path = arg
+        if next_id in entries:
+            raise SystemExit(f"{path}: ID {next_id} is already taken by {entries[next_id]}")
+        entries[next_id] = Path(path)
+        next_id += 1
+    return entries
+
+
+def build_image(entries, encoding):
+    index, data = [], bytearray()
+    data_start = 8 + ENTRY.size * len(entries)
+    for ident, path in sorted(entries.items()):
+        rate, channels, samples = read_wav(path)
+        samples = samples[:len(samples) - len(samples) % channels]
+        ctype, values, _ = encode(samples, channels, encoding, 0)
+        blob = struct.pack(f"<{len(values)}H", *values) if ctype == "uint16_t" else bytes(values)
+        index.append(ENTRY.pack(ident, data_start + len(data), len(samples), rate, ENCODINGS[encoding], channels, 0))
+        data += blob + bytes(-len(blob) % 4)
+    return MAGIC + struct.pack("<I", len(entries)) + b"".join(index) + data
+
+
+def write_header(path, entries):
+    guard = "_" + re.sub(r"\W", "_", path.stem).upper() + "_H"
+    lines = [f"#ifndef {guard}", f"#define {guard}", "", "/* Generated by Tools/make_stream_image.py: do not edit */", ""]
+    for ident, wav in sorted(entries.items()):
+        name = re.sub(r"\W", "_", wav.stem).upper()
+        lines.append(f"#define STREAM_ID_{name} {ident}U")
+    lines += ["", f"#endif // End of {guard}", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("wavs", nargs="+", metavar="[ID=]WAV", help="8 or 16-bit PCM WAV files, mono or stereo")
+    parser.add_argument("--encoding", choices=sorted(ENCODINGS), default="pcm16", help="data encoding (default: pcm16)")
+    parser.add_argument("--header", type=Path, help="also write a C header of STREAM_ID_<NAME> defines")
+    parser.add_argument("-o", "--output", type=Path, required=True, help="output image")
+    args = parser.parse_args()
+
+    entries = parse_entries(args.wavs)
+    image = build_image(entries, args.encoding)
+    args.output.write_bytes(image)
+    if args.header:
+        write_header(args.header, entries)
+    print(f"{args.output}: {len(entries)} assets, {args.encoding}, {len(image)} bytes")
+
+
+if __name__ == "__main__":
+    main()
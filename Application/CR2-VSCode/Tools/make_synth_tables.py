@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Print the audio engine's synthesiser tables (synth_sine_table and synth_wave_tables in
+audio_engine.c).
+
+Each table is one cycle of --size points in Q15, plus a guard point equal to the first so
+linear interpolation between neighbours never wraps.  The synthesiser indexes them with the top
+bits of a 32-bit phase and interpolates with the next 15.
+
+The wavetables are band-limited sawtooth, square and triangle waves, mip-mapped by octave:
+level k sums the harmonics up to --harmonics >> k, so a note whose phase step is below
+2^31 / (--harmonics >> k) has none above the Nyquist frequency at that level.  The last level is
+the fundamental alone.  All the levels of a wave share one scale, so a note keeps its loudness as
+it moves between them.
+
+Usage:
+    make_synth_tables.py --size 256 --harmonics 64 > tables.txt
+"""
+
+import argparse
+import math
+
+WAVES = ("saw", "square", "triangle")
+
+
+def sine(size):
+    return [round(32767 * math.sin(2 * math.pi * i / size)) for i in range(size)] + [0]
+
+
+def partials(wave, limit):
+    """(harmonic, amplitude) pairs of a wave up to a harmonic limit."""
+    if wave == "saw":
+        return [(h, 1.0 / h) for h in range(1, limit + 1)]
+    if wave == "square":
+        return [(h, 1.0 / h) for h in range(1, limit + 1, 2)]
+    return [(h, (-1.0) ** ((h - 1) // 2) / (h * h)) for h in range(1, limit + 1, 2)]
+
+
+def mipmaps(wave, size, harmonics):
+    levels = []
+    limit = harmonics
+    while True:
+        levels.append([sum(a * math.sin(2 * math.pi * h * i / size) for h, a in partials(wave, limit))
+                       for i in range(size)])
+        if limit == 1:
+            break
+        limit >>= 1
+    scale = 32767 / max(abs(v) for level in levels for v in level)
+    return [[round(v * scale) for v in level] + [round(level[0] * scale)] for level in levels]
+
+
+def print_rows(values, indent):
+    for i in range(0, len(values), 16):
+        sep = "," if i + 16 < len(values) else ""
+        print(indent + ", ".join(f"{v:6d}" for v in values[i:i + 16]) + sep)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--size", type=int, default=256, help="points per cycle (SYNTH_SINE_SIZE), a power of 2")
+    parser.add_argument("--harmonics", type=int, default=64,
+                        help="harmonics of the first level (SYNTH_WAVE_HARMONICS), a power of 2 below --size / 2")
+    args = parser.parse_args()
+
+    print("static const int16_t synth_sine_table[ SYNTH_SINE_SIZE + 1U ] __attribute__( ( aligned( 4 ) ) ) = {")
+    print_rows(sine(args.size), "  ")
+    print("};")
+    print()
+    print("static const int16_t synth_wave_tables[ SYNTH_WAVES ][ SYNTH_WAVE_LEVELS ][ SYNTH_SINE_SIZE + 1U ] "
+          "__attribute__( ( aligned( 4 ) ) ) = {")
+    for w, wave in enumerate(WAVES):
+        print(f"  {{ /* {wave} */")
+        levels = mipmaps(wave, args.size, args.harmonics)
+        for k, level in enumerate(levels):
+            print("    {")
+            print_rows(level, "      ")
+            print("    }" + ("," if k + 1 < len(levels) else ""))
+        print("  }" + ("," if w + 1 < len(WAVES) else ""))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
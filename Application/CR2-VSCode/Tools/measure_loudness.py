@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Measure the loudness of WAV files for the audio engine's loudness normalisation.
+
+Loudness follows ITU-R BS.1770: K-weighting (a +4 dB shelf above 1.5 kHz and a 38 Hz
+high-pass, designed for the file's rate), mean square over 400 ms blocks overlapping by 75%,
+an absolute gate at -70 and a relative gate 10 dB below the ungated level.  A sound shorter
+than one block is measured as a whole.  The result is in dB relative to full scale (LUFS);
+Tools/make_asset.py stores it in the asset descriptor in tenths of a dB.
+
+Usage:
+    measure_loudness.py chime.wav bong.wav
+"""
+
+import argparse
+import math
+from pathlib import Path
+
+BLOCK_SECONDS = 0.4
+BLOCK_STEP = 0.25            # 75% overlap
+ABSOLUTE_GATE = -70.0
+RELATIVE_GATE = -10.0
+
+
+def k_weighting(rate):
+    """The two K-weighting biquads for a sample rate, as (b, a) pairs with a[0] == 1."""
+    stages = []
+
+    a_lin = 10.0 ** (4.0 / 40.0)                              # High shelf, +4 dB at 1.5 kHz
+    w0 = 2.0 * math.pi * 1500.0 / rate
+    alpha = math.sin(w0) / (2.0 * math.sqrt(0.5))
+    cos_w0, root = math.cos(w0), 2.0 * math.sqrt(a_lin) * alpha
+    b = [a_lin * ((a_lin + 1) + (a_lin - 1) * cos_w0 + root),
+         -2 * a_lin * ((a_lin - 1) + (a_lin + 1) * cos_w0),
+         a_lin * ((a_lin + 1) + (a_lin - 1) * cos_w0 - root)]
+    a = [(a_lin + 1) - (a_lin - 1) * cos_w0 + root,
+         2 * ((a_lin - 1) - (a_lin + 1) * cos_w0),
+         (a_lin + 1) - (a_lin - 1) * cos_w0 - root]
+    stages.append(([v / a[0] for v in b], [v / a[0] for v in a]))
+
+    w0 = 2.0 * math.pi * 38.0 / rate                          # High-pass, 38 Hz, Q 0.5
+    alpha = math.sin(w0) / (2.0 * 0.5)
+    cos_w0 = math.cos(w0)
+    b = [(1 + cos_w0) / 2, -(1 + cos_w0), (1 + cos_w0) / 2]
+    a = [1 + alpha, -2 * cos_w0, 1 - alpha]
+    stages.append(([v / a[0] for v in b], [v / a[0] for v in a]))
+    return stages
+
+
+def weighted_squares(channel, rate):
+    """Squares of one channel's K-weighted samples, full scale 1.0."""
+    x = [v / 32768.0 for v in channel]
+    for b, a in k_weighting(rate):
+        y, x1, x2, y1, y2 = [], 0.0, 0.0, 0.0, 0.0
+        for v in x:
+            out = b[0] * v + b[1] * x1 + b[2] * x2 - a[1] * y1 - a[2] * y2
+            x2, x1, y2, y1 = x1, v, y1, out
+            y.append(out)
+        x = y
+    return [v * v for v in x]
+
+
+def loudness(samples, channels, rate):
+    """Gated loudness of interleaved 16-bit samples in LUFS, or None for silence."""
+    squares = [weighted_squares(samples[c::channels], rate) for c in range(channels)]
+    frames = len(squares[0]) if squares else 0
+    size = max(1, min(frames, int(BLOCK_SECONDS * rate)))
+    step = max(1, int(BLOCK_STEP * size))
+
+    blocks = []
+    for start in range(0, max(1, frames - size + 1), step):
+        z = sum(sum(ch[start:start + size]) / size for ch in squares)
+        if z > 0.0:
+            blocks.append(z)
+
+    def level(z):
+        return -0.691 + 10.0 * math.log10(z)
+
+    gated = [z for z in blocks if level(z) > ABSOLUTE_GATE]
+    if not gated:
+        return None
+    relative = level(sum(gated) / len(gated)) + RELATIVE_GATE
+    gated = [z for z in gated if level(z) > relative]
+    return level(sum(gated) / len(gated))
+
+
+def main():
+    from make_asset import read_wav
+
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("wavs", nargs="+", type=Path, help="8 or 16-bit PCM WAV files, mono or stereo")
+    args = parser.parse_args()
+
+    for path in args.wavs:
+        rate, channels, samples = read_wav(path)
+        value = loudness(samples[:len(samples) - len(samples) % channels], channels, rate)
+        print(f"{path}: " + ("silent" if value is None else f"{value:.1f} LUFS"))
+
+
+if __name__ == "__main__":
+    main()
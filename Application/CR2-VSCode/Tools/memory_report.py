@@ -0,0 +1,267 @@
+#!/usr/bin/env python3
+"""
+Report the firmware's flash and RAM use from the GNU ld map file, and check it against a budget.
+
+The report lists the memory regions, the code, constants, initialised data and zeroed data of
+each module (source file or library), the sound assets linked in from the given header
+directories, and the largest RAM objects.  With --check it exits non-zero with the overrun and
+the biggest contributors when flash or RAM exceeds its budget.  The default budgets are the
+linker script's regions: FLASH (512 KB less any asset bank) and RAM plus CCMSRAM (128 KB).
+
+Initialised data counts twice, in RAM and for its load copy in flash; the heap and stack
+reservation shows as "(heap and stack)".  Release builds are linked with LTO, so their code is
+attributed to "(LTO)" rather than to modules; a Debug build gives the per-module figures.
+
+The build runs the check after every link (CMakeLists.txt), and the memory_report target
+prints the full report:
+    cmake --build build/Debug --target memory_report
+
+Usage:
+    memory_report.py build/Debug/CR2-VSCode.map --assets Core/Inc/sound_headers
+    memory_report.py CR2-VSCode.map --flash-budget 0x60000 --ram-budget 100000 --check
+"""
+
+import argparse
+import re
+import sys
+from pathlib import Path
+
+FLASH_REGIONS = ("FLASH",)
+RAM_REGIONS = ("RAM", "CCMSRAM")
+CODE_SECTIONS = (".isr_vector", ".text", ".ARM", ".preinit_array", ".init_array", ".fini_array")
+COLUMNS = ("code", "const", "data", "bss")
+
+INPUT_RE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+INPUT_NAME_RE = re.compile(r"^ (\.\S+|COMMON)$")
+INPUT_REST_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+OUTPUT_RE = re.compile(r"^(\.\S+|\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?")
+OUTPUT_NAME_RE = re.compile(r"^(\.\S+)$")
+OUTPUT_REST_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+ARRAY_RE = re.compile(r"\bconst\s+[\w\s]+?\s(\w+)\s*\[")
+
+
+def parse_map(text):
+    """Memory regions {name: (origin, length)} and the output sections with their input sections."""
+    regions = {}
+    sections = []
+    lines = text.splitlines()
+    i = 0
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        fields = lines[i].split()
+        if len(fields) >= 3 and fields[1].startswith("0x") and fields[0] != "*default*":
+            regions[fields[0]] = (int(fields[1], 16), int(fields[2], 16))
+        i += 1
+
+    current = None
+    pending = None                                        # Section name waiting for its address line
+    for line in lines[i:]:
+        if line.startswith("OUTPUT("):
+            break
+        if pending:
+            kind, name = pending
+            pending = None
+            if kind == "out":
+                m = OUTPUT_REST_RE.match(line)
+                if m:
+                    current = new_output(name, m.group(1), m.group(2), m.group(3))
+                    sections.append(current)
+                continue
+            m = INPUT_REST_RE.match(line)
+            if m and current:
+                add_input(current, name, m.group(1), m.group(2), m.group(3))
+                continue
+        m = OUTPUT_RE.match(line)
+        if m and not line.startswith(" "):
+            current = new_output(m.group(1), m.group(2), m.group(3), m.group(4))
+            sections.append(current)
+            continue
+        m = OUTPUT_NAME_RE.match(line)
+        if m:
+            pending = ("out", m.group(1))
+            continue
+        m = INPUT_RE.match(line)
+        if m and current and not m.group(1).startswith("*("):
+            add_input(current, m.group(1), m.group(2), m.group(3), m.group(4))
+            continue
+        m = INPUT_NAME_RE.match(line)
+        if m:
+            pending = ("in", m.group(1))
+            continue
+        if current and current["inputs"] and re.match(r"^\s+0x[0-9a-fA-F]+\s+[A-Za-z_]\w*$", line):
+            last = current["inputs"][-1]
+            last.setdefault("symbol", line.split()[1])    # First symbol defined in the input section
+    return regions, sections
+
+
+def new_output(name, address, size, load):
+    return {"name": name, "address": int(address, 16), "size": int(size, 16),
+            "load": int(load, 16) if load else None, "inputs": []}
+
+
+def add_input(section, name, address, size, path):
+    size = int(size, 16)
+    if size and name != "*fill*":
+        section["inputs"].append({"name": name, "address": int(address, 16), "size": size, "path": path.strip()})
+
+
+def region_of(regions, address):
+    for name, (origin, length) in regions.items():
+        if origin <= address < origin + length:
+            return name
+    return None
+
+
+def module_of(path):
+    """Module name of an input file: the source file, the library, or (LTO)."""
+    if "ltrans" in path:
+        return "(LTO)"
+    m = re.match(r"(.*?\.a)\((.*)\)$", path)
+    if m:
+        return Path(m.group(1)).name
+    name = Path(path).name
+    for suffix in (".obj", ".o"):
+        if name.endswith(suffix):
+            return name[:-len(suffix)]
+    return name
+
+
+def symbol_of(item):
+    """Object name of an input section: the part after .text./.rodata./.bss. and the like."""
+    parts = item["name"].split(".", 2)
+    if len(parts) == 3 and parts[2]:
+        return parts[2]
+    return item.get("symbol", item["name"])
+
+
+def asset_names(directories):
+    names = set()
+    for directory in directories:
+        for header in Path(directory).glob("*.h") if Path(directory).is_dir() else []:
+            names.update(ARRAY_RE.findall(header.read_text(errors="replace")))
+    return names
+
+
+def account(regions, sections, assets):
+    """Totals per region, per module and column, the assets and the RAM objects."""
+    used = {name: 0 for name in regions}
+    flash = ram = 0
+    modules = {}
+    asset_sizes = {}
+    ram_objects = []
+    for section in sections:
+        region = region_of(regions, section["address"])
+        if region is None or section["size"] == 0:
+            continue                                      # Debug information and empty sections
+        load_region = region_of(regions, section["load"]) if section["load"] is not None else None
+        used[region] += section["size"]
+        if load_region and load_region != region:
+            used[load_region] += section["size"]
+
+        if region in FLASH_REGIONS:
+            column = "code" if section["name"].startswith(CODE_SECTIONS) else "const"
+            flash += section["size"]
+        elif region in RAM_REGIONS:
+            column = "data" if load_region in FLASH_REGIONS else "bss"
+            ram += section["size"]
+            if column == "data":
+                flash += section["size"]
+        else:
+            continue
+
+        accounted = 0
+        for item in section["inputs"]:
+            module = module_of(item["path"])
+            modules.setdefault(module, dict.fromkeys(COLUMNS, 0))[column] += item["size"]
+            accounted += item["size"]
+            symbol = symbol_of(item)
+            if column == "const" and symbol in assets:
+                asset_sizes[symbol] = asset_sizes.get(symbol, 0) + item["size"]
+            if region in RAM_REGIONS:
+                ram_objects.append((item["size"], symbol, module))
+        rest = section["size"] - accounted
+        if rest > 0:
+            label = "(heap and stack)" if "heap" in section["name"] or "stack" in section["name"] else "(alignment)"
+            modules.setdefault(label, dict.fromkeys(COLUMNS, 0))[column] += rest
+            if label == "(heap and stack)":
+                ram_objects.append((rest, label, "linker script"))
+    return used, flash, ram, modules, asset_sizes, sorted(ram_objects, reverse=True)
+
+
+def kib(n):
+    return f"{n / 1024:7.1f}K"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", type=Path, help="linker map file (-Wl,-Map)")
+    parser.add_argument("--assets", type=Path, nargs="*", default=[], metavar="DIR",
+                        help="directories of sound asset headers whose arrays are listed as assets")
+    parser.add_argument("--flash-budget", type=lambda v: int(v, 0), help="flash budget in bytes (default: the FLASH region)")
+    parser.add_argument("--ram-budget", type=lambda v: int(v, 0),
+                        help="RAM budget in bytes (default: the RAM and CCMSRAM regions)")
+    parser.add_argument("--top", type=int, default=10, help="largest RAM objects and assets to list (default: 10)")
+    parser.add_argument("--check", action="store_true", help="only check the budgets; exit 1 with the overrun")
+    parser.add_argument("--elf", type=Path, help="with --check, remove this ELF on an overrun so the next build links and checks again")
+    args = parser.parse_args()
+
+    if not args.map.exists():
+        sys.exit(f"{args.map}: no map file; the firmware is linked with -Wl,-Map")
+    regions, sections = parse_map(args.map.read_text(errors="replace"))
+    if not regions:
+        sys.exit(f"{args.map}: no memory configuration found")
+    used, flash, ram, modules, assets, ram_objects = account(regions, sections, asset_names(args.assets))
+
+    flash_budget = args.flash_budget or sum(regions[r][1] for r in FLASH_REGIONS if r in regions)
+    ram_budget = args.ram_budget or sum(regions[r][1] for r in RAM_REGIONS if r in regions)
+    asset_total = sum(assets.values())
+
+    if args.check:
+        failures = []
+        if flash > flash_budget:
+            largest = ", ".join(f"{name} {size}" for name, size in sorted(assets.items(), key=lambda kv: -kv[1])[:3])
+            failures.append(f"flash use {flash} bytes exceeds the {flash_budget}-byte budget by {flash - flash_budget} bytes"
+                            + (f"; sound assets take {asset_total} bytes (largest: {largest})" if assets else ""))
+        if ram > ram_budget:
+            largest = ", ".join(f"{name} ({module}) {size}" for size, name, module in ram_objects[:3])
+            failures.append(f"RAM use {ram} bytes exceeds the {ram_budget}-byte budget by {ram - ram_budget} bytes"
+                            f"; largest: {largest}")
+        for failure in failures:
+            print(f"{args.map.name}: error: {failure}", file=sys.stderr)
+        if failures:
+            print("Drop assets or features (AUDIO_ENGINE_* options, PB_BUFF_SZ), or run the memory_report target "
+                  "for the breakdown", file=sys.stderr)
+            if args.elf and args.elf.exists():
+                args.elf.unlink()
+            return 1
+        print(f"Memory: flash {flash} of {flash_budget} bytes ({100 * flash / flash_budget:.1f}%), "
+              f"RAM {ram} of {ram_budget} bytes ({100 * ram / ram_budget:.1f}%)")
+        return 0
+
+    print("Region        origin       used       size    use")
+    for name, (origin, length) in regions.items():
+        if length:
+            print(f"{name:<12} 0x{origin:08X} {used[name]:9d} {length:10d} {100 * used[name] / length:5.1f}%")
+    print(f"\nFlash {flash} of {flash_budget} bytes budgeted ({100 * flash / flash_budget:.1f}%), "
+          f"RAM {ram} of {ram_budget} bytes budgeted ({100 * ram / ram_budget:.1f}%)")
+
+    print(f"\n{'module':<32} {'code':>9} {'const':>9} {'data':>9} {'bss':>9}")
+    for module, sizes in sorted(modules.items(), key=lambda kv: -sum(kv[1].values())):
+        print(f"{module:<32} " + " ".join(f"{sizes[c]:9d}" for c in COLUMNS))
+    print(f"{'total':<32} " + " ".join(f"{sum(m[c] for m in modules.values()):9d}" for c in COLUMNS))
+
+    if assets:
+        print(f"\nSound assets: {len(assets)}, {asset_total} bytes of flash ({100 * asset_total / flash_budget:.1f}% of the budget)")
+        for name, size in sorted(assets.items(), key=lambda kv: -kv[1])[:args.top]:
+            print(f"  {name:<40} {size:9d}  {kib(size)}")
+
+    print("\nLargest RAM objects")
+    for size, name, module in ram_objects[:args.top]:
+        print(f"  {name:<40} {size:9d}  {module}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""
+Quantise samples to 8 bits with error feedback that moves the quantisation noise up the band.
+
+Each sample has the filtered errors of the ones before it taken off before it is rounded, so the
+noise comes out through (1 - z^-1)^order: well below plain 8-bit noise at low frequencies, where
+a small speaker does its work, and piled up towards half the sample rate, where it rolls off.
+TPDF dither of one step keeps the loop from settling into tones on quiet passages, and the error
+fed back is held to a few steps so a clipped peak cannot set it ringing.  make_asset.py --shape
+stores the result as PCM8 and marks the asset AUDIO_ASSET_SHAPED; the engine then plays it with
+no dither or LPF of its own.
+
+Usage:
+    shape_noise.py chime.wav chime_shaped.wav                   # To audition
+    make_asset.py chime.wav --encoding pcm8 --shape -o chime_asset.h
+"""
+
+import argparse
+import random
+import struct
+import wave
+from math import comb
+from pathlib import Path
+
+STEP = 256                         # One 8-bit step in 16-bit units
+ERROR_LIMIT = 2 * STEP             # Largest error fed back
+DEFAULT_ORDER = 2
+
+
+def feedback(order):
+    """Error feedback taps for a (1 - z^-1)^order noise transfer function, most recent first."""
+    return [-((-1) ** k) * comb(order, k) for k in range(1, order + 1)]
+
+
+def shape_channel(samples, taps, dither):
+    out, errors = [], [0] * len(taps)
+    for x in samples:
+        wanted = x - sum(t * e for t, e in zip(taps, errors))
+        level = max(-128, min(127, int((wanted / STEP + dither.random() - dither.random() + 0.5) // 1)))
+        error = max(-ERROR_LIMIT, min(ERROR_LIMIT, level * STEP - wanted))
+        errors = [error] + errors[:-1]
+        out.append(level * STEP)
+    return out
+
+
+def shape(samples, channels, order=DEFAULT_ORDER):
+    """Interleaved 16-bit samples on the 8-bit grid, each channel shaped on its own.
+
+    The values are multiples of 256, which make_asset.py's PCM8 encoding stores exactly.
+    """
+    dither = random.Random(8)                             # Fixed seed: the same WAV gives the same asset
+    taps = feedback(order)
+    out = list(samples)
+    for ch in range(channels):
+        out[ch::channels] = shape_channel(samples[ch::channels], taps, dither)
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", type=Path, help="8 or 16-bit PCM WAV file, mono or stereo")
+    parser.add_argument("output", type=Path, help="16-bit WAV file holding the shaped 8-bit samples")
+    parser.add_argument("--order", type=int, choices=(1, 2, 3), default=DEFAULT_ORDER,
+                        help=f"order of the noise shaping (default: {DEFAULT_ORDER})")
+    args = parser.parse_args()
+
+    from make_asset import read_wav                      # make_asset imports this module
+    rate, channels, samples = read_wav(args.input)
+    shaped = shape(samples[:len(samples) - len(samples) % channels], channels, args.order)
+    with wave.open(str(args.output), "wb") as wav:
+        wav.setnchannels(channels)
+        wav.setsampwidth(2)
+        wav.setframerate(rate)
+        wav.writeframes(struct.pack(f"<{len(shaped)}h", *shaped))
+    print(f"{args.output}: {len(shaped) // channels} frames shaped to 8 bits, order {args.order}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Send settings and playback commands to a chime over its UART control port (uart_control.c).
+
+Each invocation sends one frame, so everything given is applied together: the settings are
+gathered into one preset and applied in one swap, then the commands run in the order given.
+Settings are NAME=VALUE with integer values, in the engine's units (Q16 gains and alphas,
+LPF_Level numbers, milliseconds); --preset N starts from the firmware's preset table entry N
+instead of the running configuration.  The chime's reply is printed when it has a Tx DMA.
+
+--upload sends a RAM asset slot image (Tools/make_asset.py --ram, AUDIO_ENGINE_ENABLE_RAM_ASSET)
+ahead of the frame, RAM_WRITE_CHUNK bytes to a frame, each one waiting for the chime's reply, so
+it needs the Tx DMA.  --play-ram then plays it: a new sound is heard seconds after it is made.
+
+Usage:
+    uart_control.py /dev/ttyUSB0 fade_in_ms=200 lpf_16bit_level=3 air_gain_q16=80000
+    uart_control.py /dev/ttyUSB0 --preset 1 --play-bank 4
+    uart_control.py /dev/ttyUSB0 --stop
+    uart_control.py /dev/ttyUSB0 fade_in_ms=200 --save     # Kept over resets, with the preset store
+    uart_control.py /dev/ttyUSB0 --stop --upload chime_ram.bin --play-ram
+"""
+
+import argparse
+import binascii
+import struct
+import time
+from pathlib import Path
+
+SYNC = 0xC2
+OP_SET, OP_PRESET = 0x01, 0x02
+OP_PLAY_ID, OP_PLAY_BANK, OP_PAUSE, OP_RESUME, OP_STOP = 0x10, 0x11, 0x12, 0x13, 0x14
+OP_SAVE = 0x20
+OP_RAM_WRITE, OP_PLAY_RAM = 0x30, 0x31
+RAM_WRITE_CHUNK = 240                       # Image bytes per RAM_WRITE frame, within the 255-byte payload
+UPLOAD_TRIES = 20                           # Tries of a refused RAM_WRITE, 100 ms apart
+PARAMS = {                                  # UartControl_Param
+    "lpf_16bit_level": 0x01, "lpf_16bit_alpha": 0x02, "lpf_8bit_level": 0x03, "lpf_8bit_alpha": 0x04,
+    "lpf_makeup_q16": 0x05, "lpf_16bit_makeup_q16": 0x06,
+    "biquad_lpf_16bit": 0x10, "dc_filter_16bit": 0x11, "lpf_8bit": 0x12, "noise_gate": 0x13,
+    "soft_clipping": 0x14, "air_effect": 0x15, "filter_chain_16bit": 0x16, "filter_chain_8bit": 0x17,
+    "air_gain_q16": 0x20, "fade_in_ms": 0x21, "fade_out_ms": 0x22, "pause_fade_ms": 0x23,
+    "resume_fade_ms": 0x24, "faders": 0x25,
+}
+RESULTS = ("applied", "bad record, nothing applied", "command refused")
+
+
+def frame(payload):
+    body = bytes([len(payload)]) + payload
+    return bytes([SYNC]) + body + struct.pack("<H", binascii.crc_hqx(body, 0xFFFF))
+
+
+def build_payload(seq, settings, preset, commands):
+    records = bytearray([seq & 0xFF])
+    if preset is not None:
+        records += bytes([OP_PRESET, preset])
+    for name, value in settings:
+        if name not in PARAMS:
+            raise SystemExit(f"unknown setting {name}: one of {', '.join(sorted(PARAMS))}")
+        records += struct.pack("<BBI", OP_SET, PARAMS[name], value)
+    for op, arg in commands:
+        records += bytes([op]) + (struct.pack("<I", arg) if arg is not None else b"")
+    if len(records) > 255:
+        raise SystemExit(f"{len(records)} payload bytes do not fit one frame (255)")
+    return bytes(records)
+
+
+def read_reply(port):
+    """(sequence, result, records) of the chime's reply, or None."""
+    reply = port.read(7)
+    if len(reply) == 7 and reply[0] == SYNC and reply[1] == 3 and \
+            struct.unpack("<H", reply[5:7])[0] == binascii.crc_hqx(reply[1:5], 0xFFFF):
+        return reply[2], reply[3], reply[4]
+    return None
+
+
+def upload(port, image):
+    """Write an image into the RAM asset slot, a frame at a time."""
+    for seq, offset in enumerate(range(0, len(image), RAM_WRITE_CHUNK)):
+        chunk = image[offset:offset + RAM_WRITE_CHUNK]
+        for _ in range(UPLOAD_TRIES):                     # A stop's fade-out may still be playing the slot
+            port.write(frame(bytes([seq & 0xFF, OP_RAM_WRITE]) + struct.pack("<IB", offset, len(chunk)) + chunk))
+            reply = read_reply(port)
+            if reply is None:
+                raise SystemExit(f"no reply at offset {offset}: the upload needs the chime's Tx DMA")
+            if reply[1] == 0:
+                break
+            time.sleep(0.1)
+        else:
+            raise SystemExit(f"offset {offset}: refused, beyond the slot or the slot still playing")
+    print(f"uploaded {len(image)} bytes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", help="serial port, e.g. /dev/ttyUSB0 or COM3")
+    parser.add_argument("settings", nargs="*", metavar="NAME=VALUE", help="settings to apply together")
+    parser.add_argument("--baud", type=int, default=115200, help="baud rate (default: 115200)")
+    parser.add_argument("--preset", type=int, help="start from the firmware's preset N")
+    parser.add_argument("--play-id", type=int, help="PlayAssetById() after the settings")
+    parser.add_argument("--play-bank", type=int, help="PlayBankAsset() after the settings")
+    parser.add_argument("--pause", action="store_true")
+    parser.add_argument("--resume", action="store_true")
+    parser.add_argument("--stop", action="store_true")
+    parser.add_argument("--save", action="store_true", help="save the configuration to the preset store (while idle)")
+    parser.add_argument("--upload", type=Path, metavar="IMAGE", help="RAM asset slot image to send first (make_asset.py --ram)")
+    parser.add_argument("--play-ram", action="store_true", help="PlayRamAsset() after the settings")
+    parser.add_argument("--seq", type=int, default=0, help="sequence number echoed in the reply")
+    args = parser.parse_args()
+
+    settings = []
+    for item in args.settings:
+        name, _, value = item.partition("=")
+        settings.append((name, int(value, 0)))
+    commands = [(OP_STOP, None)] if args.stop else []
+    commands += [(OP_SAVE, None)] if args.save else []
+    commands += [(OP_PLAY_ID, args.play_id)] if args.play_id is not None else []
+    commands += [(OP_PLAY_BANK, args.play_bank)] if args.play_bank is not None else []
+    commands += [(OP_PLAY_RAM, None)] if args.play_ram else []
+    commands += [(OP_PAUSE, None)] if args.pause else []
+    commands += [(OP_RESUME, None)] if args.resume else []
+
+    payload = build_payload(args.seq, settings, args.preset, commands)
+    import serial                           # pyserial, only needed to send
+    with serial.Serial(args.port, args.baud, timeout=0.5) as port:
+        if args.upload:
+            if args.stop:                                 # Ahead of the upload, which a playing slot refuses
+                port.write(frame(bytes([args.seq & 0xFF, OP_STOP])))
+                read_reply(port)
+                payload = build_payload(args.seq, settings, args.preset, commands[1:])
+            upload(port, args.upload.read_bytes())
+        if len(payload) == 1 and args.upload:
+            return                                        # Nothing else to send
+        port.write(frame(payload))
+        reply = read_reply(port)
+    if reply is not None:
+        result = RESULTS[reply[1]] if reply[1] < len(RESULTS) else f"result {reply[1]}"
+        print(f"seq {reply[0]}: {result}, {reply[2]} records")
+    else:
+        print("no reply")
+
+
+if __name__ == "__main__":
+    main()
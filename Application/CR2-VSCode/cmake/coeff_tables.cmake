@@ -0,0 +1,45 @@
+# Per-rate filter coefficient tables
+#
+# add_coeff_tables(<target> [RATES <hz>...] [REFERENCE_RATE <hz>])
+#
+# Runs Tools/make_coeff_tables.py at build time into ${CMAKE_BINARY_DIR}/generated/
+# audio_engine_coeff_tables.h, added to the target's include path, and builds the target's audio
+# engine with AUDIO_ENGINE_ENABLE_RATE_COEFF_TABLES=1.  The tables hold the LPF level, DC filter
+# and air effect coefficients for each I2S rate (8 to 48 kHz by default), each level keeping the
+# cutoff it has at REFERENCE_RATE.  They are regenerated when the engine's levels or the tool
+# change.  The custom target audio_engine_coeff_tables makes the header, once for all the
+# targets added; the first call's RATES and REFERENCE_RATE apply to them all.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(COEFF_TABLES_ENGINE_DIR ${CMAKE_CURRENT_LIST_DIR}/../Core/Libraries)
+set(COEFF_TABLES_TOOL ${CMAKE_CURRENT_LIST_DIR}/../Tools/make_coeff_tables.py)
+
+function(add_coeff_tables target)
+    cmake_parse_arguments(ARG "" "REFERENCE_RATE" "RATES" ${ARGN})
+    set(options)
+    if(ARG_RATES)
+        string(REPLACE ";" "," rates "${ARG_RATES}")
+        list(APPEND options --rates ${rates})
+    endif()
+    if(ARG_REFERENCE_RATE)
+        list(APPEND options --reference-rate ${ARG_REFERENCE_RATE})
+    endif()
+
+    set(out_dir ${CMAKE_BINARY_DIR}/generated)
+    set(header ${out_dir}/audio_engine_coeff_tables.h)
+    if(NOT TARGET audio_engine_coeff_tables)
+        add_custom_command(
+            OUTPUT  ${header}
+            COMMAND ${Python3_EXECUTABLE} ${COEFF_TABLES_TOOL} ${COEFF_TABLES_ENGINE_DIR} ${options} -o ${header}
+            DEPENDS ${COEFF_TABLES_TOOL} ${COEFF_TABLES_ENGINE_DIR}/audio_engine.h ${COEFF_TABLES_ENGINE_DIR}/audio_engine.c
+            COMMENT "Generating the audio engine coefficient tables"
+            VERBATIM
+        )
+        add_custom_target(audio_engine_coeff_tables DEPENDS ${header})
+    endif()
+
+    add_dependencies(${target} audio_engine_coeff_tables)  # The header before the engine including it
+    target_include_directories(${target} PRIVATE ${out_dir})
+    target_compile_definitions(${target} PRIVATE AUDIO_ENGINE_ENABLE_RATE_COEFF_TABLES=1)
+endfunction()
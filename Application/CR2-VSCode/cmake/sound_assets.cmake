@@ -0,0 +1,147 @@
+# Sound asset compilation
+#
+# add_audio_asset(<target> <wav> [ENCODING <PCM16|PCM8|ADPCM|LOSSLESS|MULAW|ALAW|SBC|MIDSIDE|PCM12|RLE>]
+#                 [NAME <c-name>] [ID <id>] [PRESET <preset>] [LOUDNESS_TARGET <lufs>]
+#                 [BAKE "<make_preset.py options>"] [SHAPE] [QSPI]
+#                 [VARIANT_OF <master wav> [MASTER_NAME <c-name>]])
+#
+# Runs Tools/make_asset.py --object on the WAV file at build time.  The sample data goes into
+# the image through an .incbin in a generated assembly file and the descriptor through a small
+# generated C file, both added to the target; ${CMAKE_BINARY_DIR}/sound_assets, added to the
+# target's include path, gets <name>_asset.h declaring <name>_asset.  No sample array passes
+# through the C compiler, and --gc-sections drops an asset nothing references (or registers
+# with ID).  The outputs are regenerated when the WAV file or the tools change.
+#
+# BAKE applies the static filters of those preset options to the samples here (make_asset.py
+# --bake), so the engine skips them for this asset; pass the same options to the PRESET's
+# make_preset.py for the rest of the chain.  A baked asset also depends on audio_engine.h, whose
+# LPF and DC filter levels the baking reads.
+#
+# SHAPE noise-shapes a PCM8 asset (make_asset.py --shape), which the engine then plays without
+# its 8-bit dither and LPF.
+#
+# QSPI links the sample data into QUADSPI flash, read in place (make_asset.py --qspi); it needs
+# AUDIO_ENGINE_QSPI_FLASH_SIZE.
+#
+# VARIANT_OF builds a lower rate, depth or channel variant of another asset's WAV file
+# (Tools/find_asset_variants.py lists them) as a descriptor of that master's data
+# (make_asset.py --variant-of): the build fails if the two differ by more than resampling and
+# requantising, and the variant adds no sample data, only <name>_asset.h and its .c.  Give the
+# same ENCODING, BAKE and SHAPE as the master's add_audio_asset(), and MASTER_NAME if the master
+# has a NAME.
+#
+# add_sound_assets(<target> ENCODING <encoding> WAVS <file>...)
+#
+# add_audio_asset() for each WAV file, all in one encoding.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(SOUND_ASSET_TOOL_DIR ${CMAKE_CURRENT_LIST_DIR}/../Tools)
+set(SOUND_ASSET_TOOLS
+    ${SOUND_ASSET_TOOL_DIR}/make_asset.py
+    ${SOUND_ASSET_TOOL_DIR}/make_adpcm_header.py
+    ${SOUND_ASSET_TOOL_DIR}/make_lossless_header.py
+    ${SOUND_ASSET_TOOL_DIR}/make_companded_header.py
+    ${SOUND_ASSET_TOOL_DIR}/make_sbc_header.py
+    ${SOUND_ASSET_TOOL_DIR}/make_midside_header.py
+    ${SOUND_ASSET_TOOL_DIR}/make_rle_header.py
+    ${SOUND_ASSET_TOOL_DIR}/make_silence_map.py
+    ${SOUND_ASSET_TOOL_DIR}/measure_loudness.py
+    ${SOUND_ASSET_TOOL_DIR}/bake_filters.py
+    ${SOUND_ASSET_TOOL_DIR}/make_preset.py
+    ${SOUND_ASSET_TOOL_DIR}/make_coeff_tables.py
+    ${SOUND_ASSET_TOOL_DIR}/shape_noise.py
+    ${SOUND_ASSET_TOOL_DIR}/find_asset_variants.py
+)
+
+function(add_audio_asset target wav)
+    cmake_parse_arguments(ARG "SHAPE;QSPI" "ENCODING;NAME;ID;PRESET;LOUDNESS_TARGET;BAKE;VARIANT_OF;MASTER_NAME" "" ${ARGN})
+    if(NOT ARG_ENCODING)
+        set(ARG_ENCODING PCM16)
+    endif()
+    string(TOLOWER ${ARG_ENCODING} encoding)
+    if(NOT encoding MATCHES "^(pcm16|pcm8|adpcm|lossless|mulaw|alaw|sbc|midside|pcm12|rle)$")
+        message(FATAL_ERROR "add_audio_asset: ENCODING must be PCM16, PCM8, ADPCM, LOSSLESS, MULAW, ALAW, SBC, MIDSIDE, PCM12 or RLE")
+    endif()
+
+    get_filename_component(wav ${wav} ABSOLUTE BASE_DIR ${CMAKE_SOURCE_DIR})
+    get_filename_component(stem ${wav} NAME_WE)
+    set(options --encoding ${encoding})
+    if(ARG_NAME)
+        set(stem ${ARG_NAME})
+        list(APPEND options --name ${ARG_NAME})
+    endif()
+    if(DEFINED ARG_ID)
+        list(APPEND options --id ${ARG_ID})
+    endif()
+    if(ARG_PRESET)
+        list(APPEND options --preset ${ARG_PRESET})
+    endif()
+    if(ARG_LOUDNESS_TARGET)
+        list(APPEND options --loudness-target ${ARG_LOUDNESS_TARGET})
+    endif()
+    set(depends ${wav} ${SOUND_ASSET_TOOLS})
+    if(ARG_BAKE)
+        list(APPEND options --bake ${ARG_BAKE})
+        list(APPEND depends ${SOUND_ASSET_TOOL_DIR}/../Core/Libraries/audio_engine.h)
+    endif()
+    if(ARG_SHAPE)
+        list(APPEND options --shape)
+    endif()
+    if(ARG_QSPI)
+        if(NOT AUDIO_ENGINE_QSPI_FLASH_SIZE)
+            message(FATAL_ERROR "add_audio_asset: QSPI needs an AUDIO_ENGINE_QSPI_FLASH_SIZE")
+        endif()
+        list(APPEND options --qspi)
+    endif()
+
+    set(out_dir ${CMAKE_BINARY_DIR}/sound_assets)
+    set(base ${out_dir}/${stem}_asset)
+    if(ARG_VARIANT_OF)
+        if(ARG_QSPI)
+            message(FATAL_ERROR "add_audio_asset: a VARIANT_OF asset lies where its master's data does, so takes no QSPI")
+        endif()
+        get_filename_component(master ${ARG_VARIANT_OF} ABSOLUTE BASE_DIR ${CMAKE_SOURCE_DIR})
+        list(APPEND options --variant-of ${master})
+        if(ARG_MASTER_NAME)
+            list(APPEND options --master-name ${ARG_MASTER_NAME})
+        endif()
+        add_custom_command(
+            OUTPUT  ${base}.h ${base}.c
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${out_dir}
+            COMMAND ${Python3_EXECUTABLE} ${SOUND_ASSET_TOOL_DIR}/make_asset.py ${wav}
+                    ${options} --object -o ${base}.h
+            DEPENDS ${depends} ${master}
+            COMMENT "Compiling sound asset ${stem} as a variant of ${master}"
+            VERBATIM
+        )
+        target_sources(${target} PRIVATE ${base}.c)
+        add_custom_target(${target}_${stem}_asset DEPENDS ${base}.h)
+        add_dependencies(${target} ${target}_${stem}_asset)
+        target_include_directories(${target} PRIVATE ${out_dir})
+        return()
+    endif()
+
+    add_custom_command(
+        OUTPUT  ${base}.h ${base}.c ${base}.S ${base}.bin
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${out_dir}
+        COMMAND ${Python3_EXECUTABLE} ${SOUND_ASSET_TOOL_DIR}/make_asset.py ${wav}
+                ${options} --object -o ${base}.h
+        DEPENDS ${depends}
+        COMMENT "Compiling sound asset ${stem}"
+        VERBATIM
+    )
+    set_source_files_properties(${base}.S PROPERTIES OBJECT_DEPENDS ${base}.bin)
+
+    target_sources(${target} PRIVATE ${base}.c ${base}.S)
+    add_custom_target(${target}_${stem}_asset DEPENDS ${base}.h)
+    add_dependencies(${target} ${target}_${stem}_asset)   # Headers before the sources including them
+    target_include_directories(${target} PRIVATE ${out_dir})
+endfunction()
+
+function(add_sound_assets target)
+    cmake_parse_arguments(ARG "" "ENCODING" "WAVS" ${ARGN})
+    foreach(wav IN LISTS ARG_WAVS)
+        add_audio_asset(${target} ${wav} ENCODING ${ARG_ENCODING})
+    endforeach()
+endfunction()